@@ -0,0 +1,6 @@
+include(${CMAKE_CURRENT_LIST_DIR}/x64-linux.cmake)
+# ThreadSanitizer reports false positives on synchronization it cannot see, so the dependencies are instrumented as well.
+set(VCPKG_C_FLAGS "-fsanitize=thread")
+set(VCPKG_CXX_FLAGS "-fsanitize=thread")
+set(VCPKG_LINKER_FLAGS "-fsanitize=thread")
+set(VCPKG_BUILD_TYPE release)
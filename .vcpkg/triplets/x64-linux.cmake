@@ -0,0 +1,6 @@
+set(VCPKG_TARGET_ARCHITECTURE x64)
+set(VCPKG_CRT_LINKAGE dynamic)
+set(VCPKG_LIBRARY_LINKAGE static)
+set(VCPKG_CMAKE_SYSTEM_NAME Linux)
+# Lets the presets pick the compiler (clang) for the dependencies too.
+set(VCPKG_ENV_PASSTHROUGH CC CXX)
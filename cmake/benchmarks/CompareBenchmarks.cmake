@@ -0,0 +1,191 @@
+# Compares a Google Benchmark JSON result against a stored baseline and fails on regressions.
+#
+# Usage:
+#   cmake -DBASELINE=<baseline.json> -DCURRENT=<result.json> [-DTHRESHOLD=<percent>] [-DMETRIC=cpu_time|real_time]
+#         [-DREPORT_ONLY=ON] -P CompareBenchmarks.cmake
+#
+# REPORT_ONLY prints the changes and their mean without failing, e.g. to report the effect of a build option.
+# When the results contain repetitions the median aggregate is compared, otherwise the single run.
+# A missing baseline is not an error, it only prints how to create one.
+
+cmake_minimum_required(VERSION 3.19)
+
+if (NOT DEFINED THRESHOLD)
+    set(THRESHOLD 10)
+endif()
+if (NOT DEFINED METRIC)
+    set(METRIC cpu_time)
+endif()
+
+if (NOT EXISTS "${CURRENT}")
+    message(FATAL_ERROR "Benchmark result '${CURRENT}' does not exist.")
+endif()
+if (NOT EXISTS "${BASELINE}")
+    message(WARNING "No baseline at '${BASELINE}', run the benchmark_update_baseline target to record one.")
+    return()
+endif()
+
+# Converts a time in the given unit to nanoseconds, scaled by 1000 to keep three decimals in integer math.
+function(_shm_to_scaled_ns value unit out_var)
+    if (unit STREQUAL "ns")
+        set(unit_exponent 0)
+    elseif (unit STREQUAL "us")
+        set(unit_exponent 3)
+    elseif (unit STREQUAL "ms")
+        set(unit_exponent 6)
+    elseif (unit STREQUAL "s")
+        set(unit_exponent 9)
+    else()
+        message(FATAL_ERROR "Unknown benchmark time unit '${unit}'.")
+    endif()
+
+    # math() is integer only, so the scaling is done on the digit string: all digits of the mantissa, with the
+    # decimal point moved by the exponent, the unit and the three kept decimals, and everything after it cut off.
+    if (NOT value MATCHES "^([0-9]+)\\.?([0-9]*)([eE]\\+?(-?[0-9]+))?$")
+        message(FATAL_ERROR "Benchmark time '${value}' is not a decimal number.")
+    endif()
+    set(digits "${CMAKE_MATCH_1}${CMAKE_MATCH_2}")
+    string(LENGTH "${CMAKE_MATCH_1}" point)
+    set(exponent 0)
+    if (NOT "${CMAKE_MATCH_4}" STREQUAL "")
+        set(exponent "${CMAKE_MATCH_4}")
+    endif()
+    math(EXPR point "${point} + ${exponent} + ${unit_exponent} + 3")
+
+    if (point LESS_EQUAL 0)
+        set(scaled 0)
+    else()
+        string(LENGTH "${digits}" length)
+        while (length LESS point)
+            string(APPEND digits "0")
+            math(EXPR length "${length} + 1")
+        endwhile()
+        string(SUBSTRING "${digits}" 0 ${point} scaled)
+        string(REGEX REPLACE "^0+([0-9])" "\\1" scaled "${scaled}")
+    endif()
+    set(${out_var} ${scaled} PARENT_SCOPE)
+endfunction()
+
+# Collects "<name>;<scaled ns>" pairs from the result file into <prefix>_NAMES and <prefix>_<name>.
+function(_shm_read_results file prefix)
+    file(READ "${file}" json)
+    string(JSON count LENGTH "${json}" benchmarks)
+
+    set(has_medians FALSE)
+    if (count GREATER 0)
+        math(EXPR last "${count} - 1")
+        foreach (i RANGE ${last})
+            string(JSON aggregate ERROR_VARIABLE no_aggregate GET "${json}" benchmarks ${i} aggregate_name)
+            if (NOT no_aggregate AND aggregate STREQUAL "median")
+                set(has_medians TRUE)
+                break()
+            endif()
+        endforeach()
+    endif()
+
+    set(names "")
+    if (count GREATER 0)
+        foreach (i RANGE ${last})
+            string(JSON run_type ERROR_VARIABLE no_run_type GET "${json}" benchmarks ${i} run_type)
+            string(JSON aggregate ERROR_VARIABLE no_aggregate GET "${json}" benchmarks ${i} aggregate_name)
+            if (has_medians)
+                if (no_aggregate OR NOT aggregate STREQUAL "median")
+                    continue()
+                endif()
+                string(JSON name GET "${json}" benchmarks ${i} run_name)
+            else()
+                if (NOT no_run_type AND NOT run_type STREQUAL "iteration")
+                    continue()
+                endif()
+                string(JSON name GET "${json}" benchmarks ${i} name)
+            endif()
+
+            string(JSON value GET "${json}" benchmarks ${i} ${METRIC})
+            string(JSON unit GET "${json}" benchmarks ${i} time_unit)
+            _shm_to_scaled_ns("${value}" "${unit}" scaled)
+
+            string(MAKE_C_IDENTIFIER "${name}" key)
+            list(APPEND names "${name}")
+            set(${prefix}_${key} ${scaled} PARENT_SCOPE)
+        endforeach()
+    endif()
+    set(${prefix}_NAMES "${names}" PARENT_SCOPE)
+endfunction()
+
+function(_shm_format_scaled scaled out_var)
+    math(EXPR integer "${scaled} / 1000")
+    math(EXPR fraction "${scaled} % 1000")
+    string(LENGTH "${fraction}" length)
+    while (length LESS 3)
+        string(PREPEND fraction "0")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    set(${out_var} "${integer}.${fraction}ns" PARENT_SCOPE)
+endfunction()
+
+# Formats a value in tenths of a percent, e.g. -5 as -0.5%.
+function(_shm_format_tenths tenths out_var)
+    math(EXPR integer "${tenths} / 10")
+    math(EXPR fraction "${tenths} % 10")
+    if (fraction LESS 0)
+        math(EXPR fraction "-${fraction}")
+    endif()
+    if (tenths LESS 0 AND integer EQUAL 0)
+        set(integer "-0")
+    endif()
+    set(${out_var} "${integer}.${fraction}%" PARENT_SCOPE)
+endfunction()
+
+_shm_read_results("${BASELINE}" BASE)
+_shm_read_results("${CURRENT}" CUR)
+
+set(regressions "")
+set(report "")
+set(change_sum 0)
+set(change_count 0)
+foreach (name IN LISTS CUR_NAMES)
+    string(MAKE_C_IDENTIFIER "${name}" key)
+    if (NOT DEFINED BASE_${key})
+        string(APPEND report "  new        ${name}\n")
+        continue()
+    endif()
+
+    set(base ${BASE_${key}})
+    set(cur ${CUR_${key}})
+    if (base EQUAL 0)
+        continue()
+    endif()
+
+    # Change in tenths of a percent, positive is slower.
+    math(EXPR change "((${cur} - ${base}) * 1000) / ${base}")
+    math(EXPR change_sum "${change_sum} + ${change}")
+    math(EXPR change_count "${change_count} + 1")
+    _shm_format_tenths(${change} change_text)
+    _shm_format_scaled(${base} base_text)
+    _shm_format_scaled(${cur} cur_text)
+
+    math(EXPR threshold_tenths "${THRESHOLD} * 10")
+    if (REPORT_ONLY)
+        set(status "")
+    elseif (change GREATER threshold_tenths)
+        set(status "REGRESSED ")
+        list(APPEND regressions "${name}")
+    else()
+        set(status "ok        ")
+    endif()
+    string(APPEND report "  ${status} ${name}: ${base_text} -> ${cur_text} (${change_text})\n")
+endforeach()
+
+if (change_count GREATER 0)
+    math(EXPR mean "${change_sum} / ${change_count}")
+    _shm_format_tenths(${mean} mean_text)
+    string(APPEND report "  mean change over ${change_count} benchmark(s): ${mean_text}\n")
+endif()
+
+message(STATUS "Benchmark comparison of ${CURRENT} against ${BASELINE} (${METRIC}, threshold ${THRESHOLD}%):\n${report}")
+
+list(LENGTH regressions regression_count)
+if (regression_count GREATER 0)
+    list(JOIN regressions "\n  " regression_text)
+    message(FATAL_ERROR "${regression_count} benchmark(s) regressed by more than ${THRESHOLD}%:\n  ${regression_text}")
+endif()
@@ -0,0 +1,98 @@
+include(CMakeDependentOption)
+
+### FEATURES
+cmake_dependent_option(BUILD_TESTING "Build tests" ON [["build-tests" IN_LIST VCPKG_MANIFEST_FEATURES]] ON )
+cmake_dependent_option(BUILD_BENCHMARKS "Build benchmarks" ON [["build-benchmarks" IN_LIST VCPKG_MANIFEST_FEATURES]] OFF )
+
+### LOGGING
+# SHM_LOG_* statements below this level are compiled out, empty keeps the default (info with NDEBUG, trace otherwise).
+set(SHIMMER_LOG_ACTIVE_LEVEL "" CACHE STRING "Lowest log level compiled in: trace, debug, info, warn, error, critical, off or empty")
+set_property(CACHE SHIMMER_LOG_ACTIVE_LEVEL PROPERTY STRINGS "" trace debug info warn error critical off)
+if (SHIMMER_LOG_ACTIVE_LEVEL AND NOT SHIMMER_LOG_ACTIVE_LEVEL MATCHES "^(trace|debug|info|warn|error|critical|off)$")
+    message(FATAL_ERROR "Unknown SHIMMER_LOG_ACTIVE_LEVEL '${SHIMMER_LOG_ACTIVE_LEVEL}'")
+endif()
+
+### CODE GENERATION
+# These apply to every target of the project, dependencies are built by vcpkg with the flags of the triplet.
+option(SHIMMER_ENABLE_LTO "Link time optimization, ThinLTO with Clang" OFF)
+option(SHIMMER_FRAME_POINTERS "Keep frame pointers so perf and other sampling profilers can unwind without DWARF" OFF)
+
+set(SHIMMER_SANITIZER "" CACHE STRING "Sanitizer instrumentation: address, thread, undefined or empty")
+set_property(CACHE SHIMMER_SANITIZER PROPERTY STRINGS "" address thread undefined)
+
+set(SHIMMER_PGO "OFF" CACHE STRING "Profile guided optimization stage: OFF, GENERATE (instrumented build) or USE (optimized with SHIMMER_PGO_PROFILE)")
+set_property(CACHE SHIMMER_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(SHIMMER_PGO_PROFILE "${PROJECT_SOURCE_DIR}/.build_linux/pgo/shimmer.profdata" CACHE FILEPATH "Merged profile used by SHIMMER_PGO=USE")
+
+set(_SHIMMER_IS_CLANG_LIKE FALSE)
+if (CMAKE_CXX_COMPILER_ID MATCHES "Clang" AND NOT CMAKE_CXX_COMPILER_FRONTEND_VARIANT STREQUAL "MSVC")
+    set(_SHIMMER_IS_CLANG_LIKE TRUE)
+endif()
+
+if (SHIMMER_ENABLE_LTO)
+    if (_SHIMMER_IS_CLANG_LIKE)
+        add_compile_options(-flto=thin)
+        add_link_options(-flto=thin)
+    else()
+        include(CheckIPOSupported)
+        check_ipo_supported(RESULT _shimmer_ipo_supported OUTPUT _shimmer_ipo_output)
+        if (NOT _shimmer_ipo_supported)
+            message(FATAL_ERROR "SHIMMER_ENABLE_LTO is set but the compiler does not support it: ${_shimmer_ipo_output}")
+        endif()
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+    endif()
+endif()
+
+if (SHIMMER_FRAME_POINTERS OR SHIMMER_SANITIZER)
+    if (MSVC)
+        message(WARNING "SHIMMER_FRAME_POINTERS is not supported with MSVC, ignoring")
+    else()
+        add_compile_options(-fno-omit-frame-pointer -mno-omit-leaf-frame-pointer)
+    endif()
+endif()
+
+if (SHIMMER_SANITIZER)
+    if (NOT SHIMMER_SANITIZER MATCHES "^(address|thread|undefined)$")
+        message(FATAL_ERROR "Unknown SHIMMER_SANITIZER '${SHIMMER_SANITIZER}', expected address, thread or undefined")
+    endif()
+    if (MSVC AND NOT SHIMMER_SANITIZER STREQUAL "address")
+        message(FATAL_ERROR "MSVC only supports SHIMMER_SANITIZER=address")
+    endif()
+
+    if (MSVC)
+        add_compile_options(/fsanitize=address)
+    else()
+        add_compile_options(-fsanitize=${SHIMMER_SANITIZER} -fno-sanitize-recover=all)
+        add_link_options(-fsanitize=${SHIMMER_SANITIZER})
+    endif()
+endif()
+
+if (NOT SHIMMER_PGO STREQUAL "OFF")
+    if (NOT _SHIMMER_IS_CLANG_LIKE AND NOT CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        message(FATAL_ERROR "SHIMMER_PGO requires Clang or GCC")
+    endif()
+
+    if (SHIMMER_PGO STREQUAL "GENERATE")
+        if (_SHIMMER_IS_CLANG_LIKE)
+            add_compile_options(-fprofile-instr-generate)
+            add_link_options(-fprofile-instr-generate)
+        else()
+            add_compile_options(-fprofile-generate)
+            add_link_options(-fprofile-generate)
+        endif()
+    elseif (SHIMMER_PGO STREQUAL "USE")
+        if (NOT EXISTS "${SHIMMER_PGO_PROFILE}")
+            message(FATAL_ERROR "SHIMMER_PGO=USE but the profile '${SHIMMER_PGO_PROFILE}' does not exist, run tools/pgo/pgo.sh")
+        endif()
+        if (_SHIMMER_IS_CLANG_LIKE)
+            # Code that changed since the training run is expected, it just does not get profile data.
+            add_compile_options(-fprofile-instr-use=${SHIMMER_PGO_PROFILE} -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date)
+        else()
+            add_compile_options(-fprofile-use=${SHIMMER_PGO_PROFILE} -fprofile-partial-training -Wno-missing-profile)
+        endif()
+    else()
+        message(FATAL_ERROR "Unknown SHIMMER_PGO '${SHIMMER_PGO}', expected OFF, GENERATE or USE")
+    endif()
+endif()
+
+message(STATUS "* LTO ${SHIMMER_ENABLE_LTO}, PGO ${SHIMMER_PGO}, sanitizer '${SHIMMER_SANITIZER}', frame pointers ${SHIMMER_FRAME_POINTERS}")
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace shm::bench
+{
+    /// @return Resident set size of the current process in bytes, 0 if it cannot be determined.
+    inline std::size_t CurrentRss()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+            return counters.WorkingSetSize;
+        return 0;
+#else
+        std::ifstream statm( "/proc/self/statm" );
+        std::size_t total_pages    = 0;
+        std::size_t resident_pages = 0;
+        if ( !( statm >> total_pages >> resident_pages ) )
+            return 0;
+        return resident_pages * static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) );
+#endif
+    }
+
+    /// @brief Returns the p-th percentile (0..1) of the samples, reorders the input.
+    template< typename T >
+    T Percentile( std::vector< T > & samples, double p )
+    {
+        if ( samples.empty() )
+            return T{};
+
+        const auto nth = static_cast< std::size_t >( p * static_cast< double >( samples.size() - 1 ) );
+        std::nth_element( samples.begin(), samples.begin() + static_cast< std::ptrdiff_t >( nth ), samples.end() );
+        return samples[ nth ];
+    }
+} // namespace shm::bench
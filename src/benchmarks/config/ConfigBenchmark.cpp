@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+
+#include "config/Config.hpp"
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+namespace
+{
+    constexpr std::string_view G_CONFIG_DIR = "./Testing/Benchmarks/Configs";
+
+    struct BenchConfig
+    {
+        static constexpr uint32_t ConfigVersion = 1;
+
+        int32_t tick_rate                = 120;
+        uint32_t max_connections         = 10'000;
+        std::string listen_address       = "0.0.0.0:50000";
+        std::array< float, 8 > weights   = {};
+        std::vector< std::string > peers = { "broker-a", "broker-b", "broker-c" };
+    };
+
+    shm::Result< BenchConfig > BenchConfigMigrator( std::string &, uint32_t, uint32_t )
+    {
+        return BenchConfig{};
+    }
+
+    std::string ConfigName( int64_t index )
+    {
+        return fmt::format( "BenchConfig{}", index );
+    }
+
+    /// @brief Config holding state.range( 0 ) registered configs, the looked up one is registered last.
+    struct PopulatedConfig
+    {
+        explicit PopulatedConfig( int64_t count )
+        {
+            std::filesystem::remove_all( G_CONFIG_DIR );
+            m_config = std::make_unique< shm::Config >( G_CONFIG_DIR );
+            for ( int64_t i = 0; i < count; ++i )
+                (void)m_config->RegisterConfig( BenchConfig{}, ConfigName( i ), "json", &BenchConfigMigrator );
+            m_last_name = ConfigName( count - 1 );
+        }
+
+        std::unique_ptr< shm::Config > m_config;
+        std::string m_last_name;
+    };
+
+    void BM_GetConfigConst( benchmark::State & state )
+    {
+        PopulatedConfig populated( state.range( 0 ) );
+        for ( auto _ : state )
+        {
+            auto accessor = populated.m_config->GetConfig< const BenchConfig >( populated.m_last_name );
+            benchmark::DoNotOptimize( accessor->tick_rate );
+        }
+    }
+
+    /// @brief Mutable access that only reads, the destructor finds no changed field and queues nothing.
+    void BM_ConfigAccessorUnchanged( benchmark::State & state )
+    {
+        PopulatedConfig populated( state.range( 0 ) );
+        for ( auto _ : state )
+        {
+            auto accessor = populated.m_config->GetConfig< BenchConfig >( populated.m_last_name );
+            benchmark::DoNotOptimize( accessor->tick_rate );
+        }
+    }
+
+    /// @brief Mutable access changing a field, the destructor merges it into the pending update.
+    void BM_ConfigAccessorWriteBack( benchmark::State & state )
+    {
+        PopulatedConfig populated( state.range( 0 ) );
+        int32_t value = 0;
+        for ( auto _ : state )
+        {
+            auto accessor       = populated.m_config->GetConfig< BenchConfig >( populated.m_last_name );
+            accessor->tick_rate = ++value;
+        }
+    }
+
+    /// @brief Applies and persists state.range( 0 ) dirty configs per iteration.
+    void BM_SaveDirtyConfigs( benchmark::State & state )
+    {
+        const auto count = state.range( 0 );
+        PopulatedConfig populated( count );
+        int32_t value = 0;
+        for ( auto _ : state )
+        {
+            state.PauseTiming();
+            ++value;
+            for ( int64_t i = 0; i < count; ++i )
+                populated.m_config->GetConfig< BenchConfig >( ConfigName( i ) )->tick_rate = value;
+            state.ResumeTiming();
+
+            auto results = populated.m_config->SaveDirtyConfigs();
+            benchmark::DoNotOptimize( results.data() );
+        }
+        state.SetItemsProcessed( state.iterations() * count );
+    }
+} // namespace
+
+BENCHMARK( BM_GetConfigConst )->Arg( 1 )->Arg( 16 )->Arg( 64 );
+BENCHMARK( BM_ConfigAccessorUnchanged )->Arg( 1 )->Arg( 16 )->Arg( 64 );
+BENCHMARK( BM_ConfigAccessorWriteBack )->Arg( 1 )->Arg( 16 )->Arg( 64 );
+BENCHMARK( BM_SaveDirtyConfigs )->Arg( 1 )->Arg( 16 )->Unit( benchmark::kMicrosecond );
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include "filesystem/Filesystem.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace
+{
+    const std::filesystem::path G_FILE_DIR = "./Testing/Benchmarks/Files";
+
+    std::filesystem::path PrepareFile( int64_t size )
+    {
+        (void)shm::fs::CreateDirectories( G_FILE_DIR );
+        const auto path = G_FILE_DIR / ( "read_" + std::to_string( size ) + ".txt" );
+        (void)shm::fs::WriteStringToFile( path, std::string( static_cast< std::size_t >( size ), 'x' ), std::ios::out | std::ios::trunc );
+        return path;
+    }
+
+    void BM_ReadFileToString( benchmark::State & state )
+    {
+        const auto path = PrepareFile( state.range( 0 ) );
+        for ( auto _ : state )
+        {
+            auto content = shm::fs::ReadFileToString( path );
+            benchmark::DoNotOptimize( content );
+        }
+        state.SetBytesProcessed( state.iterations() * state.range( 0 ) );
+    }
+
+    void BM_WriteStringToFile( benchmark::State & state )
+    {
+        const auto path = PrepareFile( state.range( 0 ) );
+        const std::string data( static_cast< std::size_t >( state.range( 0 ) ), 'y' );
+        for ( auto _ : state )
+        {
+            auto result = shm::fs::WriteStringToFile( path, data, std::ios::out | std::ios::trunc );
+            benchmark::DoNotOptimize( result );
+        }
+        state.SetBytesProcessed( state.iterations() * state.range( 0 ) );
+    }
+
+    void BM_GetFileName( benchmark::State & state )
+    {
+        const std::filesystem::path path = "./configs/world/BrokerSettings.json";
+        for ( auto _ : state )
+        {
+            auto name = shm::fs::GetFileName( path );
+            benchmark::DoNotOptimize( name );
+        }
+    }
+} // namespace
+
+BENCHMARK( BM_ReadFileToString )->Arg( 1 << 10 )->Arg( 64 << 10 )->Arg( 1 << 20 );
+BENCHMARK( BM_WriteStringToFile )->Arg( 1 << 10 )->Arg( 64 << 10 );
+BENCHMARK( BM_GetFileName );
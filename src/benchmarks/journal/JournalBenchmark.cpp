@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+
+#include "journal/Journal.hpp"
+
+#include <filesystem>
+#include <flecs.h>
+#include <memory>
+
+namespace
+{
+    constexpr std::string_view G_JOURNAL_DIR = "./Testing/Benchmarks/Journal";
+
+    std::filesystem::path CleanJournalDir( std::string_view name )
+    {
+        const auto dir = std::filesystem::path( G_JOURNAL_DIR ) / name;
+        std::filesystem::remove_all( dir );
+        return dir;
+    }
+
+    /// @brief Commits state.range( 0 ) transform updates per tick, the writer thread encodes and writes them.
+    void BM_JournalAppend( benchmark::State & state )
+    {
+        const auto commands_per_tick = state.range( 0 );
+        flecs::world world;
+        shm::journal::WorldJournal journal( world, { .m_directory = CleanJournalDir( "Append" ), .m_snapshot_interval_ticks = 0 } );
+        std::ignore = journal.Recover();
+
+        for ( int64_t i = 0; i < commands_per_tick; ++i )
+            journal.Submit( shm::journal::WorldCommand::Spawn( journal.AllocateEntityId() ) );
+        journal.CommitTick( 0 );
+
+        uint64_t tick = 1;
+        for ( auto _ : state )
+        {
+            for ( int64_t i = 0; i < commands_per_tick; ++i )
+                journal.Submit( shm::journal::WorldCommand::Set( static_cast< uint64_t >( i + 1 ), shm::journal::Transform{ static_cast< float >( tick ), 0.0f, 0.0f } ) );
+            journal.CommitTick( tick++ );
+        }
+        // Included so the numbers reflect what the writer sustains, not only how fast the queue fills up.
+        journal.Flush();
+        state.SetItemsProcessed( state.iterations() * commands_per_tick );
+    }
+
+    /// @brief Restores a world of 1M entities from a snapshot plus a journal tail of 1000 ticks.
+    void BM_JournalRecovery( benchmark::State & state )
+    {
+        constexpr uint64_t entity_count = 1'000'000;
+        constexpr uint64_t tail_ticks   = 1'000;
+        const auto dir                  = CleanJournalDir( "Recovery" );
+        {
+            flecs::world world;
+            shm::journal::WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+            std::ignore = journal.Recover();
+            for ( uint64_t i = 0; i < entity_count; ++i )
+            {
+                const auto id = journal.AllocateEntityId();
+                journal.Submit( shm::journal::WorldCommand::Spawn( id ) );
+                journal.Submit( shm::journal::WorldCommand::Set( id, shm::journal::Transform{ 1.0f, 2.0f, 3.0f } ) );
+                journal.Submit( shm::journal::WorldCommand::Set( id, shm::journal::Presence{ .session_id = i, .world_id = 1 } ) );
+            }
+            journal.CommitTick( 0 );
+            journal.RequestSnapshot();
+            for ( uint64_t tick = 1; tick <= tail_ticks; ++tick )
+            {
+                for ( uint64_t i = 0; i < 100; ++i )
+                    journal.Submit( shm::journal::WorldCommand::Set( ( tick * 100 + i ) % entity_count + 1, shm::journal::Transform{ 4.0f, 5.0f, 6.0f } ) );
+                journal.CommitTick( tick );
+            }
+            journal.Flush();
+        }
+
+        std::unique_ptr< shm::journal::WorldJournal > journal;
+        std::unique_ptr< flecs::world > world;
+        for ( auto _ : state )
+        {
+            // Tearing down the previous world and creating an empty one are not part of the recovery.
+            state.PauseTiming();
+            journal.reset();
+            world   = std::make_unique< flecs::world >();
+            journal = std::make_unique< shm::journal::WorldJournal >( *world, shm::journal::JournalSettings{ .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+            state.ResumeTiming();
+
+            auto stats = journal->Recover();
+            if ( !stats.has_value() || stats->m_snapshot_entities != entity_count )
+                state.SkipWithError( "Recovery failed" );
+            benchmark::DoNotOptimize( stats );
+        }
+        state.SetItemsProcessed( state.iterations() * entity_count );
+    }
+} // namespace
+
+BENCHMARK( BM_JournalAppend )->Arg( 16 )->Arg( 1024 );
+BENCHMARK( BM_JournalRecovery )->Unit( benchmark::kMillisecond )->Iterations( 3 );
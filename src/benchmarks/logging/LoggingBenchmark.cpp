@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+
+#include "logging/FlightRecorder.hpp"
+#include "logging/Logging.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    constexpr std::string_view G_LOG_DIR = "./Testing/Benchmarks/Logs/";
+
+    /// @brief Installs a shm::Logger writing to a rotating file only, the setup the broker uses minus stderr.
+    /// The flight recorder is left out unless asked for, so the other numbers stay comparable.
+    struct BenchLogger
+    {
+        explicit BenchLogger( spdlog::level::level_enum level, bool flight_recorder = false, uint32_t max_file_size_bytes = 1024 * 1024 * 64 )
+        {
+            std::filesystem::remove_all( G_LOG_DIR );
+            m_logger = std::make_unique< shm::Logger >( shm::LoggerSettings{
+                .m_log_file_name          = "benchmark.log",
+                .m_log_file_path          = std::string( G_LOG_DIR ),
+                .m_max_file_size_bytes    = max_file_size_bytes,
+                .m_max_files              = 2,
+                .m_logger_name            = "benchmark",
+                .m_level                  = level,
+                .m_flush_level            = spdlog::level::off,
+                .m_log_pattern            = R"([%Y-%m-%d %H:%M:%S.%e] [%l@thread:%t] %*%v)",
+                .m_enable_stderr          = false,
+                .m_enable_flight_recorder = flight_recorder,
+                .m_enable_msvc            = false,
+            } );
+        }
+
+        std::unique_ptr< shm::Logger > m_logger;
+    };
+
+    void BM_LogScope( benchmark::State & state )
+    {
+        for ( auto _ : state )
+        {
+            shm::LogScope scope{ "BenchmarkScope" };
+            benchmark::ClobberMemory();
+        }
+    }
+
+    void BM_NestedLogScope( benchmark::State & state )
+    {
+        shm::LogScope outer{ "Outer" };
+        shm::LogScope middle{ "Middle" };
+        for ( auto _ : state )
+        {
+            shm::LogScope scope{ "Inner" };
+            benchmark::ClobberMemory();
+        }
+    }
+
+    /// @brief Formats and writes one record per iteration, including the %* scope flag.
+    void BM_LoggerThroughput( benchmark::State & state )
+    {
+        BenchLogger logger( spdlog::level::info );
+        shm::LogScope scope{ "Benchmark" };
+        int64_t value = 0;
+        for ( auto _ : state )
+            spdlog::info( "tick {} processed {} messages in {:.3f}ms", ++value, 42, 1.25 );
+        spdlog::default_logger()->flush();
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    /// @brief Same with a file small enough to rotate every few hundred records, rotation itself runs on a worker thread.
+    void BM_LoggerThroughputRotating( benchmark::State & state )
+    {
+        BenchLogger logger( spdlog::level::info, false, 64 * 1024 );
+        shm::LogScope scope{ "Benchmark" };
+        int64_t value = 0;
+        for ( auto _ : state )
+            spdlog::info( "tick {} processed {} messages in {:.3f}ms", ++value, 42, 1.25 );
+        spdlog::default_logger()->flush();
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    /// @brief Records below the logger level, the cost every disabled debug statement pays.
+    void BM_LoggerFiltered( benchmark::State & state )
+    {
+        BenchLogger logger( spdlog::level::info );
+        int64_t value = 0;
+        for ( auto _ : state )
+            spdlog::debug( "tick {} processed {} messages in {:.3f}ms", ++value, 42, 1.25 );
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    /// @brief A disabled SHM_LOG_* statement, one relaxed load of the category level.
+    void BM_LogMacroDisabled( benchmark::State & state )
+    {
+        BenchLogger logger( spdlog::level::info );
+        shm::LogCategory category{ "Benchmark" };
+        int64_t value = 0;
+        for ( auto _ : state )
+            SHM_LOG_TO( category, spdlog::level::debug, "tick {} processed {} messages in {:.3f}ms", ++value, 42, 1.25 );
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    /// @brief Same through the thread's current category, as SHM_LOG_DEBUG does unless stripped at compile time.
+    void BM_LogMacroDisabledCurrentCategory( benchmark::State & state )
+    {
+        BenchLogger logger( spdlog::level::info );
+        int64_t value = 0;
+        for ( auto _ : state )
+            SHM_LOG_TO( shm::log::CurrentCategory(), spdlog::level::debug, "tick {} processed {} messages in {:.3f}ms", ++value, 42, 1.25 );
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    /// @brief Records below the file level that only the flight recorder keeps, the cost debug statements pay in the broker.
+    void BM_FlightRecorderRecord( benchmark::State & state )
+    {
+        BenchLogger logger( spdlog::level::info, true );
+        int64_t value = 0;
+        for ( auto _ : state )
+            SHM_LOG_TO( shm::log::CurrentCategory(), spdlog::level::debug, "tick {} processed {} messages in {:.3f}ms", ++value, 42, 1.25 );
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    void BM_FlightRecorderFrame( benchmark::State & state )
+    {
+        uint64_t tick = 0;
+        for ( auto _ : state )
+            shm::flight::RecordFrame( ++tick, 1'250'000 );
+        state.SetItemsProcessed( state.iterations() );
+    }
+
+    /// @brief Dumps full rings of two threads, the work done in a fatal signal handler.
+    void BM_FlightRecorderDump( benchmark::State & state )
+    {
+        std::filesystem::create_directories( G_LOG_DIR );
+        std::jthread other( []()
+                            {
+                                for ( uint64_t tick = 0; tick < shm::flight::RecordsPerThread; ++tick )
+                                    shm::flight::RecordFrame( tick, 1'250'000 );
+                            } );
+        other.join();
+        for ( uint64_t tick = 0; tick < shm::flight::RecordsPerThread; ++tick )
+            shm::flight::RecordFrame( tick, 1'250'000 );
+
+        const auto path = std::filesystem::path( G_LOG_DIR ) / "benchmark.flight.log";
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( shm::flight::Dump( path ) );
+        state.SetItemsProcessed( state.iterations() * 2 * shm::flight::RecordsPerThread );
+    }
+} // namespace
+
+BENCHMARK( BM_LogScope );
+BENCHMARK( BM_NestedLogScope );
+BENCHMARK( BM_LoggerThroughput );
+BENCHMARK( BM_LoggerThroughputRotating );
+BENCHMARK( BM_LoggerFiltered );
+BENCHMARK( BM_LogMacroDisabled );
+BENCHMARK( BM_LogMacroDisabledCurrentCategory );
+BENCHMARK( BM_FlightRecorderRecord );
+BENCHMARK( BM_FlightRecorderFrame );
+BENCHMARK( BM_FlightRecorderDump );
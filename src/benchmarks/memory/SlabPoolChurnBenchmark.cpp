@@ -0,0 +1,134 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchmarkUtils.hpp"
+#include "net/Gateway.hpp"
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t G_STEADY_CONNECTIONS = 10'000;
+    constexpr std::size_t G_CHURN_PER_SECOND   = 10'000;
+
+    constexpr std::array< std::byte, 256 > G_PAYLOAD{};
+
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief One player churn step through the gateway: connect, queue a couple of messages,
+    /// flush one of them and disconnect the oldest connection.
+    struct PooledChurn
+    {
+        shm::net::Gateway m_gateway;
+        std::deque< shm::net::ConnectionHandle > m_live;
+        uint64_t m_tick = 0;
+
+        void Connect()
+        {
+            auto connection = m_gateway.Open( "127.0.0.1:50000", ++m_tick );
+            m_gateway.Send( connection, G_PAYLOAD );
+            m_gateway.Send( connection, G_PAYLOAD );
+            m_gateway.ReleaseBuffer( m_gateway.PopQueued( connection ) );
+            m_live.push_back( connection );
+        }
+
+        void Disconnect()
+        {
+            m_gateway.Close( m_live.front() );
+            m_live.pop_front();
+        }
+    };
+
+    /// @brief Same churn with plain heap allocations, the baseline the pool has to beat.
+    struct HeapChurn
+    {
+        struct HeapConnection
+        {
+            shm::net::Connection m_connection{ "127.0.0.1:50000", 0 };
+            std::deque< std::vector< std::byte > > m_send_queue;
+        };
+
+        std::deque< std::unique_ptr< HeapConnection > > m_live;
+
+        void Connect()
+        {
+            auto connection = std::make_unique< HeapConnection >();
+            connection->m_send_queue.emplace_back( G_PAYLOAD.begin(), G_PAYLOAD.end() );
+            connection->m_send_queue.emplace_back( G_PAYLOAD.begin(), G_PAYLOAD.end() );
+            connection->m_send_queue.pop_front();
+            m_live.push_back( std::move( connection ) );
+        }
+
+        void Disconnect()
+        {
+            m_live.pop_front();
+        }
+    };
+
+    template< typename Churn >
+    void BM_ConnectionChurn( benchmark::State & state )
+    {
+        Churn churn;
+        for ( std::size_t i = 0; i < G_STEADY_CONNECTIONS; ++i )
+            churn.Connect();
+
+        const auto rss_start = shm::bench::CurrentRss();
+        for ( auto _ : state )
+        {
+            churn.Connect();
+            churn.Disconnect();
+        }
+        const auto rss_end = shm::bench::CurrentRss();
+
+        state.SetItemsProcessed( state.iterations() );
+        state.counters[ "rss_start_mb" ]  = static_cast< double >( rss_start ) / ( 1024.0 * 1024.0 );
+        state.counters[ "rss_growth_kb" ] = ( static_cast< double >( rss_end ) - static_cast< double >( rss_start ) ) / 1024.0;
+    }
+
+    /// @brief Connect/disconnect paced at G_CHURN_PER_SECOND for one second per iteration on top of a steady population.
+    /// Reports the allocation latency distribution and how much the RSS moved over the whole run.
+    template< typename Churn >
+    void BM_PacedConnectionChurn( benchmark::State & state )
+    {
+        Churn churn;
+        for ( std::size_t i = 0; i < G_STEADY_CONNECTIONS; ++i )
+            churn.Connect();
+
+        const auto interval = std::chrono::nanoseconds( std::chrono::seconds( 1 ) ) / G_CHURN_PER_SECOND;
+        std::vector< int64_t > latencies_ns;
+        latencies_ns.reserve( G_CHURN_PER_SECOND * 8 );
+
+        const auto rss_start = shm::bench::CurrentRss();
+        for ( auto _ : state )
+        {
+            auto next = Clock::now();
+            for ( std::size_t i = 0; i < G_CHURN_PER_SECOND; ++i )
+            {
+                const auto begin = Clock::now();
+                churn.Connect();
+                churn.Disconnect();
+                latencies_ns.push_back( std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now() - begin ).count() );
+
+                next += interval;
+                while ( Clock::now() < next )
+                    std::this_thread::yield();
+            }
+        }
+        const auto rss_end = shm::bench::CurrentRss();
+
+        state.SetItemsProcessed( static_cast< int64_t >( latencies_ns.size() ) );
+        state.counters[ "p50_ns" ]        = static_cast< double >( shm::bench::Percentile( latencies_ns, 0.50 ) );
+        state.counters[ "p99_ns" ]        = static_cast< double >( shm::bench::Percentile( latencies_ns, 0.99 ) );
+        state.counters[ "max_ns" ]        = static_cast< double >( shm::bench::Percentile( latencies_ns, 1.0 ) );
+        state.counters[ "rss_growth_kb" ] = ( static_cast< double >( rss_end ) - static_cast< double >( rss_start ) ) / 1024.0;
+    }
+} // namespace
+
+BENCHMARK_TEMPLATE( BM_ConnectionChurn, PooledChurn );
+BENCHMARK_TEMPLATE( BM_ConnectionChurn, HeapChurn );
+BENCHMARK_TEMPLATE( BM_PacedConnectionChurn, PooledChurn )->Iterations( 5 )->UseRealTime()->Unit( benchmark::kMillisecond );
+BENCHMARK_TEMPLATE( BM_PacedConnectionChurn, HeapChurn )->Iterations( 5 )->UseRealTime()->Unit( benchmark::kMillisecond );
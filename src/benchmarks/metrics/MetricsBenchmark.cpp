@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include "metrics/Metrics.hpp"
+
+namespace
+{
+    shm::metrics::Registry G_REGISTRY;
+
+    void BM_CounterIncrement( benchmark::State & state )
+    {
+        auto & counter = G_REGISTRY.GetCounter( "bench_counter_total" );
+        for ( auto _ : state )
+            counter.Increment();
+        benchmark::DoNotOptimize( counter.Value() );
+    }
+
+    void BM_GaugeSet( benchmark::State & state )
+    {
+        auto & gauge  = G_REGISTRY.GetGauge( "bench_gauge" );
+        int64_t value = 0;
+        for ( auto _ : state )
+            gauge.Set( ++value );
+    }
+
+    void BM_HistogramRecord( benchmark::State & state )
+    {
+        auto & histogram = G_REGISTRY.GetHistogram( "bench_histogram_ns" );
+        uint64_t value   = 1;
+        for ( auto _ : state )
+        {
+            histogram.Record( value );
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+            value >>= 40;
+        }
+    }
+} // namespace
+
+BENCHMARK( BM_CounterIncrement )->ThreadRange( 1, 8 );
+BENCHMARK( BM_GaugeSet );
+BENCHMARK( BM_HistogramRecord )->ThreadRange( 1, 8 );
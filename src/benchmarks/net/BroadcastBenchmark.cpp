@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchmarkUtils.hpp"
+#include "net/Gateway.hpp"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t G_RECIPIENTS = 10'000;
+    constexpr uint16_t G_OPCODE        = 42;
+
+    /// @brief Takes every frame and only counts the bytes, so the benchmark measures the broker's side of the fan-out.
+    class CountingTransport final : public shm::net::ITransport
+    {
+    public:
+        explicit CountingTransport( uint64_t & bytes )
+            : m_bytes( bytes )
+        {
+        }
+
+        shm::Result< void > SendGathered( const shm::protocol::FrameHeader & header, std::span< const std::byte > payload ) override
+        {
+            benchmark::DoNotOptimize( payload.data() );
+            m_bytes += sizeof( header ) + payload.size();
+            return {};
+        }
+
+        shm::Result< std::span< const std::byte > > ReceiveFrame( std::span< std::byte >, std::chrono::nanoseconds ) override
+        {
+            return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+        }
+
+    private:
+        uint64_t & m_bytes;
+    };
+
+    struct Audience
+    {
+        shm::net::Gateway m_gateway;
+        std::vector< shm::net::ConnectionHandle > m_recipients;
+        uint64_t m_bytes_sent = 0;
+
+        Audience()
+        {
+            for ( std::size_t i = 0; i < G_RECIPIENTS; ++i )
+                m_recipients.push_back( m_gateway.Attach( "127.0.0.1:50000", 0, std::make_unique< CountingTransport >( m_bytes_sent ) ) );
+            m_gateway.Inbound().Clear();
+        }
+    };
+
+    /// @brief Encodes the frame once per recipient into a buffer of its own, the way Gateway::Send queues it.
+    void QueueCopies( Audience & audience, std::span< const std::byte > payload )
+    {
+        std::vector< std::byte > frame( sizeof( shm::protocol::FrameHeader ) + payload.size() );
+        for ( const auto recipient : audience.m_recipients )
+        {
+            const shm::protocol::FrameHeader header{ .m_length   = static_cast< uint16_t >( payload.size() ),
+                                                     .m_opcode   = G_OPCODE,
+                                                     .m_checksum = shm::hash::Crc32c( payload ) };
+            std::memcpy( frame.data(), &header, sizeof( header ) );
+            std::memcpy( frame.data() + sizeof( header ), payload.data(), payload.size() );
+            audience.m_gateway.Send( recipient, frame );
+        }
+    }
+
+    void QueueShared( Audience & audience, std::span< const std::byte > payload )
+    {
+        audience.m_gateway.Broadcast( audience.m_recipients, G_OPCODE, payload );
+    }
+
+    /// @brief One broadcast of state.range( 0 ) payload bytes to G_RECIPIENTS sessions, queued and written to their
+    /// transports. Reports the peak of pooled buffer memory the broadcast held and the RSS growth.
+    template< void ( *Queue )( Audience &, std::span< const std::byte > ) >
+    void BM_Broadcast( benchmark::State & state )
+    {
+        Audience audience;
+        const std::vector< std::byte > payload( static_cast< std::size_t >( state.range( 0 ) ), std::byte{ 0x5A } );
+
+        const auto rss_start = shm::bench::CurrentRss();
+        uint64_t tick        = 0;
+        for ( auto _ : state )
+        {
+            Queue( audience, payload );
+            audience.m_gateway.PumpTransports( ++tick );
+        }
+        const auto rss_end = shm::bench::CurrentRss();
+
+        const auto buffers = audience.m_gateway.Stats().m_buffers;
+        state.SetItemsProcessed( static_cast< int64_t >( state.iterations() * G_RECIPIENTS ) );
+        state.SetBytesProcessed( static_cast< int64_t >( audience.m_bytes_sent ) );
+        state.counters[ "peak_buffers" ]   = static_cast< double >( buffers.m_high_water );
+        state.counters[ "peak_buffer_kb" ] = static_cast< double >( buffers.m_high_water * sizeof( shm::net::MessageBuffer ) ) / 1024.0;
+        state.counters[ "rss_growth_kb" ]  = ( static_cast< double >( rss_end ) - static_cast< double >( rss_start ) ) / 1024.0;
+    }
+} // namespace
+
+BENCHMARK_TEMPLATE( BM_Broadcast, QueueCopies )->Arg( 64 )->Arg( 1024 )->Unit( benchmark::kMicrosecond );
+BENCHMARK_TEMPLATE( BM_Broadcast, QueueShared )->Arg( 64 )->Arg( 1024 )->Unit( benchmark::kMicrosecond );
@@ -0,0 +1,146 @@
+#include <benchmark/benchmark.h>
+
+#include "net/Messages.hpp"
+#include "net/ShmTransport.hpp"
+#include "net/SocketTransport.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    enum class Kind : int64_t
+    {
+        Tcp,
+        Unix,
+        Shm,
+    };
+
+    using TransportPair = std::pair< std::unique_ptr< shm::net::ITransport >, std::unique_ptr< shm::net::ITransport > >;
+
+    shm::Result< TransportPair > MakePair( Kind kind )
+    {
+        if ( kind == Kind::Shm )
+        {
+            auto channel = shm::net::ShmTransport::CreateChannel();
+            if ( !channel.has_value() )
+                return std::unexpected( channel.error() );
+            auto broker = shm::net::ShmTransport::Attach( *channel, shm::net::ShmSide::Broker );
+            auto peer   = shm::net::ShmTransport::Attach( *channel, shm::net::ShmSide::Peer );
+            if ( !broker.has_value() || !peer.has_value() )
+                return std::unexpected( std::make_error_code( std::errc::io_error ) );
+            return TransportPair{ std::move( *broker ), std::move( *peer ) };
+        }
+
+        auto pair = shm::net::SocketTransport::CreatePair( kind == Kind::Tcp ? shm::net::SocketKind::TcpLoopback : shm::net::SocketKind::Unix );
+        if ( !pair.has_value() )
+            return std::unexpected( pair.error() );
+        return TransportPair{ std::move( pair->first ), std::move( pair->second ) };
+    }
+
+    /// @brief A frame carrying the given number of payload bytes. The transports do not look past the header,
+    /// so the checksum is left out.
+    std::vector< std::byte > MakeFrame( std::size_t payload )
+    {
+        std::vector< std::byte > frame( sizeof( shm::protocol::FrameHeader ) + payload, std::byte{ 0x5A } );
+        const shm::protocol::FrameHeader header{ .m_length = static_cast< uint16_t >( payload ), .m_opcode = shm::net::msg::Move::Opcode };
+        std::memcpy( frame.data(), &header, sizeof( header ) );
+        return frame;
+    }
+
+    /// @brief Retries while the peer does not keep up.
+    void SendBlocking( shm::net::ITransport & transport, std::span< const std::byte > frame )
+    {
+        const auto retry = []( const shm::Result< void > & result ) { return !result.has_value() && result.error() == std::errc::resource_unavailable_try_again; };
+        while ( retry( transport.SendFrame( frame ) ) )
+            std::this_thread::yield();
+        // A frame the transport only took in part is finished here, the receiver waits for its end.
+        while ( retry( transport.FlushPending() ) )
+            std::this_thread::yield();
+    }
+
+    /// @brief Receives frames until the other side sends one without payload or goes away.
+    template< typename OnFrame >
+    void ServeUntilStopped( shm::net::ITransport & transport, OnFrame && on_frame )
+    {
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+        while ( true )
+        {
+            const auto received = transport.ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+            if ( !received.has_value() && received.error() == std::errc::timed_out )
+                continue;
+            if ( !received.has_value() || received->size() == sizeof( shm::protocol::FrameHeader ) )
+                return;
+            on_frame( *received );
+        }
+    }
+
+    /// @brief Sends a frame to a peer thread which echoes it back, the time per iteration is one round trip.
+    /// Arguments: transport kind, payload bytes.
+    void BM_TransportRoundTrip( benchmark::State & state )
+    {
+        auto pair = MakePair( static_cast< Kind >( state.range( 0 ) ) );
+        if ( !pair.has_value() )
+        {
+            state.SkipWithError( "Transport could not be created" );
+            return;
+        }
+        auto & [ broker, peer ] = *pair;
+        const auto frame        = MakeFrame( static_cast< std::size_t >( state.range( 1 ) ) );
+
+        std::jthread echo( [ &peer ] { ServeUntilStopped( *peer, [ &peer ]( std::span< const std::byte > frame ) { SendBlocking( *peer, frame ); } ); } );
+
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+        for ( auto _ : state )
+        {
+            SendBlocking( *broker, frame );
+            const auto replied = broker->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+            benchmark::DoNotOptimize( replied );
+        }
+        SendBlocking( *broker, MakeFrame( 0 ) );
+        echo.join();
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * frame.size() * 2 ) );
+    }
+
+    /// @brief Streams frames to a peer thread which only reads them, the rate is one way throughput.
+    /// Arguments: transport kind, payload bytes.
+    void BM_TransportThroughput( benchmark::State & state )
+    {
+        auto pair = MakePair( static_cast< Kind >( state.range( 0 ) ) );
+        if ( !pair.has_value() )
+        {
+            state.SkipWithError( "Transport could not be created" );
+            return;
+        }
+        auto & [ broker, peer ] = *pair;
+        const auto frame        = MakeFrame( static_cast< std::size_t >( state.range( 1 ) ) );
+
+        std::atomic< uint64_t > received_frames{ 0 };
+        std::jthread sink( [ &peer, &received_frames ]
+                           { ServeUntilStopped( *peer, [ & ]( std::span< const std::byte > ) { received_frames.fetch_add( 1, std::memory_order_relaxed ); } ); } );
+
+        for ( auto _ : state )
+            SendBlocking( *broker, frame );
+        SendBlocking( *broker, MakeFrame( 0 ) );
+        sink.join();
+        state.counters[ "delivered" ] = static_cast< double >( received_frames.load() );
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * frame.size() ) );
+    }
+
+    void TransportArguments( benchmark::internal::Benchmark * benchmark )
+    {
+        benchmark->ArgNames( { "transport", "payload" } );
+        for ( const auto kind : { Kind::Tcp, Kind::Unix, Kind::Shm } )
+            for ( const int64_t payload : { 64, 1024 } )
+                benchmark->Args( { static_cast< int64_t >( kind ), payload } );
+    }
+} // namespace
+
+BENCHMARK( BM_TransportRoundTrip )->Apply( TransportArguments )->UseRealTime();
+BENCHMARK( BM_TransportThroughput )->Apply( TransportArguments )->UseRealTime();
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include "net/UdpSocket.hpp"
+
+#include <array>
+#include <vector>
+
+namespace
+{
+    /// @brief Datagrams per simulated tick, a burst to a single peer.
+    constexpr std::size_t G_BURST = 64;
+
+    /// @brief Sends a burst of 200 byte datagrams over loopback and receives it again on the same thread, so the
+    /// rate is packets per second per core for both ends together.
+    /// Arguments: UdpSendMode, datagrams per receive call (1 = one recvmmsg per packet, like recvfrom).
+    void BM_UdpLoopback( benchmark::State & state )
+    {
+        const auto mode     = static_cast< shm::net::UdpSendMode >( state.range( 0 ) );
+        const auto per_call = static_cast< std::size_t >( state.range( 1 ) );
+
+        shm::net::MessageBufferPool pool;
+        auto receiver = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+        auto sender   = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+        if ( !receiver.has_value() || !sender.has_value() )
+        {
+            state.SkipWithError( "UDP sockets could not be bound" );
+            return;
+        }
+        const auto to      = receiver->LocalAddress();
+        const auto payload = std::vector< std::byte >( 200, std::byte{ 0x5A } );
+        std::array< shm::net::ReceivedDatagram, G_BURST > datagrams;
+
+        uint64_t received = 0;
+        for ( auto _ : state )
+        {
+            for ( std::size_t i = 0; i < G_BURST; ++i )
+                sender->Queue( to, payload );
+            std::ignore = sender->Flush( mode );
+
+            // Loopback delivers synchronously, the burst is there once the send returned.
+            std::size_t burst_received = 0;
+            for ( int attempt = 0; attempt < 4 && burst_received < G_BURST; ++attempt )
+            {
+                const auto batch = receiver->ReceiveBatch( pool, std::span( datagrams ).subspan( burst_received ), per_call );
+                burst_received += batch.value_or( 0 );
+            }
+            for ( std::size_t i = 0; i < burst_received; ++i )
+                pool.Destroy( datagrams[ i ].m_buffer );
+            received += burst_received;
+        }
+        state.counters[ "packets_per_second" ] = benchmark::Counter( static_cast< double >( received ), benchmark::Counter::kIsRate );
+        state.counters[ "lost" ]               = static_cast< double >( state.iterations() * G_BURST - received );
+    }
+
+    void UdpArguments( benchmark::internal::Benchmark * benchmark )
+    {
+        benchmark->ArgNames( { "send_mode", "receive_batch" } );
+        benchmark->Args( { static_cast< int64_t >( shm::net::UdpSendMode::PerDatagram ), 1 } );
+        benchmark->Args( { static_cast< int64_t >( shm::net::UdpSendMode::Batched ), static_cast< int64_t >( shm::net::UdpSocket::BatchSize ) } );
+        benchmark->Args( { static_cast< int64_t >( shm::net::UdpSendMode::Segmented ), static_cast< int64_t >( shm::net::UdpSocket::BatchSize ) } );
+    }
+} // namespace
+
+BENCHMARK( BM_UdpLoopback )->Apply( UdpArguments );
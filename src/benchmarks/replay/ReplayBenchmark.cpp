@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+
+#include "app/InboundHandler.hpp"
+#include "journal/Journal.hpp"
+#include "net/Messages.hpp"
+#include "replay/Capture.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <filesystem>
+#include <flecs.h>
+#include <memory>
+
+namespace
+{
+    constexpr std::string_view G_REPLAY_DIR = "./Testing/Benchmarks/Replay";
+    constexpr uint64_t G_CAPTURE_TICKS      = 600;
+
+    /// @brief Records G_CAPTURE_TICKS ticks of the given number of sessions, each sending one position update per tick.
+    std::filesystem::path RecordCapture( uint64_t sessions )
+    {
+        const auto dir = std::filesystem::path( G_REPLAY_DIR ) / std::to_string( sessions );
+        std::filesystem::remove_all( dir );
+        std::filesystem::create_directories( dir );
+        const auto path = dir / "bench.capture";
+
+        auto writer = shm::replay::CaptureWriter::Create( path, {} );
+        if ( !writer.has_value() )
+            return {};
+
+        for ( uint64_t session = 1; session <= sessions; ++session )
+            writer->RecordInbound( 1, { .m_type = shm::net::InboundType::Connected, .m_session = session } );
+        for ( uint64_t tick = 1; tick <= G_CAPTURE_TICKS; ++tick )
+        {
+            const auto payload = shm::wire::EncodeFrame( shm::net::msg::Move{ .x = static_cast< float >( tick ) } );
+            for ( uint64_t session = 1; session <= sessions; ++session )
+                writer->RecordInbound( tick, { .m_type = shm::net::InboundType::Message, .m_session = session, .m_payload = payload } );
+            writer->RecordTick( tick, 1.0f / 120.0f );
+        }
+        std::ignore = writer->Close();
+        return path;
+    }
+
+    /// @brief Replays a capture of state.range( 0 ) sessions through the inbound handler, the world and the journal,
+    /// the offline equivalent of running the broker on recorded traffic.
+    void BM_CaptureReplay( benchmark::State & state )
+    {
+        const auto sessions     = static_cast< uint64_t >( state.range( 0 ) );
+        const auto capture_path = RecordCapture( sessions );
+        const auto journal_dir  = capture_path.parent_path() / "journal";
+
+        uint64_t ticks = 0;
+        for ( auto _ : state )
+        {
+            state.PauseTiming();
+            std::filesystem::remove_all( journal_dir );
+            auto reader  = shm::replay::CaptureReader::Open( capture_path );
+            auto world   = std::make_unique< flecs::world >();
+            auto journal = std::make_unique< shm::journal::WorldJournal >(
+                *world, shm::journal::JournalSettings{ .m_directory = journal_dir, .m_snapshot_interval_ticks = 0 } );
+            wb::InboundHandler inbound( *journal );
+            shm::net::Inbox inbox;
+            if ( !reader.has_value() )
+            {
+                state.SkipWithError( "Capture could not be opened" );
+                break;
+            }
+            journal->Restore( reader->InitialState() );
+            state.ResumeTiming();
+
+            const auto stats = shm::replay::Replay(
+                *reader, inbox,
+                [ & ]( uint64_t tick, float delta_time )
+                {
+                    inbox.ForEach( [ & ]( const shm::net::InboundEvent & event ) { inbound.Handle( event ); } );
+                    inbox.Clear();
+                    world->progress( delta_time );
+                    journal->CommitTick( tick );
+                },
+                []() { return uint64_t{ 0 }; } );
+            journal->Flush();
+            ticks += stats.m_ticks;
+
+            state.PauseTiming();
+            journal.reset();
+            world.reset();
+            state.ResumeTiming();
+        }
+        state.counters[ "ticks_per_second" ] = benchmark::Counter( static_cast< double >( ticks ), benchmark::Counter::kIsRate );
+        state.SetItemsProcessed( static_cast< int64_t >( ticks * sessions ) );
+    }
+} // namespace
+
+BENCHMARK( BM_CaptureReplay )->Arg( 100 )->Arg( 2000 )->Unit( benchmark::kMillisecond );
@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#include "hash/Crc32c.hpp"
+#include "protocol/FrameHeader.hpp"
+#include "simd/Simd.hpp"
+#include "strings/String.hpp"
+#include "strings/Utf8.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// @brief Runs the benchmark with the dispatch capped at state.range( 0 ), skips levels the machine lacks.
+    class LevelScope
+    {
+    public:
+        explicit LevelScope( benchmark::State & state )
+        {
+            const auto level = static_cast< shm::simd::Level >( state.range( 0 ) );
+            if ( level > shm::simd::DetectedLevel() )
+                state.SkipWithError( "Not supported by this CPU" );
+            state.SetLabel( std::string( shm::simd::LevelName( level ) ) );
+            shm::simd::SetMaxLevel( level );
+        }
+
+        ~LevelScope()
+        {
+            shm::simd::SetMaxLevel( shm::simd::Level::Avx2 );
+        }
+    };
+
+    void LevelsAndSizes( benchmark::internal::Benchmark * benchmark )
+    {
+        for ( int level = 0; level <= static_cast< int >( shm::simd::Level::Avx2 ); ++level )
+        {
+            for ( int64_t size : { 64, 1024, 64 * 1024 } )
+                benchmark->Args( { level, size } );
+        }
+    }
+
+    std::vector< std::byte > RandomBytes( std::size_t size )
+    {
+        std::mt19937 rng( 1 );
+        std::vector< std::byte > bytes( size );
+        for ( auto & value : bytes )
+            value = static_cast< std::byte >( rng() );
+        return bytes;
+    }
+
+    /// @brief Chat-like text: mostly ASCII with a share of two, three and four byte sequences.
+    std::string MixedText( std::size_t size )
+    {
+        const std::string_view pieces[]{ "The quick brown fox ", "gr\xC3\xBC\xC3\x9F\x65 ", "\xE2\x82\xAC\x35 ", "\xF0\x9F\x98\x80 ", "jumps over the dog. " };
+        std::mt19937 rng( 2 );
+        std::string text;
+        while ( text.size() < size )
+            text += pieces[ rng() % std::size( pieces ) ];
+        // Cut at a sequence boundary so the text stays valid.
+        while ( text.size() > size || ( text.size() > 0 && ( static_cast< uint8_t >( text.back() ) & 0x80 ) != 0 ) )
+            text.pop_back();
+        return text;
+    }
+
+    void BM_Crc32c( benchmark::State & state )
+    {
+        LevelScope level( state );
+        const auto bytes = RandomBytes( static_cast< std::size_t >( state.range( 1 ) ) );
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( shm::hash::Crc32c( bytes ) );
+        state.SetBytesProcessed( state.iterations() * state.range( 1 ) );
+    }
+
+    void BM_Utf8ValidateAscii( benchmark::State & state )
+    {
+        LevelScope level( state );
+        const std::string text( static_cast< std::size_t >( state.range( 1 ) ), 'a' );
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( shm::str::IsValidUtf8( text ) );
+        state.SetBytesProcessed( state.iterations() * state.range( 1 ) );
+    }
+
+    void BM_Utf8ValidateMixed( benchmark::State & state )
+    {
+        LevelScope level( state );
+        const auto text = MixedText( static_cast< std::size_t >( state.range( 1 ) ) );
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( shm::str::IsValidUtf8( text ) );
+        state.SetBytesProcessed( state.iterations() * static_cast< int64_t >( text.size() ) );
+    }
+
+    /// @brief state.range( 1 ) bytes worth of headers, all of them valid so the whole batch is checked.
+    void BM_FrameHeaderValidate( benchmark::State & state )
+    {
+        LevelScope level( state );
+        const std::vector< shm::protocol::FrameHeader > headers( static_cast< std::size_t >( state.range( 1 ) ) / sizeof( shm::protocol::FrameHeader ),
+                                                                { .m_length = 128, .m_opcode = 12, .m_checksum = 0xC0FFEE } );
+        const shm::protocol::FrameLimits limits{ .m_min_length = 1, .m_max_length = 4096, .m_min_opcode = 1, .m_max_opcode = 512 };
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( shm::protocol::FindInvalidHeader( headers, limits ) );
+        state.SetBytesProcessed( state.iterations() * state.range( 1 ) );
+    }
+
+    void BM_ConvertToWide( benchmark::State & state )
+    {
+        const auto text = MixedText( static_cast< std::size_t >( state.range( 0 ) ) );
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( ed::str::ConvertToWide( text.c_str() ) );
+        state.SetBytesProcessed( state.iterations() * static_cast< int64_t >( text.size() ) );
+    }
+
+    void BM_ConvertWide( benchmark::State & state )
+    {
+        const auto wide = ed::str::ConvertToWide( MixedText( static_cast< std::size_t >( state.range( 0 ) ) ).c_str() );
+        for ( auto _ : state )
+            benchmark::DoNotOptimize( ed::str::ConvertWide( wide.c_str() ) );
+        state.SetBytesProcessed( state.iterations() * static_cast< int64_t >( wide.size() * sizeof( wchar_t ) ) );
+    }
+} // namespace
+
+BENCHMARK( BM_Crc32c )->Apply( LevelsAndSizes );
+BENCHMARK( BM_Utf8ValidateAscii )->Apply( LevelsAndSizes );
+BENCHMARK( BM_Utf8ValidateMixed )->Apply( LevelsAndSizes );
+BENCHMARK( BM_FrameHeaderValidate )->Apply( LevelsAndSizes );
+BENCHMARK( BM_ConvertToWide )->Arg( 64 )->Arg( 64 * 1024 );
+BENCHMARK( BM_ConvertWide )->Arg( 64 )->Arg( 64 * 1024 );
@@ -0,0 +1,139 @@
+#include <benchmark/benchmark.h>
+
+#include "threading/ConcurrentMap.hpp"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace
+{
+    constexpr uint64_t G_ENTRIES = 1'000'000;
+    /// @brief Operations per iteration, keeps the benchmark loop out of the numbers.
+    constexpr int G_OPERATIONS = 64;
+
+    struct SessionEntry
+    {
+        uint64_t m_entity   = 0;
+        uint32_t m_world_id = 0;
+    };
+
+    /// @brief What the concurrent map is measured against: std::unordered_map shards behind a mutex each.
+    class ShardedMutexMap
+    {
+    public:
+        static constexpr std::size_t Shards = 64;
+
+        explicit ShardedMutexMap( std::size_t expected_size )
+        {
+            for ( auto & shard : m_shards )
+                shard.m_map.reserve( expected_size / Shards );
+        }
+
+        [[nodiscard]] std::optional< SessionEntry > Find( uint64_t key )
+        {
+            auto & shard = ShardOf( key );
+            std::scoped_lock lock( shard.m_mutex );
+            const auto iter = shard.m_map.find( key );
+            if ( iter == shard.m_map.end() )
+                return std::nullopt;
+            return iter->second;
+        }
+
+        bool InsertOrAssign( uint64_t key, const SessionEntry & value )
+        {
+            auto & shard = ShardOf( key );
+            std::scoped_lock lock( shard.m_mutex );
+            return shard.m_map.insert_or_assign( key, value ).second;
+        }
+
+        bool Erase( uint64_t key )
+        {
+            auto & shard = ShardOf( key );
+            std::scoped_lock lock( shard.m_mutex );
+            return shard.m_map.erase( key ) != 0;
+        }
+
+    private:
+        struct alignas( 64 ) Shard
+        {
+            std::mutex m_mutex;
+            std::unordered_map< uint64_t, SessionEntry > m_map;
+        };
+
+        Shard & ShardOf( uint64_t key )
+        {
+            return m_shards[ ( key * 0x9e3779b97f4a7c15ULL ) >> 58 ];
+        }
+
+        std::array< Shard, Shards > m_shards;
+    };
+
+    template< typename Map >
+    Map & SessionDirectory()
+    {
+        struct Populated
+        {
+            Populated()
+            {
+                for ( uint64_t session = 0; session < G_ENTRIES; ++session )
+                    m_map.InsertOrAssign( session, { session, 0 } );
+            }
+
+            Map m_map{ G_ENTRIES };
+        };
+
+        static Populated S_DIRECTORY;
+        return S_DIRECTORY.m_map;
+    }
+
+    /// @brief Session lookups from every thread over 1M sessions, state.range( 0 ) percent of the operations are
+    /// lookups. Writes change a session's world or, every other one, reconnect it (erase and insert again), so the
+    /// directory stays at 1M entries.
+    template< typename Map >
+    void RunSessionDirectory( benchmark::State & state )
+    {
+        auto & directory        = SessionDirectory< Map >();
+        const auto read_percent = static_cast< uint64_t >( state.range( 0 ) );
+        uint64_t random         = 0x9e3779b97f4a7c15ULL * static_cast< uint64_t >( state.thread_index() + 1 );
+        uint64_t found          = 0;
+        uint64_t writes         = 0;
+        for ( auto _ : state )
+        {
+            for ( int i = 0; i < G_OPERATIONS; ++i )
+            {
+                random ^= random << 13;
+                random ^= random >> 7;
+                random ^= random << 17;
+
+                const uint64_t session = random % G_ENTRIES;
+                if ( ( random >> 40 ) % 100 < read_percent )
+                {
+                    found += directory.Find( session ).has_value() ? 1 : 0;
+                    continue;
+                }
+
+                if ( ++writes % 2 == 0 )
+                    directory.Erase( session );
+                directory.InsertOrAssign( session, { session, static_cast< uint32_t >( writes ) } );
+            }
+        }
+        benchmark::DoNotOptimize( found );
+        state.SetItemsProcessed( static_cast< int64_t >( state.iterations() ) * G_OPERATIONS );
+    }
+
+    void BM_ConcurrentMap( benchmark::State & state )
+    {
+        RunSessionDirectory< shm::ConcurrentMap< uint64_t, SessionEntry > >( state );
+    }
+
+    void BM_ShardedMutexMap( benchmark::State & state )
+    {
+        RunSessionDirectory< ShardedMutexMap >( state );
+    }
+} // namespace
+
+BENCHMARK( BM_ConcurrentMap )->ArgName( "read_percent" )->Arg( 95 )->Arg( 50 )->ThreadRange( 1, 32 )->UseRealTime();
+BENCHMARK( BM_ShardedMutexMap )->ArgName( "read_percent" )->Arg( 95 )->Arg( 50 )->ThreadRange( 1, 32 )->UseRealTime();
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include "threading/TimingWheel.hpp"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t G_OUTSTANDING_TIMERS = 1'000'000;
+    /// @brief Idle timeout of two minutes at 120 ticks per second.
+    constexpr uint64_t G_TIMEOUT_TICKS = 120 * 120;
+
+    /// @brief 1M session idle timers, state.range( 0 ) of them are pushed back per tick as their sessions send
+    /// something, the wheel is advanced once per tick and expired sessions reconnect with a new timer.
+    void BM_TimingWheelChurn( benchmark::State & state )
+    {
+        const auto reschedules_per_tick = static_cast< std::size_t >( state.range( 0 ) );
+
+        shm::TimingWheel< uint32_t > wheel;
+        std::vector< shm::TimerHandle > handles( G_OUTSTANDING_TIMERS );
+        std::mt19937 random( 42 );
+        for ( uint32_t session = 0; session < G_OUTSTANDING_TIMERS; ++session )
+            handles[ session ] = wheel.Schedule( 1 + random() % G_TIMEOUT_TICKS, session );
+
+        uint64_t tick    = 0;
+        uint64_t expired = 0;
+        for ( auto _ : state )
+        {
+            ++tick;
+            for ( std::size_t i = 0; i < reschedules_per_tick; ++i )
+                wheel.Reschedule( handles[ random() % G_OUTSTANDING_TIMERS ], tick + G_TIMEOUT_TICKS );
+
+            expired += wheel.Advance( tick,
+                                      [ & ]( uint32_t session )
+                                      { handles[ session ] = wheel.Schedule( tick + G_TIMEOUT_TICKS, session ); } );
+        }
+        benchmark::DoNotOptimize( expired );
+        state.counters[ "outstanding" ] = static_cast< double >( wheel.Size() );
+        state.counters[ "expired" ]     = static_cast< double >( expired );
+        state.SetItemsProcessed( static_cast< int64_t >( state.iterations() * reschedules_per_tick ) );
+    }
+
+    /// @brief Schedule and cancel pairs on top of 1M outstanding timers, the cost of short lived timers.
+    void BM_TimingWheelScheduleCancel( benchmark::State & state )
+    {
+        shm::TimingWheel< uint32_t > wheel;
+        std::mt19937 random( 42 );
+        for ( uint32_t session = 0; session < G_OUTSTANDING_TIMERS; ++session )
+            wheel.Schedule( 1 + random() % G_TIMEOUT_TICKS, session );
+
+        for ( auto _ : state )
+        {
+            const auto handle = wheel.Schedule( random() % G_TIMEOUT_TICKS, 0 );
+            benchmark::DoNotOptimize( wheel.Cancel( handle ) );
+        }
+        state.SetItemsProcessed( static_cast< int64_t >( state.iterations() ) );
+    }
+} // namespace
+
+BENCHMARK( BM_TimingWheelChurn )->Arg( 1'000 )->Arg( 50'000 )->Unit( benchmark::kMicrosecond );
+BENCHMARK( BM_TimingWheelScheduleCancel );
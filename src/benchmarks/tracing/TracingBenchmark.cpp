@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include "logging/Logging.hpp"
+#include "tracing/Tracing.hpp"
+
+namespace
+{
+    void BM_SpanDisabled( benchmark::State & state )
+    {
+        shm::trace::SetEnabled( false );
+        for ( auto _ : state )
+        {
+            shm::trace::Span span{ "BenchmarkSpan" };
+            benchmark::ClobberMemory();
+        }
+    }
+
+    void BM_SpanEnabled( benchmark::State & state )
+    {
+        shm::trace::SetEnabled( true );
+        for ( auto _ : state )
+        {
+            shm::trace::Span span{ "BenchmarkSpan" };
+            benchmark::ClobberMemory();
+        }
+        shm::trace::SetEnabled( false );
+    }
+
+    void BM_LogScope( benchmark::State & state )
+    {
+        shm::trace::SetEnabled( state.range( 0 ) != 0 );
+        for ( auto _ : state )
+        {
+            shm::LogScope scope{ "BenchmarkScope" };
+            benchmark::ClobberMemory();
+        }
+        shm::trace::SetEnabled( false );
+    }
+} // namespace
+
+BENCHMARK( BM_SpanDisabled );
+BENCHMARK( BM_SpanEnabled )->ThreadRange( 1, 4 );
+BENCHMARK( BM_LogScope )->ArgName( "tracing" )->Arg( 0 )->Arg( 1 );
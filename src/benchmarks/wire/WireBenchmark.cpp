@@ -0,0 +1,154 @@
+#include <benchmark/benchmark.h>
+
+#include "wire/Codec.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <rfl/json.hpp>
+#include <rfl/msgpack.hpp>
+
+#include <array>
+#include <string>
+
+namespace
+{
+    enum class Stance : uint8_t
+    {
+        Idle,
+        Walking,
+        Running,
+    };
+
+    struct Vec3
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+    };
+
+    /// @brief Typical per entity replication message, the hot path of broadcasting world state.
+    struct EntityState
+    {
+        static constexpr uint16_t Opcode = 1;
+
+        uint64_t id = 0;
+        Vec3 position;
+        Vec3 velocity;
+        std::array< int16_t, 4 > rotation{};
+        Stance stance = Stance::Idle;
+        bool grounded = false;
+        shm::wire::FixedString< 16 > name;
+    };
+
+    struct Sink
+    {
+        uint64_t m_checksum = 0;
+
+        void On( const EntityState & message )
+        {
+            m_checksum += message.id;
+        }
+    };
+
+    EntityState SampleState()
+    {
+        return {
+            .id       = 424242,
+            .position = { 12.5f, -3.0f, 100.25f },
+            .velocity = { 0.5f, 0.0f, -1.5f },
+            .rotation = { 0, 16384, 0, 16384 },
+            .stance   = Stance::Running,
+            .grounded = true,
+            .name     = shm::wire::FixedString< 16 >( "bot-4242" ),
+        };
+    }
+
+    void BM_WireEncode( benchmark::State & state )
+    {
+        auto message = SampleState();
+        for ( auto _ : state )
+        {
+            benchmark::DoNotOptimize( message );
+            auto bytes = shm::wire::Encode( message );
+            benchmark::DoNotOptimize( bytes );
+        }
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * shm::wire::WireSize< EntityState > ) );
+    }
+
+    void BM_WireDecode( benchmark::State & state )
+    {
+        const auto bytes = shm::wire::Encode( SampleState() );
+        for ( auto _ : state )
+        {
+            auto message = shm::wire::Decode< EntityState >( bytes );
+            benchmark::DoNotOptimize( message );
+        }
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * bytes.size() ) );
+    }
+
+    /// @brief Header checks, checksum, opcode lookup and decode, what the broker does per inbound frame.
+    void BM_WireDispatchFrame( benchmark::State & state )
+    {
+        const auto frame = shm::wire::EncodeFrame( SampleState() );
+        Sink sink;
+        for ( auto _ : state )
+        {
+            auto result = shm::wire::Dispatcher< Sink, EntityState >::DispatchFrame( sink, frame );
+            benchmark::DoNotOptimize( result );
+        }
+        benchmark::DoNotOptimize( sink.m_checksum );
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * frame.size() ) );
+    }
+
+    void BM_JsonEncode( benchmark::State & state )
+    {
+        auto message = SampleState();
+        for ( auto _ : state )
+        {
+            benchmark::DoNotOptimize( message );
+            auto text = rfl::json::write( message );
+            benchmark::DoNotOptimize( text );
+        }
+    }
+
+    void BM_JsonDecode( benchmark::State & state )
+    {
+        const auto text = rfl::json::write( SampleState() );
+        for ( auto _ : state )
+        {
+            auto message = rfl::json::read< EntityState >( text );
+            benchmark::DoNotOptimize( message );
+        }
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * text.size() ) );
+    }
+
+    /// @brief The generic binary path, configured like the world journal encodes its entries.
+    void BM_MsgpackEncode( benchmark::State & state )
+    {
+        auto message = SampleState();
+        for ( auto _ : state )
+        {
+            benchmark::DoNotOptimize( message );
+            auto bytes = rfl::msgpack::write< rfl::NoFieldNames, rfl::UnderlyingEnums >( message );
+            benchmark::DoNotOptimize( bytes );
+        }
+    }
+
+    void BM_MsgpackDecode( benchmark::State & state )
+    {
+        const auto bytes = rfl::msgpack::write< rfl::NoFieldNames, rfl::UnderlyingEnums >( SampleState() );
+        for ( auto _ : state )
+        {
+            auto message = rfl::msgpack::read< EntityState, rfl::NoFieldNames, rfl::UnderlyingEnums >( bytes.data(), bytes.size() );
+            benchmark::DoNotOptimize( message );
+        }
+        state.SetBytesProcessed( static_cast< int64_t >( state.iterations() * bytes.size() ) );
+    }
+} // namespace
+
+BENCHMARK( BM_WireEncode );
+BENCHMARK( BM_WireDecode );
+BENCHMARK( BM_WireDispatchFrame );
+BENCHMARK( BM_JsonEncode );
+BENCHMARK( BM_JsonDecode );
+BENCHMARK( BM_MsgpackEncode );
+BENCHMARK( BM_MsgpackDecode );
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include "worlds/WorldCluster.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Wall time each benchmark iteration lets the worlds run for.
+    constexpr auto G_RUN_TIME = 250ms;
+
+    /// @brief Simulation work of one tick that only touches state of its own world, roughly 20us.
+    void SimulateTick( std::vector< float > & positions )
+    {
+        for ( auto & position : positions )
+            position = std::sin( position ) + 1.0f;
+        benchmark::DoNotOptimize( positions.data() );
+    }
+
+    std::vector< shm::worlds::WorldSettings > Worlds( int64_t count, uint32_t tick_rate )
+    {
+        std::vector< shm::worlds::WorldSettings > worlds;
+        for ( int64_t id = 0; id < count; ++id )
+        {
+            worlds.push_back( { .m_id        = static_cast< uint32_t >( id ),
+                                .m_tick_rate = tick_rate,
+                                .m_setup     = []( flecs::world & world )
+                                {
+                                    world.system( "Simulate" ).run( [ positions = std::vector< float >( 4096, 1.0f ) ]( flecs::iter & ) mutable
+                                                                    { SimulateTick( positions ); } );
+                                } } );
+        }
+        return worlds;
+    }
+
+    /// @brief Runs the cluster for G_RUN_TIME while the tick thread polls it, returns the ticks per second of each world.
+    std::vector< double > RunCluster( shm::worlds::WorldCluster & cluster )
+    {
+        std::vector< uint64_t > start_ticks;
+        for ( const auto & host : cluster.Hosts() )
+            start_ticks.push_back( host->Ticks() );
+
+        const auto start = Clock::now();
+        while ( Clock::now() - start < G_RUN_TIME )
+        {
+            cluster.Poll();
+            std::this_thread::sleep_for( 1ms );
+        }
+        const auto seconds = std::chrono::duration< double >( Clock::now() - start ).count();
+
+        std::vector< double > rates;
+        for ( std::size_t i = 0; i < cluster.Hosts().size(); ++i )
+            rates.push_back( static_cast< double >( cluster.Hosts()[ i ]->Ticks() - start_ticks[ i ] ) / seconds );
+        return rates;
+    }
+
+    /// @brief state.range( 0 ) worlds ticking as fast as they can. With a core per world the total rate grows
+    /// linearly with the worlds, each world keeps the rate a single one reaches.
+    void BM_WorldScaling( benchmark::State & state )
+    {
+        shm::worlds::WorldCluster cluster( Worlds( state.range( 0 ), 0 ) );
+        cluster.Start();
+
+        double total   = 0.0;
+        double slowest = std::numeric_limits< double >::max();
+        for ( auto _ : state )
+        {
+            const auto rates = RunCluster( cluster );
+            for ( double rate : rates )
+                total += rate;
+            slowest = std::min( slowest, *std::ranges::min_element( rates ) );
+        }
+        cluster.Stop();
+
+        state.counters[ "ticks_per_second" ]          = total / static_cast< double >( state.iterations() );
+        state.counters[ "slowest_world_ticks_per_s" ] = slowest;
+    }
+
+    /// @brief state.range( 0 ) worlds at 120 Hz, one of them takes 40ms per tick. The others still reach their rate.
+    void BM_SlowWorldIsolation( benchmark::State & state )
+    {
+        auto worlds            = Worlds( state.range( 0 ), 120 );
+        worlds.front().m_setup = []( flecs::world & world )
+        { world.system( "Stall" ).run( []( flecs::iter & ) { std::this_thread::sleep_for( 40ms ); } ); };
+        shm::worlds::WorldCluster cluster( std::move( worlds ) );
+        cluster.Start();
+
+        double slow_rate         = 0.0;
+        double slowest_fast_rate = std::numeric_limits< double >::max();
+        for ( auto _ : state )
+        {
+            const auto rates = RunCluster( cluster );
+            slow_rate        = rates.front();
+            if ( rates.size() > 1 )
+                slowest_fast_rate = std::min( slowest_fast_rate, *std::ranges::min_element( rates.begin() + 1, rates.end() ) );
+        }
+        cluster.Stop();
+
+        state.counters[ "stalled_world_ticks_per_s" ] = slow_rate;
+        if ( state.range( 0 ) > 1 )
+            state.counters[ "other_worlds_min_ticks_per_s" ] = slowest_fast_rate;
+    }
+} // namespace
+
+BENCHMARK( BM_WorldScaling )->RangeMultiplier( 2 )->Range( 1, 8 )->Iterations( 4 )->UseRealTime()->Unit( benchmark::kMillisecond );
+BENCHMARK( BM_SlowWorldIsolation )->Arg( 2 )->Arg( 8 )->Iterations( 4 )->UseRealTime()->Unit( benchmark::kMillisecond );
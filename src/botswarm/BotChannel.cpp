@@ -0,0 +1,44 @@
+#include "BotChannel.hpp"
+
+#include <algorithm>
+
+swarm::BotChannel::BotChannel( uint64_t resend_after_ms )
+    : m_resend_after_ms( resend_after_ms )
+{
+}
+
+bool swarm::BotChannel::Queue( std::span< const std::byte > message, Clock::time_point now )
+{
+    if ( message.size() > MaxMessage || InFlight() >= Window )
+        return false;
+
+    auto & slot     = m_sent[ m_next_sequence % Window ];
+    slot.m_pending  = true;
+    slot.m_attempts = 0;
+    slot.m_size     = static_cast< uint8_t >( message.size() );
+    slot.m_queued   = now;
+    std::copy( message.begin(), message.end(), slot.m_message.begin() );
+    ++m_next_sequence;
+    return true;
+}
+
+void swarm::BotChannel::Reset( uint32_t nonce ) noexcept
+{
+    m_connector          = shm::net::UdpConnector( nonce );
+    m_handshake_attempts = 0;
+    for ( auto & slot : m_sent )
+        slot.m_pending = false;
+    m_next_sequence  = 0;
+    m_oldest_unacked = 0;
+    m_next_expected  = 0;
+    m_ack_due        = false;
+}
+
+std::span< const std::byte > swarm::BotChannel::Build( uint16_t sequence, std::span< const std::byte > message )
+{
+    // Nothing is held back out of order, so there are never ack bits to set.
+    const shm::net::ReliableHeader header{ .m_sequence = sequence, .m_ack = m_next_expected, .m_connection = m_connector.Connection() };
+    std::memcpy( m_datagram.data(), &header, sizeof( header ) );
+    std::memcpy( m_datagram.data() + sizeof( header ), message.data(), message.size() );
+    return std::span( m_datagram ).first( sizeof( header ) + message.size() );
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "net/ReliableChannel.hpp"
+#include "net/UdpHandshake.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+
+namespace swarm
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief The bot's end of a net::ReliableChannel, sized for a hundred thousand bots rather than for the broker:
+    /// a handful of small messages in flight and nothing held back. Messages of the broker that overtook a lost one
+    /// are dropped without an ack, the broker sends them again. Every message remembers when it was queued, its ack
+    /// yields the round trip through the broker's tick. Messages wait until the handshake with the broker named the
+    /// connection, see net::UdpHandshake.
+    class BotChannel
+    {
+    public:
+        static constexpr std::size_t Window     = 8;
+        static constexpr std::size_t MaxMessage = 32;
+        /// @brief Resend timers double up to 2^MaxBackoff times the first one.
+        static constexpr int MaxBackoff = 4;
+
+        explicit BotChannel( uint64_t resend_after_ms = 100 );
+
+        /// @return False if the window is full or the message is larger than MaxMessage.
+        bool Queue( std::span< const std::byte > message, Clock::time_point now );
+
+        /// @brief Emits the datagrams due at the given millisecond: messages never sent, messages whose resend timer
+        /// ran out, or a bare ack if the broker sent something since the last ack. Unlike the broker's channel, every
+        /// resend of a message doubles its timer, so that a swarm outrunning the broker does not bury it in resends.
+        /// Until the broker accepted the connection, only the handshake goes out, again on the same timers.
+        template< typename OnDatagram >
+        void Poll( uint64_t now_ms, OnDatagram && on_datagram )
+        {
+            if ( !Connected() )
+            {
+                if ( m_handshake_attempts != 0 && now_ms < m_handshake_sent_ms + ( m_resend_after_ms << ( m_handshake_attempts - 1 ) ) )
+                    return;
+                m_handshake_attempts = static_cast< uint8_t >( std::min( m_handshake_attempts + 1, MaxBackoff + 1 ) );
+                m_handshake_sent_ms  = now_ms;
+                const auto request   = m_connector.Request();
+                on_datagram( std::span< const std::byte >( request ) );
+                return;
+            }
+
+            bool acked = false;
+            for ( uint16_t sequence = m_oldest_unacked; sequence != m_next_sequence; ++sequence )
+            {
+                auto & slot = m_sent[ sequence % Window ];
+                if ( !slot.m_pending || ( slot.m_attempts != 0 && now_ms < slot.m_sent_ms + ( m_resend_after_ms << ( slot.m_attempts - 1 ) ) ) )
+                    continue;
+                if ( slot.m_attempts != 0 )
+                    ++m_resends;
+                slot.m_attempts = static_cast< uint8_t >( std::min( slot.m_attempts + 1, MaxBackoff + 1 ) );
+                slot.m_sent_ms  = now_ms;
+                on_datagram( Build( sequence, std::span( slot.m_message ).first( slot.m_size ) ) );
+                acked = true;
+            }
+            if ( m_ack_due && !acked )
+                on_datagram( Build( 0, {} ) );
+            m_ack_due = false;
+        }
+
+        /// @param on_acked Called with the queue time of every message the datagram acknowledged.
+        /// @param on_message Called with every message of the broker that arrived in order.
+        /// @return False if the datagram is too short to be one of a ReliableChannel or belongs to another connection.
+        template< typename OnAcked, typename OnMessage >
+        bool Receive( std::span< const std::byte > datagram, OnAcked && on_acked, OnMessage && on_message )
+        {
+            if ( !Connected() )
+            {
+                // The answer to a challenge goes out with the next Poll.
+                if ( !m_connector.Receive( datagram ) )
+                    return false;
+                m_handshake_attempts = 0;
+                return true;
+            }
+
+            shm::net::ReliableHeader header;
+            if ( datagram.size() < sizeof( header ) )
+                return false;
+            std::memcpy( &header, datagram.data(), sizeof( header ) );
+            if ( header.m_connection != m_connector.Connection() )
+                return false;
+            Acknowledge( header, on_acked );
+
+            const auto payload = datagram.subspan( sizeof( header ) );
+            if ( payload.empty() )
+                return true;
+
+            // Duplicates are acknowledged again, their first ack may have been the one that got lost.
+            m_ack_due = true;
+            if ( header.m_sequence != m_next_expected )
+                return true;
+            ++m_next_expected;
+            on_message( payload );
+            return true;
+        }
+
+        /// @brief Messages queued but not acknowledged yet.
+        [[nodiscard]] std::size_t InFlight() const noexcept
+        {
+            return static_cast< uint16_t >( m_next_sequence - m_oldest_unacked );
+        }
+
+        /// @brief Whether the broker accepted the connection.
+        [[nodiscard]] bool Connected() const noexcept
+        {
+            return m_connector.Accepted();
+        }
+
+        /// @brief Whether Poll has something to send right now or once a resend timer runs out.
+        [[nodiscard]] bool Busy() const noexcept
+        {
+            return !Connected() || m_ack_due || InFlight() != 0;
+        }
+
+        [[nodiscard]] uint64_t Resends() const noexcept
+        {
+            return m_resends;
+        }
+
+        /// @brief Starts over for a new session, without the messages still in flight, and starts its handshake.
+        /// @param nonce Of the handshake, should differ from the one of the last session.
+        void Reset( uint32_t nonce ) noexcept;
+
+    private:
+        struct Slot
+        {
+            bool m_pending     = false;
+            /// @brief Times sent, 0 until the first Poll.
+            uint8_t m_attempts = 0;
+            uint8_t m_size     = 0;
+            uint64_t m_sent_ms = 0;
+            Clock::time_point m_queued;
+            std::array< std::byte, MaxMessage > m_message{};
+        };
+
+        template< typename OnAcked >
+        void Acknowledge( const shm::net::ReliableHeader & header, OnAcked && on_acked )
+        {
+            // An ack from before the current window or beyond what was sent is stale.
+            const auto acked = static_cast< uint16_t >( header.m_ack - m_oldest_unacked );
+            if ( acked > InFlight() )
+                return;
+
+            const auto release = [ & ]( uint16_t sequence )
+            {
+                auto & slot = m_sent[ sequence % Window ];
+                if ( std::exchange( slot.m_pending, false ) )
+                    on_acked( slot.m_queued );
+            };
+            for ( uint16_t i = 0; i < acked; ++i )
+                release( static_cast< uint16_t >( m_oldest_unacked + i ) );
+            for ( uint32_t bit = 0; bit < 32; ++bit )
+            {
+                const auto sequence = static_cast< uint16_t >( header.m_ack + 1 + bit );
+                if ( ( header.m_ack_bits & ( 1u << bit ) ) != 0 && static_cast< uint16_t >( sequence - m_oldest_unacked ) < InFlight() )
+                    release( sequence );
+            }
+
+            while ( m_oldest_unacked != m_next_sequence && !m_sent[ m_oldest_unacked % Window ].m_pending )
+                ++m_oldest_unacked;
+        }
+
+        /// @brief Header with the current ack followed by the message, in m_datagram.
+        std::span< const std::byte > Build( uint16_t sequence, std::span< const std::byte > message );
+
+        uint64_t m_resend_after_ms = 0;
+        shm::net::UdpConnector m_connector{ 0 };
+        uint8_t m_handshake_attempts = 0;
+        uint64_t m_handshake_sent_ms = 0;
+        std::array< Slot, Window > m_sent{};
+        uint16_t m_next_sequence  = 0;
+        uint16_t m_oldest_unacked = 0;
+        uint16_t m_next_expected  = 0;
+        bool m_ack_due            = false;
+        uint64_t m_resends        = 0;
+        std::array< std::byte, sizeof( shm::net::ReliableHeader ) + MaxMessage > m_datagram{};
+    };
+} // namespace swarm
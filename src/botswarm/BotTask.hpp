@@ -0,0 +1,81 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace swarm
+{
+    /// @brief The script of one bot as a coroutine. It starts suspended, its shard resumes it whenever what it waits for
+    /// happened and destroys it. A finished script stays suspended until then, so Done() can be asked at any time.
+    class BotTask
+    {
+    public:
+        struct promise_type
+        {
+            BotTask get_return_object() noexcept
+            {
+                return BotTask( std::coroutine_handle< promise_type >::from_promise( *this ) );
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept
+            {
+            }
+
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+        };
+
+        BotTask() = default;
+
+        BotTask( const BotTask & )             = delete;
+        BotTask & operator=( const BotTask & ) = delete;
+
+        BotTask( BotTask && other ) noexcept
+            : m_handle( std::exchange( other.m_handle, nullptr ) )
+        {
+        }
+
+        BotTask & operator=( BotTask && other ) noexcept
+        {
+            std::swap( m_handle, other.m_handle );
+            return *this;
+        }
+
+        ~BotTask()
+        {
+            if ( m_handle )
+                m_handle.destroy();
+        }
+
+        [[nodiscard]] std::coroutine_handle<> Handle() const noexcept
+        {
+            return m_handle;
+        }
+
+        [[nodiscard]] bool Done() const noexcept
+        {
+            return !m_handle || m_handle.done();
+        }
+
+    private:
+        explicit BotTask( std::coroutine_handle< promise_type > handle ) noexcept
+            : m_handle( handle )
+        {
+        }
+
+        std::coroutine_handle< promise_type > m_handle;
+    };
+} // namespace swarm
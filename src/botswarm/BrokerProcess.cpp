@@ -0,0 +1,207 @@
+#include "BrokerProcess.hpp"
+
+#include "BotChannel.hpp"
+
+#include "net/Messages.hpp"
+#include "net/UdpSocket.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+extern char ** environ;
+
+namespace
+{
+    std::unexpected< std::error_code > LastError( int error = errno )
+    {
+        return std::unexpected( std::error_code( error, std::generic_category() ) );
+    }
+
+    /// @return Whether the process exited, with its status.
+    shm::Result< bool > TryReap( pid_t pid, int & status )
+    {
+        while ( true )
+        {
+            const pid_t reaped = ::waitpid( pid, &status, WNOHANG );
+            if ( reaped >= 0 )
+                return reaped == pid;
+            if ( errno != EINTR )
+                return LastError();
+        }
+    }
+
+    /// @brief A port nobody listens on right now. Should another process take it before the broker, the readiness
+    /// probe fails.
+    shm::Result< uint16_t > FreePort()
+    {
+        const auto socket = shm::net::UdpSocket::Bind( {}, false );
+        if ( !socket.has_value() )
+            return std::unexpected( socket.error() );
+        return socket->LocalAddress().m_port;
+    }
+} // namespace
+
+shm::Result< swarm::BrokerProcess > swarm::BrokerProcess::Spawn( const BrokerSettings & settings )
+{
+    std::error_code error;
+    std::filesystem::create_directories( settings.m_work_directory, error );
+    if ( error )
+        return std::unexpected( error );
+
+    const auto port = FreePort();
+    if ( !port.has_value() )
+        return std::unexpected( port.error() );
+
+    const auto in_work_directory = [ & ]( const char * name ) { return ( settings.m_work_directory / name ).string(); };
+    std::vector< std::string > arguments{ settings.m_executable.string(),
+                                          "--udp-port",
+                                          std::to_string( *port ),
+                                          "--udp-max-peers",
+                                          std::to_string( settings.m_max_peers ),
+                                          "--udp-io-threads",
+                                          std::to_string( settings.m_io_threads ),
+                                          "--worlds",
+                                          std::to_string( settings.m_worlds ),
+                                          "--config-dir",
+                                          in_work_directory( "configs" ),
+                                          "--journal-dir",
+                                          in_work_directory( "journal" ),
+                                          "--crash-dir",
+                                          in_work_directory( "crashes" ),
+                                          "--metrics-file",
+                                          "" };
+    std::vector< char * > argv;
+    for ( auto & argument : arguments )
+        argv.push_back( argument.data() );
+    argv.push_back( nullptr );
+
+    const auto log = in_work_directory( "broker.log" );
+    posix_spawn_file_actions_t actions;
+    ::posix_spawn_file_actions_init( &actions );
+    ::posix_spawn_file_actions_addopen( &actions, STDOUT_FILENO, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    ::posix_spawn_file_actions_adddup2( &actions, STDOUT_FILENO, STDERR_FILENO );
+    pid_t pid         = -1;
+    const int spawned = ::posix_spawn( &pid, settings.m_executable.c_str(), &actions, nullptr, argv.data(), environ );
+    ::posix_spawn_file_actions_destroy( &actions );
+    if ( spawned != 0 )
+        return LastError( spawned );
+
+    // Stopped again by the destructor should it not come up.
+    BrokerProcess broker( pid, *port, settings.m_stop_timeout );
+    if ( const auto ready = broker.WaitReady( settings.m_ready_timeout ); !ready.has_value() )
+        return std::unexpected( ready.error() );
+    return broker;
+}
+
+swarm::BrokerProcess::BrokerProcess( pid_t pid, uint16_t port, std::chrono::milliseconds stop_timeout ) noexcept
+    : m_pid( pid )
+    , m_port( port )
+    , m_stop_timeout( stop_timeout )
+{
+}
+
+swarm::BrokerProcess::BrokerProcess( BrokerProcess && other ) noexcept
+    : m_pid( std::exchange( other.m_pid, -1 ) )
+    , m_port( std::exchange( other.m_port, 0 ) )
+    , m_stop_timeout( other.m_stop_timeout )
+{
+}
+
+swarm::BrokerProcess & swarm::BrokerProcess::operator=( BrokerProcess && other ) noexcept
+{
+    std::swap( m_pid, other.m_pid );
+    std::swap( m_port, other.m_port );
+    std::swap( m_stop_timeout, other.m_stop_timeout );
+    return *this;
+}
+
+swarm::BrokerProcess::~BrokerProcess()
+{
+    if ( m_pid >= 0 )
+        std::ignore = Stop();
+}
+
+shm::Result< int > swarm::BrokerProcess::Stop()
+{
+    if ( m_pid < 0 )
+        return std::unexpected( std::make_error_code( std::errc::no_such_process ) );
+
+    const pid_t pid = std::exchange( m_pid, -1 );
+    ::kill( pid, SIGTERM );
+    int status          = 0;
+    const auto deadline = Clock::now() + m_stop_timeout;
+    while ( true )
+    {
+        const auto exited = TryReap( pid, status );
+        if ( !exited.has_value() )
+            return std::unexpected( exited.error() );
+        if ( *exited )
+            break;
+        if ( Clock::now() >= deadline )
+        {
+            // A broker stuck on shutdown must not hang the swarm, nor be left running.
+            ::kill( pid, SIGKILL );
+            while ( ::waitpid( pid, &status, 0 ) < 0 && errno == EINTR )
+                continue;
+            return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+    if ( WIFSIGNALED( status ) )
+        return 128 + WTERMSIG( status );
+    return WEXITSTATUS( status );
+}
+
+shm::Result< void > swarm::BrokerProcess::WaitReady( std::chrono::milliseconds timeout )
+{
+    auto socket = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+    if ( !socket.has_value() )
+        return std::unexpected( socket.error() );
+
+    // The probe becomes a peer like any bot and times out on the broker once the swarm is running.
+    BotChannel channel;
+    channel.Queue( shm::wire::EncodeFrame( shm::net::msg::Move{} ), Clock::now() );
+    shm::net::MessageBufferPool buffers;
+    const auto start = Clock::now();
+    bool acked       = false;
+    while ( !acked )
+    {
+        const auto elapsed = std::chrono::duration_cast< std::chrono::milliseconds >( Clock::now() - start );
+        if ( elapsed > timeout )
+            return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+        int status = 0;
+        if ( ::waitpid( m_pid, &status, WNOHANG ) == m_pid )
+        {
+            m_pid = -1;
+            return std::unexpected( std::make_error_code( std::errc::no_such_process ) );
+        }
+
+        channel.Poll( static_cast< uint64_t >( elapsed.count() ),
+                      [ & ]( std::span< const std::byte > datagram ) { socket->Queue( shm::net::UdpAddress::Loopback( m_port ), datagram ); } );
+        if ( socket->QueuedDatagrams() != 0 )
+            std::ignore = socket->Flush( shm::net::UdpSendMode::PerDatagram );
+        if ( !socket->WaitReadable( std::chrono::milliseconds( 50 ) ).value_or( false ) )
+            continue;
+
+        std::array< shm::net::ReceivedDatagram, 8 > datagrams;
+        const auto received = socket->ReceiveBatch( buffers, datagrams );
+        for ( const auto & datagram : std::span( datagrams ).first( received.value_or( 0 ) ) )
+        {
+            if ( const auto * buffer = buffers.Get( datagram.m_buffer ) )
+                channel.Receive( buffer->Bytes(), [ & ]( Clock::time_point ) { acked = true; }, []( std::span< const std::byte > ) {} );
+            buffers.Destroy( datagram.m_buffer );
+        }
+    }
+    return {};
+}
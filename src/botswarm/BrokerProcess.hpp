@@ -0,0 +1,62 @@
+#pragma once
+
+#include "results/Result.hpp"
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace swarm
+{
+    struct BrokerSettings
+    {
+        std::filesystem::path m_executable;
+        /// @brief Holds the broker's configs, journal, crash dumps and its output in broker.log.
+        std::filesystem::path m_work_directory;
+        uint32_t m_max_peers  = 4096;
+        uint32_t m_worlds     = 1;
+        uint32_t m_io_threads = 0;
+        /// @brief How long the broker may take until it acknowledges a first peer.
+        std::chrono::milliseconds m_ready_timeout{ 10'000 };
+        /// @brief How long the broker may take to exit after SIGTERM before it is killed.
+        std::chrono::milliseconds m_stop_timeout{ 10'000 };
+    };
+
+    /// @brief A broker started for the swarm on a free UDP port, stopped like an operator would with SIGTERM.
+    class BrokerProcess
+    {
+    public:
+        /// @brief Starts the broker and waits until it acknowledges a probe over UDP.
+        /// @return timed_out if it did not within the timeout, no_such_process if it exited meanwhile.
+        static shm::Result< BrokerProcess > Spawn( const BrokerSettings & settings );
+
+        BrokerProcess( const BrokerProcess & )             = delete;
+        BrokerProcess & operator=( const BrokerProcess & ) = delete;
+
+        BrokerProcess( BrokerProcess && other ) noexcept;
+        BrokerProcess & operator=( BrokerProcess && other ) noexcept;
+
+        ~BrokerProcess();
+
+        [[nodiscard]] uint16_t Port() const noexcept
+        {
+            return m_port;
+        }
+
+        /// @brief Sends SIGTERM and waits for the broker to exit, a broker still running after the stop timeout is killed.
+        /// @return Its exit code, or 128 plus the signal that killed it. timed_out if it had to be killed.
+        shm::Result< int > Stop();
+
+    private:
+        BrokerProcess( pid_t pid, uint16_t port, std::chrono::milliseconds stop_timeout ) noexcept;
+
+        /// @brief The broker is up once it acknowledges a message of a peer, which takes it a tick.
+        shm::Result< void > WaitReady( std::chrono::milliseconds timeout );
+
+        pid_t m_pid     = -1;
+        uint16_t m_port = 0;
+        std::chrono::milliseconds m_stop_timeout{ 0 };
+    };
+} // namespace swarm
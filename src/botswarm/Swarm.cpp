@@ -0,0 +1,394 @@
+#include "Swarm.hpp"
+
+#include "BotChannel.hpp"
+#include "BotTask.hpp"
+
+#include "net/Messages.hpp"
+#include "net/UniqueFd.hpp"
+#include "threading/TimingWheel.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <coroutine>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using swarm::Clock;
+
+    /// @brief Descriptors left for everything that is not a bot socket.
+    constexpr rlim_t G_SPARE_DESCRIPTORS = 256;
+    /// @brief Addresses of 127.0.0.0/8 past 127.0.0.1 the bots bind to.
+    constexpr uint32_t G_LOOPBACK_ADDRESSES = ( 1u << 24 ) - 3;
+    /// @brief How long a bot logging out waits for its last acks before it goes silent.
+    constexpr uint64_t G_SETTLE_MS = 1000;
+    /// @brief Bots with messages in flight are checked for resends this often.
+    constexpr uint64_t G_RESEND_SWEEP_MS = 10;
+    /// @brief How long a bot waits for the broker to accept its connection before it tries again from a new address.
+    constexpr uint64_t G_HANDSHAKE_TIMEOUT_MS = 2000;
+
+    struct Bot
+    {
+        uint32_t m_index  = 0;
+        uint32_t m_world  = 0;
+        uint32_t m_logins = 0;
+        std::optional< shm::net::UdpSocket > m_socket;
+        swarm::BotChannel m_channel;
+        swarm::BotTask m_task;
+        uint32_t m_retry_after_ms = 0;
+        bool m_rejected           = false;
+        /// @brief Listed for the resend sweep.
+        bool m_sweeping = false;
+    };
+
+    /// @brief What a bot handles of the broker's messages, everything else is ignored.
+    struct BrokerMessages
+    {
+        Bot & m_bot;
+
+        void On( const shm::net::msg::Rejected & rejected )
+        {
+            m_bot.m_rejected       = true;
+            m_bot.m_retry_after_ms = rejected.retry_after_ms;
+        }
+    };
+
+    using BrokerDispatcher = shm::wire::Dispatcher< BrokerMessages, shm::net::msg::Rejected >;
+
+    /// @brief The bots of one thread. Their coroutines wait in a timing wheel counting milliseconds, their sockets
+    /// in one epoll set, and the thread resumes whichever is due.
+    class Shard
+    {
+    public:
+        Shard( const swarm::SwarmSettings & settings, shm::net::UniqueFd epoll, Clock::time_point start, shm::metrics::Histogram & latency )
+            : m_settings( settings )
+            , m_epoll( std::move( epoll ) )
+            , m_start( start )
+            , m_latency( latency )
+        {
+        }
+
+        Shard( const Shard & )             = delete;
+        Shard & operator=( const Shard & ) = delete;
+
+        void Add( uint32_t index )
+        {
+            auto & bot  = *m_bots.emplace_back( std::make_unique< Bot >() );
+            bot.m_index = index;
+            bot.m_world = index % std::max( m_settings.m_worlds, 1u );
+            bot.m_task  = Script( bot );
+            ++m_running;
+        }
+
+        /// @brief Runs until every bot logged out for good.
+        void Run()
+        {
+            for ( const auto & bot : m_bots )
+                bot->m_task.Handle().resume();
+
+            std::array< epoll_event, 256 > events;
+            while ( m_running != 0 )
+            {
+                const int ready = ::epoll_wait( m_epoll.Get(), events.data(), static_cast< int >( events.size() ), 1 );
+                for ( int i = 0; i < ready; ++i )
+                    Receive( *static_cast< Bot * >( events[ static_cast< std::size_t >( i ) ].data.ptr ) );
+
+                m_now_ms = Elapsed();
+                m_timers.Advance( m_now_ms, []( std::coroutine_handle<> bot ) { bot.resume(); } );
+                if ( m_now_ms >= m_next_sweep_ms )
+                {
+                    Sweep();
+                    m_next_sweep_ms = m_now_ms + G_RESEND_SWEEP_MS;
+                }
+            }
+
+            for ( const auto & bot : m_bots )
+                m_report.m_resends += bot->m_channel.Resends();
+        }
+
+        [[nodiscard]] const swarm::SwarmReport & Report() const noexcept
+        {
+            return m_report;
+        }
+
+    private:
+        struct Sleep
+        {
+            Shard & m_shard;
+            uint64_t m_ms;
+
+            [[nodiscard]] bool await_ready() const noexcept
+            {
+                return m_ms == 0;
+            }
+
+            void await_suspend( std::coroutine_handle<> bot )
+            {
+                m_shard.m_timers.Schedule( m_shard.m_now_ms + m_ms, bot );
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        [[nodiscard]] Sleep SleepFor( uint64_t ms ) noexcept
+        {
+            return { *this, ms };
+        }
+
+        [[nodiscard]] uint64_t Elapsed() const noexcept
+        {
+            return static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::milliseconds >( Clock::now() - m_start ).count() );
+        }
+
+        [[nodiscard]] bool Sending() const noexcept
+        {
+            return m_now_ms < static_cast< uint64_t >( m_settings.m_duration.count() );
+        }
+
+        swarm::BotTask Script( Bot & bot )
+        {
+            const auto interval = std::max< uint64_t >( static_cast< uint64_t >( m_settings.m_move_interval.count() ), 1 );
+            const auto session  = static_cast< uint64_t >( m_settings.m_session_length.count() );
+            co_await SleepFor( static_cast< uint64_t >( m_settings.m_ramp_up.count() ) * bot.m_index / std::max( m_settings.m_bots, 1u ) );
+
+            while ( Sending() )
+            {
+                if ( !Connect( bot ) )
+                {
+                    ++m_report.m_failed_bots;
+                    break;
+                }
+                for ( uint64_t waited = 0; !bot.m_channel.Connected() && waited < G_HANDSHAKE_TIMEOUT_MS; waited += G_RESEND_SWEEP_MS )
+                    co_await SleepFor( G_RESEND_SWEEP_MS );
+                if ( !bot.m_channel.Connected() )
+                {
+                    // Refused or swamped, the broker did not answer.
+                    ++m_report.m_handshake_timeouts;
+                    bot.m_socket.reset();
+                    continue;
+                }
+
+                // Entering its world is the first message of a bot, the broker attaches a session for it.
+                ++m_report.m_logins;
+                Send( bot, shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = bot.m_world } ) );
+                const uint64_t logout = session != 0 ? m_now_ms + session : std::numeric_limits< uint64_t >::max();
+                for ( uint64_t sent = 1;; ++sent )
+                {
+                    co_await SleepFor( interval );
+                    if ( !Sending() || bot.m_rejected || m_now_ms >= logout )
+                        break;
+
+                    if ( m_settings.m_transfer_every != 0 && sent % m_settings.m_transfer_every == 0 )
+                    {
+                        bot.m_world = ( bot.m_world + 1 ) % std::max( m_settings.m_worlds, 1u );
+                        if ( Send( bot, shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = bot.m_world } ) ) )
+                            ++m_report.m_transfers;
+                        continue;
+                    }
+
+                    const shm::net::msg::Move move{ .x = static_cast< float >( bot.m_index % 1024 ),
+                                                    .y = static_cast< float >( sent % 256 ),
+                                                    .z = 0.0f };
+                    if ( Send( bot, shm::wire::EncodeFrame( move ) ) )
+                        ++m_report.m_moves;
+                }
+
+                for ( uint64_t waited = 0; bot.m_channel.InFlight() != 0 && !bot.m_rejected && waited < G_SETTLE_MS; waited += G_RESEND_SWEEP_MS )
+                    co_await SleepFor( G_RESEND_SWEEP_MS );
+
+                // There is no logout message, a peer that goes silent times out on the broker.
+                bot.m_socket.reset();
+                if ( !bot.m_rejected )
+                {
+                    ++m_report.m_disconnects;
+                    continue;
+                }
+
+                ++m_report.m_rejections;
+                co_await SleepFor( bot.m_retry_after_ms );
+                bot.m_rejected = false;
+            }
+            --m_running;
+        }
+
+        /// @brief Opens a socket on an address of its own for every login, so every login is a new peer to the broker
+        /// rather than a client restarting on the address of the last one, and starts the handshake.
+        bool Connect( Bot & bot )
+        {
+            const uint64_t login = static_cast< uint64_t >( bot.m_logins++ ) * m_settings.m_bots + bot.m_index;
+            const shm::net::UdpAddress local{ .m_ip = shm::net::UdpAddress::Loopback( 0 ).m_ip + 1 + static_cast< uint32_t >( login % G_LOOPBACK_ADDRESSES ) };
+            auto socket = shm::net::UdpSocket::Bind( local, false );
+            if ( !socket.has_value() )
+                return false;
+
+            epoll_event event{ .events = EPOLLIN, .data = { .ptr = &bot } };
+            if ( ::epoll_ctl( m_epoll.Get(), EPOLL_CTL_ADD, socket->NativeHandle(), &event ) != 0 )
+                return false;
+            bot.m_socket.emplace( std::move( *socket ) );
+            bot.m_channel.Reset( static_cast< uint32_t >( m_random() ) );
+            Transmit( bot );
+            return true;
+        }
+
+        bool Send( Bot & bot, std::span< const std::byte > frame )
+        {
+            if ( !bot.m_channel.Queue( frame, Clock::now() ) )
+            {
+                ++m_report.m_stalled;
+                return false;
+            }
+            Transmit( bot );
+            return true;
+        }
+
+        void Transmit( Bot & bot )
+        {
+            auto & socket = *bot.m_socket;
+            bot.m_channel.Poll( m_now_ms, [ & ]( std::span< const std::byte > datagram ) { socket.Queue( m_settings.m_broker, datagram ); } );
+            if ( socket.QueuedDatagrams() != 0 )
+                std::ignore = socket.Flush( shm::net::UdpSendMode::PerDatagram );
+            if ( bot.m_channel.Busy() && !std::exchange( bot.m_sweeping, true ) )
+                m_in_flight.push_back( &bot );
+        }
+
+        void Receive( Bot & bot )
+        {
+            if ( !bot.m_socket )
+                return;
+
+            std::array< shm::net::ReceivedDatagram, 8 > datagrams;
+            const auto received = bot.m_socket->ReceiveBatch( m_buffers, datagrams );
+            if ( !received.has_value() || *received == 0 )
+                return;
+
+            const auto now        = Clock::now();
+            const auto on_ack     = [ & ]( Clock::time_point queued )
+            {
+                m_latency.Record( now - queued );
+                ++m_report.m_acked;
+            };
+            const auto on_message = [ & ]( std::span< const std::byte > message )
+            {
+                BrokerMessages handler{ bot };
+                std::ignore = BrokerDispatcher::DispatchFrame( handler, message );
+            };
+            for ( const auto & datagram : std::span( datagrams ).first( *received ) )
+            {
+                if ( const auto * buffer = m_buffers.Get( datagram.m_buffer ) )
+                    bot.m_channel.Receive( buffer->Bytes(), on_ack, on_message );
+                m_buffers.Destroy( datagram.m_buffer );
+            }
+            // Acks what the broker sent.
+            Transmit( bot );
+        }
+
+        /// @brief Resends what is overdue, handshakes included, and forgets the bots that have nothing in flight anymore.
+        void Sweep()
+        {
+            std::erase_if( m_in_flight,
+                           [ & ]( Bot * bot )
+                           {
+                               if ( bot->m_socket && bot->m_channel.Busy() )
+                               {
+                                   Transmit( *bot );
+                                   return false;
+                               }
+                               bot->m_sweeping = false;
+                               return true;
+                           } );
+        }
+
+        const swarm::SwarmSettings & m_settings;
+        shm::net::UniqueFd m_epoll;
+        Clock::time_point m_start;
+        shm::metrics::Histogram & m_latency;
+        shm::net::MessageBufferPool m_buffers;
+        shm::TimingWheel< std::coroutine_handle<> > m_timers;
+        std::vector< std::unique_ptr< Bot > > m_bots;
+        std::vector< Bot * > m_in_flight;
+        std::size_t m_running    = 0;
+        uint64_t m_now_ms        = 0;
+        uint64_t m_next_sweep_ms = 0;
+        /// @brief Handshake nonces.
+        std::minstd_rand m_random{ std::random_device{}() };
+        swarm::SwarmReport m_report;
+    };
+
+    /// @brief Every bot holds a socket, the soft limit usually allows a thousand.
+    shm::Result< void > RaiseDescriptorLimit( uint32_t bots )
+    {
+        rlimit limit{};
+        if ( ::getrlimit( RLIMIT_NOFILE, &limit ) != 0 )
+            return std::unexpected( std::error_code( errno, std::generic_category() ) );
+
+        const rlim_t needed = bots + G_SPARE_DESCRIPTORS;
+        if ( limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur >= needed )
+            return {};
+        if ( limit.rlim_max != RLIM_INFINITY && limit.rlim_max < needed )
+            return std::unexpected( std::make_error_code( std::errc::too_many_files_open ) );
+
+        limit.rlim_cur = needed;
+        if ( ::setrlimit( RLIMIT_NOFILE, &limit ) != 0 )
+            return std::unexpected( std::error_code( errno, std::generic_category() ) );
+        return {};
+    }
+
+    void Accumulate( swarm::SwarmReport & total, const swarm::SwarmReport & shard )
+    {
+        total.m_logins += shard.m_logins;
+        total.m_disconnects += shard.m_disconnects;
+        total.m_moves += shard.m_moves;
+        total.m_transfers += shard.m_transfers;
+        total.m_acked += shard.m_acked;
+        total.m_resends += shard.m_resends;
+        total.m_stalled += shard.m_stalled;
+        total.m_rejections += shard.m_rejections;
+        total.m_failed_bots += shard.m_failed_bots;
+        total.m_handshake_timeouts += shard.m_handshake_timeouts;
+    }
+} // namespace
+
+shm::Result< swarm::SwarmReport > swarm::RunSwarm( const SwarmSettings & settings )
+{
+    if ( const auto raised = RaiseDescriptorLimit( settings.m_bots ); !raised.has_value() )
+        return std::unexpected( raised.error() );
+
+    const auto latency = std::make_unique< shm::metrics::Histogram >();
+    const auto start   = Clock::now();
+    const auto threads = std::clamp( settings.m_threads, 1u, std::max( settings.m_bots, 1u ) );
+    std::vector< std::unique_ptr< Shard > > shards;
+    for ( uint32_t i = 0; i < threads; ++i )
+    {
+        shm::net::UniqueFd epoll( ::epoll_create1( EPOLL_CLOEXEC ) );
+        if ( !epoll )
+            return std::unexpected( std::error_code( errno, std::generic_category() ) );
+        shards.push_back( std::make_unique< Shard >( settings, std::move( epoll ), start, *latency ) );
+    }
+    for ( uint32_t bot = 0; bot < settings.m_bots; ++bot )
+        shards[ bot % threads ]->Add( bot );
+
+    {
+        std::vector< std::jthread > runners;
+        for ( const auto & shard : shards )
+            runners.emplace_back( [ &shard ] { shard->Run(); } );
+    }
+
+    SwarmReport report;
+    for ( const auto & shard : shards )
+        Accumulate( report, shard->Report() );
+    report.m_elapsed = Clock::now() - start;
+    report.m_latency = latency->Snapshot();
+    return report;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "metrics/Metrics.hpp"
+#include "net/UdpSocket.hpp"
+#include "results/Result.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace swarm
+{
+    struct SwarmSettings
+    {
+        shm::net::UdpAddress m_broker = shm::net::UdpAddress::Loopback( 0 );
+        uint32_t m_bots               = 1000;
+        /// @brief Threads the bots are spread over, each running its bots' coroutines in turn.
+        uint32_t m_threads = 1;
+        /// @brief Bots send until then, afterwards they wait up to a second for the acks still missing.
+        std::chrono::milliseconds m_duration{ 30'000 };
+        /// @brief Bots log in evenly spread over this time instead of all at once.
+        std::chrono::milliseconds m_ramp_up{ 5'000 };
+        std::chrono::milliseconds m_move_interval{ 100 };
+        /// @brief Every this many messages of a bot is a transfer into the next world instead of a move, 0 never transfers.
+        uint32_t m_transfer_every = 50;
+        /// @brief Worlds the broker hosts, bots start in the world of their index modulo this.
+        uint32_t m_worlds = 1;
+        /// @brief Bots disconnect after this long and log in again as a new peer, 0 keeps one session for the whole run.
+        std::chrono::milliseconds m_session_length{ 0 };
+    };
+
+    struct SwarmReport
+    {
+        uint64_t m_logins      = 0;
+        uint64_t m_disconnects = 0;
+        uint64_t m_moves       = 0;
+        uint64_t m_transfers   = 0;
+        uint64_t m_acked       = 0;
+        uint64_t m_resends     = 0;
+        /// @brief Messages not sent because the bot's window was full of unacknowledged ones.
+        uint64_t m_stalled = 0;
+        /// @brief msg::Rejected received, the bot waits as long as asked and logs in again.
+        uint64_t m_rejections = 0;
+        /// @brief Bots that could not open a socket and gave up.
+        uint64_t m_failed_bots = 0;
+        /// @brief Logins the broker did not accept in time, the bot tries again from a new address.
+        uint64_t m_handshake_timeouts = 0;
+        /// @brief From the start of the run to the last bot logging out, ramp-up and draining included.
+        std::chrono::nanoseconds m_elapsed{ 0 };
+        /// @brief Nanoseconds from queueing a message to its ack, which the broker sends with the tick that received it.
+        shm::metrics::HistogramSnapshot m_latency;
+
+        [[nodiscard]] uint64_t Sent() const noexcept
+        {
+            return m_logins + m_moves + m_transfers;
+        }
+
+        [[nodiscard]] double AcksPerSecond() const noexcept
+        {
+            const double seconds = std::chrono::duration< double >( m_elapsed ).count();
+            return seconds > 0.0 ? static_cast< double >( m_acked ) / seconds : 0.0;
+        }
+    };
+
+    /// @brief Runs a swarm of bots against a broker over UDP and blocks until the last one logged out.
+    /// Every bot is a coroutine following the same script: connect, log in by entering its world, move every
+    /// m_move_interval with a world transfer now and then, disconnect by going silent once its session is over
+    /// and log in again as a new peer. Each bot owns a socket bound to a loopback address of its own, since
+    /// the broker tells peers apart by address.
+    /// @return too_many_files_open if the descriptor limit cannot be raised to a socket per bot.
+    shm::Result< SwarmReport > RunSwarm( const SwarmSettings & settings );
+} // namespace swarm
@@ -0,0 +1,185 @@
+#include "BrokerProcess.hpp"
+#include "Swarm.hpp"
+
+#include <args.hxx>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <string>
+
+namespace
+{
+    /// @brief Exit codes, so that CTest and scripts can tell a slow broker from a broken setup.
+    constexpr int G_EXIT_PASSED       = 0;
+    constexpr int G_EXIT_FAILED       = 1;
+    constexpr int G_EXIT_LIMIT_MISSED = 2;
+
+    double ToMilliseconds( uint64_t nanoseconds )
+    {
+        return static_cast< double >( nanoseconds ) / 1e6;
+    }
+} // namespace
+
+int main( int argc, char ** argv )
+{
+    swarm::SwarmSettings settings;
+    std::optional< swarm::BrokerSettings > broker_settings;
+    std::optional< double > max_p99_ms;
+    std::optional< double > min_acks_per_second;
+    args::ArgumentParser parser( "Shimmer Bot Swarm",
+                                 "Simulates players as coroutines sending over loopback UDP to a broker and reports the latency of their acks." );
+    try
+    {
+        args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+        args::ValueFlag< uint16_t > port( parser, "port", "UDP port of a broker already listening on loopback", { "port" }, args::Options::Single );
+        args::ValueFlag< std::string > spawn_broker( parser, "spawn-broker", "Start the given broker executable on a free port and stop it afterwards",
+                                                     { "spawn-broker" }, args::Options::Single );
+        args::ValueFlag< std::string > work_dir( parser, "work-dir", "Directory of the spawned broker's configs, journal and log",
+                                                 { "work-dir" }, args::Options::Single );
+        args::ValueFlag< uint32_t > broker_io_threads( parser, "broker-io-threads", "UDP I/O threads of the spawned broker",
+                                                       { "broker-io-threads" }, args::Options::Single );
+        args::ValueFlag< uint32_t > bots( parser, "bots", "Number of bots", { "bots" }, args::Options::Single );
+        args::ValueFlag< uint32_t > threads( parser, "threads", "Threads the bots are spread over", { "threads" }, args::Options::Single );
+        args::ValueFlag< uint32_t > duration( parser, "duration", "Seconds the bots send for", { "duration" }, args::Options::Single );
+        args::ValueFlag< uint32_t > ramp_up( parser, "ramp-up", "Seconds over which the bots log in", { "ramp-up" }, args::Options::Single );
+        args::ValueFlag< uint32_t > move_interval( parser, "move-interval", "Milliseconds between two messages of a bot", { "move-interval" },
+                                                   args::Options::Single );
+        args::ValueFlag< uint32_t > transfer_every( parser, "transfer-every", "Every this many messages of a bot is a world transfer (0 = never)",
+                                                    { "transfer-every" }, args::Options::Single );
+        args::ValueFlag< uint32_t > worlds( parser, "worlds", "Worlds the broker hosts", { "worlds" }, args::Options::Single );
+        args::ValueFlag< uint32_t > session_length( parser, "session-length", "Seconds after which a bot disconnects and logs in again (0 = never)",
+                                                    { "session-length" }, args::Options::Single );
+        args::ValueFlag< double > max_p99( parser, "max-p99-ms", "Fail if the 99th percentile of the ack latency is higher",
+                                           { "max-p99-ms" }, args::Options::Single );
+        args::ValueFlag< double > min_throughput( parser, "min-acks-per-second", "Fail if fewer messages per second were acknowledged",
+                                                  { "min-acks-per-second" }, args::Options::Single );
+        parser.ParseCLI( argc, argv );
+
+        if ( bots )
+            settings.m_bots = bots.Get();
+        if ( threads )
+            settings.m_threads = threads.Get();
+        if ( duration )
+            settings.m_duration = std::chrono::seconds( duration.Get() );
+        if ( ramp_up )
+            settings.m_ramp_up = std::chrono::seconds( ramp_up.Get() );
+        if ( move_interval )
+            settings.m_move_interval = std::chrono::milliseconds( move_interval.Get() );
+        if ( transfer_every )
+            settings.m_transfer_every = transfer_every.Get();
+        if ( worlds )
+            settings.m_worlds = worlds.Get();
+        if ( session_length )
+            settings.m_session_length = std::chrono::seconds( session_length.Get() );
+        if ( max_p99 )
+            max_p99_ms = max_p99.Get();
+        if ( min_throughput )
+            min_acks_per_second = min_throughput.Get();
+
+        if ( static_cast< bool >( port ) == static_cast< bool >( spawn_broker ) )
+            throw args::ValidationError( "Either --port or --spawn-broker is needed" );
+        if ( port )
+            settings.m_broker = shm::net::UdpAddress::Loopback( port.Get() );
+        if ( spawn_broker )
+        {
+            // Room for every bot plus the peers of bots that logged out and did not time out yet.
+            broker_settings = swarm::BrokerSettings{ .m_executable     = spawn_broker.Get(),
+                                                     .m_work_directory = work_dir ? work_dir.Get() : "./botswarm",
+                                                     .m_max_peers      = settings.m_bots * 2 + 16,
+                                                     .m_worlds         = settings.m_worlds,
+                                                     .m_io_threads     = broker_io_threads ? broker_io_threads.Get() : 0 };
+        }
+    }
+    catch ( const args::Completion & )
+    {
+        return G_EXIT_PASSED;
+    }
+    catch ( const args::Help & h )
+    {
+        std::print( std::cerr, "{}\n{}", h.what(), parser.Help() );
+        return G_EXIT_PASSED;
+    }
+    catch ( const args::ParseError & e )
+    {
+        std::print( std::cerr, "{}\n{}", e.what(), parser.Help() );
+        return G_EXIT_FAILED;
+    }
+    catch ( const args::ValidationError & e )
+    {
+        std::print( std::cerr, "{}\n{}", e.what(), parser.Help() );
+        return G_EXIT_FAILED;
+    }
+
+    std::optional< swarm::BrokerProcess > broker;
+    if ( broker_settings )
+    {
+        auto spawned = swarm::BrokerProcess::Spawn( *broker_settings );
+        if ( !spawned.has_value() )
+        {
+            std::println( std::cerr, "Failed to start the broker {}: {}, see {}", broker_settings->m_executable.string(), spawned.error().message(),
+                          ( broker_settings->m_work_directory / "broker.log" ).string() );
+            return G_EXIT_FAILED;
+        }
+        broker.emplace( std::move( *spawned ) );
+        settings.m_broker = shm::net::UdpAddress::Loopback( broker->Port() );
+    }
+
+    std::println( "Running {} bots on {} threads against {} for {}s", settings.m_bots, settings.m_threads, settings.m_broker.ToString(),
+                  std::chrono::duration_cast< std::chrono::seconds >( settings.m_duration ).count() );
+    const auto report = swarm::RunSwarm( settings );
+    if ( !report.has_value() )
+    {
+        std::println( std::cerr, "Failed to run the swarm: {}", report.error().message() );
+        return G_EXIT_FAILED;
+    }
+
+    const auto & latency = report->m_latency;
+    const double p50_ms  = ToMilliseconds( latency.ValueAtQuantile( 0.5 ) );
+    const double p90_ms  = ToMilliseconds( latency.ValueAtQuantile( 0.9 ) );
+    const double p99_ms  = ToMilliseconds( latency.ValueAtQuantile( 0.99 ) );
+    const double p999_ms = ToMilliseconds( latency.ValueAtQuantile( 0.999 ) );
+    const double seconds = std::chrono::duration< double >( report->m_elapsed ).count();
+    std::println( "Sent {} messages ({} logins, {} moves, {} transfers), {} acknowledged in {:.1f}s ({:.0f}/s)", report->Sent(), report->m_logins,
+                  report->m_moves, report->m_transfers, report->m_acked, seconds, report->AcksPerSecond() );
+    std::println( "Ack latency p50 {:.2f}ms, p90 {:.2f}ms, p99 {:.2f}ms, p99.9 {:.2f}ms, max {:.2f}ms", p50_ms, p90_ms, p99_ms, p999_ms,
+                  ToMilliseconds( latency.m_max ) );
+    std::println( "{} disconnects, {} rejections, {} handshake timeouts, {} resends, {} stalled sends, {} bots failed to connect",
+                  report->m_disconnects, report->m_rejections, report->m_handshake_timeouts, report->m_resends, report->m_stalled, report->m_failed_bots );
+    std::println( "bots={} sent={} acked={} acks_per_second={:.0f} p50_ms={:.3f} p99_ms={:.3f} p999_ms={:.3f} max_ms={:.3f}", settings.m_bots,
+                  report->Sent(), report->m_acked, report->AcksPerSecond(), p50_ms, p99_ms, p999_ms, ToMilliseconds( latency.m_max ) );
+
+    int exit_code = G_EXIT_PASSED;
+    if ( broker )
+    {
+        const auto status = broker->Stop();
+        if ( !status.has_value() && status.error() == std::errc::timed_out )
+        {
+            std::println( std::cerr, "The broker did not exit within {}ms of SIGTERM and was killed", broker_settings->m_stop_timeout.count() );
+            exit_code = G_EXIT_FAILED;
+        }
+        else if ( !status.has_value() || *status != 0 )
+        {
+            std::println( std::cerr, "The broker did not exit cleanly: {}", status.has_value() ? std::to_string( *status ) : status.error().message() );
+            exit_code = G_EXIT_FAILED;
+        }
+    }
+    if ( report->m_failed_bots != 0 )
+        exit_code = G_EXIT_FAILED;
+    bool limit_missed = false;
+    if ( max_p99_ms && p99_ms > *max_p99_ms )
+    {
+        std::println( std::cerr, "p99 latency {:.2f}ms is above the limit of {:.2f}ms", p99_ms, *max_p99_ms );
+        limit_missed = true;
+    }
+    if ( min_acks_per_second && report->AcksPerSecond() < *min_acks_per_second )
+    {
+        std::println( std::cerr, "{:.0f} acks per second are below the limit of {:.0f}", report->AcksPerSecond(), *min_acks_per_second );
+        limit_missed = true;
+    }
+    if ( exit_code == G_EXIT_PASSED && limit_missed )
+        exit_code = G_EXIT_LIMIT_MISSED;
+    return exit_code;
+}
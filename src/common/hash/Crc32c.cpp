@@ -0,0 +1,161 @@
+#include "Crc32c.hpp"
+
+#include "simd/Simd.hpp"
+
+#include <cstring>
+
+#if SHM_SIMD_X86
+#include <nmmintrin.h>
+#elif defined( __aarch64__ ) && defined( __ARM_FEATURE_CRC32 )
+#include <arm_acle.h>
+#define SHM_CRC32C_ARM 1
+#endif
+
+namespace
+{
+    // The CRC32 instruction has a latency of three cycles but a throughput of one, so long buffers are split
+    // into three streams checksummed interleaved. The stream results are combined by shifting the first
+    // over the length of the next as if followed by that many zero bytes, an operation precomputed per length.
+    constexpr std::size_t LONG_BLOCK  = 8192;
+    constexpr std::size_t SHORT_BLOCK = 256;
+
+    using ZerosTable = std::array< std::array< uint32_t, 256 >, 4 >;
+
+    constexpr uint32_t Gf2MatrixTimes( const std::array< uint32_t, 32 > & matrix, uint32_t vector )
+    {
+        uint32_t sum = 0;
+        for ( std::size_t i = 0; vector != 0; ++i, vector >>= 1 )
+        {
+            if ( vector & 1u )
+                sum ^= matrix[ i ];
+        }
+        return sum;
+    }
+
+    constexpr std::array< uint32_t, 32 > Gf2MatrixSquare( const std::array< uint32_t, 32 > & matrix )
+    {
+        std::array< uint32_t, 32 > square{};
+        for ( std::size_t i = 0; i < 32; ++i )
+            square[ i ] = Gf2MatrixTimes( matrix, matrix[ i ] );
+        return square;
+    }
+
+    /// @brief Operator appending length zero bytes to a CRC register, length has to be a power of two.
+    constexpr ZerosTable MakeZerosTable( std::size_t length )
+    {
+        // Operator for a single zero bit, squared up to eight bits and then once per doubling of the length.
+        std::array< uint32_t, 32 > op{};
+        op[ 0 ] = 0x82F63B78u;
+        for ( std::size_t i = 1; i < 32; ++i )
+            op[ i ] = 1u << ( i - 1 );
+        for ( int i = 0; i < 3; ++i )
+            op = Gf2MatrixSquare( op );
+        for ( ; length > 1; length >>= 1 )
+            op = Gf2MatrixSquare( op );
+
+        ZerosTable table{};
+        for ( uint32_t value = 0; value < 256; ++value )
+        {
+            for ( std::size_t byte = 0; byte < 4; ++byte )
+                table[ byte ][ value ] = Gf2MatrixTimes( op, value << ( 8 * byte ) );
+        }
+        return table;
+    }
+
+    constexpr ZerosTable LONG_ZEROS  = MakeZerosTable( LONG_BLOCK );
+    constexpr ZerosTable SHORT_ZEROS = MakeZerosTable( SHORT_BLOCK );
+
+    [[maybe_unused]] uint32_t Shift( const ZerosTable & zeros, uint32_t crc )
+    {
+        return zeros[ 0 ][ crc & 0xFFu ] ^ zeros[ 1 ][ ( crc >> 8 ) & 0xFFu ] ^ zeros[ 2 ][ ( crc >> 16 ) & 0xFFu ] ^ zeros[ 3 ][ crc >> 24 ];
+    }
+
+    [[maybe_unused]] uint64_t Load64( const std::byte * data )
+    {
+        uint64_t value;
+        std::memcpy( &value, data, sizeof( value ) );
+        return value;
+    }
+
+#if SHM_SIMD_X86 || defined( SHM_CRC32C_ARM )
+#if SHM_SIMD_X86
+    SHM_TARGET_SSE42 inline uint32_t Step8( uint32_t crc, std::byte value )
+    {
+        return _mm_crc32_u8( crc, static_cast< uint8_t >( value ) );
+    }
+
+    SHM_TARGET_SSE42 inline uint32_t Step64( uint32_t crc, const std::byte * data )
+    {
+#if defined( __x86_64__ ) || defined( _M_X64 )
+        return static_cast< uint32_t >( _mm_crc32_u64( crc, Load64( data ) ) );
+#else
+        const uint64_t value = Load64( data );
+        return _mm_crc32_u32( _mm_crc32_u32( crc, static_cast< uint32_t >( value ) ), static_cast< uint32_t >( value >> 32 ) );
+#endif
+    }
+#else
+    inline uint32_t Step8( uint32_t crc, std::byte value )
+    {
+        return __crc32cb( crc, static_cast< uint8_t >( value ) );
+    }
+
+    inline uint32_t Step64( uint32_t crc, const std::byte * data )
+    {
+        return __crc32cd( crc, Load64( data ) );
+    }
+#endif
+
+    template< std::size_t Block >
+    SHM_TARGET_SSE42 inline uint32_t ThreeStreams( uint32_t crc0, const std::byte *& data, std::size_t & length, const ZerosTable & zeros )
+    {
+        while ( length >= Block * 3 )
+        {
+            uint32_t crc1 = 0;
+            uint32_t crc2 = 0;
+            for ( const std::byte * end = data + Block; data < end; data += 8 )
+            {
+                crc0 = Step64( crc0, data );
+                crc1 = Step64( crc1, data + Block );
+                crc2 = Step64( crc2, data + Block * 2 );
+            }
+            crc0 = Shift( zeros, crc0 ) ^ crc1;
+            crc0 = Shift( zeros, crc0 ) ^ crc2;
+            data += Block * 2;
+            length -= Block * 3;
+        }
+        return crc0;
+    }
+
+    SHM_TARGET_SSE42 uint32_t Crc32cHardware( std::span< const std::byte > bytes, uint32_t crc )
+    {
+        const std::byte * data = bytes.data();
+        std::size_t length     = bytes.size();
+
+        crc = ~crc;
+        for ( ; length != 0 && ( reinterpret_cast< uintptr_t >( data ) & 7u ) != 0; ++data, --length )
+            crc = Step8( crc, *data );
+
+        crc = ThreeStreams< LONG_BLOCK >( crc, data, length, LONG_ZEROS );
+        crc = ThreeStreams< SHORT_BLOCK >( crc, data, length, SHORT_ZEROS );
+        for ( ; length >= 8; data += 8, length -= 8 )
+            crc = Step64( crc, data );
+        for ( ; length != 0; ++data, --length )
+            crc = Step8( crc, *data );
+        return ~crc;
+    }
+#endif
+} // namespace
+
+uint32_t shm::hash::detail::Crc32cRuntime( std::span< const std::byte > data, uint32_t crc ) noexcept
+{
+#if SHM_SIMD_X86
+    if ( shm::simd::ActiveLevel() >= shm::simd::Level::Sse42 )
+        return Crc32cHardware( data, crc );
+    return Crc32cScalar( data, crc );
+#elif defined( SHM_CRC32C_ARM )
+    // Only built in when the target guarantees the CRC extension, there is nothing to check at runtime.
+    return Crc32cHardware( data, crc );
+#else
+    return Crc32cScalar( data, crc );
+#endif
+}
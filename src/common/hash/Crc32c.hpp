@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace shm::hash
+{
+    namespace detail
+    {
+        constexpr std::array< uint32_t, 256 > MakeCrc32cTable()
+        {
+            std::array< uint32_t, 256 > table{};
+            for ( uint32_t i = 0; i < 256; ++i )
+            {
+                uint32_t crc = i;
+                for ( int bit = 0; bit < 8; ++bit )
+                    crc = ( crc >> 1 ) ^ ( ( crc & 1u ) ? 0x82F63B78u : 0u );
+                table[ i ] = crc;
+            }
+            return table;
+        }
+
+        inline constexpr std::array< uint32_t, 256 > CRC32C_TABLE = MakeCrc32cTable();
+
+        /// @brief Dispatches to the CRC32 instruction when the CPU has it (SSE4.2, ARMv8 CRC).
+        uint32_t Crc32cRuntime( std::span< const std::byte > data, uint32_t crc ) noexcept;
+    } // namespace detail
+
+    /// @brief Byte-wise table implementation, the fallback of Crc32c and what it evaluates to at compile time.
+    constexpr uint32_t Crc32cScalar( std::span< const std::byte > data, uint32_t crc = 0 ) noexcept
+    {
+        crc = ~crc;
+        for ( std::byte value : data )
+            crc = detail::CRC32C_TABLE[ ( crc ^ static_cast< uint32_t >( value ) ) & 0xFFu ] ^ ( crc >> 8 );
+        return ~crc;
+    }
+
+    /// @brief CRC-32C (Castagnoli), the checksum of journal and snapshot records and of inbound frames.
+    /// @param crc Result of the previous chunk when checksumming in pieces.
+    constexpr uint32_t Crc32c( std::span< const std::byte > data, uint32_t crc = 0 ) noexcept
+    {
+        if consteval
+        {
+            return Crc32cScalar( data, crc );
+        }
+        else
+        {
+            return detail::Crc32cRuntime( data, crc );
+        }
+    }
+} // namespace shm::hash
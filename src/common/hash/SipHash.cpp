@@ -0,0 +1,63 @@
+#include "SipHash.hpp"
+
+#include <bit>
+
+namespace
+{
+    struct SipState
+    {
+        uint64_t m_v0;
+        uint64_t m_v1;
+        uint64_t m_v2;
+        uint64_t m_v3;
+
+        void Round() noexcept
+        {
+            m_v0 += m_v1;
+            m_v1 = std::rotl( m_v1, 13 ) ^ m_v0;
+            m_v0 = std::rotl( m_v0, 32 );
+            m_v2 += m_v3;
+            m_v3 = std::rotl( m_v3, 16 ) ^ m_v2;
+            m_v0 += m_v3;
+            m_v3 = std::rotl( m_v3, 21 ) ^ m_v0;
+            m_v2 += m_v1;
+            m_v1 = std::rotl( m_v1, 17 ) ^ m_v2;
+            m_v2 = std::rotl( m_v2, 32 );
+        }
+
+        void Compress( uint64_t word ) noexcept
+        {
+            m_v3 ^= word;
+            Round();
+            Round();
+            m_v0 ^= word;
+        }
+    };
+
+    uint64_t LoadLittleEndian( std::span< const std::byte > bytes ) noexcept
+    {
+        uint64_t word = 0;
+        for ( std::size_t i = 0; i < bytes.size(); ++i )
+            word |= static_cast< uint64_t >( bytes[ i ] ) << ( 8 * i );
+        return word;
+    }
+} // namespace
+
+uint64_t shm::hash::SipHash24( const SipKey & key, std::span< const std::byte > data ) noexcept
+{
+    SipState state{ .m_v0 = key[ 0 ] ^ 0x736f6d6570736575ull,
+                    .m_v1 = key[ 1 ] ^ 0x646f72616e646f6dull,
+                    .m_v2 = key[ 0 ] ^ 0x6c7967656e657261ull,
+                    .m_v3 = key[ 1 ] ^ 0x7465646279746573ull };
+
+    const auto full_words = data.size() / 8;
+    for ( std::size_t i = 0; i < full_words; ++i )
+        state.Compress( LoadLittleEndian( data.subspan( i * 8, 8 ) ) );
+    // The last word holds the remaining bytes and the length modulo 256 in its top byte.
+    state.Compress( LoadLittleEndian( data.subspan( full_words * 8 ) ) | ( static_cast< uint64_t >( data.size() ) << 56 ) );
+
+    state.m_v2 ^= 0xFF;
+    for ( int i = 0; i < 4; ++i )
+        state.Round();
+    return state.m_v0 ^ state.m_v1 ^ state.m_v2 ^ state.m_v3;
+}
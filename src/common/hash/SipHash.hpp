@@ -0,0 +1,16 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace shm::hash
+{
+    /// @brief Secret of a SipHash, keep it out of reach of whoever sends the hashed data.
+    using SipKey = std::array< uint64_t, 2 >;
+
+    /// @brief SipHash-2-4, a keyed hash for short inputs. Unlike Crc32c its output cannot be predicted without the key,
+    /// so it is what stateless cookies and hash tables fed by peers use.
+    [[nodiscard]] uint64_t SipHash24( const SipKey & key, std::span< const std::byte > data ) noexcept;
+} // namespace shm::hash
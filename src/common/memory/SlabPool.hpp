@@ -0,0 +1,440 @@
+#pragma once
+
+#include "threading/SpinLock.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace shm::mem
+{
+    /// @brief Generation-checked reference to an object living inside a SlabPool.
+    /// A handle outlives the object it points to safely: once the slot is destroyed (or reused)
+    /// the generation no longer matches and lookups return nullptr instead of a recycled object.
+    template< typename T >
+    struct Handle
+    {
+        static constexpr uint32_t InvalidIndex = std::numeric_limits< uint32_t >::max();
+
+        uint32_t m_index      = InvalidIndex;
+        uint32_t m_generation = 0;
+
+        [[nodiscard]] constexpr bool IsValid() const noexcept
+        {
+            return m_index != InvalidIndex;
+        }
+
+        constexpr explicit operator bool() const noexcept
+        {
+            return IsValid();
+        }
+
+        /// @brief Packs index and generation into a single integer, e.g. to use the handle as an id on the wire.
+        [[nodiscard]] constexpr uint64_t Pack() const noexcept
+        {
+            return ( static_cast< uint64_t >( m_generation ) << 32 ) | m_index;
+        }
+
+        [[nodiscard]] static constexpr Handle Unpack( uint64_t packed ) noexcept
+        {
+            return Handle{ static_cast< uint32_t >( packed ), static_cast< uint32_t >( packed >> 32 ) };
+        }
+
+        constexpr bool operator==( const Handle & ) const noexcept = default;
+    };
+
+    struct PoolStats
+    {
+        std::size_t m_live           = 0;
+        std::size_t m_high_water     = 0;
+        std::size_t m_capacity       = 0;
+        std::size_t m_slabs          = 0;
+        uint64_t m_total_allocations = 0;
+        uint64_t m_total_frees       = 0;
+        uint64_t m_stale_accesses    = 0;
+        /// @brief Share of reserved slots that are not holding a live object (0 = fully packed, 1 = empty).
+        double m_fragmentation = 0.0;
+    };
+
+    namespace detail
+    {
+        inline std::atomic< uint64_t > G_NEXT_POOL_ID{ 1 };
+    }
+
+    /// @brief Typed slab allocator with per-thread free-list caches.
+    ///
+    /// Objects are placed in fixed-size slabs of `SlotsPerSlab` slots which are never returned to the OS
+    /// while the pool is alive, so a steady churn of create/destroy keeps the RSS flat at the high-water mark.
+    /// Every slot carries a generation counter: odd generations mark a live slot, even ones a free slot.
+    ///
+    /// Create/Destroy are thread-safe. Each thread keeps a small cache of free slot indices so the shared
+    /// free list (guarded by a mutex) is only touched once per `ThreadCacheSize / 2` operations.
+    /// Get() is lock-free but the pool cannot protect a raw pointer from a concurrent Destroy of the same object,
+    /// ownership of the object itself still has to be single-threaded or externally synchronized.
+    template< typename T, std::size_t SlotsPerSlab = 256, std::size_t MaxSlabs = 16384 >
+    class SlabPool
+    {
+        static_assert( SlotsPerSlab > 0 && ( SlotsPerSlab & ( SlotsPerSlab - 1 ) ) == 0, "SlotsPerSlab has to be a power of two" );
+        static_assert( SlotsPerSlab * MaxSlabs < Handle< T >::InvalidIndex, "Pool capacity does not fit into a 32 bit index" );
+
+    public:
+        using HandleType = Handle< T >;
+
+        static constexpr std::size_t ThreadCacheSize = 64;
+        static constexpr std::size_t MaxCapacity     = SlotsPerSlab * MaxSlabs;
+
+        SlabPool() = default;
+
+        SlabPool( const SlabPool & )             = delete;
+        SlabPool & operator=( const SlabPool & ) = delete;
+        SlabPool( SlabPool && )                  = delete;
+        SlabPool & operator=( SlabPool && )      = delete;
+
+        ~SlabPool()
+        {
+            const auto slab_count = m_slab_count.load( std::memory_order_acquire );
+            for ( std::size_t slab_index = 0; slab_index < slab_count; ++slab_index )
+            {
+                Slot * slab = SlabAt( slab_index );
+                for ( std::size_t i = 0; i < SlotsPerSlab; ++i )
+                {
+                    if ( IsLive( slab[ i ].m_generation.load( std::memory_order_relaxed ) ) )
+                        std::destroy_at( slab[ i ].Object() );
+                }
+                delete[] slab;
+            }
+            for ( auto & chunk : m_slab_chunks )
+                delete chunk.load( std::memory_order_relaxed );
+        }
+
+        /// @brief Constructs a new object in a free slot.
+        /// @return Invalid handle if the pool reached MaxCapacity.
+        template< typename... Args >
+        [[nodiscard]] HandleType Create( Args &&... args )
+        {
+            const uint32_t index = AcquireIndex();
+            if ( index == HandleType::InvalidIndex )
+                return {};
+
+            Slot & slot = SlotAt( index );
+            std::construct_at( slot.Object(), std::forward< Args >( args )... );
+
+            // free (even) -> live (odd)
+            const uint32_t generation = slot.m_generation.load( std::memory_order_relaxed ) + 1;
+            slot.m_generation.store( generation, std::memory_order_release );
+
+            const auto live = m_live.fetch_add( 1, std::memory_order_relaxed ) + 1;
+            auto high_water = m_high_water.load( std::memory_order_relaxed );
+            while ( live > high_water && !m_high_water.compare_exchange_weak( high_water, live, std::memory_order_relaxed ) )
+            {
+            }
+            return HandleType{ index, generation };
+        }
+
+        /// @brief Destroys the object referenced by the handle and recycles its slot.
+        /// @return False if the handle is invalid or stale (object already destroyed).
+        bool Destroy( HandleType handle )
+        {
+            Slot * slot = TryGetSlot( handle );
+            if ( !slot )
+                return false;
+
+            // live (odd) -> free (even). The CAS makes concurrent double-destroys of the same handle safe.
+            uint32_t expected = handle.m_generation;
+            if ( !slot->m_generation.compare_exchange_strong( expected, expected + 1, std::memory_order_acq_rel ) )
+            {
+                m_stale_accesses.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+
+            std::destroy_at( slot->Object() );
+            m_live.fetch_sub( 1, std::memory_order_relaxed );
+            ReleaseIndex( handle.m_index );
+            return true;
+        }
+
+        /// @return Pointer to the object or nullptr when the handle is invalid or stale.
+        [[nodiscard]] T * Get( HandleType handle ) noexcept
+        {
+            Slot * slot = TryGetSlot( handle );
+            if ( !slot || slot->m_generation.load( std::memory_order_acquire ) != handle.m_generation )
+            {
+                if ( handle.IsValid() )
+                    m_stale_accesses.fetch_add( 1, std::memory_order_relaxed );
+                return nullptr;
+            }
+            return slot->Object();
+        }
+
+        [[nodiscard]] const T * Get( HandleType handle ) const noexcept
+        {
+            return const_cast< SlabPool * >( this )->Get( handle );
+        }
+
+        [[nodiscard]] bool IsAlive( HandleType handle ) const noexcept
+        {
+            const Slot * slot = const_cast< SlabPool * >( this )->TryGetSlot( handle );
+            return slot && slot->m_generation.load( std::memory_order_acquire ) == handle.m_generation;
+        }
+
+        /// @brief Calls fn( handle, object ) for each live object. Not safe against concurrent Create/Destroy.
+        template< typename Fn >
+        void ForEach( Fn && fn )
+        {
+            const auto slab_count = m_slab_count.load( std::memory_order_acquire );
+            for ( std::size_t slab_index = 0; slab_index < slab_count; ++slab_index )
+            {
+                Slot * slab = SlabAt( slab_index );
+                for ( std::size_t i = 0; i < SlotsPerSlab; ++i )
+                {
+                    const uint32_t generation = slab[ i ].m_generation.load( std::memory_order_acquire );
+                    if ( IsLive( generation ) )
+                        fn( HandleType{ static_cast< uint32_t >( slab_index * SlotsPerSlab + i ), generation }, *slab[ i ].Object() );
+                }
+            }
+        }
+
+        [[nodiscard]] PoolStats Stats() const
+        {
+            PoolStats stats;
+            stats.m_live              = m_live.load( std::memory_order_relaxed );
+            stats.m_high_water        = m_high_water.load( std::memory_order_relaxed );
+            stats.m_slabs             = m_slab_count.load( std::memory_order_relaxed );
+            stats.m_capacity          = stats.m_slabs * SlotsPerSlab;
+            stats.m_stale_accesses    = m_stale_accesses.load( std::memory_order_relaxed );
+            {
+                // Only m_mutex, it guards the list of caches. Create and Destroy take a cache lock before m_mutex,
+                // so taking the cache locks here would invert that order.
+                std::scoped_lock lock( m_mutex );
+                for ( const auto & cache : m_thread_caches )
+                {
+                    stats.m_total_allocations += cache->m_allocations.load( std::memory_order_relaxed );
+                    stats.m_total_frees += cache->m_frees.load( std::memory_order_relaxed );
+                }
+            }
+            if ( stats.m_capacity > 0 )
+                stats.m_fragmentation = 1.0 - static_cast< double >( stats.m_live ) / static_cast< double >( stats.m_capacity );
+            return stats;
+        }
+
+        [[nodiscard]] std::size_t LiveCount() const noexcept
+        {
+            return m_live.load( std::memory_order_relaxed );
+        }
+
+    private:
+        struct Slot
+        {
+            alignas( T ) std::byte m_storage[ sizeof( T ) ];
+            std::atomic< uint32_t > m_generation{ 0 };
+            uint32_t m_next_free = HandleType::InvalidIndex;
+
+            T * Object() noexcept
+            {
+                return std::launder( reinterpret_cast< T * >( m_storage ) );
+            }
+        };
+
+        struct ThreadCache
+        {
+            mutable shm::SpinLock m_lock;
+            std::size_t m_count = 0;
+            std::array< uint32_t, ThreadCacheSize > m_indices{};
+            // Counted per thread under m_lock rather than with shared counters, Stats() sums them up without the lock.
+            std::atomic< uint64_t > m_allocations{ 0 };
+            std::atomic< uint64_t > m_frees{ 0 };
+        };
+
+        /// @brief Slab pointers are kept in chunks allocated with the first slab they hold, an idle pool stays small.
+        static constexpr std::size_t SlabsPerChunk = 256;
+        using SlabChunk                            = std::array< std::atomic< Slot * >, SlabsPerChunk >;
+
+        static constexpr bool IsLive( uint32_t generation ) noexcept
+        {
+            return ( generation & 1u ) != 0;
+        }
+
+        /// @brief Only for slabs below m_slab_count, their chunk exists.
+        Slot * SlabAt( std::size_t slab_index ) const noexcept
+        {
+            const SlabChunk * chunk = m_slab_chunks[ slab_index / SlabsPerChunk ].load( std::memory_order_acquire );
+            return ( *chunk )[ slab_index % SlabsPerChunk ].load( std::memory_order_acquire );
+        }
+
+        Slot & SlotAt( uint32_t index ) noexcept
+        {
+            return SlabAt( index / SlotsPerSlab )[ index & ( SlotsPerSlab - 1 ) ];
+        }
+
+        Slot * TryGetSlot( HandleType handle ) noexcept
+        {
+            if ( !handle.IsValid() || !IsLive( handle.m_generation ) )
+                return nullptr;
+
+            const std::size_t slab_index = handle.m_index / SlotsPerSlab;
+            if ( slab_index >= m_slab_count.load( std::memory_order_acquire ) )
+                return nullptr;
+
+            return &SlotAt( handle.m_index );
+        }
+
+        /// @brief Finds (or lazily creates) this thread's cache for this pool instance.
+        /// The last used pool is memoized so the common single-pool hot loop skips the lookup entirely.
+        ThreadCache & LocalCache()
+        {
+            struct Entry
+            {
+                uint64_t m_pool_id    = 0;
+                ThreadCache * m_cache = nullptr;
+                /// @brief Expires with the pool, whose caches the entry then points into are gone.
+                std::weak_ptr< const void > m_pool_lifetime;
+            };
+            static thread_local Entry S_LAST;
+            static thread_local std::vector< Entry > S_CACHES;
+
+            // Pool ids are never reused, an entry of a destroyed pool never matches.
+            if ( S_LAST.m_pool_id == m_pool_id )
+                return *S_LAST.m_cache;
+
+            auto iter = std::ranges::find( S_CACHES, m_pool_id, &Entry::m_pool_id );
+            if ( iter == S_CACHES.end() )
+            {
+                // A thread going through many short-lived pools would otherwise collect an entry for each of them.
+                std::erase_if( S_CACHES, []( const Entry & entry ) { return entry.m_pool_lifetime.expired(); } );
+
+                ThreadCache * cache = nullptr;
+                {
+                    std::scoped_lock lock( m_mutex );
+                    cache = m_thread_caches.emplace_back( std::make_unique< ThreadCache >() ).get();
+                }
+                iter = S_CACHES.insert( S_CACHES.end(), Entry{ m_pool_id, cache, m_lifetime } );
+            }
+
+            S_LAST = *iter;
+            return *iter->m_cache;
+        }
+
+        uint32_t AcquireIndex()
+        {
+            ThreadCache & cache = LocalCache();
+            std::scoped_lock cache_lock( cache.m_lock );
+            if ( cache.m_count == 0 )
+                RefillCache( cache );
+
+            if ( cache.m_count == 0 )
+                return HandleType::InvalidIndex;
+
+            // Only this thread writes the counter, a plain store instead of a read-modify-write is enough.
+            cache.m_allocations.store( cache.m_allocations.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+            return cache.m_indices[ --cache.m_count ];
+        }
+
+        void ReleaseIndex( uint32_t index )
+        {
+            ThreadCache & cache = LocalCache();
+            std::scoped_lock cache_lock( cache.m_lock );
+            if ( cache.m_count == ThreadCacheSize )
+                FlushCache( cache, ThreadCacheSize / 2 );
+
+            cache.m_frees.store( cache.m_frees.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+            cache.m_indices[ cache.m_count++ ] = index;
+        }
+
+        /// @brief Moves up to half a cache worth of indices from the shared free list, growing the pool when it is empty.
+        /// Caller holds cache.m_lock.
+        void RefillCache( ThreadCache & cache )
+        {
+            std::scoped_lock lock( m_mutex );
+            if ( m_free_head == HandleType::InvalidIndex && !AllocateSlab() )
+                StealFromOtherCaches( cache );
+
+            while ( cache.m_count < ThreadCacheSize / 2 && m_free_head != HandleType::InvalidIndex )
+            {
+                const uint32_t index               = m_free_head;
+                m_free_head                        = SlotAt( index ).m_next_free;
+                cache.m_indices[ cache.m_count++ ] = index;
+            }
+        }
+
+        /// @brief Caller holds cache.m_lock.
+        void FlushCache( ThreadCache & cache, std::size_t count )
+        {
+            std::scoped_lock lock( m_mutex );
+            for ( std::size_t i = 0; i < count && cache.m_count > 0; ++i )
+            {
+                const uint32_t index        = cache.m_indices[ --cache.m_count ];
+                SlotAt( index ).m_next_free = m_free_head;
+                m_free_head                 = index;
+            }
+        }
+
+        /// @brief Pulls indices parked in other threads' caches (e.g. of threads that exited) back to the shared list.
+        /// Only used once the pool is at MaxCapacity. Caller holds m_mutex and own_cache.m_lock.
+        void StealFromOtherCaches( ThreadCache & own_cache )
+        {
+            for ( auto & other : m_thread_caches )
+            {
+                if ( other.get() == &own_cache || !other->m_lock.try_lock() )
+                    continue;
+
+                while ( other->m_count > 0 )
+                {
+                    const uint32_t index        = other->m_indices[ --other->m_count ];
+                    SlotAt( index ).m_next_free = m_free_head;
+                    m_free_head                 = index;
+                }
+                other->m_lock.unlock();
+            }
+        }
+
+        /// @brief Caller holds m_mutex.
+        bool AllocateSlab()
+        {
+            const auto slab_index = m_slab_count.load( std::memory_order_relaxed );
+            if ( slab_index >= MaxSlabs )
+                return false;
+
+            Slot * slab = new Slot[ SlotsPerSlab ];
+            // Link back to front so that the lowest indices are handed out first.
+            for ( std::size_t i = SlotsPerSlab; i-- > 0; )
+            {
+                slab[ i ].m_next_free = m_free_head;
+                m_free_head           = static_cast< uint32_t >( slab_index * SlotsPerSlab + i );
+            }
+
+            auto & chunk_slot = m_slab_chunks[ slab_index / SlabsPerChunk ];
+            SlabChunk * chunk = chunk_slot.load( std::memory_order_relaxed );
+            if ( !chunk )
+            {
+                chunk = new SlabChunk{};
+                chunk_slot.store( chunk, std::memory_order_release );
+            }
+            ( *chunk )[ slab_index % SlabsPerChunk ].store( slab, std::memory_order_release );
+            m_slab_count.store( slab_index + 1, std::memory_order_release );
+            return true;
+        }
+
+        const uint64_t m_pool_id = detail::G_NEXT_POOL_ID.fetch_add( 1, std::memory_order_relaxed );
+        /// @brief Only observed through the weak pointers of the thread local cache entries, see LocalCache.
+        const std::shared_ptr< const void > m_lifetime = std::make_shared< const char >( 0 );
+
+        std::array< std::atomic< SlabChunk * >, ( MaxSlabs + SlabsPerChunk - 1 ) / SlabsPerChunk > m_slab_chunks{};
+        std::atomic< std::size_t > m_slab_count{ 0 };
+
+        mutable std::mutex m_mutex;
+        uint32_t m_free_head = HandleType::InvalidIndex;
+        std::vector< std::unique_ptr< ThreadCache > > m_thread_caches;
+
+        std::atomic< std::size_t > m_live{ 0 };
+        std::atomic< std::size_t > m_high_water{ 0 };
+        mutable std::atomic< uint64_t > m_stale_accesses{ 0 };
+    };
+} // namespace shm::mem
@@ -0,0 +1,94 @@
+#include "FrameHeader.hpp"
+
+#include "simd/Simd.hpp"
+
+#if SHM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#if SHM_SIMD_X86
+    // A header is four 16 bit lanes: length, opcode and the two halves of the checksum. Lanes are within their
+    // range when clamping them to it changes nothing, the checksum lanes get the full range. Blocks are checked
+    // as a whole, the one holding the first invalid header and the leftovers go through the scalar check.
+    constexpr int64_t PackLanes( uint16_t length, uint16_t opcode, uint32_t checksum )
+    {
+        return static_cast< int64_t >( static_cast< uint64_t >( length ) | ( static_cast< uint64_t >( opcode ) << 16 ) | ( static_cast< uint64_t >( checksum ) << 32 ) );
+    }
+
+    SHM_TARGET_SSE42 std::size_t FindInvalidHeaderSse42( std::span< const shm::protocol::FrameHeader > headers, const shm::protocol::FrameLimits & limits )
+    {
+        const __m128i low  = _mm_set1_epi64x( PackLanes( limits.m_min_length, limits.m_min_opcode, 0 ) );
+        const __m128i high = _mm_set1_epi64x( PackLanes( limits.m_max_length, limits.m_max_opcode, UINT32_MAX ) );
+
+        constexpr std::size_t per_block = 8;
+        const std::size_t count         = headers.size();
+        const auto * data               = reinterpret_cast< const std::byte * >( headers.data() );
+        std::size_t index               = 0;
+        for ( ; index + per_block <= count; index += per_block )
+        {
+            __m128i within = _mm_set1_epi8( -1 );
+            for ( std::size_t i = 0; i < per_block / 2; ++i )
+            {
+                const __m128i value   = _mm_loadu_si128( reinterpret_cast< const __m128i * >( data + ( index + i * 2 ) * sizeof( shm::protocol::FrameHeader ) ) );
+                const __m128i clamped = _mm_min_epu16( _mm_max_epu16( value, low ), high );
+                within                = _mm_and_si128( within, _mm_cmpeq_epi16( clamped, value ) );
+            }
+            if ( _mm_movemask_epi8( within ) != 0xFFFF )
+                break;
+        }
+        return index + shm::protocol::FindInvalidHeaderScalar( headers.subspan( index ), limits );
+    }
+
+    SHM_TARGET_AVX2 std::size_t FindInvalidHeaderAvx2( std::span< const shm::protocol::FrameHeader > headers, const shm::protocol::FrameLimits & limits )
+    {
+        const __m256i low  = _mm256_set1_epi64x( PackLanes( limits.m_min_length, limits.m_min_opcode, 0 ) );
+        const __m256i high = _mm256_set1_epi64x( PackLanes( limits.m_max_length, limits.m_max_opcode, UINT32_MAX ) );
+
+        constexpr std::size_t per_block = 16;
+        const std::size_t count         = headers.size();
+        const auto * data               = reinterpret_cast< const std::byte * >( headers.data() );
+        std::size_t index               = 0;
+        for ( ; index + per_block <= count; index += per_block )
+        {
+            __m256i within = _mm256_set1_epi8( -1 );
+            for ( std::size_t i = 0; i < per_block / 4; ++i )
+            {
+                const __m256i value   = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( data + ( index + i * 4 ) * sizeof( shm::protocol::FrameHeader ) ) );
+                const __m256i clamped = _mm256_min_epu16( _mm256_max_epu16( value, low ), high );
+                within                = _mm256_and_si256( within, _mm256_cmpeq_epi16( clamped, value ) );
+            }
+            if ( _mm256_movemask_epi8( within ) != -1 )
+                break;
+        }
+        return index + shm::protocol::FindInvalidHeaderScalar( headers.subspan( index ), limits );
+    }
+#endif
+} // namespace
+
+std::size_t shm::protocol::FindInvalidHeaderScalar( std::span< const FrameHeader > headers, const FrameLimits & limits ) noexcept
+{
+    for ( std::size_t i = 0; i < headers.size(); ++i )
+    {
+        if ( !IsWithin( headers[ i ], limits ) )
+            return i;
+    }
+    return headers.size();
+}
+
+std::size_t shm::protocol::FindInvalidHeader( std::span< const FrameHeader > headers, const FrameLimits & limits ) noexcept
+{
+#if SHM_SIMD_X86
+    switch ( shm::simd::ActiveLevel() )
+    {
+    case shm::simd::Level::Avx2:
+        return FindInvalidHeaderAvx2( headers, limits );
+    case shm::simd::Level::Sse42:
+        return FindInvalidHeaderSse42( headers, limits );
+    case shm::simd::Level::Scalar:
+        break;
+    }
+#endif
+    return FindInvalidHeaderScalar( headers, limits );
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "hash/Crc32c.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace shm::protocol
+{
+    static_assert( std::endian::native == std::endian::little, "Frame headers are read in place, the wire format is little endian" );
+
+    /// @brief Header in front of every frame a peer sends, followed by m_length payload bytes.
+    struct FrameHeader
+    {
+        uint16_t m_length   = 0;
+        uint16_t m_opcode   = 0;
+        /// @brief CRC-32C of the payload.
+        uint32_t m_checksum = 0;
+    };
+    static_assert( sizeof( FrameHeader ) == 8 );
+
+    /// @brief Inclusive ranges a header has to fall into before its frame is looked at any further.
+    struct FrameLimits
+    {
+        uint16_t m_min_length = 0;
+        uint16_t m_max_length = UINT16_MAX;
+        uint16_t m_min_opcode = 0;
+        uint16_t m_max_opcode = UINT16_MAX;
+    };
+
+    /// @brief Checks the length and opcode of a batch of headers, dispatched to AVX2 or SSE4.2 when available.
+    /// @return Index of the first header out of range, headers.size() if all of them are fine.
+    [[nodiscard]] std::size_t FindInvalidHeader( std::span< const FrameHeader > headers, const FrameLimits & limits ) noexcept;
+
+    /// @brief Header by header implementation, the fallback of FindInvalidHeader.
+    [[nodiscard]] std::size_t FindInvalidHeaderScalar( std::span< const FrameHeader > headers, const FrameLimits & limits ) noexcept;
+
+    [[nodiscard]] inline bool IsWithin( const FrameHeader & header, const FrameLimits & limits ) noexcept
+    {
+        return header.m_length >= limits.m_min_length && header.m_length <= limits.m_max_length && header.m_opcode >= limits.m_min_opcode
+               && header.m_opcode <= limits.m_max_opcode;
+    }
+
+    [[nodiscard]] inline bool ChecksumMatches( const FrameHeader & header, std::span< const std::byte > payload ) noexcept
+    {
+        return payload.size() == header.m_length && shm::hash::Crc32c( payload ) == header.m_checksum;
+    }
+} // namespace shm::protocol
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <expected>
+#include <system_error>
 
 namespace shm
 {
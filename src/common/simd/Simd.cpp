@@ -0,0 +1,104 @@
+#include "Simd.hpp"
+
+#include <atomic>
+
+#if SHM_SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+    std::atomic< shm::simd::Level > G_MAX_LEVEL{ shm::simd::Level::Avx2 };
+
+#if SHM_SIMD_X86
+    void Cpuid( uint32_t leaf, uint32_t subleaf, uint32_t ( &regs )[ 4 ] )
+    {
+#ifdef _MSC_VER
+        int values[ 4 ];
+        __cpuidex( values, static_cast< int >( leaf ), static_cast< int >( subleaf ) );
+        for ( int i = 0; i < 4; ++i )
+            regs[ i ] = static_cast< uint32_t >( values[ i ] );
+#else
+        __cpuid_count( leaf, subleaf, regs[ 0 ], regs[ 1 ], regs[ 2 ], regs[ 3 ] );
+#endif
+    }
+
+    uint64_t ReadXcr0()
+    {
+#ifdef _MSC_VER
+        return _xgetbv( 0 );
+#else
+        uint32_t eax = 0;
+        uint32_t edx = 0;
+        __asm__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+        return ( static_cast< uint64_t >( edx ) << 32 ) | eax;
+#endif
+    }
+
+    shm::simd::Level Detect()
+    {
+        uint32_t regs[ 4 ]{};
+        Cpuid( 0, 0, regs );
+        const uint32_t max_leaf = regs[ 0 ];
+        if ( max_leaf < 1 )
+            return shm::simd::Level::Scalar;
+
+        Cpuid( 1, 0, regs );
+        const bool sse42   = ( regs[ 2 ] & ( 1u << 20 ) ) != 0;
+        const bool ssse3   = ( regs[ 2 ] & ( 1u << 9 ) ) != 0;
+        const bool osxsave = ( regs[ 2 ] & ( 1u << 27 ) ) != 0;
+        const bool avx     = ( regs[ 2 ] & ( 1u << 28 ) ) != 0;
+        if ( !sse42 || !ssse3 )
+            return shm::simd::Level::Scalar;
+
+        // AVX2 also needs the OS to save the upper halves of the ymm registers on context switches.
+        if ( max_leaf < 7 || !osxsave || !avx || ( ReadXcr0() & 0x6 ) != 0x6 )
+            return shm::simd::Level::Sse42;
+
+        Cpuid( 7, 0, regs );
+        const bool avx2 = ( regs[ 1 ] & ( 1u << 5 ) ) != 0;
+        return avx2 ? shm::simd::Level::Avx2 : shm::simd::Level::Sse42;
+    }
+#else
+    shm::simd::Level Detect()
+    {
+        return shm::simd::Level::Scalar;
+    }
+#endif
+} // namespace
+
+shm::simd::Level shm::simd::DetectedLevel() noexcept
+{
+    static const Level S_DETECTED = Detect();
+    return S_DETECTED;
+}
+
+shm::simd::Level shm::simd::ActiveLevel() noexcept
+{
+    const Level cap      = G_MAX_LEVEL.load( std::memory_order_relaxed );
+    const Level detected = DetectedLevel();
+    return cap < detected ? cap : detected;
+}
+
+void shm::simd::SetMaxLevel( Level level ) noexcept
+{
+    G_MAX_LEVEL.store( level, std::memory_order_relaxed );
+}
+
+std::string_view shm::simd::LevelName( Level level ) noexcept
+{
+    switch ( level )
+    {
+    case Level::Scalar:
+        return "scalar";
+    case Level::Sse42:
+        return "sse4.2";
+    case Level::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define SHM_SIMD_X86 1
+#else
+#define SHM_SIMD_X86 0
+#endif
+
+// Kernels for instruction sets above the build baseline are compiled per function and only called after
+// the CPU was checked, so the binary keeps running on machines without them. MSVC needs no attribute for that.
+// Flattened so generic helpers the kernel calls are compiled for the kernel's instruction set, not the baseline.
+#if SHM_SIMD_X86 && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define SHM_TARGET_SSE42 __attribute__( ( target( "sse4.2" ), flatten ) )
+#define SHM_TARGET_AVX2  __attribute__( ( target( "avx2" ), flatten ) )
+#else
+#define SHM_TARGET_SSE42
+#define SHM_TARGET_AVX2
+#endif
+
+namespace shm::simd
+{
+    /// @brief Instruction set levels kernels are dispatched on, ordered so that each includes the ones below.
+    enum class Level : uint8_t
+    {
+        Scalar,
+        Sse42,
+        Avx2,
+    };
+
+    /// @brief Highest level the CPU (and OS, for the AVX state) supports, detected once.
+    [[nodiscard]] Level DetectedLevel() noexcept;
+
+    /// @brief Level kernels run at: the detected level, unless capped lower.
+    [[nodiscard]] Level ActiveLevel() noexcept;
+
+    /// @brief Caps the dispatch to the given level, to compare kernels or to rule one out. Not meant to be
+    /// changed while kernels run on other threads, they may pick either level.
+    void SetMaxLevel( Level level ) noexcept;
+
+    [[nodiscard]] std::string_view LevelName( Level level ) noexcept;
+} // namespace shm::simd
@@ -1,17 +1,240 @@
 
 #include "String.hpp"
 
-//#include <boost/nowide/convert.hpp>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <string_view>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define SHM_STRING_SSE2 1
+#endif
+
+namespace
+{
+    constexpr char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+    constexpr bool WIDE_IS_UTF16             = sizeof( wchar_t ) == 2;
+
+    /// @brief Decodes the sequence starting at index, which is moved past it. Invalid bytes are skipped one at a time.
+    char32_t DecodeUtf8( std::string_view text, std::size_t & index )
+    {
+        const auto lead = static_cast< uint8_t >( text[ index++ ] );
+        if ( lead < 0x80 )
+            return lead;
+
+        std::size_t length = 0;
+        char32_t code      = 0;
+        uint8_t min        = 0x80;
+        uint8_t max        = 0xBF;
+        if ( lead >= 0xC2 && lead <= 0xDF )
+        {
+            length = 1;
+            code   = lead & 0x1Fu;
+        }
+        else if ( lead >= 0xE0 && lead <= 0xEF )
+        {
+            length = 2;
+            code   = lead & 0x0Fu;
+            min    = lead == 0xE0 ? 0xA0 : 0x80;
+            max    = lead == 0xED ? 0x9F : 0xBF;
+        }
+        else if ( lead >= 0xF0 && lead <= 0xF4 )
+        {
+            length = 3;
+            code   = lead & 0x07u;
+            min    = lead == 0xF0 ? 0x90 : 0x80;
+            max    = lead == 0xF4 ? 0x8F : 0xBF;
+        }
+        else
+            return REPLACEMENT_CHARACTER;
+
+        if ( text.size() - index < length )
+            return REPLACEMENT_CHARACTER;
+        for ( std::size_t i = 0; i < length; ++i )
+        {
+            const auto next = static_cast< uint8_t >( text[ index + i ] );
+            if ( next < ( i == 0 ? min : 0x80 ) || next > ( i == 0 ? max : 0xBF ) )
+                return REPLACEMENT_CHARACTER;
+            code = ( code << 6 ) | ( next & 0x3Fu );
+        }
+        index += length;
+        return code;
+    }
+
+    char * EncodeUtf8( char * out, char32_t code )
+    {
+        if ( code < 0x80 )
+            *out++ = static_cast< char >( code );
+        else if ( code < 0x800 )
+        {
+            *out++ = static_cast< char >( 0xC0 | ( code >> 6 ) );
+            *out++ = static_cast< char >( 0x80 | ( code & 0x3F ) );
+        }
+        else if ( code < 0x10000 )
+        {
+            *out++ = static_cast< char >( 0xE0 | ( code >> 12 ) );
+            *out++ = static_cast< char >( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            *out++ = static_cast< char >( 0x80 | ( code & 0x3F ) );
+        }
+        else
+        {
+            *out++ = static_cast< char >( 0xF0 | ( code >> 18 ) );
+            *out++ = static_cast< char >( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+            *out++ = static_cast< char >( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            *out++ = static_cast< char >( 0x80 | ( code & 0x3F ) );
+        }
+        return out;
+    }
+
+    char32_t DecodeWide( std::wstring_view text, std::size_t & index )
+    {
+        const auto unit = static_cast< char32_t >( text[ index++ ] );
+        if constexpr ( WIDE_IS_UTF16 )
+        {
+            if ( unit >= 0xD800 && unit <= 0xDBFF && index < text.size() )
+            {
+                const auto low = static_cast< char32_t >( text[ index ] );
+                if ( low >= 0xDC00 && low <= 0xDFFF )
+                {
+                    ++index;
+                    return 0x10000 + ( ( unit - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                }
+            }
+        }
+        if ( ( unit >= 0xD800 && unit <= 0xDFFF ) || unit > 0x10FFFF )
+            return REPLACEMENT_CHARACTER;
+        return unit;
+    }
+
+    wchar_t * EncodeWide( wchar_t * out, char32_t code )
+    {
+        if ( WIDE_IS_UTF16 && code >= 0x10000 )
+        {
+            *out++ = static_cast< wchar_t >( 0xD800 + ( ( code - 0x10000 ) >> 10 ) );
+            *out++ = static_cast< wchar_t >( 0xDC00 + ( ( code - 0x10000 ) & 0x3FF ) );
+        }
+        else
+            *out++ = static_cast< wchar_t >( code );
+        return out;
+    }
+
+#ifdef SHM_STRING_SSE2
+    // Text is mostly ASCII, runs of it are copied 16 bytes at a time. SSE2 is part of every x86-64 target,
+    // so unlike the validation kernels this needs no dispatch.
+
+    /// @brief Widens ASCII blocks of 16 bytes, stops at the first block holding anything else.
+    std::size_t WidenAscii( std::string_view text, wchar_t * out )
+    {
+        std::size_t index  = 0;
+        const __m128i zero = _mm_setzero_si128();
+        for ( ; index + 16 <= text.size(); index += 16 )
+        {
+            const __m128i bytes = _mm_loadu_si128( reinterpret_cast< const __m128i * >( text.data() + index ) );
+            if ( _mm_movemask_epi8( bytes ) != 0 )
+                break;
+
+            const __m128i low  = _mm_unpacklo_epi8( bytes, zero );
+            const __m128i high = _mm_unpackhi_epi8( bytes, zero );
+            auto * target      = reinterpret_cast< __m128i * >( out + index );
+            if constexpr ( WIDE_IS_UTF16 )
+            {
+                _mm_storeu_si128( target, low );
+                _mm_storeu_si128( target + 1, high );
+            }
+            else
+            {
+                _mm_storeu_si128( target, _mm_unpacklo_epi16( low, zero ) );
+                _mm_storeu_si128( target + 1, _mm_unpackhi_epi16( low, zero ) );
+                _mm_storeu_si128( target + 2, _mm_unpacklo_epi16( high, zero ) );
+                _mm_storeu_si128( target + 3, _mm_unpackhi_epi16( high, zero ) );
+            }
+        }
+        return index;
+    }
+
+    /// @brief Narrows ASCII blocks of 16 code units, stops at the first block holding anything else.
+    std::size_t NarrowAscii( std::wstring_view text, char * out )
+    {
+        std::size_t index       = 0;
+        constexpr int per_load  = 16 / sizeof( wchar_t );
+        const __m128i non_ascii = WIDE_IS_UTF16 ? _mm_set1_epi16( static_cast< short >( 0xFF80 ) ) : _mm_set1_epi32( static_cast< int >( 0xFFFFFF80 ) );
+        for ( ; index + 16 <= text.size(); index += 16 )
+        {
+            __m128i units[ 16 / per_load ];
+            __m128i any = _mm_setzero_si128();
+            for ( int i = 0; i < 16 / per_load; ++i )
+            {
+                units[ i ] = _mm_loadu_si128( reinterpret_cast< const __m128i * >( text.data() + index + i * per_load ) );
+                any        = _mm_or_si128( any, _mm_and_si128( units[ i ], non_ascii ) );
+            }
+            if ( _mm_movemask_epi8( _mm_cmpeq_epi8( any, _mm_setzero_si128() ) ) != 0xFFFF )
+                break;
+
+            __m128i bytes;
+            if constexpr ( WIDE_IS_UTF16 )
+                bytes = _mm_packus_epi16( units[ 0 ], units[ 1 ] );
+            else
+                bytes = _mm_packus_epi16( _mm_packs_epi32( units[ 0 ], units[ 1 ] ), _mm_packs_epi32( units[ 2 ], units[ 3 ] ) );
+            _mm_storeu_si128( reinterpret_cast< __m128i * >( out + index ), bytes );
+        }
+        return index;
+    }
+#else
+    std::size_t WidenAscii( std::string_view, wchar_t * )
+    {
+        return 0;
+    }
+
+    std::size_t NarrowAscii( std::wstring_view, char * )
+    {
+        return 0;
+    }
+#endif
+} // namespace
 
 std::string ed::str::ConvertWide( const wchar_t * wide_string )
 {
-    return {};
-    //return boost::nowide::narrow( wide_string );
+    if ( !wide_string )
+        return {};
+
+    const std::wstring_view text( wide_string );
+    // At most three bytes per UTF-16 unit (a surrogate pair takes four for two), four per UTF-32 unit.
+    std::string result( text.size() * ( WIDE_IS_UTF16 ? 3 : 4 ), '\0' );
+    char * out = result.data();
+
+    std::size_t index = 0;
+    while ( index < text.size() )
+    {
+        const std::size_t ascii = NarrowAscii( text.substr( index ), out );
+        index += ascii;
+        out += ascii;
+        if ( index < text.size() )
+            out = EncodeUtf8( out, DecodeWide( text, index ) );
+    }
+    result.resize( static_cast< std::size_t >( out - result.data() ) );
+    return result;
 }
 
 std::wstring ed::str::ConvertToWide( const char * narrow_string )
 {
-    //return boost::nowide::widen( narrow_string );
-    return {};
-}
+    if ( !narrow_string )
+        return {};
 
+    const std::string_view text( narrow_string );
+    // Never more code units than bytes: a four byte sequence is at most a surrogate pair.
+    std::wstring result( text.size(), L'\0' );
+    wchar_t * out = result.data();
+
+    std::size_t index = 0;
+    while ( index < text.size() )
+    {
+        const std::size_t ascii = WidenAscii( text.substr( index ), out );
+        index += ascii;
+        out += ascii;
+        if ( index < text.size() )
+            out = EncodeWide( out, DecodeUtf8( text, index ) );
+    }
+    result.resize( static_cast< std::size_t >( out - result.data() ) );
+    return result;
+}
@@ -1,10 +1,11 @@
-
 #pragma once
 
 #include <string>
 
 namespace ed::str
 {
+    /// @brief UTF-16 (Windows) or UTF-32 to UTF-8. Unpaired surrogates and values outside Unicode become U+FFFD.
     std::string ConvertWide( const wchar_t * wide_string );
+    /// @brief UTF-8 to UTF-16 (Windows) or UTF-32. Every byte not part of a valid sequence becomes U+FFFD.
     std::wstring ConvertToWide( const char * narrow_string );
 }
@@ -0,0 +1,277 @@
+#include "Utf8.hpp"
+
+#include "simd/Simd.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if SHM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Vectorized validation after Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+    // Every byte is classified together with the byte before it through three 16 entry lookups: the high nibble
+    // of the previous byte, its low nibble and the high nibble of the current byte. Each lookup yields the set of
+    // errors the pair could still be part of, a pair is invalid when all three agree on one. Third and fourth
+    // bytes of a sequence are checked separately from the lead two and three bytes back.
+    constexpr uint8_t TOO_SHORT      = 1 << 0; // 11______ 0_______ or 11______ 11______
+    constexpr uint8_t TOO_LONG       = 1 << 1; // 0_______ 10______
+    constexpr uint8_t OVERLONG_3     = 1 << 2; // 11100000 100_____
+    constexpr uint8_t TOO_LARGE      = 1 << 3; // 11110100 1001____ and above
+    constexpr uint8_t SURROGATE      = 1 << 4; // 11101101 101_____
+    constexpr uint8_t OVERLONG_2     = 1 << 5; // 1100000_ 10______
+    constexpr uint8_t TOO_LARGE_1000 = 1 << 6; // 11110101 1000____ and above
+    constexpr uint8_t OVERLONG_4     = 1 << 6; // 11110000 1000____
+    constexpr uint8_t TWO_CONTS      = 1 << 7; // 10______ 10______
+    constexpr uint8_t CARRY          = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    constexpr std::array< uint8_t, 16 > BYTE_1_HIGH{
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+    };
+
+    constexpr std::array< uint8_t, 16 > BYTE_1_LOW{
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+    };
+
+    constexpr std::array< uint8_t, 16 > BYTE_2_HIGH{
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    };
+
+#if SHM_SIMD_X86
+#if defined( __GNUC__ ) && !defined( __clang__ )
+    // The checker passes vectors around in baseline code as far as the compiler is concerned, it is only ever
+    // inlined into the kernels though, so the ABI the warning is about never applies.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+    /// @brief One implementation for both widths, Ops maps the handful of operations onto SSE or AVX2.
+    /// Only ever inlined into the kernel of its width, so it is compiled for that instruction set.
+    template< typename Ops >
+    struct Utf8Checker
+    {
+        using Vec = typename Ops::Vec;
+
+        Vec m_error           = Ops::Zero();
+        Vec m_prev_input      = Ops::Zero();
+        Vec m_prev_incomplete = Ops::Zero();
+
+        [[gnu::always_inline]] inline void CheckBlock( Vec input )
+        {
+            if ( Ops::IsAscii( input ) )
+            {
+                // A sequence cut short by ASCII, the lookups would catch it as well but are not needed here.
+                m_error = Ops::Or( m_error, m_prev_incomplete );
+                return;
+            }
+
+            const Vec prev1        = Ops::template Prev< 1 >( input, m_prev_input );
+            const Vec special      = Ops::And( Ops::And( Ops::Lookup( BYTE_1_HIGH, Ops::High( prev1 ) ), Ops::Lookup( BYTE_1_LOW, Ops::Low( prev1 ) ) ),
+                                               Ops::Lookup( BYTE_2_HIGH, Ops::High( input ) ) );
+            const Vec is_third     = Ops::SubSat( Ops::template Prev< 2 >( input, m_prev_input ), 0xE0 - 0x80 );
+            const Vec is_fourth    = Ops::SubSat( Ops::template Prev< 3 >( input, m_prev_input ), 0xF0 - 0x80 );
+            const Vec must_be_cont = Ops::And( Ops::Or( is_third, is_fourth ), Ops::Splat( 0x80 ) );
+            m_error                = Ops::Or( m_error, Ops::Xor( must_be_cont, special ) );
+            m_prev_incomplete      = Ops::Incomplete( input );
+            m_prev_input           = input;
+        }
+
+        [[gnu::always_inline]] inline bool Run( std::span< const std::byte > text )
+        {
+            const std::byte * data = text.data();
+            std::size_t length     = text.size();
+            for ( ; length >= Ops::Width; data += Ops::Width, length -= Ops::Width )
+                CheckBlock( Ops::Load( data ) );
+
+            if ( length != 0 )
+            {
+                // Padded with zeros, which are ASCII and so end any sequence still open.
+                alignas( 32 ) std::array< std::byte, Ops::Width > tail{};
+                std::memcpy( tail.data(), data, length );
+                CheckBlock( Ops::Load( tail.data() ) );
+            }
+            return Ops::IsZero( Ops::Or( m_error, m_prev_incomplete ) );
+        }
+    };
+
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic pop
+#endif
+
+    struct Sse42Ops
+    {
+        using Vec                        = __m128i;
+        static constexpr std::size_t Width = 16;
+
+        SHM_TARGET_SSE42 static Vec Zero() { return _mm_setzero_si128(); }
+        SHM_TARGET_SSE42 static Vec Splat( uint8_t value ) { return _mm_set1_epi8( static_cast< char >( value ) ); }
+        SHM_TARGET_SSE42 static Vec Load( const std::byte * data ) { return _mm_loadu_si128( reinterpret_cast< const __m128i * >( data ) ); }
+        SHM_TARGET_SSE42 static Vec And( Vec a, Vec b ) { return _mm_and_si128( a, b ); }
+        SHM_TARGET_SSE42 static Vec Or( Vec a, Vec b ) { return _mm_or_si128( a, b ); }
+        SHM_TARGET_SSE42 static Vec Xor( Vec a, Vec b ) { return _mm_xor_si128( a, b ); }
+        SHM_TARGET_SSE42 static Vec SubSat( Vec a, uint8_t value ) { return _mm_subs_epu8( a, Splat( value ) ); }
+        SHM_TARGET_SSE42 static Vec High( Vec a ) { return _mm_and_si128( _mm_srli_epi16( a, 4 ), Splat( 0x0F ) ); }
+        SHM_TARGET_SSE42 static Vec Low( Vec a ) { return _mm_and_si128( a, Splat( 0x0F ) ); }
+        SHM_TARGET_SSE42 static bool IsAscii( Vec a ) { return _mm_movemask_epi8( a ) == 0; }
+        SHM_TARGET_SSE42 static bool IsZero( Vec a ) { return _mm_testz_si128( a, a ) != 0; }
+
+        SHM_TARGET_SSE42 static Vec Lookup( const std::array< uint8_t, 16 > & table, Vec index )
+        {
+            return _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i * >( table.data() ) ), index );
+        }
+
+        template< int N >
+        SHM_TARGET_SSE42 static Vec Prev( Vec input, Vec prev_input )
+        {
+            return _mm_alignr_epi8( input, prev_input, 16 - N );
+        }
+
+        /// @brief Non-zero where the last three bytes start a sequence that needs more bytes than are left.
+        SHM_TARGET_SSE42 static Vec Incomplete( Vec input )
+        {
+            const Vec max = _mm_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast< char >( 0xF0 - 1 ),
+                                           static_cast< char >( 0xE0 - 1 ), static_cast< char >( 0xC0 - 1 ) );
+            return _mm_subs_epu8( input, max );
+        }
+    };
+
+    struct Avx2Ops
+    {
+        using Vec                        = __m256i;
+        static constexpr std::size_t Width = 32;
+
+        SHM_TARGET_AVX2 static Vec Zero() { return _mm256_setzero_si256(); }
+        SHM_TARGET_AVX2 static Vec Splat( uint8_t value ) { return _mm256_set1_epi8( static_cast< char >( value ) ); }
+        SHM_TARGET_AVX2 static Vec Load( const std::byte * data ) { return _mm256_loadu_si256( reinterpret_cast< const __m256i * >( data ) ); }
+        SHM_TARGET_AVX2 static Vec And( Vec a, Vec b ) { return _mm256_and_si256( a, b ); }
+        SHM_TARGET_AVX2 static Vec Or( Vec a, Vec b ) { return _mm256_or_si256( a, b ); }
+        SHM_TARGET_AVX2 static Vec Xor( Vec a, Vec b ) { return _mm256_xor_si256( a, b ); }
+        SHM_TARGET_AVX2 static Vec SubSat( Vec a, uint8_t value ) { return _mm256_subs_epu8( a, Splat( value ) ); }
+        SHM_TARGET_AVX2 static Vec High( Vec a ) { return _mm256_and_si256( _mm256_srli_epi16( a, 4 ), Splat( 0x0F ) ); }
+        SHM_TARGET_AVX2 static Vec Low( Vec a ) { return _mm256_and_si256( a, Splat( 0x0F ) ); }
+        SHM_TARGET_AVX2 static bool IsAscii( Vec a ) { return _mm256_movemask_epi8( a ) == 0; }
+        SHM_TARGET_AVX2 static bool IsZero( Vec a ) { return _mm256_testz_si256( a, a ) != 0; }
+
+        SHM_TARGET_AVX2 static Vec Lookup( const std::array< uint8_t, 16 > & table, Vec index )
+        {
+            return _mm256_shuffle_epi8( _mm256_broadcastsi128_si256( _mm_loadu_si128( reinterpret_cast< const __m128i * >( table.data() ) ) ), index );
+        }
+
+        template< int N >
+        SHM_TARGET_AVX2 static Vec Prev( Vec input, Vec prev_input )
+        {
+            // alignr works per 128 bit lane, the lane below each one is the high lane of prev_input for the low lane.
+            return _mm256_alignr_epi8( input, _mm256_permute2x128_si256( prev_input, input, 0x21 ), 16 - N );
+        }
+
+        SHM_TARGET_AVX2 static Vec Incomplete( Vec input )
+        {
+            const Vec max = _mm256_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, static_cast< char >( 0xF0 - 1 ), static_cast< char >( 0xE0 - 1 ),
+                                              static_cast< char >( 0xC0 - 1 ) );
+            return _mm256_subs_epu8( input, max );
+        }
+    };
+
+    SHM_TARGET_SSE42 bool IsValidUtf8Sse42( std::span< const std::byte > text )
+    {
+        return Utf8Checker< Sse42Ops >{}.Run( text );
+    }
+
+    SHM_TARGET_AVX2 bool IsValidUtf8Avx2( std::span< const std::byte > text )
+    {
+        return Utf8Checker< Avx2Ops >{}.Run( text );
+    }
+#endif
+} // namespace
+
+bool shm::str::IsValidUtf8Scalar( std::span< const std::byte > text ) noexcept
+{
+    const std::size_t size = text.size();
+    for ( std::size_t i = 0; i < size; )
+    {
+        const auto lead = static_cast< uint8_t >( text[ i ] );
+        if ( lead < 0x80 )
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t length = 0;
+        uint8_t min        = 0x80;
+        uint8_t max        = 0xBF;
+        if ( lead >= 0xC2 && lead <= 0xDF )
+            length = 2;
+        else if ( lead >= 0xE0 && lead <= 0xEF )
+        {
+            length = 3;
+            min    = lead == 0xE0 ? 0xA0 : 0x80;
+            max    = lead == 0xED ? 0x9F : 0xBF;
+        }
+        else if ( lead >= 0xF0 && lead <= 0xF4 )
+        {
+            length = 4;
+            min    = lead == 0xF0 ? 0x90 : 0x80;
+            max    = lead == 0xF4 ? 0x8F : 0xBF;
+        }
+        else
+            return false;
+
+        if ( size - i < length )
+            return false;
+        // Only the first continuation byte has a narrower range, the others are plain 10xxxxxx.
+        const auto second = static_cast< uint8_t >( text[ i + 1 ] );
+        if ( second < min || second > max )
+            return false;
+        for ( std::size_t k = 2; k < length; ++k )
+        {
+            if ( ( static_cast< uint8_t >( text[ i + k ] ) & 0xC0 ) != 0x80 )
+                return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+bool shm::str::IsValidUtf8( std::span< const std::byte > text ) noexcept
+{
+#if SHM_SIMD_X86
+    switch ( shm::simd::ActiveLevel() )
+    {
+    case shm::simd::Level::Avx2:
+        return IsValidUtf8Avx2( text );
+    case shm::simd::Level::Sse42:
+        return IsValidUtf8Sse42( text );
+    case shm::simd::Level::Scalar:
+        break;
+    }
+#endif
+    return IsValidUtf8Scalar( text );
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace shm::str
+{
+    /// @brief Strict UTF-8 validation as in RFC 3629: no overlong forms, no surrogates, nothing above U+10FFFF
+    /// and no sequence cut short at the end. Dispatched to AVX2 or SSE4.2 when available.
+    [[nodiscard]] bool IsValidUtf8( std::span< const std::byte > text ) noexcept;
+
+    [[nodiscard]] inline bool IsValidUtf8( std::string_view text ) noexcept
+    {
+        return IsValidUtf8( std::as_bytes( std::span( text ) ) );
+    }
+
+    /// @brief Byte-wise implementation, the fallback of IsValidUtf8.
+    [[nodiscard]] bool IsValidUtf8Scalar( std::span< const std::byte > text ) noexcept;
+} // namespace shm::str
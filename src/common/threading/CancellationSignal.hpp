@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ed::thread
+{
+    /// @brief One shot stop request shared by a task and whoever may cancel it, see Threading::TaskResult::StopTask.
+    /// Handlers registered before Emit run on the emitting thread, handlers registered afterwards run right away.
+    class CancellationSignal
+    {
+    public:
+        CancellationSignal() = default;
+
+        CancellationSignal( const CancellationSignal & )             = delete;
+        CancellationSignal & operator=( const CancellationSignal & ) = delete;
+
+        [[nodiscard]] bool SignalCalled() const noexcept
+        {
+            return m_called.load( std::memory_order_acquire );
+        }
+
+        /// @return False if the signal was already emitted, handlers only ever run once.
+        bool Emit()
+        {
+            std::vector< std::function< void() > > handlers;
+            {
+                std::scoped_lock lock( m_lock );
+                if ( m_called.exchange( true, std::memory_order_acq_rel ) )
+                    return false;
+                handlers = std::exchange( m_handlers, {} );
+            }
+
+            for ( auto & handler : handlers )
+                handler();
+            return true;
+        }
+
+        void OnCancel( std::function< void() > handler )
+        {
+            {
+                std::scoped_lock lock( m_lock );
+                if ( !m_called.load( std::memory_order_relaxed ) )
+                {
+                    m_handlers.emplace_back( std::move( handler ) );
+                    return;
+                }
+            }
+            handler();
+        }
+
+    private:
+        std::atomic< bool > m_called{ false };
+        std::mutex m_lock;
+        std::vector< std::function< void() > > m_handlers;
+    };
+} // namespace ed::thread
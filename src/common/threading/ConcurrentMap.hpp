@@ -0,0 +1,368 @@
+#pragma once
+
+#include "threading/EpochDomain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+namespace shm
+{
+    /// @brief Hash map for many threads that read far more often than they write, e.g. session lookups from I/O threads.
+    ///
+    /// Open addressing with linear probing over a power of two table. A key claims its slot once and keeps it for the
+    /// lifetime of the table, the slot holds a pointer to an immutable node with the value that writers swap with a
+    /// compare-exchange. Erasing leaves a tombstone behind for the same key to reuse. Readers take no lock and write
+    /// nothing shared but their epoch counter, replaced nodes are freed through an EpochDomain.
+    ///
+    /// Growing does not stop anybody either: the table that filled up links a larger one, every writer passing by
+    /// helps moving slots over, chunk by chunk. A moved slot is frozen, writers continue in the newer table and readers
+    /// look there first. Once every slot moved the newer table replaces the old one, which is retired as well.
+    template< typename Key, typename Value >
+        requires std::unsigned_integral< Key > && std::is_trivially_copyable_v< Value >
+    class ConcurrentMap
+    {
+        struct Node
+        {
+            Value m_value;
+        };
+
+        /// @brief Slot values: a node pointer, or one of the markers below. Nodes are aligned, the low bits are free.
+        static constexpr uintptr_t Unset     = 0;
+        static constexpr uintptr_t Frozen    = 1;
+        static constexpr uintptr_t Tombstone = 2;
+
+        struct Slot
+        {
+            std::atomic< Key > m_key{ EmptyKey };
+            std::atomic< uintptr_t > m_value{ Unset };
+        };
+
+        struct Table
+        {
+            explicit Table( std::size_t capacity )
+                : m_mask( capacity - 1 )
+                , m_slots( std::make_unique< Slot[] >( capacity ) )
+            {
+            }
+
+            [[nodiscard]] std::size_t Capacity() const noexcept
+            {
+                return m_mask + 1;
+            }
+
+            const std::size_t m_mask;
+            const std::unique_ptr< Slot[] > m_slots;
+            std::atomic< Table * > m_next{ nullptr };
+            /// @brief Written by inserts of new keys and by growing, kept off the line readers need.
+            alignas( 64 ) std::atomic< std::size_t > m_claimed{ 0 };
+            std::atomic< std::size_t > m_move_cursor{ 0 };
+            std::atomic< std::size_t > m_moved{ 0 };
+        };
+
+        struct alignas( 64 ) SizeCounter
+        {
+            std::atomic< int64_t > m_value{ 0 };
+        };
+
+    public:
+        /// @brief Reserved to mark free slots, it cannot be stored.
+        static constexpr Key EmptyKey             = std::numeric_limits< Key >::max();
+        static constexpr std::size_t MinCapacity  = 16;
+        /// @brief Slots one helper moves at a time while growing.
+        static constexpr std::size_t MoveChunk    = 1024;
+        static constexpr std::size_t SizeCounters = 16;
+
+        /// @param expected_size Entries the map should hold without growing.
+        explicit ConcurrentMap( std::size_t expected_size = 0 )
+            : m_table( new Table( CapacityFor( expected_size ) ) )
+        {
+        }
+
+        ConcurrentMap( const ConcurrentMap & )             = delete;
+        ConcurrentMap & operator=( const ConcurrentMap & ) = delete;
+
+        /// @brief Nobody may use the map anymore.
+        ~ConcurrentMap()
+        {
+            // A growth left halfway is finished first, then only the newest table holds live nodes.
+            Table * table = m_table.load( std::memory_order_acquire );
+            while ( Table * next = table->m_next.load( std::memory_order_acquire ) )
+            {
+                Move( *table, *next );
+                table = m_table.load( std::memory_order_acquire );
+            }
+
+            for ( std::size_t i = 0; i < table->Capacity(); ++i )
+            {
+                if ( const uintptr_t value = table->m_slots[ i ].m_value.load( std::memory_order_relaxed ) & ~Frozen; IsNode( value ) )
+                    delete AsNode( value );
+            }
+            delete table;
+        }
+
+        [[nodiscard]] std::optional< Value > Find( Key key ) const
+        {
+            const auto guard      = m_epochs.Pin();
+            const uintptr_t value = Lookup( *m_table.load( std::memory_order_acquire ), key, Hash( key ) );
+            if ( !IsNode( value ) )
+                return std::nullopt;
+            return AsNode( value )->m_value;
+        }
+
+        [[nodiscard]] bool Contains( Key key ) const
+        {
+            return Find( key ).has_value();
+        }
+
+        /// @return True if the key was not in the map before.
+        bool InsertOrAssign( Key key, const Value & value )
+        {
+            auto node                = std::make_unique< Node >( value );
+            const uintptr_t previous = Store( key, reinterpret_cast< uintptr_t >( node.get() ) );
+            node.release();
+            return !IsNode( previous );
+        }
+
+        /// @return True if the key was in the map.
+        bool Erase( Key key )
+        {
+            return IsNode( Store( key, Tombstone ) );
+        }
+
+        /// @brief Exact while no writer runs, approximate otherwise.
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            int64_t size = 0;
+            for ( const auto & counter : m_size )
+                size += counter.m_value.load( std::memory_order_relaxed );
+            return static_cast< std::size_t >( std::max< int64_t >( size, 0 ) );
+        }
+
+        /// @brief Slots of the current table, including those a growth in progress still has to move.
+        [[nodiscard]] std::size_t Capacity() const noexcept
+        {
+            const auto guard = m_epochs.Pin();
+            return m_table.load( std::memory_order_acquire )->Capacity();
+        }
+
+    private:
+        [[nodiscard]] static std::size_t CapacityFor( std::size_t size ) noexcept
+        {
+            // Below half full, so the table does not grow again right away.
+            return std::bit_ceil( std::max( MinCapacity, size * 2 ) );
+        }
+
+        [[nodiscard]] static std::size_t MaxClaimed( const Table & table ) noexcept
+        {
+            return table.Capacity() / 4 * 3;
+        }
+
+        [[nodiscard]] static std::size_t Hash( Key key ) noexcept
+        {
+            // splitmix64 finalizer, ids tend to be sequential.
+            auto hash = static_cast< uint64_t >( key );
+            hash      = ( hash ^ ( hash >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+            hash      = ( hash ^ ( hash >> 27 ) ) * 0x94d049bb133111ebULL;
+            return static_cast< std::size_t >( hash ^ ( hash >> 31 ) );
+        }
+
+        [[nodiscard]] static bool IsNode( uintptr_t value ) noexcept
+        {
+            return value > Tombstone;
+        }
+
+        [[nodiscard]] static Node * AsNode( uintptr_t value ) noexcept
+        {
+            return reinterpret_cast< Node * >( value & ~Frozen );
+        }
+
+        [[nodiscard]] static Slot * FindSlot( const Table & table, Key key, std::size_t hash ) noexcept
+        {
+            for ( std::size_t probe = 0, i = hash & table.m_mask; probe <= table.m_mask; ++probe, i = ( i + 1 ) & table.m_mask )
+            {
+                const Key current = table.m_slots[ i ].m_key.load( std::memory_order_acquire );
+                if ( current == key )
+                    return &table.m_slots[ i ];
+                if ( current == EmptyKey )
+                    return nullptr;
+            }
+            return nullptr;
+        }
+
+        /// @return The slot of the key, claimed if need be. Nullptr if the key is new and the table is full or growing.
+        [[nodiscard]] static Slot * ClaimSlot( Table & table, Key key, std::size_t hash ) noexcept
+        {
+            for ( std::size_t probe = 0, i = hash & table.m_mask; probe <= table.m_mask; ++probe, i = ( i + 1 ) & table.m_mask )
+            {
+                Slot & slot = table.m_slots[ i ];
+                Key current = slot.m_key.load( std::memory_order_acquire );
+                if ( current == EmptyKey )
+                {
+                    if ( table.m_next.load( std::memory_order_acquire ) != nullptr || table.m_claimed.load( std::memory_order_relaxed ) >= MaxClaimed( table ) )
+                        return nullptr;
+                    if ( slot.m_key.compare_exchange_strong( current, key, std::memory_order_acq_rel, std::memory_order_acquire ) )
+                    {
+                        table.m_claimed.fetch_add( 1, std::memory_order_relaxed );
+                        return &slot;
+                    }
+                }
+                if ( current == key )
+                    return &slot;
+            }
+            return nullptr;
+        }
+
+        /// @return The newest value of the key: a node, a tombstone or Unset if the key never was in these tables.
+        [[nodiscard]] static uintptr_t Lookup( const Table & table, Key key, std::size_t hash ) noexcept
+        {
+            if ( const Table * next = table.m_next.load( std::memory_order_acquire ) )
+            {
+                if ( const uintptr_t newer = Lookup( *next, key, hash ); newer != Unset )
+                    return newer;
+            }
+
+            const Slot * slot = FindSlot( table, key, hash );
+            return slot == nullptr ? Unset : slot->m_value.load( std::memory_order_acquire ) & ~Frozen;
+        }
+
+        /// @param desired A new node or Tombstone.
+        /// @return The value the key held before.
+        uintptr_t Store( Key key, uintptr_t desired )
+        {
+            const auto guard       = m_epochs.Pin();
+            const std::size_t hash = Hash( key );
+            Table * table          = m_table.load( std::memory_order_acquire );
+            // What a frozen slot of an older table held, the newer table may not have it yet.
+            uintptr_t inherited = Unset;
+            for ( ;; )
+            {
+                const bool claim = desired != Tombstone || IsNode( inherited );
+                Slot * slot      = claim ? ClaimSlot( *table, key, hash ) : FindSlot( *table, key, hash );
+                if ( slot == nullptr )
+                {
+                    if ( !claim && table->m_next.load( std::memory_order_acquire ) == nullptr )
+                        return inherited;
+                    table = &Grow( *table );
+                    continue;
+                }
+
+                uintptr_t current = slot->m_value.load( std::memory_order_acquire );
+                while ( ( current & Frozen ) == 0 && !slot->m_value.compare_exchange_weak( current, desired, std::memory_order_acq_rel, std::memory_order_acquire ) )
+                {
+                }
+
+                if ( ( current & Frozen ) == 0 )
+                {
+                    // An inherited node is retired by the move that finds this slot taken.
+                    if ( IsNode( current ) )
+                        m_epochs.Retire( AsNode( current ) );
+
+                    const uintptr_t previous = current == Unset ? inherited : current;
+                    if ( IsNode( previous ) != IsNode( desired ) )
+                        m_size[ detail::EpochStripe() % SizeCounters ].m_value.fetch_add( IsNode( desired ) ? 1 : -1, std::memory_order_relaxed );
+                    return previous;
+                }
+
+                if ( current != Frozen )
+                    inherited = current & ~Frozen;
+                table = &Grow( *table );
+            }
+        }
+
+        /// @brief Links a larger table to a full one unless that happened already and helps moving the slots over.
+        /// @return The newer table.
+        Table & Grow( Table & table )
+        {
+            Table * next = table.m_next.load( std::memory_order_acquire );
+            if ( next == nullptr )
+            {
+                auto * fresh = new Table( std::max( CapacityFor( Size() ), table.Capacity() ) );
+                if ( table.m_next.compare_exchange_strong( next, fresh, std::memory_order_acq_rel, std::memory_order_acquire ) )
+                    next = fresh;
+                else
+                    delete fresh;
+            }
+            Move( table, *next );
+            return *next;
+        }
+
+        void Move( Table & table, Table & next )
+        {
+            for ( ;; )
+            {
+                const std::size_t begin = table.m_move_cursor.fetch_add( MoveChunk, std::memory_order_relaxed );
+                if ( begin >= table.Capacity() )
+                    return;
+
+                const std::size_t end = std::min( begin + MoveChunk, table.Capacity() );
+                for ( std::size_t i = begin; i < end; ++i )
+                    MoveSlot( table.m_slots[ i ], next );
+
+                if ( table.m_moved.fetch_add( end - begin, std::memory_order_acq_rel ) + ( end - begin ) == table.Capacity() )
+                    Promote();
+            }
+        }
+
+        void MoveSlot( Slot & slot, Table & next )
+        {
+            const uintptr_t value = slot.m_value.fetch_or( Frozen, std::memory_order_acq_rel );
+            if ( !IsNode( value ) )
+                return;
+
+            const Key key          = slot.m_key.load( std::memory_order_relaxed );
+            const std::size_t hash = Hash( key );
+            Table * table          = &next;
+            for ( ;; )
+            {
+                Slot * target = ClaimSlot( *table, key, hash );
+                if ( target == nullptr )
+                {
+                    table = &Grow( *table );
+                    continue;
+                }
+
+                uintptr_t current = Unset;
+                if ( target->m_value.compare_exchange_strong( current, value, std::memory_order_acq_rel, std::memory_order_acquire ) )
+                    return;
+                if ( current != Frozen )
+                {
+                    // A writer got there first, the moved node is stale.
+                    m_epochs.Retire( AsNode( value ) );
+                    return;
+                }
+                table = &Grow( *table );
+            }
+        }
+
+        /// @brief Replaces the current table by its successor for as long as the current one was moved completely.
+        void Promote()
+        {
+            Table * head = m_table.load( std::memory_order_acquire );
+            for ( ;; )
+            {
+                Table * next = head->m_next.load( std::memory_order_acquire );
+                if ( next == nullptr || head->m_moved.load( std::memory_order_acquire ) != head->Capacity() )
+                    return;
+                if ( m_table.compare_exchange_strong( head, next, std::memory_order_acq_rel, std::memory_order_acquire ) )
+                {
+                    m_epochs.Retire( head );
+                    head = next;
+                }
+            }
+        }
+
+        /// @brief Declared first, the tables still retired go last.
+        mutable EpochDomain m_epochs;
+        alignas( 64 ) std::atomic< Table * > m_table;
+        std::array< SizeCounter, SizeCounters > m_size{};
+    };
+} // namespace shm
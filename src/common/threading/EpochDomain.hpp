@@ -0,0 +1,194 @@
+#pragma once
+
+#include "threading/SpinLock.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace shm
+{
+    namespace detail
+    {
+        inline std::atomic< std::size_t > G_NEXT_EPOCH_STRIPE{ 0 };
+
+        /// @brief Threads are spread over the stripes round robin, in the order they first pin.
+        inline std::size_t EpochStripe() noexcept
+        {
+            static thread_local const std::size_t S_STRIPE = G_NEXT_EPOCH_STRIPE.fetch_add( 1, std::memory_order_relaxed );
+            return S_STRIPE;
+        }
+    } // namespace detail
+
+    /// @brief Epoch based reclamation for structures read without locks.
+    /// Readers pin the current epoch while they hold pointers into the structure, writers retire what they unlinked.
+    /// A retired object is freed once the epoch moved on twice, by then every reader that might have seen it unpinned.
+    /// Readers count themselves per epoch parity in one of `Stripes` counters instead of registering per thread, so
+    /// pinning is two atomic increments on a cache line the calling thread rarely shares.
+    class EpochDomain
+    {
+        struct alignas( 64 ) Stripe
+        {
+            std::array< std::atomic< uint64_t >, 2 > m_readers{};
+        };
+
+        struct Retired
+        {
+            void * m_object;
+            void ( *m_deleter )( void * );
+            uint64_t m_epoch;
+        };
+
+        struct alignas( 64 ) RetiredList
+        {
+            SpinLock m_lock;
+            std::vector< Retired > m_objects;
+        };
+
+    public:
+        static constexpr std::size_t Stripes = 64;
+        /// @brief Every this many objects retired into a stripe trigger a Collect.
+        static constexpr std::size_t CollectInterval = 64;
+
+        /// @brief Keeps the epoch pinned while alive.
+        class Guard
+        {
+        public:
+            Guard( const Guard & )             = delete;
+            Guard & operator=( const Guard & ) = delete;
+
+            Guard( Guard && other ) noexcept
+                : m_readers( std::exchange( other.m_readers, nullptr ) )
+            {
+            }
+
+            Guard & operator=( Guard && other ) noexcept
+            {
+                std::swap( m_readers, other.m_readers );
+                return *this;
+            }
+
+            ~Guard()
+            {
+                if ( m_readers != nullptr )
+                    m_readers->fetch_sub( 1, std::memory_order_release );
+            }
+
+        private:
+            friend class EpochDomain;
+
+            explicit Guard( std::atomic< uint64_t > & readers ) noexcept
+                : m_readers( &readers )
+            {
+            }
+
+            std::atomic< uint64_t > * m_readers;
+        };
+
+        EpochDomain() = default;
+
+        EpochDomain( const EpochDomain & )             = delete;
+        EpochDomain & operator=( const EpochDomain & ) = delete;
+
+        /// @brief Frees everything still retired, nobody may be pinned anymore.
+        ~EpochDomain()
+        {
+            for ( auto & list : m_retired )
+            {
+                for ( const auto & retired : list.m_objects )
+                    retired.m_deleter( retired.m_object );
+            }
+        }
+
+        [[nodiscard]] Guard Pin() noexcept
+        {
+            auto & stripe  = m_stripes[ detail::EpochStripe() % Stripes ];
+            uint64_t epoch = m_epoch.load( std::memory_order_seq_cst );
+            for ( ;; )
+            {
+                auto & readers = stripe.m_readers[ epoch & 1 ];
+                readers.fetch_add( 1, std::memory_order_seq_cst );
+
+                // An advance that missed the increment above moved the epoch, pin the new one instead.
+                const uint64_t current = m_epoch.load( std::memory_order_seq_cst );
+                if ( current == epoch )
+                    return Guard( readers );
+
+                readers.fetch_sub( 1, std::memory_order_release );
+                epoch = current;
+            }
+        }
+
+        /// @brief Frees the object with the deleter once no reader can still see it. Call after unlinking it.
+        void Retire( void * object, void ( *deleter )( void * ) )
+        {
+            auto & list         = m_retired[ detail::EpochStripe() % Stripes ];
+            std::size_t retired = 0;
+            {
+                std::scoped_lock lock( list.m_lock );
+                list.m_objects.push_back( { object, deleter, m_epoch.load( std::memory_order_seq_cst ) } );
+                retired = list.m_objects.size();
+            }
+            // Every so many rather than whenever the list is long, it stays long while a reader stays pinned.
+            if ( retired % CollectInterval == 0 )
+                Collect();
+        }
+
+        template< typename T >
+        void Retire( T * object )
+        {
+            Retire( object, []( void * retired ) { delete static_cast< T * >( retired ); } );
+        }
+
+        /// @brief Moves the epoch on if no reader still pins the previous one and frees what became unreachable.
+        /// Retire calls it now and then, a structure that stops changing keeps its last few retired objects until then.
+        /// @return Objects freed.
+        std::size_t Collect()
+        {
+            TryAdvance();
+            const uint64_t epoch = m_epoch.load( std::memory_order_seq_cst );
+
+            std::vector< Retired > expired;
+            for ( auto & list : m_retired )
+            {
+                std::unique_lock lock( list.m_lock, std::try_to_lock );
+                if ( !lock.owns_lock() )
+                    continue;
+
+                std::erase_if( list.m_objects,
+                               [ & ]( const Retired & retired )
+                               {
+                                   if ( retired.m_epoch + 2 > epoch )
+                                       return false;
+                                   expired.push_back( retired );
+                                   return true;
+                               } );
+            }
+
+            for ( const auto & retired : expired )
+                retired.m_deleter( retired.m_object );
+            return expired.size();
+        }
+
+    private:
+        /// @brief Readers of the current epoch may stay, the epoch before it must have none left.
+        bool TryAdvance() noexcept
+        {
+            uint64_t epoch = m_epoch.load( std::memory_order_seq_cst );
+            for ( const auto & stripe : m_stripes )
+            {
+                if ( stripe.m_readers[ ( epoch + 1 ) & 1 ].load( std::memory_order_seq_cst ) != 0 )
+                    return false;
+            }
+            return m_epoch.compare_exchange_strong( epoch, epoch + 1, std::memory_order_seq_cst );
+        }
+
+        alignas( 64 ) std::atomic< uint64_t > m_epoch{ 0 };
+        std::array< Stripe, Stripes > m_stripes{};
+        std::array< RetiredList, Stripes > m_retired{};
+    };
+} // namespace shm
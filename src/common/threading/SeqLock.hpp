@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+namespace shm
+{
+    /// @brief Sequence lock publishing a trivially copyable value to any number of readers.
+    /// Readers never block the writer, they retry when they raced with a store. Concurrent writers
+    /// serialize on the sequence counter, so the lock is meant for values written far more often
+    /// than they are contended (stats snapshots, rarely written slots).
+    template< typename T >
+        requires std::is_trivially_copyable_v< T > && std::is_default_constructible_v< T >
+    class SeqLock
+    {
+        static constexpr std::size_t WordCount = ( sizeof( T ) + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t );
+
+    public:
+        void Store( const T & value ) noexcept
+        {
+            uint64_t sequence = m_sequence.load( std::memory_order_relaxed );
+            for ( ;; )
+            {
+                if ( ( sequence & 1 ) == 0 && m_sequence.compare_exchange_weak( sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed ) )
+                    break;
+
+                std::this_thread::yield();
+                sequence = m_sequence.load( std::memory_order_relaxed );
+            }
+            std::atomic_thread_fence( std::memory_order_release );
+
+            std::array< uint64_t, WordCount > words{};
+            std::memcpy( words.data(), &value, sizeof( T ) );
+            for ( std::size_t i = 0; i < WordCount; ++i )
+                m_words[ i ].store( words[ i ], std::memory_order_relaxed );
+
+            m_sequence.store( sequence + 2, std::memory_order_release );
+        }
+
+        [[nodiscard]] T Load() const noexcept
+        {
+            std::array< uint64_t, WordCount > words{};
+            for ( ;; )
+            {
+                const uint64_t sequence = m_sequence.load( std::memory_order_acquire );
+                if ( ( sequence & 1 ) != 0 )
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for ( std::size_t i = 0; i < WordCount; ++i )
+                    words[ i ] = m_words[ i ].load( std::memory_order_relaxed );
+
+                std::atomic_thread_fence( std::memory_order_acquire );
+                if ( m_sequence.load( std::memory_order_relaxed ) == sequence )
+                    break;
+            }
+
+            T value;
+            std::memcpy( static_cast< void * >( &value ), words.data(), sizeof( T ) );
+            return value;
+        }
+
+        /// @brief Single read attempt that never waits, for readers that cannot rely on the writer to finish
+        /// (e.g. a writer in another process that may have died mid-store).
+        /// @return The value or nullopt if a store was in progress.
+        [[nodiscard]] std::optional< T > TryLoad() const noexcept
+        {
+            const uint64_t sequence = m_sequence.load( std::memory_order_acquire );
+            if ( ( sequence & 1 ) != 0 )
+                return std::nullopt;
+
+            std::array< uint64_t, WordCount > words{};
+            for ( std::size_t i = 0; i < WordCount; ++i )
+                words[ i ] = m_words[ i ].load( std::memory_order_relaxed );
+
+            std::atomic_thread_fence( std::memory_order_acquire );
+            if ( m_sequence.load( std::memory_order_relaxed ) != sequence )
+                return std::nullopt;
+
+            T value;
+            std::memcpy( static_cast< void * >( &value ), words.data(), sizeof( T ) );
+            return value;
+        }
+
+        /// @return Number of completed stores, can be used to detect whether anything changed since the last Load.
+        [[nodiscard]] uint64_t Version() const noexcept
+        {
+            return m_sequence.load( std::memory_order_acquire ) / 2;
+        }
+
+    private:
+        std::atomic< uint64_t > m_sequence{ 0 };
+        std::array< std::atomic< uint64_t >, WordCount > m_words{};
+    };
+} // namespace shm
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+namespace shm
+{
+    /// @brief Minimal test-and-test-and-set spin lock for short, mostly uncontended critical sections.
+    /// Satisfies Lockable so it can be used with std::scoped_lock.
+    class SpinLock
+    {
+    public:
+        void lock() noexcept
+        {
+            for ( ;; )
+            {
+                if ( !m_flag.exchange( true, std::memory_order_acquire ) )
+                    return;
+
+                while ( m_flag.load( std::memory_order_relaxed ) )
+                    std::this_thread::yield();
+            }
+        }
+
+        bool try_lock() noexcept
+        {
+            return !m_flag.load( std::memory_order_relaxed ) && !m_flag.exchange( true, std::memory_order_acquire );
+        }
+
+        void unlock() noexcept
+        {
+            m_flag.store( false, std::memory_order_release );
+        }
+
+    private:
+        std::atomic< bool > m_flag{ false };
+    };
+} // namespace shm
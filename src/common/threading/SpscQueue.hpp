@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace shm
+{
+    /// @brief Bounded lock-free queue between exactly one producer and one consumer thread.
+    /// Neither side ever waits: TryPush fails when the queue is full and TryPop when it is empty, the caller decides
+    /// whether to retry later. Each side caches the other side's index and only rereads it when the cached value says
+    /// full or empty, so a steady stream costs one shared cache line transfer per batch rather than per element.
+    template< typename T >
+        requires std::is_nothrow_move_constructible_v< T > && std::is_default_constructible_v< T >
+    class SpscQueue
+    {
+    public:
+        /// @param capacity Rounded up to a power of two.
+        explicit SpscQueue( std::size_t capacity )
+            : m_mask( std::bit_ceil( capacity < 2 ? std::size_t{ 2 } : capacity ) - 1 )
+            , m_slots( std::make_unique< T[] >( m_mask + 1 ) )
+        {
+        }
+
+        SpscQueue( const SpscQueue & )             = delete;
+        SpscQueue & operator=( const SpscQueue & ) = delete;
+
+        /// @brief Producer side.
+        [[nodiscard]] bool TryPush( T value ) noexcept
+        {
+            const std::size_t tail = m_tail.load( std::memory_order_relaxed );
+            if ( tail - m_cached_head == m_mask + 1 )
+            {
+                m_cached_head = m_head.load( std::memory_order_acquire );
+                if ( tail - m_cached_head == m_mask + 1 )
+                    return false;
+            }
+
+            m_slots[ tail & m_mask ] = std::move( value );
+            m_tail.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        /// @brief Consumer side.
+        [[nodiscard]] std::optional< T > TryPop() noexcept
+        {
+            const std::size_t head = m_head.load( std::memory_order_relaxed );
+            if ( head == m_cached_tail )
+            {
+                m_cached_tail = m_tail.load( std::memory_order_acquire );
+                if ( head == m_cached_tail )
+                    return std::nullopt;
+            }
+
+            std::optional< T > value{ std::move( m_slots[ head & m_mask ] ) };
+            m_head.store( head + 1, std::memory_order_release );
+            return value;
+        }
+
+        [[nodiscard]] std::size_t Capacity() const noexcept
+        {
+            return m_mask + 1;
+        }
+
+        /// @brief Approximate from any thread other than the two using the queue.
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            const std::size_t head = m_head.load( std::memory_order_acquire );
+            return m_tail.load( std::memory_order_acquire ) - head;
+        }
+
+    private:
+        const std::size_t m_mask;
+        const std::unique_ptr< T[] > m_slots;
+        /// @brief Written by the consumer, next to the tail it last saw.
+        alignas( 64 ) std::atomic< std::size_t > m_head{ 0 };
+        std::size_t m_cached_tail = 0;
+        /// @brief Written by the producer, next to the head it last saw.
+        alignas( 64 ) std::atomic< std::size_t > m_tail{ 0 };
+        std::size_t m_cached_head = 0;
+    };
+} // namespace shm
@@ -2,11 +2,11 @@
 
 #include "CancellationSignal.hpp"
 
-#include <boost/assert.hpp>
-#include <boost/asio/cancellation_signal.hpp>
-
+#include <cassert>
+#include <chrono>
 #include <future>
 #include <memory>
+#include <utility>
 
 namespace Threading
 {
@@ -84,7 +84,7 @@ namespace Threading
 
         T GetResult()
         {
-            BOOST_ASSERT( IsValid() );
+            assert( IsValid() );
             return m_future.get();
         }
 
@@ -96,9 +96,14 @@ namespace Threading
             if ( !signal )
                 return false;
 
-            BOOST_ASSERT_MSG( !signal->SignalCalled(), "Cancellation signal was already emitted, cannot emit again" );
-            signal->Emit();
-            return true;
+            assert( !signal->SignalCalled() && "Cancellation signal was already emitted, cannot emit again" );
+            return signal->Emit();
+        }
+
+        /// @brief The signal StopTask emits, e.g. to drop a timer guarding the task once it got stopped.
+        [[nodiscard]] std::weak_ptr< ed::thread::CancellationSignal > CancelSignal() const noexcept
+        {
+            return m_cancelSignal;
         }
 
     private:
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "threading/CancellationSignal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace shm
+{
+    /// @brief Generation-checked reference to a timer of a TimingWheel, stale once the timer fired or was cancelled.
+    struct TimerHandle
+    {
+        static constexpr uint32_t InvalidIndex = std::numeric_limits< uint32_t >::max();
+
+        uint32_t m_index      = InvalidIndex;
+        uint32_t m_generation = 0;
+
+        [[nodiscard]] constexpr bool IsValid() const noexcept
+        {
+            return m_index != InvalidIndex;
+        }
+
+        constexpr explicit operator bool() const noexcept
+        {
+            return IsValid();
+        }
+
+        constexpr bool operator==( const TimerHandle & ) const noexcept = default;
+    };
+
+    /// @brief Hierarchical timing wheel counting in broker ticks, for large numbers of timers that are mostly
+    /// rescheduled or cancelled before they fire (session timeouts, grace periods, delayed world events).
+    ///
+    /// Four levels of 256 slots cover 2^32 ticks ahead, deadlines further out wait in an overflow list. A timer sits in
+    /// the slot of the highest tick digit in which its deadline differs from now and moves down a level whenever the
+    /// wheel passes that digit, so Schedule, Reschedule and Cancel are O(1) and every timer is touched at most once per
+    /// level. Timers live in one vector and are chained through indices, a steady churn does not allocate.
+    ///
+    /// Not thread-safe, owned and advanced by the tick. Timers tied to a CancellationSignal are dropped instead of fired
+    /// when the signal was emitted by the time they expire, which is what makes the signal usable from other threads.
+    template< typename Payload >
+    class TimingWheel
+    {
+    public:
+        static constexpr uint32_t SlotBits   = 8;
+        static constexpr uint32_t SlotCount  = 1u << SlotBits;
+        static constexpr uint32_t LevelCount = 4;
+
+        explicit TimingWheel( uint64_t now = 0 )
+            : m_now( now )
+        {
+            m_heads.fill( Nil );
+        }
+
+        TimingWheel( const TimingWheel & )             = delete;
+        TimingWheel & operator=( const TimingWheel & ) = delete;
+
+        /// @brief The last tick Advance processed, timers due at it or earlier have fired.
+        [[nodiscard]] uint64_t Now() const noexcept
+        {
+            return m_now;
+        }
+
+        /// @brief Timers scheduled and not yet fired or cancelled.
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            return m_size;
+        }
+
+        /// @param deadline Tick to fire at, deadlines that already passed fire on the next tick.
+        /// @param cancel Drops the timer if emitted before it expires.
+        TimerHandle Schedule( uint64_t deadline, Payload payload, std::weak_ptr< ed::thread::CancellationSignal > cancel = {} )
+        {
+            const uint32_t index = Acquire();
+            auto & node          = m_nodes[ index ];
+            node.m_deadline      = std::max( deadline, m_now + 1 );
+            node.m_payload.emplace( std::move( payload ) );
+            node.m_cancel = std::move( cancel );
+            Link( index );
+            ++m_size;
+            return { index, node.m_generation };
+        }
+
+        /// @brief Moves a pending timer to a new deadline, keeping its payload.
+        /// @return False if the handle is stale.
+        bool Reschedule( TimerHandle handle, uint64_t deadline )
+        {
+            if ( !IsPending( handle ) )
+                return false;
+
+            Unlink( handle.m_index );
+            m_nodes[ handle.m_index ].m_deadline = std::max( deadline, m_now + 1 );
+            Link( handle.m_index );
+            return true;
+        }
+
+        /// @return False if the handle is stale.
+        bool Cancel( TimerHandle handle )
+        {
+            if ( !IsPending( handle ) )
+                return false;
+
+            Unlink( handle.m_index );
+            Release( handle.m_index );
+            --m_size;
+            return true;
+        }
+
+        [[nodiscard]] bool IsPending( TimerHandle handle ) const noexcept
+        {
+            return handle.m_index < m_nodes.size() && m_nodes[ handle.m_index ].m_generation == handle.m_generation
+                   && ( handle.m_generation & 1 ) != 0;
+        }
+
+        /// @return The payload of a pending timer, nullptr for stale handles.
+        [[nodiscard]] Payload * Get( TimerHandle handle ) noexcept
+        {
+            return IsPending( handle ) ? &*m_nodes[ handle.m_index ].m_payload : nullptr;
+        }
+
+        /// @brief Processes all ticks up to and including now, calling on_expired( Payload && ) for every timer due,
+        /// in deadline order. on_expired may schedule, reschedule and cancel timers, new ones fire on the next tick at
+        /// the earliest.
+        /// @return Number of timers fired.
+        template< typename OnExpired >
+        std::size_t Advance( uint64_t now, OnExpired && on_expired )
+        {
+            std::size_t fired = 0;
+            while ( m_now < now )
+            {
+                if ( m_size == 0 )
+                {
+                    m_now = now;
+                    break;
+                }
+
+                const uint64_t tick = ++m_now;
+                if ( ( tick & SlotMask ) == 0 )
+                    CascadeAt( tick );
+
+                auto & head = m_heads[ tick & SlotMask ];
+                while ( head != Nil )
+                {
+                    const uint32_t index = head;
+                    Unlink( index );
+                    auto & node = m_nodes[ index ];
+
+                    Payload payload    = std::move( *node.m_payload );
+                    const auto signal  = node.m_cancel.lock();
+                    const bool dropped = signal && signal->SignalCalled();
+                    Release( index );
+                    --m_size;
+
+                    if ( dropped )
+                        continue;
+                    on_expired( std::move( payload ) );
+                    ++fired;
+                }
+            }
+            return fired;
+        }
+
+    private:
+        static constexpr uint32_t Nil            = std::numeric_limits< uint32_t >::max();
+        static constexpr uint64_t SlotMask       = SlotCount - 1;
+        static constexpr uint32_t OverflowBucket = SlotCount * LevelCount;
+
+        struct Node
+        {
+            uint64_t m_deadline = 0;
+            uint32_t m_prev     = Nil;
+            uint32_t m_next     = Nil;
+            /// @brief Odd while the timer is pending.
+            uint32_t m_generation = 0;
+            uint32_t m_bucket     = 0;
+            std::optional< Payload > m_payload;
+            std::weak_ptr< ed::thread::CancellationSignal > m_cancel;
+        };
+
+        [[nodiscard]] uint32_t BucketOf( uint64_t deadline ) const noexcept
+        {
+            const uint64_t differing = deadline ^ m_now;
+            if ( differing == 0 )
+                return static_cast< uint32_t >( deadline & SlotMask );
+
+            const auto level = static_cast< uint32_t >( ( std::bit_width( differing ) - 1 ) / SlotBits );
+            if ( level >= LevelCount )
+                return OverflowBucket;
+            return level * SlotCount + static_cast< uint32_t >( ( deadline >> ( level * SlotBits ) ) & SlotMask );
+        }
+
+        void Link( uint32_t index ) noexcept
+        {
+            auto & node   = m_nodes[ index ];
+            node.m_bucket = BucketOf( node.m_deadline );
+            auto & head   = m_heads[ node.m_bucket ];
+            node.m_prev   = Nil;
+            node.m_next   = head;
+            if ( head != Nil )
+                m_nodes[ head ].m_prev = index;
+            head = index;
+        }
+
+        void Unlink( uint32_t index ) noexcept
+        {
+            auto & node = m_nodes[ index ];
+            if ( node.m_prev != Nil )
+                m_nodes[ node.m_prev ].m_next = node.m_next;
+            else
+                m_heads[ node.m_bucket ] = node.m_next;
+            if ( node.m_next != Nil )
+                m_nodes[ node.m_next ].m_prev = node.m_prev;
+        }
+
+        /// @brief Redistributes the slots whose digit just wrapped, highest level first, so timers can fall through
+        /// several levels on the same tick.
+        void CascadeAt( uint64_t tick )
+        {
+            if ( ( tick & ( ( uint64_t{ 1 } << ( SlotBits * LevelCount ) ) - 1 ) ) == 0 )
+                Cascade( OverflowBucket );
+
+            for ( uint32_t level = LevelCount - 1; level > 0; --level )
+            {
+                if ( ( tick & ( ( uint64_t{ 1 } << ( SlotBits * level ) ) - 1 ) ) == 0 )
+                    Cascade( level * SlotCount + static_cast< uint32_t >( ( tick >> ( SlotBits * level ) ) & SlotMask ) );
+            }
+        }
+
+        void Cascade( uint32_t bucket )
+        {
+            uint32_t index = std::exchange( m_heads[ bucket ], Nil );
+            while ( index != Nil )
+            {
+                const uint32_t next = m_nodes[ index ].m_next;
+                Link( index );
+                index = next;
+            }
+        }
+
+        uint32_t Acquire()
+        {
+            uint32_t index = m_free_head;
+            if ( index != Nil )
+                m_free_head = m_nodes[ index ].m_next;
+            else
+            {
+                index = static_cast< uint32_t >( m_nodes.size() );
+                m_nodes.emplace_back();
+            }
+            ++m_nodes[ index ].m_generation;
+            return index;
+        }
+
+        void Release( uint32_t index ) noexcept
+        {
+            auto & node = m_nodes[ index ];
+            node.m_payload.reset();
+            node.m_cancel.reset();
+            ++node.m_generation;
+            node.m_next = m_free_head;
+            m_free_head = index;
+        }
+
+        std::vector< Node > m_nodes;
+        std::array< uint32_t, OverflowBucket + 1 > m_heads{};
+        uint32_t m_free_head = Nil;
+        std::size_t m_size   = 0;
+        uint64_t m_now       = 0;
+    };
+} // namespace shm
@@ -3,14 +3,43 @@
 #include <args.hxx>
 #include <flecs.h>
 
+#include <chrono>
+#include <csignal>
 #include <filesystem>
+#include <format>
 #include <iostream>
+#include <optional>
 #include <print>
+#include <utility>
+#include <vector>
 
+#include "logging/FlightRecorder.hpp"
 #include "logging/Logging.hpp"
 #include <spdlog/spdlog.h>
 
+#include <app/InboundHandler.hpp>
+#include <app/RuntimeStats.hpp>
 #include <config/Config.hpp>
+#include <crashhandler/CrashContext.hpp>
+#include <crashhandler/CrashHandler.hpp>
+#include <dashboard/Dashboard.hpp>
+#include <handoff/SessionHandoff.hpp>
+#include <journal/Journal.hpp>
+#include <metrics/Metrics.hpp>
+#include <net/Gateway.hpp>
+#include <net/Messages.hpp>
+#include <net/SessionDirectory.hpp>
+#include <net/ShmTransport.hpp>
+#include <net/UdpServer.hpp>
+#include <overload/LoadShedder.hpp>
+#include <overload/OverloadController.hpp>
+#include <replay/Capture.hpp>
+#include <scheduler/FrameScheduler.hpp>
+#include <tracing/Tracing.hpp>
+#include <wire/Dispatcher.hpp>
+#include <worlds/WorldCluster.hpp>
+
+#include <magic_enum/magic_enum.hpp>
 
 struct TestConfig
 {
@@ -21,26 +50,93 @@ struct TestConfig
 
 namespace
 {
+    std::atomic< bool > G_STOP_REQUESTED{ false };
+    shm::LogCategory G_CONFIG_LOG{ "Config" };
+
+    /// @brief Ticks between two checks for config files edited on disk, about once a second.
+    constexpr uint64_t CONFIG_RELOAD_INTERVAL_TICKS = 120;
+    /// @brief Ticks between two periodic journal snapshots, a minute. They are deferred work, see SubmitSnapshot.
+    constexpr uint64_t SNAPSHOT_INTERVAL_TICKS = 120 * 60;
+    /// @brief Entity ids a snapshot step captures, well below a millisecond.
+    constexpr std::size_t SNAPSHOT_STEP_IDS = 2048;
+    /// @brief Snapshot intervals a snapshot may wait for an overloaded broker before it runs anyway.
+    constexpr uint32_t SNAPSHOT_MAX_SKIPPED_INTERVALS = 5;
+    /// @brief Ticks between two world hashes in a capture, every five seconds. Each one copies the world.
+    constexpr uint64_t CAPTURE_CHECKPOINT_INTERVAL_TICKS = 600;
+    /// @brief Ticks without a message after which a session is dropped, a minute.
+    constexpr uint64_t SESSION_IDLE_TIMEOUT_TICKS = 120 * 60;
+    /// @brief Time a takeover may take before the running broker carries on by itself.
+    constexpr std::chrono::seconds HANDOFF_TIMEOUT{ 10 };
+
+    void OnStopSignal( int )
+    {
+        G_STOP_REQUESTED.store( true, std::memory_order_relaxed );
+    }
+
     shm::Result< TestConfig > TestConfigMigrator( std::string & json_data, uint32_t from_version,
                                                   uint32_t to_version )
     {
         return TestConfig{};
     }
+
+    shm::Result< shm::LogLevelsConfig > LogLevelsMigrator( std::string &, uint32_t, uint32_t )
+    {
+        return shm::LogLevelsConfig{};
+    }
+
+    shm::Result< shm::overload::OverloadConfig > OverloadMigrator( std::string &, uint32_t, uint32_t )
+    {
+        return shm::overload::OverloadConfig{};
+    }
+
+    void ApplyLogLevels( const shm::LogLevelsConfig & levels )
+    {
+        auto apply_result = shm::log::ApplyLevels( levels );
+        if ( !apply_result.has_value() )
+            SHM_LOG_ERROR( "Ignoring log levels config with an unknown level name: {}", apply_result.error().message() );
+        else
+            SHM_LOG_INFO( "Log levels applied, {} category overrides", levels.categories.size() );
+    }
 } // namespace
 
 wb::Application::Application()
     : m_broker_world( std::make_unique< flecs::world >() )
+    , m_crash_handler( nullptr )
+    , m_stats_board( std::make_unique< RuntimeStatsBoard >() )
     , m_logger( nullptr )
+    , m_gateway( std::make_unique< shm::net::Gateway >() )
+    , m_session_directory( std::make_unique< shm::net::SessionDirectory >() )
+    , m_scheduler( std::make_unique< shm::sched::FrameScheduler >( shm::metrics::DefaultRegistry() ) )
 {
+    m_tick_worker = m_stats_board->RegisterWorker( "tick" );
 }
 
-wb::Application::~Application() = default;
+wb::Application::~Application()
+{
+    shm::metrics::DefaultRegistry().UnregisterGaugeCallback( "shm_connections" );
+    shm::metrics::DefaultRegistry().UnregisterGaugeCallback( "shm_sessions" );
+    shm::metrics::DefaultRegistry().UnregisterGaugeCallback( "shm_worlds_stalled" );
+}
 
 constexpr uint32_t TARGET_FPS = 120;
 
 int wb::Application::Run( int argc, char ** argv )
 {
-    std::string config_directory = "./configs";
+    std::string config_directory  = "./configs";
+    std::string metrics_file      = "./metrics/worldbroker.prom";
+    std::string crash_directory   = "./crashes";
+    std::string journal_directory = "./journal";
+    std::string record_file;
+    std::string replay_file;
+    std::string handoff_socket;
+    std::string shm_socket;
+    uint64_t max_ticks            = 0;
+    uint32_t hosted_worlds        = 1;
+    uint32_t world_tick_rate      = TARGET_FPS;
+    bool tracing_enabled          = false;
+    bool dashboard_enabled        = false;
+    bool take_over                = false;
+    std::optional< shm::net::UdpSettings > udp_settings;
     args::ArgumentParser parser( "Shimmer World Broker Application",
                                  "A broker application for managing connections from players and service servers." );
     try
@@ -48,10 +144,74 @@ int wb::Application::Run( int argc, char ** argv )
         args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
         args::ValueFlag< std::string > config_dir( parser, "config-dir", "Directory to load configuration files from",
                                                    { 'c', "config-dir" }, args::Options::Single );
+        args::ValueFlag< std::string > metrics_path( parser, "metrics-file", "Prometheus text file the metrics are exported to, empty disables the export",
+                                                     { "metrics-file" }, args::Options::Single );
+        args::ValueFlag< uint64_t > ticks( parser, "max-ticks", "Stop after the given number of ticks (0 = run until interrupted)",
+                                           { "max-ticks" }, args::Options::Single );
+        args::Flag trace( parser, "trace", "Record spans of log scopes and flecs systems, dumped on exit and on SIGUSR1", { "trace" } );
+        args::ValueFlag< std::string > trace_path( parser, "trace-file", "Chrome trace JSON file the recorded spans are dumped to",
+                                                   { "trace-file" }, args::Options::Single );
+        args::ValueFlag< std::string > crash_dir( parser, "crash-dir", "Directory minidumps and their crash context are written to",
+                                                  { "crash-dir" }, args::Options::Single );
+        args::ValueFlag< std::string > journal_dir( parser, "journal-dir", "Directory the world journal and its snapshots are kept in",
+                                                    { "journal-dir" }, args::Options::Single );
+        args::ValueFlag< std::string > record_path( parser, "record", "Record every inbound event and tick into the given capture file",
+                                                    { "record" }, args::Options::Single );
+        args::ValueFlag< std::string > replay_path( parser, "replay", "Replay the given capture as fast as possible without sockets, then exit",
+                                                    { "replay" }, args::Options::Single );
+        args::ValueFlag< uint16_t > udp_port( parser, "udp-port", "Also accept peers over UDP on the given port", { "udp-port" }, args::Options::Single );
+        args::ValueFlag< uint32_t > udp_io_threads( parser, "udp-io-threads", "Threads receiving UDP datagrams, each on its own socket (0 = the tick thread)",
+                                                    { "udp-io-threads" }, args::Options::Single );
+        args::ValueFlag< uint32_t > udp_max_peers( parser, "udp-max-peers", "UDP peers accepted at most, datagrams of further addresses are dropped",
+                                                   { "udp-max-peers" }, args::Options::Single );
+        args::ValueFlag< uint32_t > worlds( parser, "worlds", "Number of hosted worlds, with ids from 0, each ticking on a thread of its own",
+                                            { "worlds" }, args::Options::Single );
+        args::ValueFlag< uint32_t > world_rate( parser, "world-tick-rate", "Ticks per second of every hosted world", { "world-tick-rate" },
+                                                args::Options::Single );
+        args::ValueFlag< std::string > handoff_path( parser, "handoff-socket", "Unix socket a restarted broker takes the peers over through, see --take-over",
+                                                     { "handoff-socket" }, args::Options::Single );
+        args::Flag take_over_flag( parser, "take-over", "Take the sockets and peers over from the broker listening on --handoff-socket",
+                                   { "take-over" } );
+        args::ValueFlag< std::string > shm_path( parser, "shm-socket", "Unix socket co-located services attach over shared memory through",
+                                                 { "shm-socket" }, args::Options::Single );
+        args::Flag dashboard( parser, "dashboard", "Show a live terminal dashboard of the runtime stats instead of logging to stderr, 'q' quits",
+                              { "dashboard" } );
         parser.ParseCLI( argc, argv );
 
         if ( config_dir )
             config_directory = config_dir.Get();
+        if ( metrics_path )
+            metrics_file = metrics_path.Get();
+        if ( ticks )
+            max_ticks = ticks.Get();
+        if ( trace_path )
+            m_trace_file = trace_path.Get();
+        if ( crash_dir )
+            crash_directory = crash_dir.Get();
+        if ( journal_dir )
+            journal_directory = journal_dir.Get();
+        if ( record_path )
+            record_file = record_path.Get();
+        if ( replay_path )
+            replay_file = replay_path.Get();
+        if ( udp_port )
+            udp_settings = shm::net::UdpSettings{ .m_address    = { .m_ip = 0, .m_port = udp_port.Get() },
+                                                  .m_io_threads = udp_io_threads ? udp_io_threads.Get() : 0 };
+        if ( udp_settings && udp_max_peers )
+            udp_settings->m_max_peers = udp_max_peers.Get();
+        if ( worlds )
+            hosted_worlds = worlds.Get();
+        if ( world_rate )
+            world_tick_rate = world_rate.Get();
+        if ( handoff_path )
+            handoff_socket = handoff_path.Get();
+        if ( shm_path )
+            shm_socket = shm_path.Get();
+        tracing_enabled   = trace;
+        dashboard_enabled = dashboard;
+        take_over         = take_over_flag;
+        if ( take_over && handoff_socket.empty() )
+            throw args::ValidationError( "--take-over needs --handoff-socket" );
     }
     catch ( const args::Completion & )
     {
@@ -73,30 +233,74 @@ int wb::Application::Run( int argc, char ** argv )
         return 1;
     }
 
-    if ( !InitializeLoggingSystem() )
+    // Forks the dump helper, so this has to happen before any thread is started.
+    m_crash_handler = std::make_unique< fs::CrashHandler >( std::filesystem::path( crash_directory ), "worldbroker" );
+
+    if ( !InitializeLoggingSystem( !dashboard_enabled ) )
     {
         std::println( "Failed to initialize logging system, shutting down." );
         return 1;
     }
 
-    spdlog::info( "Application starting {}", 1 );
+    SHM_LOG_INFO( "Application starting {}", 1 );
+    if ( !m_crash_handler->IsInstalled() )
+        SHM_LOG_WARN( "Crash handler is not installed, crashes will not leave a dump" );
+
+    if ( tracing_enabled )
+    {
+        shm::trace::SetEnabled( true );
+        shm::trace::InstallDumpSignalHandler();
+        if ( !shm::trace::InstrumentFlecs( *m_broker_world ) )
+            SHM_LOG_WARN( "flecs was built without FLECS_PERF_TRACE, systems will not be traced individually" );
+    }
 
     {
         shm::LogScope startup{ "Startup" };
-        spdlog::debug( "Loading configuration" );
+        SHM_LOG_DEBUG( "Loading configuration" );
         {
-            shm::LogScope cfg{ "Config" };
-            spdlog::info( "Using directory: {}", config_directory );
+            shm::LogScope cfg{ G_CONFIG_LOG };
+            SHM_LOG_INFO( "Using directory: {}", config_directory );
         }
     }
 
     shm::Config cfg{ config_directory };
     if ( !cfg.IsDirectoryCreated() )
     {
-        spdlog::error( "Failed to create configuration directory: {}", config_directory );
+        SHM_LOG_ERROR( "Failed to create configuration directory: {}", config_directory );
         return 1;
     }
 
+    if ( auto levels_result = cfg.RegisterConfig( shm::LogLevelsConfig{}, "LogLevels", "json", &LogLevelsMigrator ); levels_result.has_value() )
+    {
+        auto levels = cfg.GetConfig< const shm::LogLevelsConfig >( "LogLevels" );
+        ApplyLogLevels( *levels.operator->() );
+        std::ignore = cfg.Subscribe< shm::LogLevelsConfig >( "LogLevels", &ApplyLogLevels );
+    }
+    else
+    {
+        SHM_LOG_ERROR( "Failed to register log levels config: {}", levels_result.error().message() );
+    }
+
+    shm::overload::OverloadConfig overload_config;
+    if ( auto overload_result = cfg.RegisterConfig( shm::overload::OverloadConfig{}, "Overload", "json", &OverloadMigrator ); overload_result.has_value() )
+    {
+        overload_config = *cfg.GetConfig< const shm::overload::OverloadConfig >( "Overload" ).operator->();
+        std::ignore     = cfg.Subscribe< shm::overload::OverloadConfig >( "Overload",
+                                                                          [ this ]( const shm::overload::OverloadConfig & config )
+                                                                          {
+                                                                              m_overload->Configure( config );
+                                                                              m_shedder->Configure( config );
+                                                                              SHM_LOG_INFO( "Overload thresholds reloaded" );
+                                                                          } );
+    }
+    else
+    {
+        SHM_LOG_ERROR( "Failed to register overload config, using the default thresholds: {}", overload_result.error().message() );
+    }
+    const auto frame_budget_ns = static_cast< uint64_t >( std::chrono::nanoseconds( std::chrono::seconds( 1 ) ).count() / TARGET_FPS );
+    m_overload                 = std::make_unique< shm::overload::OverloadController >( shm::metrics::DefaultRegistry(), frame_budget_ns, overload_config );
+    m_shedder                  = std::make_unique< shm::overload::LoadShedder >( shm::metrics::DefaultRegistry(), overload_config );
+
     auto test_result = cfg.RegisterConfig( TestConfig{}, "TestConfig", "json", &TestConfigMigrator );
     {
         auto test_cfg          = cfg.GetConfig< TestConfig >( "TestConfig" );
@@ -108,32 +312,532 @@ int wb::Application::Run( int argc, char ** argv )
     {
         if ( !res.has_value() )
         {
-            spdlog::error( "Failed to save config: {}", res.error().message() );
+            SHM_LOG_ERROR( "Failed to save config: {}", res.error().message() );
+        }
+    }
+
+    if ( !replay_file.empty() )
+        return RunReplay( replay_file, journal_directory );
+
+    // The running broker snapshots and flushes the journal before it answers, recovering below picks up its world.
+    std::optional< shm::handoff::Handoff > handoff;
+    if ( take_over )
+    {
+        auto requested = shm::handoff::RequestHandoff( handoff_socket, HANDOFF_TIMEOUT );
+        if ( !requested.has_value() )
+        {
+            SHM_LOG_CRITICAL( "Failed to take over from the broker on {}: {}", handoff_socket, requested.error().message() );
+            return 1;
+        }
+        handoff = std::move( *requested );
+        m_tick  = handoff->m_table.tick;
+        SHM_LOG_INFO( "Taking over {} UDP peers at tick {}", handoff->m_table.udp_peers.size(), m_tick );
+    }
+
+    // Snapshots are taken by the main loop, as deferred work that waits while the broker is overloaded.
+    m_journal = std::make_unique< shm::journal::WorldJournal >( *m_broker_world, shm::journal::JournalSettings{
+                                                                                     .m_directory               = journal_directory,
+                                                                                     .m_snapshot_interval_ticks = 0,
+                                                                                 } );
+    {
+        auto & recovery_duration = shm::metrics::DefaultRegistry().GetHistogram( "shm_journal_recovery_ns", "Time spent restoring the world from the journal" );
+        shm::metrics::ScopedTimer recovery_timer{ recovery_duration };
+        auto recovery = m_journal->Recover();
+        if ( !recovery.has_value() )
+        {
+            SHM_LOG_CRITICAL( "Failed to recover the world from {}: {}", journal_directory, recovery.error().message() );
+            return 1;
+        }
+        if ( recovery->m_truncated_tail )
+            SHM_LOG_WARN( "World journal ended in a torn record, it was cut off there" );
+        SHM_LOG_INFO( "World recovered: snapshot {} with {} entities, {} journal records replayed", recovery->m_snapshot_sequence,
+                      recovery->m_snapshot_entities, recovery->m_replayed_records );
+    }
+
+    {
+        m_inbound = std::make_unique< InboundHandler >( *m_journal, SESSION_IDLE_TIMEOUT_TICKS, m_tick );
+        m_inbound->MirrorInto( *m_session_directory );
+        m_inbound->Adopt( m_journal->CaptureState() );
+        if ( handoff && !ResumeSessions( *handoff, udp_settings.value_or( shm::net::UdpSettings{} ) ) )
+            return 1;
+
+        // Taken after the handed over sessions were moved to their new ids, captures and worlds start from them.
+        const auto initial_state = m_journal->CaptureState();
+
+        if ( !record_file.empty() )
+        {
+            auto capture = shm::replay::CaptureWriter::Create( record_file, initial_state );
+            if ( !capture.has_value() )
+            {
+                SHM_LOG_CRITICAL( "Failed to create capture {}: {}", record_file, capture.error().message() );
+                return 1;
+            }
+            m_capture = std::make_unique< shm::replay::CaptureWriter >( std::move( *capture ) );
+            SHM_LOG_INFO( "Recording capture to {}", record_file );
+        }
+
+        std::vector< shm::worlds::WorldSettings > world_settings;
+        for ( uint32_t world_id = 0; world_id < hosted_worlds; ++world_id )
+            world_settings.push_back( { .m_id = world_id, .m_name = std::format( "world-{}", world_id ), .m_tick_rate = world_tick_rate } );
+        m_worlds = std::make_unique< shm::worlds::WorldCluster >( std::move( world_settings ) );
+        m_worlds->Adopt( initial_state );
+        m_worlds->Start();
+        SHM_LOG_INFO( "Hosting {} worlds at {} ticks per second", hosted_worlds, world_tick_rate );
+    }
+
+    if ( udp_settings && !m_udp )
+    {
+        auto udp = shm::net::UdpServer::Create( *m_gateway, *udp_settings );
+        if ( !udp.has_value() )
+        {
+            SHM_LOG_CRITICAL( "Failed to listen on UDP port {}: {}", udp_settings->m_address.m_port, udp.error().message() );
+            return 1;
+        }
+        m_udp = std::move( *udp );
+        SHM_LOG_INFO( "Accepting UDP peers on port {} with {} I/O threads", m_udp->Port(), udp_settings->m_io_threads );
+    }
+
+    if ( !handoff_socket.empty() )
+    {
+        auto listener = shm::handoff::HandoffListener::Listen( handoff_socket );
+        if ( listener.has_value() )
+        {
+            m_handoff = std::make_unique< shm::handoff::HandoffListener >( std::move( *listener ) );
+            SHM_LOG_INFO( "A restarted broker can take over through {}", handoff_socket );
+        }
+        else
+        {
+            SHM_LOG_ERROR( "Failed to listen for a successor on {}, restarts will drop the peers: {}", handoff_socket, listener.error().message() );
+        }
+    }
+
+    if ( !shm_socket.empty() )
+    {
+        auto listener = shm::net::ShmListener::Listen( shm_socket );
+        if ( !listener.has_value() )
+        {
+            SHM_LOG_CRITICAL( "Failed to listen for shared memory services on {}: {}", shm_socket, listener.error().message() );
+            return 1;
+        }
+        m_shm = std::make_unique< shm::net::ShmListener >( std::move( *listener ) );
+        SHM_LOG_INFO( "Services can attach over shared memory through {}", shm_socket );
+    }
+
+    RegisterBuiltinMetrics();
+    shm::metrics::Aggregator metrics_aggregator{ shm::metrics::DefaultRegistry(),
+                                                 {
+                                                     .m_prometheus_file = metrics_file,
+                                                     .m_on_export_error = [ metrics_file ]( std::error_code error, uint64_t failures )
+                                                     { SHM_LOG_WARN( "Failed to export metrics to {} ({} times): {}", metrics_file, failures, error.message() ); },
+                                                 } };
+
+    std::signal( SIGINT, &OnStopSignal );
+    std::signal( SIGTERM, &OnStopSignal );
+
+    std::unique_ptr< Dashboard > dashboard;
+    if ( dashboard_enabled )
+        dashboard = std::make_unique< Dashboard >( *m_stats_board, metrics_aggregator, []() { OnStopSignal( 0 ); } );
+
+    const int exit_code = RunMainLoop( cfg, max_ticks );
+    dashboard.reset();
+
+    m_worlds->Stop();
+    for ( const auto & host : m_worlds->Hosts() )
+        SHM_LOG_INFO( "World {} stopped after {} ticks with {} players", host->Name(), host->Ticks(), host->Residents() );
+
+    if ( m_capture )
+    {
+        if ( m_tick % CAPTURE_CHECKPOINT_INTERVAL_TICKS != 0 )
+            m_capture->RecordCheckpoint( m_tick, shm::replay::HashWorld( m_journal->CaptureState() ) );
+        if ( auto capture_result = m_capture->Close(); !capture_result.has_value() )
+            SHM_LOG_ERROR( "Writing the capture {} failed: {}", record_file, capture_result.error().message() );
+        m_capture.reset();
+    }
+
+    m_journal->Flush();
+    if ( auto journal_error = m_journal->WriterError(); !journal_error.has_value() )
+        SHM_LOG_ERROR( "Writing the world journal failed: {}", journal_error.error().message() );
+
+    if ( shm::trace::IsEnabled() )
+        DumpTrace();
+
+    return exit_code;
+}
+
+int wb::Application::RunReplay( const std::string & capture_file, const std::string & journal_directory )
+{
+    auto reader = shm::replay::CaptureReader::Open( capture_file );
+    if ( !reader.has_value() )
+    {
+        SHM_LOG_CRITICAL( "Failed to open capture {}: {}", capture_file, reader.error().message() );
+        return 1;
+    }
+
+    // The replayed world is journaled like a live one, but into a scratch directory so the real journal stays untouched.
+    const auto replay_journal = std::filesystem::path( journal_directory ) / "replay";
+    std::error_code ec;
+    std::filesystem::remove_all( replay_journal, ec );
+    m_journal = std::make_unique< shm::journal::WorldJournal >( *m_broker_world, shm::journal::JournalSettings{
+                                                                                     .m_directory               = replay_journal,
+                                                                                     .m_snapshot_interval_ticks = 0,
+                                                                                 } );
+    m_journal->Restore( reader->InitialState() );
+    SHM_LOG_INFO( "Replaying {} starting from {} entities", capture_file, reader->InitialState().entities.size() );
+
+    using Clock      = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto stats = shm::replay::Replay(
+        *reader, m_gateway->Inbound(),
+        [ this, &reader ]( uint64_t tick, float delta_time )
+        {
+            m_tick = tick - 1;
+            // Idle deadlines count from the first tick, which is not 1 for a capture recorded after a takeover.
+            if ( !m_inbound )
+            {
+                m_inbound = std::make_unique< InboundHandler >( *m_journal, SESSION_IDLE_TIMEOUT_TICKS, m_tick );
+                m_inbound->Adopt( reader->InitialState() );
+            }
+            StepTick( delta_time );
+        },
+        [ this ]() { return shm::replay::HashWorld( m_journal->CaptureState() ); } );
+    const auto seconds = std::chrono::duration< double >( Clock::now() - start ).count();
+    m_journal->Flush();
+
+    const auto world_hash = shm::replay::HashWorld( m_journal->CaptureState() );
+    SHM_LOG_INFO( "Replayed {} ticks and {} events in {:.3f}s ({:.0f} ticks/s), {} checkpoints, world hash {:016x}", stats.m_ticks,
+                  stats.m_events, seconds, seconds > 0.0 ? static_cast< double >( stats.m_ticks ) / seconds : 0.0, stats.m_checkpoints,
+                  world_hash );
+    std::println( "ticks={} events={} seconds={:.6f} world_hash={:016x}", stats.m_ticks, stats.m_events, seconds, world_hash );
+
+    if ( stats.m_truncated )
+        SHM_LOG_WARN( "Capture {} ends in a torn event, the replay stopped there", capture_file );
+    if ( stats.m_first_divergent_tick )
+    {
+        SHM_LOG_ERROR( "Replay diverged from the recording, first mismatching checkpoint at tick {}", *stats.m_first_divergent_tick );
+        return 2;
+    }
+    return 0;
+}
+
+void wb::Application::StepTick( float delta_time )
+{
+    auto & inbox = m_gateway->Inbound();
+    inbox.ForEach( [ this ]( const shm::net::InboundEvent & event ) { m_inbound->Handle( event ); } );
+    inbox.Clear();
+    m_inbound->ExpireIdle( m_tick + 1 );
+    if ( m_worlds )
+    {
+        m_worlds->Route( m_journal->StagedCommands() );
+        m_worlds->Poll();
+    }
+
+    {
+        shm::trace::Span tick_span{ "Tick" };
+        m_broker_world->progress( delta_time );
+    }
+    ++m_tick;
+    m_journal->CommitTick( m_tick );
+}
+
+void wb::Application::DumpTrace() const
+{
+    auto dump_result = shm::trace::DumpChromeTrace( m_trace_file );
+    if ( !dump_result.has_value() )
+        SHM_LOG_ERROR( "Failed to dump trace to {}: {}", m_trace_file, dump_result.error().message() );
+    else
+        SHM_LOG_INFO( "Trace dumped to {}", m_trace_file );
+}
+
+bool wb::Application::HandOver()
+{
+    shm::handoff::SessionTable table{ .tick = m_tick };
+    std::vector< int > descriptors;
+    // Frames still in send queues would be lost, in the peers' channels they are handed over.
+    m_gateway->FlushTransports();
+    if ( m_udp )
+    {
+        // What already arrived goes along with the peers, later datagrams wait in the sockets for the successor.
+        m_udp->StopReceiving( m_tick + 1 );
+        table.udp_peers = m_udp->CapturePeers();
+        descriptors     = m_udp->NativeHandles();
+    }
+    // The successor recovers from the journal, a fresh snapshot keeps that short.
+    m_journal->RequestSnapshot();
+    m_journal->Flush();
+
+    SHM_LOG_INFO( "Handing {} UDP peers over to a successor at tick {}", table.udp_peers.size(), m_tick );
+    if ( auto handed = m_handoff->Hand( table, descriptors, HANDOFF_TIMEOUT ); !handed.has_value() )
+    {
+        SHM_LOG_ERROR( "The successor did not take over, carrying on: {}", handed.error().message() );
+        if ( m_udp )
+            m_udp->ResumeReceiving();
+        return false;
+    }
+
+    m_udp.reset();
+    SHM_LOG_INFO( "Successor took over, stopping" );
+    return true;
+}
+
+bool wb::Application::ResumeSessions( shm::handoff::Handoff & handoff, const shm::net::UdpSettings & udp_settings )
+{
+    std::size_t resumed = 0;
+    if ( !handoff.m_descriptors.empty() )
+    {
+        auto adopted = shm::net::UdpServer::Adopt( *m_gateway, udp_settings, std::move( handoff.m_descriptors ), handoff.m_table.udp_peers, m_tick );
+        if ( !adopted.has_value() )
+        {
+            SHM_LOG_CRITICAL( "Failed to take over the UDP sockets: {}", adopted.error().message() );
+            return false;
+        }
+        m_udp = std::move( adopted->m_server );
+
+        // The previous broker attached the unknown peers but never ran a tick with them.
+        const auto unknown = m_inbound->Resume( adopted->m_sessions );
+        for ( const auto session : unknown )
+            m_gateway->Inbound().Push( shm::net::InboundType::Connected, session );
+        resumed = adopted->m_sessions.size() - unknown.size();
+    }
+
+    // Nothing is committed before the previous broker let go, it keeps writing the journal if it carries on.
+    if ( auto confirmed = shm::handoff::ConfirmHandoff( handoff, HANDOFF_TIMEOUT ); !confirmed.has_value() )
+    {
+        SHM_LOG_CRITICAL( "The previous broker gave up waiting for the takeover: {}", confirmed.error().message() );
+        return false;
+    }
+    m_journal->CommitTick( m_tick );
+    SHM_LOG_INFO( "Took over {} sessions, UDP port {}", resumed, m_udp ? m_udp->Port() : 0 );
+    return true;
+}
+
+void wb::Application::RegisterBuiltinMetrics()
+{
+    auto & registry = shm::metrics::DefaultRegistry();
+    registry.GetHistogram( "shm_tick_duration_ns", "Wall time of a single broker tick" );
+    registry.GetCounter( "shm_ticks_total", "Number of broker ticks executed" );
+    registry.RegisterGaugeCallback( "shm_connections", "Currently open connections",
+                                    [ gateway = m_gateway.get() ]() -> int64_t
+                                    {
+                                        return static_cast< int64_t >( gateway->ConnectionCount() );
+                                    } );
+    registry.RegisterGaugeCallback( "shm_sessions", "Sessions with an entity in the world",
+                                    [ directory = m_session_directory.get() ]() -> int64_t
+                                    {
+                                        return static_cast< int64_t >( directory->Size() );
+                                    } );
+    if ( m_worlds )
+        registry.RegisterGaugeCallback( "shm_worlds_stalled", "Hosted worlds too far behind on the commands routed to them",
+                                        [ worlds = m_worlds.get() ]() -> int64_t
+                                        {
+                                            return static_cast< int64_t >( worlds->StalledWorlds() );
+                                        } );
+}
+
+void wb::Application::SubmitConfigSync( shm::Config & cfg )
+{
+    // A sync still waiting for frame time picks up whatever changed since it was submitted, a second one would only pile up.
+    if ( m_config_sync_job != 0 && m_scheduler->IsQueued( m_config_sync_job ) )
+        return;
+
+    // Reloading and saving stat and rewrite files, they run in left over frame time. Two steps so each fits a frame on its own.
+    // Normal priority keeps it running while low priority work is deferred, and the scheduler runs a step that never fits
+    // every few frames, so overload thresholds edited on disk still apply while every frame is late.
+    m_config_sync_job = m_scheduler->Submit( { .m_name = "config-sync", .m_priority = shm::sched::JobPriority::Normal, .m_deadline = std::chrono::seconds( 1 ) },
+                                             [ &cfg, reloaded = false ]() mutable
+                                             {
+                                                 if ( !std::exchange( reloaded, true ) )
+                                                 {
+                                                     for ( const auto & reload_result : cfg.ReloadChangedConfigs() )
+                                                     {
+                                                         if ( !reload_result.has_value() )
+                                                             SHM_LOG_ERROR_TO( G_CONFIG_LOG, "Failed to reload config: {}", reload_result.error().message() );
+                                                     }
+                                                     return shm::sched::StepResult::Continue;
+                                                 }
+
+                                                 for ( const auto & save_result : cfg.SaveDirtyConfigs() )
+                                                 {
+                                                     if ( !save_result.has_value() )
+                                                         SHM_LOG_ERROR_TO( G_CONFIG_LOG, "Failed to save config: {}", save_result.error().message() );
+                                                 }
+                                                 return shm::sched::StepResult::Done;
+                                             } );
+}
+
+void wb::Application::SubmitSnapshot()
+{
+    // Low priority, a snapshot only shortens recovery and can wait until an overloaded broker recovered. The journal
+    // grows meanwhile though, after a few skipped intervals it continues at normal priority, which still runs while
+    // deferred systems are shed.
+    auto priority = shm::sched::JobPriority::Low;
+    if ( m_snapshot_job != 0 && m_scheduler->IsQueued( m_snapshot_job ) )
+    {
+        if ( ++m_snapshot_intervals_skipped < SNAPSHOT_MAX_SKIPPED_INTERVALS )
+            return;
+        m_scheduler->Cancel( m_snapshot_job );
+        priority = shm::sched::JobPriority::Normal;
+    }
+    m_snapshot_intervals_skipped = 0;
+
+    // Copying the world happens on the tick thread, a range of entities per step. The writer thread encodes and writes it.
+    m_snapshot_job = m_scheduler->Submit( { .m_name = "journal-snapshot", .m_priority = priority },
+                                          [ this ]()
+                                          {
+                                              if ( !m_journal->SnapshotInProgress() )
+                                                  m_journal->BeginSnapshot();
+                                              return m_journal->ContinueSnapshot( SNAPSHOT_STEP_IDS ) ? shm::sched::StepResult::Done
+                                                                                                      : shm::sched::StepResult::Continue;
+                                          } );
+}
+
+void wb::Application::RejectSessions( std::span< const uint64_t > sessions )
+{
+    if ( sessions.empty() )
+        return;
+
+    const auto retry_after_ms = m_overload->Config().retry_after_ms;
+    std::vector< shm::net::ConnectionHandle > connections;
+    connections.reserve( sessions.size() );
+    for ( const auto session : sessions )
+        connections.push_back( shm::net::ConnectionHandle::Unpack( session ) );
+    // An overloaded broker sheds many sessions in the same tick, they all share one buffer holding the rejection.
+    m_gateway->Broadcast( connections, shm::net::msg::Rejected::Opcode, shm::wire::Encode( shm::net::msg::Rejected{ .retry_after_ms = retry_after_ms } ) );
+
+    // A UDP peer would otherwise be attached again by its next datagram, before it even got the rejection.
+    const auto refused_until = m_tick + ( static_cast< uint64_t >( retry_after_ms ) * TARGET_FPS + 999 ) / 1000;
+    for ( std::size_t i = 0; i < sessions.size(); ++i )
+    {
+        m_gateway->CloseAfterFlush( connections[ i ] );
+        if ( m_udp )
+            m_udp->Refuse( sessions[ i ], refused_until );
+    }
+}
+
+int wb::Application::RunMainLoop( shm::Config & cfg, uint64_t max_ticks )
+{
+    using Clock                 = std::chrono::steady_clock;
+    constexpr auto frame_budget = std::chrono::duration_cast< Clock::duration >( std::chrono::seconds( 1 ) ) / TARGET_FPS;
+
+    auto & registry      = shm::metrics::DefaultRegistry();
+    auto & tick_duration = registry.GetHistogram( "shm_tick_duration_ns" );
+    auto & ticks_total   = registry.GetCounter( "shm_ticks_total" );
+
+    TickStats tick_stats;
+    tick_stats.m_frame_budget_ns = static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( frame_budget ).count() );
+
+    auto next_frame = Clock::now();
+    auto last_frame = next_frame;
+    while ( !G_STOP_REQUESTED.load( std::memory_order_relaxed ) && ( max_ticks == 0 || m_tick < max_ticks ) )
+    {
+        const auto frame_start = Clock::now();
+        const auto delta_time  = std::chrono::duration< float >( frame_start - last_frame ).count();
+        last_frame             = frame_start;
+
+        if ( m_udp )
+            m_udp->Receive( m_tick + 1 );
+        if ( m_shm )
+        {
+            for ( auto & service : m_shm->Accept() )
+            {
+                // Reported to the tick as a new connection, PumpTransports closes it once the service goes away.
+                std::ignore = m_gateway->Attach( std::format( "shm:{}", service.m_pid ), m_tick + 1, std::move( service.m_transport ) );
+                SHM_LOG_INFO( "Service {} attached over shared memory", service.m_pid );
+            }
+        }
+        m_gateway->PumpTransports( m_tick + 1 );
+        // Shed before recording, the capture holds what the tick handled and replays without the controller.
+        const auto inbound_events = m_gateway->Inbound().Size();
+        RejectSessions( m_shedder->Apply( m_gateway->Inbound(), m_overload->Level(), m_tick + 1 ) );
+        if ( m_capture )
+        {
+            m_gateway->Inbound().ForEach( [ this ]( const shm::net::InboundEvent & event ) { m_capture->RecordInbound( m_tick + 1, event ); } );
+            m_capture->RecordTick( m_tick + 1, delta_time );
         }
+        StepTick( delta_time );
+        // What the tick queued goes out now rather than with the next pump, a tick later.
+        m_gateway->FlushTransports();
+        if ( m_udp )
+            m_udp->Flush( m_tick );
+        if ( m_capture && m_tick % CAPTURE_CHECKPOINT_INTERVAL_TICKS == 0 )
+            m_capture->RecordCheckpoint( m_tick, shm::replay::HashWorld( m_journal->CaptureState() ) );
+
+        const auto frame_ns = static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now() - frame_start ).count() );
+        tick_duration.Record( frame_ns );
+        ticks_total.Increment();
+        shm::flight::RecordFrame( m_tick, frame_ns );
+
+        const auto previous_level = m_overload->Level();
+        if ( const auto level = m_overload->Observe( frame_ns, inbound_events ); level > previous_level )
+            SHM_LOG_WARN( "Broker overloaded, shedding load: {} -> {}", magic_enum::enum_name( previous_level ), magic_enum::enum_name( level ) );
+        else if ( level < previous_level )
+            SHM_LOG_INFO( "Broker recovering, shedding less load: {} -> {}", magic_enum::enum_name( previous_level ), magic_enum::enum_name( level ) );
+
+        tick_stats.m_tick          = m_tick;
+        tick_stats.m_last_frame_ns = frame_ns;
+        tick_stats.m_connections   = m_gateway->ConnectionCount();
+        tick_stats.m_sessions      = m_inbound->SessionCount();
+        ++tick_stats.m_frame_histogram[ RuntimeStatsBoard::FrameHistogramBucket( frame_ns, tick_stats.m_frame_budget_ns ) ];
+        m_stats_board->PublishTick( tick_stats );
+        m_stats_board->AddWorkerBusyTime( m_tick_worker, frame_ns );
+        m_crash_handler->Context().PublishTick( {
+            .m_unix_ms         = std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::system_clock::now().time_since_epoch() ).count(),
+            .m_tick            = m_tick,
+            .m_last_frame_ns   = frame_ns,
+            .m_frame_budget_ns = tick_stats.m_frame_budget_ns,
+            .m_connections     = tick_stats.m_connections,
+        } );
+
+        if ( shm::trace::ConsumeDumpRequest() )
+            DumpTrace();
+
+        if ( m_handoff && m_handoff->PollSuccessor() && HandOver() )
+            break;
+
+        if ( m_tick % CONFIG_RELOAD_INTERVAL_TICKS == 0 )
+            SubmitConfigSync( cfg );
+        if ( m_tick % SNAPSHOT_INTERVAL_TICKS == 0 )
+            SubmitSnapshot();
+
+        // Late frames are not caught up on, the schedule restarts from now instead. That leaves no time for deferred jobs,
+        // the scheduler then runs a step every few frames regardless.
+        next_frame += frame_budget;
+        if ( next_frame < Clock::now() )
+            next_frame = Clock::now();
+        m_scheduler->RunUntil( next_frame, m_overload->Level() >= shm::overload::OverloadLevel::DeferredSystems ? shm::sched::JobPriority::Normal
+                                                                                                             : shm::sched::JobPriority::Low );
+        std::this_thread::sleep_until( next_frame );
     }
 
+    SHM_LOG_INFO( "Main loop stopped after {} ticks", m_tick );
     return 0;
 }
 
-bool wb::Application::InitializeLoggingSystem()
+bool wb::Application::InitializeLoggingSystem( bool enable_stderr )
 {
 
     shm::LoggerSettings logger_settings{
         .m_log_file_name       = "worldbroker.log",
         .m_log_file_path       = "./logs/",
         .m_max_file_size_bytes = 1024 * 1024 * 5,
-        .m_max_files           = 5,
+        .m_max_files           = 20,
         .m_rotate_on_open      = true,
+        .m_max_total_bytes     = 1024 * 1024 * 64,
+        .m_compress_rotated    = true,
         .m_create_directories  = true,
         .m_logger_name         = "worldbroker",
         .m_level               = spdlog::level::debug,
         .m_flush_level         = spdlog::level::info,
         .m_log_pattern         = R"([%Y-%m-%d %H:%M:%S.%e] [%l@thread:%t] %*%v)",
-        .m_enable_stderr       = true,
+        .m_enable_stderr       = enable_stderr,
 #ifdef _WIN32
         .m_enable_msvc = true,
 #endif
     };
+    // Installed after the crash handler, which it passes fatal signals on to.
+    logger_settings.m_dump_flight_recorder_on_crash = true;
+    logger_settings.m_extra_sinks.push_back( MakeWarningSink( *m_stats_board ) );
+    if ( m_crash_handler )
+        logger_settings.m_extra_sinks.push_back( fs::MakeCrashContextSink( m_crash_handler->Context() ) );
 
     m_logger = std::make_unique< shm::Logger >( std::move( logger_settings ) );
 
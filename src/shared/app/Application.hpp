@@ -1,13 +1,63 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string>
 #include <thread>
 
 namespace shm
 {
+    struct Config;
     struct Logger;
 }
 
+namespace shm::handoff
+{
+    struct Handoff;
+    class HandoffListener;
+} // namespace shm::handoff
+
+namespace shm::net
+{
+    class Gateway;
+    class SessionDirectory;
+    class ShmListener;
+    class UdpServer;
+    struct UdpSettings;
+} // namespace shm::net
+
+namespace shm::journal
+{
+    class WorldJournal;
+}
+
+namespace shm::overload
+{
+    class LoadShedder;
+    class OverloadController;
+} // namespace shm::overload
+
+namespace shm::replay
+{
+    class CaptureWriter;
+}
+
+namespace shm::sched
+{
+    class FrameScheduler;
+}
+
+namespace shm::worlds
+{
+    class WorldCluster;
+}
+
+namespace fs
+{
+    struct CrashHandler;
+}
+
 namespace flecs
 {
     struct world;
@@ -15,6 +65,9 @@ namespace flecs
 
 namespace wb
 {
+    class InboundHandler;
+    class RuntimeStatsBoard;
+
     class Application
     {
     public:
@@ -29,10 +82,63 @@ namespace wb
         int Run( int argc, char * argv[] );
 
     protected:
-        bool InitializeLoggingSystem();
+        bool InitializeLoggingSystem( bool enable_stderr );
+        void RegisterBuiltinMetrics();
+        int RunMainLoop( shm::Config & cfg, uint64_t max_ticks );
+        /// @brief Queues reloading configs edited on disk and saving the ones changed in memory as deferred work.
+        void SubmitConfigSync( shm::Config & cfg );
+        /// @brief Queues a journal snapshot as deferred work, unless the previous one is still waiting.
+        /// One that waited for several intervals is raised to normal priority instead.
+        void SubmitSnapshot();
+        /// @brief Tells the peers of the given sessions to come back later and closes their connections.
+        void RejectSessions( std::span< const uint64_t > sessions );
+        /// @brief Feeds a capture through the tick without sockets or frame pacing and compares its checkpoints.
+        int RunReplay( const std::string & capture_file, const std::string & journal_directory );
+        /// @brief Hands the UDP sockets and sessions to the successor waiting on the handoff socket.
+        /// @return True once the successor took over, the main loop stops then.
+        bool HandOver();
+        /// @brief Carries on with the sockets and sessions a predecessor handed over, before the first tick.
+        bool ResumeSessions( shm::handoff::Handoff & handoff, const shm::net::UdpSettings & udp_settings );
+        /// @brief Hands the inbound events to the world, runs the world and commits the tick to the journal.
+        void StepTick( float delta_time );
+        void DumpTrace() const;
 
     private:
         std::unique_ptr< flecs::world > m_broker_world;
+        std::unique_ptr< fs::CrashHandler > m_crash_handler;
+        /// @brief Declared before the logger, whose warning sink writes into it until the logger is gone.
+        std::unique_ptr< RuntimeStatsBoard > m_stats_board;
         std::unique_ptr< shm::Logger > m_logger;
+        std::unique_ptr< shm::net::Gateway > m_gateway;
+        /// @brief The sessions of the inbound handler, for lookups from other threads. Declared before the handler.
+        std::unique_ptr< shm::net::SessionDirectory > m_session_directory;
+        /// @brief Only set when peers may connect over UDP, declared after the gateway it attaches them to.
+        std::unique_ptr< shm::net::UdpServer > m_udp;
+        /// @brief Only set when co-located services may attach over shared memory, see RunMainLoop.
+        std::unique_ptr< shm::net::ShmListener > m_shm;
+        /// @brief Declared after the world it writes into.
+        std::unique_ptr< shm::journal::WorldJournal > m_journal;
+        std::unique_ptr< InboundHandler > m_inbound;
+        /// @brief The hosted worlds, each on its own thread, with the broker world as their coordinator. Not set for replays,
+        /// which only reproduce the broker world.
+        std::unique_ptr< shm::worlds::WorldCluster > m_worlds;
+        /// @brief Only set while recording a capture.
+        std::unique_ptr< shm::replay::CaptureWriter > m_capture;
+        /// @brief Work that runs in the time left over after the tick, see RunMainLoop.
+        std::unique_ptr< shm::sched::FrameScheduler > m_scheduler;
+        /// @brief The config sync job submitted last, see SubmitConfigSync.
+        uint64_t m_config_sync_job = 0;
+        /// @brief The snapshot job submitted last, see SubmitSnapshot.
+        uint64_t m_snapshot_job = 0;
+        /// @brief Intervals the snapshot job has been waiting for, see SubmitSnapshot.
+        uint32_t m_snapshot_intervals_skipped = 0;
+        /// @brief Pick the overload level from the frame times and shed inbound load accordingly, see RunMainLoop.
+        std::unique_ptr< shm::overload::OverloadController > m_overload;
+        std::unique_ptr< shm::overload::LoadShedder > m_shedder;
+        /// @brief Only set when a successor may take over, see HandOver.
+        std::unique_ptr< shm::handoff::HandoffListener > m_handoff;
+        std::size_t m_tick_worker = 0;
+        uint64_t m_tick           = 0;
+        std::string m_trace_file  = "./traces/worldbroker.trace.json";
     };
 } // namespace wb
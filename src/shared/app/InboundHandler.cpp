@@ -0,0 +1,180 @@
+#include "InboundHandler.hpp"
+
+#include "journal/Journal.hpp"
+
+#include "net/Messages.hpp"
+#include "net/SessionDirectory.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <utility>
+
+namespace
+{
+    /// @brief Applies the messages of one session to its entity.
+    struct SessionMessages
+    {
+        shm::journal::WorldJournal & m_journal;
+        uint64_t m_session;
+        uint64_t m_entity;
+        uint32_t & m_world_id;
+
+        void On( const shm::net::msg::Move & message )
+        {
+            m_journal.Submit( shm::journal::WorldCommand::Set( m_entity, shm::journal::Transform{ message.x, message.y, message.z } ) );
+        }
+
+        void On( const shm::net::msg::SetWorld & message )
+        {
+            m_world_id = message.world_id;
+            m_journal.Submit( shm::journal::WorldCommand::Set( m_entity, shm::journal::Presence{ .session_id = m_session, .world_id = message.world_id } ) );
+        }
+    };
+
+    using MessageDispatcher = shm::wire::Dispatcher< SessionMessages, shm::net::msg::Move, shm::net::msg::SetWorld >;
+} // namespace
+
+wb::InboundHandler::InboundHandler( shm::journal::WorldJournal & journal, uint64_t idle_timeout_ticks, uint64_t tick )
+    : m_journal( journal )
+    , m_idle_timers( tick )
+    , m_idle_timeout_ticks( idle_timeout_ticks )
+{
+}
+
+void wb::InboundHandler::Adopt( const shm::journal::WorldSnapshot & state )
+{
+    for ( const auto & entity : state.entities )
+    {
+        if ( entity.presence )
+            Track( entity.presence->session_id, entity.id, entity.presence->world_id );
+    }
+}
+
+std::vector< uint64_t > wb::InboundHandler::Resume( std::span< const shm::net::SessionRename > sessions )
+{
+    std::vector< std::pair< uint64_t, Session > > resumed;
+    std::vector< uint64_t > unknown;
+    for ( const auto & rename : sessions )
+    {
+        auto session = m_sessions.extract( rename.m_from );
+        if ( session.empty() )
+        {
+            unknown.push_back( rename.m_to );
+            continue;
+        }
+        m_idle_timers.Cancel( session.mapped().m_idle_timer );
+        if ( m_directory != nullptr )
+            m_directory->Withdraw( rename.m_from );
+        resumed.emplace_back( rename.m_to, session.mapped() );
+    }
+
+    // Whatever still holds one of the new ids is a session whose peer did not come along.
+    for ( const auto session : unknown )
+        Drop( session );
+    for ( const auto & [ session, state ] : resumed )
+    {
+        Drop( session );
+        Track( session, state.m_entity, state.m_world_id );
+        m_journal.Submit( shm::journal::WorldCommand::Set( state.m_entity, shm::journal::Presence{ .session_id = session, .world_id = state.m_world_id } ) );
+    }
+    return unknown;
+}
+
+void wb::InboundHandler::MirrorInto( shm::net::SessionDirectory & directory )
+{
+    m_directory = &directory;
+    for ( const auto & [ session, state ] : m_sessions )
+        m_directory->Publish( session, { .m_entity = state.m_entity, .m_world_id = state.m_world_id } );
+}
+
+void wb::InboundHandler::Handle( const shm::net::InboundEvent & event )
+{
+    using shm::journal::WorldCommand;
+
+    switch ( event.m_type )
+    {
+    case shm::net::InboundType::Connected:
+    {
+        if ( m_sessions.contains( event.m_session ) )
+            return;
+
+        const auto entity = m_journal.AllocateEntityId();
+        Track( event.m_session, entity, 0 );
+        m_journal.Submit( WorldCommand::Spawn( entity ) );
+        m_journal.Submit( WorldCommand::Set( entity, shm::journal::Presence{ .session_id = event.m_session } ) );
+        return;
+    }
+    case shm::net::InboundType::Disconnected:
+    {
+        Drop( event.m_session );
+        return;
+    }
+    case shm::net::InboundType::Message:
+    {
+        auto iter = m_sessions.find( event.m_session );
+        if ( iter == m_sessions.end() )
+        {
+            ++m_ignored_messages;
+            return;
+        }
+
+        if ( m_idle_timeout_ticks != 0 )
+            m_idle_timers.Reschedule( iter->second.m_idle_timer, IdleDeadline() );
+
+        auto & state                  = iter->second;
+        const uint32_t previous_world = state.m_world_id;
+        SessionMessages messages{ m_journal, event.m_session, state.m_entity, state.m_world_id };
+        if ( MessageDispatcher::DispatchFrame( messages, event.m_payload ) != shm::wire::DispatchResult::Handled )
+            ++m_ignored_messages;
+        if ( m_directory != nullptr && state.m_world_id != previous_world )
+            m_directory->Publish( event.m_session, { .m_entity = state.m_entity, .m_world_id = state.m_world_id } );
+        return;
+    }
+    }
+}
+
+void wb::InboundHandler::ExpireIdle( uint64_t tick )
+{
+    m_idle_timers.Advance( tick,
+                           [ this ]( uint64_t session )
+                           {
+                               auto iter = m_sessions.find( session );
+                               if ( iter == m_sessions.end() )
+                                   return;
+
+                               if ( m_directory != nullptr )
+                                   m_directory->Withdraw( session );
+                               m_journal.Submit( shm::journal::WorldCommand::Destroy( iter->second.m_entity ) );
+                               m_sessions.erase( iter );
+                               ++m_timed_out_sessions;
+                           } );
+}
+
+void wb::InboundHandler::Track( uint64_t session, uint64_t entity, uint32_t world_id )
+{
+    auto & state     = m_sessions[ session ];
+    state.m_entity   = entity;
+    state.m_world_id = world_id;
+    if ( m_idle_timeout_ticks != 0 && !m_idle_timers.Reschedule( state.m_idle_timer, IdleDeadline() ) )
+        state.m_idle_timer = m_idle_timers.Schedule( IdleDeadline(), session );
+    if ( m_directory != nullptr )
+        m_directory->Publish( session, { .m_entity = entity, .m_world_id = world_id } );
+}
+
+uint64_t wb::InboundHandler::IdleDeadline() const noexcept
+{
+    // Events are handled before ExpireIdle moves the wheel to their tick, which is the one after Now().
+    return m_idle_timers.Now() + 1 + m_idle_timeout_ticks;
+}
+
+void wb::InboundHandler::Drop( uint64_t session )
+{
+    auto iter = m_sessions.find( session );
+    if ( iter == m_sessions.end() )
+        return;
+
+    m_idle_timers.Cancel( iter->second.m_idle_timer );
+    if ( m_directory != nullptr )
+        m_directory->Withdraw( session );
+    m_journal.Submit( shm::journal::WorldCommand::Destroy( iter->second.m_entity ) );
+    m_sessions.erase( iter );
+}
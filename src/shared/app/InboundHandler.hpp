@@ -0,0 +1,85 @@
+#pragma once
+
+#include "journal/WorldCommands.hpp"
+#include "net/Inbox.hpp"
+#include "threading/TimingWheel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace shm::journal
+{
+    class WorldJournal;
+}
+
+namespace shm::net
+{
+    class SessionDirectory;
+}
+
+namespace wb
+{
+    /// @brief Turns inbound peer events into world commands. A connecting session gets an entity carrying its presence,
+    /// its messages (see net/Messages.hpp) move it around and disconnecting or going quiet for too long destroys it. The outcome only depends on the world state it started
+    /// from and the events in order, which is what makes captures replay bit for bit.
+    class InboundHandler
+    {
+    public:
+        /// @param idle_timeout_ticks Ticks without a message after which a session is dropped, 0 keeps sessions forever.
+        /// @param tick The last tick that ran, the next events belong to the one after it.
+        explicit InboundHandler( shm::journal::WorldJournal & journal, uint64_t idle_timeout_ticks = 0, uint64_t tick = 0 );
+
+        /// @brief Picks up the sessions of entities the world already holds, after a recovery or a restore.
+        void Adopt( const shm::journal::WorldSnapshot & state );
+        /// @brief Moves sessions and their entities to new session ids, e.g. once their peers were handed over from another
+        /// process. All in one go, a new id may well be the old id of another session.
+        /// @return The new ids of the sessions that were unknown.
+        std::vector< uint64_t > Resume( std::span< const shm::net::SessionRename > sessions );
+        /// @brief Publishes the sessions into the directory and keeps it in step with them from now on.
+        void MirrorInto( shm::net::SessionDirectory & directory );
+        void Handle( const shm::net::InboundEvent & event );
+        /// @brief Drops the sessions that went idle by the given tick, once per tick after its events were handled.
+        void ExpireIdle( uint64_t tick );
+
+        [[nodiscard]] std::size_t SessionCount() const noexcept
+        {
+            return m_sessions.size();
+        }
+
+        /// @brief Messages of unknown sessions and frames that are malformed or of an unknown opcode.
+        [[nodiscard]] uint64_t IgnoredMessages() const noexcept
+        {
+            return m_ignored_messages;
+        }
+
+        [[nodiscard]] uint64_t TimedOutSessions() const noexcept
+        {
+            return m_timed_out_sessions;
+        }
+
+    private:
+        struct Session
+        {
+            uint64_t m_entity   = 0;
+            uint32_t m_world_id = 0;
+            shm::TimerHandle m_idle_timer;
+        };
+
+        void Track( uint64_t session, uint64_t entity, uint32_t world_id );
+        void Drop( uint64_t session );
+        [[nodiscard]] uint64_t IdleDeadline() const noexcept;
+
+        shm::journal::WorldJournal & m_journal;
+        std::unordered_map< uint64_t, Session > m_sessions;
+        /// @brief Idle deadline per session, keyed by session id.
+        shm::TimingWheel< uint64_t > m_idle_timers;
+        /// @brief Only set while mirroring, see MirrorInto.
+        shm::net::SessionDirectory * m_directory = nullptr;
+        uint64_t m_idle_timeout_ticks = 0;
+        uint64_t m_ignored_messages   = 0;
+        uint64_t m_timed_out_sessions = 0;
+    };
+} // namespace wb
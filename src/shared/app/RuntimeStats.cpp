@@ -0,0 +1,99 @@
+#include "RuntimeStats.hpp"
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    class WarningSink final : public spdlog::sinks::base_sink< spdlog::details::null_mutex >
+    {
+    public:
+        explicit WarningSink( wb::RuntimeStatsBoard & board )
+            : m_board( board )
+        {
+            set_level( spdlog::level::warn );
+        }
+
+    protected:
+        void sink_it_( const spdlog::details::log_msg & msg ) override
+        {
+            const auto unix_ms = std::chrono::duration_cast< std::chrono::milliseconds >( msg.time.time_since_epoch() ).count();
+            m_board.PushWarning( std::string_view( msg.payload.data(), msg.payload.size() ), static_cast< int32_t >( msg.level ), unix_ms );
+        }
+
+        void flush_() override
+        {
+        }
+
+    private:
+        wb::RuntimeStatsBoard & m_board;
+    };
+} // namespace
+
+std::size_t wb::RuntimeStatsBoard::FrameHistogramBucket( uint64_t frame_ns, uint64_t budget_ns ) noexcept
+{
+    if ( budget_ns == 0 )
+        return FRAME_HISTOGRAM_BUCKETS - 1;
+
+    const uint64_t percent = frame_ns * 100 / budget_ns;
+    const auto iter        = std::ranges::lower_bound( FRAME_HISTOGRAM_BOUNDS_PERCENT, percent );
+    return static_cast< std::size_t >( iter - FRAME_HISTOGRAM_BOUNDS_PERCENT.begin() );
+}
+
+std::size_t wb::RuntimeStatsBoard::RegisterWorker( std::string_view name ) noexcept
+{
+    const auto index = m_next_worker.fetch_add( 1, std::memory_order_relaxed );
+    if ( index >= MaxWorkers )
+        return InvalidWorker;
+
+    auto & worker        = m_workers[ index ];
+    worker.m_name_length = static_cast< uint32_t >( std::min( name.size(), worker.m_name.size() ) );
+    std::copy_n( name.data(), worker.m_name_length, worker.m_name.data() );
+
+    // Publish in registration order so a reader never sees a worker whose name is still being written.
+    std::size_t expected = index;
+    while ( !m_worker_count.compare_exchange_weak( expected, index + 1, std::memory_order_release, std::memory_order_relaxed ) )
+        expected = index;
+
+    return index;
+}
+
+std::string_view wb::RuntimeStatsBoard::WorkerName( std::size_t worker ) const noexcept
+{
+    if ( worker >= WorkerCount() )
+        return {};
+
+    return { m_workers[ worker ].m_name.data(), m_workers[ worker ].m_name_length };
+}
+
+void wb::RuntimeStatsBoard::PushWarning( std::string_view text, int32_t level, int64_t unix_ms ) noexcept
+{
+    WarningLine line;
+    line.m_unix_ms = unix_ms;
+    line.m_level   = level;
+    line.m_length  = static_cast< uint32_t >( std::min( text.size(), line.m_text.size() ) );
+    std::copy_n( text.data(), line.m_length, line.m_text.data() );
+
+    const auto slot = m_warnings_pushed.fetch_add( 1, std::memory_order_acq_rel ) % WarningCapacity;
+    m_warnings[ slot ].Store( line );
+}
+
+std::vector< wb::WarningLine > wb::RuntimeStatsBoard::RecentWarnings() const
+{
+    const auto pushed = m_warnings_pushed.load( std::memory_order_acquire );
+    const auto count  = std::min< uint64_t >( pushed, WarningCapacity );
+
+    std::vector< WarningLine > lines;
+    lines.reserve( count );
+    for ( uint64_t i = 0; i < count; ++i )
+        lines.push_back( m_warnings[ ( pushed - 1 - i ) % WarningCapacity ].Load() );
+    return lines;
+}
+
+std::shared_ptr< spdlog::sinks::sink > wb::MakeWarningSink( RuntimeStatsBoard & board )
+{
+    return std::make_shared< WarningSink >( board );
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "threading/SeqLock.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace spdlog::sinks
+{
+    class sink;
+}
+
+namespace wb
+{
+    /// @brief Upper bounds of the frame time histogram buckets in percent of the frame budget, the last bucket is open ended.
+    constexpr std::array< uint32_t, 9 > FRAME_HISTOGRAM_BOUNDS_PERCENT{ 25, 50, 75, 100, 125, 150, 200, 300, 500 };
+    constexpr std::size_t FRAME_HISTOGRAM_BUCKETS = FRAME_HISTOGRAM_BOUNDS_PERCENT.size() + 1;
+
+    /// @brief Published by the tick thread once per tick. Counters are cumulative, consumers diff two loads.
+    struct TickStats
+    {
+        uint64_t m_tick            = 0;
+        uint64_t m_frame_budget_ns = 0;
+        uint64_t m_last_frame_ns   = 0;
+        uint64_t m_connections     = 0;
+        uint64_t m_sessions        = 0;
+        std::array< uint64_t, FRAME_HISTOGRAM_BUCKETS > m_frame_histogram{};
+    };
+
+    struct WarningLine
+    {
+        int64_t m_unix_ms = 0;
+        int32_t m_level   = 0;
+        uint32_t m_length = 0;
+        std::array< char, 240 > m_text{};
+
+        [[nodiscard]] std::string_view Text() const noexcept
+        {
+            return { m_text.data(), m_length };
+        }
+    };
+
+    /// @brief Lock-free exchange point between the broker threads and observers such as the terminal dashboard.
+    /// Writers only ever do relaxed atomic stores or a seqlock store, so observing never slows down the tick.
+    class RuntimeStatsBoard
+    {
+    public:
+        static constexpr std::size_t MaxWorkers      = 32;
+        static constexpr std::size_t WarningCapacity = 16;
+        static constexpr std::size_t InvalidWorker   = MaxWorkers;
+
+        void PublishTick( const TickStats & stats ) noexcept
+        {
+            m_tick.Store( stats );
+        }
+
+        [[nodiscard]] TickStats LoadTick() const noexcept
+        {
+            return m_tick.Load();
+        }
+
+        static std::size_t FrameHistogramBucket( uint64_t frame_ns, uint64_t budget_ns ) noexcept;
+        /// @brief Buckets from this one on hold frames that overran their budget.
+        static constexpr std::size_t FirstOverBudgetBucket =
+            static_cast< std::size_t >( std::ranges::find( FRAME_HISTOGRAM_BOUNDS_PERCENT, 100u ) - FRAME_HISTOGRAM_BOUNDS_PERCENT.begin() ) + 1;
+
+        /// @brief Registers a thread whose busy time is reported through AddWorkerBusyTime.
+        /// @return Worker index or InvalidWorker once MaxWorkers are registered.
+        std::size_t RegisterWorker( std::string_view name ) noexcept;
+
+        void AddWorkerBusyTime( std::size_t worker, uint64_t busy_ns ) noexcept
+        {
+            if ( worker < MaxWorkers )
+                m_workers[ worker ].m_busy_ns.fetch_add( busy_ns, std::memory_order_relaxed );
+        }
+
+        [[nodiscard]] std::size_t WorkerCount() const noexcept
+        {
+            return m_worker_count.load( std::memory_order_acquire );
+        }
+
+        [[nodiscard]] std::string_view WorkerName( std::size_t worker ) const noexcept;
+
+        /// @return Cumulative busy time of the worker in nanoseconds.
+        [[nodiscard]] uint64_t WorkerBusyNs( std::size_t worker ) const noexcept
+        {
+            return worker < MaxWorkers ? m_workers[ worker ].m_busy_ns.load( std::memory_order_relaxed ) : 0;
+        }
+
+        void PushWarning( std::string_view text, int32_t level, int64_t unix_ms ) noexcept;
+
+        /// @return Up to WarningCapacity most recent warnings, newest first.
+        [[nodiscard]] std::vector< WarningLine > RecentWarnings() const;
+
+    private:
+        struct Worker
+        {
+            std::atomic< uint64_t > m_busy_ns{ 0 };
+            std::array< char, 32 > m_name{};
+            uint32_t m_name_length = 0;
+        };
+
+        shm::SeqLock< TickStats > m_tick;
+
+        std::array< Worker, MaxWorkers > m_workers{};
+        std::atomic< std::size_t > m_worker_count{ 0 };
+        std::atomic< std::size_t > m_next_worker{ 0 };
+
+        std::array< shm::SeqLock< WarningLine >, WarningCapacity > m_warnings{};
+        std::atomic< uint64_t > m_warnings_pushed{ 0 };
+    };
+
+    /// @brief spdlog sink forwarding warnings and errors to the board.
+    std::shared_ptr< spdlog::sinks::sink > MakeWarningSink( RuntimeStatsBoard & board );
+} // namespace wb
@@ -1,6 +1,7 @@
 
 #include "Config.hpp"
 #include "filesystem/Filesystem.hpp"
+#include "metrics/Metrics.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -28,12 +29,16 @@ shm::Result< void > shm::Config::IsDirectoryCreated() const
 
 std::vector< shm::Result< void > > shm::Config::SaveDirtyConfigs()
 {
+    static auto & save_duration = shm::metrics::DefaultRegistry().GetHistogram( "shm_config_save_duration_ns",
+                                                                                "Time spent applying and persisting a single config" );
+
     std::vector< shm::Result< void > > results;
     for ( auto & cfg_obj : m_configs )
     {
         if ( !cfg_obj )
             continue;
 
+        shm::metrics::ScopedTimer timer{ save_duration };
         auto pending_result = cfg_obj->m_impl->ApplyPendingUpdate();
         if ( !pending_result.has_value() )
         {
@@ -46,6 +51,30 @@ std::vector< shm::Result< void > > shm::Config::SaveDirtyConfigs()
     return results;
 }
 
+std::vector< shm::Result< void > > shm::Config::ReloadChangedConfigs()
+{
+    std::vector< shm::Result< void > > results;
+    for ( auto & cfg_obj : m_configs )
+    {
+        if ( !cfg_obj )
+            continue;
+
+        auto reload_result = cfg_obj->m_impl->ReloadIfChanged();
+        if ( !reload_result.has_value() )
+        {
+            results.emplace_back( std::unexpected( reload_result.error() ) );
+            continue;
+        }
+        if ( !*reload_result )
+            continue;
+
+        for ( const auto & callback : cfg_obj->m_reload_callbacks )
+            callback();
+        results.emplace_back( shm::Result< void >{} );
+    }
+    return results;
+}
+
 /** CONFIG OBJECT **/
 
 std::type_index shm::ConfigObject::Type() const noexcept
@@ -3,14 +3,17 @@
 
 #include <concepts>
 #include <cstdio>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <ranges>
 #include <string>
 #include <thread>
 #include <type_traits>
 #include <typeindex>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include <fmt/format.h>
@@ -31,6 +34,71 @@ namespace shm
     concept IsVersionMigratorFnPtr =
         std::is_same_v< Fn, shm::Result< F > ( * )( std::string &, uint32_t, uint32_t ) >;
 
+    namespace detail
+    {
+        /// @brief Structs that are diffed and merged field by field, anything else is compared as a whole.
+        template< typename T >
+        concept IsFieldwiseStruct = std::is_class_v< T > && std::is_aggregate_v< T > && !std::ranges::range< T >;
+
+        template< std::size_t I, typename OnField, typename... Values >
+        void VisitField( OnField & on_field, const Values &... values )
+        {
+            on_field( *std::get< I >( values )... );
+        }
+
+        template< typename OnField, std::size_t... I, typename... Values >
+        void VisitFields( OnField & on_field, std::index_sequence< I... >, const Values &... values )
+        {
+            ( VisitField< I >( on_field, values... ), ... );
+        }
+
+        /// @brief Calls on_field with the matching fields of all structs, in declaration order.
+        template< typename OnField, typename First, typename... Rest >
+        void ForEachField( OnField && on_field, First & first, Rest &... rest )
+        {
+            using Values = std::remove_cvref_t< decltype( rfl::to_view( first ).values() ) >;
+            VisitFields( on_field, std::make_index_sequence< std::tuple_size_v< Values > >{}, rfl::to_view( first ).values(), rfl::to_view( rest ).values()... );
+        }
+
+        template< typename T >
+        [[nodiscard]] bool FieldEquals( const T & lhs, const T & rhs )
+        {
+            if constexpr ( std::equality_comparable< T > )
+                return lhs == rhs;
+            else if constexpr ( IsFieldwiseStruct< T > )
+            {
+                bool equal = true;
+                ForEachField( [ &equal ]< typename F >( const F & lhs_field, const F & rhs_field ) { equal = equal && FieldEquals( lhs_field, rhs_field ); }, lhs, rhs );
+                return equal;
+            }
+            else
+                return rfl::json::write( lhs ) == rfl::json::write( rhs );
+        }
+
+        /// @brief Copies every field edited changed relative to original into target, nested structs field by field,
+        /// so edits made to other fields of target in the meantime survive.
+        /// @return Whether any field was copied.
+        template< typename T >
+        bool MergeChangedFields( const T & original, const T & edited, T & target )
+        {
+            if constexpr ( IsFieldwiseStruct< T > )
+            {
+                bool changed = false;
+                ForEachField( [ &changed ]< typename F >( const F & original_field, const F & edited_field, F & target_field )
+                              { changed = MergeChangedFields( original_field, edited_field, target_field ) || changed; },
+                              original, edited, target );
+                return changed;
+            }
+            else
+            {
+                if ( FieldEquals( original, edited ) )
+                    return false;
+                target = edited;
+                return true;
+            }
+        }
+    } // namespace detail
+
     struct ConfigObject
     {
         friend struct Config;
@@ -55,8 +123,13 @@ namespace shm
             virtual std::type_index Type() const noexcept                                           = 0;
             [[nodiscard]] virtual void * DataPtr() noexcept                                         = 0;
             [[nodiscard]] virtual const void * DataPtr() const noexcept                             = 0;
-            virtual void SetPendingUpdate( void * new_data )                                        = 0;
-            virtual shm::Result< void > ApplyPendingUpdate()                                        = 0;
+            /// @brief Merges the fields edited changed relative to original into the pending update.
+            virtual void MergePendingUpdate( const void * original, const void * edited ) = 0;
+            /// @brief Persists the pending update, unless it ended up equal to the current config.
+            virtual shm::Result< void > ApplyPendingUpdate() = 0;
+            /// @brief Re-reads the file if it was modified since it was last loaded or saved.
+            /// @return Whether the config changed. A file that fails to parse leaves the config untouched.
+            [[nodiscard]] virtual shm::Result< bool > ReloadIfChanged() = 0;
 
             template< IsConfigStructure Cfg, typename Self >
             [[nodiscard]] auto Get( this Self & self ) -> decltype( auto )
@@ -86,6 +159,7 @@ namespace shm
 
             [[nodiscard]] shm::Result< void > Init() override
             {
+                RefreshWriteTime();
                 auto json_data_res = shm::fs::ReadFileToString( m_config_full_path ).value_or( {} );
                 if ( !json_data_res.empty() )
                 {
@@ -130,18 +204,23 @@ namespace shm
                 return ConfigT::ConfigVersion;
             }
 
-            void SetPendingUpdate( void * new_data ) override
+            void MergePendingUpdate( const void * original, const void * edited ) override
             {
-                if ( !new_data )
+                if ( !original || !edited )
                     return;
 
-                auto config_t = static_cast< ConfigT * >( new_data );
+                const auto & original_config = *static_cast< const ConfigT * >( original );
+                const auto & edited_config   = *static_cast< const ConfigT * >( edited );
 
                 std::scoped_lock lock( m_access_lock );
                 if ( !m_config_update )
-                    m_config_update = std::make_unique< ConfigT >();
+                {
+                    if ( detail::FieldEquals( original_config, edited_config ) )
+                        return;
+                    m_config_update = std::make_unique< ConfigT >( m_config );
+                }
 
-                *m_config_update = std::move( *config_t );
+                detail::MergeChangedFields( original_config, edited_config, *m_config_update );
             }
 
             shm::Result< void > ApplyPendingUpdate() override
@@ -153,6 +232,9 @@ namespace shm
                         return {};
 
                     local_update = std::exchange( m_config_update, nullptr );
+                    // Edits that reverted each other leave nothing to write.
+                    if ( detail::FieldEquals( *local_update, m_config ) )
+                        return {};
                 }
 
                 try
@@ -167,15 +249,45 @@ namespace shm
                     return std::unexpected( std::make_error_code( std::errc::io_error ) );
                 }
 
+                RefreshWriteTime();
                 m_config = std::move( *local_update );
                 return {};
             }
 
+            [[nodiscard]] shm::Result< bool > ReloadIfChanged() override
+            {
+                std::error_code ec;
+                const auto write_time = std::filesystem::last_write_time( m_config_full_path, ec );
+                if ( ec || write_time == m_last_write_time )
+                    return false;
+
+                // Remembered even if parsing fails, a broken file is reported once rather than on every poll.
+                m_last_write_time = write_time;
+                auto json_data    = shm::fs::ReadFileToString( m_config_full_path );
+                if ( !json_data.has_value() )
+                    return std::unexpected( json_data.error() );
+
+                rfl::Result< ConfigT > value = rfl::json::read< ConfigT >( *json_data );
+                if ( !value )
+                    return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+
+                std::scoped_lock lock( m_access_lock );
+                m_config = std::move( *value );
+                return true;
+            }
+
         protected:
+            void RefreshWriteTime()
+            {
+                std::error_code ec;
+                m_last_write_time = std::filesystem::last_write_time( m_config_full_path, ec );
+            }
+
             ConfigT m_config;
             std::string m_config_full_path;
             std::string m_config_file_name;
             std::unique_ptr< ConfigT > m_config_update = nullptr;
+            std::filesystem::file_time_type m_last_write_time{};
         };
 
         template< IsConfigStructure Cfg, typename Self >
@@ -188,8 +300,12 @@ namespace shm
 
     private:
         std::unique_ptr< IConfig > m_impl;
+        std::vector< std::function< void() > > m_reload_callbacks;
     };
 
+    /// @brief Copy of a config, written back when it goes out of scope. Mutable accessors remember the config they
+    /// started from, only the fields that differ from it are merged into the pending update, so accessors that merely
+    /// read or change different fields do not overwrite each other and unchanged configs are not written to disk.
     template< IsConfigStructure Cfg >
     struct ConfigAccessor
     {
@@ -206,6 +322,7 @@ namespace shm
                                  std::string_view config_name ) noexcept
             : m_config_object( config_object )
             , m_cfg_copy( std::forward< Cfg >( cfg_copy ) )
+            , m_original( TakeSnapshot( m_cfg_copy ) )
             , m_config_name( config_name )
         {
         }
@@ -244,8 +361,19 @@ namespace shm
     protected:
         friend struct Config;
 
+        using Snapshot = std::conditional_t< std::is_const_v< Cfg >, std::monostate, Cfg >;
+
+        static Snapshot TakeSnapshot( const Cfg & cfg )
+        {
+            if constexpr ( std::is_const_v< Cfg > )
+                return {};
+            else
+                return cfg;
+        }
+
         ConfigObject * m_config_object = nullptr;
         Cfg m_cfg_copy                 = {};
+        Snapshot m_original            = {};
         std::string_view m_config_name = "";
         bool m_needs_synchro           = false;
     };
@@ -309,6 +437,36 @@ namespace shm
             return init_result;
         }
 
+        /// @brief Calls on_reload with a copy of the config every time ReloadChangedConfigs picked up a change of its file.
+        template< IsConfigStructure Cfg >
+        shm::Result< void > Subscribe( std::string_view config_name, std::function< void( const Cfg & ) > on_reload )
+        {
+            auto config_iter = std::ranges::find_if( m_configs,
+                                                     [ config_name ]( const std::unique_ptr< ConfigObject > & obj )
+                                                     {
+                                                         return obj->Type() == std::type_index( typeid( Cfg ) ) && obj->m_impl->GetConfigFileName() == config_name;
+                                                     } );
+            if ( config_iter == m_configs.end() )
+                return std::unexpected( std::make_error_code( std::errc::no_such_file_or_directory ) );
+
+            ( *config_iter )->m_reload_callbacks.emplace_back(
+                [ config = config_iter->get(), on_reload = std::move( on_reload ) ]()
+                {
+                    Cfg copy;
+                    {
+                        std::scoped_lock lock( config->m_impl->m_access_lock );
+                        copy = *static_cast< const Cfg * >( config->m_impl->DataPtr() );
+                    }
+                    on_reload( copy );
+                } );
+            return {};
+        }
+
+        /// @brief Reloads every config whose file was modified on disk, e.g. by hand, and notifies its subscribers.
+        /// Call from main thread, cheap enough to poll every second or so.
+        /// @return One result per config that changed or failed to reload.
+        std::vector< shm::Result< void > > ReloadChangedConfigs();
+
         /// @brief Apply queued updates & persist each modified config to disk.
         /// Call from main thread.
         /// @return Num of configs that were dirty and were saved.
@@ -326,7 +484,7 @@ namespace shm
         if constexpr ( !std::is_const_v< Cfg > )
         {
             if ( m_needs_synchro && m_config_object )
-                m_config_object->m_impl->SetPendingUpdate( &m_cfg_copy );
+                m_config_object->m_impl->MergePendingUpdate( &m_original, &m_cfg_copy );
         }
     }
 
@@ -0,0 +1,106 @@
+#include "CrashContext.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    class CrashContextSink final : public spdlog::sinks::base_sink< spdlog::details::null_mutex >
+    {
+    public:
+        explicit CrashContextSink( fs::CrashContext & context )
+            : m_context( context )
+        {
+        }
+
+    protected:
+        void sink_it_( const spdlog::details::log_msg & msg ) override
+        {
+            const auto unix_ms = std::chrono::duration_cast< std::chrono::milliseconds >( msg.time.time_since_epoch() ).count();
+            m_context.PushLogLine( std::string_view( msg.payload.data(), msg.payload.size() ), static_cast< int32_t >( msg.level ), unix_ms );
+        }
+
+        void flush_() override
+        {
+        }
+
+    private:
+        fs::CrashContext & m_context;
+    };
+
+    void AppendJsonString( std::string & out, std::string_view text )
+    {
+        out += '"';
+        for ( const char c : text )
+        {
+            switch ( c )
+            {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                default:
+                    if ( static_cast< unsigned char >( c ) < 0x20 )
+                        fmt::format_to( std::back_inserter( out ), "\\u{:04x}", static_cast< unsigned >( c ) );
+                    else
+                        out += c;
+            }
+        }
+        out += '"';
+    }
+} // namespace
+
+void fs::CrashContext::PushLogLine( std::string_view text, int32_t level, int64_t unix_ms ) noexcept
+{
+    CrashLogLine line;
+    line.m_unix_ms = unix_ms;
+    line.m_level   = level;
+    line.m_length  = static_cast< uint32_t >( std::min( text.size(), line.m_text.size() ) );
+    std::copy_n( text.data(), line.m_length, line.m_text.data() );
+
+    const auto slot = m_log_pushed.fetch_add( 1, std::memory_order_acq_rel ) % LogCapacity;
+    m_log[ slot ].Store( line );
+}
+
+std::string fs::CrashContext::ToJson( std::string_view version_data ) const
+{
+    std::string out = "{\n  \"version\": ";
+    AppendJsonString( out, version_data );
+
+    if ( const auto tick = m_tick.TryLoad() )
+    {
+        fmt::format_to( std::back_inserter( out ),
+                        ",\n  \"tick\": {{\"unix_ms\": {}, \"tick\": {}, \"last_frame_ns\": {}, \"frame_budget_ns\": {}, \"connections\": {}}}",
+                        tick->m_unix_ms, tick->m_tick, tick->m_last_frame_ns, tick->m_frame_budget_ns, tick->m_connections );
+    }
+
+    out += ",\n  \"log\": [";
+    const auto pushed = m_log_pushed.load( std::memory_order_acquire );
+    const auto count  = std::min< uint64_t >( pushed, LogCapacity );
+    bool first        = true;
+    for ( uint64_t i = pushed - count; i < pushed; ++i )
+    {
+        const auto line = m_log[ i % LogCapacity ].TryLoad();
+        if ( !line )
+            continue;
+
+        out += first ? "\n    " : ",\n    ";
+        first = false;
+        fmt::format_to( std::back_inserter( out ), "{{\"unix_ms\": {}, \"level\": {}, \"text\": ", line->m_unix_ms, line->m_level );
+        AppendJsonString( out, std::string_view( line->m_text.data(), std::min< std::size_t >( line->m_length, line->m_text.size() ) ) );
+        out += '}';
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+std::shared_ptr< spdlog::sinks::sink > fs::MakeCrashContextSink( CrashContext & context )
+{
+    return std::make_shared< CrashContextSink >( context );
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "threading/SeqLock.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace spdlog::sinks
+{
+    class sink;
+}
+
+namespace fs
+{
+    struct CrashLogLine
+    {
+        int64_t m_unix_ms = 0;
+        int32_t m_level   = 0;
+        uint32_t m_length = 0;
+        std::array< char, 240 > m_text{};
+    };
+
+    struct CrashTickStats
+    {
+        int64_t m_unix_ms          = 0;
+        uint64_t m_tick            = 0;
+        uint64_t m_last_frame_ns   = 0;
+        uint64_t m_frame_budget_ns = 0;
+        uint64_t m_connections     = 0;
+    };
+
+    /// @brief Recent log lines and tick statistics, kept where the crash dump writer can read them.
+    /// Only holds trivially copyable, lock-free state, so it can live in memory shared with the out-of-process
+    /// dump writer and be read while the writing process is stopped at an arbitrary point.
+    class CrashContext
+    {
+    public:
+        static constexpr std::size_t LogCapacity = 128;
+
+        void PushLogLine( std::string_view text, int32_t level, int64_t unix_ms ) noexcept;
+        void PublishTick( const CrashTickStats & stats ) noexcept
+        {
+            m_tick.Store( stats );
+        }
+
+        /// @brief Renders the context as JSON, oldest log line first. Slots torn by the crash are skipped.
+        [[nodiscard]] std::string ToJson( std::string_view version_data ) const;
+
+    private:
+        std::atomic< uint64_t > m_log_pushed{ 0 };
+        std::array< shm::SeqLock< CrashLogLine >, LogCapacity > m_log{};
+        shm::SeqLock< CrashTickStats > m_tick;
+    };
+
+    /// @brief spdlog sink copying every record at or above the level into the context.
+    std::shared_ptr< spdlog::sinks::sink > MakeCrashContextSink( CrashContext & context );
+} // namespace fs
@@ -1,12 +1,33 @@
 
 #include "CrashHandler.hpp"
+#include "CrashContext.hpp"
+
+#ifdef _WIN32
 #include "strings/String.hpp"
 
 #include <client/windows/handler/exception_handler.h>
 #include <client/windows/common/ipc_protocol.h>
+#else
+#include "filesystem/Filesystem.hpp"
+
+#include <client/linux/crash_generation/client_info.h>
+#include <client/linux/crash_generation/crash_generation_server.h>
+#include <client/linux/handler/exception_handler.h>
+#include <client/linux/handler/minidump_descriptor.h>
 
-#include <spdlog/spdlog.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
+#include "logging/LogLevels.hpp"
+
+#ifdef _WIN32
 constexpr const char * G_CRASH_UPLOADER_BINARY_NAME{ "WoWEditorCrashio.exe" };
 constexpr const wchar_t * G_PIPE_NAME = nullptr; // TODO: eventually move this from IP to OOP
 
@@ -30,14 +51,79 @@ static bool DumpCallback( const wchar_t * dump_path, const wchar_t * minidump_id
     CloseHandle( pi.hThread );
     return succeeded;
 }
+#else
+namespace
+{
+    struct HelperState
+    {
+        const fs::CrashContext * m_context = nullptr;
+        const std::string * m_version_data = nullptr;
+    };
+
+    /// @brief Runs in the helper once the minidump of the crashed process is written, the crashed process
+    /// stays stopped until this returns, so the shared context is exactly what it was at the crash.
+    void OnClientDumpRequest( void * context, const google_breakpad::ClientInfo *, const std::string * file_path )
+    {
+        const auto * state = static_cast< const HelperState * >( context );
+        if ( !file_path )
+            return;
+
+        auto sidecar_path = std::filesystem::path( *file_path ).replace_extension( ".context.json" );
+        (void)shm::fs::WriteStringToFile( sidecar_path, state->m_context->ToJson( *state->m_version_data ), std::ios::out | std::ios::trunc );
+    }
+
+    [[noreturn]] void RunDumpHelper( int server_fd, int lifeline_fd, const std::string & dump_dir, const HelperState & state )
+    {
+        // Interrupts go to the whole process group, the helper has to outlive the broker's shutdown.
+        std::signal( SIGINT, SIG_IGN );
+        std::signal( SIGTERM, SIG_IGN );
+
+        google_breakpad::CrashGenerationServer server( server_fd, &OnClientDumpRequest, const_cast< HelperState * >( &state ),
+                                                       nullptr, nullptr, true, &dump_dir );
+        if ( server.Start() )
+        {
+            char byte = 0;
+            for ( ;; )
+            {
+                const auto result = read( lifeline_fd, &byte, 1 );
+                if ( result == 0 || ( result < 0 && errno != EINTR ) )
+                    break;
+            }
+            server.Stop();
+        }
+        _exit( 0 );
+    }
+} // namespace
+#endif
 
 namespace fs
 {
-    CrashHandler::~CrashHandler() = default;
+    CrashHandler::~CrashHandler()
+    {
+        // Uninstall the signal handlers before the helper goes away.
+        m_crash_handler.reset();
+
+#ifdef _WIN32
+        delete m_context;
+#else
+        if ( m_lifeline_fd >= 0 )
+            close( m_lifeline_fd );
+        if ( m_helper_pid > 0 )
+            waitpid( m_helper_pid, nullptr, 0 );
+        if ( m_context )
+        {
+            m_context->~CrashContext();
+            munmap( m_context, sizeof( CrashContext ) );
+        }
+#endif
+    }
+
+#ifdef _WIN32
     CrashHandler::CrashHandler( std::filesystem::path && crash_dumps_dir, std::string && add_data )
         : m_crash_handler( nullptr )
         , m_crash_dumps_dir( std::move( crash_dumps_dir ) )
         , m_additional_version_data( std::move( add_data ) )
+        , m_context( new CrashContext() )
         , m_custom_info_entries( nullptr )
         , m_custom_client_info( nullptr )
     {
@@ -54,7 +140,7 @@ namespace fs
             std::error_code ec;
             if ( !std::filesystem::create_directories( m_crash_dumps_dir, ec ) || ec )
             {
-                spdlog::debug( "Failed to create crash dumps directory: {}", ec.message() );
+                SHM_LOG_DEBUG( "Failed to create crash dumps directory: {}", ec.message() );
                 std::abort();
                 return;
             }
@@ -69,6 +155,80 @@ namespace fs
             , MINIDUMP_TYPE( MINIDUMP_TYPE::MiniDumpNormal | MINIDUMP_TYPE::MiniDumpWithDataSegs | MINIDUMP_TYPE::MiniDumpWithThreadInfo )
             , G_PIPE_NAME
             , m_custom_client_info.get() );
+
+        // The context is written in process here, so it is simply included in the dump.
+        m_crash_handler->RegisterAppMemory( m_context, sizeof( CrashContext ) );
+    }
+#else
+    CrashHandler::CrashHandler( std::filesystem::path && crash_dumps_dir, std::string && add_data )
+        : m_crash_handler( nullptr )
+        , m_crash_dumps_dir( std::move( crash_dumps_dir ) )
+        , m_additional_version_data( std::move( add_data ) )
+    {
+        void * shared_memory = mmap( nullptr, sizeof( CrashContext ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+        if ( shared_memory == MAP_FAILED )
+        {
+            // Context() has to stay valid and a few pages failing to map leaves nothing sensible to do.
+            SHM_LOG_ERROR( "Failed to map the crash context: {}", std::strerror( errno ) );
+            std::abort();
+        }
+        m_context = new ( shared_memory ) CrashContext();
+
+        std::error_code ec;
+        std::filesystem::create_directories( m_crash_dumps_dir, ec );
+        if ( ec )
+        {
+            SHM_LOG_ERROR( "Failed to create crash dumps directory: {}", ec.message() );
+            return;
+        }
+
+        int server_fd = -1;
+        int client_fd = -1;
+        int lifeline[ 2 ]{ -1, -1 };
+        if ( !google_breakpad::CrashGenerationServer::CreateReportChannel( &server_fd, &client_fd ) )
+        {
+            SHM_LOG_ERROR( "Failed to create the crash report channel" );
+            return;
+        }
+        if ( pipe2( lifeline, O_CLOEXEC ) != 0 )
+        {
+            SHM_LOG_ERROR( "Failed to create the crash helper pipe: {}", std::strerror( errno ) );
+            close( server_fd );
+            close( client_fd );
+            return;
+        }
+
+        // Everything the helper needs is prepared before forking, the child only starts the server.
+        const std::string dump_dir = m_crash_dumps_dir.string();
+        const HelperState helper_state{ m_context, &m_additional_version_data };
+
+        const pid_t pid = fork();
+        if ( pid == 0 )
+        {
+            close( client_fd );
+            close( lifeline[ 1 ] );
+            RunDumpHelper( server_fd, lifeline[ 0 ], dump_dir, helper_state );
+        }
+
+        close( server_fd );
+        close( lifeline[ 0 ] );
+        if ( pid < 0 )
+        {
+            SHM_LOG_ERROR( "Failed to fork the crash dump helper: {}", std::strerror( errno ) );
+            close( client_fd );
+            close( lifeline[ 1 ] );
+            return;
+        }
+
+        m_helper_pid  = pid;
+        m_lifeline_fd = lifeline[ 1 ];
+
+        // With Yama ptrace_scope=1 the helper may only attach to us if we allow it explicitly.
+        prctl( PR_SET_PTRACER, pid, 0, 0, 0 );
+
+        m_crash_handler = std::make_unique< google_breakpad::ExceptionHandler >(
+            google_breakpad::MinidumpDescriptor( dump_dir ), nullptr, nullptr, nullptr, true, client_fd );
     }
+#endif
 
 }
@@ -1,8 +1,8 @@
-
 #pragma once
 
 #include <memory>
 #include <filesystem>
+#include <string>
 
 namespace google_breakpad
 {
@@ -13,18 +13,49 @@ namespace google_breakpad
 
 namespace fs
 {
+    class CrashContext;
+
+    /// @brief Writes a minidump when the process crashes, together with the recent log lines and tick
+    /// statistics collected in Context().
+    /// On Linux the dump is written out of process by a helper forked from the constructor, the crashing
+    /// process only signals the helper. Create the handler before starting any other thread.
     struct CrashHandler
     {
         CrashHandler( std::filesystem::path && crash_dumps_dir, std::string && additional_version_data );
         ~CrashHandler();
 
+        CrashHandler( const CrashHandler & )             = delete;
+        CrashHandler & operator=( const CrashHandler & ) = delete;
+        CrashHandler( CrashHandler && )                  = delete;
+        CrashHandler & operator=( CrashHandler && )      = delete;
+
+        /// @return Context attached to the dumps, valid for the lifetime of the handler.
+        CrashContext & Context() noexcept
+        {
+            return *m_context;
+        }
+
+        /// @return False if the handler could not be installed, crashes then leave no dump.
+        [[nodiscard]] bool IsInstalled() const noexcept
+        {
+            return m_crash_handler != nullptr;
+        }
+
     protected:
         std::unique_ptr< google_breakpad::ExceptionHandler > m_crash_handler;
         std::filesystem::path m_crash_dumps_dir;
         /// @brief {SEMVER} : {GIT_HASH} (Compile time)
         std::string m_additional_version_data;
+        /// @brief Heap allocated on Windows, shared with the dump helper on Linux.
+        CrashContext * m_context = nullptr;
 
+#ifdef _WIN32
         std::unique_ptr< google_breakpad::CustomInfoEntry[] > m_custom_info_entries;
         std::unique_ptr< google_breakpad::CustomClientInfo > m_custom_client_info;
+#else
+        int m_helper_pid  = -1;
+        /// @brief Write end of a pipe the helper blocks on, it exits once the pipe is closed.
+        int m_lifeline_fd = -1;
+#endif
     };
 }
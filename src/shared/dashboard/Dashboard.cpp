@@ -0,0 +1,233 @@
+#include "Dashboard.hpp"
+
+#include "app/RuntimeStats.hpp"
+#include "metrics/Metrics.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/common.h>
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/screen_interactive.hpp>
+#include <ftxui/dom/elements.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Previous sample, rates and utilization are computed from the delta to it.
+    struct RenderState
+    {
+        Clock::time_point m_taken_at{};
+        uint64_t m_tick = 0;
+        std::array< uint64_t, wb::RuntimeStatsBoard::MaxWorkers > m_worker_busy_ns{};
+        double m_tick_rate = 0.0;
+        std::array< double, wb::RuntimeStatsBoard::MaxWorkers > m_worker_utilization{};
+    };
+
+    std::optional< int64_t > FindGauge( const shm::metrics::RegistrySnapshot * snapshot, std::string_view name )
+    {
+        if ( !snapshot )
+            return std::nullopt;
+
+        const auto iter = std::ranges::find( snapshot->m_gauges, name, &shm::metrics::RegistrySnapshot::Sample::m_name );
+        if ( iter == snapshot->m_gauges.end() )
+            return std::nullopt;
+        return iter->m_value;
+    }
+
+    std::string FormatGauge( std::optional< int64_t > value )
+    {
+        return value ? fmt::format( "{}", *value ) : std::string( "n/a" );
+    }
+
+    std::string BucketLabel( std::size_t bucket )
+    {
+        if ( bucket < wb::FRAME_HISTOGRAM_BOUNDS_PERCENT.size() )
+            return fmt::format( "<= {:>3}%", wb::FRAME_HISTOGRAM_BOUNDS_PERCENT[ bucket ] );
+        return fmt::format( " > {:>3}%", wb::FRAME_HISTOGRAM_BOUNDS_PERCENT.back() );
+    }
+
+    ftxui::Element LabeledGauge( const std::string & label, float ratio, const std::string & value )
+    {
+        using namespace ftxui;
+        return hbox( {
+            text( label ) | size( WIDTH, EQUAL, 12 ),
+            gauge( std::clamp( ratio, 0.0f, 1.0f ) ) | flex,
+            text( " " + value ) | size( WIDTH, EQUAL, 12 ),
+        } );
+    }
+
+    void Sample( const wb::RuntimeStatsBoard & board, const wb::TickStats & tick, RenderState & state )
+    {
+        const auto now = Clock::now();
+        if ( state.m_taken_at != Clock::time_point{} )
+        {
+            const auto elapsed_ns = std::chrono::duration_cast< std::chrono::nanoseconds >( now - state.m_taken_at ).count();
+            if ( elapsed_ns <= 0 )
+                return;
+
+            state.m_tick_rate = static_cast< double >( tick.m_tick - state.m_tick ) * 1e9 / static_cast< double >( elapsed_ns );
+            for ( std::size_t i = 0; i < board.WorkerCount(); ++i )
+            {
+                const auto busy_ns              = board.WorkerBusyNs( i ) - state.m_worker_busy_ns[ i ];
+                state.m_worker_utilization[ i ] = static_cast< double >( busy_ns ) / static_cast< double >( elapsed_ns );
+            }
+        }
+
+        state.m_taken_at = now;
+        state.m_tick     = tick.m_tick;
+        for ( std::size_t i = 0; i < board.WorkerCount(); ++i )
+            state.m_worker_busy_ns[ i ] = board.WorkerBusyNs( i );
+    }
+
+    ftxui::Element Render( const wb::RuntimeStatsBoard & board, const shm::metrics::Aggregator & aggregator, RenderState & state )
+    {
+        using namespace ftxui;
+
+        const auto tick     = board.LoadTick();
+        const auto snapshot = aggregator.Latest();
+        Sample( board, tick, state );
+
+        const double budget_ms = static_cast< double >( tick.m_frame_budget_ns ) / 1e6;
+        const double frame_ms  = static_cast< double >( tick.m_last_frame_ns ) / 1e6;
+        const double target    = budget_ms > 0.0 ? 1000.0 / budget_ms : 0.0;
+
+        Elements tick_rows{
+            text( fmt::format( "tick {}", tick.m_tick ) ),
+            LabeledGauge( "rate", target > 0.0 ? static_cast< float >( state.m_tick_rate / target ) : 0.0f,
+                          fmt::format( "{:.1f}/s", state.m_tick_rate ) ),
+            LabeledGauge( "last frame", budget_ms > 0.0 ? static_cast< float >( frame_ms / budget_ms ) : 0.0f,
+                          fmt::format( "{:.2f}ms", frame_ms ) ),
+            text( fmt::format( "budget {:.2f}ms", budget_ms ) ) | dim,
+        };
+
+        uint64_t total_frames = 0;
+        for ( const auto count : tick.m_frame_histogram )
+            total_frames += count;
+
+        Elements histogram_rows;
+        for ( std::size_t i = 0; i < tick.m_frame_histogram.size(); ++i )
+        {
+            const auto count = tick.m_frame_histogram[ i ];
+            const auto ratio = total_frames ? static_cast< float >( count ) / static_cast< float >( total_frames ) : 0.0f;
+            auto row         = LabeledGauge( BucketLabel( i ), ratio, fmt::format( "{}", count ) );
+            if ( i >= wb::RuntimeStatsBoard::FirstOverBudgetBucket && count > 0 )
+                row = row | color( Color::Red );
+            histogram_rows.push_back( std::move( row ) );
+        }
+
+        Elements worker_rows;
+        for ( std::size_t i = 0; i < board.WorkerCount(); ++i )
+        {
+            const auto utilization = state.m_worker_utilization[ i ];
+            worker_rows.push_back( LabeledGauge( std::string( board.WorkerName( i ) ), static_cast< float >( utilization ),
+                                                 fmt::format( "{:.1f}%", utilization * 100.0 ) ) );
+        }
+
+        Elements counter_rows{
+            text( fmt::format( "connections     {}", tick.m_connections ) ),
+            text( fmt::format( "sessions        {}", FormatGauge( FindGauge( snapshot.get(), "shm_sessions" ) ) ) ),
+            text( fmt::format( "log backlog     {}", FormatGauge( FindGauge( snapshot.get(), "shm_log_archive_backlog" ) ) ) ),
+        };
+
+        Elements warning_rows;
+        for ( const auto & warning : board.RecentWarnings() )
+        {
+            auto line = text( std::string( warning.Text() ) );
+            warning_rows.push_back( warning.m_level >= static_cast< int32_t >( spdlog::level::err ) ? line | color( Color::Red )
+                                                                                                  : line | color( Color::Yellow ) );
+        }
+        if ( warning_rows.empty() )
+            warning_rows.push_back( text( "none" ) | dim );
+
+        return vbox( {
+            hbox( {
+                window( text( " Tick " ), vbox( std::move( tick_rows ) ) ) | flex,
+                window( text( " Counters " ), vbox( std::move( counter_rows ) ) ) | flex,
+            } ),
+            window( text( " Frame time / budget " ), vbox( std::move( histogram_rows ) ) ),
+            window( text( " Worker utilization " ), vbox( std::move( worker_rows ) ) ),
+            window( text( " Recent warnings " ), vbox( std::move( warning_rows ) ) | yframe ) | flex,
+            text( "q: quit" ) | dim,
+        } );
+    }
+} // namespace
+
+wb::Dashboard::Dashboard( const RuntimeStatsBoard & board, const shm::metrics::Aggregator & aggregator, std::function< void() > on_quit,
+                          DashboardSettings settings )
+    : m_board( board )
+    , m_aggregator( aggregator )
+    , m_on_quit( std::move( on_quit ) )
+    , m_settings( settings )
+{
+    m_screen_thread  = std::jthread( [ this ]( std::stop_token ) { RunScreen(); } );
+    m_refresh_thread = std::jthread( [ this ]( std::stop_token stop_token ) { RunRefresh( std::move( stop_token ) ); } );
+}
+
+wb::Dashboard::~Dashboard()
+{
+    m_refresh_thread.request_stop();
+    m_wait_cv.notify_all();
+    if ( m_refresh_thread.joinable() )
+        m_refresh_thread.join();
+
+    {
+        std::scoped_lock lock( m_screen_mutex );
+        m_stopping = true;
+        if ( m_screen )
+            m_screen->Exit();
+    }
+    if ( m_screen_thread.joinable() )
+        m_screen_thread.join();
+}
+
+void wb::Dashboard::RunScreen()
+{
+    auto screen = ftxui::ScreenInteractive::Fullscreen();
+    RenderState state;
+
+    auto renderer  = ftxui::Renderer( [ this, &state ] { return Render( m_board, m_aggregator, state ); } );
+    auto component = ftxui::CatchEvent( renderer,
+                                        [ this, &screen ]( const ftxui::Event & event )
+                                        {
+                                            if ( event != ftxui::Event::Character( 'q' ) )
+                                                return false;
+
+                                            if ( m_on_quit )
+                                                m_on_quit();
+                                            screen.Exit();
+                                            return true;
+                                        } );
+
+    {
+        std::scoped_lock lock( m_screen_mutex );
+        if ( m_stopping )
+            return;
+        m_screen = &screen;
+    }
+
+    screen.Loop( component );
+
+    std::scoped_lock lock( m_screen_mutex );
+    m_screen = nullptr;
+}
+
+void wb::Dashboard::RunRefresh( std::stop_token stop_token )
+{
+    while ( !stop_token.stop_requested() )
+    {
+        {
+            std::unique_lock lock( m_wait_mutex );
+            m_wait_cv.wait_for( lock, stop_token, m_settings.m_refresh_period, [] { return false; } );
+        }
+
+        std::scoped_lock lock( m_screen_mutex );
+        if ( m_screen )
+            m_screen->PostEvent( ftxui::Event::Custom );
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace ftxui
+{
+    class ScreenInteractive;
+}
+
+namespace shm::metrics
+{
+    class Aggregator;
+}
+
+namespace wb
+{
+    class RuntimeStatsBoard;
+
+    struct DashboardSettings
+    {
+        std::chrono::milliseconds m_refresh_period{ 200 };
+    };
+
+    /// @brief Full screen terminal view of the broker runtime stats.
+    /// Rendering happens on its own threads and only reads the lock-free RuntimeStatsBoard
+    /// and the latest metrics aggregator snapshot, the tick thread never waits on it.
+    class Dashboard
+    {
+    public:
+        /// @param on_quit Called from the UI thread when the user presses 'q'.
+        Dashboard( const RuntimeStatsBoard & board, const shm::metrics::Aggregator & aggregator, std::function< void() > on_quit,
+                   DashboardSettings settings = {} );
+        ~Dashboard();
+
+        Dashboard( const Dashboard & )             = delete;
+        Dashboard & operator=( const Dashboard & ) = delete;
+        Dashboard( Dashboard && )                  = delete;
+        Dashboard & operator=( Dashboard && )      = delete;
+
+    private:
+        void RunScreen();
+        void RunRefresh( std::stop_token stop_token );
+
+        const RuntimeStatsBoard & m_board;
+        const shm::metrics::Aggregator & m_aggregator;
+        std::function< void() > m_on_quit;
+        DashboardSettings m_settings;
+
+        /// @brief Guards m_screen, which is only set while the UI thread is inside the screen loop.
+        std::mutex m_screen_mutex;
+        ftxui::ScreenInteractive * m_screen = nullptr;
+        bool m_stopping                     = false;
+
+        std::mutex m_wait_mutex;
+        std::condition_variable_any m_wait_cv;
+
+        std::jthread m_screen_thread;
+        std::jthread m_refresh_thread;
+    };
+} // namespace wb
@@ -0,0 +1,119 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+shm::Result< shm::fs::MappedFile > shm::fs::MappedFile::Open( const std::filesystem::path & path )
+{
+    MappedFile mapped;
+#ifdef _WIN32
+    HANDLE file = ::CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                 FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    if ( file == INVALID_HANDLE_VALUE )
+        return std::unexpected( std::error_code( static_cast< int >( ::GetLastError() ), std::system_category() ) );
+    mapped.m_file_handle = file;
+
+    LARGE_INTEGER size{};
+    if ( !::GetFileSizeEx( file, &size ) )
+        return std::unexpected( std::error_code( static_cast< int >( ::GetLastError() ), std::system_category() ) );
+    mapped.m_size = static_cast< std::size_t >( size.QuadPart );
+    if ( mapped.m_size == 0 )
+        return mapped;
+
+    mapped.m_mapping_handle = ::CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( !mapped.m_mapping_handle )
+        return std::unexpected( std::error_code( static_cast< int >( ::GetLastError() ), std::system_category() ) );
+
+    mapped.m_data = ::MapViewOfFile( mapped.m_mapping_handle, FILE_MAP_READ, 0, 0, 0 );
+    if ( !mapped.m_data )
+        return std::unexpected( std::error_code( static_cast< int >( ::GetLastError() ), std::system_category() ) );
+#else
+    const int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        return std::unexpected( std::error_code( errno, std::generic_category() ) );
+
+    struct stat info{};
+    if ( ::fstat( fd, &info ) != 0 )
+    {
+        const int error = errno;
+        ::close( fd );
+        return std::unexpected( std::error_code( error, std::generic_category() ) );
+    }
+
+    mapped.m_size = static_cast< std::size_t >( info.st_size );
+    if ( mapped.m_size != 0 )
+    {
+        void * data = ::mmap( nullptr, mapped.m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( data == MAP_FAILED )
+        {
+            const int error = errno;
+            ::close( fd );
+            return std::unexpected( std::error_code( error, std::generic_category() ) );
+        }
+        // Read front to back exactly once.
+        ::madvise( data, mapped.m_size, MADV_SEQUENTIAL );
+        mapped.m_data = data;
+    }
+    // The mapping keeps the file alive.
+    ::close( fd );
+#endif
+    return mapped;
+}
+
+shm::fs::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+shm::fs::MappedFile::MappedFile( MappedFile && other ) noexcept
+    : m_data( std::exchange( other.m_data, nullptr ) )
+    , m_size( std::exchange( other.m_size, 0 ) )
+#ifdef _WIN32
+    , m_file_handle( std::exchange( other.m_file_handle, nullptr ) )
+    , m_mapping_handle( std::exchange( other.m_mapping_handle, nullptr ) )
+#endif
+{
+}
+
+shm::fs::MappedFile & shm::fs::MappedFile::operator=( MappedFile && other ) noexcept
+{
+    if ( this != &other )
+    {
+        Close();
+        m_data = std::exchange( other.m_data, nullptr );
+        m_size = std::exchange( other.m_size, 0 );
+#ifdef _WIN32
+        m_file_handle    = std::exchange( other.m_file_handle, nullptr );
+        m_mapping_handle = std::exchange( other.m_mapping_handle, nullptr );
+#endif
+    }
+    return *this;
+}
+
+void shm::fs::MappedFile::Close() noexcept
+{
+#ifdef _WIN32
+    if ( m_data )
+        ::UnmapViewOfFile( m_data );
+    if ( m_mapping_handle )
+        ::CloseHandle( m_mapping_handle );
+    if ( m_file_handle )
+        ::CloseHandle( m_file_handle );
+    m_file_handle    = nullptr;
+    m_mapping_handle = nullptr;
+#else
+    if ( m_data )
+        ::munmap( const_cast< void * >( m_data ), m_size );
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "results/Result.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace shm::fs
+{
+    /// @brief Read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        static shm::Result< MappedFile > Open( const std::filesystem::path & path );
+
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile( const MappedFile & )             = delete;
+        MappedFile & operator=( const MappedFile & ) = delete;
+        MappedFile( MappedFile && other ) noexcept;
+        MappedFile & operator=( MappedFile && other ) noexcept;
+
+        [[nodiscard]] std::span< const std::byte > Bytes() const noexcept
+        {
+            return { static_cast< const std::byte * >( m_data ), m_size };
+        }
+
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            return m_size;
+        }
+
+    private:
+        void Close() noexcept;
+
+        const void * m_data = nullptr;
+        std::size_t m_size  = 0;
+#ifdef _WIN32
+        void * m_file_handle    = nullptr;
+        void * m_mapping_handle = nullptr;
+#endif
+    };
+} // namespace shm::fs
@@ -0,0 +1,424 @@
+#include "SessionHandoff.hpp"
+
+#include <rfl/msgpack.hpp>
+
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // The conversation on the socket: the successor sends a Request, the old process answers with an Offer carrying
+    // the descriptors, followed by the encoded SessionTable, and the successor confirms with a single byte. The old
+    // process then closes the connection once it stopped, or sends a refusal byte first if it carries on.
+    // Both ends run on the same host, so the structs go over as they are.
+    constexpr uint32_t G_MAGIC = 0x48'4D'48'53; // "SHMH"
+    /// @brief A successor that connected has this long to send its request, and to confirm a handoff.
+    constexpr std::chrono::milliseconds G_REQUEST_TIMEOUT{ 1000 };
+    /// @brief Tables above this are refused, far more than the peers a broker takes.
+    constexpr uint64_t G_MAX_TABLE_SIZE = uint64_t{ 1 } << 30;
+
+    struct Request
+    {
+        uint32_t m_magic   = G_MAGIC;
+        uint32_t m_version = shm::handoff::SessionTable::CurrentVersion;
+    };
+
+    struct Offer
+    {
+        uint32_t m_magic       = G_MAGIC;
+        uint32_t m_descriptors = 0;
+        uint64_t m_table_size  = 0;
+    };
+
+#ifdef __linux__
+    using Clock = std::chrono::steady_clock;
+
+    std::unexpected< std::error_code > LastError()
+    {
+        return std::unexpected( std::error_code( errno, std::generic_category() ) );
+    }
+
+    shm::Result< void > WaitFor( int fd, short events, Clock::time_point deadline )
+    {
+        for ( ;; )
+        {
+            const auto remaining = std::chrono::ceil< std::chrono::milliseconds >( deadline - Clock::now() );
+            if ( remaining.count() <= 0 )
+                return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+
+            pollfd ready{ .fd = fd, .events = events, .revents = 0 };
+            const int result = ::poll( &ready, 1, static_cast< int >( remaining.count() ) );
+            if ( result > 0 )
+                return {};
+            if ( result < 0 && errno != EINTR )
+                return LastError();
+        }
+    }
+
+    shm::Result< void > SendAll( int fd, std::span< const std::byte > bytes, Clock::time_point deadline )
+    {
+        while ( !bytes.empty() )
+        {
+            const auto sent = ::send( fd, bytes.data(), bytes.size(), MSG_NOSIGNAL );
+            if ( sent >= 0 )
+            {
+                bytes = bytes.subspan( static_cast< std::size_t >( sent ) );
+                continue;
+            }
+            if ( errno == EPIPE || errno == ECONNRESET )
+                return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+            if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+                return LastError();
+            if ( auto writable = WaitFor( fd, POLLOUT, deadline ); !writable.has_value() )
+                return writable;
+        }
+        return {};
+    }
+
+    shm::Result< void > ReceiveAll( int fd, std::span< std::byte > bytes, Clock::time_point deadline )
+    {
+        while ( !bytes.empty() )
+        {
+            const auto received = ::recv( fd, bytes.data(), bytes.size(), 0 );
+            if ( received > 0 )
+            {
+                bytes = bytes.subspan( static_cast< std::size_t >( received ) );
+                continue;
+            }
+            if ( received == 0 )
+                return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+            if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+                return LastError();
+            if ( auto readable = WaitFor( fd, POLLIN, deadline ); !readable.has_value() )
+                return readable;
+        }
+        return {};
+    }
+
+    shm::Result< sockaddr_un > ToSockaddr( const std::filesystem::path & path )
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        const auto & name  = path.native();
+        if ( name.empty() || name.size() >= sizeof( address.sun_path ) )
+            return std::unexpected( std::make_error_code( std::errc::filename_too_long ) );
+        std::memcpy( address.sun_path, name.c_str(), name.size() );
+        return address;
+    }
+#endif
+} // namespace
+
+shm::Result< shm::handoff::HandoffListener > shm::handoff::HandoffListener::Listen( const std::filesystem::path & path )
+{
+#ifndef __linux__
+    (void)path;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    auto address = ToSockaddr( path );
+    if ( !address.has_value() )
+        return std::unexpected( address.error() );
+
+    HandoffListener listener;
+    listener.m_listener.Reset( ::socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 ) );
+    if ( !listener.m_listener )
+        return LastError();
+
+    std::error_code ec;
+    std::filesystem::remove( path, ec );
+    if ( ::bind( listener.m_listener.Get(), reinterpret_cast< const sockaddr * >( &*address ), sizeof( *address ) ) != 0 )
+        return LastError();
+    listener.m_path = path;
+    if ( ::chmod( path.c_str(), S_IRUSR | S_IWUSR ) != 0 || ::listen( listener.m_listener.Get(), 1 ) != 0 )
+        return LastError();
+    return listener;
+#endif
+}
+
+shm::handoff::HandoffListener::~HandoffListener()
+{
+    if ( m_path.empty() )
+        return;
+
+    std::error_code ec;
+    std::filesystem::remove( m_path, ec );
+}
+
+shm::handoff::HandoffListener::HandoffListener( HandoffListener && other ) noexcept
+    : m_path( std::exchange( other.m_path, {} ) )
+    , m_listener( std::move( other.m_listener ) )
+    , m_connecting( std::move( other.m_connecting ) )
+    , m_request( other.m_request )
+    , m_request_received( std::exchange( other.m_request_received, 0 ) )
+    , m_request_deadline( other.m_request_deadline )
+    , m_successor( std::move( other.m_successor ) )
+{
+}
+
+shm::handoff::HandoffListener & shm::handoff::HandoffListener::operator=( HandoffListener && other ) noexcept
+{
+    if ( this != &other )
+    {
+        std::swap( m_path, other.m_path );
+        std::swap( m_listener, other.m_listener );
+        std::swap( m_connecting, other.m_connecting );
+        std::swap( m_request, other.m_request );
+        std::swap( m_request_received, other.m_request_received );
+        std::swap( m_request_deadline, other.m_request_deadline );
+        std::swap( m_successor, other.m_successor );
+    }
+    return *this;
+}
+
+bool shm::handoff::HandoffListener::PollSuccessor()
+{
+#ifndef __linux__
+    return false;
+#else
+    static_assert( sizeof( Request ) == RequestSize );
+    if ( m_successor )
+        return true;
+    if ( !m_listener )
+        return false;
+
+    if ( !m_connecting )
+    {
+        net::UniqueFd connecting( ::accept4( m_listener.Get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC ) );
+        if ( !connecting )
+            return false;
+
+        // The sockets and sessions only go to a process of the same user.
+        ucred credentials{};
+        socklen_t size = sizeof( credentials );
+        if ( ::getsockopt( connecting.Get(), SOL_SOCKET, SO_PEERCRED, &credentials, &size ) != 0 || credentials.uid != ::geteuid() )
+            return false;
+
+        m_connecting       = std::move( connecting );
+        m_request_received = 0;
+        m_request_deadline = Clock::now() + G_REQUEST_TIMEOUT;
+    }
+
+    const auto received = ::recv( m_connecting.Get(), m_request.data() + m_request_received, m_request.size() - m_request_received, 0 );
+    if ( received > 0 )
+        m_request_received += static_cast< std::size_t >( received );
+    else if ( received == 0 || ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) || Clock::now() >= m_request_deadline )
+    {
+        // Gone, broken or too slow, the next one may connect.
+        m_connecting.Reset();
+        return false;
+    }
+    if ( m_request_received < m_request.size() )
+        return false;
+
+    Request request;
+    std::memcpy( &request, m_request.data(), sizeof( request ) );
+    auto successor = std::move( m_connecting );
+    if ( request.m_magic != G_MAGIC || request.m_version != SessionTable::CurrentVersion )
+        return false;
+
+    m_successor = std::move( successor );
+    return true;
+#endif
+}
+
+shm::Result< void > shm::handoff::HandoffListener::Hand( const SessionTable & table, std::span< const int > descriptors, std::chrono::milliseconds timeout )
+{
+#ifndef __linux__
+    (void)table;
+    (void)descriptors;
+    (void)timeout;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    if ( !m_successor )
+        return std::unexpected( std::make_error_code( std::errc::not_connected ) );
+    if ( descriptors.size() > MaxDescriptors )
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+
+    // Whatever happens, this successor is done with.
+    auto successor      = std::move( m_successor );
+    const auto deadline = Clock::now() + timeout;
+    const auto encoded  = rfl::msgpack::write< rfl::NoFieldNames, rfl::UnderlyingEnums >( table );
+    const Offer offer{ .m_descriptors = static_cast< uint32_t >( descriptors.size() ), .m_table_size = encoded.size() };
+
+    // The descriptors ride along with the first byte of the offer.
+    alignas( cmsghdr ) std::array< std::byte, CMSG_SPACE( sizeof( int ) * MaxDescriptors ) > control{};
+    iovec part{ const_cast< Offer * >( &offer ), sizeof( offer ) };
+    msghdr message{};
+    message.msg_iov    = &part;
+    message.msg_iovlen = 1;
+    if ( !descriptors.empty() )
+    {
+        message.msg_control    = control.data();
+        message.msg_controllen = CMSG_SPACE( sizeof( int ) * descriptors.size() );
+        cmsghdr * rights       = CMSG_FIRSTHDR( &message );
+        rights->cmsg_level     = SOL_SOCKET;
+        rights->cmsg_type      = SCM_RIGHTS;
+        rights->cmsg_len       = CMSG_LEN( sizeof( int ) * descriptors.size() );
+        std::memcpy( CMSG_DATA( rights ), descriptors.data(), sizeof( int ) * descriptors.size() );
+    }
+
+    ssize_t sent = -1;
+    while ( sent < 0 )
+    {
+        sent = ::sendmsg( successor.Get(), &message, MSG_NOSIGNAL );
+        if ( sent >= 0 )
+            break;
+        if ( errno == EPIPE || errno == ECONNRESET )
+            return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+        if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+            return LastError();
+        if ( auto writable = WaitFor( successor.Get(), POLLOUT, deadline ); !writable.has_value() )
+            return writable;
+    }
+
+    const auto offer_bytes = std::as_bytes( std::span( &offer, 1 ) );
+    if ( auto rest = SendAll( successor.Get(), offer_bytes.subspan( static_cast< std::size_t >( sent ) ), deadline ); !rest.has_value() )
+        return rest;
+    if ( auto sent_table = SendAll( successor.Get(), std::as_bytes( std::span( encoded ) ), deadline ); !sent_table.has_value() )
+        return sent_table;
+
+    std::byte confirmation{};
+    auto confirmed = ReceiveAll( successor.Get(), std::span( &confirmation, 1 ), deadline );
+    // The confirmation may arrive just as the wait runs out.
+    if ( !confirmed.has_value() && ::recv( successor.Get(), &confirmation, 1, MSG_DONTWAIT ) == 1 )
+        confirmed = {};
+    if ( !confirmed.has_value() )
+    {
+        // A confirmation still on its way must not start the successor, it waits for this answer.
+        const std::byte refusal{ 0 };
+        std::ignore = ::send( successor.Get(), &refusal, 1, MSG_NOSIGNAL | MSG_DONTWAIT );
+        return confirmed;
+    }
+
+    // The successor listens on the path from now on, it must not be removed on the way out. It starts once the
+    // connection closes.
+    m_listener.Reset();
+    m_path.clear();
+    return {};
+#endif
+}
+
+shm::Result< shm::handoff::Handoff > shm::handoff::RequestHandoff( const std::filesystem::path & path, std::chrono::milliseconds timeout )
+{
+#ifndef __linux__
+    (void)path;
+    (void)timeout;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    auto address = ToSockaddr( path );
+    if ( !address.has_value() )
+        return std::unexpected( address.error() );
+
+    Handoff handoff;
+    handoff.m_predecessor.Reset( ::socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 ) );
+    if ( !handoff.m_predecessor )
+        return LastError();
+    const int predecessor = handoff.m_predecessor.Get();
+    if ( ::connect( predecessor, reinterpret_cast< const sockaddr * >( &*address ), sizeof( *address ) ) != 0 )
+        return LastError();
+
+    const auto deadline = Clock::now() + timeout;
+    const Request request;
+    if ( auto sent = SendAll( predecessor, std::as_bytes( std::span( &request, 1 ) ), deadline ); !sent.has_value() )
+        return std::unexpected( sent.error() );
+
+    Offer offer;
+    offer.m_magic = 0;
+    alignas( cmsghdr ) std::array< std::byte, CMSG_SPACE( sizeof( int ) * MaxDescriptors ) > control{};
+    iovec part{ &offer, sizeof( offer ) };
+    msghdr message{};
+    message.msg_iov        = &part;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.data();
+    message.msg_controllen = control.size();
+
+    ssize_t received = -1;
+    while ( received < 0 )
+    {
+        received = ::recvmsg( predecessor, &message, MSG_CMSG_CLOEXEC );
+        if ( received >= 0 )
+            break;
+        if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+            return LastError();
+        if ( auto readable = WaitFor( predecessor, POLLIN, deadline ); !readable.has_value() )
+            return std::unexpected( readable.error() );
+    }
+    if ( received == 0 )
+        return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+
+    // Owned right away, so they are closed again whatever goes wrong below.
+    for ( cmsghdr * header = CMSG_FIRSTHDR( &message ); header != nullptr; header = CMSG_NXTHDR( &message, header ) )
+    {
+        if ( header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS )
+            continue;
+
+        const std::size_t count = ( header->cmsg_len - CMSG_LEN( 0 ) ) / sizeof( int );
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            int fd = -1;
+            std::memcpy( &fd, CMSG_DATA( header ) + i * sizeof( int ), sizeof( int ) );
+            handoff.m_descriptors.emplace_back( fd );
+        }
+    }
+    if ( ( message.msg_flags & MSG_CTRUNC ) != 0 )
+        return std::unexpected( std::make_error_code( std::errc::message_size ) );
+
+    const auto offer_bytes = std::as_writable_bytes( std::span( &offer, 1 ) );
+    if ( auto rest = ReceiveAll( predecessor, offer_bytes.subspan( static_cast< std::size_t >( received ) ), deadline ); !rest.has_value() )
+        return std::unexpected( rest.error() );
+    if ( offer.m_magic != G_MAGIC || offer.m_descriptors != handoff.m_descriptors.size() )
+        return std::unexpected( std::make_error_code( std::errc::protocol_error ) );
+    if ( offer.m_table_size > G_MAX_TABLE_SIZE )
+        return std::unexpected( std::make_error_code( std::errc::message_size ) );
+
+    std::vector< char > encoded( offer.m_table_size );
+    if ( auto table = ReceiveAll( predecessor, std::as_writable_bytes( std::span( encoded ) ), deadline ); !table.has_value() )
+        return std::unexpected( table.error() );
+
+    auto table = rfl::msgpack::read< SessionTable, rfl::NoFieldNames, rfl::UnderlyingEnums >( encoded.data(), encoded.size() );
+    if ( !table )
+        return std::unexpected( std::make_error_code( std::errc::illegal_byte_sequence ) );
+    if ( table->version != SessionTable::CurrentVersion )
+        return std::unexpected( std::make_error_code( std::errc::protocol_not_supported ) );
+
+    handoff.m_table = std::move( *table );
+    return handoff;
+#endif
+}
+
+shm::Result< void > shm::handoff::ConfirmHandoff( Handoff & handoff, std::chrono::milliseconds timeout )
+{
+#ifndef __linux__
+    (void)handoff;
+    (void)timeout;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    if ( !handoff.m_predecessor )
+        return std::unexpected( std::make_error_code( std::errc::not_connected ) );
+
+    const std::byte confirmation{ 1 };
+    auto predecessor    = std::move( handoff.m_predecessor );
+    const auto deadline = Clock::now() + timeout;
+    if ( auto sent = SendAll( predecessor.Get(), std::span( &confirmation, 1 ), deadline ); !sent.has_value() )
+        return sent;
+
+    // Any answer is a refusal. A closed connection means the old process stopped, or died, either way it is gone.
+    std::byte answer{};
+    auto answered = ReceiveAll( predecessor.Get(), std::span( &answer, 1 ), deadline );
+    if ( answered.has_value() )
+        return std::unexpected( std::make_error_code( std::errc::operation_canceled ) );
+    if ( answered.error() == std::errc::connection_reset )
+        return {};
+    return answered;
+#endif
+}
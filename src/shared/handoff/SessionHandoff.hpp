@@ -0,0 +1,94 @@
+#pragma once
+
+#include "net/UdpServer.hpp"
+#include "net/UniqueFd.hpp"
+#include "results/Result.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+/// @brief Restarting the broker without dropping its peers. The running process listens on a Unix socket, a new
+/// process started with the same path connects to it and receives the listening sockets (SCM_RIGHTS) together with
+/// a table of the live sessions. The old process stops reading its sockets before it hands them over, datagrams
+/// arriving meanwhile wait in the kernel for the new one. The world itself moves through the shared journal.
+namespace shm::handoff
+{
+    /// @brief Descriptors a single handoff carries at most.
+    constexpr std::size_t MaxDescriptors = 64;
+
+    /// @brief Everything the new process needs to carry on with the sessions of the old one.
+    /// Field names are the serialized names.
+    struct SessionTable
+    {
+        /// @brief Bumped whenever the table changes, processes only hand over to the same version.
+        static constexpr uint32_t CurrentVersion = 2;
+
+        uint32_t version = CurrentVersion;
+        /// @brief Last tick the old process ran, the new one continues with the next.
+        uint64_t tick = 0;
+        std::vector< net::UdpPeerState > udp_peers;
+    };
+
+    /// @brief What the new process received, the descriptors in the order they were handed.
+    struct Handoff
+    {
+        SessionTable m_table;
+        std::vector< net::UniqueFd > m_descriptors;
+        /// @brief Connection to the old process, it waits for ConfirmHandoff.
+        net::UniqueFd m_predecessor;
+    };
+
+    /// @brief The old process's end: waits for a successor without blocking the tick. The socket file has mode 0600
+    /// and only processes of the same user are heard, anyone else could take the sockets and the sessions.
+    class HandoffListener
+    {
+    public:
+        /// @brief Listens on the given path, replacing a socket file left behind by a process that died.
+        static shm::Result< HandoffListener > Listen( const std::filesystem::path & path );
+
+        HandoffListener() = default;
+        /// @brief Removes the socket file unless the listener was handed over.
+        ~HandoffListener();
+
+        HandoffListener( const HandoffListener & )             = delete;
+        HandoffListener & operator=( const HandoffListener & ) = delete;
+        HandoffListener( HandoffListener && other ) noexcept;
+        HandoffListener & operator=( HandoffListener && other ) noexcept;
+
+        /// @brief Accepts a pending successor and reads what arrived of its request, once per tick. Never waits, a
+        /// request may take several ticks to arrive in full.
+        /// @return True once a successor of the same version waits for Hand.
+        [[nodiscard]] bool PollSuccessor();
+
+        /// @brief Sends the descriptors and the table to the waiting successor and blocks until it confirmed.
+        /// On success the socket path belongs to the successor, which starts right away, the caller must not tick
+        /// again. On failure the caller still owns everything it handed and carries on, the successor is told so and
+        /// the listener waits for the next one.
+        shm::Result< void > Hand( const SessionTable & table, std::span< const int > descriptors, std::chrono::milliseconds timeout );
+
+    private:
+        static constexpr std::size_t RequestSize = 8;
+
+        std::filesystem::path m_path;
+        net::UniqueFd m_listener;
+        /// @brief Connected, its request did not arrive in full yet.
+        net::UniqueFd m_connecting;
+        std::array< std::byte, RequestSize > m_request{};
+        std::size_t m_request_received = 0;
+        std::chrono::steady_clock::time_point m_request_deadline;
+        net::UniqueFd m_successor;
+    };
+
+    /// @brief The new process's end: asks the process listening on the path to hand over.
+    /// The descriptors arrive close-on-exec.
+    [[nodiscard]] shm::Result< Handoff > RequestHandoff( const std::filesystem::path & path, std::chrono::milliseconds timeout );
+
+    /// @brief Tells the old process the sessions were taken over and waits until it stopped.
+    /// @return An error if the old process gave up waiting and carries on, the successor must not run then.
+    shm::Result< void > ConfirmHandoff( Handoff & handoff, std::chrono::milliseconds timeout );
+} // namespace shm::handoff
@@ -0,0 +1,575 @@
+#include "Journal.hpp"
+
+#include "filesystem/MappedFile.hpp"
+#include "hash/Crc32c.hpp"
+
+#include <fmt/format.h>
+#include <rfl/msgpack.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Every record and snapshot is one frame: payload size and CRC-32C of the payload (both little endian),
+    // followed by the payload. A frame that is cut short or fails the check ends the file.
+    constexpr std::size_t FRAME_HEADER_SIZE       = 8;
+    constexpr std::string_view SNAPSHOT_PREFIX    = "snapshot-";
+    constexpr std::string_view SNAPSHOT_EXTENSION = ".bin";
+    constexpr std::string_view SEGMENT_PREFIX     = "journal-";
+    constexpr std::string_view SEGMENT_EXTENSION  = ".log";
+
+    template< typename T >
+    std::vector< char > Encode( const T & value )
+    {
+        return rfl::msgpack::write< rfl::NoFieldNames, rfl::UnderlyingEnums >( value );
+    }
+
+    template< typename T >
+    rfl::Result< T > Decode( std::span< const std::byte > payload )
+    {
+        return rfl::msgpack::read< T, rfl::NoFieldNames, rfl::UnderlyingEnums >( reinterpret_cast< const char * >( payload.data() ), payload.size() );
+    }
+
+    void StoreLe32( std::byte * out, uint32_t value )
+    {
+        for ( int i = 0; i < 4; ++i )
+            out[ i ] = static_cast< std::byte >( value >> ( 8 * i ) );
+    }
+
+    uint32_t LoadLe32( const std::byte * in )
+    {
+        uint32_t value = 0;
+        for ( int i = 0; i < 4; ++i )
+            value |= static_cast< uint32_t >( in[ i ] ) << ( 8 * i );
+        return value;
+    }
+
+    shm::Result< void > WriteFrame( std::FILE * file, const std::vector< char > & payload )
+    {
+        const auto bytes = std::as_bytes( std::span( payload ) );
+        std::array< std::byte, FRAME_HEADER_SIZE > header;
+        StoreLe32( header.data(), static_cast< uint32_t >( payload.size() ) );
+        StoreLe32( header.data() + 4, shm::hash::Crc32c( bytes ) );
+
+        if ( std::fwrite( header.data(), 1, header.size(), file ) != header.size()
+             || std::fwrite( payload.data(), 1, payload.size(), file ) != payload.size() )
+            return std::unexpected( std::make_error_code( std::errc::io_error ) );
+        return {};
+    }
+
+    /// @brief Calls on_frame with every intact frame.
+    /// @return Offset just past the last intact frame, equal to the size when the whole file is intact.
+    template< typename OnFrame >
+    std::size_t ForEachFrame( std::span< const std::byte > bytes, OnFrame && on_frame )
+    {
+        std::size_t offset = 0;
+        while ( bytes.size() - offset >= FRAME_HEADER_SIZE )
+        {
+            const uint32_t size = LoadLe32( bytes.data() + offset );
+            const uint32_t crc  = LoadLe32( bytes.data() + offset + 4 );
+            if ( bytes.size() - offset - FRAME_HEADER_SIZE < size )
+                break;
+
+            const auto payload = bytes.subspan( offset + FRAME_HEADER_SIZE, size );
+            if ( shm::hash::Crc32c( payload ) != crc || !on_frame( payload ) )
+                break;
+            offset += FRAME_HEADER_SIZE + size;
+        }
+        return offset;
+    }
+
+    shm::Result< void > SyncFile( std::FILE * file )
+    {
+        if ( std::fflush( file ) != 0 )
+            return std::unexpected( std::make_error_code( std::errc::io_error ) );
+#ifdef _WIN32
+        if ( _commit( _fileno( file ) ) != 0 )
+#else
+        if ( ::fsync( ::fileno( file ) ) != 0 )
+#endif
+            return std::unexpected( std::make_error_code( std::errc::io_error ) );
+        return {};
+    }
+
+    std::filesystem::path NumberedPath( const std::filesystem::path & directory, std::string_view prefix, uint64_t sequence,
+                                        std::string_view extension )
+    {
+        return directory / fmt::format( "{}{:020}{}", prefix, sequence, extension );
+    }
+
+    struct NumberedFile
+    {
+        uint64_t m_sequence = 0;
+        std::filesystem::path m_path;
+    };
+
+    /// @brief Files named "<prefix><sequence><extension>", sorted by sequence.
+    std::vector< NumberedFile > ListNumbered( const std::filesystem::path & directory, std::string_view prefix, std::string_view extension )
+    {
+        std::vector< NumberedFile > files;
+        std::error_code ec;
+        for ( const auto & entry : std::filesystem::directory_iterator( directory, ec ) )
+        {
+            const auto name = entry.path().filename().string();
+            if ( !name.starts_with( prefix ) || !name.ends_with( extension ) || name.size() != prefix.size() + 20 + extension.size() )
+                continue;
+
+            const auto digits = std::string_view( name ).substr( prefix.size(), 20 );
+            if ( !std::ranges::all_of( digits, []( char c ) { return c >= '0' && c <= '9'; } ) )
+                continue;
+            files.push_back( { std::stoull( std::string( digits ) ), entry.path() } );
+        }
+        std::ranges::sort( files, {}, &NumberedFile::m_sequence );
+        return files;
+    }
+} // namespace
+
+std::vector< char > shm::journal::EncodeSnapshot( const WorldSnapshot & snapshot )
+{
+    return Encode( snapshot );
+}
+
+shm::Result< shm::journal::WorldSnapshot > shm::journal::DecodeSnapshot( std::span< const std::byte > payload )
+{
+    auto decoded = Decode< WorldSnapshot >( payload );
+    if ( !decoded )
+        return std::unexpected( std::make_error_code( std::errc::illegal_byte_sequence ) );
+    return std::move( *decoded );
+}
+
+/** WORLD APPLIER **/
+
+shm::journal::WorldApplier::WorldApplier( flecs::world & world )
+    : m_world( world )
+{
+    m_world.component< PersistentId >();
+    m_world.component< Transform >();
+    m_world.component< Presence >();
+}
+
+void shm::journal::WorldApplier::Apply( const WorldCommand & command )
+{
+    if ( command.type == CommandType::Spawn )
+    {
+        if ( !m_entities.contains( command.entity ) )
+            m_entities.emplace( command.entity, m_world.entity().set< PersistentId >( { command.entity } ) );
+        return;
+    }
+
+    auto iter = m_entities.find( command.entity );
+    if ( iter == m_entities.end() )
+        return;
+
+    switch ( command.type )
+    {
+    case CommandType::Destroy:
+        iter->second.destruct();
+        m_entities.erase( iter );
+        break;
+    case CommandType::SetTransform:
+        if ( command.transform )
+            iter->second.set< Transform >( *command.transform );
+        break;
+    case CommandType::SetPresence:
+        if ( command.presence )
+            iter->second.set< Presence >( *command.presence );
+        break;
+    case CommandType::Spawn:
+        break;
+    }
+}
+
+void shm::journal::WorldApplier::Load( const WorldSnapshot & snapshot )
+{
+    m_entities.reserve( m_entities.size() + snapshot.entities.size() );
+    for ( const auto & entity : snapshot.entities )
+    {
+        Apply( WorldCommand::Spawn( entity.id ) );
+        if ( entity.transform )
+            Apply( WorldCommand::Set( entity.id, *entity.transform ) );
+        if ( entity.presence )
+            Apply( WorldCommand::Set( entity.id, *entity.presence ) );
+    }
+}
+
+shm::journal::WorldSnapshot shm::journal::WorldApplier::Capture( uint64_t sequence, uint64_t next_entity_id ) const
+{
+    WorldSnapshot snapshot{ .sequence = sequence, .next_entity_id = next_entity_id };
+    snapshot.entities.reserve( m_entities.size() );
+    for ( const auto & [ id, entity ] : m_entities )
+        snapshot.entities.push_back( { .id = id } );
+    std::ranges::sort( snapshot.entities, {}, &EntitySnapshot::id );
+
+    auto find = [ &snapshot ]( uint64_t id ) -> EntitySnapshot *
+    {
+        auto iter = std::ranges::lower_bound( snapshot.entities, id, {}, &EntitySnapshot::id );
+        return iter != snapshot.entities.end() && iter->id == id ? &*iter : nullptr;
+    };
+    m_world.each( [ & ]( const PersistentId & id, const Transform & transform )
+                  {
+                      if ( auto * entity = find( id.value ) )
+                          entity->transform = transform;
+                  } );
+    m_world.each( [ & ]( const PersistentId & id, const Presence & presence )
+                  {
+                      if ( auto * entity = find( id.value ) )
+                          entity->presence = presence;
+                  } );
+    return snapshot;
+}
+
+void shm::journal::WorldApplier::CaptureRange( uint64_t first_id, uint64_t end_id, std::vector< EntitySnapshot > & entities ) const
+{
+    for ( auto id = first_id; id < end_id; ++id )
+    {
+        const auto iter = m_entities.find( id );
+        if ( iter == m_entities.end() )
+            continue;
+
+        auto & entity = entities.emplace_back( EntitySnapshot{ .id = id } );
+        iter->second.get( [ & ]( const Transform & transform ) { entity.transform = transform; } );
+        iter->second.get( [ & ]( const Presence & presence ) { entity.presence = presence; } );
+    }
+}
+
+/** WORLD JOURNAL **/
+
+shm::journal::WorldJournal::WorldJournal( flecs::world & world, JournalSettings settings )
+    : m_settings( std::move( settings ) )
+    , m_applier( world )
+{
+    m_writer = std::jthread( [ this ]( std::stop_token stop ) { RunWriter( std::move( stop ) ); } );
+}
+
+shm::journal::WorldJournal::~WorldJournal()
+{
+    m_writer.request_stop();
+    if ( m_writer.joinable() )
+        m_writer.join();
+    if ( m_segment )
+        std::fclose( m_segment );
+}
+
+shm::Result< shm::journal::RecoveryStats > shm::journal::WorldJournal::Recover()
+{
+    std::error_code ec;
+    std::filesystem::create_directories( m_settings.m_directory, ec );
+    if ( ec )
+        return std::unexpected( ec );
+
+    RecoveryStats stats;
+
+    // Newest snapshot first, an unreadable one falls back to the previous.
+    auto snapshots = ListNumbered( m_settings.m_directory, SNAPSHOT_PREFIX, SNAPSHOT_EXTENSION );
+    for ( auto iter = snapshots.rbegin(); iter != snapshots.rend(); ++iter )
+    {
+        auto mapped = shm::fs::MappedFile::Open( iter->m_path );
+        if ( !mapped.has_value() )
+            continue;
+
+        std::optional< WorldSnapshot > snapshot;
+        ForEachFrame( mapped->Bytes(),
+                      [ &snapshot ]( std::span< const std::byte > payload )
+                      {
+                          auto decoded = Decode< WorldSnapshot >( payload );
+                          if ( decoded )
+                              snapshot = std::move( *decoded );
+                          return false;
+                      } );
+        if ( !snapshot )
+            continue;
+
+        m_applier.Load( *snapshot );
+        m_sequence                = snapshot->sequence;
+        m_next_entity_id          = snapshot->next_entity_id;
+        stats.m_snapshot_sequence = snapshot->sequence;
+        stats.m_snapshot_entities = snapshot->entities.size();
+        break;
+    }
+
+    const auto segments = ListNumbered( m_settings.m_directory, SEGMENT_PREFIX, SEGMENT_EXTENSION );
+    for ( std::size_t i = 0; i < segments.size(); ++i )
+    {
+        std::size_t intact_size = 0;
+        std::size_t file_size   = 0;
+        {
+            auto mapped = shm::fs::MappedFile::Open( segments[ i ].m_path );
+            if ( !mapped.has_value() )
+                return std::unexpected( mapped.error() );
+
+            file_size   = mapped->Size();
+            intact_size = ForEachFrame( mapped->Bytes(),
+                                        [ & ]( std::span< const std::byte > payload )
+                                        {
+                                            auto record = Decode< JournalRecord >( payload );
+                                            if ( !record )
+                                                return false;
+                                            if ( record->sequence <= m_sequence )
+                                                return true;
+
+                                            for ( const auto & command : record->commands )
+                                            {
+                                                m_applier.Apply( command );
+                                                if ( command.type == CommandType::Spawn )
+                                                    m_next_entity_id = std::max( m_next_entity_id, command.entity + 1 );
+                                            }
+                                            m_sequence = record->sequence;
+                                            ++stats.m_replayed_records;
+                                            stats.m_replayed_commands += record->commands.size();
+                                            return true;
+                                        } );
+        }
+
+        if ( intact_size == file_size )
+            continue;
+
+        // Only the segment being written when the process died can end in a torn record.
+        if ( i + 1 != segments.size() )
+            return std::unexpected( std::make_error_code( std::errc::illegal_byte_sequence ) );
+
+        std::filesystem::resize_file( segments[ i ].m_path, intact_size, ec );
+        if ( ec )
+            return std::unexpected( ec );
+        stats.m_truncated_tail = true;
+    }
+
+    return stats;
+}
+
+void shm::journal::WorldJournal::Restore( const WorldSnapshot & snapshot )
+{
+    m_applier.Load( snapshot );
+    m_sequence       = snapshot.sequence;
+    m_next_entity_id = snapshot.next_entity_id;
+
+    std::error_code ec;
+    std::filesystem::create_directories( m_settings.m_directory, ec );
+    RequestSnapshot();
+}
+
+void shm::journal::WorldJournal::Submit( WorldCommand command )
+{
+    m_applier.Apply( command );
+    m_staged.push_back( std::move( command ) );
+}
+
+void shm::journal::WorldJournal::CommitTick( uint64_t tick )
+{
+    if ( !m_staged.empty() )
+    {
+        JournalRecord record{ .sequence = ++m_sequence, .tick = tick, .commands = std::move( m_staged ) };
+        m_staged.clear();
+        {
+            std::scoped_lock lock( m_writer_mutex );
+            m_tasks.emplace_back( std::move( record ) );
+        }
+        m_writer_cv.notify_one();
+    }
+
+    ++m_ticks_since_snapshot;
+    if ( m_settings.m_snapshot_interval_ticks != 0 && m_ticks_since_snapshot >= m_settings.m_snapshot_interval_ticks )
+        RequestSnapshot();
+}
+
+void shm::journal::WorldJournal::RequestSnapshot()
+{
+    // Newer than anything a partial snapshot would still capture.
+    m_partial_snapshot.reset();
+    m_ticks_since_snapshot = 0;
+    SnapshotTask task{ m_applier.Capture( m_sequence, m_next_entity_id ) };
+    {
+        std::scoped_lock lock( m_writer_mutex );
+        m_tasks.emplace_back( std::move( task ) );
+    }
+    m_writer_cv.notify_one();
+}
+
+void shm::journal::WorldJournal::BeginSnapshot()
+{
+    m_ticks_since_snapshot = 0;
+    m_partial_snapshot     = PartialSnapshot{ .m_snapshot = { .sequence = m_sequence, .next_entity_id = m_next_entity_id } };
+    // Records committed while the snapshot is captured have to survive pruning the segments it covers.
+    {
+        std::scoped_lock lock( m_writer_mutex );
+        m_tasks.emplace_back( SegmentBreakTask{} );
+    }
+    m_writer_cv.notify_one();
+}
+
+bool shm::journal::WorldJournal::ContinueSnapshot( std::size_t max_ids )
+{
+    if ( !m_partial_snapshot )
+        return true;
+
+    // Ids allocated after the snapshot began belong to entities spawned by the records replayed on top of it.
+    auto & partial   = *m_partial_snapshot;
+    const auto end   = partial.m_snapshot.next_entity_id;
+    const auto until = partial.m_next_id + std::min< uint64_t >( max_ids, end - partial.m_next_id );
+    m_applier.CaptureRange( partial.m_next_id, until, partial.m_snapshot.entities );
+    partial.m_next_id = until;
+    if ( until < end )
+        return false;
+
+    SnapshotTask task{ std::move( partial.m_snapshot ) };
+    m_partial_snapshot.reset();
+    {
+        std::scoped_lock lock( m_writer_mutex );
+        m_tasks.emplace_back( std::move( task ) );
+    }
+    m_writer_cv.notify_one();
+    return true;
+}
+
+void shm::journal::WorldJournal::Flush()
+{
+    std::unique_lock lock( m_writer_mutex );
+    m_idle_cv.wait( lock, [ this ]() { return m_tasks.empty() && !m_writer_busy; } );
+}
+
+shm::Result< void > shm::journal::WorldJournal::WriterError() const
+{
+    std::scoped_lock lock( m_writer_mutex );
+    if ( m_writer_error )
+        return std::unexpected( m_writer_error );
+    return {};
+}
+
+void shm::journal::WorldJournal::RunWriter( std::stop_token stop )
+{
+    for ( ;; )
+    {
+        WriterTask task;
+        {
+            std::unique_lock lock( m_writer_mutex );
+            m_writer_cv.wait( lock, stop, [ this ]() { return !m_tasks.empty(); } );
+            // Whatever was committed before shutdown still gets written.
+            if ( m_tasks.empty() )
+                return;
+
+            task = std::move( m_tasks.front() );
+            m_tasks.pop_front();
+            m_writer_busy = true;
+        }
+
+        shm::Result< void > result;
+        if ( const auto * record = std::get_if< JournalRecord >( &task ) )
+            result = WriteRecord( *record );
+        else if ( const auto * snapshot = std::get_if< SnapshotTask >( &task ) )
+            result = WriteSnapshot( snapshot->m_snapshot );
+        else
+            CloseSegment();
+        {
+            std::scoped_lock lock( m_writer_mutex );
+            if ( !result.has_value() && !m_writer_error )
+                m_writer_error = result.error();
+            m_writer_busy = false;
+        }
+        m_idle_cv.notify_all();
+    }
+}
+
+shm::Result< void > shm::journal::WorldJournal::WriteRecord( const JournalRecord & record )
+{
+    if ( !m_segment )
+    {
+        const auto path = NumberedPath( m_settings.m_directory, SEGMENT_PREFIX, record.sequence, SEGMENT_EXTENSION );
+        m_segment       = std::fopen( path.string().c_str(), "ab" );
+        if ( !m_segment )
+            return std::unexpected( std::make_error_code( static_cast< std::errc >( errno ) ) );
+        std::error_code ec;
+        const auto size = std::filesystem::file_size( path, ec );
+        m_segment_path  = path;
+        m_segment_size  = ec ? 0 : size;
+    }
+
+    const auto payload = Encode( record );
+    auto written       = WriteFrame( m_segment, payload );
+    if ( written.has_value() )
+    {
+        // Flushed so a crash of the process loses nothing that was committed.
+        if ( m_settings.m_sync_on_commit )
+            written = SyncFile( m_segment );
+        else if ( std::fflush( m_segment ) != 0 )
+            written = std::unexpected( std::make_error_code( std::errc::io_error ) );
+    }
+
+    if ( !written.has_value() )
+    {
+        // A torn frame would end replay early and hide every record after it, so cut the segment back to its last
+        // whole frame and let the next record start a new one.
+        CloseSegment();
+        std::error_code ec;
+        std::filesystem::resize_file( m_segment_path, m_segment_size, ec );
+        return written;
+    }
+    m_segment_size += FRAME_HEADER_SIZE + payload.size();
+    return {};
+}
+
+shm::Result< void > shm::journal::WorldJournal::WriteSnapshot( const WorldSnapshot & snapshot )
+{
+    const auto path = NumberedPath( m_settings.m_directory, SNAPSHOT_PREFIX, snapshot.sequence, SNAPSHOT_EXTENSION );
+    auto temp_path  = path;
+    temp_path += ".tmp";
+
+    std::FILE * file = std::fopen( temp_path.string().c_str(), "wb" );
+    if ( !file )
+        return std::unexpected( std::make_error_code( static_cast< std::errc >( errno ) ) );
+
+    auto written = WriteFrame( file, Encode( snapshot ) );
+    if ( written.has_value() )
+        written = SyncFile( file );
+    std::fclose( file );
+    if ( !written.has_value() )
+        return written;
+
+    std::error_code ec;
+    std::filesystem::rename( temp_path, path, ec );
+    if ( ec )
+        return std::unexpected( ec );
+
+    // Records after the snapshot go to a new segment, so older segments can be dropped as a whole.
+    CloseSegment();
+    PruneOldFiles();
+    return {};
+}
+
+void shm::journal::WorldJournal::CloseSegment()
+{
+    if ( m_segment )
+    {
+        std::fclose( m_segment );
+        m_segment = nullptr;
+    }
+}
+
+void shm::journal::WorldJournal::PruneOldFiles()
+{
+    const auto snapshots   = ListNumbered( m_settings.m_directory, SNAPSHOT_PREFIX, SNAPSHOT_EXTENSION );
+    const std::size_t kept = std::max< std::size_t >( m_settings.m_snapshots_kept, 1 );
+    if ( snapshots.size() <= kept )
+        return;
+
+    std::error_code ec;
+    const auto oldest_kept = snapshots[ snapshots.size() - kept ].m_sequence;
+    for ( std::size_t i = 0; i + kept < snapshots.size(); ++i )
+        std::filesystem::remove( snapshots[ i ].m_path, ec );
+
+    // Segments start right after a snapshot (or a recovery), one starting at or before the oldest kept snapshot
+    // only holds records that snapshot already contains.
+    for ( const auto & segment : ListNumbered( m_settings.m_directory, SEGMENT_PREFIX, SEGMENT_EXTENSION ) )
+    {
+        if ( segment.m_sequence <= oldest_kept )
+            std::filesystem::remove( segment.m_path, ec );
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "WorldCommands.hpp"
+#include "results/Result.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <flecs.h>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+
+namespace shm::journal
+{
+    struct JournalSettings
+    {
+        /// @brief Holds "snapshot-<sequence>.bin" files and "journal-<first sequence>.log" segments.
+        std::filesystem::path m_directory{ "./journal" };
+        /// @brief Ticks between two snapshots, 0 only snapshots on request.
+        uint64_t m_snapshot_interval_ticks{ 120u * 60u };
+        /// @brief Snapshots kept, together with the journal segments needed to replay on top of the oldest one.
+        uint32_t m_snapshots_kept{ 2u };
+        /// @brief fsync every appended batch. Without it a power loss can drop the last batches, a crash cannot.
+        bool m_sync_on_commit{ false };
+    };
+
+    struct RecoveryStats
+    {
+        uint64_t m_snapshot_sequence    = 0;
+        std::size_t m_snapshot_entities = 0;
+        std::size_t m_replayed_records  = 0;
+        std::size_t m_replayed_commands = 0;
+        /// @brief A torn or corrupt record ended the journal, it was cut off there.
+        bool m_truncated_tail = false;
+    };
+
+    /// @brief Binary encoding snapshots are stored in, shared with other files embedding a world state.
+    [[nodiscard]] std::vector< char > EncodeSnapshot( const WorldSnapshot & snapshot );
+    [[nodiscard]] shm::Result< WorldSnapshot > DecodeSnapshot( std::span< const std::byte > payload );
+
+    /// @brief Applies world commands to flecs entities carrying a PersistentId.
+    class WorldApplier
+    {
+    public:
+        explicit WorldApplier( flecs::world & world );
+
+        void Apply( const WorldCommand & command );
+        void Load( const WorldSnapshot & snapshot );
+        /// @brief Copies the persistent state of every entity, sorted by id.
+        [[nodiscard]] WorldSnapshot Capture( uint64_t sequence, uint64_t next_entity_id ) const;
+        /// @brief Appends the persistent state of the entities with an id in [first_id, end_id), sorted by id.
+        void CaptureRange( uint64_t first_id, uint64_t end_id, std::vector< EntitySnapshot > & entities ) const;
+
+        [[nodiscard]] std::size_t EntityCount() const noexcept
+        {
+            return m_entities.size();
+        }
+
+    private:
+        flecs::world & m_world;
+        std::unordered_map< uint64_t, flecs::entity > m_entities;
+    };
+
+    /// @brief Event-sourced persistence of the broker world. Changes are submitted as commands, applied right away
+    /// and appended to the journal once per tick by a background writer, next to periodic snapshots.
+    /// Recovery loads the newest readable snapshot and replays the journal written after it.
+    class WorldJournal
+    {
+    public:
+        WorldJournal( flecs::world & world, JournalSettings settings );
+        ~WorldJournal();
+
+        WorldJournal( const WorldJournal & )             = delete;
+        WorldJournal & operator=( const WorldJournal & ) = delete;
+        WorldJournal( WorldJournal && )                  = delete;
+        WorldJournal & operator=( WorldJournal && )      = delete;
+
+        /// @brief Rebuilds the world from disk. Call once, before anything is submitted.
+        shm::Result< RecoveryStats > Recover();
+        /// @brief Starts from the given state instead of recovering, the directory has to be empty.
+        /// The state is snapshotted first, so the directory recovers to it as well.
+        void Restore( const WorldSnapshot & snapshot );
+
+        [[nodiscard]] uint64_t AllocateEntityId() noexcept
+        {
+            return m_next_entity_id++;
+        }
+
+        /// @brief Applies the command to the world and stages it for the current tick.
+        void Submit( WorldCommand command );
+        /// @brief Hands the staged commands to the writer and takes a snapshot when the interval elapsed.
+        void CommitTick( uint64_t tick );
+        /// @brief Captures the world now, serialization and writing happen on the writer thread.
+        void RequestSnapshot();
+        /// @brief Starts a snapshot that ContinueSnapshot captures a range of entity ids at a time, so a large world
+        /// never stalls a tick. It is taken as of the last committed tick, the ticks committed while it is captured are
+        /// replayed on top of it and leave every entity in its latest state whether it was captured before or after them.
+        void BeginSnapshot();
+        /// @brief Captures the next max_ids entity ids of the snapshot begun last and hands it to the writer once all are.
+        /// @return True once no snapshot is in progress anymore.
+        bool ContinueSnapshot( std::size_t max_ids );
+
+        [[nodiscard]] bool SnapshotInProgress() const noexcept
+        {
+            return m_partial_snapshot.has_value();
+        }
+        /// @brief Blocks until everything handed to the writer is written.
+        void Flush();
+
+        /// @brief First error the writer ran into, it keeps going with the next batch.
+        [[nodiscard]] shm::Result< void > WriterError() const;
+
+        /// @brief Persistent state of the world as of the last committed tick.
+        [[nodiscard]] WorldSnapshot CaptureState() const
+        {
+            return m_applier.Capture( m_sequence, m_next_entity_id );
+        }
+
+        /// @brief Commands submitted since the last CommitTick, in the order they were applied.
+        [[nodiscard]] std::span< const WorldCommand > StagedCommands() const noexcept
+        {
+            return m_staged;
+        }
+
+        [[nodiscard]] const WorldApplier & World() const noexcept
+        {
+            return m_applier;
+        }
+
+    private:
+        struct SnapshotTask
+        {
+            WorldSnapshot m_snapshot;
+        };
+        /// @brief Starts the records after it in a new segment.
+        struct SegmentBreakTask
+        {
+        };
+        using WriterTask = std::variant< JournalRecord, SnapshotTask, SegmentBreakTask >;
+
+        /// @brief A snapshot begun by BeginSnapshot, captured up to m_next_id.
+        struct PartialSnapshot
+        {
+            WorldSnapshot m_snapshot;
+            uint64_t m_next_id = 1;
+        };
+
+        void RunWriter( std::stop_token stop );
+        shm::Result< void > WriteRecord( const JournalRecord & record );
+        shm::Result< void > WriteSnapshot( const WorldSnapshot & snapshot );
+        void CloseSegment();
+        void PruneOldFiles();
+
+        JournalSettings m_settings;
+        WorldApplier m_applier;
+        uint64_t m_next_entity_id       = 1;
+        uint64_t m_sequence             = 0;
+        uint64_t m_ticks_since_snapshot = 0;
+        std::vector< WorldCommand > m_staged;
+        std::optional< PartialSnapshot > m_partial_snapshot;
+
+        mutable std::mutex m_writer_mutex;
+        std::condition_variable_any m_writer_cv;
+        std::condition_variable m_idle_cv;
+        std::deque< WriterTask > m_tasks;
+        bool m_writer_busy = false;
+        std::error_code m_writer_error;
+
+        /// @brief Only touched by the writer thread.
+        std::FILE * m_segment = nullptr;
+        std::filesystem::path m_segment_path;
+        /// @brief Bytes of whole frames in the open segment, what a failed write is cut back to.
+        uint64_t m_segment_size = 0;
+        std::jthread m_writer;
+    };
+} // namespace shm::journal
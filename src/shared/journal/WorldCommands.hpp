@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/// @brief Persistent broker world state and the commands changing it. Field names follow the serialized
+/// structures elsewhere (configs), the binary encoding does not store them.
+namespace shm::journal
+{
+    /// @brief Identity of an entity across restarts, flecs ids are not stable.
+    struct PersistentId
+    {
+        uint64_t value = 0;
+    };
+
+    struct Transform
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+    };
+
+    /// @brief The session and world an entity currently belongs to.
+    struct Presence
+    {
+        uint64_t session_id = 0;
+        uint32_t world_id   = 0;
+    };
+
+    enum class CommandType : uint8_t
+    {
+        Spawn,
+        Destroy,
+        SetTransform,
+        SetPresence,
+    };
+
+    struct WorldCommand
+    {
+        CommandType type = CommandType::Spawn;
+        uint64_t entity  = 0;
+        std::optional< Transform > transform;
+        std::optional< Presence > presence;
+
+        static WorldCommand Spawn( uint64_t entity )
+        {
+            return { .type = CommandType::Spawn, .entity = entity };
+        }
+
+        static WorldCommand Destroy( uint64_t entity )
+        {
+            return { .type = CommandType::Destroy, .entity = entity };
+        }
+
+        static WorldCommand Set( uint64_t entity, const Transform & value )
+        {
+            return { .type = CommandType::SetTransform, .entity = entity, .transform = value };
+        }
+
+        static WorldCommand Set( uint64_t entity, const Presence & value )
+        {
+            return { .type = CommandType::SetPresence, .entity = entity, .presence = value };
+        }
+    };
+
+    /// @brief All commands of one tick, the unit the journal is appended in.
+    struct JournalRecord
+    {
+        uint64_t sequence = 0;
+        uint64_t tick     = 0;
+        std::vector< WorldCommand > commands;
+    };
+
+    struct EntitySnapshot
+    {
+        uint64_t id = 0;
+        std::optional< Transform > transform;
+        std::optional< Presence > presence;
+    };
+
+    /// @brief World state after the journal record with the given sequence was applied.
+    struct WorldSnapshot
+    {
+        uint64_t sequence       = 0;
+        uint64_t next_entity_id = 1;
+        std::vector< EntitySnapshot > entities;
+    };
+} // namespace shm::journal
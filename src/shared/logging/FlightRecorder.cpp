@@ -0,0 +1,509 @@
+#include "FlightRecorder.hpp"
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <string_view>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    enum class RecordKind : uint8_t
+    {
+        Log,
+        Frame,
+    };
+
+    struct Record
+    {
+        int64_t m_time_ns    = 0;
+        uint64_t m_thread_id = 0;
+        uint64_t m_tick      = 0;
+        uint64_t m_frame_ns  = 0;
+        RecordKind m_kind    = RecordKind::Log;
+        uint8_t m_level      = 0;
+        uint16_t m_length    = 0;
+        std::array< char, 220 > m_payload;
+    };
+    static_assert( sizeof( Record ) == 256 );
+
+    /// @brief Single-producer ring, only the owning thread writes. Rings are never freed, so a signal handler can
+    /// walk them without taking any lock. A thread that exits hands its ring to the next thread starting, until
+    /// then the records of the exited thread survive.
+    struct ThreadRing
+    {
+        std::atomic< uint64_t > m_head{ 0 };
+        std::atomic< uint64_t > m_tail{ 0 };
+        std::atomic< bool > m_owned{ true };
+        std::array< Record, shm::flight::RecordsPerThread > m_records;
+    };
+
+    std::array< std::atomic< ThreadRing * >, shm::flight::MaxThreads > G_RINGS{};
+    std::atomic< std::size_t > G_RING_COUNT{ 0 };
+
+    /// @brief The ring of the calling thread, released on thread exit.
+    struct RingOwner
+    {
+        ThreadRing * m_ring = nullptr;
+        bool m_rejected     = false;
+
+        ~RingOwner()
+        {
+            if ( m_ring )
+                m_ring->m_owned.store( false, std::memory_order_release );
+            // Records made by thread local destructors running after this one are dropped.
+            m_ring     = nullptr;
+            m_rejected = true;
+        }
+    };
+
+    ThreadRing * AcquireRing() noexcept
+    {
+        const auto ring_count = std::min( G_RING_COUNT.load( std::memory_order_acquire ), shm::flight::MaxThreads );
+        for ( std::size_t i = 0; i < ring_count; ++i )
+        {
+            ThreadRing * ring = G_RINGS[ i ].load( std::memory_order_acquire );
+            bool owned        = false;
+            if ( ring && ring->m_owned.compare_exchange_strong( owned, true, std::memory_order_acquire ) )
+                return ring;
+        }
+
+        const auto index = G_RING_COUNT.fetch_add( 1, std::memory_order_relaxed );
+        if ( index >= shm::flight::MaxThreads )
+            return nullptr;
+        auto * ring = new ThreadRing();
+        G_RINGS[ index ].store( ring, std::memory_order_release );
+        return ring;
+    }
+
+    ThreadRing * LocalRing() noexcept
+    {
+        static thread_local RingOwner S_OWNER;
+        if ( !S_OWNER.m_ring && !S_OWNER.m_rejected ) [[unlikely]]
+        {
+            S_OWNER.m_ring     = AcquireRing();
+            S_OWNER.m_rejected = S_OWNER.m_ring == nullptr;
+        }
+        return S_OWNER.m_ring;
+    }
+
+    Record * BeginRecord() noexcept
+    {
+        ThreadRing * ring = LocalRing();
+        if ( !ring )
+            return nullptr;
+        return &ring->m_records[ ring->m_head.load( std::memory_order_relaxed ) % shm::flight::RecordsPerThread ];
+    }
+
+    void CommitRecord() noexcept
+    {
+        ThreadRing * ring = LocalRing();
+        ring->m_head.store( ring->m_head.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+
+    void RecordLogMessage( spdlog::log_clock::time_point time, std::size_t thread_id, spdlog::level::level_enum level,
+                           std::string_view payload ) noexcept
+    {
+        Record * record = BeginRecord();
+        if ( !record )
+            return;
+
+        record->m_time_ns   = std::chrono::duration_cast< std::chrono::nanoseconds >( time.time_since_epoch() ).count();
+        record->m_thread_id = thread_id;
+        record->m_kind      = RecordKind::Log;
+        record->m_level     = static_cast< uint8_t >( level );
+        record->m_length    = static_cast< uint16_t >( std::min( payload.size(), record->m_payload.size() ) );
+        std::memcpy( record->m_payload.data(), payload.data(), record->m_length );
+        CommitRecord();
+    }
+
+    class FlightRecorderSink final : public spdlog::sinks::base_sink< spdlog::details::null_mutex >
+    {
+    protected:
+        void sink_it_( const spdlog::details::log_msg & msg ) override
+        {
+            RecordLogMessage( msg.time, msg.thread_id, msg.level, std::string_view( msg.payload.data(), msg.payload.size() ) );
+        }
+
+        void flush_() override
+        {
+        }
+    };
+
+    /** DUMP **/
+    // Everything below runs inside the fatal signal handler too: no allocation, no locks, no stdio.
+
+#ifdef _WIN32
+    int OpenForWrite( const char * path ) noexcept
+    {
+        return _open( path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE );
+    }
+
+    void WriteAll( int fd, const char * data, std::size_t size ) noexcept
+    {
+        while ( size > 0 )
+        {
+            const int written = _write( fd, data, static_cast< unsigned >( size ) );
+            if ( written <= 0 )
+                return;
+            data += written;
+            size -= static_cast< std::size_t >( written );
+        }
+    }
+
+    void CloseFile( int fd ) noexcept
+    {
+        _close( fd );
+    }
+#else
+    int OpenForWrite( const char * path ) noexcept
+    {
+        return open( path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+    }
+
+    void WriteAll( int fd, const char * data, std::size_t size ) noexcept
+    {
+        while ( size > 0 )
+        {
+            const auto written = write( fd, data, size );
+            if ( written < 0 && errno == EINTR )
+                continue;
+            if ( written <= 0 )
+                return;
+            data += written;
+            size -= static_cast< std::size_t >( written );
+        }
+    }
+
+    void CloseFile( int fd ) noexcept
+    {
+        close( fd );
+    }
+#endif
+
+    /// @brief Fixed size output buffer flushed to a file descriptor.
+    class FdWriter
+    {
+    public:
+        explicit FdWriter( int fd ) noexcept
+            : m_fd( fd )
+        {
+        }
+
+        ~FdWriter()
+        {
+            Flush();
+        }
+
+        FdWriter( const FdWriter & )             = delete;
+        FdWriter & operator=( const FdWriter & ) = delete;
+
+        void Append( std::string_view text ) noexcept
+        {
+            while ( !text.empty() )
+            {
+                const auto chunk = std::min( text.size(), m_buffer.size() - m_size );
+                std::memcpy( m_buffer.data() + m_size, text.data(), chunk );
+                m_size += chunk;
+                text.remove_prefix( chunk );
+                if ( m_size == m_buffer.size() )
+                    Flush();
+            }
+        }
+
+        void AppendUnsigned( uint64_t value, int min_width = 0 ) noexcept
+        {
+            std::array< char, 24 > digits{};
+            int count = 0;
+            do
+            {
+                digits[ count++ ] = static_cast< char >( '0' + value % 10 );
+                value /= 10;
+            } while ( value != 0 );
+            for ( ; count < min_width; ++count )
+                digits[ count ] = '0';
+
+            std::array< char, 24 > text{};
+            for ( int i = 0; i < count; ++i )
+                text[ i ] = digits[ count - 1 - i ];
+            Append( std::string_view( text.data(), static_cast< std::size_t >( count ) ) );
+        }
+
+        void Flush() noexcept
+        {
+            WriteAll( m_fd, m_buffer.data(), m_size );
+            m_size = 0;
+        }
+
+    private:
+        int m_fd;
+        std::size_t m_size = 0;
+        std::array< char, 8192 > m_buffer;
+    };
+
+    /// @brief UTC "YYYY-MM-DD HH:MM:SS.nnnnnnnnn", days to civil date after H. Hinnant's algorithm.
+    void AppendTimestamp( FdWriter & out, int64_t time_ns ) noexcept
+    {
+        const int64_t seconds = time_ns >= 0 ? time_ns / 1'000'000'000 : ( time_ns - 999'999'999 ) / 1'000'000'000;
+        const int64_t nanos   = time_ns - seconds * 1'000'000'000;
+        const int64_t days    = seconds >= 0 ? seconds / 86400 : ( seconds - 86399 ) / 86400;
+        const int64_t second  = seconds - days * 86400;
+
+        const int64_t z     = days + 719468;
+        const int64_t era   = ( z >= 0 ? z : z - 146096 ) / 146097;
+        const int64_t doe   = z - era * 146097;
+        const int64_t yoe   = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+        const int64_t doy   = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+        const int64_t mp    = ( 5 * doy + 2 ) / 153;
+        const int64_t day   = doy - ( 153 * mp + 2 ) / 5 + 1;
+        const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+        const int64_t year  = yoe + era * 400 + ( month <= 2 ? 1 : 0 );
+
+        out.AppendUnsigned( static_cast< uint64_t >( year ), 4 );
+        out.Append( "-" );
+        out.AppendUnsigned( static_cast< uint64_t >( month ), 2 );
+        out.Append( "-" );
+        out.AppendUnsigned( static_cast< uint64_t >( day ), 2 );
+        out.Append( " " );
+        out.AppendUnsigned( static_cast< uint64_t >( second / 3600 ), 2 );
+        out.Append( ":" );
+        out.AppendUnsigned( static_cast< uint64_t >( second / 60 % 60 ), 2 );
+        out.Append( ":" );
+        out.AppendUnsigned( static_cast< uint64_t >( second % 60 ), 2 );
+        out.Append( "." );
+        out.AppendUnsigned( static_cast< uint64_t >( nanos ), 9 );
+    }
+
+    constexpr std::array< std::string_view, 7 > G_LEVEL_NAMES{ "trace", "debug", "info", "warning", "error", "critical", "off" };
+
+    void AppendRecord( FdWriter & out, const Record & record ) noexcept
+    {
+        out.Append( "[" );
+        AppendTimestamp( out, record.m_time_ns );
+        out.Append( "] [" );
+        if ( record.m_kind == RecordKind::Frame )
+        {
+            out.Append( "frame@thread:" );
+            out.AppendUnsigned( record.m_thread_id );
+            out.Append( "] tick " );
+            out.AppendUnsigned( record.m_tick );
+            out.Append( " took " );
+            out.AppendUnsigned( record.m_frame_ns / 1000 );
+            out.Append( "us\n" );
+            return;
+        }
+
+        out.Append( G_LEVEL_NAMES[ std::min< std::size_t >( record.m_level, G_LEVEL_NAMES.size() - 1 ) ] );
+        out.Append( "@thread:" );
+        out.AppendUnsigned( record.m_thread_id );
+        out.Append( "] " );
+        out.Append( std::string_view( record.m_payload.data(), std::min< std::size_t >( record.m_length, record.m_payload.size() ) ) );
+        out.Append( "\n" );
+    }
+
+    /// @brief Merges the rings by time. Each ring is already ordered, so this repeatedly takes the oldest head.
+    void DumpToFd( int fd ) noexcept
+    {
+        struct Cursor
+        {
+            const ThreadRing * m_ring = nullptr;
+            uint64_t m_next           = 0;
+            uint64_t m_end            = 0;
+        };
+
+        std::array< Cursor, shm::flight::MaxThreads > cursors{};
+        const auto ring_count = std::min( G_RING_COUNT.load( std::memory_order_acquire ), shm::flight::MaxThreads );
+        for ( std::size_t i = 0; i < ring_count; ++i )
+        {
+            const ThreadRing * ring = G_RINGS[ i ].load( std::memory_order_acquire );
+            if ( !ring )
+                continue;
+
+            const uint64_t head = ring->m_head.load( std::memory_order_acquire );
+            const uint64_t tail = ring->m_tail.load( std::memory_order_relaxed );
+            cursors[ i ]        = { ring, std::max( tail, head > shm::flight::RecordsPerThread ? head - shm::flight::RecordsPerThread : 0 ), head };
+        }
+
+        FdWriter out( fd );
+        for ( ;; )
+        {
+            const Record * oldest = nullptr;
+            Cursor * oldest_cursor = nullptr;
+            for ( std::size_t i = 0; i < ring_count; ++i )
+            {
+                Cursor & cursor = cursors[ i ];
+                if ( cursor.m_next >= cursor.m_end )
+                    continue;
+
+                const Record & record = cursor.m_ring->m_records[ cursor.m_next % shm::flight::RecordsPerThread ];
+                if ( !oldest || record.m_time_ns < oldest->m_time_ns )
+                {
+                    oldest        = &record;
+                    oldest_cursor = &cursor;
+                }
+            }
+            if ( !oldest )
+                break;
+
+            AppendRecord( out, *oldest );
+            ++oldest_cursor->m_next;
+        }
+    }
+
+    /** FATAL SIGNALS **/
+
+    constexpr std::array< int, 5 > G_FATAL_SIGNALS{ SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#ifdef _WIN32
+                                                    SIGTERM };
+#else
+                                                    SIGBUS };
+#endif
+
+    std::array< char, 4096 > G_SIGNAL_DUMP_PATH{};
+    std::atomic< bool > G_SIGNAL_DUMP_DONE{ false };
+
+#ifdef _WIN32
+    using PreviousHandler = void ( * )( int );
+    std::array< PreviousHandler, G_FATAL_SIGNALS.size() > G_PREVIOUS_HANDLERS{};
+#else
+    std::array< struct sigaction, G_FATAL_SIGNALS.size() > G_PREVIOUS_HANDLERS{};
+#endif
+    bool G_HANDLERS_INSTALLED = false;
+
+    void RestorePreviousHandlers() noexcept
+    {
+        for ( std::size_t i = 0; i < G_FATAL_SIGNALS.size(); ++i )
+        {
+#ifdef _WIN32
+            std::signal( G_FATAL_SIGNALS[ i ], G_PREVIOUS_HANDLERS[ i ] );
+#else
+            sigaction( G_FATAL_SIGNALS[ i ], &G_PREVIOUS_HANDLERS[ i ], nullptr );
+#endif
+        }
+        G_HANDLERS_INSTALLED = false;
+    }
+
+    void OnFatalSignal( int signal_number )
+    {
+        if ( !G_SIGNAL_DUMP_DONE.exchange( true ) )
+        {
+            const int fd = OpenForWrite( G_SIGNAL_DUMP_PATH.data() );
+            if ( fd >= 0 )
+            {
+                DumpToFd( fd );
+                CloseFile( fd );
+            }
+        }
+
+        // Hand the signal to whoever was installed before us, e.g. the crash handler writing the minidump.
+        RestorePreviousHandlers();
+        std::raise( signal_number );
+    }
+} // namespace
+
+std::shared_ptr< spdlog::sinks::sink > shm::flight::MakeSink( spdlog::level::level_enum level )
+{
+    auto sink = std::make_shared< FlightRecorderSink >();
+    sink->set_level( level );
+    return sink;
+}
+
+void shm::flight::RecordLog( spdlog::level::level_enum level, std::string_view payload ) noexcept
+{
+    RecordLogMessage( spdlog::log_clock::now(), spdlog::details::os::thread_id(), level, payload );
+}
+
+void shm::flight::RecordFrame( uint64_t tick, uint64_t frame_ns ) noexcept
+{
+    Record * record = BeginRecord();
+    if ( !record )
+        return;
+
+    record->m_time_ns = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::system_clock::now().time_since_epoch() ).count();
+    record->m_thread_id = spdlog::details::os::thread_id();
+    record->m_tick      = tick;
+    record->m_frame_ns  = frame_ns;
+    record->m_kind      = RecordKind::Frame;
+    CommitRecord();
+}
+
+shm::Result< void > shm::flight::Dump( const std::filesystem::path & path )
+{
+    if ( path.has_parent_path() )
+    {
+        std::error_code ec;
+        std::filesystem::create_directories( path.parent_path(), ec );
+        if ( ec )
+            return std::unexpected( ec );
+    }
+
+    const int fd = OpenForWrite( path.string().c_str() );
+    if ( fd < 0 )
+        return std::unexpected( std::make_error_code( static_cast< std::errc >( errno ) ) );
+
+    DumpToFd( fd );
+    CloseFile( fd );
+    return {};
+}
+
+void shm::flight::InstallFatalSignalHandler( const std::filesystem::path & path )
+{
+    if ( G_HANDLERS_INSTALLED )
+        UninstallFatalSignalHandler();
+
+    std::error_code ec;
+    if ( path.has_parent_path() )
+        std::filesystem::create_directories( path.parent_path(), ec );
+
+    // Resolved now, the handler must not allocate.
+    const auto path_string = std::filesystem::absolute( path, ec ).string();
+    const auto length      = std::min( path_string.size(), G_SIGNAL_DUMP_PATH.size() - 1 );
+    std::memcpy( G_SIGNAL_DUMP_PATH.data(), path_string.data(), length );
+    G_SIGNAL_DUMP_PATH[ length ] = '\0';
+    G_SIGNAL_DUMP_DONE.store( false );
+
+    for ( std::size_t i = 0; i < G_FATAL_SIGNALS.size(); ++i )
+    {
+#ifdef _WIN32
+        G_PREVIOUS_HANDLERS[ i ] = std::signal( G_FATAL_SIGNALS[ i ], &OnFatalSignal );
+#else
+        struct sigaction action{};
+        action.sa_handler = &OnFatalSignal;
+        sigemptyset( &action.sa_mask );
+        action.sa_flags = SA_ONSTACK;
+        sigaction( G_FATAL_SIGNALS[ i ], &action, &G_PREVIOUS_HANDLERS[ i ] );
+#endif
+    }
+    G_HANDLERS_INSTALLED = true;
+}
+
+void shm::flight::UninstallFatalSignalHandler()
+{
+    if ( G_HANDLERS_INSTALLED )
+        RestorePreviousHandlers();
+}
+
+void shm::flight::Clear() noexcept
+{
+    const auto ring_count = std::min( G_RING_COUNT.load( std::memory_order_acquire ), MaxThreads );
+    for ( std::size_t i = 0; i < ring_count; ++i )
+    {
+        if ( ThreadRing * ring = G_RINGS[ i ].load( std::memory_order_acquire ) )
+            ring->m_tail.store( ring->m_head.load( std::memory_order_acquire ), std::memory_order_relaxed );
+    }
+}
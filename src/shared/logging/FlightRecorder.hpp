@@ -0,0 +1,48 @@
+#pragma once
+
+#include "results/Result.hpp"
+
+#include <spdlog/common.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+namespace spdlog::sinks
+{
+    class sink;
+}
+
+/// @brief In-memory flight recorder of the most recent log records and frame timings of every thread.
+/// Records are copied unformatted into a per-thread ring, the log pattern is only applied when the
+/// recorder is dumped, either explicitly or from a fatal signal. Rings of exited threads are reused.
+namespace shm::flight
+{
+    /// @brief Records kept per thread, older records are overwritten.
+    constexpr std::size_t RecordsPerThread = 4096;
+    /// @brief Threads running at the same time beyond this limit are not recorded.
+    constexpr std::size_t MaxThreads = 128;
+
+    /// @brief spdlog sink storing every record at or above the level into the calling thread's ring.
+    std::shared_ptr< spdlog::sinks::sink > MakeSink( spdlog::level::level_enum level );
+
+    /// @brief Records an already formatted message on the calling thread, used for records below the logger level.
+    void RecordLog( spdlog::level::level_enum level, std::string_view payload ) noexcept;
+
+    /// @brief Records the duration of a finished tick on the calling thread.
+    void RecordFrame( uint64_t tick, uint64_t frame_ns ) noexcept;
+
+    /// @brief Writes the records of all threads, merged by time, as text.
+    /// Records written concurrently with the dump may be missing or torn.
+    shm::Result< void > Dump( const std::filesystem::path & path );
+
+    /// @brief Dumps to the path when the process receives SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT, then passes
+    /// the signal on to the previously installed handler (e.g. the crash handler). The dump path is async-signal-safe.
+    void InstallFatalSignalHandler( const std::filesystem::path & path );
+    void UninstallFatalSignalHandler();
+
+    /// @brief Drops every recorded entry.
+    void Clear() noexcept;
+} // namespace shm::flight
@@ -0,0 +1,169 @@
+#include "LogLevels.hpp"
+#include "FlightRecorder.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <vector>
+
+constinit shm::LogCategory shm::log::detail::G_DEFAULT_CATEGORY{ shm::log::detail::DefaultCategoryTag{} };
+
+namespace shm
+{
+    struct LogLevelRegistry
+    {
+        static LogLevelRegistry & Get()
+        {
+            static LogLevelRegistry S_REGISTRY;
+            return S_REGISTRY;
+        }
+
+        void Register( LogCategory & category, std::string_view name )
+        {
+            std::scoped_lock lock( m_mutex );
+            category.m_name = *m_names.emplace( name ).first;
+            m_categories.push_back( &category );
+            Store( category, LevelOf( category.m_name ) );
+        }
+
+        void Unregister( LogCategory & category )
+        {
+            std::scoped_lock lock( m_mutex );
+            std::erase( m_categories, &category );
+        }
+
+        template< typename Fn >
+        void Update( Fn && update )
+        {
+            std::scoped_lock lock( m_mutex );
+            update();
+
+            Store( log::detail::G_DEFAULT_CATEGORY, m_default_level );
+            for ( LogCategory * category : m_categories )
+                Store( *category, LevelOf( category->m_name ) );
+
+            // Plain spdlog calls and everything the SHM_LOG_* macros route to the logger pass its level.
+            if ( auto * logger = spdlog::default_logger_raw() )
+                logger->set_level( LowestLevelLocked() );
+        }
+
+        spdlog::level::level_enum LowestLevel()
+        {
+            std::scoped_lock lock( m_mutex );
+            return LowestLevelLocked();
+        }
+
+        spdlog::level::level_enum m_default_level = spdlog::level::info;
+        spdlog::level::level_enum m_capture_level = spdlog::level::off;
+        std::map< std::string, spdlog::level::level_enum, std::less<> > m_overrides;
+
+    private:
+        spdlog::level::level_enum LevelOf( std::string_view name ) const
+        {
+            auto iter = m_overrides.find( name );
+            return iter != m_overrides.end() ? iter->second : m_default_level;
+        }
+
+        spdlog::level::level_enum LowestLevelLocked() const
+        {
+            auto lowest = m_default_level;
+            for ( const auto & [ name, level ] : m_overrides )
+                lowest = std::min( lowest, level );
+            return lowest;
+        }
+
+        void Store( LogCategory & category, spdlog::level::level_enum level ) const
+        {
+            category.m_levels.store( static_cast< uint16_t >( level | ( m_capture_level << 8 ) ), std::memory_order_relaxed );
+        }
+
+        std::mutex m_mutex;
+        std::set< std::string, std::less<> > m_names;
+        std::vector< LogCategory * > m_categories;
+    };
+
+    LogCategory::LogCategory( std::string_view name )
+    {
+        LogLevelRegistry::Get().Register( *this, name );
+    }
+
+    LogCategory::~LogCategory()
+    {
+        if ( this != &log::detail::G_DEFAULT_CATEGORY )
+            LogLevelRegistry::Get().Unregister( *this );
+    }
+} // namespace shm
+
+void shm::log::SetDefaultLevel( spdlog::level::level_enum level )
+{
+    auto & registry = LogLevelRegistry::Get();
+    registry.Update( [ & ]() { registry.m_default_level = level; } );
+}
+
+void shm::log::SetCategoryLevel( std::string_view name, spdlog::level::level_enum level )
+{
+    auto & registry = LogLevelRegistry::Get();
+    registry.Update( [ & ]() { registry.m_overrides.insert_or_assign( std::string( name ), level ); } );
+}
+
+void shm::log::ClearCategoryLevels()
+{
+    auto & registry = LogLevelRegistry::Get();
+    registry.Update( [ & ]() { registry.m_overrides.clear(); } );
+}
+
+void shm::log::SetCaptureLevel( spdlog::level::level_enum level )
+{
+    auto & registry = LogLevelRegistry::Get();
+    registry.Update( [ & ]() { registry.m_capture_level = level; } );
+}
+
+shm::Result< void > shm::log::ApplyLevels( const LogLevelsConfig & config )
+{
+    auto parse = []( std::string_view name ) -> shm::Result< spdlog::level::level_enum >
+    {
+        const auto level = spdlog::level::from_str( std::string( name ) );
+        if ( level == spdlog::level::off && name != "off" )
+            return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+        return level;
+    };
+
+    std::optional< spdlog::level::level_enum > default_level;
+    if ( !config.default_level.empty() )
+    {
+        auto level = parse( config.default_level );
+        if ( !level.has_value() )
+            return std::unexpected( level.error() );
+        default_level = *level;
+    }
+
+    std::map< std::string, spdlog::level::level_enum, std::less<> > overrides;
+    for ( const auto & [ name, level_name ] : config.categories )
+    {
+        auto level = parse( level_name );
+        if ( !level.has_value() )
+            return std::unexpected( level.error() );
+        overrides.emplace( name, *level );
+    }
+
+    auto & registry = LogLevelRegistry::Get();
+    registry.Update(
+        [ & ]()
+        {
+            registry.m_default_level = default_level.value_or( registry.m_default_level );
+            registry.m_overrides     = std::move( overrides );
+        } );
+    return {};
+}
+
+spdlog::level::level_enum shm::log::LowestLevel()
+{
+    return LogLevelRegistry::Get().LowestLevel();
+}
+
+void shm::log::detail::CaptureFormatted( spdlog::level::level_enum level, std::string_view payload ) noexcept
+{
+    shm::flight::RecordLog( level, payload );
+}
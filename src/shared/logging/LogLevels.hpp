@@ -0,0 +1,209 @@
+#pragma once
+
+#include "results/Result.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Compile-time minimum level, SHM_LOG_* calls below it are removed entirely. Defaults to info in release builds.
+#define SHM_LOG_LEVEL_TRACE    0
+#define SHM_LOG_LEVEL_DEBUG    1
+#define SHM_LOG_LEVEL_INFO     2
+#define SHM_LOG_LEVEL_WARN     3
+#define SHM_LOG_LEVEL_ERROR    4
+#define SHM_LOG_LEVEL_CRITICAL 5
+#define SHM_LOG_LEVEL_OFF      6
+
+#ifndef SHM_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define SHM_LOG_ACTIVE_LEVEL SHM_LOG_LEVEL_INFO
+#else
+#define SHM_LOG_ACTIVE_LEVEL SHM_LOG_LEVEL_TRACE
+#endif
+#endif
+
+namespace shm
+{
+    namespace log::detail
+    {
+        struct DefaultCategoryTag
+        {
+        };
+    } // namespace log::detail
+
+    /// @brief Where a record of a given level goes for a category.
+    enum class LogRoute : uint8_t
+    {
+        Drop,
+        FlightRecorder,
+        Logger,
+    };
+
+    /// @brief Named set of log statements with its own runtime level, e.g. one per module.
+    /// Categories are usually static objects, a LogScope constructed from one makes it the current category
+    /// of the thread, which SHM_LOG_* without an explicit category log to.
+    struct LogCategory
+    {
+        explicit LogCategory( std::string_view name );
+        constexpr explicit LogCategory( log::detail::DefaultCategoryTag )
+            : m_name( "default" )
+        {
+        }
+        ~LogCategory();
+
+        LogCategory()                                  = delete;
+        LogCategory( const LogCategory & )             = delete;
+        LogCategory & operator=( const LogCategory & ) = delete;
+        LogCategory( LogCategory && )                  = delete;
+        LogCategory & operator=( LogCategory && )      = delete;
+
+        [[nodiscard]] std::string_view Name() const noexcept
+        {
+            return m_name;
+        }
+
+        [[nodiscard]] spdlog::level::level_enum Level() const noexcept
+        {
+            return static_cast< spdlog::level::level_enum >( m_levels.load( std::memory_order_relaxed ) & 0xFF );
+        }
+
+        /// @brief One relaxed load: records at or above the category level go to the logger, records below it
+        /// but at or above the capture level only to the flight recorder.
+        [[nodiscard]] LogRoute Route( spdlog::level::level_enum level ) const noexcept
+        {
+            const uint16_t levels = m_levels.load( std::memory_order_relaxed );
+            if ( level >= ( levels & 0xFF ) )
+                return LogRoute::Logger;
+            if ( level >= ( levels >> 8 ) )
+                return LogRoute::FlightRecorder;
+            return LogRoute::Drop;
+        }
+
+    private:
+        friend struct LogLevelRegistry;
+
+        /// @brief Interned by the registry, so it outlives the category.
+        std::string_view m_name;
+        /// @brief Low byte is the category level, high byte the capture level.
+        std::atomic< uint16_t > m_levels{ spdlog::level::info | ( spdlog::level::off << 8 ) };
+    };
+
+    namespace log::detail
+    {
+        extern constinit LogCategory G_DEFAULT_CATEGORY;
+    }
+
+    /// @brief Category of every log statement outside a categorized LogScope, its level is the logger level.
+    inline LogCategory & DefaultLogCategory() noexcept
+    {
+        return log::detail::G_DEFAULT_CATEGORY;
+    }
+
+    /// @brief Level overrides, hot-reloaded from the "LogLevels" config.
+    struct LogLevelsConfig
+    {
+        static constexpr uint32_t ConfigVersion = 1;
+
+        /// @brief spdlog level name ("trace", "debug", "info", "warning", "error", "critical", "off"),
+        /// empty keeps the level the logger was created with.
+        std::string default_level;
+        /// @brief Category name to spdlog level name.
+        std::map< std::string, std::string > categories;
+    };
+
+    namespace log
+    {
+        /// @brief Level of the default category and of every category without an override.
+        void SetDefaultLevel( spdlog::level::level_enum level );
+        /// @brief Overrides the level of every category with the name, including ones created later.
+        void SetCategoryLevel( std::string_view name, spdlog::level::level_enum level );
+        void ClearCategoryLevels();
+        /// @brief Level records below the category level are still kept in the flight recorder at, off disables it.
+        void SetCaptureLevel( spdlog::level::level_enum level );
+        /// @brief Replaces the default level and all overrides, nothing changes if a level name is unknown.
+        shm::Result< void > ApplyLevels( const LogLevelsConfig & config );
+        /// @brief Lowest level any category logs at, the level the default spdlog logger is kept at.
+        spdlog::level::level_enum LowestLevel();
+
+        namespace detail
+        {
+            inline thread_local LogCategory * S_CURRENT_CATEGORY = nullptr;
+
+            void CaptureFormatted( spdlog::level::level_enum level, std::string_view payload ) noexcept;
+
+            template< typename... Args >
+            void Capture( spdlog::level::level_enum level, fmt::format_string< Args... > format, Args &&... args )
+            {
+                fmt::memory_buffer buffer;
+                fmt::format_to( std::back_inserter( buffer ), format, std::forward< Args >( args )... );
+                CaptureFormatted( level, std::string_view( buffer.data(), buffer.size() ) );
+            }
+        } // namespace detail
+
+        /// @brief Category of the innermost categorized LogScope of the thread, or the default category.
+        inline LogCategory & CurrentCategory() noexcept
+        {
+            LogCategory * category = detail::S_CURRENT_CATEGORY;
+            return category ? *category : DefaultLogCategory();
+        }
+    } // namespace log
+} // namespace shm
+
+#define SHM_LOG_TO( category, level, ... )                                                 \
+    do                                                                                     \
+    {                                                                                      \
+        const ::shm::LogRoute shm_log_route_ = ( category ).Route( level );                \
+        if ( shm_log_route_ == ::shm::LogRoute::Logger )                                   \
+            ::spdlog::log( level, __VA_ARGS__ );                                           \
+        else if ( shm_log_route_ == ::shm::LogRoute::FlightRecorder ) [[unlikely]]         \
+            ::shm::log::detail::Capture( level, __VA_ARGS__ );                             \
+    } while ( false )
+
+#if SHM_LOG_ACTIVE_LEVEL <= SHM_LOG_LEVEL_TRACE
+#define SHM_LOG_TRACE_TO( category, ... ) SHM_LOG_TO( category, ::spdlog::level::trace, __VA_ARGS__ )
+#else
+#define SHM_LOG_TRACE_TO( category, ... ) (void)0
+#endif
+
+#if SHM_LOG_ACTIVE_LEVEL <= SHM_LOG_LEVEL_DEBUG
+#define SHM_LOG_DEBUG_TO( category, ... ) SHM_LOG_TO( category, ::spdlog::level::debug, __VA_ARGS__ )
+#else
+#define SHM_LOG_DEBUG_TO( category, ... ) (void)0
+#endif
+
+#if SHM_LOG_ACTIVE_LEVEL <= SHM_LOG_LEVEL_INFO
+#define SHM_LOG_INFO_TO( category, ... ) SHM_LOG_TO( category, ::spdlog::level::info, __VA_ARGS__ )
+#else
+#define SHM_LOG_INFO_TO( category, ... ) (void)0
+#endif
+
+#if SHM_LOG_ACTIVE_LEVEL <= SHM_LOG_LEVEL_WARN
+#define SHM_LOG_WARN_TO( category, ... ) SHM_LOG_TO( category, ::spdlog::level::warn, __VA_ARGS__ )
+#else
+#define SHM_LOG_WARN_TO( category, ... ) (void)0
+#endif
+
+#if SHM_LOG_ACTIVE_LEVEL <= SHM_LOG_LEVEL_ERROR
+#define SHM_LOG_ERROR_TO( category, ... ) SHM_LOG_TO( category, ::spdlog::level::err, __VA_ARGS__ )
+#else
+#define SHM_LOG_ERROR_TO( category, ... ) (void)0
+#endif
+
+#if SHM_LOG_ACTIVE_LEVEL <= SHM_LOG_LEVEL_CRITICAL
+#define SHM_LOG_CRITICAL_TO( category, ... ) SHM_LOG_TO( category, ::spdlog::level::critical, __VA_ARGS__ )
+#else
+#define SHM_LOG_CRITICAL_TO( category, ... ) (void)0
+#endif
+
+#define SHM_LOG_TRACE( ... )    SHM_LOG_TRACE_TO( ::shm::log::CurrentCategory(), __VA_ARGS__ )
+#define SHM_LOG_DEBUG( ... )    SHM_LOG_DEBUG_TO( ::shm::log::CurrentCategory(), __VA_ARGS__ )
+#define SHM_LOG_INFO( ... )     SHM_LOG_INFO_TO( ::shm::log::CurrentCategory(), __VA_ARGS__ )
+#define SHM_LOG_WARN( ... )     SHM_LOG_WARN_TO( ::shm::log::CurrentCategory(), __VA_ARGS__ )
+#define SHM_LOG_ERROR( ... )    SHM_LOG_ERROR_TO( ::shm::log::CurrentCategory(), __VA_ARGS__ )
+#define SHM_LOG_CRITICAL( ... ) SHM_LOG_CRITICAL_TO( ::shm::log::CurrentCategory(), __VA_ARGS__ )
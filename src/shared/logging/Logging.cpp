@@ -1,11 +1,15 @@
 #include "Logging.hpp"
+#include "FlightRecorder.hpp"
+#include "RotatingFileSink.hpp"
+#include "metrics/Metrics.hpp"
+#include "tracing/Tracing.hpp"
 
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <spdlog/async.h>
 #include <spdlog/logger.h>
 #include <spdlog/pattern_formatter.h>
 #include <spdlog/sinks/msvc_sink.h>
-#include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
@@ -37,12 +41,29 @@ namespace shm
     LogScope::LogScope( std::string_view scope_name )
     {
         S_THREAD_SCOPES.emplace_back( scope_name );
+        if ( shm::trace::IsEnabled() ) [[unlikely]]
+            m_trace_begin = shm::trace::Timestamp();
+    }
+
+    LogScope::LogScope( LogCategory & category )
+        : LogScope( category.Name() )
+    {
+        m_previous_category             = log::detail::S_CURRENT_CATEGORY;
+        m_restores_category             = true;
+        log::detail::S_CURRENT_CATEGORY = &category;
     }
 
     LogScope::~LogScope()
     {
-        if ( !S_THREAD_SCOPES.empty() )
-            S_THREAD_SCOPES.pop_back();
+        if ( m_restores_category )
+            log::detail::S_CURRENT_CATEGORY = m_previous_category;
+
+        if ( S_THREAD_SCOPES.empty() )
+            return;
+
+        if ( m_trace_begin != 0 ) [[unlikely]]
+            shm::trace::detail::RecordSpan( S_THREAD_SCOPES.back(), m_trace_begin, shm::trace::Timestamp() );
+        S_THREAD_SCOPES.pop_back();
     }
 
     Logger::Logger( const LoggerSettings & settings )
@@ -55,12 +76,16 @@ namespace shm
             const auto log_path = std::filesystem::path( settings.m_log_file_path ) / settings.m_log_file_name;
             std::vector< spdlog::sink_ptr > sinks;
 
-            auto rotating_sink = std::make_shared< spdlog::sinks::rotating_file_sink_mt >(
-                log_path.string(),
-                settings.m_max_file_size_bytes,
-                settings.m_max_files,
-                settings.m_rotate_on_open );
-            sinks.push_back( rotating_sink );
+            auto file_sink = std::make_shared< shm::RotatingFileSink >( shm::RotatingFileSettings{
+                .m_file_path           = log_path,
+                .m_max_file_size_bytes = settings.m_max_file_size_bytes,
+                .m_rotation_interval   = settings.m_rotation_interval,
+                .m_max_files           = settings.m_max_files,
+                .m_max_total_bytes     = settings.m_max_total_bytes,
+                .m_compress            = settings.m_compress_rotated,
+                .m_rotate_on_open      = settings.m_rotate_on_open,
+            } );
+            sinks.push_back( file_sink );
 
 #ifdef _WIN32
             if ( settings.m_enable_msvc )
@@ -74,7 +99,6 @@ namespace shm
 
             // Create logger and configure
             auto logger = std::make_shared< spdlog::logger >( settings.m_logger_name, sinks.begin(), sinks.end() );
-            logger->set_level( settings.m_level );
             logger->flush_on( settings.m_flush_level );
 
             {
@@ -84,19 +108,62 @@ namespace shm
                 logger->set_formatter( std::move( pf ) );
             }
 
+            // Records are filtered per category before they reach the logger (see LogLevels.hpp), the level of
+            // the logger itself follows the lowest category level.
             for ( auto & s : sinks )
-                s->set_level( settings.m_level );
+                s->set_level( spdlog::level::trace );
+
+            for ( const auto & s : settings.m_extra_sinks )
+                logger->sinks().push_back( s );
+
+            if ( settings.m_enable_flight_recorder )
+            {
+                logger->sinks().push_back( shm::flight::MakeSink( settings.m_flight_recorder_level ) );
+
+                const std::filesystem::path flight_file = settings.m_flight_recorder_file.empty()
+                                                              ? std::filesystem::path( settings.m_logger_name + ".flight.log" )
+                                                              : std::filesystem::path( settings.m_flight_recorder_file );
+                m_flight_recorder_file = ( std::filesystem::path( settings.m_log_file_path ) / flight_file ).string();
+                if ( settings.m_dump_flight_recorder_on_crash )
+                {
+                    shm::flight::InstallFatalSignalHandler( m_flight_recorder_file );
+                    m_fatal_signal_handler = true;
+                }
+            }
 
             m_logger = std::move( logger );
 
+            // Records are written on the thread that logs them (scopes and the flight recorder are per thread), the
+            // only queue is that of the rotated segments waiting to be archived.
+            shm::metrics::DefaultRegistry().RegisterGaugeCallback( "shm_log_archive_backlog", "Rotated log segments waiting to be archived",
+                                                                   [ sink = std::weak_ptr( file_sink ) ]() -> int64_t
+                                                                   {
+                                                                       const auto locked = sink.lock();
+                                                                       return locked ? static_cast< int64_t >( locked->ArchiveBacklog() ) : 0;
+                                                                   } );
+
             spdlog::set_default_logger( m_logger );
+            shm::log::SetCaptureLevel( settings.m_enable_flight_recorder ? settings.m_flight_recorder_level : spdlog::level::off );
+            shm::log::SetDefaultLevel( settings.m_level );
         }
     }
 
     Logger::~Logger()
     {
+        if ( m_fatal_signal_handler )
+            shm::flight::UninstallFatalSignalHandler();
+        if ( !m_flight_recorder_file.empty() )
+            shm::log::SetCaptureLevel( spdlog::level::off );
+        shm::metrics::DefaultRegistry().UnregisterGaugeCallback( "shm_log_archive_backlog" );
         spdlog::drop_all();
         spdlog::shutdown();
     }
 
+    shm::Result< void > Logger::DumpFlightRecorder() const
+    {
+        if ( m_flight_recorder_file.empty() )
+            return std::unexpected( std::make_error_code( std::errc::operation_not_permitted ) );
+        return shm::flight::Dump( m_flight_recorder_file );
+    }
+
 } // namespace shm
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <spdlog/common.h>
+#include "LogLevels.hpp"
 #include "results/Result.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -21,16 +24,24 @@ namespace shm
     /// @brief RAII scope logger. On construction, pushes scope name to thread-local stack.
     /// When destroyed, pops scope name from stack.
     /// It is visible in log messages via the %Z pattern flag.
+    /// While tracing is enabled (shm::trace), every scope is also recorded as a span.
+    /// A scope made from a LogCategory is named after it and makes it the thread's current category until it ends.
     struct LogScope
     {
         LogScope() = delete;
         explicit LogScope( std::string_view scope_name );
+        explicit LogScope( LogCategory & category );
         ~LogScope();
 
         LogScope( const LogScope & )             = delete;
         LogScope & operator=( const LogScope & ) = delete;
         LogScope( LogScope && )                  = delete;
         LogScope & operator=( LogScope && )      = delete;
+
+    private:
+        uint64_t m_trace_begin            = 0;
+        LogCategory * m_previous_category = nullptr;
+        bool m_restores_category          = false;
     };
 
     struct LoggerSettings
@@ -40,15 +51,35 @@ namespace shm
         uint32_t m_max_file_size_bytes{ 1024u * 1024u * 5u }; // 5 MB
         uint32_t m_max_files{ 5u };
         bool m_rotate_on_open{ true };
+        /// @brief Also rotate the log file once it is this old, zero rotates by size only.
+        std::chrono::seconds m_rotation_interval{ 0 };
+        /// @brief Disk budget of the log file and its rotated segments together, 0 is unlimited.
+        uint64_t m_max_total_bytes{ 0 };
+        /// @brief Compress rotated segments with zstd, done by the rotation thread.
+        bool m_compress_rotated{ false };
         bool m_create_directories{ true };
 
         std::string m_logger_name{ "shimmer" };
+        /// @brief Level of the default category, per category levels are set through shm::log (see LogLevels.hpp).
         spdlog::level::level_enum m_level{ spdlog::level::info };
         spdlog::level::level_enum m_flush_level{ spdlog::level::info };
         /// @brief Log pattern, using spdlog pattern syntax. Controls how log messages are formatted.
         std::string m_log_pattern{ "[%n] [%Y-%m-%d %H:%M:%S.%e] [%l@%t] %*%v" };
 
         bool m_enable_stderr{ true };
+        /// @brief Additional sinks, attached as is. They keep their own level instead of m_level.
+        std::vector< spdlog::sink_ptr > m_extra_sinks{};
+
+        /// @brief Keeps the most recent records of every thread in memory (see shm::flight), dumped to
+        /// m_flight_recorder_file on a fatal signal or by Logger::DumpFlightRecorder.
+        bool m_enable_flight_recorder{ true };
+        /// @brief Records below their category level still reach the flight recorder down to this level.
+        spdlog::level::level_enum m_flight_recorder_level{ spdlog::level::trace };
+        /// @brief Relative paths are resolved against m_log_file_path, empty uses "<logger name>.flight.log".
+        std::string m_flight_recorder_file{};
+        /// @brief Also dumps the flight recorder on a fatal signal, see shm::flight::InstallFatalSignalHandler. Off by
+        /// default, the handler is process wide and belongs to the application rather than to every logger.
+        bool m_dump_flight_recorder_on_crash{ false };
         // TODO get rid of this preprocessor altogether once we have UI layer
 #ifdef _WIN32
         bool m_enable_msvc{ true };
@@ -75,8 +106,13 @@ namespace shm
             return {};
         }
 
+        /// @brief Writes the flight recorder contents to the configured file.
+        shm::Result< void > DumpFlightRecorder() const;
+
     private:
         std::error_code m_directory_ec;
+        std::string m_flight_recorder_file;
+        bool m_fatal_signal_handler = false;
         std::shared_ptr< spdlog::logger > m_logger;
     };
 
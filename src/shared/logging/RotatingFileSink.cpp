@@ -0,0 +1,327 @@
+#include "RotatingFileSink.hpp"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#endif
+
+namespace
+{
+    /// @brief Opens for appending. On Windows the file is shared for deletion, otherwise the worker could not rename
+    /// the active file while the logging thread still holds it.
+    std::FILE * OpenForAppend( const std::filesystem::path & path, bool truncate )
+    {
+#ifdef _WIN32
+        HANDLE handle = ::CreateFileW( path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                       truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+        if ( handle == INVALID_HANDLE_VALUE )
+            return nullptr;
+
+        const int fd = _open_osfhandle( reinterpret_cast< intptr_t >( handle ), _O_APPEND | _O_BINARY );
+        if ( fd < 0 )
+        {
+            ::CloseHandle( handle );
+            return nullptr;
+        }
+        std::FILE * file = _fdopen( fd, "ab" );
+        if ( !file )
+            _close( fd );
+        return file;
+#else
+        return std::fopen( path.c_str(), truncate ? "wb" : "ab" );
+#endif
+    }
+
+    uint64_t FileSize( const std::filesystem::path & path )
+    {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size( path, ec );
+        return ec ? 0 : size;
+    }
+
+    /// @brief "<stem>.YYYYmmdd-HHMMSS...", other files sharing the stem (e.g. the flight recorder dump) are left alone.
+    bool IsArchiveName( std::string_view file_name, std::string_view prefix )
+    {
+        if ( !file_name.starts_with( prefix ) || file_name.size() < prefix.size() + 15 )
+            return false;
+
+        const auto stamp = file_name.substr( prefix.size(), 15 );
+        for ( std::size_t i = 0; i < stamp.size(); ++i )
+        {
+            const bool is_separator = i == 8;
+            if ( is_separator ? stamp[ i ] != '-' : ( stamp[ i ] < '0' || stamp[ i ] > '9' ) )
+                return false;
+        }
+        return true;
+    }
+
+    bool CompressFile( const std::filesystem::path & source, const std::filesystem::path & destination, int level )
+    {
+        std::unique_ptr< std::FILE, decltype( &std::fclose ) > in( std::fopen( source.string().c_str(), "rb" ), &std::fclose );
+        std::unique_ptr< std::FILE, decltype( &std::fclose ) > out( std::fopen( destination.string().c_str(), "wb" ), &std::fclose );
+        std::unique_ptr< ZSTD_CCtx, decltype( &ZSTD_freeCCtx ) > context( ZSTD_createCCtx(), &ZSTD_freeCCtx );
+        if ( !in || !out || !context )
+            return false;
+
+        ZSTD_CCtx_setParameter( context.get(), ZSTD_c_compressionLevel, level );
+
+        std::vector< char > in_buffer( ZSTD_CStreamInSize() );
+        std::vector< char > out_buffer( ZSTD_CStreamOutSize() );
+        for ( ;; )
+        {
+            const std::size_t read = std::fread( in_buffer.data(), 1, in_buffer.size(), in.get() );
+            const bool last        = read < in_buffer.size();
+            ZSTD_inBuffer input{ in_buffer.data(), read, 0 };
+            for ( bool finished = false; !finished; )
+            {
+                ZSTD_outBuffer output{ out_buffer.data(), out_buffer.size(), 0 };
+                const std::size_t remaining = ZSTD_compressStream2( context.get(), &output, &input, last ? ZSTD_e_end : ZSTD_e_continue );
+                if ( ZSTD_isError( remaining ) )
+                    return false;
+                if ( std::fwrite( out_buffer.data(), 1, output.pos, out.get() ) != output.pos )
+                    return false;
+                finished = last ? remaining == 0 : input.pos == input.size;
+            }
+            if ( last )
+                return std::ferror( in.get() ) == 0;
+        }
+    }
+} // namespace
+
+shm::RotatingFileSink::RotatingFileSink( RotatingFileSettings settings )
+    : m_settings( std::move( settings ) )
+{
+    std::error_code ec;
+    if ( m_settings.m_file_path.has_parent_path() )
+        std::filesystem::create_directories( m_settings.m_file_path.parent_path(), ec );
+
+    // Leftovers of a previous run: a non empty next file means it crashed between a rotation and its archiving. The
+    // active file holds the older records, the rotation is finished the way ArchiveSegment would so the archive
+    // stays in order.
+    if ( FileSize( NextFilePath() ) > 0 )
+    {
+        if ( FileSize( m_settings.m_file_path ) > 0 )
+            std::filesystem::rename( m_settings.m_file_path, MakeArchivePath(), ec );
+        std::filesystem::rename( NextFilePath(), m_settings.m_file_path, ec );
+    }
+    if ( m_settings.m_rotate_on_open && FileSize( m_settings.m_file_path ) > 0 )
+        std::filesystem::rename( m_settings.m_file_path, MakeArchivePath(), ec );
+
+    m_file = OpenForAppend( m_settings.m_file_path, false );
+    if ( !m_file )
+        throw spdlog::spdlog_ex( fmt::format( "Failed opening log file {}", m_settings.m_file_path.string() ), errno );
+    m_file_size   = FileSize( m_settings.m_file_path );
+    m_file_opened = spdlog::log_clock::now();
+
+    m_worker = std::jthread( [ this ]( std::stop_token stop ) { RunWorker( std::move( stop ) ); } );
+}
+
+shm::RotatingFileSink::~RotatingFileSink()
+{
+    m_worker.request_stop();
+    if ( m_worker.joinable() )
+        m_worker.join();
+
+    if ( m_file )
+        std::fclose( m_file );
+    if ( m_next_file )
+    {
+        std::fclose( m_next_file );
+        std::error_code ec;
+        std::filesystem::remove( NextFilePath(), ec );
+    }
+}
+
+std::filesystem::path shm::RotatingFileSink::NextFilePath() const
+{
+    auto path = m_settings.m_file_path;
+    path += ".next";
+    return path;
+}
+
+void shm::RotatingFileSink::WaitForArchiving()
+{
+    std::unique_lock lock( m_worker_mutex );
+    m_idle_cv.wait( lock, [ this ]() { return m_segments.empty() && !m_worker_busy && m_next_file; } );
+}
+
+std::size_t shm::RotatingFileSink::ArchiveBacklog()
+{
+    std::scoped_lock lock( m_worker_mutex );
+    return m_segments.size() + ( m_archiving ? 1 : 0 );
+}
+
+void shm::RotatingFileSink::sink_it_( const spdlog::details::log_msg & msg )
+{
+    spdlog::memory_buf_t formatted;
+    formatter_->format( msg, formatted );
+
+    if ( ShouldRotate( msg.time ) ) [[unlikely]]
+        TryRotate( msg.time );
+
+    m_file_size += std::fwrite( formatted.data(), 1, formatted.size(), m_file );
+}
+
+void shm::RotatingFileSink::flush_()
+{
+    std::fflush( m_file );
+}
+
+bool shm::RotatingFileSink::ShouldRotate( spdlog::log_clock::time_point now ) const noexcept
+{
+    if ( m_file_size == 0 )
+        return false;
+    if ( m_settings.m_max_file_size_bytes != 0 && m_file_size >= m_settings.m_max_file_size_bytes )
+        return true;
+    return m_settings.m_rotation_interval.count() != 0 && now - m_file_opened >= m_settings.m_rotation_interval;
+}
+
+bool shm::RotatingFileSink::TryRotate( spdlog::log_clock::time_point now )
+{
+    std::FILE * full_segment = nullptr;
+    {
+        std::scoped_lock lock( m_worker_mutex );
+        if ( !m_next_file )
+            return false;
+
+        full_segment = std::exchange( m_file, std::exchange( m_next_file, nullptr ) );
+        m_segments.push_back( full_segment );
+    }
+    m_worker_cv.notify_one();
+
+    m_file_size   = 0;
+    m_file_opened = now;
+    return true;
+}
+
+void shm::RotatingFileSink::RunWorker( std::stop_token stop )
+{
+    for ( ;; )
+    {
+        std::FILE * segment = nullptr;
+        bool open_next      = false;
+        {
+            std::unique_lock lock( m_worker_mutex );
+            m_worker_cv.wait( lock, stop, [ this ]() { return !m_segments.empty() || !m_next_file; } );
+            if ( m_segments.empty() && ( m_next_file || stop.stop_requested() ) )
+                return;
+
+            if ( !m_segments.empty() )
+            {
+                segment = m_segments.front();
+                m_segments.pop_front();
+            }
+            open_next     = m_segments.empty() && !m_next_file && !stop.stop_requested();
+            m_worker_busy = true;
+            m_archiving   = segment != nullptr;
+        }
+
+        if ( segment )
+            ArchiveSegment( segment );
+
+        // Opened only once every queued segment is archived, the file it replaces is renamed to the active path last.
+        std::FILE * next_file = open_next ? OpenForAppend( NextFilePath(), true ) : nullptr;
+        {
+            std::scoped_lock lock( m_worker_mutex );
+            if ( next_file )
+                m_next_file = next_file;
+            m_worker_busy = false;
+            m_archiving   = false;
+        }
+        m_idle_cv.notify_all();
+
+        if ( open_next && !next_file )
+        {
+            // Retried until it succeeds, meanwhile rotation is postponed and the active file keeps growing.
+            std::unique_lock lock( m_worker_mutex );
+            m_worker_cv.wait_for( lock, stop, std::chrono::seconds( 1 ), []() { return false; } );
+        }
+    }
+}
+
+void shm::RotatingFileSink::ArchiveSegment( std::FILE * segment )
+{
+    std::fclose( segment );
+
+    // The segment is still named after the active file, and the file the logging thread switched to is still named
+    // after the next file. Renaming them in this order keeps the active path pointing at the file being written.
+    std::error_code ec;
+    auto archive_path = MakeArchivePath();
+    std::filesystem::rename( m_settings.m_file_path, archive_path, ec );
+    std::filesystem::rename( NextFilePath(), m_settings.m_file_path, ec );
+
+    if ( m_settings.m_compress )
+    {
+        auto compressed_path = archive_path;
+        compressed_path += ".zst";
+        if ( CompressFile( archive_path, compressed_path, m_settings.m_compression_level ) )
+            std::filesystem::remove( archive_path, ec );
+        else
+            std::filesystem::remove( compressed_path, ec );
+    }
+
+    PruneArchive();
+}
+
+void shm::RotatingFileSink::PruneArchive()
+{
+    if ( m_settings.m_max_files == 0 && m_settings.m_max_total_bytes == 0 )
+        return;
+
+    const auto directory = m_settings.m_file_path.has_parent_path() ? m_settings.m_file_path.parent_path() : std::filesystem::path( "." );
+    const auto prefix    = m_settings.m_file_path.stem().string() + ".";
+
+    struct ArchivedFile
+    {
+        std::filesystem::path m_path;
+        uint64_t m_size;
+    };
+    std::vector< ArchivedFile > archived;
+    uint64_t total_bytes = FileSize( m_settings.m_file_path );
+
+    std::error_code ec;
+    for ( const auto & entry : std::filesystem::directory_iterator( directory, ec ) )
+    {
+        if ( !entry.is_regular_file( ec ) || !IsArchiveName( entry.path().filename().string(), prefix ) )
+            continue;
+
+        const uint64_t size = FileSize( entry.path() );
+        archived.push_back( { entry.path(), size } );
+        total_bytes += size;
+    }
+
+    // Archive names start with the rotation time, so they sort oldest first.
+    std::ranges::sort( archived, {}, &ArchivedFile::m_path );
+    std::size_t remaining = archived.size();
+    for ( const auto & file : archived )
+    {
+        const bool over_count  = m_settings.m_max_files != 0 && remaining > m_settings.m_max_files;
+        const bool over_budget = m_settings.m_max_total_bytes != 0 && total_bytes > m_settings.m_max_total_bytes;
+        if ( !over_count && !over_budget )
+            break;
+
+        std::filesystem::remove( file.m_path, ec );
+        total_bytes -= file.m_size;
+        --remaining;
+    }
+}
+
+std::filesystem::path shm::RotatingFileSink::MakeArchivePath()
+{
+    const auto now = std::chrono::floor< std::chrono::seconds >( std::chrono::system_clock::now() );
+    auto path      = m_settings.m_file_path;
+    path.replace_filename( fmt::format( "{}.{:%Y%m%d-%H%M%S}.{:06}{}", m_settings.m_file_path.stem().string(), now,
+                                        m_archive_sequence++, m_settings.m_file_path.extension().string() ) );
+    return path;
+}
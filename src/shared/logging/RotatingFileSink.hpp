@@ -0,0 +1,87 @@
+#pragma once
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+namespace shm
+{
+    struct RotatingFileSettings
+    {
+        /// @brief Active log file, rotated segments are archived next to it as "<stem>.<YYYYmmdd-HHMMSS>.<n><extension>".
+        std::filesystem::path m_file_path;
+        /// @brief Size the active file is rotated at, 0 disables size based rotation.
+        uint64_t m_max_file_size_bytes{ 1024u * 1024u * 5u };
+        /// @brief Age the active file is rotated at, zero disables time based rotation.
+        std::chrono::seconds m_rotation_interval{ 0 };
+        /// @brief Archived segments kept, the oldest are deleted first. 0 keeps all of them.
+        uint32_t m_max_files{ 5u };
+        /// @brief Budget for the active file and all archived segments together, 0 is unlimited.
+        uint64_t m_max_total_bytes{ 0 };
+        /// @brief Compress archived segments with zstd ("<segment>.zst").
+        bool m_compress{ false };
+        int m_compression_level{ 3 };
+        bool m_rotate_on_open{ true };
+    };
+
+    /// @brief File sink whose rotation never blocks the logging thread on file system work.
+    /// A worker thread keeps the next file open ahead of time. Rotating swaps the FILE pointers and hands the full
+    /// segment to the worker, which renames, compresses and prunes the archive. If the worker has not caught up yet,
+    /// logging continues into the current file and rotation is retried on the next record.
+    class RotatingFileSink final : public spdlog::sinks::base_sink< std::mutex >
+    {
+    public:
+        explicit RotatingFileSink( RotatingFileSettings settings );
+        ~RotatingFileSink() override;
+
+        RotatingFileSink( const RotatingFileSink & )             = delete;
+        RotatingFileSink & operator=( const RotatingFileSink & ) = delete;
+        RotatingFileSink( RotatingFileSink && )                  = delete;
+        RotatingFileSink & operator=( RotatingFileSink && )      = delete;
+
+        /// @brief Blocks until the worker archived every segment handed to it so far and the next file is open.
+        void WaitForArchiving();
+
+        /// @brief Rotated segments the worker has not finished archiving yet. Grows if rotation outpaces compression
+        /// or the file system, each of them still takes up disk space outside the archive budget.
+        [[nodiscard]] std::size_t ArchiveBacklog();
+
+        [[nodiscard]] std::filesystem::path NextFilePath() const;
+
+    protected:
+        void sink_it_( const spdlog::details::log_msg & msg ) override;
+        void flush_() override;
+
+    private:
+        bool ShouldRotate( spdlog::log_clock::time_point now ) const noexcept;
+        bool TryRotate( spdlog::log_clock::time_point now );
+
+        void RunWorker( std::stop_token stop );
+        void ArchiveSegment( std::FILE * segment );
+        void PruneArchive();
+        [[nodiscard]] std::filesystem::path MakeArchivePath();
+
+        RotatingFileSettings m_settings;
+        std::FILE * m_file = nullptr;
+        uint64_t m_file_size = 0;
+        spdlog::log_clock::time_point m_file_opened;
+
+        std::mutex m_worker_mutex;
+        std::condition_variable_any m_worker_cv;
+        std::condition_variable m_idle_cv;
+        std::FILE * m_next_file = nullptr;
+        std::deque< std::FILE * > m_segments;
+        bool m_worker_busy = false;
+        /// @brief The worker took a segment off m_segments and is archiving it.
+        bool m_archiving = false;
+        uint64_t m_archive_sequence = 0;
+        std::jthread m_worker;
+    };
+} // namespace shm
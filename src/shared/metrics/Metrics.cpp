@@ -0,0 +1,299 @@
+#include "Metrics.hpp"
+
+#include "filesystem/Filesystem.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+namespace
+{
+    std::atomic< std::size_t > G_NEXT_THREAD_SHARD{ 0 };
+
+    template< typename Entries >
+    auto FindEntry( Entries & entries, std::string_view name )
+    {
+        return std::ranges::find_if( entries,
+                                     [ name ]( const auto & entry )
+                                     {
+                                         return entry.m_name == name;
+                                     } );
+    }
+
+    template< typename T, typename Entries >
+    T & GetOrCreate( Entries & entries, std::string_view name, std::string_view help )
+    {
+        auto iter = FindEntry( entries, name );
+        if ( iter != entries.end() )
+            return *iter->m_metric;
+
+        auto & entry = entries.emplace_back( std::string( name ), std::string( help ), std::make_unique< T >() );
+        return *entry.m_metric;
+    }
+
+    void AppendHeader( std::string & out, std::string_view name, std::string_view help, std::string_view type )
+    {
+        if ( !help.empty() )
+            fmt::format_to( std::back_inserter( out ), "# HELP {} {}\n", name, help );
+        fmt::format_to( std::back_inserter( out ), "# TYPE {} {}\n", name, type );
+    }
+} // namespace
+
+std::size_t shm::metrics::ThreadShard() noexcept
+{
+    static thread_local const std::size_t S_SHARD = G_NEXT_THREAD_SHARD.fetch_add( 1, std::memory_order_relaxed ) % ShardCount;
+    return S_SHARD;
+}
+
+uint64_t shm::metrics::Counter::Value() const noexcept
+{
+    uint64_t total = 0;
+    for ( const auto & shard : m_shards )
+        total += shard.m_value.load( std::memory_order_relaxed );
+    return total;
+}
+
+/** HISTOGRAM **/
+
+shm::metrics::HistogramSnapshot shm::metrics::Histogram::Snapshot() const
+{
+    HistogramSnapshot snapshot;
+    snapshot.m_buckets.resize( BucketCount, 0 );
+    for ( const auto & shard : m_shards )
+    {
+        for ( std::size_t i = 0; i < BucketCount; ++i )
+        {
+            const auto count = shard.m_buckets[ i ].load( std::memory_order_relaxed );
+            snapshot.m_buckets[ i ] += count;
+            snapshot.m_count += count;
+        }
+        snapshot.m_sum += shard.m_sum.load( std::memory_order_relaxed );
+        snapshot.m_max = std::max( snapshot.m_max, shard.m_max.load( std::memory_order_relaxed ) );
+    }
+    return snapshot;
+}
+
+uint64_t shm::metrics::HistogramSnapshot::ValueAtQuantile( double quantile ) const noexcept
+{
+    if ( m_count == 0 )
+        return 0;
+
+    const auto rank = static_cast< uint64_t >( std::clamp( quantile, 0.0, 1.0 ) * static_cast< double >( m_count - 1 ) ) + 1;
+    uint64_t seen   = 0;
+    for ( std::size_t i = 0; i < m_buckets.size(); ++i )
+    {
+        seen += m_buckets[ i ];
+        if ( seen >= rank )
+            return std::min( Histogram::BucketUpperBound( i ), m_max );
+    }
+    return m_max;
+}
+
+void shm::metrics::HistogramSnapshot::Merge( const HistogramSnapshot & other )
+{
+    if ( m_buckets.size() < other.m_buckets.size() )
+        m_buckets.resize( other.m_buckets.size(), 0 );
+
+    for ( std::size_t i = 0; i < other.m_buckets.size(); ++i )
+        m_buckets[ i ] += other.m_buckets[ i ];
+
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_max = std::max( m_max, other.m_max );
+}
+
+/** REGISTRY **/
+
+shm::metrics::Counter & shm::metrics::Registry::GetCounter( std::string_view name, std::string_view help )
+{
+    std::scoped_lock lock( m_mutex );
+    return GetOrCreate< Counter >( m_counters, name, help );
+}
+
+shm::metrics::Gauge & shm::metrics::Registry::GetGauge( std::string_view name, std::string_view help )
+{
+    std::scoped_lock lock( m_mutex );
+    return GetOrCreate< Gauge >( m_gauges, name, help );
+}
+
+shm::metrics::Histogram & shm::metrics::Registry::GetHistogram( std::string_view name, std::string_view help )
+{
+    std::scoped_lock lock( m_mutex );
+    return GetOrCreate< Histogram >( m_histograms, name, help );
+}
+
+void shm::metrics::Registry::RegisterGaugeCallback( std::string_view name, std::string_view help, std::function< int64_t() > callback )
+{
+    std::scoped_lock lock( m_mutex );
+    auto iter = FindEntry( m_gauge_callbacks, name );
+    if ( iter != m_gauge_callbacks.end() )
+    {
+        iter->m_callback = std::move( callback );
+        return;
+    }
+    m_gauge_callbacks.emplace_back( std::string( name ), std::string( help ), std::move( callback ) );
+}
+
+void shm::metrics::Registry::UnregisterGaugeCallback( std::string_view name )
+{
+    std::scoped_lock lock( m_mutex );
+    std::erase_if( m_gauge_callbacks,
+                   [ name ]( const CallbackEntry & entry )
+                   {
+                       return entry.m_name == name;
+                   } );
+}
+
+shm::metrics::RegistrySnapshot shm::metrics::Registry::Snapshot() const
+{
+    RegistrySnapshot snapshot;
+    snapshot.m_taken_at = std::chrono::system_clock::now();
+
+    std::scoped_lock lock( m_mutex );
+    for ( const auto & entry : m_counters )
+        snapshot.m_counters.emplace_back( entry.m_name, entry.m_help, static_cast< int64_t >( entry.m_metric->Value() ) );
+
+    for ( const auto & entry : m_gauges )
+        snapshot.m_gauges.emplace_back( entry.m_name, entry.m_help, entry.m_metric->Value() );
+
+    for ( const auto & entry : m_gauge_callbacks )
+        snapshot.m_gauges.emplace_back( entry.m_name, entry.m_help, entry.m_callback ? entry.m_callback() : 0 );
+
+    for ( const auto & entry : m_histograms )
+        snapshot.m_histograms.emplace_back( entry.m_name, entry.m_help, entry.m_metric->Snapshot() );
+
+    return snapshot;
+}
+
+shm::metrics::Registry & shm::metrics::DefaultRegistry()
+{
+    static Registry S_REGISTRY;
+    return S_REGISTRY;
+}
+
+/** EXPORT **/
+
+std::string shm::metrics::FormatPrometheus( const RegistrySnapshot & snapshot )
+{
+    std::string out;
+    for ( const auto & counter : snapshot.m_counters )
+    {
+        AppendHeader( out, counter.m_name, counter.m_help, "counter" );
+        fmt::format_to( std::back_inserter( out ), "{} {}\n", counter.m_name, counter.m_value );
+    }
+
+    for ( const auto & gauge : snapshot.m_gauges )
+    {
+        AppendHeader( out, gauge.m_name, gauge.m_help, "gauge" );
+        fmt::format_to( std::back_inserter( out ), "{} {}\n", gauge.m_name, gauge.m_value );
+    }
+
+    for ( const auto & sample : snapshot.m_histograms )
+    {
+        const auto & histogram = sample.m_histogram;
+        AppendHeader( out, sample.m_name, sample.m_help, "histogram" );
+
+        // Exporting all HDR buckets would be far too verbose, emit power of two boundaries up to the max instead.
+        uint64_t cumulative = 0;
+        for ( std::size_t i = 0; i < histogram.m_buckets.size(); ++i )
+        {
+            cumulative += histogram.m_buckets[ i ];
+            if ( ( i + 1 ) % Histogram::SubBuckets != 0 || cumulative == 0 )
+                continue;
+
+            fmt::format_to( std::back_inserter( out ), "{}_bucket{{le=\"{}\"}} {}\n", sample.m_name, Histogram::BucketUpperBound( i ), cumulative );
+            if ( cumulative == histogram.m_count )
+                break;
+        }
+        fmt::format_to( std::back_inserter( out ), "{}_bucket{{le=\"+Inf\"}} {}\n", sample.m_name, histogram.m_count );
+        fmt::format_to( std::back_inserter( out ), "{}_sum {}\n", sample.m_name, histogram.m_sum );
+        fmt::format_to( std::back_inserter( out ), "{}_count {}\n", sample.m_name, histogram.m_count );
+    }
+    return out;
+}
+
+shm::Result< void > shm::metrics::WritePrometheusFile( const RegistrySnapshot & snapshot, const std::filesystem::path & path )
+{
+    if ( path.has_parent_path() )
+    {
+        auto dir_result = shm::fs::CreateDirectories( path.parent_path() );
+        if ( !dir_result.has_value() )
+            return dir_result;
+    }
+
+    auto temp_path    = path;
+    temp_path += ".tmp";
+    auto write_result = shm::fs::WriteStringToFile( temp_path, FormatPrometheus( snapshot ), std::ios::out | std::ios::trunc );
+    if ( !write_result.has_value() )
+        return write_result;
+
+    std::error_code ec;
+    std::filesystem::rename( temp_path, path, ec );
+    if ( ec )
+        return std::unexpected( ec );
+
+    return {};
+}
+
+/** AGGREGATOR **/
+
+shm::metrics::Aggregator::Aggregator( Registry & registry, AggregatorSettings settings )
+    : m_registry( registry )
+    , m_settings( std::move( settings ) )
+    , m_thread( [ this ]( std::stop_token stop_token )
+                {
+                    Run( std::move( stop_token ) );
+                } )
+{
+}
+
+shm::metrics::Aggregator::~Aggregator()
+{
+    m_thread.request_stop();
+    m_wait_cv.notify_all();
+}
+
+std::shared_ptr< const shm::metrics::RegistrySnapshot > shm::metrics::Aggregator::Latest() const
+{
+    std::scoped_lock lock( m_latest_mutex );
+    return m_latest;
+}
+
+void shm::metrics::Aggregator::Run( std::stop_token stop_token )
+{
+    uint64_t export_failures = 0;
+    std::optional< std::chrono::steady_clock::time_point > last_error_report;
+    while ( !stop_token.stop_requested() )
+    {
+        {
+            std::unique_lock lock( m_wait_mutex );
+            m_wait_cv.wait_for( lock, stop_token, m_settings.m_period,
+                                []
+                                {
+                                    return false;
+                                } );
+        }
+
+        auto snapshot = std::make_shared< const RegistrySnapshot >( m_registry.Snapshot() );
+        if ( !m_settings.m_prometheus_file.empty() )
+        {
+            auto written = WritePrometheusFile( *snapshot, m_settings.m_prometheus_file );
+            if ( !written.has_value() )
+            {
+                ++export_failures;
+                const auto now = std::chrono::steady_clock::now();
+                if ( m_settings.m_on_export_error && ( !last_error_report || now - *last_error_report >= m_settings.m_export_error_interval ) )
+                {
+                    m_settings.m_on_export_error( written.error(), std::exchange( export_failures, 0 ) );
+                    last_error_report = now;
+                }
+            }
+        }
+
+        std::scoped_lock lock( m_latest_mutex );
+        m_latest = std::move( snapshot );
+    }
+}
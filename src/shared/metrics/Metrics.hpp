@@ -0,0 +1,297 @@
+#pragma once
+
+#include "results/Result.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace shm::metrics
+{
+    /// @brief Number of per-thread shards each metric is split into. Threads are assigned round-robin,
+    /// so up to ShardCount recording threads never share a cache line.
+    constexpr std::size_t ShardCount    = 8;
+    constexpr std::size_t CacheLineSize = 64;
+
+    /// @return Shard index of the calling thread.
+    std::size_t ThreadShard() noexcept;
+
+    class Counter
+    {
+    public:
+        void Increment( uint64_t amount = 1 ) noexcept
+        {
+            m_shards[ ThreadShard() ].m_value.fetch_add( amount, std::memory_order_relaxed );
+        }
+
+        [[nodiscard]] uint64_t Value() const noexcept;
+
+    private:
+        struct alignas( CacheLineSize ) Shard
+        {
+            std::atomic< uint64_t > m_value{ 0 };
+        };
+        std::array< Shard, ShardCount > m_shards{};
+    };
+
+    class Gauge
+    {
+    public:
+        void Set( int64_t value ) noexcept
+        {
+            m_value.store( value, std::memory_order_relaxed );
+        }
+
+        void Add( int64_t amount ) noexcept
+        {
+            m_value.fetch_add( amount, std::memory_order_relaxed );
+        }
+
+        [[nodiscard]] int64_t Value() const noexcept
+        {
+            return m_value.load( std::memory_order_relaxed );
+        }
+
+    private:
+        std::atomic< int64_t > m_value{ 0 };
+    };
+
+    struct HistogramSnapshot
+    {
+        uint64_t m_count = 0;
+        uint64_t m_sum   = 0;
+        uint64_t m_max   = 0;
+        /// @brief Bucket counts, indexed the same way as Histogram::BucketIndex.
+        std::vector< uint64_t > m_buckets;
+
+        /// @param quantile 0..1
+        /// @return Upper bound of the bucket containing the quantile, relative error is below 1 / Histogram::SubBuckets.
+        [[nodiscard]] uint64_t ValueAtQuantile( double quantile ) const noexcept;
+        void Merge( const HistogramSnapshot & other );
+    };
+
+    /// @brief HDR-style log-linear histogram of unsigned integer samples (typically nanoseconds).
+    /// Every power of two range is split into SubBuckets linear buckets, which keeps the relative
+    /// error bounded over the whole uint64_t range with a fixed, allocation-free bucket array.
+    class Histogram
+    {
+    public:
+        static constexpr uint32_t SubBucketBits  = 4;
+        static constexpr uint32_t SubBuckets     = 1u << SubBucketBits;
+        static constexpr std::size_t BucketCount = ( 64 - SubBucketBits + 1 ) * SubBuckets;
+
+        static constexpr std::size_t BucketIndex( uint64_t value ) noexcept
+        {
+            if ( value < SubBuckets )
+                return static_cast< std::size_t >( value );
+
+            const uint32_t shift = static_cast< uint32_t >( std::bit_width( value ) ) - 1 - SubBucketBits;
+            const uint64_t sub   = ( value >> shift ) - SubBuckets;
+            return ( shift + 1 ) * SubBuckets + static_cast< std::size_t >( sub );
+        }
+
+        static constexpr uint64_t BucketLowerBound( std::size_t index ) noexcept
+        {
+            if ( index < SubBuckets )
+                return index;
+
+            const auto shift = index / SubBuckets - 1;
+            return ( SubBuckets + index % SubBuckets ) << shift;
+        }
+
+        static constexpr uint64_t BucketUpperBound( std::size_t index ) noexcept
+        {
+            if ( index < SubBuckets )
+                return index;
+
+            const auto shift = index / SubBuckets - 1;
+            return BucketLowerBound( index ) + ( ( uint64_t{ 1 } << shift ) - 1 );
+        }
+
+        void Record( uint64_t value ) noexcept
+        {
+            Shard & shard = m_shards[ ThreadShard() ];
+            shard.m_buckets[ BucketIndex( value ) ].fetch_add( 1, std::memory_order_relaxed );
+            shard.m_sum.fetch_add( value, std::memory_order_relaxed );
+            // Shards are per thread only modulo ShardCount, another thread may be raising the same maximum.
+            auto max = shard.m_max.load( std::memory_order_relaxed );
+            while ( value > max && !shard.m_max.compare_exchange_weak( max, value, std::memory_order_relaxed ) )
+            {
+            }
+        }
+
+        template< typename Rep, typename Period >
+        void Record( std::chrono::duration< Rep, Period > duration ) noexcept
+        {
+            const auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( duration ).count();
+            Record( static_cast< uint64_t >( ns < 0 ? 0 : ns ) );
+        }
+
+        [[nodiscard]] HistogramSnapshot Snapshot() const;
+
+    private:
+        struct alignas( CacheLineSize ) Shard
+        {
+            std::array< std::atomic< uint64_t >, BucketCount > m_buckets{};
+            std::atomic< uint64_t > m_sum{ 0 };
+            std::atomic< uint64_t > m_max{ 0 };
+        };
+        std::array< Shard, ShardCount > m_shards{};
+    };
+
+    /// @brief Records the lifetime of the scope into a histogram in nanoseconds.
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer( Histogram & histogram ) noexcept
+            : m_histogram( histogram )
+            , m_start( std::chrono::steady_clock::now() )
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            m_histogram.Record( std::chrono::steady_clock::now() - m_start );
+        }
+
+        ScopedTimer( const ScopedTimer & )             = delete;
+        ScopedTimer & operator=( const ScopedTimer & ) = delete;
+
+    private:
+        Histogram & m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    struct RegistrySnapshot
+    {
+        struct Sample
+        {
+            std::string m_name;
+            std::string m_help;
+            int64_t m_value = 0;
+        };
+
+        struct HistogramSample
+        {
+            std::string m_name;
+            std::string m_help;
+            HistogramSnapshot m_histogram;
+        };
+
+        std::chrono::system_clock::time_point m_taken_at;
+        std::vector< Sample > m_counters;
+        std::vector< Sample > m_gauges;
+        std::vector< HistogramSample > m_histograms;
+    };
+
+    /// @brief Owns all metrics of the process. Registration takes a lock, recording into
+    /// the returned metric references never does. References stay valid for the registry's lifetime.
+    class Registry
+    {
+    public:
+        Registry()  = default;
+        ~Registry() = default;
+
+        Registry( const Registry & )             = delete;
+        Registry & operator=( const Registry & ) = delete;
+        Registry( Registry && )                  = delete;
+        Registry & operator=( Registry && )      = delete;
+
+        /// @brief Returns the metric registered under the name, creating it on first use.
+        Counter & GetCounter( std::string_view name, std::string_view help = {} );
+        Gauge & GetGauge( std::string_view name, std::string_view help = {} );
+        Histogram & GetHistogram( std::string_view name, std::string_view help = {} );
+
+        /// @brief Registers a gauge evaluated at snapshot time, e.g. for sizes owned by other subsystems.
+        /// Registering the same name again replaces the callback.
+        void RegisterGaugeCallback( std::string_view name, std::string_view help, std::function< int64_t() > callback );
+        void UnregisterGaugeCallback( std::string_view name );
+
+        [[nodiscard]] RegistrySnapshot Snapshot() const;
+
+    private:
+        template< typename T >
+        struct Entry
+        {
+            std::string m_name;
+            std::string m_help;
+            std::unique_ptr< T > m_metric;
+        };
+
+        struct CallbackEntry
+        {
+            std::string m_name;
+            std::string m_help;
+            std::function< int64_t() > m_callback;
+        };
+
+        mutable std::mutex m_mutex;
+        std::vector< Entry< Counter > > m_counters;
+        std::vector< Entry< Gauge > > m_gauges;
+        std::vector< Entry< Histogram > > m_histograms;
+        std::vector< CallbackEntry > m_gauge_callbacks;
+    };
+
+    /// @brief Process wide registry used by built-in metrics (tick, logging, config).
+    Registry & DefaultRegistry();
+
+    /// @brief Renders the snapshot in the Prometheus text exposition format.
+    std::string FormatPrometheus( const RegistrySnapshot & snapshot );
+
+    /// @brief Writes the snapshot to the file in Prometheus text format.
+    /// Goes through a temporary file and a rename so that scrapers never see a partially written file.
+    shm::Result< void > WritePrometheusFile( const RegistrySnapshot & snapshot, const std::filesystem::path & path );
+
+    struct AggregatorSettings
+    {
+        std::chrono::milliseconds m_period{ 1000 };
+        /// @brief Empty path disables the export, snapshots are still taken and available through Latest().
+        std::filesystem::path m_prometheus_file{};
+        /// @brief Called on the aggregator thread when the export failed, with the failures since the last call. A broken
+        /// export fails every period, so it is called at most once per m_export_error_interval.
+        std::function< void( std::error_code error, uint64_t failures ) > m_on_export_error{};
+        std::chrono::milliseconds m_export_error_interval{ 60'000 };
+    };
+
+    /// @brief Background thread that periodically snapshots every shard of the registry and exports the result.
+    class Aggregator
+    {
+    public:
+        Aggregator( Registry & registry, AggregatorSettings settings );
+        ~Aggregator();
+
+        Aggregator( const Aggregator & )             = delete;
+        Aggregator & operator=( const Aggregator & ) = delete;
+        Aggregator( Aggregator && )                  = delete;
+        Aggregator & operator=( Aggregator && )      = delete;
+
+        /// @return Most recent snapshot, nullptr until the first period elapsed.
+        [[nodiscard]] std::shared_ptr< const RegistrySnapshot > Latest() const;
+
+    private:
+        void Run( std::stop_token stop_token );
+
+        Registry & m_registry;
+        AggregatorSettings m_settings;
+
+        mutable std::mutex m_latest_mutex;
+        std::shared_ptr< const RegistrySnapshot > m_latest;
+
+        std::mutex m_wait_mutex;
+        std::condition_variable_any m_wait_cv;
+
+        std::jthread m_thread;
+    };
+} // namespace shm::metrics
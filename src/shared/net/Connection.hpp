@@ -0,0 +1,72 @@
+#pragma once
+
+#include "net/MessageBuffer.hpp"
+#include "protocol/FrameHeader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace shm::net
+{
+    enum class ConnectionState : uint8_t
+    {
+        Connecting,
+        Connected,
+        Closing,
+    };
+
+    /// @brief Entry of a send queue.
+    struct QueuedFrame
+    {
+        MessageBufferHandle m_buffer;
+        /// @brief Only set for a broadcast: m_buffer then holds the payload shared by all recipients and every recipient
+        /// sends its own header in front of it, patched for it if need be.
+        std::optional< protocol::FrameHeader > m_header;
+    };
+
+    /// @brief State the gateway keeps per connected peer (player or service server).
+    /// Kept allocation-free so that connect/disconnect churn only recycles pool slots.
+    struct Connection
+    {
+        static constexpr std::size_t MaxRemoteAddressLength = 47; // fits a textual IPv6 address + port
+        static constexpr std::size_t SendQueueCapacity      = 32;
+
+        explicit Connection( std::string_view remote_address, uint64_t connected_at_tick ) noexcept
+            : m_connected_at_tick( connected_at_tick )
+            , m_last_activity_tick( connected_at_tick )
+        {
+            m_remote_address_length = static_cast< uint8_t >( std::min( remote_address.size(), MaxRemoteAddressLength ) );
+            std::copy_n( remote_address.data(), m_remote_address_length, m_remote_address.data() );
+        }
+
+        [[nodiscard]] std::string_view RemoteAddress() const noexcept
+        {
+            return { m_remote_address.data(), m_remote_address_length };
+        }
+
+        [[nodiscard]] std::size_t QueuedBuffers() const noexcept
+        {
+            return m_send_tail - m_send_head;
+        }
+
+        ConnectionState m_state       = ConnectionState::Connecting;
+        uint64_t m_connected_at_tick  = 0;
+        uint64_t m_last_activity_tick = 0;
+        uint64_t m_bytes_sent         = 0;
+        uint64_t m_bytes_received     = 0;
+
+        /// @brief Ring of buffers waiting to be written to the socket, indices grow monotonically.
+        std::array< QueuedFrame, SendQueueCapacity > m_send_queue{};
+        uint32_t m_send_head = 0;
+        uint32_t m_send_tail = 0;
+
+        std::array< char, MaxRemoteAddressLength > m_remote_address{};
+        uint8_t m_remote_address_length = 0;
+    };
+
+    using ConnectionPool   = shm::mem::SlabPool< Connection >;
+    using ConnectionHandle = ConnectionPool::HandleType;
+} // namespace shm::net
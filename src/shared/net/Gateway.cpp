@@ -0,0 +1,176 @@
+#include "Gateway.hpp"
+
+#include <algorithm>
+
+shm::net::ConnectionHandle shm::net::Gateway::Open( std::string_view remote_address, uint64_t tick )
+{
+    auto handle = m_connections.Create( remote_address, tick );
+    if ( auto * connection = m_connections.Get( handle ) )
+        connection->m_state = ConnectionState::Connected;
+    return handle;
+}
+
+shm::net::ConnectionHandle shm::net::Gateway::Attach( std::string_view remote_address, uint64_t tick, std::unique_ptr< ITransport > transport )
+{
+    auto handle = Resume( remote_address, tick, std::move( transport ) );
+    if ( handle )
+        m_inbox.Push( InboundType::Connected, handle.Pack() );
+    return handle;
+}
+
+shm::net::ConnectionHandle shm::net::Gateway::Resume( std::string_view remote_address, uint64_t tick, std::unique_ptr< ITransport > transport )
+{
+    auto handle = Open( remote_address, tick );
+    if ( handle )
+        m_transports.push_back( { handle, std::move( transport ) } );
+    return handle;
+}
+
+void shm::net::Gateway::PumpTransports( uint64_t tick )
+{
+    Pump( tick, true );
+}
+
+void shm::net::Gateway::FlushTransports()
+{
+    Pump( 0, false );
+}
+
+void shm::net::Gateway::Pump( uint64_t tick, bool receive )
+{
+    if ( m_receive_buffer.empty() )
+        m_receive_buffer.resize( MaxFrameSize );
+
+    // Close erases from m_transports, collect first.
+    std::vector< ConnectionHandle > gone;
+    std::vector< ConnectionHandle > flushed;
+    for ( auto & [ handle, transport ] : m_transports )
+    {
+        auto * connection = m_connections.Get( handle );
+        if ( connection && connection->m_state == ConnectionState::Closing )
+        {
+            if ( !Flush( *connection, *transport ) || ( connection->QueuedBuffers() == 0 && transport->FlushPending().has_value() ) )
+                flushed.push_back( handle );
+            continue;
+        }
+        if ( !connection || !Flush( *connection, *transport ) || ( receive && !Drain( handle, *connection, *transport, tick ) ) )
+            gone.push_back( handle );
+    }
+
+    for ( const auto handle : gone )
+    {
+        m_inbox.Push( InboundType::Disconnected, handle.Pack() );
+        Close( handle );
+    }
+    for ( const auto handle : flushed )
+        Close( handle );
+}
+
+bool shm::net::Gateway::Flush( Connection & connection, ITransport & transport )
+{
+    for ( ; connection.m_send_head != connection.m_send_tail; ++connection.m_send_head )
+    {
+        const auto & entry = connection.m_send_queue[ connection.m_send_head % Connection::SendQueueCapacity ];
+        if ( const auto * buffer = m_buffers.Get( entry.m_buffer ) )
+        {
+            const auto sent = entry.m_header ? transport.SendGathered( *entry.m_header, buffer->Bytes() ) : transport.SendFrame( buffer->Bytes() );
+            if ( !sent.has_value() && sent.error() == std::errc::resource_unavailable_try_again )
+                return true;
+            if ( !sent.has_value() && sent.error() == std::errc::connection_reset )
+                return false;
+            // Anything else is a malformed frame, dropping it beats wedging the queue.
+            if ( sent.has_value() )
+                connection.m_bytes_sent += buffer->m_size + ( entry.m_header ? sizeof( protocol::FrameHeader ) : 0 );
+        }
+        ReleaseBuffer( entry.m_buffer );
+    }
+    // The transport may still hold the tail of the last frame.
+    const auto pending = transport.FlushPending();
+    return pending.has_value() || pending.error() != std::errc::connection_reset;
+}
+
+bool shm::net::Gateway::Drain( ConnectionHandle handle, Connection & connection, ITransport & transport, uint64_t tick )
+{
+    for ( std::size_t frames = 0; frames < MaxFramesPerPump; ++frames )
+    {
+        const auto frame = transport.ReceiveFrame( m_receive_buffer, std::chrono::nanoseconds::zero() );
+        if ( !frame.has_value() )
+            return frame.error() != std::errc::connection_reset;
+
+        m_inbox.Push( InboundType::Message, handle.Pack(), *frame );
+        connection.m_bytes_received += frame->size();
+        connection.m_last_activity_tick = tick;
+    }
+    return true;
+}
+
+bool shm::net::Gateway::Close( ConnectionHandle connection )
+{
+    auto * conn = m_connections.Get( connection );
+    if ( !conn )
+        return false;
+
+    std::erase_if( m_transports, [ & ]( const AttachedTransport & attached ) { return attached.m_connection == connection; } );
+
+    conn->m_state = ConnectionState::Closing;
+    for ( ; conn->m_send_head != conn->m_send_tail; ++conn->m_send_head )
+        ReleaseBuffer( conn->m_send_queue[ conn->m_send_head % Connection::SendQueueCapacity ].m_buffer );
+
+    return m_connections.Destroy( connection );
+}
+
+bool shm::net::Gateway::CloseAfterFlush( ConnectionHandle connection )
+{
+    auto * conn = m_connections.Get( connection );
+    if ( !conn )
+        return false;
+
+    if ( std::ranges::none_of( m_transports, [ & ]( const AttachedTransport & attached ) { return attached.m_connection == connection; } ) )
+        return Close( connection );
+
+    conn->m_state = ConnectionState::Closing;
+    return true;
+}
+
+bool shm::net::Gateway::Send( ConnectionHandle connection, std::span< const std::byte > payload )
+{
+    auto * conn = m_connections.Get( connection );
+    if ( !conn || conn->QueuedBuffers() >= Connection::SendQueueCapacity || payload.size() > MessageBuffer::Capacity )
+        return false;
+
+    auto buffer_handle = m_buffers.Create();
+    auto * buffer      = m_buffers.Get( buffer_handle );
+    if ( !buffer )
+        return false;
+
+    buffer->Append( payload );
+    conn->m_send_queue[ conn->m_send_tail++ % Connection::SendQueueCapacity ] = { buffer_handle, std::nullopt };
+    return true;
+}
+
+shm::net::MessageBufferHandle shm::net::Gateway::PopQueued( ConnectionHandle connection )
+{
+    auto * conn = m_connections.Get( connection );
+    if ( !conn || conn->m_send_head == conn->m_send_tail )
+        return {};
+
+    const auto & entry = conn->m_send_queue[ conn->m_send_head++ % Connection::SendQueueCapacity ];
+    if ( const auto * popped = m_buffers.Get( entry.m_buffer ) )
+        conn->m_bytes_sent += popped->m_size;
+    return entry.m_buffer;
+}
+
+void shm::net::Gateway::ReleaseBuffer( MessageBufferHandle buffer )
+{
+    auto * released = m_buffers.Get( buffer );
+    if ( released && --released->m_references == 0 )
+        m_buffers.Destroy( buffer );
+}
+
+shm::net::GatewayStats shm::net::Gateway::Stats() const
+{
+    return GatewayStats{
+        .m_connections = m_connections.Stats(),
+        .m_buffers     = m_buffers.Stats(),
+    };
+}
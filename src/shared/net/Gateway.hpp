@@ -0,0 +1,171 @@
+#pragma once
+
+#include "net/Connection.hpp"
+#include "net/Inbox.hpp"
+#include "net/MessageBuffer.hpp"
+#include "net/Transport.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace shm::net
+{
+    struct GatewayStats
+    {
+        shm::mem::PoolStats m_connections;
+        shm::mem::PoolStats m_buffers;
+    };
+
+    /// @brief Owns every live connection of the broker together with the message buffers queued on them.
+    /// Connections and buffers are pooled, handles handed out by the gateway are generation checked,
+    /// so a late callback holding a handle of an already closed connection is detected instead of
+    /// touching a recycled connection.
+    class Gateway
+    {
+    public:
+        Gateway()  = default;
+        ~Gateway() = default;
+
+        Gateway( const Gateway & )             = delete;
+        Gateway & operator=( const Gateway & ) = delete;
+        Gateway( Gateway && )                  = delete;
+        Gateway & operator=( Gateway && )      = delete;
+
+        [[nodiscard]] ConnectionHandle Open( std::string_view remote_address, uint64_t tick );
+
+        /// @brief Opens a connection whose frames travel through the given transport and reports it to the tick.
+        /// From then on PumpTransports writes its send queue to the transport and reads its frames into the inbox.
+        [[nodiscard]] ConnectionHandle Attach( std::string_view remote_address, uint64_t tick, std::unique_ptr< ITransport > transport );
+
+        /// @brief Like Attach for a peer the tick already knows, e.g. one handed over by the previous broker process.
+        /// The tick is not told, the caller moves the session over to the new handle.
+        [[nodiscard]] ConnectionHandle Resume( std::string_view remote_address, uint64_t tick, std::unique_ptr< ITransport > transport );
+
+        /// @brief Flushes the send queues of every attached transport and moves the frames that arrived into the inbox,
+        /// without blocking. A transport whose peer went away is reported as disconnected and closed.
+        void PumpTransports( uint64_t tick );
+
+        /// @brief Only the sending half of PumpTransports, so that frames queued by the tick leave in the same tick
+        /// instead of waiting for the next pump.
+        void FlushTransports();
+
+        /// @brief Releases every queued buffer and recycles the connection.
+        /// @return False if the handle is stale.
+        bool Close( ConnectionHandle connection );
+
+        /// @brief Stops reading from the connection and closes it once its send queue was written, e.g. after queueing
+        /// a last message. The tick is not told, the connection is closed right away if it has no transport.
+        /// @return False if the handle is stale.
+        bool CloseAfterFlush( ConnectionHandle connection );
+
+        [[nodiscard]] Connection * Get( ConnectionHandle connection ) noexcept
+        {
+            return m_connections.Get( connection );
+        }
+
+        /// @brief Copies the payload into a pooled buffer and queues it on the connection.
+        /// @return False if the connection is stale, its send queue is full or the payload exceeds MessageBuffer::Capacity.
+        bool Send( ConnectionHandle connection, std::span< const std::byte > payload );
+
+        /// @brief Queues a payload on every recipient while storing it only once. The recipients' send queues hold a
+        /// reference to the shared buffer and a frame header of their own, transports gather both when sending.
+        /// @return Number of recipients it was queued on. Stale connections and full send queues are skipped.
+        std::size_t Broadcast( std::span< const ConnectionHandle > recipients, uint16_t opcode, std::span< const std::byte > payload )
+        {
+            return Broadcast( recipients, opcode, payload, []( ConnectionHandle, protocol::FrameHeader & ) {} );
+        }
+
+        /// @param patch_header Called as patch_header( recipient, header ) to adjust the header of a single recipient.
+        template< typename PatchHeader >
+        std::size_t Broadcast( std::span< const ConnectionHandle > recipients, uint16_t opcode, std::span< const std::byte > payload,
+                               PatchHeader && patch_header )
+        {
+            if ( payload.size() > MessageBuffer::Capacity || payload.size() > UINT16_MAX )
+                return 0;
+            const auto shared = m_buffers.Create();
+            auto * buffer     = m_buffers.Get( shared );
+            if ( !buffer )
+                return 0;
+            buffer->Append( payload );
+
+            const protocol::FrameHeader header{ .m_length   = static_cast< uint16_t >( payload.size() ),
+                                                .m_opcode   = opcode,
+                                                .m_checksum = shm::hash::Crc32c( payload ) };
+            std::size_t queued = 0;
+            for ( const auto recipient : recipients )
+            {
+                auto * connection = m_connections.Get( recipient );
+                if ( !connection || connection->QueuedBuffers() >= Connection::SendQueueCapacity )
+                    continue;
+
+                auto & entry = connection->m_send_queue[ connection->m_send_tail++ % Connection::SendQueueCapacity ];
+                entry        = { shared, header };
+                patch_header( recipient, *entry.m_header );
+                ++buffer->m_references;
+                ++queued;
+            }
+            // Drops the reference of the broadcast itself, the buffer is gone right away if nobody took it.
+            ReleaseBuffer( shared );
+            return queued;
+        }
+
+        /// @brief Pops the oldest queued buffer. The caller has to hand it back through ReleaseBuffer once written.
+        /// The buffer of a broadcast holds only the payload and is shared, it must not be modified.
+        [[nodiscard]] MessageBufferHandle PopQueued( ConnectionHandle connection );
+
+        [[nodiscard]] MessageBuffer * GetBuffer( MessageBufferHandle buffer ) noexcept
+        {
+            return m_buffers.Get( buffer );
+        }
+
+        [[nodiscard]] MessageBufferHandle AcquireBuffer()
+        {
+            return m_buffers.Create();
+        }
+
+        /// @brief Drops one reference to the buffer and recycles it once no send queue holds it anymore.
+        void ReleaseBuffer( MessageBufferHandle buffer );
+
+        [[nodiscard]] std::size_t ConnectionCount() const noexcept
+        {
+            return m_connections.LiveCount();
+        }
+
+        /// @brief Events received from peers since the last tick, drained by the tick.
+        [[nodiscard]] Inbox & Inbound() noexcept
+        {
+            return m_inbox;
+        }
+
+        [[nodiscard]] GatewayStats Stats() const;
+
+    private:
+        struct AttachedTransport
+        {
+            ConnectionHandle m_connection;
+            std::unique_ptr< ITransport > m_transport;
+        };
+
+        /// @param receive False only flushes, see FlushTransports.
+        void Pump( uint64_t tick, bool receive );
+
+        /// @brief Writes queued buffers until the transport pushes back.
+        /// @return False if the peer is gone.
+        bool Flush( Connection & connection, ITransport & transport );
+
+        /// @brief Reads the frames that already arrived, at most MaxFramesPerPump to keep one peer from stalling the tick.
+        /// @return False if the peer is gone.
+        bool Drain( ConnectionHandle handle, Connection & connection, ITransport & transport, uint64_t tick );
+
+        static constexpr std::size_t MaxFramesPerPump = 64;
+
+        ConnectionPool m_connections;
+        MessageBufferPool m_buffers;
+        Inbox m_inbox;
+        std::vector< AttachedTransport > m_transports;
+        std::vector< std::byte > m_receive_buffer;
+    };
+} // namespace shm::net
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace shm::net
+{
+    enum class InboundType : uint8_t
+    {
+        Connected,
+        Disconnected,
+        Message,
+    };
+
+    /// @brief Something a peer did, as seen by the tick. The payload is only valid until the inbox is cleared.
+    struct InboundEvent
+    {
+        InboundType m_type = InboundType::Message;
+        uint64_t m_session = 0;
+        std::span< const std::byte > m_payload;
+    };
+
+    /// @brief A session that carries on under another id, e.g. after its peer was handed to another broker process.
+    struct SessionRename
+    {
+        uint64_t m_from = 0;
+        uint64_t m_to   = 0;
+    };
+
+    /// @brief Events received since the last tick, in arrival order. The tick drains it once per frame, so both
+    /// the event list and the payload bytes are reused and stop allocating once they reached their peak size.
+    class Inbox
+    {
+    public:
+        void Push( InboundType type, uint64_t session, std::span< const std::byte > payload = {} )
+        {
+            m_entries.push_back( { type, session, m_payloads.size(), payload.size() } );
+            m_payloads.insert( m_payloads.end(), payload.begin(), payload.end() );
+        }
+
+        template< typename OnEvent >
+        void ForEach( OnEvent && on_event ) const
+        {
+            for ( const auto & entry : m_entries )
+                on_event( InboundEvent{ entry.m_type, entry.m_session, std::span( m_payloads ).subspan( entry.m_offset, entry.m_size ) } );
+        }
+
+        void Clear() noexcept
+        {
+            m_entries.clear();
+            m_payloads.clear();
+        }
+
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            return m_entries.size();
+        }
+
+    private:
+        struct Entry
+        {
+            InboundType m_type;
+            uint64_t m_session;
+            std::size_t m_offset;
+            std::size_t m_size;
+        };
+
+        std::vector< Entry > m_entries;
+        std::vector< std::byte > m_payloads;
+    };
+} // namespace shm::net
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "memory/SlabPool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace shm::net
+{
+    /// @brief Fixed-capacity byte buffer for a single framed message.
+    /// Buffers are recycled through a SlabPool, so sending does not touch the global allocator.
+    struct MessageBuffer
+    {
+        static constexpr std::size_t Capacity = 4096;
+
+        // User-provided on purpose: pooled buffers are value-initialized on Create, which would otherwise zero all of m_data.
+        MessageBuffer() noexcept {}
+
+        std::array< std::byte, Capacity > m_data;
+        uint32_t m_size = 0;
+        /// @brief Send queues holding the buffer. A broadcast queues one buffer on every recipient, it is recycled
+        /// once the last of them let go of it.
+        uint32_t m_references = 1;
+
+        [[nodiscard]] std::span< std::byte > Writable() noexcept
+        {
+            return { m_data.data() + m_size, Capacity - m_size };
+        }
+
+        [[nodiscard]] std::span< const std::byte > Bytes() const noexcept
+        {
+            return { m_data.data(), m_size };
+        }
+
+        /// @return False if the data does not fit, the buffer is left untouched in that case.
+        bool Append( std::span< const std::byte > bytes ) noexcept
+        {
+            if ( bytes.size() > Capacity - m_size )
+                return false;
+
+            std::copy( bytes.begin(), bytes.end(), m_data.begin() + m_size );
+            m_size += static_cast< uint32_t >( bytes.size() );
+            return true;
+        }
+
+        void Clear() noexcept
+        {
+            m_size = 0;
+        }
+    };
+
+    using MessageBufferPool   = shm::mem::SlabPool< MessageBuffer, 64 >;
+    using MessageBufferHandle = MessageBufferPool::HandleType;
+} // namespace shm::net
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Messages between peers and the broker. Each one is framed behind a protocol::FrameHeader carrying its opcode
+/// and encoded with shm::wire, so the field order here is the wire layout and must not change once released.
+namespace shm::net::msg
+{
+    /// @brief Moves the session's entity to a new position.
+    struct Move
+    {
+        static constexpr uint16_t Opcode = 1;
+
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+    };
+
+    /// @brief Moves the session's entity into another world.
+    struct SetWorld
+    {
+        static constexpr uint16_t Opcode = 2;
+
+        uint32_t world_id = 0;
+    };
+
+    /// @brief Sent by the broker to a peer it turns away while overloaded, right before closing the connection.
+    struct Rejected
+    {
+        static constexpr uint16_t Opcode = 3;
+
+        /// @brief Time after which the peer may connect again.
+        uint32_t retry_after_ms = 0;
+    };
+} // namespace shm::net::msg
@@ -0,0 +1,115 @@
+#include "ReliableChannel.hpp"
+
+shm::net::ReliableChannel::ReliableChannel( ReliableSettings settings, uint32_t connection )
+    : m_settings( settings )
+    , m_connection( connection )
+{
+    m_datagram.reserve( MaxDatagramSize );
+}
+
+bool shm::net::ReliableChannel::Queue( std::span< const std::byte > head, std::span< const std::byte > tail )
+{
+    if ( head.size() + tail.size() > MaxReliablePayload || InFlight() >= Window )
+        return false;
+
+    auto & slot    = m_sent[ m_next_sequence % Window ];
+    slot.m_pending = true;
+    slot.m_sent    = false;
+    slot.m_message.assign( head.begin(), head.end() );
+    slot.m_message.insert( slot.m_message.end(), tail.begin(), tail.end() );
+    ++m_next_sequence;
+    return true;
+}
+
+shm::net::ReliableState shm::net::ReliableChannel::Capture() const
+{
+    ReliableState state{
+        .connection = m_connection, .next_sequence = m_next_sequence, .oldest_unacked = m_oldest_unacked, .next_expected = m_next_expected
+    };
+    const auto copy = []( uint16_t sequence, const Slot & slot )
+    {
+        PendingMessage message{ .sequence = sequence, .bytes = std::vector< uint8_t >( slot.m_message.size() ) };
+        std::memcpy( message.bytes.data(), slot.m_message.data(), slot.m_message.size() );
+        return message;
+    };
+    for ( uint16_t sequence = m_oldest_unacked; sequence != m_next_sequence; ++sequence )
+    {
+        if ( m_sent[ sequence % Window ].m_pending )
+            state.unacked.push_back( copy( sequence, m_sent[ sequence % Window ] ) );
+    }
+    for ( uint16_t offset = 1; offset < Window; ++offset )
+    {
+        const auto sequence = static_cast< uint16_t >( m_next_expected + offset );
+        if ( m_received[ sequence % Window ].m_pending )
+            state.out_of_order.push_back( copy( sequence, m_received[ sequence % Window ] ) );
+    }
+    return state;
+}
+
+void shm::net::ReliableChannel::Restore( const ReliableState & state )
+{
+    for ( auto & slot : m_sent )
+        slot.m_pending = false;
+    for ( auto & slot : m_received )
+        slot.m_pending = false;
+
+    m_connection     = state.connection;
+    m_next_sequence  = state.next_sequence;
+    m_oldest_unacked = state.oldest_unacked;
+    m_next_expected  = state.next_expected;
+
+    const auto restore = []( Slot & slot, const PendingMessage & message )
+    {
+        slot.m_pending = true;
+        slot.m_sent    = false;
+        slot.m_message.resize( message.bytes.size() );
+        std::memcpy( slot.m_message.data(), message.bytes.data(), message.bytes.size() );
+    };
+    for ( const auto & message : state.unacked )
+    {
+        if ( static_cast< uint16_t >( message.sequence - m_oldest_unacked ) < InFlight() )
+            restore( m_sent[ message.sequence % Window ], message );
+    }
+    for ( const auto & message : state.out_of_order )
+    {
+        const auto offset = static_cast< uint16_t >( message.sequence - m_next_expected );
+        if ( offset != 0 && offset < Window )
+            restore( m_received[ message.sequence % Window ], message );
+    }
+    m_ack_due = true;
+}
+
+std::span< const std::byte > shm::net::ReliableChannel::Build( uint16_t sequence, std::span< const std::byte > message )
+{
+    ReliableHeader header{ .m_sequence = sequence, .m_ack = m_next_expected, .m_connection = m_connection };
+    for ( uint32_t bit = 0; bit < 32; ++bit )
+    {
+        if ( m_received[ static_cast< uint16_t >( m_next_expected + 1 + bit ) % Window ].m_pending )
+            header.m_ack_bits |= 1u << bit;
+    }
+
+    m_datagram.resize( sizeof( header ) + message.size() );
+    std::memcpy( m_datagram.data(), &header, sizeof( header ) );
+    std::memcpy( m_datagram.data() + sizeof( header ), message.data(), message.size() );
+    return m_datagram;
+}
+
+void shm::net::ReliableChannel::Acknowledge( const ReliableHeader & header )
+{
+    // An ack from before the current window or beyond what was sent is stale or forged.
+    const auto acked = static_cast< uint16_t >( header.m_ack - m_oldest_unacked );
+    if ( acked > InFlight() )
+        return;
+
+    for ( uint16_t i = 0; i < acked; ++i )
+        m_sent[ static_cast< uint16_t >( m_oldest_unacked + i ) % Window ].m_pending = false;
+    for ( uint32_t bit = 0; bit < 32; ++bit )
+    {
+        const auto sequence = static_cast< uint16_t >( header.m_ack + 1 + bit );
+        if ( ( header.m_ack_bits & ( 1u << bit ) ) != 0 && static_cast< uint16_t >( sequence - m_oldest_unacked ) < InFlight() )
+            m_sent[ sequence % Window ].m_pending = false;
+    }
+
+    while ( m_oldest_unacked != m_next_sequence && !m_sent[ m_oldest_unacked % Window ].m_pending )
+        ++m_oldest_unacked;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "net/UdpSocket.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace shm::net
+{
+    /// @brief In front of every datagram of a ReliableChannel. A datagram without payload only carries acks.
+    struct ReliableHeader
+    {
+        uint16_t m_sequence = 0;
+        /// @brief Next sequence the receiver expects, everything before it arrived.
+        uint16_t m_ack = 0;
+        /// @brief Bit i is set if m_ack + 1 + i arrived out of order.
+        uint32_t m_ack_bits = 0;
+        /// @brief Connection the datagram belongs to, see ReliableChannel. 0 before one was agreed on, e.g. during the
+        /// handshake of a UdpServer.
+        uint32_t m_connection = 0;
+    };
+    static_assert( sizeof( ReliableHeader ) == 12 );
+
+    /// @brief Largest message a ReliableChannel sends in one datagram.
+    constexpr std::size_t MaxReliablePayload = MaxDatagramSize - sizeof( ReliableHeader );
+
+    /// @brief A message held by a ReliableChannel, see ReliableState.
+    struct PendingMessage
+    {
+        uint16_t sequence = 0;
+        std::vector< uint8_t > bytes;
+    };
+
+    /// @brief Everything a ReliableChannel needs to carry on where another one left off, e.g. in another process.
+    /// Field names are the serialized names.
+    struct ReliableState
+    {
+        uint32_t connection     = 0;
+        uint16_t next_sequence  = 0;
+        uint16_t oldest_unacked = 0;
+        uint16_t next_expected  = 0;
+        /// @brief Sent messages the peer has not acknowledged yet.
+        std::vector< PendingMessage > unacked;
+        /// @brief Received messages held back behind a lost one.
+        std::vector< PendingMessage > out_of_order;
+    };
+
+    struct ReliableSettings
+    {
+        /// @brief Ticks a datagram stays unacknowledged before it is sent again, 100 ms at 120 ticks per second.
+        uint64_t m_resend_after_ticks = 12;
+    };
+
+    /// @brief Ordered, reliable delivery over datagrams that may be lost, duplicated or reordered. Every message is
+    /// one datagram, sent again until the peer acknowledges it. The peer delivers messages in the order they were
+    /// queued, holding back those that overtook a lost one. Acks ride along on every datagram and cover the 32
+    /// sequences after the first missing one, so a single loss does not resend what arrived behind it.
+    /// Every datagram carries the channel's connection, datagrams of another connection, e.g. of an earlier one between
+    /// the same addresses, are ignored.
+    class ReliableChannel
+    {
+    public:
+        /// @brief Messages in flight per direction. Sequences wrap at 16 bits, the window keeps them unambiguous.
+        static constexpr std::size_t Window = 256;
+
+        explicit ReliableChannel( ReliableSettings settings = {}, uint32_t connection = 0 );
+
+        /// @brief Copies a message into the send window.
+        /// @return False if the window is full or the message is larger than MaxReliablePayload.
+        bool Queue( std::span< const std::byte > message )
+        {
+            return Queue( message, {} );
+        }
+
+        /// @brief Copies a message given in two parts, e.g. a frame header and a shared payload, into the send window.
+        bool Queue( std::span< const std::byte > head, std::span< const std::byte > tail );
+
+        /// @brief Emits the datagrams due at the given tick: messages never sent, messages whose resend timer ran out,
+        /// or a bare ack if the peer sent something since the last ack.
+        template< typename OnDatagram >
+        void Poll( uint64_t tick, OnDatagram && on_datagram )
+        {
+            bool acked = false;
+            for ( uint16_t sequence = m_oldest_unacked; sequence != m_next_sequence; ++sequence )
+            {
+                auto & slot = m_sent[ sequence % Window ];
+                if ( !slot.m_pending || ( slot.m_sent && tick < slot.m_sent_tick + m_settings.m_resend_after_ticks ) )
+                    continue;
+                if ( slot.m_sent )
+                    ++m_resends;
+                slot.m_sent      = true;
+                slot.m_sent_tick = tick;
+                on_datagram( Build( sequence, slot.m_message ) );
+                acked = true;
+            }
+            if ( m_ack_due && !acked )
+                on_datagram( Build( 0, {} ) );
+            m_ack_due = false;
+        }
+
+        /// @brief Processes a datagram of the peer and hands the messages that are now in order to on_message.
+        /// @return False if the datagram is too short to be one of a ReliableChannel or belongs to another connection.
+        template< typename OnMessage >
+        bool Receive( std::span< const std::byte > datagram, OnMessage && on_message )
+        {
+            ReliableHeader header;
+            if ( datagram.size() < sizeof( header ) )
+                return false;
+            std::memcpy( &header, datagram.data(), sizeof( header ) );
+            if ( header.m_connection != m_connection )
+                return false;
+            Acknowledge( header );
+
+            const auto payload = datagram.subspan( sizeof( header ) );
+            if ( payload.empty() )
+                return true;
+
+            // Duplicates are acknowledged again, their first ack may have been the one that got lost.
+            m_ack_due         = true;
+            const auto offset = static_cast< uint16_t >( header.m_sequence - m_next_expected );
+            if ( offset >= Window )
+                return true;
+
+            auto & slot = m_received[ header.m_sequence % Window ];
+            if ( offset != 0 )
+            {
+                if ( !slot.m_pending )
+                {
+                    slot.m_pending = true;
+                    slot.m_message.assign( payload.begin(), payload.end() );
+                }
+                return true;
+            }
+
+            on_message( payload );
+            ++m_next_expected;
+            for ( auto * next = &m_received[ m_next_expected % Window ]; next->m_pending; next = &m_received[ m_next_expected % Window ] )
+            {
+                next->m_pending = false;
+                on_message( std::span< const std::byte >( next->m_message ) );
+                ++m_next_expected;
+            }
+            return true;
+        }
+
+        /// @brief Messages queued but not acknowledged yet.
+        [[nodiscard]] std::size_t InFlight() const noexcept
+        {
+            return static_cast< uint16_t >( m_next_sequence - m_oldest_unacked );
+        }
+
+        [[nodiscard]] uint32_t Connection() const noexcept
+        {
+            return m_connection;
+        }
+
+        [[nodiscard]] ReliableState Capture() const;
+        /// @brief Continues from a captured state. Unacknowledged messages go out again with the next Poll and the
+        /// peer is acknowledged right away, in case acks got lost while nobody was polling.
+        void Restore( const ReliableState & state );
+
+        /// @brief Number of datagrams sent again because their ack did not arrive in time.
+        [[nodiscard]] uint64_t Resends() const noexcept
+        {
+            return m_resends;
+        }
+
+    private:
+        struct Slot
+        {
+            bool m_pending       = false;
+            bool m_sent          = false;
+            uint64_t m_sent_tick = 0;
+            /// @brief Keeps its capacity when the slot is reused, the window stops allocating once warm.
+            std::vector< std::byte > m_message;
+        };
+
+        /// @brief Header with the current acks followed by the message, in m_datagram.
+        std::span< const std::byte > Build( uint16_t sequence, std::span< const std::byte > message );
+        void Acknowledge( const ReliableHeader & header );
+
+        ReliableSettings m_settings;
+        uint32_t m_connection = 0;
+        std::array< Slot, Window > m_sent;
+        std::array< Slot, Window > m_received;
+        uint16_t m_next_sequence  = 0;
+        uint16_t m_oldest_unacked = 0;
+        uint16_t m_next_expected  = 0;
+        bool m_ack_due            = false;
+        uint64_t m_resends        = 0;
+        std::vector< std::byte > m_datagram;
+    };
+} // namespace shm::net
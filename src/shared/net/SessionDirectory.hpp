@@ -0,0 +1,71 @@
+#pragma once
+
+#include "threading/ConcurrentMap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace shm::net
+{
+    /// @brief Where a session lives in the broker world.
+    struct SessionEntry
+    {
+        uint64_t m_entity   = 0;
+        uint32_t m_world_id = 0;
+    };
+
+    /// @brief Sessions by id and by the entity (player) they drive, for threads other than the tick thread such as
+    /// I/O threads. Only the tick thread writes, as it creates and destroys the session entities, every other thread
+    /// looks up without locking. A player found always has its session published, the other way round a session
+    /// may briefly be found while its player is not.
+    class SessionDirectory
+    {
+    public:
+        /// @param expected_sessions Sessions the directory holds without growing.
+        explicit SessionDirectory( std::size_t expected_sessions = 0 )
+            : m_sessions( expected_sessions )
+            , m_players( expected_sessions )
+        {
+        }
+
+        /// @brief Tick thread only.
+        void Publish( uint64_t session, const SessionEntry & entry )
+        {
+            if ( const auto previous = m_sessions.Find( session ); previous && previous->m_entity != entry.m_entity )
+                m_players.Erase( previous->m_entity );
+            m_sessions.InsertOrAssign( session, entry );
+            m_players.InsertOrAssign( entry.m_entity, session );
+        }
+
+        /// @brief Tick thread only.
+        void Withdraw( uint64_t session )
+        {
+            const auto entry = m_sessions.Find( session );
+            if ( !entry )
+                return;
+            m_players.Erase( entry->m_entity );
+            m_sessions.Erase( session );
+        }
+
+        [[nodiscard]] std::optional< SessionEntry > FindSession( uint64_t session ) const
+        {
+            return m_sessions.Find( session );
+        }
+
+        /// @return The session driving the entity.
+        [[nodiscard]] std::optional< uint64_t > FindPlayer( uint64_t entity ) const
+        {
+            return m_players.Find( entity );
+        }
+
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            return m_sessions.Size();
+        }
+
+    private:
+        shm::ConcurrentMap< uint64_t, SessionEntry > m_sessions;
+        shm::ConcurrentMap< uint64_t, uint64_t > m_players;
+    };
+} // namespace shm::net
@@ -0,0 +1,476 @@
+#include "ShmTransport.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+/// @brief Positions of one ring. Both counters grow monotonically, the byte at position p lives at p % capacity.
+/// Writer and reader each own one of them, the cache line padding keeps them from bouncing the other's line.
+struct shm::net::ShmRingState
+{
+    alignas( 64 ) std::atomic< uint64_t > m_write{ 0 };
+    alignas( 64 ) std::atomic< uint64_t > m_read{ 0 };
+    /// @brief Set by a reader about to sleep on the eventfd, the writer only pays for the wake up if it is set.
+    alignas( 64 ) std::atomic< uint32_t > m_reader_waiting{ 0 };
+    /// @brief Set once the writer detached.
+    std::atomic< uint32_t > m_closed{ 0 };
+};
+
+namespace
+{
+    constexpr uint32_t G_SHM_MAGIC       = 0x52'4D'48'53; // "SHMR"
+    constexpr std::size_t G_CONTROL_SIZE = 4096;
+    /// @brief Sent by a ShmListener together with the memfd and both eventfds, in this order.
+    constexpr uint32_t G_OFFER_MAGIC = 0x4F'4D'48'53; // "SHMO"
+    /// @brief Connections a single ShmListener::Accept takes at most, the rest wait for the next tick.
+    constexpr std::size_t G_ACCEPTS_PER_CALL = 16;
+
+    /// @brief Start of the memfd, followed by the data of ring 0 and ring 1.
+    struct ControlBlock
+    {
+        uint32_t m_magic    = G_SHM_MAGIC;
+        uint64_t m_capacity = 0;
+        shm::net::ShmRingState m_rings[ 2 ];
+    };
+    static_assert( sizeof( ControlBlock ) <= G_CONTROL_SIZE );
+    static_assert( std::atomic< uint64_t >::is_always_lock_free, "Ring positions are shared with another process" );
+
+    std::size_t MappingSize( std::size_t capacity )
+    {
+        return G_CONTROL_SIZE + 2 * capacity;
+    }
+
+    void CopyIn( std::byte * ring, std::size_t capacity, uint64_t position, std::span< const std::byte > bytes )
+    {
+        const auto offset = static_cast< std::size_t >( position & ( capacity - 1 ) );
+        const auto first  = std::min( bytes.size(), capacity - offset );
+        std::memcpy( ring + offset, bytes.data(), first );
+        std::memcpy( ring, bytes.data() + first, bytes.size() - first );
+    }
+
+    void CopyOut( const std::byte * ring, std::size_t capacity, uint64_t position, std::span< std::byte > bytes )
+    {
+        const auto offset = static_cast< std::size_t >( position & ( capacity - 1 ) );
+        const auto first  = std::min( bytes.size(), capacity - offset );
+        std::memcpy( bytes.data(), ring + offset, first );
+        std::memcpy( bytes.data() + first, ring, bytes.size() - first );
+    }
+
+    inline void CpuRelax() noexcept
+    {
+#if defined( __x86_64__ ) || defined( _M_X64 )
+        __builtin_ia32_pause();
+#elif defined( __aarch64__ )
+        asm volatile( "yield" );
+#endif
+    }
+
+#ifdef __linux__
+    std::unexpected< std::error_code > LastError()
+    {
+        return std::unexpected( std::error_code( errno, std::generic_category() ) );
+    }
+
+    void Wake( const shm::net::UniqueFd & wake )
+    {
+        const uint64_t one = 1;
+        std::ignore        = ::write( wake.Get(), &one, sizeof( one ) );
+    }
+
+    shm::Result< sockaddr_un > ToSockaddr( const std::filesystem::path & path )
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        const auto & name  = path.native();
+        if ( name.empty() || name.size() >= sizeof( address.sun_path ) )
+            return std::unexpected( std::make_error_code( std::errc::filename_too_long ) );
+        std::memcpy( address.sun_path, name.c_str(), name.size() );
+        return address;
+    }
+
+    /// @brief Hands the channel's descriptors to the service on the other end of the connection.
+    bool SendChannel( int connection, const shm::net::ShmChannel & channel )
+    {
+        const std::array descriptors{ channel.m_memory.Get(), channel.m_wake[ 0 ].Get(), channel.m_wake[ 1 ].Get() };
+        alignas( cmsghdr ) std::array< std::byte, CMSG_SPACE( sizeof( descriptors ) ) > control{};
+        uint32_t magic = G_OFFER_MAGIC;
+        iovec part{ &magic, sizeof( magic ) };
+        msghdr message{};
+        message.msg_iov        = &part;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control.data();
+        message.msg_controllen = control.size();
+        cmsghdr * rights       = CMSG_FIRSTHDR( &message );
+        rights->cmsg_level     = SOL_SOCKET;
+        rights->cmsg_type      = SCM_RIGHTS;
+        rights->cmsg_len       = CMSG_LEN( sizeof( descriptors ) );
+        std::memcpy( CMSG_DATA( rights ), descriptors.data(), sizeof( descriptors ) );
+        // A fresh connection has room for a few bytes, one that has not is not worth waiting for.
+        return ::sendmsg( connection, &message, MSG_NOSIGNAL | MSG_DONTWAIT ) == static_cast< ssize_t >( sizeof( magic ) );
+    }
+#endif
+} // namespace
+
+shm::Result< shm::net::ShmChannel > shm::net::ShmTransport::CreateChannel( std::size_t ring_capacity )
+{
+#ifndef __linux__
+    (void)ring_capacity;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    const auto capacity = std::bit_ceil( std::max( ring_capacity, MaxFrameSize ) );
+
+    ShmChannel channel;
+    channel.m_memory = UniqueFd( ::memfd_create( "shimmer-transport", MFD_CLOEXEC ) );
+    if ( !channel.m_memory || ::ftruncate( channel.m_memory.Get(), static_cast< off_t >( MappingSize( capacity ) ) ) != 0 )
+        return LastError();
+    for ( auto & wake : channel.m_wake )
+    {
+        wake = UniqueFd( ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK ) );
+        if ( !wake )
+            return LastError();
+    }
+
+    void * control = ::mmap( nullptr, G_CONTROL_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, channel.m_memory.Get(), 0 );
+    if ( control == MAP_FAILED )
+        return LastError();
+    auto * block      = new ( control ) ControlBlock();
+    block->m_capacity = capacity;
+    ::munmap( control, G_CONTROL_SIZE );
+    return channel;
+#endif
+}
+
+shm::Result< std::unique_ptr< shm::net::ShmTransport > > shm::net::ShmTransport::Attach( const ShmChannel & channel, ShmSide side,
+                                                                                        ShmSettings settings )
+{
+#ifndef __linux__
+    (void)channel;
+    (void)side;
+    (void)settings;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    struct stat memory_stat{};
+    if ( ::fstat( channel.m_memory.Get(), &memory_stat ) != 0 )
+        return LastError();
+    const auto size = static_cast< std::size_t >( memory_stat.st_size );
+    if ( size < G_CONTROL_SIZE )
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+
+    auto * mapping = static_cast< std::byte * >( ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, channel.m_memory.Get(), 0 ) );
+    if ( mapping == MAP_FAILED )
+        return LastError();
+    const auto * control = std::launder( reinterpret_cast< const ControlBlock * >( mapping ) );
+    const auto capacity  = static_cast< std::size_t >( control->m_capacity );
+    if ( control->m_magic != G_SHM_MAGIC || !std::has_single_bit( capacity ) || MappingSize( capacity ) != size )
+    {
+        ::munmap( mapping, size );
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+    }
+
+    UniqueFd memory( ::fcntl( channel.m_memory.Get(), F_DUPFD_CLOEXEC, 0 ) );
+    UniqueFd wake_0( ::fcntl( channel.m_wake[ 0 ].Get(), F_DUPFD_CLOEXEC, 0 ) );
+    UniqueFd wake_1( ::fcntl( channel.m_wake[ 1 ].Get(), F_DUPFD_CLOEXEC, 0 ) );
+    if ( !memory || !wake_0 || !wake_1 )
+    {
+        ::munmap( mapping, size );
+        return LastError();
+    }
+
+    // Spinning only pays off while the writer runs on another core, on a single one it keeps the writer from running.
+    if ( std::thread::hardware_concurrency() <= 1 )
+        settings.m_busy_poll = std::chrono::nanoseconds::zero();
+
+    const bool broker = side == ShmSide::Broker;
+    return std::unique_ptr< ShmTransport >( new ShmTransport( std::move( memory ), broker ? std::move( wake_0 ) : std::move( wake_1 ),
+                                                              broker ? std::move( wake_1 ) : std::move( wake_0 ), mapping, capacity, side,
+                                                              settings ) );
+#endif
+}
+
+shm::net::ShmTransport::ShmTransport( UniqueFd memory, UniqueFd tx_wake, UniqueFd rx_wake, std::byte * mapping, std::size_t capacity,
+                                      ShmSide side, ShmSettings settings )
+    : m_memory( std::move( memory ) )
+    , m_tx_wake( std::move( tx_wake ) )
+    , m_rx_wake( std::move( rx_wake ) )
+    , m_mapping( mapping )
+    , m_capacity( capacity )
+    , m_settings( settings )
+{
+    auto * control     = std::launder( reinterpret_cast< ControlBlock * >( mapping ) );
+    const auto tx_ring = side == ShmSide::Broker ? 0u : 1u;
+    m_tx               = &control->m_rings[ tx_ring ];
+    m_rx               = &control->m_rings[ 1 - tx_ring ];
+    m_tx_data          = mapping + G_CONTROL_SIZE + tx_ring * capacity;
+    m_rx_data          = mapping + G_CONTROL_SIZE + ( 1 - tx_ring ) * capacity;
+}
+
+shm::net::ShmTransport::~ShmTransport()
+{
+#ifdef __linux__
+    m_tx->m_closed.store( 1, std::memory_order_seq_cst );
+    Wake( m_tx_wake );
+    ::munmap( m_mapping, MappingSize( m_capacity ) );
+#endif
+}
+
+shm::Result< void > shm::net::ShmTransport::SendGathered( const protocol::FrameHeader & header, std::span< const std::byte > payload )
+{
+    if ( header.m_length != payload.size() )
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+    if ( m_rx->m_closed.load( std::memory_order_relaxed ) != 0 )
+        return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+
+    const auto write = m_tx->m_write.load( std::memory_order_relaxed );
+    const auto read  = m_tx->m_read.load( std::memory_order_acquire );
+    const auto size  = FrameSizeOf( header );
+    if ( m_capacity - ( write - read ) < size )
+        return std::unexpected( std::make_error_code( std::errc::resource_unavailable_try_again ) );
+
+    CopyIn( m_tx_data, m_capacity, write, std::as_bytes( std::span( &header, 1 ) ) );
+    CopyIn( m_tx_data, m_capacity, write + sizeof( header ), payload );
+    m_tx->m_write.store( write + size, std::memory_order_release );
+
+#ifdef __linux__
+    // Pairs with the fence in ReceiveFrame: either the reader sees the new position before it sleeps,
+    // or this sees its waiting flag and wakes it.
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if ( m_tx->m_reader_waiting.load( std::memory_order_relaxed ) != 0 )
+        Wake( m_tx_wake );
+#endif
+    return {};
+}
+
+shm::Result< std::span< const std::byte > > shm::net::ShmTransport::TryReceive( std::span< std::byte > buffer )
+{
+    const auto read  = m_rx->m_read.load( std::memory_order_relaxed );
+    const auto write = m_rx->m_write.load( std::memory_order_acquire );
+    if ( read == write )
+        return std::span< const std::byte >{};
+
+    protocol::FrameHeader header;
+    CopyOut( m_rx_data, m_capacity, read, std::as_writable_bytes( std::span( &header, 1 ) ) );
+    const auto size = FrameSizeOf( header );
+    if ( size > buffer.size() )
+        return std::unexpected( std::make_error_code( std::errc::message_size ) );
+
+    CopyOut( m_rx_data, m_capacity, read, buffer.first( size ) );
+    m_rx->m_read.store( read + size, std::memory_order_release );
+    return buffer.first( size );
+}
+
+shm::Result< std::span< const std::byte > > shm::net::ShmTransport::ReceiveFrame( std::span< std::byte > buffer, std::chrono::nanoseconds timeout )
+{
+    using Clock         = std::chrono::steady_clock;
+    const auto start    = Clock::now();
+    const auto deadline = start + timeout;
+    const auto spin_end = start + std::min( timeout, m_settings.m_busy_poll );
+
+    while ( true )
+    {
+        auto received = TryReceive( buffer );
+        if ( !received.has_value() || !received->empty() )
+            return received;
+        // The writer sets m_closed after its last frame, an empty ring seen after it is final.
+        if ( m_rx->m_closed.load( std::memory_order_acquire ) != 0 )
+        {
+            received = TryReceive( buffer );
+            if ( !received.has_value() || !received->empty() )
+                return received;
+            return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+        }
+
+        const auto now = Clock::now();
+        if ( now >= deadline )
+            return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+        if ( now < spin_end )
+        {
+            CpuRelax();
+            continue;
+        }
+
+#ifndef __linux__
+        return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+        m_rx->m_reader_waiting.store( 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( m_rx->m_write.load( std::memory_order_relaxed ) == m_rx->m_read.load( std::memory_order_relaxed )
+             && m_rx->m_closed.load( std::memory_order_relaxed ) == 0 )
+        {
+            const auto remaining = std::chrono::duration_cast< std::chrono::nanoseconds >( deadline - now );
+            const timespec wait{ .tv_sec  = static_cast< time_t >( remaining.count() / 1'000'000'000 ),
+                                 .tv_nsec = static_cast< long >( remaining.count() % 1'000'000'000 ) };
+            pollfd readable{ .fd = m_rx_wake.Get(), .events = POLLIN, .revents = 0 };
+            ::ppoll( &readable, 1, &wait, nullptr );
+        }
+        m_rx->m_reader_waiting.store( 0, std::memory_order_relaxed );
+
+        uint64_t wakes = 0;
+        std::ignore    = ::read( m_rx_wake.Get(), &wakes, sizeof( wakes ) );
+#endif
+    }
+}
+
+shm::Result< std::unique_ptr< shm::net::ShmTransport > > shm::net::ShmTransport::Connect( const std::filesystem::path & path,
+                                                                                         std::chrono::milliseconds timeout, ShmSettings settings )
+{
+#ifndef __linux__
+    (void)path;
+    (void)timeout;
+    (void)settings;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    auto address = ToSockaddr( path );
+    if ( !address.has_value() )
+        return std::unexpected( address.error() );
+
+    UniqueFd broker( ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+    if ( !broker )
+        return LastError();
+    if ( ::connect( broker.Get(), reinterpret_cast< const sockaddr * >( &*address ), sizeof( *address ) ) != 0 )
+        return LastError();
+
+    // The broker answers once its tick accepts the connection.
+    pollfd readable{ .fd = broker.Get(), .events = POLLIN, .revents = 0 };
+    const int ready = ::poll( &readable, 1, static_cast< int >( timeout.count() ) );
+    if ( ready < 0 )
+        return LastError();
+    if ( ready == 0 )
+        return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+
+    uint32_t magic = 0;
+    alignas( cmsghdr ) std::array< std::byte, CMSG_SPACE( sizeof( int ) * 3 ) > control{};
+    iovec part{ &magic, sizeof( magic ) };
+    msghdr message{};
+    message.msg_iov        = &part;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.data();
+    message.msg_controllen = control.size();
+    const auto received    = ::recvmsg( broker.Get(), &message, MSG_CMSG_CLOEXEC | MSG_DONTWAIT );
+    if ( received < 0 )
+        return LastError();
+
+    // Owned right away, so they are closed again whatever goes wrong below.
+    std::vector< UniqueFd > descriptors;
+    for ( cmsghdr * header = CMSG_FIRSTHDR( &message ); header != nullptr; header = CMSG_NXTHDR( &message, header ) )
+    {
+        if ( header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS )
+            continue;
+        const std::size_t count = ( header->cmsg_len - CMSG_LEN( 0 ) ) / sizeof( int );
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            int fd = -1;
+            std::memcpy( &fd, CMSG_DATA( header ) + i * sizeof( int ), sizeof( int ) );
+            descriptors.emplace_back( fd );
+        }
+    }
+    if ( received == 0 )
+        return std::unexpected( std::make_error_code( std::errc::connection_refused ) );
+    if ( received != sizeof( magic ) || magic != G_OFFER_MAGIC || descriptors.size() != 3 || ( message.msg_flags & MSG_CTRUNC ) != 0 )
+        return std::unexpected( std::make_error_code( std::errc::protocol_error ) );
+
+    const ShmChannel channel{ .m_memory = std::move( descriptors[ 0 ] ), .m_wake = { std::move( descriptors[ 1 ] ), std::move( descriptors[ 2 ] ) } };
+    return Attach( channel, ShmSide::Peer, settings );
+#endif
+}
+
+shm::Result< shm::net::ShmListener > shm::net::ShmListener::Listen( const std::filesystem::path & path, ShmSettings settings )
+{
+#ifndef __linux__
+    (void)path;
+    (void)settings;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    auto address = ToSockaddr( path );
+    if ( !address.has_value() )
+        return std::unexpected( address.error() );
+
+    ShmListener listener;
+    listener.m_settings = settings;
+    listener.m_listener.Reset( ::socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 ) );
+    if ( !listener.m_listener )
+        return LastError();
+
+    std::error_code ec;
+    std::filesystem::remove( path, ec );
+    if ( ::bind( listener.m_listener.Get(), reinterpret_cast< const sockaddr * >( &*address ), sizeof( *address ) ) != 0 )
+        return LastError();
+    listener.m_path = path;
+    // Connections of other users are refused in Accept anyway, this keeps them from connecting at all once set.
+    if ( ::chmod( path.c_str(), S_IRUSR | S_IWUSR ) != 0 || ::listen( listener.m_listener.Get(), static_cast< int >( G_ACCEPTS_PER_CALL ) ) != 0 )
+        return LastError();
+    return listener;
+#endif
+}
+
+shm::net::ShmListener::~ShmListener()
+{
+    if ( m_path.empty() )
+        return;
+
+    std::error_code ec;
+    std::filesystem::remove( m_path, ec );
+}
+
+shm::net::ShmListener::ShmListener( ShmListener && other ) noexcept
+    : m_path( std::exchange( other.m_path, {} ) )
+    , m_settings( other.m_settings )
+    , m_listener( std::move( other.m_listener ) )
+{
+}
+
+shm::net::ShmListener & shm::net::ShmListener::operator=( ShmListener && other ) noexcept
+{
+    if ( this != &other )
+    {
+        std::swap( m_path, other.m_path );
+        std::swap( m_settings, other.m_settings );
+        std::swap( m_listener, other.m_listener );
+    }
+    return *this;
+}
+
+std::vector< shm::net::ShmAccepted > shm::net::ShmListener::Accept()
+{
+    std::vector< ShmAccepted > accepted;
+#ifdef __linux__
+    if ( !m_listener )
+        return accepted;
+
+    for ( std::size_t i = 0; i < G_ACCEPTS_PER_CALL; ++i )
+    {
+        UniqueFd connection( ::accept4( m_listener.Get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC ) );
+        if ( !connection )
+            break;
+
+        ucred credentials{};
+        socklen_t size = sizeof( credentials );
+        if ( ::getsockopt( connection.Get(), SOL_SOCKET, SO_PEERCRED, &credentials, &size ) != 0 || credentials.uid != ::geteuid() )
+            continue;
+
+        auto channel = ShmTransport::CreateChannel( m_settings.m_ring_capacity );
+        if ( !channel.has_value() )
+            continue;
+        auto transport = ShmTransport::Attach( *channel, ShmSide::Broker, m_settings );
+        if ( !transport.has_value() || !SendChannel( connection.Get(), *channel ) )
+            continue;
+        accepted.push_back( { .m_transport = std::move( *transport ), .m_pid = credentials.pid } );
+    }
+#endif
+    return accepted;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "net/Transport.hpp"
+#include "net/UniqueFd.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace shm::net
+{
+    /// @brief Positions of one ring inside the shared memory, defined in ShmTransport.cpp.
+    struct ShmRingState;
+
+    struct ShmSettings
+    {
+        /// @brief Bytes per direction, rounded up to a power of two of at least MaxFrameSize.
+        std::size_t m_ring_capacity = std::size_t{ 1 } << 20;
+        /// @brief How long a receive spins on the ring before it sleeps on the eventfd. Spinning keeps the round trip
+        /// below a microsecond while traffic flows, sleeping keeps an idle peer off the CPU. Ignored on single core machines.
+        std::chrono::nanoseconds m_busy_poll = std::chrono::microseconds( 50 );
+    };
+
+    /// @brief File descriptors making up a shared memory link: the memfd holding both rings and one eventfd per ring
+    /// to wake its reader. They can be handed to another process (fork, SCM_RIGHTS) which attaches the other side.
+    struct ShmChannel
+    {
+        UniqueFd m_memory;
+        std::array< UniqueFd, 2 > m_wake;
+    };
+
+    enum class ShmSide : uint8_t
+    {
+        /// @brief Writes ring 0 and reads ring 1.
+        Broker,
+        /// @brief Writes ring 1 and reads ring 0.
+        Peer,
+    };
+
+    /// @brief Frames through a pair of single producer single consumer rings in shared memory, one per direction.
+    /// A frame costs two memcpy and, only while the reader sleeps, one eventfd write instead of two system calls and
+    /// a trip through the network stack. Linux only.
+    class ShmTransport final : public ITransport
+    {
+    public:
+        /// @brief Creates the memfd and the eventfds and initializes both rings.
+        static shm::Result< ShmChannel > CreateChannel( std::size_t ring_capacity = ShmSettings{}.m_ring_capacity );
+
+        /// @brief Maps the channel as one of its sides. The descriptors are duplicated, the channel stays usable.
+        static shm::Result< std::unique_ptr< ShmTransport > > Attach( const ShmChannel & channel, ShmSide side, ShmSettings settings = {} );
+
+        /// @brief The service's end of a link: asks the broker listening on the path (see ShmListener) for a channel and
+        /// attaches its peer side.
+        static shm::Result< std::unique_ptr< ShmTransport > > Connect( const std::filesystem::path & path, std::chrono::milliseconds timeout,
+                                                                       ShmSettings settings = {} );
+
+        /// @brief Marks this side as gone, the peer's pending and later calls report connection_reset.
+        ~ShmTransport() override;
+
+        ShmTransport( const ShmTransport & )             = delete;
+        ShmTransport & operator=( const ShmTransport & ) = delete;
+
+        /// @return resource_unavailable_try_again while the ring lacks room for the whole frame.
+        shm::Result< void > SendGathered( const protocol::FrameHeader & header, std::span< const std::byte > payload ) override;
+        shm::Result< std::span< const std::byte > > ReceiveFrame( std::span< std::byte > buffer, std::chrono::nanoseconds timeout ) override;
+
+    private:
+        ShmTransport( UniqueFd memory, UniqueFd tx_wake, UniqueFd rx_wake, std::byte * mapping, std::size_t capacity, ShmSide side,
+                      ShmSettings settings );
+
+        /// @brief Copies the next frame out of the receive ring.
+        /// @return An empty span if the ring is empty.
+        shm::Result< std::span< const std::byte > > TryReceive( std::span< std::byte > buffer );
+
+        UniqueFd m_memory;
+        UniqueFd m_tx_wake;
+        UniqueFd m_rx_wake;
+        std::byte * m_mapping = nullptr;
+        std::size_t m_capacity;
+        ShmSettings m_settings;
+        ShmRingState * m_tx;
+        ShmRingState * m_rx;
+        std::byte * m_tx_data;
+        std::byte * m_rx_data;
+    };
+
+    /// @brief A service that connected through a ShmListener.
+    struct ShmAccepted
+    {
+        /// @brief The broker's side of the link, for Gateway::Attach.
+        std::unique_ptr< ShmTransport > m_transport;
+        /// @brief Process id of the service, e.g. for its remote address.
+        int32_t m_pid = 0;
+    };
+
+    /// @brief Where co-located services ask the broker for a shared memory link, a Unix socket of mode 0600 that
+    /// only accepts processes of the broker's own user. Every service that connects gets a channel of its own over
+    /// SCM_RIGHTS and hangs up, the link itself needs no socket. Linux only.
+    class ShmListener
+    {
+    public:
+        /// @brief Listens on the given path, replacing a socket file left behind by a process that died.
+        static shm::Result< ShmListener > Listen( const std::filesystem::path & path, ShmSettings settings = {} );
+
+        ShmListener() = default;
+        /// @brief Removes the socket file.
+        ~ShmListener();
+
+        ShmListener( const ShmListener & )             = delete;
+        ShmListener & operator=( const ShmListener & ) = delete;
+        ShmListener( ShmListener && other ) noexcept;
+        ShmListener & operator=( ShmListener && other ) noexcept;
+
+        /// @brief Accepts the services waiting to connect and sends each its channel, without blocking. Services
+        /// of another user and those that do not take their channel right away are dropped.
+        [[nodiscard]] std::vector< ShmAccepted > Accept();
+
+    private:
+        std::filesystem::path m_path;
+        ShmSettings m_settings;
+        UniqueFd m_listener;
+    };
+} // namespace shm::net
@@ -0,0 +1,216 @@
+#include "SocketTransport.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+namespace
+{
+    /// @brief Read ahead, enough for a maximum frame plus whatever small frames follow it.
+    constexpr std::size_t G_RECEIVE_BUFFER_SIZE = 2 * shm::net::MaxFrameSize;
+
+#ifndef _WIN32
+    std::unexpected< std::error_code > LastError()
+    {
+        return std::unexpected( std::error_code( errno, std::generic_category() ) );
+    }
+#endif
+} // namespace
+
+shm::net::SocketTransport::SocketTransport( UniqueFd socket )
+    : m_socket( std::move( socket ) )
+    , m_received( G_RECEIVE_BUFFER_SIZE )
+{
+#ifndef _WIN32
+    // Reads poll first anyway, sends must never wait for the peer.
+    if ( const int flags = ::fcntl( m_socket.Get(), F_GETFL ); flags >= 0 )
+        ::fcntl( m_socket.Get(), F_SETFL, flags | O_NONBLOCK );
+#endif
+}
+
+shm::Result< shm::net::SocketTransport::Pair > shm::net::SocketTransport::CreatePair( SocketKind kind )
+{
+#ifdef _WIN32
+    (void)kind;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    if ( kind == SocketKind::Unix )
+    {
+        int fds[ 2 ];
+        if ( ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds ) != 0 )
+            return LastError();
+        return Pair{ std::make_unique< SocketTransport >( UniqueFd( fds[ 0 ] ) ), std::make_unique< SocketTransport >( UniqueFd( fds[ 1 ] ) ) };
+    }
+
+    UniqueFd listener( ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+    if ( !listener )
+        return LastError();
+
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    socklen_t address_size  = sizeof( address );
+    if ( ::bind( listener.Get(), reinterpret_cast< sockaddr * >( &address ), sizeof( address ) ) != 0 || ::listen( listener.Get(), 1 ) != 0
+         || ::getsockname( listener.Get(), reinterpret_cast< sockaddr * >( &address ), &address_size ) != 0 )
+        return LastError();
+
+    UniqueFd client( ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+    if ( !client || ::connect( client.Get(), reinterpret_cast< sockaddr * >( &address ), sizeof( address ) ) != 0 )
+        return LastError();
+    UniqueFd server( ::accept4( listener.Get(), nullptr, nullptr, SOCK_CLOEXEC ) );
+    if ( !server )
+        return LastError();
+
+    const int enabled = 1;
+    for ( const int fd : { client.Get(), server.Get() } )
+        ::setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof( enabled ) );
+    return Pair{ std::make_unique< SocketTransport >( std::move( server ) ), std::make_unique< SocketTransport >( std::move( client ) ) };
+#endif
+}
+
+shm::Result< void > shm::net::SocketTransport::SendGathered( const protocol::FrameHeader & header, std::span< const std::byte > payload )
+{
+    if ( header.m_length != payload.size() )
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+
+#ifdef _WIN32
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    // A stream must never carry half of a frame followed by the next one.
+    if ( auto flushed = FlushPending(); !flushed.has_value() )
+        return flushed;
+
+    // Header and payload go out in one sendmsg.
+    std::array< iovec, 2 > parts{ iovec{ const_cast< protocol::FrameHeader * >( &header ), sizeof( header ) },
+                                  iovec{ const_cast< std::byte * >( payload.data() ), payload.size() } };
+    msghdr message{};
+    message.msg_iov    = parts.data();
+    message.msg_iovlen = parts.size();
+    ssize_t result     = 0;
+    do
+        result = ::sendmsg( m_socket.Get(), &message, MSG_NOSIGNAL | MSG_DONTWAIT );
+    while ( result < 0 && errno == EINTR );
+    if ( result < 0 )
+    {
+        if ( errno == EAGAIN || errno == EWOULDBLOCK )
+            return std::unexpected( std::make_error_code( std::errc::resource_unavailable_try_again ) );
+        if ( errno == EPIPE || errno == ECONNRESET )
+            return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+        return LastError();
+    }
+
+    // Part of the frame is out, so the frame counts as sent and the rest waits for FlushPending.
+    auto sent = static_cast< std::size_t >( result );
+    for ( const auto & part : parts )
+    {
+        const auto skipped = std::min( sent, part.iov_len );
+        sent -= skipped;
+        const auto * begin = static_cast< const std::byte * >( part.iov_base ) + skipped;
+        m_pending.insert( m_pending.end(), begin, begin + ( part.iov_len - skipped ) );
+    }
+    return {};
+#endif
+}
+
+shm::Result< void > shm::net::SocketTransport::FlushPending()
+{
+#ifdef _WIN32
+    return {};
+#else
+    while ( m_pending_begin != m_pending.size() )
+    {
+        const auto result = ::send( m_socket.Get(), m_pending.data() + m_pending_begin, m_pending.size() - m_pending_begin, MSG_NOSIGNAL | MSG_DONTWAIT );
+        if ( result < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                return std::unexpected( std::make_error_code( std::errc::resource_unavailable_try_again ) );
+            if ( errno == EPIPE || errno == ECONNRESET )
+                return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+            return LastError();
+        }
+        m_pending_begin += static_cast< std::size_t >( result );
+    }
+    m_pending.clear();
+    m_pending_begin = 0;
+    return {};
+#endif
+}
+
+shm::Result< std::span< const std::byte > > shm::net::SocketTransport::ReceiveFrame( std::span< std::byte > buffer, std::chrono::nanoseconds timeout )
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for ( bool polled = false;; polled = true )
+    {
+        const auto buffered = m_received_end - m_received_begin;
+        if ( buffered >= sizeof( protocol::FrameHeader ) )
+        {
+            protocol::FrameHeader header;
+            std::memcpy( &header, m_received.data() + m_received_begin, sizeof( header ) );
+            const auto size = FrameSizeOf( header );
+            if ( size > buffer.size() )
+                return std::unexpected( std::make_error_code( std::errc::message_size ) );
+            if ( buffered >= size )
+            {
+                std::memcpy( buffer.data(), m_received.data() + m_received_begin, size );
+                m_received_begin += size;
+                return buffer.first( size );
+            }
+        }
+
+        // Only a zero timeout is a pure poll, anything else waits at least once.
+        if ( polled && std::chrono::steady_clock::now() >= deadline )
+            return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+        if ( auto filled = Fill( deadline, timeout <= std::chrono::nanoseconds::zero() ); !filled.has_value() )
+            return std::unexpected( filled.error() );
+    }
+}
+
+shm::Result< void > shm::net::SocketTransport::Fill( std::chrono::steady_clock::time_point deadline, bool poll_only )
+{
+#ifdef _WIN32
+    (void)deadline;
+    (void)poll_only;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    // Keep the unread tail at the front so a whole frame always fits behind it.
+    if ( m_received_begin != 0 )
+    {
+        std::memmove( m_received.data(), m_received.data() + m_received_begin, m_received_end - m_received_begin );
+        m_received_end -= m_received_begin;
+        m_received_begin = 0;
+    }
+
+    pollfd readable{ .fd = m_socket.Get(), .events = POLLIN, .revents = 0 };
+    int wait_ms = 0;
+    if ( !poll_only )
+    {
+        const auto remaining = std::chrono::ceil< std::chrono::milliseconds >( deadline - std::chrono::steady_clock::now() );
+        wait_ms              = static_cast< int >( std::max< int64_t >( remaining.count(), 0 ) );
+    }
+    const int ready = ::poll( &readable, 1, wait_ms );
+    if ( ready < 0 )
+        return errno == EINTR ? shm::Result< void >{} : LastError();
+    if ( ready == 0 )
+        return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+
+    const auto result = ::recv( m_socket.Get(), m_received.data() + m_received_end, m_received.size() - m_received_end, 0 );
+    if ( result == 0 )
+        return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+    if ( result < 0 )
+        return errno == EINTR || errno == EAGAIN ? shm::Result< void >{} : LastError();
+    m_received_end += static_cast< std::size_t >( result );
+    return {};
+#endif
+}
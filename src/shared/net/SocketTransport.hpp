@@ -0,0 +1,50 @@
+#pragma once
+
+#include "net/Transport.hpp"
+#include "net/UniqueFd.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace shm::net
+{
+    enum class SocketKind : uint8_t
+    {
+        /// @brief TCP over the loopback interface, with Nagle disabled.
+        TcpLoopback,
+        /// @brief Unix domain stream socket.
+        Unix,
+    };
+
+    /// @brief Frames over a connected stream socket, which is made non-blocking. Reads go through a buffer, so small
+    /// frames arriving back to back cost one recv for many of them rather than two each. A frame the socket only takes
+    /// in part is finished from a buffer of its own before the next one, a peer that does not read never blocks the sender.
+    class SocketTransport final : public ITransport
+    {
+    public:
+        using Pair = std::pair< std::unique_ptr< SocketTransport >, std::unique_ptr< SocketTransport > >;
+
+        /// @brief Takes over a connected stream socket.
+        explicit SocketTransport( UniqueFd socket );
+
+        /// @brief Two connected ends, for peers in the same process and for measuring against the shared memory transport.
+        static shm::Result< Pair > CreatePair( SocketKind kind );
+
+        shm::Result< void > SendGathered( const protocol::FrameHeader & header, std::span< const std::byte > payload ) override;
+        shm::Result< void > FlushPending() override;
+        shm::Result< std::span< const std::byte > > ReceiveFrame( std::span< std::byte > buffer, std::chrono::nanoseconds timeout ) override;
+
+    private:
+        /// @brief Waits for the socket to turn readable and appends what arrived to the receive buffer.
+        shm::Result< void > Fill( std::chrono::steady_clock::time_point deadline, bool poll_only );
+
+        UniqueFd m_socket;
+        std::vector< std::byte > m_received;
+        std::size_t m_received_begin = 0;
+        std::size_t m_received_end   = 0;
+        /// @brief The unsent tail of the last frame, at most one frame.
+        std::vector< std::byte > m_pending;
+        std::size_t m_pending_begin = 0;
+    };
+} // namespace shm::net
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "protocol/FrameHeader.hpp"
+#include "results/Result.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace shm::net
+{
+    /// @brief Largest frame a transport carries: a header and the longest payload its 16 bit length can describe.
+    /// A receive buffer of this size always fits the next frame.
+    constexpr std::size_t MaxFrameSize = sizeof( protocol::FrameHeader ) + UINT16_MAX;
+
+    /// @brief Total size of the frame starting with the given header.
+    [[nodiscard]] inline std::size_t FrameSizeOf( const protocol::FrameHeader & header ) noexcept
+    {
+        return sizeof( protocol::FrameHeader ) + header.m_length;
+    }
+
+    /// @brief Bidirectional pipe of frames to a single peer. A frame is a protocol::FrameHeader followed by its payload,
+    /// the bytes wire::EncodeFrame produces and wire::Dispatcher::DispatchFrame consumes, so code routing frames does not
+    /// care whether the peer sits behind a socket or a shared memory ring. Each direction is used by one thread at a time.
+    class ITransport
+    {
+    public:
+        virtual ~ITransport() = default;
+
+        /// @brief Sends one whole frame.
+        /// @return invalid_argument if the bytes are not a frame, otherwise see SendGathered.
+        shm::Result< void > SendFrame( std::span< const std::byte > frame )
+        {
+            protocol::FrameHeader header;
+            if ( frame.size() < sizeof( header ) )
+                return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+            std::memcpy( &header, frame.data(), sizeof( header ) );
+            if ( FrameSizeOf( header ) != frame.size() )
+                return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+            return SendGathered( header, frame.subspan( sizeof( header ) ) );
+        }
+
+        /// @brief Sends one frame whose header and payload live apart. The transport gathers them on the way out, so a
+        /// payload shared by many recipients is never joined with a header per recipient.
+        /// @return invalid_argument if header.m_length does not match the payload, resource_unavailable_try_again if
+        /// the peer does not keep up and nothing was sent, connection_reset once the peer is gone.
+        virtual shm::Result< void > SendGathered( const protocol::FrameHeader & header, std::span< const std::byte > payload ) = 0;
+
+        /// @brief Sends what is left of a frame SendGathered accepted but the peer only took in part. Later frames
+        /// wait behind it anyway, this is for when no later frame comes.
+        /// @return resource_unavailable_try_again while bytes are left, connection_reset once the peer is gone.
+        virtual shm::Result< void > FlushPending()
+        {
+            return {};
+        }
+
+        /// @brief Waits up to timeout for the next frame and copies it into buffer, a zero timeout only polls.
+        /// @return The frame within buffer. timed_out if none arrived, message_size if it does not fit buffer (the frame
+        /// stays queued), connection_reset once the peer is gone.
+        virtual shm::Result< std::span< const std::byte > > ReceiveFrame( std::span< std::byte > buffer, std::chrono::nanoseconds timeout ) = 0;
+    };
+} // namespace shm::net
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "net/ReliableChannel.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+
+namespace shm::net
+{
+    enum class HandshakeType : uint8_t
+    {
+        /// @brief Client to server, asks for a connection.
+        Connect = 1,
+        /// @brief Server to client, a cookie the client has to echo. The server keeps no state until it comes back.
+        Challenge,
+        /// @brief Client to server, echoes the cookie.
+        Response,
+        /// @brief Server to client, names the connection.
+        Accept,
+    };
+
+    /// @brief Payload of a handshake datagram, which is one whose ReliableHeader has no connection.
+    /// A peer only becomes a connection once it echoed a cookie sent to its address, so datagrams with a forged
+    /// sender address do not create sessions. All four datagrams have the same size, a forged Connect makes the
+    /// server send no more than it received.
+    struct UdpHandshake
+    {
+        HandshakeType m_type = HandshakeType::Connect;
+        std::array< uint8_t, 3 > m_reserved{};
+        /// @brief Picked by the client for every attempt to connect, echoed by the server. A client that restarted on the
+        /// same address and port picks a new one, the server replaces the old connection instead of answering for it.
+        uint32_t m_nonce = 0;
+        /// @brief Challenge and Response only.
+        uint32_t m_cookie = 0;
+        /// @brief Accept only, never 0. Every later datagram of both sides carries it in its ReliableHeader.
+        uint32_t m_connection = 0;
+    };
+    static_assert( sizeof( UdpHandshake ) == 16 );
+
+    constexpr std::size_t HandshakeDatagramSize = sizeof( ReliableHeader ) + sizeof( UdpHandshake );
+    using HandshakeDatagram                     = std::array< std::byte, HandshakeDatagramSize >;
+
+    [[nodiscard]] inline HandshakeDatagram EncodeHandshake( const UdpHandshake & handshake ) noexcept
+    {
+        HandshakeDatagram datagram{};
+        const ReliableHeader header{};
+        std::memcpy( datagram.data(), &header, sizeof( header ) );
+        std::memcpy( datagram.data() + sizeof( header ), &handshake, sizeof( handshake ) );
+        return datagram;
+    }
+
+    /// @return Nothing if the datagram is not a handshake datagram.
+    [[nodiscard]] inline std::optional< UdpHandshake > DecodeHandshake( std::span< const std::byte > datagram ) noexcept
+    {
+        ReliableHeader header;
+        UdpHandshake handshake;
+        if ( datagram.size() != HandshakeDatagramSize )
+            return std::nullopt;
+        std::memcpy( &header, datagram.data(), sizeof( header ) );
+        std::memcpy( &handshake, datagram.data() + sizeof( header ), sizeof( handshake ) );
+        if ( header.m_connection != 0 || handshake.m_type < HandshakeType::Connect || handshake.m_type > HandshakeType::Accept )
+            return std::nullopt;
+        return handshake;
+    }
+
+    /// @brief The client's end of the handshake with a UdpServer. The client sends Request() until Accepted(), again
+    /// whenever no answer arrived in time and right away once Receive took a challenge.
+    class UdpConnector
+    {
+    public:
+        /// @param nonce Should differ from the nonces of earlier connections from the same address, e.g. random.
+        explicit UdpConnector( uint32_t nonce ) noexcept
+            : m_request{ .m_type = HandshakeType::Connect, .m_nonce = nonce }
+        {
+        }
+
+        /// @brief Connect until the server challenged the client, then the Response to its cookie.
+        [[nodiscard]] HandshakeDatagram Request() const noexcept
+        {
+            return EncodeHandshake( m_request );
+        }
+
+        /// @return True if the datagram was the server's answer to this attempt.
+        bool Receive( std::span< const std::byte > datagram ) noexcept
+        {
+            const auto answer = DecodeHandshake( datagram );
+            if ( !answer || answer->m_nonce != m_request.m_nonce || Accepted() )
+                return false;
+            if ( answer->m_type == HandshakeType::Challenge )
+            {
+                m_request.m_type   = HandshakeType::Response;
+                m_request.m_cookie = answer->m_cookie;
+                return true;
+            }
+            if ( answer->m_type != HandshakeType::Accept || answer->m_connection == 0 || m_request.m_type != HandshakeType::Response )
+                return false;
+            m_connection = answer->m_connection;
+            return true;
+        }
+
+        [[nodiscard]] bool Accepted() const noexcept
+        {
+            return m_connection != 0;
+        }
+
+        /// @brief 0 until accepted.
+        [[nodiscard]] uint32_t Connection() const noexcept
+        {
+            return m_connection;
+        }
+
+    private:
+        UdpHandshake m_request;
+        uint32_t m_connection = 0;
+    };
+} // namespace shm::net
@@ -0,0 +1,437 @@
+#include "UdpServer.hpp"
+
+#include "hash/SipHash.hpp"
+#include "net/Gateway.hpp"
+#include "net/Transport.hpp"
+#include "net/UdpHandshake.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <utility>
+
+/// @brief State of one remote address, shared between the server routing its datagrams and the transport the
+/// gateway owns. Only touched by the tick thread.
+struct shm::net::UdpPeer
+{
+    explicit UdpPeer( UdpAddress address, ReliableSettings settings, uint32_t connection, uint32_t nonce, uint64_t tick )
+        : m_address( address )
+        , m_nonce( nonce )
+        , m_channel( settings, connection )
+        , m_last_heard_tick( tick )
+    {
+    }
+
+    UdpAddress m_address;
+    /// @brief Of the handshake that created the peer, see UdpHandshake::m_nonce.
+    uint32_t m_nonce = 0;
+    /// @brief The gateway connection of the peer, its session.
+    ConnectionHandle m_connection;
+    ReliableChannel m_channel;
+    /// @brief Last tick a datagram of the peer's connection arrived.
+    uint64_t m_last_heard_tick = 0;
+    /// @brief See UdpServer::Refuse, applies once the peer is gone.
+    uint64_t m_refused_until_tick = 0;
+    /// @brief Frames delivered in order but not read by the gateway yet, back to back from m_received_begin.
+    std::vector< std::byte > m_received;
+    std::size_t m_received_begin = 0;
+    /// @brief Set by the server, the transport reports connection_reset from then on.
+    bool m_timed_out = false;
+    /// @brief Set once the gateway dropped the transport, the server forgets the peer once its last frames were acknowledged.
+    bool m_detached = false;
+};
+
+namespace
+{
+    /// @brief Ticks a handshake cookie is valid for, at least five seconds and at most ten.
+    constexpr uint64_t G_COOKIE_TICKS = 120 * 5;
+
+    /// @brief The gateway's end of a UdpPeer. Never waits, the server fills it once per tick.
+    class UdpPeerTransport final : public shm::net::ITransport
+    {
+    public:
+        explicit UdpPeerTransport( std::shared_ptr< shm::net::UdpPeer > peer )
+            : m_peer( std::move( peer ) )
+        {
+        }
+
+        ~UdpPeerTransport() override
+        {
+            m_peer->m_detached = true;
+        }
+
+        shm::Result< void > SendGathered( const shm::protocol::FrameHeader & header, std::span< const std::byte > payload ) override
+        {
+            if ( header.m_length != payload.size() || shm::net::FrameSizeOf( header ) > shm::net::MaxReliablePayload )
+                return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+            if ( m_peer->m_timed_out )
+                return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+            if ( !m_peer->m_channel.Queue( std::as_bytes( std::span( &header, 1 ) ), payload ) )
+                return std::unexpected( std::make_error_code( std::errc::resource_unavailable_try_again ) );
+            return {};
+        }
+
+        shm::Result< std::span< const std::byte > > ReceiveFrame( std::span< std::byte > buffer, std::chrono::nanoseconds ) override
+        {
+            auto & received = m_peer->m_received;
+            if ( m_peer->m_received_begin == received.size() )
+            {
+                received.clear();
+                m_peer->m_received_begin = 0;
+                if ( m_peer->m_timed_out )
+                    return std::unexpected( std::make_error_code( std::errc::connection_reset ) );
+                return std::unexpected( std::make_error_code( std::errc::timed_out ) );
+            }
+
+            shm::protocol::FrameHeader header;
+            std::memcpy( &header, received.data() + m_peer->m_received_begin, sizeof( header ) );
+            const auto size = shm::net::FrameSizeOf( header );
+            if ( size > buffer.size() )
+                return std::unexpected( std::make_error_code( std::errc::message_size ) );
+            std::memcpy( buffer.data(), received.data() + m_peer->m_received_begin, size );
+            m_peer->m_received_begin += size;
+            return buffer.first( size );
+        }
+
+    private:
+        std::shared_ptr< shm::net::UdpPeer > m_peer;
+    };
+
+    /// @brief A frame as the reliable channel delivers it. Datagrams are not checksummed by the broker, so only frames
+    /// whose header matches their size are handed on, the dispatcher checks the rest.
+    bool IsWholeFrame( std::span< const std::byte > message )
+    {
+        shm::protocol::FrameHeader header;
+        if ( message.size() < sizeof( header ) )
+            return false;
+        std::memcpy( &header, message.data(), sizeof( header ) );
+        return shm::net::FrameSizeOf( header ) == message.size();
+    }
+} // namespace
+
+shm::Result< std::unique_ptr< shm::net::UdpServer > > shm::net::UdpServer::Create( Gateway & gateway, UdpSettings settings )
+{
+    std::vector< UdpSocket > sockets;
+    const auto socket_count = std::max< std::size_t >( settings.m_io_threads, 1 );
+    auto address            = settings.m_address;
+    for ( std::size_t i = 0; i < socket_count; ++i )
+    {
+        auto socket = UdpSocket::Bind( address, socket_count > 1 );
+        if ( !socket.has_value() )
+            return std::unexpected( socket.error() );
+        // Port 0 picks a free port for the first socket, the others have to join that one.
+        address.m_port = socket->LocalAddress().m_port;
+        sockets.push_back( std::move( *socket ) );
+    }
+    return std::unique_ptr< UdpServer >( new UdpServer( gateway, settings, std::move( sockets ) ) );
+}
+
+shm::Result< shm::net::UdpAdoption > shm::net::UdpServer::Adopt( Gateway & gateway, UdpSettings settings, std::vector< UniqueFd > sockets,
+                                                                 std::span< const UdpPeerState > peers, uint64_t tick )
+{
+    if ( sockets.empty() )
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+
+    std::vector< UdpSocket > adopted;
+    for ( auto & socket : sockets )
+    {
+        auto udp = UdpSocket::Adopt( std::move( socket ) );
+        if ( !udp.has_value() )
+            return std::unexpected( udp.error() );
+        adopted.push_back( std::move( *udp ) );
+    }
+    // Sockets sharing a port through SO_REUSEPORT each receive their own peers, every one of them needs a reader.
+    settings.m_address    = adopted.front().LocalAddress();
+    settings.m_io_threads = adopted.size() > 1 ? static_cast< uint32_t >( adopted.size() ) : std::min( settings.m_io_threads, 1u );
+
+    UdpAdoption adoption{ .m_server = std::unique_ptr< UdpServer >( new UdpServer( gateway, settings, std::move( adopted ) ) ) };
+    for ( const auto & state : peers )
+    {
+        const UdpAddress address{ state.ip, state.port };
+        auto peer = std::make_shared< UdpPeer >( address, settings.m_reliability, state.channel.connection, state.nonce, state.last_heard_tick );
+        peer->m_channel.Restore( state.channel );
+        peer->m_received.resize( state.received.size() );
+        std::memcpy( peer->m_received.data(), state.received.data(), state.received.size() );
+
+        peer->m_connection = gateway.Resume( address.ToString(), tick, std::make_unique< UdpPeerTransport >( peer ) );
+        if ( !peer->m_connection )
+            continue;
+        adoption.m_sessions.push_back( { state.session, peer->m_connection.Pack() } );
+        adoption.m_server->m_peer_keys.emplace( peer->m_connection.Pack(), address.Key() );
+        adoption.m_server->m_peers.emplace( address.Key(), std::move( peer ) );
+    }
+    return adoption;
+}
+
+shm::net::UdpServer::UdpServer( Gateway & gateway, UdpSettings settings, std::vector< UdpSocket > sockets )
+    : m_gateway( gateway )
+    , m_settings( settings )
+    , m_port( sockets.front().LocalAddress().m_port )
+    , m_sockets( std::move( sockets ) )
+{
+    std::random_device random;
+    for ( auto & word : m_secret )
+        word = ( static_cast< uint64_t >( random() ) << 32 ) | random();
+    for ( uint32_t i = 0; i < m_settings.m_io_threads; ++i )
+        m_io_queues.push_back( std::make_unique< IoQueue >() );
+    StartIoThreads();
+}
+
+shm::net::UdpServer::~UdpServer()
+{
+    m_io_threads.clear();
+    for ( const auto & queue : m_io_queues )
+    {
+        for ( const auto & datagram : queue->m_datagrams )
+            m_buffers.Destroy( datagram.m_buffer );
+    }
+}
+
+void shm::net::UdpServer::StopReceiving( uint64_t tick )
+{
+    m_io_threads.clear();
+    m_receiving = false;
+    Receive( tick );
+}
+
+void shm::net::UdpServer::ResumeReceiving()
+{
+    if ( !std::exchange( m_receiving, true ) )
+        StartIoThreads();
+}
+
+std::vector< int > shm::net::UdpServer::NativeHandles() const
+{
+    std::vector< int > handles;
+    for ( const auto & socket : m_sockets )
+        handles.push_back( socket.NativeHandle() );
+    return handles;
+}
+
+std::vector< shm::net::UdpPeerState > shm::net::UdpServer::CapturePeers() const
+{
+    std::vector< UdpPeerState > peers;
+    for ( const auto & [ key, peer ] : m_peers )
+    {
+        if ( peer->m_detached || peer->m_timed_out )
+            continue;
+
+        UdpPeerState state{ .session         = peer->m_connection.Pack(),
+                            .ip              = peer->m_address.m_ip,
+                            .port            = peer->m_address.m_port,
+                            .nonce           = peer->m_nonce,
+                            .last_heard_tick = peer->m_last_heard_tick,
+                            .channel         = peer->m_channel.Capture() };
+        const auto unread = std::span( peer->m_received ).subspan( peer->m_received_begin );
+        state.received.resize( unread.size() );
+        std::memcpy( state.received.data(), unread.data(), unread.size() );
+        peers.push_back( std::move( state ) );
+    }
+    return peers;
+}
+
+void shm::net::UdpServer::StartIoThreads()
+{
+    for ( uint32_t i = 0; i < m_settings.m_io_threads; ++i )
+        m_io_threads.emplace_back( [ this, i ]( std::stop_token stop ) { RunIoThread( stop, i ); } );
+}
+
+void shm::net::UdpServer::RunIoThread( std::stop_token stop, std::size_t index )
+{
+    auto & socket = m_sockets[ index ];
+    auto & queue  = *m_io_queues[ index ];
+    std::array< ReceivedDatagram, UdpSocket::BatchSize > batch;
+    while ( !stop.stop_requested() )
+    {
+        // Short enough for a prompt shutdown, long enough to stay off the CPU while nothing arrives.
+        const auto readable = socket.WaitReadable( std::chrono::milliseconds( 50 ) );
+        if ( !readable.has_value() || !*readable )
+            continue;
+
+        const auto received = socket.ReceiveBatch( m_buffers, batch );
+        if ( !received.has_value() || *received == 0 )
+            continue;
+
+        std::scoped_lock lock( queue.m_lock );
+        queue.m_datagrams.insert( queue.m_datagrams.end(), batch.begin(), batch.begin() + static_cast< std::ptrdiff_t >( *received ) );
+    }
+}
+
+void shm::net::UdpServer::Receive( uint64_t tick )
+{
+    m_received.clear();
+    if ( m_receiving && m_settings.m_io_threads == 0 )
+    {
+        std::array< ReceivedDatagram, UdpSocket::BatchSize > batch;
+        while ( true )
+        {
+            const auto received = m_sockets.front().ReceiveBatch( m_buffers, batch );
+            if ( !received.has_value() || *received == 0 )
+                break;
+            m_received.insert( m_received.end(), batch.begin(), batch.begin() + static_cast< std::ptrdiff_t >( *received ) );
+            if ( *received < batch.size() )
+                break;
+        }
+    }
+    for ( const auto & queue : m_io_queues )
+    {
+        std::scoped_lock lock( queue->m_lock );
+        m_received.insert( m_received.end(), queue->m_datagrams.begin(), queue->m_datagrams.end() );
+        queue->m_datagrams.clear();
+    }
+
+    for ( const auto & datagram : m_received )
+    {
+        Route( datagram, tick );
+        m_buffers.Destroy( datagram.m_buffer );
+    }
+
+    std::erase_if( m_peers,
+                   [ & ]( const auto & entry )
+                   {
+                       auto & peer = *entry.second;
+                       if ( tick > peer.m_last_heard_tick + m_settings.m_peer_timeout_ticks )
+                           peer.m_timed_out = true;
+                       if ( !peer.m_detached || ( !peer.m_timed_out && peer.m_channel.InFlight() != 0 ) )
+                           return false;
+
+                       if ( tick < peer.m_refused_until_tick )
+                           m_refused.insert_or_assign( entry.first, peer.m_refused_until_tick );
+                       m_peer_keys.erase( peer.m_connection.Pack() );
+                       return true;
+                   } );
+    std::erase_if( m_refused, [ & ]( const auto & entry ) { return tick >= entry.second; } );
+}
+
+void shm::net::UdpServer::Refuse( uint64_t session, uint64_t until_tick )
+{
+    const auto key = m_peer_keys.find( session );
+    if ( key == m_peer_keys.end() )
+        return;
+    if ( const auto peer = m_peers.find( key->second ); peer != m_peers.end() )
+        peer->second->m_refused_until_tick = until_tick;
+}
+
+void shm::net::UdpServer::Route( const ReceivedDatagram & datagram, uint64_t tick )
+{
+    const auto * buffer = m_buffers.Get( datagram.m_buffer );
+    if ( !buffer || buffer->m_size < sizeof( ReliableHeader ) )
+        return;
+    if ( const auto handshake = DecodeHandshake( buffer->Bytes() ) )
+    {
+        Handshake( datagram.m_from, *handshake, tick );
+        return;
+    }
+
+    const auto peer_it = m_peers.find( datagram.m_from.Key() );
+    if ( peer_it == m_peers.end() || peer_it->second->m_timed_out )
+        return;
+
+    // Only datagrams of the peer's connection keep it alive, those of an earlier connection or a forged one do not.
+    // A detached peer only has its acks processed, nobody reads its frames anymore.
+    auto & peer = *peer_it->second;
+    if ( peer.m_channel.Receive( buffer->Bytes(),
+                                 [ & ]( std::span< const std::byte > message )
+                                 {
+                                     if ( !peer.m_detached && IsWholeFrame( message ) )
+                                         peer.m_received.insert( peer.m_received.end(), message.begin(), message.end() );
+                                 } ) )
+        peer.m_last_heard_tick = tick;
+}
+
+void shm::net::UdpServer::Handshake( UdpAddress from, const UdpHandshake & request, uint64_t tick )
+{
+    const auto key    = from.Key();
+    const auto bucket = tick / G_COOKIE_TICKS;
+    if ( request.m_type == HandshakeType::Connect )
+    {
+        if ( !IsRefused( key, tick ) )
+            Answer( from, { .m_type = HandshakeType::Challenge, .m_nonce = request.m_nonce, .m_cookie = Cookie( from, request.m_nonce, bucket ) } );
+        return;
+    }
+    if ( request.m_type != HandshakeType::Response )
+        return;
+    // Without the cookie sent to its address the sender cannot receive there, its address is probably forged.
+    if ( request.m_cookie != Cookie( from, request.m_nonce, bucket ) && ( bucket == 0 || request.m_cookie != Cookie( from, request.m_nonce, bucket - 1 ) ) )
+        return;
+
+    auto peer_it = m_peers.find( key );
+    if ( peer_it != m_peers.end() && peer_it->second->m_nonce == request.m_nonce )
+    {
+        // The Accept got lost and the client asks again.
+        const auto & peer = *peer_it->second;
+        if ( !peer.m_detached && !peer.m_timed_out )
+            Answer( from, { .m_type = HandshakeType::Accept, .m_nonce = peer.m_nonce, .m_connection = peer.m_channel.Connection() } );
+        return;
+    }
+    if ( IsRefused( key, tick ) )
+        return;
+
+    if ( peer_it != m_peers.end() )
+    {
+        // The client started over on the same address. Its old connection is reported as gone once the gateway notices,
+        // together with whatever it still had in flight.
+        peer_it->second->m_timed_out = true;
+        m_peer_keys.erase( peer_it->second->m_connection.Pack() );
+        m_peers.erase( peer_it );
+    }
+    else if ( m_peers.size() >= m_settings.m_max_peers )
+    {
+        return;
+    }
+
+    auto peer          = std::make_shared< UdpPeer >( from, m_settings.m_reliability, NextConnection(), request.m_nonce, tick );
+    peer->m_connection = m_gateway.Attach( from.ToString(), tick, std::make_unique< UdpPeerTransport >( peer ) );
+    if ( !peer->m_connection )
+        return;
+    Answer( from, { .m_type = HandshakeType::Accept, .m_nonce = peer->m_nonce, .m_connection = peer->m_channel.Connection() } );
+    m_peer_keys.emplace( peer->m_connection.Pack(), key );
+    m_peers.emplace( key, std::move( peer ) );
+}
+
+void shm::net::UdpServer::Answer( UdpAddress to, const UdpHandshake & answer )
+{
+    const auto datagram = EncodeHandshake( answer );
+    m_sockets.front().Queue( to, datagram );
+}
+
+bool shm::net::UdpServer::IsRefused( uint64_t key, uint64_t tick ) const
+{
+    if ( const auto refused = m_refused.find( key ); refused != m_refused.end() && tick < refused->second )
+        return true;
+    const auto peer = m_peers.find( key );
+    return peer != m_peers.end() && tick < peer->second->m_refused_until_tick;
+}
+
+uint32_t shm::net::UdpServer::Cookie( UdpAddress address, uint32_t nonce, uint64_t bucket ) const
+{
+    const std::array< uint64_t, 3 > input{ address.Key(), nonce, bucket };
+    return static_cast< uint32_t >( shm::hash::SipHash24( m_secret, std::as_bytes( std::span( input ) ) ) );
+}
+
+uint32_t shm::net::UdpServer::NextConnection()
+{
+    // Unpredictable without the secret, so a forged datagram cannot guess the connection of a peer either.
+    while ( true )
+    {
+        const auto counter    = m_connections_created++;
+        const auto connection = static_cast< uint32_t >( shm::hash::SipHash24( m_secret, std::as_bytes( std::span( &counter, 1 ) ) ) >> 32 );
+        if ( connection != 0 )
+            return connection;
+    }
+}
+
+void shm::net::UdpServer::Flush( uint64_t tick )
+{
+    auto & socket = m_sockets.front();
+    for ( auto & [ key, peer ] : m_peers )
+    {
+        if ( peer->m_timed_out )
+            continue;
+        peer->m_channel.Poll( tick, [ & ]( std::span< const std::byte > datagram ) { socket.Queue( peer->m_address, datagram ); } );
+    }
+    if ( socket.QueuedDatagrams() != 0 )
+        std::ignore = socket.Flush( m_settings.m_send_mode );
+}
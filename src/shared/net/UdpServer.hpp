@@ -0,0 +1,154 @@
+#pragma once
+
+#include "hash/SipHash.hpp"
+#include "net/Inbox.hpp"
+#include "net/MessageBuffer.hpp"
+#include "net/ReliableChannel.hpp"
+#include "net/UdpSocket.hpp"
+#include "threading/SpinLock.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace shm::net
+{
+    class Gateway;
+    struct UdpAdoption;
+    struct UdpHandshake;
+    struct UdpPeer;
+
+    struct UdpSettings
+    {
+        UdpAddress m_address = UdpAddress::Loopback( 0 );
+        /// @brief Threads receiving datagrams, each on its own SO_REUSEPORT socket. 0 receives on the tick thread.
+        uint32_t m_io_threads   = 0;
+        UdpSendMode m_send_mode = UdpSendMode::Segmented;
+        /// @brief Ticks without a datagram of its connection after which a peer is reported as disconnected, ten seconds.
+        uint64_t m_peer_timeout_ticks = 120 * 10;
+        /// @brief Datagrams of unknown addresses are dropped once this many peers are known.
+        std::size_t m_max_peers = 4096;
+        ReliableSettings m_reliability;
+    };
+
+    /// @brief A peer as handed from one broker process to the next. Field names are the serialized names.
+    struct UdpPeerState
+    {
+        /// @brief Session id the peer had in the process handing it over.
+        uint64_t session         = 0;
+        uint32_t ip              = 0;
+        uint16_t port            = 0;
+        uint32_t nonce           = 0;
+        uint64_t last_heard_tick = 0;
+        ReliableState channel;
+        /// @brief Frames delivered in order but not read by the gateway yet.
+        std::vector< uint8_t > received;
+    };
+
+    /// @brief Optional UDP transport of the broker. A remote address that completed a handshake (see UdpHandshake)
+    /// becomes a gateway connection with its own ordered ReliableChannel, frames travel one per datagram. Datagrams are received in batches at the start of a
+    /// tick, either directly or from the I/O threads, and everything the tick sent leaves in one burst at its end.
+    /// A peer whose connection the gateway closed stays until the peer acknowledged its last frames or timed out, so a
+    /// message queued right before closing, like a rejection, still arrives.
+    class UdpServer
+    {
+    public:
+        static shm::Result< std::unique_ptr< UdpServer > > Create( Gateway & gateway, UdpSettings settings );
+
+        /// @brief Takes over the sockets and peers of a server in another process, see NativeHandles and CapturePeers.
+        /// The peers are resumed on the gateway without being reported as connected. The sockets decide the port
+        /// and, if there are several of them, the number of I/O threads.
+        static shm::Result< UdpAdoption > Adopt( Gateway & gateway, UdpSettings settings, std::vector< UniqueFd > sockets,
+                                                 std::span< const UdpPeerState > peers, uint64_t tick );
+
+        /// @brief Stops the I/O threads.
+        ~UdpServer();
+
+        UdpServer( const UdpServer & )             = delete;
+        UdpServer & operator=( const UdpServer & ) = delete;
+
+        /// @brief Routes the datagrams received since the last call to their peers and attaches new peers to the gateway.
+        /// Run before Gateway::PumpTransports, which moves the frames into the inbox.
+        void Receive( uint64_t tick );
+
+        /// @brief Sends what the peers queued, resends and acks in one batch. Run after Gateway::FlushTransports, which
+        /// moves the frames the tick queued into the peers.
+        void Flush( uint64_t tick );
+
+        [[nodiscard]] uint16_t Port() const noexcept
+        {
+            return m_port;
+        }
+
+        [[nodiscard]] std::size_t PeerCount() const noexcept
+        {
+            return m_peers.size();
+        }
+
+        /// @brief Keeps the peer of the session from connecting again before the given tick, e.g. after rejecting it.
+        /// Its datagrams are dropped until then instead of attaching a new connection. Does nothing for sessions that
+        /// are not UDP peers.
+        void Refuse( uint64_t session, uint64_t until_tick );
+
+        /// @brief Stops the I/O threads and routes what they already received, for the given tick. Later calls to
+        /// Receive leave the sockets alone, so their datagrams stay queued in the kernel for whoever reads them next.
+        void StopReceiving( uint64_t tick );
+        void ResumeReceiving();
+
+        /// @brief The descriptors of the sockets, to hand them to another process. They stay owned by the server.
+        [[nodiscard]] std::vector< int > NativeHandles() const;
+        /// @brief State of every live peer, for Adopt in another process. Meant for a server that stopped receiving.
+        [[nodiscard]] std::vector< UdpPeerState > CapturePeers() const;
+
+    private:
+        /// @brief Datagrams an I/O thread received, handed over to the tick thread under the lock.
+        struct IoQueue
+        {
+            SpinLock m_lock;
+            std::vector< ReceivedDatagram > m_datagrams;
+        };
+
+        UdpServer( Gateway & gateway, UdpSettings settings, std::vector< UdpSocket > sockets );
+
+        void StartIoThreads();
+        void RunIoThread( std::stop_token stop, std::size_t index );
+        void Route( const ReceivedDatagram & datagram, uint64_t tick );
+        void Handshake( UdpAddress from, const UdpHandshake & request, uint64_t tick );
+        /// @brief Queues a handshake datagram, it leaves with the next Flush.
+        void Answer( UdpAddress to, const UdpHandshake & answer );
+        [[nodiscard]] bool IsRefused( uint64_t key, uint64_t tick ) const;
+        [[nodiscard]] uint32_t Cookie( UdpAddress address, uint32_t nonce, uint64_t bucket ) const;
+        [[nodiscard]] uint32_t NextConnection();
+
+        Gateway & m_gateway;
+        UdpSettings m_settings;
+        uint16_t m_port  = 0;
+        bool m_receiving = true;
+        /// @brief Key of handshake cookies and connections, random per process.
+        shm::hash::SipKey m_secret{};
+        uint64_t m_connections_created = 0;
+        /// @brief Socket 0 also sends, the others only receive on their I/O thread.
+        std::vector< UdpSocket > m_sockets;
+        MessageBufferPool m_buffers;
+        std::vector< std::unique_ptr< IoQueue > > m_io_queues;
+        std::vector< ReceivedDatagram > m_received;
+        std::unordered_map< uint64_t, std::shared_ptr< UdpPeer > > m_peers;
+        /// @brief Address key of every peer by its session, for Refuse.
+        std::unordered_map< uint64_t, uint64_t > m_peer_keys;
+        /// @brief Tick until which an address is refused, by address key. Only holds addresses whose peer is gone.
+        std::unordered_map< uint64_t, uint64_t > m_refused;
+        /// @brief Declared last, joined before everything they touch is destroyed.
+        std::vector< std::jthread > m_io_threads;
+    };
+
+    struct UdpAdoption
+    {
+        std::unique_ptr< UdpServer > m_server;
+        /// @brief Old and new session of every adopted peer.
+        std::vector< SessionRename > m_sessions;
+    };
+} // namespace shm::net
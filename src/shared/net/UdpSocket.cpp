@@ -0,0 +1,345 @@
+#include "UdpSocket.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    /// @brief Segments of one GSO message, the kernel's UDP_MAX_SEGMENTS.
+    constexpr std::size_t G_MAX_SEGMENTS = 64;
+    /// @brief Payload of one GSO message, it still has to fit a single IP packet before it is split.
+    constexpr std::size_t G_MAX_SEGMENTED_BYTES = 65'000;
+
+    std::unexpected< std::error_code > LastError()
+    {
+        return std::unexpected( std::error_code( errno, std::generic_category() ) );
+    }
+
+    sockaddr_in ToSockaddr( shm::net::UdpAddress address )
+    {
+        sockaddr_in result{};
+        result.sin_family      = AF_INET;
+        result.sin_addr.s_addr = htonl( address.m_ip );
+        result.sin_port        = htons( address.m_port );
+        return result;
+    }
+
+    shm::net::UdpAddress FromSockaddr( const sockaddr_in & address )
+    {
+        return { ntohl( address.sin_addr.s_addr ), ntohs( address.sin_port ) };
+    }
+
+    /// @brief Datagrams the kernel could not take right now are lost like on the wire, anything else is an error.
+    bool IsTransient( int error )
+    {
+        return error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS || error == ECONNREFUSED;
+    }
+#endif
+} // namespace
+
+std::string shm::net::UdpAddress::ToString() const
+{
+    return std::to_string( m_ip >> 24 ) + '.' + std::to_string( ( m_ip >> 16 ) & 0xFF ) + '.' + std::to_string( ( m_ip >> 8 ) & 0xFF ) + '.'
+           + std::to_string( m_ip & 0xFF ) + ':' + std::to_string( m_port );
+}
+
+shm::net::UdpSocket::UdpSocket( UniqueFd socket )
+    : m_socket( std::move( socket ) )
+{
+}
+
+shm::Result< shm::net::UdpSocket > shm::net::UdpSocket::Bind( UdpAddress local, bool reuse_port )
+{
+#ifndef __linux__
+    (void)local;
+    (void)reuse_port;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    UniqueFd socket( ::socket( AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 ) );
+    if ( !socket )
+        return LastError();
+
+    const int enabled = 1;
+    if ( reuse_port && ::setsockopt( socket.Get(), SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof( enabled ) ) != 0 )
+        return LastError();
+    // A tick worth of traffic of every peer has to fit while the broker is busy ticking.
+    const int buffer_size = 4 << 20;
+    ::setsockopt( socket.Get(), SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof( buffer_size ) );
+    ::setsockopt( socket.Get(), SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof( buffer_size ) );
+
+    const auto address = ToSockaddr( local );
+    if ( ::bind( socket.Get(), reinterpret_cast< const sockaddr * >( &address ), sizeof( address ) ) != 0 )
+        return LastError();
+    return UdpSocket( std::move( socket ) );
+#endif
+}
+
+shm::Result< shm::net::UdpSocket > shm::net::UdpSocket::Adopt( UniqueFd socket )
+{
+#ifndef __linux__
+    (void)socket;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    int type       = 0;
+    socklen_t size = sizeof( type );
+    if ( ::getsockopt( socket.Get(), SOL_SOCKET, SO_TYPE, &type, &size ) != 0 )
+        return std::unexpected( std::make_error_code( std::errc::not_a_socket ) );
+    if ( type != SOCK_DGRAM )
+        return std::unexpected( std::make_error_code( std::errc::wrong_protocol_type ) );
+
+    // Receiving and sending rely on never blocking.
+    const int flags = ::fcntl( socket.Get(), F_GETFL );
+    if ( flags < 0 || ::fcntl( socket.Get(), F_SETFL, flags | O_NONBLOCK ) != 0 )
+        return LastError();
+    return UdpSocket( std::move( socket ) );
+#endif
+}
+
+shm::net::UdpAddress shm::net::UdpSocket::LocalAddress() const
+{
+#ifdef __linux__
+    sockaddr_in address{};
+    socklen_t size = sizeof( address );
+    if ( ::getsockname( m_socket.Get(), reinterpret_cast< sockaddr * >( &address ), &size ) == 0 )
+        return FromSockaddr( address );
+#endif
+    return {};
+}
+
+shm::Result< bool > shm::net::UdpSocket::WaitReadable( std::chrono::milliseconds timeout ) const
+{
+#ifndef __linux__
+    (void)timeout;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    pollfd readable{ .fd = m_socket.Get(), .events = POLLIN, .revents = 0 };
+    const int ready = ::poll( &readable, 1, static_cast< int >( timeout.count() ) );
+    if ( ready < 0 )
+        return errno == EINTR ? shm::Result< bool >{ false } : LastError();
+    return ready > 0;
+#endif
+}
+
+shm::Result< std::size_t > shm::net::UdpSocket::ReceiveBatch( MessageBufferPool & pool, std::span< ReceivedDatagram > datagrams,
+                                                             std::size_t max_per_call )
+{
+#ifndef __linux__
+    (void)pool;
+    (void)datagrams;
+    (void)max_per_call;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    std::array< mmsghdr, BatchSize > messages;
+    std::array< iovec, BatchSize > vectors;
+    std::array< sockaddr_in, BatchSize > sources;
+    std::array< MessageBufferHandle, BatchSize > buffers;
+
+    const auto per_call  = std::clamp< std::size_t >( max_per_call, 1, BatchSize );
+    std::size_t received = 0;
+    while ( received < datagrams.size() )
+    {
+        const auto batch     = std::min( per_call, datagrams.size() - received );
+        std::size_t prepared = 0;
+        for ( ; prepared < batch; ++prepared )
+        {
+            buffers[ prepared ] = pool.Create();
+            auto * buffer       = pool.Get( buffers[ prepared ] );
+            if ( !buffer )
+                break;
+            vectors[ prepared ]  = { buffer->m_data.data(), MaxDatagramSize };
+            messages[ prepared ] = mmsghdr{ .msg_hdr = { .msg_name       = &sources[ prepared ],
+                                                          .msg_namelen    = sizeof( sockaddr_in ),
+                                                          .msg_iov        = &vectors[ prepared ],
+                                                          .msg_iovlen     = 1,
+                                                          .msg_control    = nullptr,
+                                                          .msg_controllen = 0,
+                                                          .msg_flags      = 0 },
+                                            .msg_len = 0 };
+        }
+
+        const int count   = prepared == 0 ? 0 : ::recvmmsg( m_socket.Get(), messages.data(), static_cast< unsigned >( prepared ), MSG_DONTWAIT, nullptr );
+        const int error   = errno;
+        const auto filled = static_cast< std::size_t >( std::max( count, 0 ) );
+        for ( std::size_t i = 0; i < prepared; ++i )
+        {
+            if ( i >= filled || ( messages[ i ].msg_hdr.msg_flags & MSG_TRUNC ) != 0 )
+            {
+                pool.Destroy( buffers[ i ] );
+                continue;
+            }
+            pool.Get( buffers[ i ] )->m_size = messages[ i ].msg_len;
+            datagrams[ received++ ]          = { FromSockaddr( sources[ i ] ), buffers[ i ] };
+        }
+
+        if ( count < 0 && !IsTransient( error ) && error != EINTR )
+            return std::unexpected( std::error_code( error, std::generic_category() ) );
+        if ( filled < batch )
+            break;
+    }
+    return received;
+#endif
+}
+
+bool shm::net::UdpSocket::Queue( UdpAddress to, std::span< const std::byte > datagram )
+{
+    if ( datagram.size() > MaxDatagramSize )
+        return false;
+
+    m_queued.push_back( { to, static_cast< uint32_t >( m_queued_bytes.size() ), static_cast< uint32_t >( datagram.size() ) } );
+    m_queued_bytes.insert( m_queued_bytes.end(), datagram.begin(), datagram.end() );
+    return true;
+}
+
+shm::Result< std::size_t > shm::net::UdpSocket::Flush( UdpSendMode mode )
+{
+#ifndef __linux__
+    (void)mode;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    shm::Result< std::size_t > sent = 0;
+    if ( mode == UdpSendMode::PerDatagram )
+        sent = FlushPerDatagram();
+    else
+        sent = FlushBatched( mode == UdpSendMode::Segmented && m_segmentation_supported ? G_MAX_SEGMENTS : 1 );
+
+    m_queued.clear();
+    m_queued_bytes.clear();
+    return sent;
+#endif
+}
+
+shm::Result< std::size_t > shm::net::UdpSocket::FlushPerDatagram()
+{
+#ifndef __linux__
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    std::size_t sent = 0;
+    for ( const auto & datagram : m_queued )
+    {
+        const auto address = ToSockaddr( datagram.m_to );
+        const auto result  = ::sendto( m_socket.Get(), m_queued_bytes.data() + datagram.m_offset, datagram.m_size, 0,
+                                       reinterpret_cast< const sockaddr * >( &address ), sizeof( address ) );
+        if ( result >= 0 )
+            ++sent;
+        else if ( !IsTransient( errno ) && errno != EINTR )
+            return LastError();
+    }
+    return sent;
+#endif
+}
+
+shm::Result< std::size_t > shm::net::UdpSocket::FlushBatched( std::size_t max_segments )
+{
+#ifndef __linux__
+    (void)max_segments;
+    return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+#else
+    constexpr std::size_t control_size = CMSG_SPACE( sizeof( uint16_t ) );
+
+    std::array< mmsghdr, BatchSize > messages;
+    std::array< sockaddr_in, BatchSize > targets;
+    std::array< std::size_t, BatchSize > segments;
+    std::array< std::size_t, BatchSize > first_queued;
+    std::array< iovec, BatchSize * G_MAX_SEGMENTS > vectors;
+    alignas( cmsghdr ) std::array< std::array< std::byte, control_size >, BatchSize > controls;
+
+    std::size_t sent = 0;
+    std::size_t next = 0;
+    while ( next < m_queued.size() )
+    {
+        // Gather up to BatchSize messages, each a run of datagrams to the same peer. A run is segmented by the
+        // kernel into its size of the first datagram, only the last one may be shorter.
+        std::size_t message_count = 0;
+        std::size_t vector_count  = 0;
+        for ( ; message_count < BatchSize && next < m_queued.size(); ++message_count )
+        {
+            const auto & first    = m_queued[ next ];
+            std::size_t run       = 0;
+            std::size_t run_bytes = 0;
+            while ( next + run < m_queued.size() && run < max_segments )
+            {
+                const auto & datagram = m_queued[ next + run ];
+                if ( datagram.m_to != first.m_to || datagram.m_size > first.m_size || run_bytes + datagram.m_size > G_MAX_SEGMENTED_BYTES )
+                    break;
+                vectors[ vector_count + run ] = { m_queued_bytes.data() + datagram.m_offset, datagram.m_size };
+                run_bytes += datagram.m_size;
+                ++run;
+                if ( datagram.m_size < first.m_size )
+                    break;
+            }
+
+            targets[ message_count ]      = ToSockaddr( first.m_to );
+            first_queued[ message_count ] = next;
+            segments[ message_count ]     = run;
+            messages[ message_count ]     = mmsghdr{ .msg_hdr = { .msg_name       = &targets[ message_count ],
+                                                                   .msg_namelen    = sizeof( sockaddr_in ),
+                                                                   .msg_iov        = &vectors[ vector_count ],
+                                                                   .msg_iovlen     = run,
+                                                                   .msg_control    = nullptr,
+                                                                   .msg_controllen = 0,
+                                                                   .msg_flags      = 0 },
+                                                     .msg_len = 0 };
+            if ( run > 1 )
+            {
+                auto & header            = messages[ message_count ].msg_hdr;
+                header.msg_control       = controls[ message_count ].data();
+                header.msg_controllen    = control_size;
+                cmsghdr * segment_size   = CMSG_FIRSTHDR( &header );
+                segment_size->cmsg_level = SOL_UDP;
+                segment_size->cmsg_type  = UDP_SEGMENT;
+                segment_size->cmsg_len   = CMSG_LEN( sizeof( uint16_t ) );
+                const auto size          = static_cast< uint16_t >( first.m_size );
+                std::memcpy( CMSG_DATA( segment_size ), &size, sizeof( size ) );
+            }
+            vector_count += run;
+            next += run;
+        }
+
+        for ( std::size_t offset = 0; offset < message_count; )
+        {
+            const int count = ::sendmmsg( m_socket.Get(), messages.data() + offset, static_cast< unsigned >( message_count - offset ), 0 );
+            if ( count < 0 )
+            {
+                if ( errno == EINTR )
+                    continue;
+                if ( max_segments > 1 && ( errno == EIO || errno == EINVAL || errno == ENOPROTOOPT ) )
+                {
+                    // No GSO on this kernel or device, send the rest as plain datagrams from now on.
+                    m_segmentation_supported = false;
+                    m_queued.erase( m_queued.begin(), m_queued.begin() + static_cast< std::ptrdiff_t >( first_queued[ offset ] ) );
+                    const auto rest = FlushBatched( 1 );
+                    if ( !rest.has_value() )
+                        return rest;
+                    return sent + *rest;
+                }
+                if ( !IsTransient( errno ) )
+                    return LastError();
+                if ( errno == ECONNREFUSED )
+                {
+                    // A pending error from an earlier datagram to a closed port, only this message is lost.
+                    ++offset;
+                    continue;
+                }
+                // The socket buffer is full, retrying would only fail again. Everything still queued is dropped
+                // and Flush empties the queue.
+                return sent;
+            }
+            for ( int i = 0; i < count; ++i )
+                sent += segments[ offset + static_cast< std::size_t >( i ) ];
+            offset += static_cast< std::size_t >( count );
+        }
+    }
+    return sent;
+#endif
+}
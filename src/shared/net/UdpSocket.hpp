@@ -0,0 +1,126 @@
+#pragma once
+
+#include "net/MessageBuffer.hpp"
+#include "net/UniqueFd.hpp"
+#include "results/Result.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace shm::net
+{
+    /// @brief Largest datagram sent or received, fits an Ethernet MTU without IP fragmentation.
+    constexpr std::size_t MaxDatagramSize = 1472;
+
+    /// @brief IPv4 address and port, both in host byte order.
+    struct UdpAddress
+    {
+        uint32_t m_ip   = 0;
+        uint16_t m_port = 0;
+
+        [[nodiscard]] static constexpr UdpAddress Loopback( uint16_t port ) noexcept
+        {
+            return { 0x7F'00'00'01, port };
+        }
+
+        [[nodiscard]] constexpr uint64_t Key() const noexcept
+        {
+            return ( static_cast< uint64_t >( m_ip ) << 16 ) | m_port;
+        }
+
+        [[nodiscard]] std::string ToString() const;
+
+        constexpr bool operator==( const UdpAddress & ) const noexcept = default;
+    };
+
+    struct ReceivedDatagram
+    {
+        UdpAddress m_from;
+        /// @brief Owned by the receiver, it has to hand it back to the pool.
+        MessageBufferHandle m_buffer;
+    };
+
+    enum class UdpSendMode : uint8_t
+    {
+        /// @brief One sendto per datagram, the reference the batched modes are measured against.
+        PerDatagram,
+        /// @brief All queued datagrams in as few sendmmsg calls as possible.
+        Batched,
+        /// @brief Like Batched, runs of equally sized datagrams to the same peer additionally become a single UDP GSO
+        /// message the kernel splits late. Falls back to Batched where the kernel does not support it.
+        Segmented,
+    };
+
+    /// @brief Non-blocking UDP socket which receives and sends in batches. Datagrams to send are queued over the
+    /// tick and written with one Flush, received datagrams land in pooled buffers. Receiving and sending may happen
+    /// on different threads, each of them on one thread at a time.
+    class UdpSocket
+    {
+    public:
+        /// @brief Datagrams handled per system call.
+        static constexpr std::size_t BatchSize = 64;
+
+        /// @param reuse_port Sets SO_REUSEPORT, so that every I/O thread can bind its own socket to the same port
+        /// and the kernel spreads peers across them.
+        static shm::Result< UdpSocket > Bind( UdpAddress local, bool reuse_port );
+
+        /// @brief Takes over a bound UDP socket, e.g. one handed over by another process.
+        /// @return not_a_socket or wrong_protocol_type if the descriptor is no UDP socket.
+        static shm::Result< UdpSocket > Adopt( UniqueFd socket );
+
+        /// @brief The descriptor, to hand the socket to another process. It stays owned by this socket.
+        [[nodiscard]] int NativeHandle() const noexcept
+        {
+            return m_socket.Get();
+        }
+
+        [[nodiscard]] UdpAddress LocalAddress() const;
+
+        /// @brief Waits until a datagram can be received.
+        /// @return False if none arrived within the timeout.
+        [[nodiscard]] shm::Result< bool > WaitReadable( std::chrono::milliseconds timeout ) const;
+
+        /// @brief Receives what already arrived without waiting, up to datagrams.size() (at most BatchSize per system call).
+        /// @param max_per_call 1 receives one datagram per system call, the reference the batch is measured against.
+        /// @return Number of datagrams written to the front of datagrams. Datagrams larger than MaxDatagramSize are dropped.
+        shm::Result< std::size_t > ReceiveBatch( MessageBufferPool & pool, std::span< ReceivedDatagram > datagrams, std::size_t max_per_call = BatchSize );
+
+        /// @brief Copies a datagram into the send queue.
+        /// @return False if it is larger than MaxDatagramSize.
+        bool Queue( UdpAddress to, std::span< const std::byte > datagram );
+
+        /// @brief Sends every queued datagram and empties the queue. Once the kernel has no room left, batched modes drop
+        /// the rest of the queue like any other lost datagram.
+        /// @return Number of datagrams sent.
+        shm::Result< std::size_t > Flush( UdpSendMode mode );
+
+        [[nodiscard]] std::size_t QueuedDatagrams() const noexcept
+        {
+            return m_queued.size();
+        }
+
+    private:
+        explicit UdpSocket( UniqueFd socket );
+
+        shm::Result< std::size_t > FlushPerDatagram();
+        /// @param max_segments 1 disables segmentation.
+        shm::Result< std::size_t > FlushBatched( std::size_t max_segments );
+
+        struct QueuedDatagram
+        {
+            UdpAddress m_to;
+            uint32_t m_offset;
+            uint32_t m_size;
+        };
+
+        UniqueFd m_socket;
+        std::vector< QueuedDatagram > m_queued;
+        std::vector< std::byte > m_queued_bytes;
+        bool m_segmentation_supported = true;
+    };
+} // namespace shm::net
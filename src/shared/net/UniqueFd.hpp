@@ -0,0 +1,81 @@
+#pragma once
+
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace shm::net
+{
+    /// @brief Owning POSIX file descriptor (socket, memfd, eventfd), closed on destruction.
+    class UniqueFd
+    {
+    public:
+        UniqueFd() = default;
+
+        explicit UniqueFd( int fd ) noexcept
+            : m_fd( fd )
+        {
+        }
+
+        ~UniqueFd()
+        {
+            Reset();
+        }
+
+        UniqueFd( const UniqueFd & )             = delete;
+        UniqueFd & operator=( const UniqueFd & ) = delete;
+
+        UniqueFd( UniqueFd && other ) noexcept
+            : m_fd( std::exchange( other.m_fd, -1 ) )
+        {
+        }
+
+        UniqueFd & operator=( UniqueFd && other ) noexcept
+        {
+            if ( this != &other )
+                Reset( std::exchange( other.m_fd, -1 ) );
+            return *this;
+        }
+
+        [[nodiscard]] int Get() const noexcept
+        {
+            return m_fd;
+        }
+
+        [[nodiscard]] bool IsValid() const noexcept
+        {
+            return m_fd >= 0;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return IsValid();
+        }
+
+        /// @brief Gives up ownership without closing.
+        [[nodiscard]] int Release() noexcept
+        {
+            return std::exchange( m_fd, -1 );
+        }
+
+        void Reset( int fd = -1 ) noexcept
+        {
+            if ( m_fd >= 0 )
+            {
+#ifdef _WIN32
+                ::_close( m_fd );
+#else
+                ::close( m_fd );
+#endif
+            }
+            m_fd = fd;
+        }
+
+    private:
+        int m_fd = -1;
+    };
+} // namespace shm::net
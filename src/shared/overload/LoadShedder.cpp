@@ -0,0 +1,138 @@
+#include "LoadShedder.hpp"
+
+#include "metrics/Metrics.hpp"
+#include "net/Messages.hpp"
+#include "protocol/FrameHeader.hpp"
+
+#include <cstring>
+#include <limits>
+#include <utility>
+
+shm::overload::LoadShedder::LoadShedder( metrics::Registry & registry, const OverloadConfig & config )
+    : m_config( config )
+    , m_superseded_counter( registry.GetCounter( "shm_shed_position_updates_total", "Position updates replaced by a newer one before reaching the world" ) )
+    , m_dropped_counter( registry.GetCounter( "shm_shed_messages_total", "Messages of sessions waiting at the admission gate" ) )
+    , m_rejected_counter( registry.GetCounter( "shm_rejected_sessions_total", "Sessions turned away because the broker was overloaded" ) )
+{
+}
+
+std::span< const uint64_t > shm::overload::LoadShedder::Apply( net::Inbox & inbox, OverloadLevel level, uint64_t tick )
+{
+    m_rejected.clear();
+    m_rejected_lookup.clear();
+    if ( level == OverloadLevel::Normal && m_waiting.empty() && m_deferred_moves.empty() )
+        return {};
+
+    const bool reduce_moves = level >= OverloadLevel::ReducedReplication && m_config.reduced_replication_interval > 1;
+    m_shed.Clear();
+    inbox.ForEach( [ & ]( const net::InboundEvent & event ) { Shed( event, level, reduce_moves ); } );
+
+    // Due updates move on, all of them once replication is back to normal.
+    for ( auto iter = m_deferred_moves.begin(); iter != m_deferred_moves.end(); )
+    {
+        if ( reduce_moves && !IsDue( iter->first, tick ) )
+        {
+            ++iter;
+            continue;
+        }
+        m_shed.Push( net::InboundType::Message, iter->first, iter->second );
+        iter = m_deferred_moves.erase( iter );
+    }
+
+    std::size_t admissions = std::numeric_limits< std::size_t >::max();
+    if ( level >= OverloadLevel::RejectConnections )
+        admissions = 0;
+    else if ( level >= OverloadLevel::AdmissionGate )
+        admissions = m_config.admissions_per_tick;
+    while ( admissions > 0 && !m_waiting_order.empty() )
+    {
+        const auto session = m_waiting_order.front();
+        m_waiting_order.pop_front();
+        if ( m_waiting.erase( session ) == 0 )
+            continue;
+
+        m_shed.Push( net::InboundType::Connected, session );
+        --admissions;
+    }
+    if ( m_waiting.empty() )
+        m_waiting_order.clear();
+
+    std::swap( inbox, m_shed );
+    return m_rejected;
+}
+
+void shm::overload::LoadShedder::Shed( const net::InboundEvent & event, OverloadLevel level, bool reduce_moves )
+{
+    switch ( event.m_type )
+    {
+    case net::InboundType::Connected:
+    {
+        // Once sessions wait, new ones queue up behind them even if the level already dropped below the gate.
+        const bool gated = level >= OverloadLevel::AdmissionGate || !m_waiting.empty();
+        if ( level >= OverloadLevel::RejectConnections || ( gated && m_waiting.size() >= m_config.max_waiting_sessions ) )
+        {
+            m_rejected.push_back( event.m_session );
+            m_rejected_lookup.insert( event.m_session );
+            m_rejected_counter.Increment();
+        }
+        else if ( gated )
+        {
+            if ( m_waiting.insert( event.m_session ).second )
+                m_waiting_order.push_back( event.m_session );
+        }
+        else
+        {
+            m_shed.Push( event.m_type, event.m_session );
+        }
+        return;
+    }
+    case net::InboundType::Disconnected:
+    {
+        // The tick never saw these sessions connect.
+        if ( m_waiting.erase( event.m_session ) != 0 || m_rejected_lookup.contains( event.m_session ) )
+            return;
+
+        m_deferred_moves.erase( event.m_session );
+        m_shed.Push( event.m_type, event.m_session );
+        return;
+    }
+    case net::InboundType::Message:
+    {
+        if ( m_waiting.contains( event.m_session ) || m_rejected_lookup.contains( event.m_session ) )
+        {
+            m_dropped_counter.Increment();
+            return;
+        }
+
+        if ( reduce_moves && IsMove( event.m_payload ) )
+        {
+            auto & deferred = m_deferred_moves[ event.m_session ];
+            if ( !deferred.empty() )
+                m_superseded_counter.Increment();
+            deferred.assign( event.m_payload.begin(), event.m_payload.end() );
+            return;
+        }
+        // A held back update must not land after a newer one.
+        if ( !m_deferred_moves.empty() && IsMove( event.m_payload ) && m_deferred_moves.erase( event.m_session ) != 0 )
+            m_superseded_counter.Increment();
+
+        m_shed.Push( event.m_type, event.m_session, event.m_payload );
+        return;
+    }
+    }
+}
+
+bool shm::overload::LoadShedder::IsMove( std::span< const std::byte > frame ) const noexcept
+{
+    protocol::FrameHeader header;
+    if ( frame.size() < sizeof( header ) )
+        return false;
+
+    std::memcpy( &header, frame.data(), sizeof( header ) );
+    return header.m_opcode == net::msg::Move::Opcode;
+}
+
+bool shm::overload::LoadShedder::IsDue( uint64_t session, uint64_t tick ) const noexcept
+{
+    return ( session + tick ) % m_config.reduced_replication_interval == 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "net/Inbox.hpp"
+#include "overload/OverloadController.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace shm::metrics
+{
+    class Counter;
+} // namespace shm::metrics
+
+namespace shm::overload
+{
+    /// @brief Sheds load from the inbound events of a tick according to the overload level, before the tick or a
+    /// capture sees them. Captures therefore record what the tick actually handled and replay the same way.
+    ///
+    /// - ReducedReplication keeps only the newest position update of a session and hands it on every
+    ///   reduced_replication_interval ticks, sessions take turns so the updates spread over the ticks.
+    /// - AdmissionGate holds back new sessions and lets admissions_per_tick of them in per tick, in arrival order.
+    ///   Messages of a waiting session are dropped, it does not exist for the tick yet.
+    /// - RejectConnections turns new sessions away, as does a full gate. The caller tells the peers and closes them.
+    ///
+    /// Levels below DeferredSystems need nothing from here. Tick thread only.
+    class LoadShedder
+    {
+    public:
+        explicit LoadShedder( metrics::Registry & registry, const OverloadConfig & config = {} );
+
+        LoadShedder( const LoadShedder & )             = delete;
+        LoadShedder & operator=( const LoadShedder & ) = delete;
+
+        void Configure( const OverloadConfig & config ) noexcept
+        {
+            m_config = config;
+        }
+
+        /// @brief Rewrites the inbox of the given tick in place.
+        /// @return Sessions rejected this tick, valid until the next call.
+        std::span< const uint64_t > Apply( net::Inbox & inbox, OverloadLevel level, uint64_t tick );
+
+        /// @brief Sessions waiting at the admission gate.
+        [[nodiscard]] std::size_t Waiting() const noexcept
+        {
+            return m_waiting.size();
+        }
+
+        /// @brief Sessions with a position update held back for a later tick.
+        [[nodiscard]] std::size_t Deferred() const noexcept
+        {
+            return m_deferred_moves.size();
+        }
+
+    private:
+        /// @brief Handles one event, appending what is left of it to m_shed.
+        void Shed( const net::InboundEvent & event, OverloadLevel level, bool reduce_moves );
+        [[nodiscard]] bool IsMove( std::span< const std::byte > frame ) const noexcept;
+        [[nodiscard]] bool IsDue( uint64_t session, uint64_t tick ) const noexcept;
+
+        OverloadConfig m_config;
+        /// @brief Receives the events that are kept, swapped with the inbox afterwards.
+        net::Inbox m_shed;
+        /// @brief Newest held back position update per session, the frame bytes.
+        std::unordered_map< uint64_t, std::vector< std::byte > > m_deferred_moves;
+        /// @brief Arrival order of the waiting sessions. Sessions that went away meanwhile are skipped when popping.
+        std::deque< uint64_t > m_waiting_order;
+        std::unordered_set< uint64_t > m_waiting;
+        /// @brief Both hold the sessions rejected this tick, the set to look them up.
+        std::vector< uint64_t > m_rejected;
+        std::unordered_set< uint64_t > m_rejected_lookup;
+
+        metrics::Counter & m_superseded_counter;
+        metrics::Counter & m_dropped_counter;
+        metrics::Counter & m_rejected_counter;
+    };
+} // namespace shm::overload
@@ -0,0 +1,59 @@
+#include "OverloadController.hpp"
+
+#include "metrics/Metrics.hpp"
+
+#include <algorithm>
+
+shm::overload::OverloadController::OverloadController( metrics::Registry & registry, uint64_t frame_budget_ns, const OverloadConfig & config )
+    : m_config( config )
+    , m_frame_budget_ns( frame_budget_ns )
+    , m_level_gauge( registry.GetGauge( "shm_overload_level", "Load shedding step, 0 when the broker keeps up" ) )
+{
+    m_level_gauge.Set( 0 );
+}
+
+void shm::overload::OverloadController::Configure( const OverloadConfig & config ) noexcept
+{
+    m_config           = config;
+    m_overloaded_ticks = 0;
+    m_idle_ticks       = 0;
+}
+
+shm::overload::OverloadLevel shm::overload::OverloadController::Observe( uint64_t frame_ns, std::size_t inbound_events ) noexcept
+{
+    // Quarter weight for the newest frame: a step in load shows after two or three frames, a lone outlier barely does.
+    const auto smoothed = static_cast< int64_t >( m_smoothed_frame_ns );
+    m_smoothed_frame_ns = static_cast< uint64_t >( smoothed + ( static_cast< int64_t >( frame_ns ) - smoothed ) / 4 );
+
+    const bool queue_overloaded = m_config.max_inbound_events != 0 && inbound_events >= m_config.max_inbound_events;
+    const bool overloaded       = queue_overloaded || m_smoothed_frame_ns * 100 >= m_frame_budget_ns * m_config.escalate_percent;
+    const bool idle             = !queue_overloaded && m_smoothed_frame_ns * 100 < m_frame_budget_ns * m_config.recover_percent;
+
+    if ( overloaded )
+    {
+        m_idle_ticks = 0;
+        if ( ++m_overloaded_ticks >= std::max( m_config.escalate_after_ticks, 1u ) && m_level != OverloadLevel::RejectConnections )
+        {
+            m_level            = static_cast< OverloadLevel >( static_cast< uint8_t >( m_level ) + 1 );
+            m_overloaded_ticks = 0;
+        }
+    }
+    else if ( idle )
+    {
+        m_overloaded_ticks = 0;
+        if ( ++m_idle_ticks >= std::max( m_config.recover_after_ticks, 1u ) && m_level != OverloadLevel::Normal )
+        {
+            m_level      = static_cast< OverloadLevel >( static_cast< uint8_t >( m_level ) - 1 );
+            m_idle_ticks = 0;
+        }
+    }
+    else
+    {
+        // Between the two thresholds the current level is right, neither direction builds up.
+        m_overloaded_ticks = 0;
+        m_idle_ticks       = 0;
+    }
+
+    m_level_gauge.Set( static_cast< int64_t >( m_level ) );
+    return m_level;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shm::metrics
+{
+    class Gauge;
+    class Registry;
+} // namespace shm::metrics
+
+/// @brief Keeping the tick within its frame budget when more traffic arrives than it can handle.
+namespace shm::overload
+{
+    /// @brief Thresholds of the overload controller and the load shedder, hot reloadable. Field names are the json keys.
+    struct OverloadConfig
+    {
+        static constexpr uint32_t ConfigVersion = 1;
+
+        /// @brief Smoothed frame time, in percent of the frame budget, from which the broker sheds more load.
+        uint32_t escalate_percent = 90;
+        /// @brief Smoothed frame time, in percent of the frame budget, below which the broker sheds less load.
+        uint32_t recover_percent = 50;
+        /// @brief Ticks the broker has to stay overloaded before each further step.
+        uint32_t escalate_after_ticks = 3;
+        /// @brief Ticks the broker has to stay below recover_percent before each step back, ten seconds by default
+        /// so a spike is ridden out at one level instead of probing every few seconds.
+        uint32_t recover_after_ticks = 1200;
+        /// @brief Inbound events per tick that count as overload whatever the frame time, 0 ignores the queue.
+        uint32_t max_inbound_events = 50'000;
+        /// @brief Ticks between two position updates of a session while replication is reduced.
+        uint32_t reduced_replication_interval = 4;
+        /// @brief Sessions let through the admission gate per tick while it is closed.
+        uint32_t admissions_per_tick = 16;
+        /// @brief Sessions waiting at the admission gate, further ones are rejected.
+        uint32_t max_waiting_sessions = 2048;
+        /// @brief Sent to rejected peers as the time after which they may try again.
+        uint32_t retry_after_ms = 5000;
+    };
+
+    /// @brief Steps of graceful degradation, each one includes the ones before it.
+    enum class OverloadLevel : uint8_t
+    {
+        Normal,
+        /// @brief Position updates of a session reach the world only every reduced_replication_interval ticks.
+        ReducedReplication,
+        /// @brief Deferred jobs below normal priority, e.g. periodic journal snapshots, wait until the broker recovered.
+        DeferredSystems,
+        /// @brief New sessions wait at the admission gate and are let in a few per tick.
+        AdmissionGate,
+        /// @brief New sessions are turned away with a retry-after.
+        RejectConnections,
+    };
+
+    /// @brief Watches the frame time and the inbound queue of every tick and moves the overload level one step at a
+    /// time: up once the broker was overloaded for escalate_after_ticks, down once it was idle enough for
+    /// recover_after_ticks. The frame time is smoothed first, a single late frame does not shed anything.
+    class OverloadController
+    {
+    public:
+        OverloadController( metrics::Registry & registry, uint64_t frame_budget_ns, const OverloadConfig & config = {} );
+
+        OverloadController( const OverloadController & )             = delete;
+        OverloadController & operator=( const OverloadController & ) = delete;
+
+        /// @brief Takes effect from the next tick on, the current level is kept.
+        void Configure( const OverloadConfig & config ) noexcept;
+
+        /// @brief Once per tick, after it ran.
+        /// @param inbound_events Events the tick received, before any of them were shed.
+        /// @return The level for the next tick.
+        OverloadLevel Observe( uint64_t frame_ns, std::size_t inbound_events ) noexcept;
+
+        [[nodiscard]] OverloadLevel Level() const noexcept
+        {
+            return m_level;
+        }
+
+        [[nodiscard]] uint64_t SmoothedFrameNs() const noexcept
+        {
+            return m_smoothed_frame_ns;
+        }
+
+        [[nodiscard]] const OverloadConfig & Config() const noexcept
+        {
+            return m_config;
+        }
+
+    private:
+        OverloadConfig m_config;
+        uint64_t m_frame_budget_ns   = 0;
+        uint64_t m_smoothed_frame_ns = 0;
+        OverloadLevel m_level        = OverloadLevel::Normal;
+        uint32_t m_overloaded_ticks  = 0;
+        uint32_t m_idle_ticks        = 0;
+
+        metrics::Gauge & m_level_gauge;
+    };
+} // namespace shm::overload
@@ -0,0 +1,297 @@
+#include "Capture.hpp"
+
+#include "hash/Crc32c.hpp"
+#include "journal/Journal.hpp"
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+    // File header: magic and format version. Everything after it is framed like the journal: payload size and
+    // CRC-32C of the payload (both little endian), then the payload. The first frame is the initial world state,
+    // every following frame one event: type, tick, value, then the event payload.
+    constexpr std::string_view CAPTURE_MAGIC  = "SHMCAPT";
+    constexpr uint32_t CAPTURE_VERSION        = 1;
+    constexpr std::size_t FILE_HEADER_SIZE    = 12;
+    constexpr std::size_t FRAME_HEADER_SIZE   = 8;
+    constexpr std::size_t EVENT_HEADER_SIZE   = 17;
+    constexpr std::size_t CAPTURE_BUFFER_SIZE = 1024 * 1024;
+
+    static_assert( std::to_underlying( shm::replay::CaptureEventType::Connected ) == std::to_underlying( shm::net::InboundType::Connected ) );
+    static_assert( std::to_underlying( shm::replay::CaptureEventType::Disconnected ) == std::to_underlying( shm::net::InboundType::Disconnected ) );
+    static_assert( std::to_underlying( shm::replay::CaptureEventType::Message ) == std::to_underlying( shm::net::InboundType::Message ) );
+
+    template< typename T >
+    void StoreLe( std::byte * out, T value )
+    {
+        for ( std::size_t i = 0; i < sizeof( T ); ++i )
+            out[ i ] = static_cast< std::byte >( value >> ( 8 * i ) );
+    }
+
+    template< typename T >
+    T LoadLe( const std::byte * in )
+    {
+        T value = 0;
+        for ( std::size_t i = 0; i < sizeof( T ); ++i )
+            value |= static_cast< T >( in[ i ] ) << ( 8 * i );
+        return value;
+    }
+
+    /// @brief FNV-1a, 64 bit.
+    class WorldHasher
+    {
+    public:
+        template< typename T >
+        void Add( T value )
+        {
+            for ( std::size_t i = 0; i < sizeof( T ); ++i )
+            {
+                m_hash ^= static_cast< uint8_t >( value >> ( 8 * i ) );
+                m_hash *= 0x100000001B3ull;
+            }
+        }
+
+        [[nodiscard]] uint64_t Value() const noexcept
+        {
+            return m_hash;
+        }
+
+    private:
+        uint64_t m_hash = 0xCBF29CE484222325ull;
+    };
+} // namespace
+
+uint64_t shm::replay::HashWorld( const journal::WorldSnapshot & state )
+{
+    WorldHasher hasher;
+    hasher.Add( state.next_entity_id );
+    hasher.Add( static_cast< uint64_t >( state.entities.size() ) );
+    for ( const auto & entity : state.entities )
+    {
+        hasher.Add( entity.id );
+        hasher.Add( static_cast< uint8_t >( ( entity.transform ? 1u : 0u ) | ( entity.presence ? 2u : 0u ) ) );
+        if ( entity.transform )
+        {
+            hasher.Add( std::bit_cast< uint32_t >( entity.transform->x ) );
+            hasher.Add( std::bit_cast< uint32_t >( entity.transform->y ) );
+            hasher.Add( std::bit_cast< uint32_t >( entity.transform->z ) );
+        }
+        if ( entity.presence )
+        {
+            hasher.Add( entity.presence->session_id );
+            hasher.Add( entity.presence->world_id );
+        }
+    }
+    return hasher.Value();
+}
+
+/** CAPTURE WRITER **/
+
+shm::Result< shm::replay::CaptureWriter > shm::replay::CaptureWriter::Create( const std::filesystem::path & path,
+                                                                             const journal::WorldSnapshot & initial_state )
+{
+    if ( path.has_parent_path() )
+    {
+        std::error_code ec;
+        std::filesystem::create_directories( path.parent_path(), ec );
+        if ( ec )
+            return std::unexpected( ec );
+    }
+
+    CaptureWriter writer;
+    writer.m_file = std::fopen( path.string().c_str(), "wb" );
+    if ( !writer.m_file )
+        return std::unexpected( std::make_error_code( static_cast< std::errc >( errno ) ) );
+    std::setvbuf( writer.m_file, nullptr, _IOFBF, CAPTURE_BUFFER_SIZE );
+
+    std::array< std::byte, FILE_HEADER_SIZE > header{};
+    std::memcpy( header.data(), CAPTURE_MAGIC.data(), CAPTURE_MAGIC.size() );
+    StoreLe< uint32_t >( header.data() + 8, CAPTURE_VERSION );
+
+    const auto state   = journal::EncodeSnapshot( initial_state );
+    const auto payload = std::as_bytes( std::span( state ) );
+    std::array< std::byte, FRAME_HEADER_SIZE > frame_header;
+    StoreLe< uint32_t >( frame_header.data(), static_cast< uint32_t >( payload.size() ) );
+    StoreLe< uint32_t >( frame_header.data() + 4, shm::hash::Crc32c( payload ) );
+
+    if ( std::fwrite( header.data(), 1, header.size(), writer.m_file ) != header.size()
+         || std::fwrite( frame_header.data(), 1, frame_header.size(), writer.m_file ) != frame_header.size()
+         || std::fwrite( payload.data(), 1, payload.size(), writer.m_file ) != payload.size() )
+        return std::unexpected( std::make_error_code( std::errc::io_error ) );
+
+    return writer;
+}
+
+shm::replay::CaptureWriter::~CaptureWriter()
+{
+    std::ignore = Close();
+}
+
+shm::replay::CaptureWriter::CaptureWriter( CaptureWriter && other ) noexcept
+    : m_file( std::exchange( other.m_file, nullptr ) )
+    , m_error( other.m_error )
+    , m_frame( std::move( other.m_frame ) )
+{
+}
+
+shm::replay::CaptureWriter & shm::replay::CaptureWriter::operator=( CaptureWriter && other ) noexcept
+{
+    if ( this != &other )
+    {
+        std::ignore = Close();
+        m_file      = std::exchange( other.m_file, nullptr );
+        m_error     = other.m_error;
+        m_frame     = std::move( other.m_frame );
+    }
+    return *this;
+}
+
+void shm::replay::CaptureWriter::RecordInbound( uint64_t tick, const net::InboundEvent & event )
+{
+    Write( static_cast< CaptureEventType >( event.m_type ), tick, event.m_session, event.m_payload );
+}
+
+void shm::replay::CaptureWriter::RecordTick( uint64_t tick, float delta_time )
+{
+    Write( CaptureEventType::Tick, tick, std::bit_cast< uint32_t >( delta_time ), {} );
+}
+
+void shm::replay::CaptureWriter::RecordCheckpoint( uint64_t tick, uint64_t world_hash )
+{
+    Write( CaptureEventType::Checkpoint, tick, world_hash, {} );
+}
+
+shm::Result< void > shm::replay::CaptureWriter::Close()
+{
+    if ( m_file )
+    {
+        if ( std::fclose( m_file ) != 0 && !m_error )
+            m_error = std::make_error_code( std::errc::io_error );
+        m_file = nullptr;
+    }
+    if ( m_error )
+        return std::unexpected( m_error );
+    return {};
+}
+
+void shm::replay::CaptureWriter::Write( CaptureEventType type, uint64_t tick, uint64_t value, std::span< const std::byte > payload )
+{
+    if ( !m_file || m_error )
+        return;
+
+    const std::size_t event_size = EVENT_HEADER_SIZE + payload.size();
+    m_frame.resize( FRAME_HEADER_SIZE + event_size );
+    std::byte * event = m_frame.data() + FRAME_HEADER_SIZE;
+    event[ 0 ]        = static_cast< std::byte >( type );
+    StoreLe( event + 1, tick );
+    StoreLe( event + 9, value );
+    if ( !payload.empty() )
+        std::memcpy( event + EVENT_HEADER_SIZE, payload.data(), payload.size() );
+
+    StoreLe< uint32_t >( m_frame.data(), static_cast< uint32_t >( event_size ) );
+    StoreLe< uint32_t >( m_frame.data() + 4, shm::hash::Crc32c( std::span( event, event_size ) ) );
+    if ( std::fwrite( m_frame.data(), 1, m_frame.size(), m_file ) != m_frame.size() )
+        m_error = std::make_error_code( std::errc::io_error );
+}
+
+/** CAPTURE READER **/
+
+shm::Result< shm::replay::CaptureReader > shm::replay::CaptureReader::Open( const std::filesystem::path & path )
+{
+    auto mapped = shm::fs::MappedFile::Open( path );
+    if ( !mapped.has_value() )
+        return std::unexpected( mapped.error() );
+
+    const auto bytes = mapped->Bytes();
+    if ( bytes.size() < FILE_HEADER_SIZE + FRAME_HEADER_SIZE
+         || std::memcmp( bytes.data(), CAPTURE_MAGIC.data(), CAPTURE_MAGIC.size() ) != 0 )
+        return std::unexpected( std::make_error_code( std::errc::invalid_argument ) );
+    if ( LoadLe< uint32_t >( bytes.data() + 8 ) != CAPTURE_VERSION )
+        return std::unexpected( std::make_error_code( std::errc::not_supported ) );
+
+    const uint32_t state_size = LoadLe< uint32_t >( bytes.data() + FILE_HEADER_SIZE );
+    const uint32_t state_crc  = LoadLe< uint32_t >( bytes.data() + FILE_HEADER_SIZE + 4 );
+    if ( bytes.size() - FILE_HEADER_SIZE - FRAME_HEADER_SIZE < state_size )
+        return std::unexpected( std::make_error_code( std::errc::illegal_byte_sequence ) );
+
+    const auto state_payload = bytes.subspan( FILE_HEADER_SIZE + FRAME_HEADER_SIZE, state_size );
+    if ( shm::hash::Crc32c( state_payload ) != state_crc )
+        return std::unexpected( std::make_error_code( std::errc::illegal_byte_sequence ) );
+    auto state = journal::DecodeSnapshot( state_payload );
+    if ( !state.has_value() )
+        return std::unexpected( state.error() );
+
+    CaptureReader reader;
+    reader.m_offset        = FILE_HEADER_SIZE + FRAME_HEADER_SIZE + state_size;
+    reader.m_file          = std::move( *mapped );
+    reader.m_initial_state = std::move( *state );
+    return reader;
+}
+
+std::optional< shm::replay::CaptureEvent > shm::replay::CaptureReader::Next()
+{
+    const auto bytes = m_file.Bytes();
+    if ( m_truncated || m_offset == bytes.size() )
+        return std::nullopt;
+
+    const std::size_t left = bytes.size() - m_offset;
+    const uint32_t size    = left >= FRAME_HEADER_SIZE ? LoadLe< uint32_t >( bytes.data() + m_offset ) : 0;
+    if ( left < FRAME_HEADER_SIZE || size < EVENT_HEADER_SIZE || left - FRAME_HEADER_SIZE < size )
+    {
+        m_truncated = true;
+        return std::nullopt;
+    }
+
+    const auto event = bytes.subspan( m_offset + FRAME_HEADER_SIZE, size );
+    const auto type  = static_cast< uint8_t >( event[ 0 ] );
+    if ( shm::hash::Crc32c( event ) != LoadLe< uint32_t >( bytes.data() + m_offset + 4 )
+         || type > std::to_underlying( CaptureEventType::Checkpoint ) )
+    {
+        m_truncated = true;
+        return std::nullopt;
+    }
+
+    m_offset += FRAME_HEADER_SIZE + size;
+    return CaptureEvent{
+        .m_type    = static_cast< CaptureEventType >( type ),
+        .m_tick    = LoadLe< uint64_t >( event.data() + 1 ),
+        .m_value   = LoadLe< uint64_t >( event.data() + 9 ),
+        .m_payload = event.subspan( EVENT_HEADER_SIZE ),
+    };
+}
+
+/** REPLAY **/
+
+shm::replay::ReplayStats shm::replay::Replay( CaptureReader & reader, net::Inbox & inbox, const std::function< void( uint64_t, float ) > & step,
+                                              const std::function< uint64_t() > & world_hash )
+{
+    ReplayStats stats;
+    while ( auto event = reader.Next() )
+    {
+        switch ( event->m_type )
+        {
+        case CaptureEventType::Connected:
+        case CaptureEventType::Disconnected:
+        case CaptureEventType::Message:
+            inbox.Push( static_cast< net::InboundType >( event->m_type ), event->m_value, event->m_payload );
+            ++stats.m_events;
+            break;
+        case CaptureEventType::Tick:
+            step( event->m_tick, std::bit_cast< float >( static_cast< uint32_t >( event->m_value ) ) );
+            ++stats.m_ticks;
+            break;
+        case CaptureEventType::Checkpoint:
+            ++stats.m_checkpoints;
+            if ( !stats.m_first_divergent_tick && world_hash() != event->m_value )
+                stats.m_first_divergent_tick = event->m_tick;
+            break;
+        }
+    }
+    stats.m_truncated = reader.Truncated();
+    return stats;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "filesystem/MappedFile.hpp"
+#include "journal/WorldCommands.hpp"
+#include "net/Inbox.hpp"
+#include "results/Result.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+/// @brief Recording of everything that drives the broker tick, so a run can be replayed offline.
+/// A capture starts with the world state recording began with, followed by the inbound events of every tick,
+/// a marker per tick carrying its delta time and, now and then, a hash of the world to find where a replay diverges.
+namespace shm::replay
+{
+    enum class CaptureEventType : uint8_t
+    {
+        Connected,
+        Disconnected,
+        Message,
+        /// @brief Runs the tick, the value holds the bits of the delta time passed to the world.
+        Tick,
+        /// @brief Hash of the world after the tick, see HashWorld.
+        Checkpoint,
+    };
+
+    struct CaptureEvent
+    {
+        CaptureEventType m_type = CaptureEventType::Tick;
+        uint64_t m_tick         = 0;
+        /// @brief Session of inbound events, delta time bits of ticks, world hash of checkpoints.
+        uint64_t m_value = 0;
+        std::span< const std::byte > m_payload;
+    };
+
+    /// @brief Stable across runs and platforms: only ids and the bit patterns of the values go in, in id order.
+    [[nodiscard]] uint64_t HashWorld( const journal::WorldSnapshot & state );
+
+    class CaptureWriter
+    {
+    public:
+        static shm::Result< CaptureWriter > Create( const std::filesystem::path & path, const journal::WorldSnapshot & initial_state );
+
+        CaptureWriter() = default;
+        ~CaptureWriter();
+
+        CaptureWriter( const CaptureWriter & )             = delete;
+        CaptureWriter & operator=( const CaptureWriter & ) = delete;
+        CaptureWriter( CaptureWriter && other ) noexcept;
+        CaptureWriter & operator=( CaptureWriter && other ) noexcept;
+
+        void RecordInbound( uint64_t tick, const net::InboundEvent & event );
+        void RecordTick( uint64_t tick, float delta_time );
+        void RecordCheckpoint( uint64_t tick, uint64_t world_hash );
+
+        /// @brief Flushes and closes the file.
+        /// @return The first error any write ran into.
+        shm::Result< void > Close();
+
+    private:
+        void Write( CaptureEventType type, uint64_t tick, uint64_t value, std::span< const std::byte > payload );
+
+        std::FILE * m_file = nullptr;
+        std::error_code m_error;
+        std::vector< std::byte > m_frame;
+    };
+
+    class CaptureReader
+    {
+    public:
+        static shm::Result< CaptureReader > Open( const std::filesystem::path & path );
+
+        [[nodiscard]] const journal::WorldSnapshot & InitialState() const noexcept
+        {
+            return m_initial_state;
+        }
+
+        /// @brief The event's payload points into the mapped file and stays valid as long as the reader.
+        /// @return Nothing at the end of the capture or at the first torn or corrupt event.
+        [[nodiscard]] std::optional< CaptureEvent > Next();
+
+        /// @brief The capture ended in a torn or corrupt event, e.g. because the recording process crashed.
+        [[nodiscard]] bool Truncated() const noexcept
+        {
+            return m_truncated;
+        }
+
+    private:
+        shm::fs::MappedFile m_file;
+        journal::WorldSnapshot m_initial_state;
+        std::size_t m_offset = 0;
+        bool m_truncated     = false;
+    };
+
+    struct ReplayStats
+    {
+        uint64_t m_ticks       = 0;
+        uint64_t m_events      = 0;
+        uint64_t m_checkpoints = 0;
+        /// @brief First checkpoint whose hash did not match the recording.
+        std::optional< uint64_t > m_first_divergent_tick;
+        bool m_truncated = false;
+    };
+
+    /// @brief Feeds a capture back as fast as possible. Inbound events are pushed into the inbox, every tick
+    /// marker runs step with the recorded tick and delta time, which has to drain the inbox just like the live tick does.
+    /// Checkpoints compare world_hash against the recorded hash.
+    ReplayStats Replay( CaptureReader & reader, net::Inbox & inbox, const std::function< void( uint64_t, float ) > & step,
+                        const std::function< uint64_t() > & world_hash );
+} // namespace shm::replay
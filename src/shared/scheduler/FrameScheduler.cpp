@@ -0,0 +1,129 @@
+#include "FrameScheduler.hpp"
+
+#include "metrics/Metrics.hpp"
+#include "tracing/Tracing.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+shm::sched::FrameScheduler::FrameScheduler( metrics::Registry & registry, uint32_t max_passed_over, TimeSource now )
+    : m_max_passed_over( max_passed_over )
+    , m_now( std::move( now ) )
+    , m_backlog_gauge( registry.GetGauge( "shm_deferred_jobs", "Deferred jobs waiting for frame time" ) )
+    , m_misses_counter( registry.GetCounter( "shm_deferred_deadline_misses_total", "Deferred jobs that were not done by their deadline" ) )
+    , m_steps_counter( registry.GetCounter( "shm_deferred_steps_total", "Steps of deferred jobs run" ) )
+    , m_forced_steps_counter( registry.GetCounter( "shm_deferred_forced_steps_total", "Steps of deferred jobs run without fitting into the frame" ) )
+    , m_slice_duration( registry.GetHistogram( "shm_deferred_slice_ns", "Time spent on deferred jobs per frame" ) )
+{
+}
+
+shm::sched::FrameScheduler::JobId shm::sched::FrameScheduler::Submit( JobSettings settings, std::function< StepResult() > step )
+{
+    Job job{
+        .m_id       = m_next_id++,
+        .m_settings = std::move( settings ),
+        .m_deadline = Clock::time_point::max(),
+        .m_step     = std::move( step ),
+    };
+    if ( job.m_settings.m_deadline > Clock::duration::zero() )
+        job.m_deadline = m_now() + job.m_settings.m_deadline;
+
+    const auto urgency = []( const Job & queued ) { return std::tuple( queued.m_settings.m_priority, queued.m_deadline, queued.m_id ); };
+    const auto iter    = std::ranges::upper_bound( m_jobs, urgency( job ), {}, urgency );
+    const auto id      = job.m_id;
+    m_jobs.insert( iter, std::move( job ) );
+    m_backlog_gauge.Set( static_cast< int64_t >( m_jobs.size() ) );
+    return id;
+}
+
+bool shm::sched::FrameScheduler::Cancel( JobId id )
+{
+    const auto removed = std::erase_if( m_jobs, [ id ]( const Job & job ) { return job.m_id == id; } );
+    m_backlog_gauge.Set( static_cast< int64_t >( m_jobs.size() ) );
+    return removed != 0;
+}
+
+bool shm::sched::FrameScheduler::IsQueued( JobId id ) const noexcept
+{
+    return std::ranges::any_of( m_jobs, [ id ]( const Job & job ) { return job.m_id == id; } );
+}
+
+shm::sched::SliceStats shm::sched::FrameScheduler::RunUntil( Clock::time_point frame_end, JobPriority lowest_priority )
+{
+    SliceStats stats;
+    if ( m_jobs.empty() )
+        return stats;
+
+    const auto slice_start = m_now();
+    CountMisses( slice_start );
+
+    shm::trace::Span slice_span{ "DeferredJobs" };
+    auto now = slice_start;
+    // Sorted by priority first, once a job is below the lowest priority so is everything after it.
+    const auto eligible = [ lowest_priority ]( const Job & job ) { return job.m_settings.m_priority <= lowest_priority; };
+    while ( true )
+    {
+        auto iter = std::ranges::find_if( m_jobs,
+                                          [ & ]( const Job & job )
+                                          {
+                                              return !eligible( job ) || now + job.m_step_estimate < frame_end ||
+                                                     ( stats.m_forced == 0 && job.m_passed_over >= m_max_passed_over );
+                                          } );
+        if ( iter == m_jobs.end() || !eligible( *iter ) )
+            break;
+
+        auto & job = *iter;
+        if ( now + job.m_step_estimate >= frame_end )
+        {
+            ++stats.m_forced;
+            m_forced_steps_counter.Increment();
+        }
+        const auto result = job.m_step();
+        const auto after  = m_now();
+
+        job.m_step_estimate = std::max( after - now, job.m_step_estimate - job.m_step_estimate / 8 );
+        job.m_passed_over   = 0;
+        job.m_stepped       = true;
+        ++stats.m_steps;
+        now = after;
+
+        if ( result == StepResult::Done )
+        {
+            if ( !job.m_missed && now > job.m_deadline )
+            {
+                ++m_deadline_misses;
+                m_misses_counter.Increment();
+            }
+            m_jobs.erase( iter );
+            ++stats.m_completed;
+        }
+    }
+
+    for ( auto & job : m_jobs )
+    {
+        if ( !eligible( job ) )
+            break;
+        if ( !std::exchange( job.m_stepped, false ) )
+            ++job.m_passed_over;
+    }
+
+    stats.m_elapsed = now - slice_start;
+    m_steps_counter.Increment( stats.m_steps );
+    m_slice_duration.Record( stats.m_elapsed );
+    m_backlog_gauge.Set( static_cast< int64_t >( m_jobs.size() ) );
+    return stats;
+}
+
+void shm::sched::FrameScheduler::CountMisses( Clock::time_point now )
+{
+    for ( auto & job : m_jobs )
+    {
+        if ( job.m_missed || now <= job.m_deadline )
+            continue;
+
+        job.m_missed = true;
+        ++m_deadline_misses;
+        m_misses_counter.Increment();
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace shm::metrics
+{
+    class Counter;
+    class Gauge;
+    class Histogram;
+    class Registry;
+} // namespace shm::metrics
+
+/// @brief Deferred work that runs in whatever time the tick leaves over in a frame.
+namespace shm::sched
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum class JobPriority : uint8_t
+    {
+        High,
+        Normal,
+        Low,
+    };
+
+    enum class StepResult : uint8_t
+    {
+        /// @brief The job has more to do and is resumed by a later step, possibly in a later frame.
+        Continue,
+        Done,
+    };
+
+    struct JobSettings
+    {
+        /// @brief Identifies the job when debugging, not used otherwise.
+        std::string m_name;
+        JobPriority m_priority = JobPriority::Normal;
+        /// @brief Time after submission by which the job should be done, zero for none. A job past its deadline is
+        /// counted as a miss once, it still only runs in left over frame time.
+        Clock::duration m_deadline = Clock::duration::zero();
+    };
+
+    /// @brief What a single RunUntil did.
+    struct SliceStats
+    {
+        std::size_t m_steps     = 0;
+        std::size_t m_completed = 0;
+        /// @brief Steps run although they did not fit, at most one per slice.
+        std::size_t m_forced = 0;
+        Clock::duration m_elapsed{};
+    };
+
+    /// @brief Time-sliced job queue for work that must not blow the frame budget (config saves, session cleanup,
+    /// snapshots, rebalancing). Long jobs are written as a step function that does a bounded piece of work per call
+    /// and keeps its progress in its captures.
+    ///
+    /// RunUntil runs steps of the most urgent job (priority first, then the earliest deadline) until the frame ends.
+    /// Every job remembers how long its steps took recently, a step is only started if that estimate still fits into the
+    /// frame, so steps of roughly even size never make a frame late. A job whose step does not fit is passed over for the
+    /// next one that does. Once a job was passed over for max_passed_over frames in a row, one of its steps runs anyway,
+    /// so frames that are always late or a step larger than any frame delay jobs rather than starving them. Main thread only.
+    class FrameScheduler
+    {
+    public:
+        using JobId = uint64_t;
+        /// @brief Reads the current time. The steady clock, unless a test drives the scheduler with time of its own.
+        using TimeSource = std::function< Clock::time_point() >;
+
+        /// @brief Frames a job is passed over at most by default, about 70 ms at 120 Hz.
+        static constexpr uint32_t DefaultMaxPassedOver = 8;
+
+        explicit FrameScheduler( metrics::Registry & registry, uint32_t max_passed_over = DefaultMaxPassedOver, TimeSource now = Clock::now );
+
+        FrameScheduler( const FrameScheduler & )             = delete;
+        FrameScheduler & operator=( const FrameScheduler & ) = delete;
+
+        JobId Submit( JobSettings settings, std::function< StepResult() > step );
+        /// @return False if the job already finished or never existed.
+        bool Cancel( JobId id );
+        /// @return True while the job waits or is in progress.
+        [[nodiscard]] bool IsQueued( JobId id ) const noexcept;
+
+        /// @param lowest_priority Jobs of a lower priority wait for a later frame, e.g. while the broker is overloaded. They
+        /// are not passed over, so they do not run past frame_end either.
+        SliceStats RunUntil( Clock::time_point frame_end, JobPriority lowest_priority = JobPriority::Low );
+
+        /// @brief Jobs submitted and not yet done.
+        [[nodiscard]] std::size_t Backlog() const noexcept
+        {
+            return m_jobs.size();
+        }
+
+        [[nodiscard]] uint64_t DeadlineMisses() const noexcept
+        {
+            return m_deadline_misses;
+        }
+
+    private:
+        struct Job
+        {
+            JobId m_id = 0;
+            JobSettings m_settings;
+            /// @brief Absolute deadline, time_point::max() for none.
+            Clock::time_point m_deadline;
+            std::function< StepResult() > m_step;
+            /// @brief Recent step duration, decays slowly so a single fast step does not hide the usual cost.
+            Clock::duration m_step_estimate{};
+            /// @brief Consecutive frames in which the job could have run and did not.
+            uint32_t m_passed_over = 0;
+            bool m_stepped         = false;
+            bool m_missed          = false;
+        };
+
+        void CountMisses( Clock::time_point now );
+
+        /// @brief Sorted by urgency, the front runs next.
+        std::vector< Job > m_jobs;
+        JobId m_next_id            = 1;
+        uint64_t m_deadline_misses = 0;
+        uint32_t m_max_passed_over = DefaultMaxPassedOver;
+        TimeSource m_now;
+
+        metrics::Gauge & m_backlog_gauge;
+        metrics::Counter & m_misses_counter;
+        metrics::Counter & m_steps_counter;
+        metrics::Counter & m_forced_steps_counter;
+        metrics::Histogram & m_slice_duration;
+    };
+} // namespace shm::sched
@@ -0,0 +1,289 @@
+#include "Tracing.hpp"
+
+#include "filesystem/Filesystem.hpp"
+
+#include <flecs.h>
+#include <fmt/format.h>
+#include <spdlog/details/os.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        uint64_t m_begin      = 0;
+        uint64_t m_end        = 0;
+        uint8_t m_name_length = 0;
+        std::array< char, 47 > m_name{};
+    };
+    static_assert( sizeof( Event ) == 64 );
+
+    /// @brief Single-producer ring, only the owning thread writes, dumps read whatever is published by m_head.
+    struct ThreadBuffer
+    {
+        std::atomic< std::size_t > m_thread_id{ 0 };
+        std::atomic< uint64_t > m_head{ 0 };
+        std::atomic< uint64_t > m_tail{ 0 };
+        bool m_owned = true; ///< Guarded by G_BUFFERS_MUTEX.
+        std::array< Event, shm::trace::RingBufferCapacity > m_events;
+    };
+
+    std::mutex G_BUFFERS_MUTEX;
+    std::vector< std::shared_ptr< ThreadBuffer > > G_BUFFERS;
+    std::atomic< bool > G_DUMP_REQUESTED{ false };
+
+    /// @brief Reference point pairing a Timestamp() with the steady clock, taken when tracing gets enabled.
+    std::atomic< uint64_t > G_CALIBRATION_TICKS{ 0 };
+    std::atomic< int64_t > G_CALIBRATION_NS{ 0 };
+
+    int64_t SteadyNowNs() noexcept
+    {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    void Calibrate() noexcept
+    {
+        G_CALIBRATION_TICKS.store( shm::trace::Timestamp(), std::memory_order_relaxed );
+        G_CALIBRATION_NS.store( SteadyNowNs(), std::memory_order_relaxed );
+    }
+
+    /// @brief Maps timestamps to steady clock nanoseconds using the calibration point and the current time.
+    struct TimestampConverter
+    {
+        TimestampConverter()
+        {
+#if defined( _M_X64 ) || defined( __x86_64__ )
+            // Short calibration windows give a poor tick rate estimate, dumps are rare enough to wait for a better one.
+            constexpr int64_t min_window_ns = 10'000'000;
+            if ( SteadyNowNs() - G_CALIBRATION_NS.load( std::memory_order_relaxed ) < min_window_ns )
+                std::this_thread::sleep_for( std::chrono::nanoseconds( min_window_ns ) );
+
+            m_base_ticks         = G_CALIBRATION_TICKS.load( std::memory_order_relaxed );
+            m_base_ns            = G_CALIBRATION_NS.load( std::memory_order_relaxed );
+            const auto now_ticks = shm::trace::Timestamp();
+            const auto now_ns    = SteadyNowNs();
+            if ( now_ticks > m_base_ticks )
+                m_ns_per_tick = static_cast< double >( now_ns - m_base_ns ) / static_cast< double >( now_ticks - m_base_ticks );
+#endif
+        }
+
+        double ToMicroseconds( uint64_t timestamp ) const noexcept
+        {
+            const auto delta = static_cast< double >( static_cast< int64_t >( timestamp - m_base_ticks ) );
+            return ( static_cast< double >( m_base_ns ) + delta * m_ns_per_tick ) / 1000.0;
+        }
+
+        double DurationMicroseconds( uint64_t begin, uint64_t end ) const noexcept
+        {
+            return static_cast< double >( end - begin ) * m_ns_per_tick / 1000.0;
+        }
+
+        uint64_t m_base_ticks = 0;
+        int64_t m_base_ns     = 0;
+        double m_ns_per_tick  = 1.0;
+    };
+
+    /// @brief Releases the buffer of the calling thread when it exits.
+    struct BufferOwner
+    {
+        ThreadBuffer * m_buffer = nullptr;
+
+        ~BufferOwner()
+        {
+            if ( !m_buffer )
+                return;
+            std::scoped_lock lock( G_BUFFERS_MUTEX );
+            m_buffer->m_owned = false;
+        }
+    };
+
+    /// @brief Buffers stay in the global list so spans of threads that already exited can still be dumped, until a
+    /// new thread takes the buffer over. This bounds the memory to the peak number of concurrent threads.
+    ThreadBuffer & LocalBuffer()
+    {
+        static thread_local BufferOwner S_OWNER;
+        if ( !S_OWNER.m_buffer ) [[unlikely]]
+        {
+            const auto thread_id = spdlog::details::os::thread_id();
+            std::scoped_lock lock( G_BUFFERS_MUTEX );
+            const auto released = std::ranges::find_if( G_BUFFERS, []( const auto & buffer ) { return !buffer->m_owned; } );
+            if ( released != G_BUFFERS.end() )
+            {
+                ThreadBuffer & buffer = **released;
+                buffer.m_owned        = true;
+                // Spans of the previous owner would otherwise be attributed to this thread.
+                buffer.m_tail.store( buffer.m_head.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+                buffer.m_thread_id.store( thread_id, std::memory_order_relaxed );
+                S_OWNER.m_buffer = &buffer;
+            }
+            else
+            {
+                auto buffer         = std::make_shared< ThreadBuffer >();
+                buffer->m_thread_id = thread_id;
+                S_OWNER.m_buffer    = G_BUFFERS.emplace_back( std::move( buffer ) ).get();
+            }
+        }
+        return *S_OWNER.m_buffer;
+    }
+
+    void AppendEscaped( std::string & out, std::string_view text )
+    {
+        for ( const char c : text )
+        {
+            switch ( c )
+            {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                default:
+                    if ( static_cast< unsigned char >( c ) < 0x20 )
+                        fmt::format_to( std::back_inserter( out ), "\\u{:04x}", static_cast< unsigned >( c ) );
+                    else
+                        out += c;
+            }
+        }
+    }
+
+#ifdef FLECS_PERF_TRACE
+    constexpr std::size_t G_MAX_FLECS_DEPTH = 64;
+    thread_local std::array< uint64_t, G_MAX_FLECS_DEPTH > S_FLECS_BEGIN{};
+    thread_local std::size_t S_FLECS_DEPTH = 0;
+
+    void FlecsTracePush( const char *, size_t, const char * )
+    {
+        if ( S_FLECS_DEPTH < G_MAX_FLECS_DEPTH )
+            S_FLECS_BEGIN[ S_FLECS_DEPTH ] = shm::trace::IsEnabled() ? shm::trace::Timestamp() : 0;
+        ++S_FLECS_DEPTH;
+    }
+
+    void FlecsTracePop( const char *, size_t, const char * name )
+    {
+        if ( S_FLECS_DEPTH == 0 )
+            return;
+
+        --S_FLECS_DEPTH;
+        if ( S_FLECS_DEPTH < G_MAX_FLECS_DEPTH && S_FLECS_BEGIN[ S_FLECS_DEPTH ] != 0 )
+            shm::trace::detail::RecordSpan( name ? name : "flecs", S_FLECS_BEGIN[ S_FLECS_DEPTH ], shm::trace::Timestamp() );
+    }
+#endif
+
+#ifndef _WIN32
+    void OnDumpSignal( int )
+    {
+        shm::trace::RequestDump();
+    }
+#endif
+} // namespace
+
+namespace shm::trace
+{
+    std::atomic< bool > detail::G_TRACING_ENABLED{ false };
+
+    void detail::RecordSpan( std::string_view name, uint64_t begin, uint64_t end ) noexcept
+    {
+        ThreadBuffer & buffer = LocalBuffer();
+        const uint64_t head   = buffer.m_head.load( std::memory_order_relaxed );
+
+        Event & event       = buffer.m_events[ head % RingBufferCapacity ];
+        event.m_begin       = begin;
+        event.m_end         = end;
+        event.m_name_length = static_cast< uint8_t >( std::min( name.size(), event.m_name.size() ) );
+        std::copy_n( name.data(), event.m_name_length, event.m_name.data() );
+
+        buffer.m_head.store( head + 1, std::memory_order_release );
+    }
+
+    void SetEnabled( bool enabled ) noexcept
+    {
+        if ( enabled && !IsEnabled() )
+            Calibrate();
+        detail::G_TRACING_ENABLED.store( enabled, std::memory_order_relaxed );
+    }
+
+    shm::Result< void > DumpChromeTrace( const std::filesystem::path & path )
+    {
+        std::vector< std::shared_ptr< ThreadBuffer > > buffers;
+        {
+            std::scoped_lock lock( G_BUFFERS_MUTEX );
+            buffers = G_BUFFERS;
+        }
+
+        const TimestampConverter converter;
+        std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+        bool first      = true;
+        for ( const auto & buffer : buffers )
+        {
+            const uint64_t head  = buffer->m_head.load( std::memory_order_acquire );
+            const uint64_t tail  = buffer->m_tail.load( std::memory_order_relaxed );
+            const uint64_t begin = std::max( tail, head > RingBufferCapacity ? head - RingBufferCapacity : 0 );
+            for ( uint64_t i = begin; i < head; ++i )
+            {
+                const Event & event = buffer->m_events[ i % RingBufferCapacity ];
+                out += first ? "\n" : ",\n";
+                first = false;
+
+                out += R"({"name":")";
+                AppendEscaped( out, std::string_view( event.m_name.data(), event.m_name_length ) );
+                fmt::format_to( std::back_inserter( out ), R"(","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                                buffer->m_thread_id.load( std::memory_order_relaxed ),
+                                converter.ToMicroseconds( event.m_begin ),
+                                converter.DurationMicroseconds( event.m_begin, event.m_end ) );
+            }
+        }
+        out += "\n]}\n";
+
+        if ( path.has_parent_path() )
+        {
+            auto dir_result = shm::fs::CreateDirectories( path.parent_path() );
+            if ( !dir_result.has_value() )
+                return dir_result;
+        }
+        return shm::fs::WriteStringToFile( path, out, std::ios::out | std::ios::trunc );
+    }
+
+    void Clear() noexcept
+    {
+        std::scoped_lock lock( G_BUFFERS_MUTEX );
+        for ( auto & buffer : G_BUFFERS )
+            buffer->m_tail.store( buffer->m_head.load( std::memory_order_acquire ), std::memory_order_relaxed );
+    }
+
+    void RequestDump() noexcept
+    {
+        G_DUMP_REQUESTED.store( true, std::memory_order_relaxed );
+    }
+
+    bool ConsumeDumpRequest() noexcept
+    {
+        return G_DUMP_REQUESTED.exchange( false, std::memory_order_relaxed );
+    }
+
+    void InstallDumpSignalHandler()
+    {
+#ifndef _WIN32
+        std::signal( SIGUSR1, &OnDumpSignal );
+#endif
+    }
+
+    bool InstrumentFlecs( flecs::world & )
+    {
+#ifdef FLECS_PERF_TRACE
+        ecs_os_api.perf_trace_push_ = &FlecsTracePush;
+        ecs_os_api.perf_trace_pop_  = &FlecsTracePop;
+        return true;
+#else
+        return false;
+#endif
+    }
+} // namespace shm::trace
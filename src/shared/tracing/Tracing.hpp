@@ -0,0 +1,101 @@
+#pragma once
+
+#include "results/Result.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#if defined( _M_X64 )
+#include <intrin.h>
+#elif defined( __x86_64__ )
+#include <x86intrin.h>
+#endif
+
+namespace flecs
+{
+    struct world;
+}
+
+namespace shm::trace
+{
+    namespace detail
+    {
+        extern std::atomic< bool > G_TRACING_ENABLED;
+
+        void RecordSpan( std::string_view name, uint64_t begin, uint64_t end ) noexcept;
+    } // namespace detail
+
+    /// @brief Number of spans kept per thread, older spans are overwritten.
+    constexpr std::size_t RingBufferCapacity = 16384;
+
+    /// @brief The only check done on the hot path when tracing is off.
+    [[nodiscard]] inline bool IsEnabled() noexcept
+    {
+        return detail::G_TRACING_ENABLED.load( std::memory_order_relaxed );
+    }
+
+    /// @brief Enabling also (re)starts the calibration of Timestamp() ticks against the steady clock.
+    void SetEnabled( bool enabled ) noexcept;
+
+    /// @return Raw timestamp spans are recorded with. On x86-64 this is the TSC, converted to nanoseconds
+    /// only when dumping, which keeps a span well below the cost of two steady_clock reads.
+    [[nodiscard]] inline uint64_t Timestamp() noexcept
+    {
+#if defined( _M_X64 ) || defined( __x86_64__ )
+        return __rdtsc();
+#else
+        return static_cast< uint64_t >( std::chrono::steady_clock::now().time_since_epoch().count() );
+#endif
+    }
+
+    /// @brief RAII span. Records begin/end timestamps into the calling thread's ring buffer when tracing is enabled.
+    /// The name is copied (and truncated) on destruction, so it only has to outlive the span.
+    class Span
+    {
+    public:
+        explicit Span( std::string_view name ) noexcept
+            : m_name( name )
+        {
+            if ( IsEnabled() ) [[unlikely]]
+                m_begin = Timestamp();
+        }
+
+        ~Span()
+        {
+            if ( m_begin != 0 ) [[unlikely]]
+                detail::RecordSpan( m_name, m_begin, Timestamp() );
+        }
+
+        Span( const Span & )             = delete;
+        Span & operator=( const Span & ) = delete;
+        Span( Span && )                  = delete;
+        Span & operator=( Span && )      = delete;
+
+    private:
+        std::string_view m_name;
+        uint64_t m_begin = 0;
+    };
+
+    /// @brief Writes the spans of all threads in Chrome trace event format (loadable by chrome://tracing and Perfetto).
+    /// Spans recorded concurrently with the dump may be missing or, for the oldest slots of a full ring, torn. Spans of an
+    /// exited thread are kept until a new thread takes its ring over.
+    shm::Result< void > DumpChromeTrace( const std::filesystem::path & path );
+
+    /// @brief Drops every recorded span.
+    void Clear() noexcept;
+
+    /// @brief Async-signal-safe: flags a dump request that the main loop picks up through ConsumeDumpRequest().
+    void RequestDump() noexcept;
+    [[nodiscard]] bool ConsumeDumpRequest() noexcept;
+
+    /// @brief On POSIX installs a SIGUSR1 handler calling RequestDump(). No-op elsewhere.
+    void InstallDumpSignalHandler();
+
+    /// @brief Wraps the execution of every flecs system in a span.
+    /// Relies on the flecs perf-trace hooks, so flecs has to be built with FLECS_PERF_TRACE.
+    /// @return False if the hooks are not available in this flecs build.
+    bool InstrumentFlecs( flecs::world & world );
+} // namespace shm::trace
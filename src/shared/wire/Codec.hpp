@@ -0,0 +1,297 @@
+#pragma once
+
+#include "results/Result.hpp"
+#include "strings/Utf8.hpp"
+
+#include <magic_enum/magic_enum.hpp>
+#include <rfl.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// @brief Fixed layout binary encoding of message structs for the wire protocol.
+/// The layout follows from the field types alone: fields in declaration order, scalars little endian without
+/// padding, arrays element by element, nested structs inline. The encoded size of a type is a compile-time
+/// constant, so encoding writes straight into a caller provided buffer and decoding needs no allocation.
+namespace shm::wire
+{
+    /// @brief UTF-8 string field of bounded length, encoded as a length byte followed by all Capacity bytes.
+    template< std::size_t Capacity >
+    class FixedString
+    {
+        static_assert( Capacity > 0 && Capacity <= UINT8_MAX, "The length is encoded in a single byte" );
+
+    public:
+        constexpr FixedString() = default;
+
+        /// @brief Longer text is cut at the last complete UTF-8 sequence that fits.
+        constexpr FixedString( std::string_view text ) noexcept
+        {
+            std::size_t size = std::min( text.size(), Capacity );
+            if ( size < text.size() )
+            {
+                while ( size > 0 && ( static_cast< uint8_t >( text[ size ] ) & 0xC0 ) == 0x80 )
+                    --size;
+            }
+            std::copy_n( text.data(), size, m_data.begin() );
+            m_size = static_cast< uint8_t >( size );
+        }
+
+        [[nodiscard]] constexpr std::string_view View() const noexcept
+        {
+            return { m_data.data(), m_size };
+        }
+
+        [[nodiscard]] constexpr std::size_t Size() const noexcept
+        {
+            return m_size;
+        }
+
+        constexpr bool operator==( const FixedString & other ) const noexcept
+        {
+            return View() == other.View();
+        }
+
+    private:
+        template< typename >
+        friend struct Codec;
+
+        std::array< char, Capacity > m_data{};
+        uint8_t m_size = 0;
+    };
+
+    namespace detail
+    {
+        template< typename T >
+        struct IsStdArray : std::false_type
+        {
+        };
+
+        template< typename T, std::size_t N >
+        struct IsStdArray< std::array< T, N > > : std::true_type
+        {
+        };
+
+        template< typename T >
+        struct IsFixedString : std::false_type
+        {
+        };
+
+        template< std::size_t N >
+        struct IsFixedString< FixedString< N > > : std::true_type
+        {
+        };
+
+        /// @brief Field types of a struct, taken from the pointers of its reflect-cpp view.
+        template< typename View >
+        struct FieldTypes;
+
+        template< typename... Fields >
+        struct FieldTypes< rfl::NamedTuple< Fields... > >
+        {
+            using Type = std::tuple< std::remove_cvref_t< std::remove_pointer_t< typename Fields::Type > >... >;
+        };
+
+        template< typename T >
+        using FieldTypesOf = typename FieldTypes< decltype( rfl::to_view( std::declval< T & >() ) ) >::Type;
+    } // namespace detail
+
+    template< typename T >
+    concept WireScalar = std::is_arithmetic_v< T > || std::is_enum_v< T >;
+
+    /// @brief Per type encoding, specialized for the building blocks, every other aggregate is encoded field by field.
+    template< typename T >
+    struct Codec;
+
+    /// @brief Encoded size of T in bytes.
+    template< typename T >
+    inline constexpr std::size_t WireSize = Codec< T >::Size;
+
+    template< WireScalar T >
+    struct Codec< T >
+    {
+        static constexpr std::size_t Size = sizeof( T );
+
+        static void Write( const T & value, std::byte * out ) noexcept
+        {
+            uint64_t bits = 0;
+            if constexpr ( std::is_same_v< T, float > )
+                bits = std::bit_cast< uint32_t >( value );
+            else if constexpr ( std::is_same_v< T, double > )
+                bits = std::bit_cast< uint64_t >( value );
+            else if constexpr ( std::is_enum_v< T > )
+                bits = static_cast< std::make_unsigned_t< std::underlying_type_t< T > > >( std::to_underlying( value ) );
+            else if constexpr ( std::is_same_v< T, bool > )
+                bits = value ? 1 : 0;
+            else
+                bits = static_cast< std::make_unsigned_t< T > >( value );
+            for ( std::size_t i = 0; i < Size; ++i )
+                out[ i ] = static_cast< std::byte >( bits >> ( 8 * i ) );
+        }
+
+        /// @brief Rejects bools other than 0 and 1 and values that are not an enumerator.
+        static bool Read( T & value, const std::byte * in ) noexcept
+        {
+            uint64_t bits = 0;
+            for ( std::size_t i = 0; i < Size; ++i )
+                bits |= static_cast< uint64_t >( in[ i ] ) << ( 8 * i );
+
+            if constexpr ( std::is_same_v< T, float > )
+                value = std::bit_cast< float >( static_cast< uint32_t >( bits ) );
+            else if constexpr ( std::is_same_v< T, double > )
+                value = std::bit_cast< double >( bits );
+            else if constexpr ( std::is_same_v< T, bool > )
+            {
+                if ( bits > 1 )
+                    return false;
+                value = bits != 0;
+            }
+            else if constexpr ( std::is_enum_v< T > )
+            {
+                const auto underlying = static_cast< std::underlying_type_t< T > >( bits );
+                if ( !magic_enum::enum_contains< T >( underlying ) )
+                    return false;
+                value = static_cast< T >( underlying );
+            }
+            else
+                value = static_cast< T >( bits );
+            return true;
+        }
+    };
+
+    template< typename T, std::size_t N >
+    struct Codec< std::array< T, N > >
+    {
+        static constexpr std::size_t Size = WireSize< T > * N;
+
+        static void Write( const std::array< T, N > & value, std::byte * out ) noexcept
+        {
+            for ( std::size_t i = 0; i < N; ++i )
+                Codec< T >::Write( value[ i ], out + i * WireSize< T > );
+        }
+
+        static bool Read( std::array< T, N > & value, const std::byte * in ) noexcept
+        {
+            for ( std::size_t i = 0; i < N; ++i )
+            {
+                if ( !Codec< T >::Read( value[ i ], in + i * WireSize< T > ) )
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    template< std::size_t N >
+    struct Codec< FixedString< N > >
+    {
+        static constexpr std::size_t Size = 1 + N;
+
+        static void Write( const FixedString< N > & value, std::byte * out ) noexcept
+        {
+            out[ 0 ] = static_cast< std::byte >( value.m_size );
+            std::memcpy( out + 1, value.m_data.data(), N );
+        }
+
+        /// @brief Rejects lengths over the capacity and text that is not valid UTF-8.
+        static bool Read( FixedString< N > & value, const std::byte * in ) noexcept
+        {
+            const auto size = static_cast< uint8_t >( in[ 0 ] );
+            if ( size > N || !shm::str::IsValidUtf8( std::span( in + 1, size ) ) )
+                return false;
+            value.m_size = size;
+            std::memcpy( value.m_data.data(), in + 1, N );
+            return true;
+        }
+    };
+
+    template< typename T >
+        requires( std::is_aggregate_v< T > && !detail::IsStdArray< T >::value && !detail::IsFixedString< T >::value )
+    struct Codec< T >
+    {
+        using Fields = detail::FieldTypesOf< T >;
+
+        static constexpr std::size_t Size = []< std::size_t... I >( std::index_sequence< I... > )
+        {
+            return ( std::size_t{ 0 } + ... + WireSize< std::tuple_element_t< I, Fields > > );
+        }( std::make_index_sequence< std::tuple_size_v< Fields > >{} );
+
+        static void Write( const T & value, std::byte * out ) noexcept
+        {
+            rfl::to_view( value ).apply(
+                [ &out ]( const auto & field )
+                {
+                    using Field = std::remove_cvref_t< decltype( *field.value() ) >;
+                    Codec< Field >::Write( *field.value(), out );
+                    out += WireSize< Field >;
+                } );
+        }
+
+        static bool Read( T & value, const std::byte * in ) noexcept
+        {
+            bool valid = true;
+            rfl::to_view( value ).apply(
+                [ &in, &valid ]( const auto & field )
+                {
+                    using Field = std::remove_cvref_t< decltype( *field.value() ) >;
+                    valid       = valid && Codec< Field >::Read( *field.value(), in );
+                    in += WireSize< Field >;
+                } );
+            return valid;
+        }
+    };
+
+    template< typename T >
+    void Encode( const T & value, std::span< std::byte, WireSize< T > > out ) noexcept
+    {
+        Codec< T >::Write( value, out.data() );
+    }
+
+    template< typename T >
+    [[nodiscard]] std::array< std::byte, WireSize< T > > Encode( const T & value ) noexcept
+    {
+        std::array< std::byte, WireSize< T > > bytes;
+        Codec< T >::Write( value, bytes.data() );
+        return bytes;
+    }
+
+    /// @return message_size if the bytes are not exactly WireSize< T > long, illegal_byte_sequence for a bool, enum
+    /// or string field holding something its type cannot.
+    template< typename T >
+    [[nodiscard]] shm::Result< T > Decode( std::span< const std::byte > bytes ) noexcept
+    {
+        if ( bytes.size() != WireSize< T > )
+            return std::unexpected( std::make_error_code( std::errc::message_size ) );
+
+        T value{};
+        if ( !Codec< T >::Read( value, bytes.data() ) )
+            return std::unexpected( std::make_error_code( std::errc::illegal_byte_sequence ) );
+        return value;
+    }
+} // namespace shm::wire
+
+/// @brief Lets reflect-cpp formats (JSON for logs and configs) treat fixed strings as plain strings.
+template< std::size_t N >
+struct rfl::Reflector< shm::wire::FixedString< N > >
+{
+    using ReflType = std::string;
+
+    static shm::wire::FixedString< N > to( const ReflType & text ) noexcept
+    {
+        return shm::wire::FixedString< N >( text );
+    }
+
+    static ReflType from( const shm::wire::FixedString< N > & value )
+    {
+        return ReflType( value.View() );
+    }
+};
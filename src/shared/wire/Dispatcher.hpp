@@ -0,0 +1,116 @@
+#pragma once
+
+#include "protocol/FrameHeader.hpp"
+#include "wire/Codec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace shm::wire
+{
+    /// @brief Message struct with the opcode it travels under.
+    template< typename T >
+    concept WireMessage = requires {
+        { T::Opcode } -> std::convertible_to< uint16_t >;
+    } && WireSize< T > <= UINT16_MAX;
+
+    template< WireMessage T >
+    inline constexpr std::size_t FrameSize = sizeof( protocol::FrameHeader ) + WireSize< T >;
+
+    /// @brief Encodes a message behind a frame header carrying its opcode, length and checksum.
+    template< WireMessage T >
+    [[nodiscard]] std::array< std::byte, FrameSize< T > > EncodeFrame( const T & message ) noexcept
+    {
+        std::array< std::byte, FrameSize< T > > frame;
+        const auto payload = std::span( frame ).template subspan< sizeof( protocol::FrameHeader ) >();
+        Encode( message, payload );
+
+        const protocol::FrameHeader header{
+            .m_length   = static_cast< uint16_t >( WireSize< T > ),
+            .m_opcode   = T::Opcode,
+            .m_checksum = shm::hash::Crc32c( payload ),
+        };
+        std::memcpy( frame.data(), &header, sizeof( header ) );
+        return frame;
+    }
+
+    enum class DispatchResult : uint8_t
+    {
+        Handled,
+        UnknownOpcode,
+        /// @brief Wrong size, failed checksum or a field value its type cannot hold.
+        Malformed,
+    };
+
+    /// @brief Routes payloads to Handler::On( const Message & ) by opcode. The table of decoders is built at compile
+    /// time and indexed directly by the opcode, so a dispatch is one bounds check and one indirect call into a
+    /// decoder that is specialized for its message type.
+    template< typename Handler, WireMessage... Messages >
+    class Dispatcher
+    {
+        static_assert( sizeof...( Messages ) > 0 );
+
+        using Entry = DispatchResult ( * )( Handler &, std::span< const std::byte > );
+
+        static constexpr uint16_t MinOpcode = std::min( { static_cast< uint16_t >( Messages::Opcode )... } );
+        static constexpr uint16_t MaxOpcode = std::max( { static_cast< uint16_t >( Messages::Opcode )... } );
+        static constexpr uint16_t MinSize   = static_cast< uint16_t >( std::min( { WireSize< Messages >... } ) );
+        static constexpr uint16_t MaxSize   = static_cast< uint16_t >( std::max( { WireSize< Messages >... } ) );
+
+        template< typename Message >
+        static DispatchResult Decode( Handler & handler, std::span< const std::byte > payload )
+        {
+            if ( payload.size() != WireSize< Message > )
+                return DispatchResult::Malformed;
+
+            Message message{};
+            if ( !Codec< Message >::Read( message, payload.data() ) )
+                return DispatchResult::Malformed;
+            handler.On( std::as_const( message ) );
+            return DispatchResult::Handled;
+        }
+
+        static constexpr std::array< Entry, MaxOpcode + 1 > Table = []
+        {
+            std::array< Entry, MaxOpcode + 1 > table{};
+            ( ( table[ Messages::Opcode ] = &Decode< Messages > ), ... );
+            return table;
+        }();
+
+        static_assert( std::ranges::count_if( Table, []( Entry entry ) { return entry != nullptr; } ) == sizeof...( Messages ),
+                       "Every message needs an opcode of its own" );
+
+    public:
+        static DispatchResult Dispatch( Handler & handler, uint16_t opcode, std::span< const std::byte > payload )
+        {
+            if ( opcode > MaxOpcode || Table[ opcode ] == nullptr )
+                return DispatchResult::UnknownOpcode;
+            return Table[ opcode ]( handler, payload );
+        }
+
+        /// @brief Dispatches a whole frame, header included, after checking its length and checksum.
+        static DispatchResult DispatchFrame( Handler & handler, std::span< const std::byte > frame )
+        {
+            protocol::FrameHeader header;
+            if ( frame.size() < sizeof( header ) )
+                return DispatchResult::Malformed;
+            std::memcpy( &header, frame.data(), sizeof( header ) );
+
+            const auto payload = frame.subspan( sizeof( header ) );
+            if ( !protocol::ChecksumMatches( header, payload ) )
+                return DispatchResult::Malformed;
+            return Dispatch( handler, header.m_opcode, payload );
+        }
+
+        /// @brief Bounds of all frames this dispatcher can handle, to sort out batches with protocol::FindInvalidHeader.
+        [[nodiscard]] static constexpr protocol::FrameLimits Limits() noexcept
+        {
+            return { .m_min_length = MinSize, .m_max_length = MaxSize, .m_min_opcode = MinOpcode, .m_max_opcode = MaxOpcode };
+        }
+    };
+} // namespace shm::wire
@@ -0,0 +1,222 @@
+#include "WorldCluster.hpp"
+
+#include "journal/WorldCommands.hpp"
+
+#include <algorithm>
+#include <utility>
+
+shm::worlds::WorldCluster::WorldCluster( std::vector< WorldSettings > worlds )
+{
+    m_hosts.reserve( worlds.size() );
+    for ( auto & settings : worlds )
+    {
+        m_host_by_world[ settings.m_id ] = m_hosts.size();
+        m_hosts.push_back( std::make_unique< WorldHost >( std::move( settings ) ) );
+    }
+    m_backlog.resize( m_hosts.size() );
+}
+
+shm::worlds::WorldCluster::~WorldCluster()
+{
+    Stop();
+}
+
+void shm::worlds::WorldCluster::Start()
+{
+    for ( auto & host : m_hosts )
+        host->Start();
+}
+
+void shm::worlds::WorldCluster::Stop()
+{
+    for ( auto & host : m_hosts )
+        host->Stop();
+}
+
+void shm::worlds::WorldCluster::Adopt( const journal::WorldSnapshot & state )
+{
+    for ( const auto & entity : state.entities )
+    {
+        if ( !entity.presence )
+            continue;
+
+        auto & player      = m_players[ entity.id ];
+        player.m_session   = entity.presence->session_id;
+        player.m_world     = entity.presence->world_id;
+        player.m_transform = entity.transform.value_or( journal::Transform{} );
+        player.m_present   = true;
+        Place( entity.id, player );
+    }
+}
+
+void shm::worlds::WorldCluster::Route( std::span< const journal::WorldCommand > commands )
+{
+    using journal::CommandType;
+
+    for ( const auto & command : commands )
+    {
+        switch ( command.type )
+        {
+        case CommandType::Spawn:
+            m_players.try_emplace( command.entity );
+            break;
+        case CommandType::Destroy:
+        {
+            auto iter = m_players.find( command.entity );
+            if ( iter == m_players.end() )
+                break;
+
+            // The answer of the old world finds no player any more and is dropped.
+            if ( iter->second.m_host != NoHost )
+                Send( iter->second.m_host, { .m_type = HostCommandType::Depart, .m_entity = command.entity, .m_session = iter->second.m_session } );
+            m_players.erase( iter );
+            break;
+        }
+        case CommandType::SetTransform:
+        {
+            auto iter = m_players.find( command.entity );
+            if ( iter == m_players.end() || !command.transform )
+                break;
+
+            auto & player      = iter->second;
+            player.m_transform = *command.transform;
+            if ( player.m_in_transit )
+                player.m_moved_in_transit = true;
+            else if ( player.m_host != NoHost )
+                Send( player.m_host, { .m_type = HostCommandType::Move, .m_entity = command.entity, .m_session = player.m_session, .m_transform = player.m_transform } );
+            break;
+        }
+        case CommandType::SetPresence:
+            if ( command.presence )
+                SetPresence( command.entity, *command.presence );
+            break;
+        }
+    }
+}
+
+void shm::worlds::WorldCluster::SetPresence( uint64_t entity, const journal::Presence & presence )
+{
+    auto & player             = m_players[ entity ];
+    const bool changed_worlds = player.m_present && player.m_world != presence.world_id;
+    player.m_session          = presence.session_id;
+    player.m_world            = presence.world_id;
+    player.m_present          = true;
+
+    // A player in transit is placed into whatever world it is in once the old one answers.
+    if ( player.m_in_transit )
+        return;
+
+    if ( player.m_host == NoHost )
+    {
+        Place( entity, player );
+        return;
+    }
+
+    if ( !changed_worlds )
+        return;
+
+    Send( player.m_host, { .m_type = HostCommandType::Depart, .m_entity = entity, .m_session = player.m_session } );
+    player.m_host       = NoHost;
+    player.m_in_transit = true;
+}
+
+void shm::worlds::WorldCluster::Poll()
+{
+    for ( std::size_t host = 0; host < m_hosts.size(); ++host )
+    {
+        auto & backlog = m_backlog[ host ];
+        while ( !backlog.m_commands.empty() && m_hosts[ host ]->Post( backlog.m_commands.front() ) )
+        {
+            const auto & sent = backlog.m_commands.front();
+            if ( const auto move = backlog.m_moves.find( sent.m_entity ); move != backlog.m_moves.end() && move->second == backlog.m_front )
+                backlog.m_moves.erase( move );
+            backlog.m_commands.pop_front();
+            ++backlog.m_front;
+        }
+    }
+    m_stalled.store( std::ranges::count_if( m_backlog, []( const Backlog & backlog ) { return backlog.m_commands.size() >= StalledBacklog; } ),
+                     std::memory_order_relaxed );
+
+    for ( auto & host : m_hosts )
+    {
+        while ( auto departed = host->PollEvent() )
+        {
+            auto iter = m_players.find( departed->m_entity );
+            if ( iter == m_players.end() || !iter->second.m_in_transit )
+                continue;
+
+            auto & player = iter->second;
+            if ( !std::exchange( player.m_moved_in_transit, false ) )
+                player.m_transform = departed->m_transform;
+            player.m_in_transit = false;
+            Place( departed->m_entity, player );
+            if ( player.m_host != NoHost )
+                ++m_transfers;
+        }
+    }
+}
+
+void shm::worlds::WorldCluster::Place( uint64_t entity, Player & player )
+{
+    player.m_host = HostIndex( player.m_world );
+    if ( player.m_host == NoHost )
+        return;
+
+    Send( player.m_host, { .m_type = HostCommandType::Arrive, .m_entity = entity, .m_session = player.m_session, .m_transform = player.m_transform } );
+}
+
+void shm::worlds::WorldCluster::Send( std::size_t host, const HostCommand & command )
+{
+    // Once something waits, everything after it waits as well, a host sees the commands in the order they were routed.
+    auto & backlog = m_backlog[ host ];
+    if ( backlog.m_commands.empty() && m_hosts[ host ]->Post( command ) )
+        return;
+
+    if ( command.m_type != HostCommandType::Move )
+    {
+        // A Move queued before this command has to stay in front of it.
+        backlog.m_moves.erase( command.m_entity );
+    }
+    else if ( const auto move = backlog.m_moves.find( command.m_entity ); move != backlog.m_moves.end() )
+    {
+        // Nothing of the entity follows the queued Move, the host would only ever see the latest transform.
+        backlog.m_commands[ move->second - backlog.m_front ].m_transform = command.m_transform;
+        return;
+    }
+    else
+    {
+        backlog.m_moves.emplace( command.m_entity, backlog.m_front + backlog.m_commands.size() );
+    }
+    backlog.m_commands.push_back( command );
+}
+
+shm::worlds::ClusterStats shm::worlds::WorldCluster::Stats() const noexcept
+{
+    ClusterStats stats{ .m_transfers = m_transfers };
+    for ( const auto & [ entity, player ] : m_players )
+    {
+        if ( player.m_in_transit )
+            ++stats.m_in_transit;
+        else if ( player.m_present && player.m_host == NoHost )
+            ++stats.m_unhosted;
+    }
+    for ( const auto & backlog : m_backlog )
+    {
+        stats.m_backlog += backlog.m_commands.size();
+        if ( backlog.m_commands.size() >= StalledBacklog )
+            ++stats.m_stalled;
+    }
+    return stats;
+}
+
+shm::worlds::WorldHost * shm::worlds::WorldCluster::Find( uint32_t world_id ) const noexcept
+{
+    const auto index = HostIndex( world_id );
+    return index == NoHost ? nullptr : m_hosts[ index ].get();
+}
+
+std::size_t shm::worlds::WorldCluster::HostIndex( uint32_t world_id ) const noexcept
+{
+    const auto iter = m_host_by_world.find( world_id );
+    return iter == m_host_by_world.end() ? NoHost : iter->second;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "WorldHost.hpp"
+
+#include <atomic>
+#include <deque>
+#include <span>
+
+namespace shm::journal
+{
+    struct WorldCommand;
+    struct WorldSnapshot;
+} // namespace shm::journal
+
+namespace shm::worlds
+{
+    struct ClusterStats
+    {
+        /// @brief Players that entered a world after leaving another one.
+        uint64_t m_transfers = 0;
+        /// @brief Players whose world has no host, they wait in the coordinator world until they move to one that has.
+        std::size_t m_unhosted = 0;
+        /// @brief Players that left a world and were not handed to the next one yet.
+        std::size_t m_in_transit = 0;
+        /// @brief Commands waiting for room in the queue of their world.
+        std::size_t m_backlog = 0;
+        /// @brief Worlds with at least WorldCluster::StalledBacklog commands waiting.
+        std::size_t m_stalled = 0;
+    };
+
+    /// @brief Coordinates the hosted worlds from the tick thread. The broker world stays the coordinator world: it
+    /// holds every player and the world it is in, the cluster mirrors the commands changing it into the world hosts.
+    ///
+    /// A player changing worlds is a handoff: the old world is told to let go, answers with the last state it simulated,
+    /// and only then is the player handed to the new world. Nothing on the tick thread waits for a world, commands a
+    /// full queue does not take are kept in order and retried on the next Poll. While a Move waits, later Moves of the
+    /// same player replace its transform instead of queueing behind it, so a world that falls behind holds at most one
+    /// Move per player plus the players arriving and departing.
+    class WorldCluster
+    {
+    public:
+        /// @brief Waiting commands from which a world counts as stalled, see StalledWorlds.
+        static constexpr std::size_t StalledBacklog = 1024;
+
+        /// @param worlds One host per entry, world ids have to be unique.
+        explicit WorldCluster( std::vector< WorldSettings > worlds );
+        ~WorldCluster();
+
+        WorldCluster( const WorldCluster & )             = delete;
+        WorldCluster & operator=( const WorldCluster & ) = delete;
+
+        void Start();
+        void Stop();
+
+        /// @brief Places the players of a recovered or restored coordinator world, before anything is routed.
+        void Adopt( const journal::WorldSnapshot & state );
+        /// @brief Mirrors commands applied to the coordinator world, in the order they were applied.
+        void Route( std::span< const journal::WorldCommand > commands );
+        /// @brief Completes handoffs the old worlds answered and retries commands that did not fit, once per tick.
+        void Poll();
+
+        /// @brief Walks every player, meant for reporting rather than every tick.
+        [[nodiscard]] ClusterStats Stats() const noexcept;
+
+        /// @brief Worlds whose backlog reached StalledBacklog as of the last Poll. Safe to read from any thread.
+        [[nodiscard]] std::size_t StalledWorlds() const noexcept
+        {
+            return m_stalled.load( std::memory_order_relaxed );
+        }
+
+        [[nodiscard]] std::span< const std::unique_ptr< WorldHost > > Hosts() const noexcept
+        {
+            return m_hosts;
+        }
+
+        /// @return Nullptr if no world with that id is hosted.
+        [[nodiscard]] WorldHost * Find( uint32_t world_id ) const noexcept;
+
+    private:
+        static constexpr std::size_t NoHost = ~std::size_t{ 0 };
+
+        /// @brief A player as the coordinator last saw it.
+        struct Player
+        {
+            uint64_t m_session = 0;
+            uint32_t m_world   = 0;
+            journal::Transform m_transform;
+            /// @brief Has a presence, entities without one are not players.
+            bool m_present = false;
+            /// @brief Index of the host simulating the player, NoHost while unhosted or in transit.
+            std::size_t m_host = NoHost;
+            bool m_in_transit = false;
+            /// @brief Moved while in transit, the transform the old world answers with is stale.
+            bool m_moved_in_transit = false;
+        };
+
+        /// @brief Commands of a host its queue did not take yet.
+        struct Backlog
+        {
+            std::deque< HostCommand > m_commands;
+            /// @brief Sequence number of the front command, counting every command ever queued.
+            uint64_t m_front = 0;
+            /// @brief Per entity, the sequence number of its queued Move if no other command of the entity follows it.
+            std::unordered_map< uint64_t, uint64_t > m_moves;
+        };
+
+        void SetPresence( uint64_t entity, const journal::Presence & presence );
+        /// @brief Hands the player to the host of its world, if there is one.
+        void Place( uint64_t entity, Player & player );
+        void Send( std::size_t host, const HostCommand & command );
+        [[nodiscard]] std::size_t HostIndex( uint32_t world_id ) const noexcept;
+
+        std::vector< std::unique_ptr< WorldHost > > m_hosts;
+        std::unordered_map< uint32_t, std::size_t > m_host_by_world;
+        std::vector< Backlog > m_backlog;
+        std::unordered_map< uint64_t, Player > m_players;
+        uint64_t m_transfers = 0;
+        std::atomic< std::size_t > m_stalled = 0;
+    };
+} // namespace shm::worlds
@@ -0,0 +1,111 @@
+#include "WorldHost.hpp"
+
+#include <chrono>
+
+shm::worlds::WorldHost::WorldHost( WorldSettings settings )
+    : m_settings( std::move( settings ) )
+    , m_world( std::make_unique< flecs::world >() )
+    , m_commands( m_settings.m_queue_capacity )
+    , m_events( m_settings.m_queue_capacity )
+{
+}
+
+shm::worlds::WorldHost::~WorldHost()
+{
+    Stop();
+}
+
+void shm::worlds::WorldHost::Start()
+{
+    if ( m_thread.joinable() )
+        return;
+
+    m_thread = std::jthread( [ this ]( std::stop_token stop ) { Run( stop ); } );
+}
+
+void shm::worlds::WorldHost::Stop()
+{
+    if ( !m_thread.joinable() )
+        return;
+
+    m_thread.request_stop();
+    m_thread.join();
+}
+
+void shm::worlds::WorldHost::Run( std::stop_token stop )
+{
+    using Clock = std::chrono::steady_clock;
+    const auto period =
+        m_settings.m_tick_rate == 0 ? Clock::duration::zero() : std::chrono::duration_cast< Clock::duration >( std::chrono::seconds( 1 ) ) / m_settings.m_tick_rate;
+
+    if ( m_settings.m_setup )
+        m_settings.m_setup( *m_world );
+
+    auto next_tick = Clock::now();
+    auto last_tick = next_tick;
+    while ( !stop.stop_requested() )
+    {
+        const auto tick_start = Clock::now();
+        const auto delta_time = std::chrono::duration< float >( tick_start - last_tick ).count();
+        last_tick             = tick_start;
+
+        while ( auto command = m_commands.TryPop() )
+            Apply( *command );
+        m_world->progress( delta_time );
+        PublishEvents();
+
+        m_residents_count.store( m_residents.size(), std::memory_order_relaxed );
+        m_last_tick_ns.store( static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now() - tick_start ).count() ),
+                              std::memory_order_relaxed );
+        m_ticks.fetch_add( 1, std::memory_order_relaxed );
+
+        // Like the broker loop, a late world does not catch up on the ticks it missed.
+        next_tick += period;
+        if ( next_tick < Clock::now() )
+            next_tick = Clock::now();
+        std::this_thread::sleep_until( next_tick );
+    }
+}
+
+void shm::worlds::WorldHost::Apply( const HostCommand & command )
+{
+    switch ( command.m_type )
+    {
+    case HostCommandType::Arrive:
+    {
+        auto [ iter, inserted ] = m_residents.try_emplace( command.m_entity );
+        if ( inserted )
+            iter->second = m_world->entity();
+        iter->second.set< Resident >( { .m_entity = command.m_entity, .m_session = command.m_session } );
+        iter->second.set< journal::Transform >( command.m_transform );
+        return;
+    }
+    case HostCommandType::Move:
+    {
+        if ( auto iter = m_residents.find( command.m_entity ); iter != m_residents.end() )
+            iter->second.set< journal::Transform >( command.m_transform );
+        return;
+    }
+    case HostCommandType::Depart:
+    {
+        auto iter = m_residents.find( command.m_entity );
+        if ( iter == m_residents.end() )
+            return;
+
+        HostEvent departed{ .m_entity = command.m_entity, .m_session = command.m_session, .m_world = m_settings.m_id };
+        iter->second.get( [ & ]( const journal::Transform & transform ) { departed.m_transform = transform; } );
+        iter->second.destruct();
+        m_residents.erase( iter );
+        m_unpublished.push_back( departed );
+        return;
+    }
+    }
+}
+
+void shm::worlds::WorldHost::PublishEvents()
+{
+    std::size_t published = 0;
+    while ( published < m_unpublished.size() && m_events.TryPush( m_unpublished[ published ] ) )
+        ++published;
+    m_unpublished.erase( m_unpublished.begin(), m_unpublished.begin() + static_cast< std::ptrdiff_t >( published ) );
+}
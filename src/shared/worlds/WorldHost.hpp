@@ -0,0 +1,156 @@
+#pragma once
+
+#include "journal/WorldCommands.hpp"
+#include "threading/SpscQueue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <flecs.h>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Hosted worlds, each simulated in a flecs world of its own on a thread of its own.
+namespace shm::worlds
+{
+    struct WorldSettings
+    {
+        uint32_t m_id = 0;
+        /// @brief Names the world in logs.
+        std::string m_name;
+        /// @brief Ticks per second, 0 ticks as fast as the world allows.
+        uint32_t m_tick_rate = 120;
+        /// @brief Slots of each of the two queues to the coordinator, commands that do not fit wait on the sending side.
+        std::size_t m_queue_capacity = 4096;
+        /// @brief Runs on the host thread before the first tick, registers the systems of the world.
+        std::function< void( flecs::world & ) > m_setup;
+    };
+
+    /// @brief Component of the entities a world simulates for the coordinator.
+    struct Resident
+    {
+        /// @brief The persistent id of the player entity in the coordinator world.
+        uint64_t m_entity  = 0;
+        uint64_t m_session = 0;
+    };
+
+    enum class HostCommandType : uint8_t
+    {
+        /// @brief The player enters the world at the given transform.
+        Arrive,
+        Move,
+        /// @brief The player leaves the world, answered by a Departed event carrying its last state.
+        Depart,
+    };
+
+    struct HostCommand
+    {
+        HostCommandType m_type = HostCommandType::Arrive;
+        uint64_t m_entity      = 0;
+        uint64_t m_session     = 0;
+        journal::Transform m_transform;
+    };
+
+    struct HostEvent
+    {
+        uint64_t m_entity  = 0;
+        uint64_t m_session = 0;
+        uint32_t m_world   = 0;
+        /// @brief State of the player as the world last simulated it.
+        journal::Transform m_transform;
+    };
+
+    /// @brief Owns one flecs world and the thread ticking it at its own rate. The coordinator talks to it only through
+    /// two single producer, single consumer queues, so neither side ever waits for the other and a world that falls
+    /// behind only delays its own players.
+    class WorldHost
+    {
+    public:
+        explicit WorldHost( WorldSettings settings );
+        /// @brief Stops the thread, the world is destroyed after its last tick.
+        ~WorldHost();
+
+        WorldHost( const WorldHost & )             = delete;
+        WorldHost & operator=( const WorldHost & ) = delete;
+
+        void Start();
+        void Stop();
+
+        /// @brief Coordinator side. Applied at the start of the next tick of the world.
+        /// @return False if the queue is full, the command was not taken.
+        [[nodiscard]] bool Post( const HostCommand & command ) noexcept
+        {
+            return m_commands.TryPush( command );
+        }
+
+        /// @brief Coordinator side.
+        [[nodiscard]] std::optional< HostEvent > PollEvent() noexcept
+        {
+            return m_events.TryPop();
+        }
+
+        [[nodiscard]] uint32_t Id() const noexcept
+        {
+            return m_settings.m_id;
+        }
+
+        [[nodiscard]] const std::string & Name() const noexcept
+        {
+            return m_settings.m_name;
+        }
+
+        [[nodiscard]] uint32_t TickRate() const noexcept
+        {
+            return m_settings.m_tick_rate;
+        }
+
+        /// @brief Only safe to touch while the host is stopped.
+        [[nodiscard]] flecs::world & World() noexcept
+        {
+            return *m_world;
+        }
+
+        /// @brief Readable from any thread.
+        [[nodiscard]] uint64_t Ticks() const noexcept
+        {
+            return m_ticks.load( std::memory_order_relaxed );
+        }
+
+        /// @brief Readable from any thread.
+        [[nodiscard]] std::size_t Residents() const noexcept
+        {
+            return m_residents_count.load( std::memory_order_relaxed );
+        }
+
+        /// @brief Wall time of the last tick including its commands, readable from any thread.
+        [[nodiscard]] uint64_t LastTickNs() const noexcept
+        {
+            return m_last_tick_ns.load( std::memory_order_relaxed );
+        }
+
+    private:
+        void Run( std::stop_token stop );
+        void Apply( const HostCommand & command );
+        /// @brief Hands over departures, the ones that do not fit stay for the next tick.
+        void PublishEvents();
+
+        WorldSettings m_settings;
+        std::unique_ptr< flecs::world > m_world;
+        SpscQueue< HostCommand > m_commands;
+        SpscQueue< HostEvent > m_events;
+
+        /// @brief Only touched by the host thread once started.
+        std::unordered_map< uint64_t, flecs::entity > m_residents;
+        std::vector< HostEvent > m_unpublished;
+
+        std::atomic< uint64_t > m_ticks{ 0 };
+        std::atomic< std::size_t > m_residents_count{ 0 };
+        std::atomic< uint64_t > m_last_tick_ns{ 0 };
+        std::jthread m_thread;
+    };
+} // namespace shm::worlds
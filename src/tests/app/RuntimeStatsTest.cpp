@@ -0,0 +1,100 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "app/RuntimeStats.hpp"
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/sink.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wb
+{
+    TEST_CASE( "wb::RuntimeStatsBoard" )
+    {
+        SUBCASE( "Frame times are bucketed relative to the budget" )
+        {
+            constexpr uint64_t budget = 8'000'000;
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( 0, budget ) == 0 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( budget / 4, budget ) == 0 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( budget / 2, budget ) == 1 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( budget, budget ) == 3 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( budget + 1, budget ) == 3 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( budget * 2, budget ) == 6 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( budget * 10, budget ) == FRAME_HISTOGRAM_BUCKETS - 1 );
+            CHECK( RuntimeStatsBoard::FrameHistogramBucket( 1, 0 ) == FRAME_HISTOGRAM_BUCKETS - 1 );
+        }
+
+        SUBCASE( "Published tick stats are read back whole while the writer keeps going" )
+        {
+            RuntimeStatsBoard board;
+            std::atomic< bool > done{ false };
+            std::jthread writer(
+                [ & ]
+                {
+                    TickStats stats;
+                    for ( uint64_t tick = 1; tick <= 200'000; ++tick )
+                    {
+                        stats.m_tick          = tick;
+                        stats.m_last_frame_ns = tick * 3;
+                        stats.m_connections   = tick * 7;
+                        board.PublishTick( stats );
+                    }
+                    done.store( true );
+                } );
+
+            bool consistent = true;
+            while ( !done.load() )
+            {
+                const auto stats = board.LoadTick();
+                consistent &= stats.m_last_frame_ns == stats.m_tick * 3 && stats.m_connections == stats.m_tick * 7;
+            }
+            CHECK( consistent );
+            CHECK( board.LoadTick().m_tick == 200'000 );
+        }
+
+        SUBCASE( "Workers accumulate busy time under their registered name" )
+        {
+            RuntimeStatsBoard board;
+            const auto tick = board.RegisterWorker( "tick" );
+            const auto io   = board.RegisterWorker( "a-worker-name-longer-than-the-name-buffer" );
+            REQUIRE( board.WorkerCount() == 2 );
+            CHECK( board.WorkerName( tick ) == "tick" );
+            CHECK( board.WorkerName( io ).size() == 32 );
+
+            board.AddWorkerBusyTime( tick, 100 );
+            board.AddWorkerBusyTime( tick, 50 );
+            CHECK( board.WorkerBusyNs( tick ) == 150 );
+            CHECK( board.WorkerBusyNs( io ) == 0 );
+
+            for ( std::size_t i = 2; i < RuntimeStatsBoard::MaxWorkers; ++i )
+                board.RegisterWorker( "filler" );
+            CHECK( board.RegisterWorker( "overflow" ) == RuntimeStatsBoard::InvalidWorker );
+            board.AddWorkerBusyTime( RuntimeStatsBoard::InvalidWorker, 1 );
+        }
+
+        SUBCASE( "The warning sink keeps the most recent warnings, newest first" )
+        {
+            RuntimeStatsBoard board;
+            spdlog::logger logger( "runtime_stats_test", MakeWarningSink( board ) );
+            logger.set_level( spdlog::level::trace );
+
+            logger.info( "not a warning" );
+            CHECK( board.RecentWarnings().empty() );
+
+            for ( int i = 0; i < 20; ++i )
+                logger.warn( "warning {}", i );
+            logger.error( "an error" );
+
+            const auto warnings = board.RecentWarnings();
+            REQUIRE( warnings.size() == RuntimeStatsBoard::WarningCapacity );
+            CHECK( warnings.front().Text() == "an error" );
+            CHECK( warnings.front().m_level == static_cast< int32_t >( spdlog::level::err ) );
+            CHECK( warnings[ 1 ].Text() == "warning 19" );
+            CHECK( warnings.back().Text() == "warning 5" );
+        }
+    }
+} // namespace wb
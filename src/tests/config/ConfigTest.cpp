@@ -4,6 +4,8 @@
 
 #include "config/Config.hpp"
 
+#include <chrono>
+#include <filesystem>
 #include <future>
 
 struct TestConfig
@@ -22,6 +24,26 @@ static shm::Result< TestConfig > TestConfigMigrationFunction( std::string & /*js
     return config;
 }
 
+struct NetworkSection
+{
+    int port       = 50000;
+    int max_clients = 100;
+};
+
+struct MergeConfig
+{
+    static constexpr uint32_t ConfigVersion = 1;
+
+    int tick_rate    = 60;
+    std::string name = "broker";
+    NetworkSection network;
+};
+
+static shm::Result< MergeConfig > MergeConfigMigrationFunction( std::string & /*json_data*/, uint32_t /*from_version*/, uint32_t /*to_version*/ )
+{
+    return MergeConfig{};
+}
+
 static constexpr std::string_view G_TestConfigDir = "./Testing/Configs";
 namespace shm::cfg
 {
@@ -93,6 +115,98 @@ namespace shm::cfg
             CHECK( test_config_accessor->variable == 42 );
         }
 
+        SUBCASE( "Hot reload" )
+        {
+            shm::Config config_obj{ G_TestConfigDir };
+            auto reg_result = config_obj.RegisterConfig( TestConfig{}, "ReloadConfig", "json", &TestConfigMigrationFunction );
+            CHECK( reg_result.has_value() );
+
+            int reloaded_value = -1;
+            auto subscribe_result = config_obj.Subscribe< TestConfig >( "ReloadConfig",
+                                                                        [ &reloaded_value ]( const TestConfig & cfg )
+                                                                        {
+                                                                            reloaded_value = cfg.variable;
+                                                                        } );
+            CHECK( subscribe_result.has_value() );
+            CHECK( config_obj.ReloadChangedConfigs().empty() );
+
+            // Edited behind the broker's back, as an operator would. The write time is bumped explicitly so the change is
+            // noticed on file systems with coarse timestamps too.
+            const auto path = std::filesystem::path( G_TestConfigDir ) / "ReloadConfig.json";
+            CHECK( shm::fs::WriteStringToFile( path, R"({"variable":7})", std::ios::out | std::ios::trunc ).has_value() );
+            std::filesystem::last_write_time( path, std::filesystem::last_write_time( path ) + std::chrono::seconds( 1 ) );
+
+            auto reloaded = config_obj.ReloadChangedConfigs();
+            REQUIRE( reloaded.size() == 1 );
+            CHECK( reloaded[ 0 ].has_value() );
+            CHECK( reloaded_value == 7 );
+            CHECK( config_obj.GetConfig< const TestConfig >( "ReloadConfig" )->variable == 7 );
+            CHECK( config_obj.ReloadChangedConfigs().empty() );
+
+            // A broken file is reported and the last good value stays.
+            CHECK( shm::fs::WriteStringToFile( path, "{ not json", std::ios::out | std::ios::trunc ).has_value() );
+            std::filesystem::last_write_time( path, std::filesystem::last_write_time( path ) + std::chrono::seconds( 2 ) );
+            reloaded = config_obj.ReloadChangedConfigs();
+            REQUIRE( reloaded.size() == 1 );
+            CHECK( !reloaded[ 0 ].has_value() );
+            CHECK( config_obj.GetConfig< const TestConfig >( "ReloadConfig" )->variable == 7 );
+            std::filesystem::remove( path );
+        }
+
+        SUBCASE( "Unchanged configs are not written back" )
+        {
+            const auto path = std::filesystem::path( G_TestConfigDir ) / "UnchangedConfig.json";
+            std::filesystem::remove( path );
+
+            shm::Config config_obj{ G_TestConfigDir };
+            auto reg_result = config_obj.RegisterConfig( MergeConfig{}, "UnchangedConfig", "json", &MergeConfigMigrationFunction );
+            CHECK( reg_result.has_value() );
+
+            {
+                // Mutable access that only reads, and an edit that is undone again.
+                auto accessor = config_obj.GetConfig< MergeConfig >( "UnchangedConfig" );
+                CHECK( accessor->tick_rate == 60 );
+                accessor->network.port = 1;
+                accessor->network.port = 50000;
+            }
+
+            auto saved = config_obj.SaveDirtyConfigs();
+            REQUIRE( saved.size() == 1 );
+            CHECK( saved[ 0 ].has_value() );
+            CHECK( !std::filesystem::exists( path ) );
+        }
+
+        SUBCASE( "Edits of concurrent accessors merge per field" )
+        {
+            const auto path = std::filesystem::path( G_TestConfigDir ) / "MergedConfig.json";
+            std::filesystem::remove( path );
+
+            shm::Config config_obj{ G_TestConfigDir };
+            auto reg_result = config_obj.RegisterConfig( MergeConfig{}, "MergedConfig", "json", &MergeConfigMigrationFunction );
+            CHECK( reg_result.has_value() );
+
+            {
+                auto first                  = config_obj.GetConfig< MergeConfig >( "MergedConfig" );
+                auto second                 = config_obj.GetConfig< MergeConfig >( "MergedConfig" );
+                first->tick_rate            = 120;
+                first->network.port         = 40000;
+                second->name                = "edge";
+                second->network.max_clients = 5000;
+            }
+
+            auto saved = config_obj.SaveDirtyConfigs();
+            REQUIRE( saved.size() == 1 );
+            CHECK( saved[ 0 ].has_value() );
+            CHECK( std::filesystem::exists( path ) );
+
+            auto merged = config_obj.GetConfig< const MergeConfig >( "MergedConfig" );
+            CHECK( merged->tick_rate == 120 );
+            CHECK( merged->name == "edge" );
+            CHECK( merged->network.port == 40000 );
+            CHECK( merged->network.max_clients == 5000 );
+            std::filesystem::remove( path );
+        }
+
         SUBCASE( "Directory without ending slash" )
         {
             shm::Config config_obj{ G_TestConfigDir };
@@ -0,0 +1,107 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "crashhandler/CrashContext.hpp"
+#include "crashhandler/CrashHandler.hpp"
+#include "filesystem/Filesystem.hpp"
+
+#include <filesystem>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const std::filesystem::path G_CrashDir = "./Testing/Crashes";
+
+    std::filesystem::path FindFileWithSuffix( const std::filesystem::path & dir, std::string_view suffix )
+    {
+        std::error_code ec;
+        for ( const auto & entry : std::filesystem::directory_iterator( dir, ec ) )
+        {
+            if ( entry.path().string().ends_with( suffix ) )
+                return entry.path();
+        }
+        return {};
+    }
+} // namespace
+
+namespace fs
+{
+    TEST_CASE( "fs::CrashContext" )
+    {
+        SUBCASE( "Log lines are kept oldest first and only the most recent ones survive" )
+        {
+            auto context = std::make_unique< CrashContext >();
+            for ( std::size_t i = 0; i < CrashContext::LogCapacity + 10; ++i )
+                context->PushLogLine( "line " + std::to_string( i ), 2, static_cast< int64_t >( i ) );
+
+            const auto json = context->ToJson( "1.0" );
+            CHECK( json.find( "\"line 9\"" ) == std::string::npos );
+            const auto first = json.find( "\"line 10\"" );
+            const auto last  = json.find( "\"line " + std::to_string( CrashContext::LogCapacity + 9 ) + "\"" );
+            REQUIRE( first != std::string::npos );
+            REQUIRE( last != std::string::npos );
+            CHECK( first < last );
+        }
+
+        SUBCASE( "Tick stats and version are included, text is escaped" )
+        {
+            auto context = std::make_unique< CrashContext >();
+            context->PublishTick( { .m_unix_ms = 1, .m_tick = 77, .m_last_frame_ns = 5, .m_frame_budget_ns = 8, .m_connections = 3 } );
+            context->PushLogLine( "quote \" backslash \\ newline \n", 4, 1 );
+
+            const auto json = context->ToJson( "version \"x\"" );
+            CHECK( json.find( R"("version": "version \"x\"")" ) != std::string::npos );
+            CHECK( json.find( R"("tick": 77)" ) != std::string::npos );
+            CHECK( json.find( R"("connections": 3)" ) != std::string::npos );
+            CHECK( json.find( R"(quote \" backslash \\ newline \u000a)" ) != std::string::npos );
+        }
+    }
+
+#ifndef _WIN32
+    TEST_CASE( "fs::CrashHandler" )
+    {
+        SUBCASE( "A deliberate crash leaves a minidump and the crash context next to it" )
+        {
+            std::filesystem::remove_all( G_CrashDir );
+
+            const pid_t pid = fork();
+            REQUIRE( pid >= 0 );
+            if ( pid == 0 )
+            {
+                CrashHandler handler{ std::filesystem::path( G_CrashDir ), "crash-test-version" };
+                if ( !handler.IsInstalled() )
+                    _exit( 2 );
+
+                handler.Context().PushLogLine( "last words before the crash", 3, 1 );
+                handler.Context().PublishTick( { .m_unix_ms = 1, .m_tick = 4242, .m_connections = 7 } );
+
+                volatile int * null_pointer = nullptr;
+                *null_pointer               = 1;
+                _exit( 3 );
+            }
+
+            int status = 0;
+            REQUIRE( waitpid( pid, &status, 0 ) == pid );
+            INFO( "exit status " << status );
+            REQUIRE( WIFSIGNALED( status ) );
+            CHECK( WTERMSIG( status ) == SIGSEGV );
+
+            const auto dump = FindFileWithSuffix( G_CrashDir, ".dmp" );
+            REQUIRE( !dump.empty() );
+            CHECK( std::filesystem::file_size( dump ) > 0 );
+
+            const auto sidecar = std::filesystem::path( dump ).replace_extension( ".context.json" );
+            const auto json    = shm::fs::ReadFileToString( sidecar );
+            REQUIRE( json.has_value() );
+            CHECK( json->find( "last words before the crash" ) != std::string::npos );
+            CHECK( json->find( R"("tick": 4242)" ) != std::string::npos );
+            CHECK( json->find( "crash-test-version" ) != std::string::npos );
+        }
+    }
+#endif
+} // namespace fs
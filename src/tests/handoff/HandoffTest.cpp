@@ -0,0 +1,499 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "app/InboundHandler.hpp"
+#include "handoff/SessionHandoff.hpp"
+#include "journal/Journal.hpp"
+#include "net/Gateway.hpp"
+#include "net/Messages.hpp"
+#include "net/ReliableChannel.hpp"
+#include "net/UdpHandshake.hpp"
+#include "net/UdpServer.hpp"
+#include "net/UdpSocket.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <flecs.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::string_view G_HANDOFF_DIR = "./Testing/Handoff/";
+    constexpr std::chrono::milliseconds G_TIMEOUT{ 5000 };
+
+    std::filesystem::path CleanHandoffDir( std::string_view name )
+    {
+        const auto dir = std::filesystem::path( G_HANDOFF_DIR ) / name;
+        std::filesystem::remove_all( dir );
+        std::filesystem::create_directories( dir );
+        return dir;
+    }
+
+    /// @brief Polls until a successor asked or the timeout passed.
+    bool WaitForSuccessor( shm::handoff::HandoffListener & listener )
+    {
+        const auto deadline = Clock::now() + G_TIMEOUT;
+        while ( !listener.PollSuccessor() )
+        {
+            if ( Clock::now() >= deadline )
+                return false;
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+        return true;
+    }
+
+    /// @brief Runs the handshake with a broker ticking on another thread.
+    /// @return The connection, 0 if the broker did not accept it in time.
+    uint32_t Connect( shm::net::UdpSocket & socket, shm::net::UdpAddress server, uint32_t nonce, shm::net::MessageBufferPool & pool )
+    {
+        shm::net::UdpConnector connector( nonce );
+        std::array< shm::net::ReceivedDatagram, shm::net::UdpSocket::BatchSize > batch;
+        const auto deadline = Clock::now() + G_TIMEOUT;
+        while ( !connector.Accepted() && Clock::now() < deadline )
+        {
+            std::ignore         = socket.Queue( server, connector.Request() );
+            std::ignore         = socket.Flush( shm::net::UdpSendMode::Batched );
+            std::ignore         = socket.WaitReadable( std::chrono::milliseconds( 10 ) );
+            const auto received = socket.ReceiveBatch( pool, batch ).value_or( 0 );
+            for ( const auto & datagram : std::span( batch ).first( received ) )
+            {
+                connector.Receive( pool.Get( datagram.m_buffer )->Bytes() );
+                pool.Destroy( datagram.m_buffer );
+            }
+        }
+        return connector.Connection();
+    }
+
+    /// @brief The parts of the broker a takeover touches, ticked the way the application ticks them.
+    struct Broker
+    {
+        /// @brief Ticks without a message after which a session is dropped. Far less than the ticks the brokers run,
+        /// a successor that lost track of the tick would drop every session right away.
+        static constexpr uint64_t IdleTimeoutTicks = 200;
+
+        explicit Broker( const std::filesystem::path & journal_directory )
+            : journal( world, { .m_directory = journal_directory, .m_snapshot_interval_ticks = 0 } )
+        {
+        }
+
+        void Start( uint64_t first_tick )
+        {
+            tick    = first_tick;
+            inbound = std::make_unique< wb::InboundHandler >( journal, IdleTimeoutTicks, tick );
+            inbound->Adopt( journal.CaptureState() );
+        }
+
+        void Step()
+        {
+            udp->Receive( tick + 1 );
+            gateway.PumpTransports( tick + 1 );
+            gateway.Inbound().ForEach(
+                [ this ]( const shm::net::InboundEvent & event )
+                {
+                    if ( event.m_type == shm::net::InboundType::Connected )
+                        ++connected;
+                    inbound->Handle( event );
+                } );
+            gateway.Inbound().Clear();
+            inbound->ExpireIdle( tick + 1 );
+            ++tick;
+            journal.CommitTick( tick );
+            udp->Flush( tick );
+        }
+
+        /// @brief What wb::Application::HandOver does.
+        shm::Result< void > HandOver( shm::handoff::HandoffListener & listener )
+        {
+            udp->StopReceiving( tick + 1 );
+            const shm::handoff::SessionTable table{ .tick = tick, .udp_peers = udp->CapturePeers() };
+            journal.RequestSnapshot();
+            journal.Flush();
+            auto handed = listener.Hand( table, udp->NativeHandles(), G_TIMEOUT );
+            if ( handed.has_value() )
+                udp.reset();
+            else
+                udp->ResumeReceiving();
+            return handed;
+        }
+
+        /// @brief What wb::Application does with a handoff before its first tick.
+        shm::Result< void > TakeOver( shm::handoff::Handoff & handoff )
+        {
+            if ( auto recovered = journal.Recover(); !recovered.has_value() )
+                return std::unexpected( recovered.error() );
+            Start( handoff.m_table.tick );
+
+            auto adopted = shm::net::UdpServer::Adopt( gateway, {}, std::move( handoff.m_descriptors ), handoff.m_table.udp_peers, tick );
+            if ( !adopted.has_value() )
+                return std::unexpected( adopted.error() );
+            udp = std::move( adopted->m_server );
+            resumed = adopted->m_sessions.size() - inbound->Resume( adopted->m_sessions ).size();
+
+            auto confirmed = shm::handoff::ConfirmHandoff( handoff, G_TIMEOUT );
+            journal.CommitTick( tick );
+            return confirmed;
+        }
+
+        flecs::world world;
+        shm::journal::WorldJournal journal;
+        std::unique_ptr< wb::InboundHandler > inbound;
+        shm::net::Gateway gateway;
+        std::unique_ptr< shm::net::UdpServer > udp;
+        uint64_t tick      = 0;
+        uint64_t connected = 0;
+        uint64_t resumed   = 0;
+    };
+
+    /// @brief A player sending a position every few milliseconds. A real client gives up on a server that did not
+    /// acknowledge anything for two seconds and connects again.
+    struct Bot
+    {
+        static constexpr auto ReconnectAfter = std::chrono::seconds( 2 );
+
+        shm::net::UdpSocket socket;
+        shm::net::ReliableChannel channel{};
+        /// @brief Send time of every message not acknowledged yet, oldest first.
+        std::deque< Clock::time_point > unacked;
+        float last_sent = 0.0f;
+        bool stalled    = false;
+    };
+
+    struct Latency
+    {
+        Clock::time_point m_sent;
+        Clock::duration m_latency;
+    };
+} // namespace
+
+TEST_CASE( "shm::handoff::HandoffListener" )
+{
+    const auto dir         = CleanHandoffDir( "Listener" );
+    const auto socket_path = dir / "handoff.sock";
+    auto listener          = shm::handoff::HandoffListener::Listen( socket_path );
+    REQUIRE( listener.has_value() );
+
+    SUBCASE( "Descriptors and the session table reach the successor" )
+    {
+        auto udp = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+        REQUIRE( udp.has_value() );
+        const shm::handoff::SessionTable table{
+            .tick      = 1234,
+            .udp_peers = { { .session         = 7,
+                             .ip              = 0x7F'00'00'01,
+                             .port            = 4000,
+                             .nonce           = 5,
+                             .last_heard_tick = 1230,
+                             .channel         = { .connection = 11, .next_sequence = 3, .oldest_unacked = 2, .unacked = { { .sequence = 2, .bytes = { 1, 2 } } } },
+                             .received        = { 9, 9, 9 } } },
+        };
+
+        std::optional< shm::Result< shm::handoff::Handoff > > received;
+        shm::Result< void > confirmed;
+        std::jthread successor(
+            [ & ]()
+            {
+                received = shm::handoff::RequestHandoff( socket_path, G_TIMEOUT );
+                if ( received->has_value() )
+                    confirmed = shm::handoff::ConfirmHandoff( **received, G_TIMEOUT );
+            } );
+        REQUIRE( WaitForSuccessor( *listener ) );
+        const std::array handles{ udp->NativeHandle() };
+        REQUIRE( listener->Hand( table, handles, G_TIMEOUT ).has_value() );
+        successor.join();
+
+        REQUIRE( received.has_value() );
+        REQUIRE( received->has_value() );
+        CHECK( confirmed.has_value() );
+        auto & handoff = **received;
+        CHECK( handoff.m_table.tick == 1234 );
+        REQUIRE( handoff.m_table.udp_peers.size() == 1 );
+        const auto & peer = handoff.m_table.udp_peers.front();
+        CHECK( peer.session == 7 );
+        CHECK( peer.port == 4000 );
+        CHECK( peer.nonce == 5 );
+        CHECK( peer.last_heard_tick == 1230 );
+        CHECK( peer.channel.connection == 11 );
+        CHECK( peer.channel.next_sequence == 3 );
+        REQUIRE( peer.channel.unacked.size() == 1 );
+        CHECK( peer.channel.unacked.front().bytes == std::vector< uint8_t >{ 1, 2 } );
+        CHECK( peer.received == std::vector< uint8_t >{ 9, 9, 9 } );
+
+        // A descriptor of its own for the same socket.
+        REQUIRE( handoff.m_descriptors.size() == 1 );
+        CHECK( handoff.m_descriptors.front().Get() != udp->NativeHandle() );
+        auto adopted = shm::net::UdpSocket::Adopt( std::move( handoff.m_descriptors.front() ) );
+        REQUIRE( adopted.has_value() );
+        CHECK( adopted->LocalAddress() == udp->LocalAddress() );
+
+        // The successor listens on the path now, the old listener leaves it alone.
+        listener = shm::handoff::HandoffListener{};
+        CHECK( std::filesystem::exists( socket_path ) );
+    }
+
+    SUBCASE( "A successor that does not confirm leaves everything with the running broker" )
+    {
+        std::jthread successor( [ & ]() { std::ignore = shm::handoff::RequestHandoff( socket_path, G_TIMEOUT ); } );
+        REQUIRE( WaitForSuccessor( *listener ) );
+        CHECK_FALSE( listener->Hand( {}, {}, G_TIMEOUT ).has_value() );
+        successor.join();
+
+        // The next successor is welcome.
+        std::jthread next( [ & ]() { std::ignore = shm::handoff::RequestHandoff( socket_path, G_TIMEOUT ); } );
+        CHECK( WaitForSuccessor( *listener ) );
+        listener = shm::handoff::HandoffListener{};
+    }
+
+    SUBCASE( "A confirmation the running broker gave up on does not start the successor" )
+    {
+        std::atomic< bool > gave_up{ false };
+        shm::Result< void > confirmed;
+        std::jthread successor(
+            [ & ]()
+            {
+                auto received = shm::handoff::RequestHandoff( socket_path, G_TIMEOUT );
+                if ( !received.has_value() )
+                    return;
+                gave_up.wait( false );
+                confirmed = shm::handoff::ConfirmHandoff( *received, G_TIMEOUT );
+            } );
+        REQUIRE( WaitForSuccessor( *listener ) );
+        CHECK_FALSE( listener->Hand( {}, {}, std::chrono::milliseconds( 50 ) ).has_value() );
+        gave_up = true;
+        gave_up.notify_one();
+        successor.join();
+        CHECK_FALSE( confirmed.has_value() );
+        CHECK( std::filesystem::exists( socket_path ) );
+    }
+
+    SUBCASE( "Strangers are turned away" )
+    {
+        shm::net::UniqueFd stranger( ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+        sockaddr_un address{ .sun_family = AF_UNIX };
+        std::memcpy( address.sun_path, socket_path.c_str(), socket_path.native().size() );
+        REQUIRE( ::connect( stranger.Get(), reinterpret_cast< const sockaddr * >( &address ), sizeof( address ) ) == 0 );
+        const uint64_t garbage = 0x1234'5678'9ABC'DEF0;
+        REQUIRE( ::send( stranger.Get(), &garbage, sizeof( garbage ), MSG_NOSIGNAL ) == sizeof( garbage ) );
+
+        CHECK_FALSE( listener->PollSuccessor() );
+        CHECK_FALSE( listener->Hand( {}, {}, G_TIMEOUT ).has_value() );
+    }
+
+    SUBCASE( "A successor sending its request slowly does not block the tick" )
+    {
+        shm::net::UniqueFd successor( ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+        sockaddr_un address{ .sun_family = AF_UNIX };
+        std::memcpy( address.sun_path, socket_path.c_str(), socket_path.native().size() );
+        REQUIRE( ::connect( successor.Get(), reinterpret_cast< const sockaddr * >( &address ), sizeof( address ) ) == 0 );
+
+        const auto poll_start = Clock::now();
+        CHECK_FALSE( listener->PollSuccessor() );
+        CHECK( Clock::now() - poll_start < std::chrono::milliseconds( 100 ) );
+
+        // The request of RequestHandoff, in two parts.
+        const std::array< uint32_t, 2 > request{ 0x48'4D'48'53, shm::handoff::SessionTable::CurrentVersion };
+        REQUIRE( ::send( successor.Get(), request.data(), 4, MSG_NOSIGNAL ) == 4 );
+        CHECK_FALSE( listener->PollSuccessor() );
+        REQUIRE( ::send( successor.Get(), &request[ 1 ], 4, MSG_NOSIGNAL ) == 4 );
+        CHECK( listener->PollSuccessor() );
+    }
+
+    SUBCASE( "Only the owner may connect" )
+    {
+        const auto permissions = std::filesystem::status( socket_path ).permissions();
+        CHECK( permissions == ( std::filesystem::perms::owner_read | std::filesystem::perms::owner_write ) );
+    }
+
+    SUBCASE( "The socket file goes away with the listener" )
+    {
+        listener = shm::handoff::HandoffListener{};
+        CHECK_FALSE( std::filesystem::exists( socket_path ) );
+    }
+}
+
+TEST_CASE( "shm::handoff takeover under load" )
+{
+    constexpr std::size_t bot_count = 64;
+    const auto dir                  = CleanHandoffDir( "Takeover" );
+    const auto socket_path          = dir / "handoff.sock";
+
+    Broker old_broker( dir / "journal" );
+    REQUIRE( old_broker.journal.Recover().has_value() );
+    old_broker.Start( 0 );
+    auto udp = shm::net::UdpServer::Create( old_broker.gateway, {} );
+    REQUIRE( udp.has_value() );
+    old_broker.udp            = std::move( *udp );
+    const auto server_address = shm::net::UdpAddress::Loopback( old_broker.udp->Port() );
+    auto listener             = shm::handoff::HandoffListener::Listen( socket_path );
+    REQUIRE( listener.has_value() );
+
+    std::vector< Bot > bots;
+    for ( std::size_t i = 0; i < bot_count; ++i )
+    {
+        auto bot_socket = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+        REQUIRE( bot_socket.has_value() );
+        bots.push_back( { .socket = std::move( *bot_socket ) } );
+    }
+
+    std::atomic< bool > handed{ false };
+    shm::Result< void > hand_result;
+    std::jthread old_thread(
+        [ & ]( std::stop_token stop )
+        {
+            while ( !stop.stop_requested() )
+            {
+                old_broker.Step();
+                if ( listener->PollSuccessor() )
+                {
+                    hand_result = old_broker.HandOver( *listener );
+                    if ( hand_result.has_value() )
+                    {
+                        handed = true;
+                        return;
+                    }
+                }
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            }
+        } );
+
+    shm::net::MessageBufferPool pool;
+    for ( uint32_t i = 0; i < bots.size(); ++i )
+    {
+        const auto connection = Connect( bots[ i ].socket, server_address, i + 1, pool );
+        REQUIRE( connection != 0 );
+        bots[ i ].channel = shm::net::ReliableChannel( {}, connection );
+    }
+
+    Broker new_broker( dir / "journal" );
+    std::atomic< bool > taken_over{ false };
+    shm::Result< void > take_over_result;
+    std::jthread new_thread;
+
+    std::array< shm::net::ReceivedDatagram, shm::net::UdpSocket::BatchSize > batch;
+    std::vector< Latency > latencies;
+    std::size_t reconnects = 0;
+    const auto start       = Clock::now();
+    Clock::time_point takeover_start;
+    for ( uint64_t bot_tick = 1;; ++bot_tick )
+    {
+        const auto now     = Clock::now();
+        const auto elapsed = now - start;
+        const bool sending = elapsed < std::chrono::milliseconds( 1500 );
+        if ( !new_thread.joinable() && elapsed >= std::chrono::milliseconds( 500 ) )
+        {
+            takeover_start = now;
+            new_thread     = std::jthread(
+                [ & ]( std::stop_token stop )
+                {
+                    auto handoff = shm::handoff::RequestHandoff( socket_path, G_TIMEOUT );
+                    if ( !handoff.has_value() )
+                    {
+                        take_over_result = std::unexpected( handoff.error() );
+                        return;
+                    }
+                    take_over_result = new_broker.TakeOver( *handoff );
+                    if ( !take_over_result.has_value() )
+                        return;
+
+                    taken_over = true;
+                    while ( !stop.stop_requested() )
+                    {
+                        new_broker.Step();
+                        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                    }
+                } );
+        }
+
+        bool settled = !sending;
+        for ( std::size_t i = 0; i < bots.size(); ++i )
+        {
+            auto & bot = bots[ i ];
+            for ( auto received = bot.socket.ReceiveBatch( pool, batch ).value_or( 0 ); received != 0;
+                  received      = bot.socket.ReceiveBatch( pool, batch ).value_or( 0 ) )
+            {
+                for ( const auto & datagram : std::span( batch ).first( received ) )
+                {
+                    bot.channel.Receive( pool.Get( datagram.m_buffer )->Bytes(), []( std::span< const std::byte > ) {} );
+                    pool.Destroy( datagram.m_buffer );
+                }
+            }
+            while ( bot.unacked.size() > bot.channel.InFlight() )
+            {
+                latencies.push_back( { bot.unacked.front(), now - bot.unacked.front() } );
+                bot.unacked.pop_front();
+                bot.stalled = false;
+            }
+            if ( !bot.unacked.empty() && now - bot.unacked.front() > Bot::ReconnectAfter && !std::exchange( bot.stalled, true ) )
+                ++reconnects;
+
+            // Bots take turns, each sends every 10 ms.
+            if ( sending && ( bot_tick + i ) % 10 == 0 )
+            {
+                bot.last_sent += 1.0f;
+                if ( bot.channel.Queue( shm::wire::EncodeFrame( shm::net::msg::Move{ .x = static_cast< float >( i ), .y = bot.last_sent } ) ) )
+                    bot.unacked.push_back( now );
+                else
+                    bot.last_sent -= 1.0f;
+            }
+            bot.channel.Poll( bot_tick, [ & ]( std::span< const std::byte > datagram ) { bot.socket.Queue( server_address, datagram ); } );
+            std::ignore = bot.socket.Flush( shm::net::UdpSendMode::Batched );
+            settled     = settled && bot.unacked.empty();
+        }
+
+        if ( ( settled && taken_over ) || elapsed > std::chrono::seconds( 10 ) )
+            break;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    new_thread.request_stop();
+    new_thread.join();
+    old_thread.request_stop();
+    old_thread.join();
+
+    REQUIRE( hand_result.has_value() );
+    REQUIRE( take_over_result.has_value() );
+    CHECK( handed );
+
+    std::vector< Clock::duration > before;
+    Clock::duration worst_after{};
+    for ( const auto & latency : latencies )
+    {
+        if ( latency.m_sent < takeover_start )
+            before.push_back( latency.m_latency );
+        else
+            worst_after = std::max( worst_after, latency.m_latency );
+    }
+    REQUIRE_FALSE( before.empty() );
+    std::ranges::nth_element( before, before.begin() + before.size() / 2 );
+    const auto to_ms = []( Clock::duration duration ) { return std::chrono::duration< double, std::milli >( duration ).count(); };
+    MESSAGE( "ack latency p50 before the takeover " << to_ms( before[ before.size() / 2 ] ) << " ms, worst after it " << to_ms( worst_after )
+                                                    << " ms, " << reconnects << " reconnects" );
+
+    // Nobody noticed more than a hiccup.
+    CHECK( reconnects == 0 );
+    CHECK( worst_after < Bot::ReconnectAfter );
+
+    // Every bot kept its session and entity, and what it sent after the takeover arrived under the new session.
+    CHECK( old_broker.connected == bot_count );
+    CHECK( new_broker.connected == 0 );
+    CHECK( new_broker.resumed == bot_count );
+    CHECK( new_broker.inbound->SessionCount() == bot_count );
+    const auto state = new_broker.journal.CaptureState();
+    CHECK( state.entities.size() == bot_count );
+    for ( const auto & entity : state.entities )
+    {
+        REQUIRE( entity.transform.has_value() );
+        REQUIRE( entity.presence.has_value() );
+        const auto bot = static_cast< std::size_t >( entity.transform->x );
+        REQUIRE( bot < bot_count );
+        CHECK( entity.transform->y == bots[ bot ].last_sent );
+        CHECK( new_broker.gateway.Get( shm::net::ConnectionHandle::Unpack( entity.presence->session_id ) ) != nullptr );
+    }
+}
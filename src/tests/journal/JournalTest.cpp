@@ -0,0 +1,243 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "journal/Journal.hpp"
+
+#include <filesystem>
+#include <flecs.h>
+
+#ifdef __linux__
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    constexpr std::string_view G_JOURNAL_DIR = "./Testing/Journal/";
+
+    std::filesystem::path CleanJournalDir( std::string_view name )
+    {
+        const auto dir = std::filesystem::path( G_JOURNAL_DIR ) / name;
+        std::filesystem::remove_all( dir );
+        return dir;
+    }
+
+    /// @brief Persistent state of every entity, the way a fresh broker would see it after recovery.
+    shm::journal::WorldSnapshot Capture( const shm::journal::WorldJournal & journal )
+    {
+        return journal.World().Capture( 0, 0 );
+    }
+} // namespace
+
+namespace shm::journal
+{
+    TEST_CASE( "shm::journal::WorldJournal" )
+    {
+        SUBCASE( "Journal replay without snapshot" )
+        {
+            const auto dir = CleanJournalDir( "Replay" );
+            {
+                flecs::world world;
+                WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+                REQUIRE( journal.Recover().has_value() );
+
+                const auto player = journal.AllocateEntityId();
+                const auto gone   = journal.AllocateEntityId();
+                journal.Submit( WorldCommand::Spawn( player ) );
+                journal.Submit( WorldCommand::Spawn( gone ) );
+                journal.CommitTick( 1 );
+                journal.Submit( WorldCommand::Set( player, Transform{ 1.0f, 2.0f, 3.0f } ) );
+                journal.Submit( WorldCommand::Set( player, Presence{ .session_id = 7, .world_id = 2 } ) );
+                journal.Submit( WorldCommand::Destroy( gone ) );
+                journal.CommitTick( 2 );
+                journal.Flush();
+                CHECK( journal.WriterError().has_value() );
+            }
+
+            flecs::world world;
+            WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+            auto stats = journal.Recover();
+            REQUIRE( stats.has_value() );
+            CHECK( stats->m_replayed_records == 2 );
+            CHECK( stats->m_replayed_commands == 5 );
+            CHECK( !stats->m_truncated_tail );
+
+            const auto state = Capture( journal );
+            REQUIRE( state.entities.size() == 1 );
+            CHECK( state.entities[ 0 ].id == 1 );
+            REQUIRE( state.entities[ 0 ].transform.has_value() );
+            CHECK( state.entities[ 0 ].transform->z == 3.0f );
+            REQUIRE( state.entities[ 0 ].presence.has_value() );
+            CHECK( state.entities[ 0 ].presence->session_id == 7 );
+            CHECK( journal.AllocateEntityId() == 3 );
+        }
+
+        SUBCASE( "Snapshot plus journal tail" )
+        {
+            const auto dir = CleanJournalDir( "Snapshot" );
+            {
+                flecs::world world;
+                WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 2, .m_snapshots_kept = 1 } );
+                REQUIRE( journal.Recover().has_value() );
+
+                for ( uint64_t tick = 1; tick <= 5; ++tick )
+                {
+                    const auto id = journal.AllocateEntityId();
+                    journal.Submit( WorldCommand::Spawn( id ) );
+                    journal.Submit( WorldCommand::Set( id, Transform{ static_cast< float >( tick ), 0.0f, 0.0f } ) );
+                    journal.CommitTick( tick );
+                }
+                journal.Flush();
+            }
+
+            flecs::world world;
+            WorldJournal journal( world, { .m_directory = dir } );
+            auto stats = journal.Recover();
+            REQUIRE( stats.has_value() );
+            CHECK( stats->m_snapshot_sequence == 4 );
+            CHECK( stats->m_snapshot_entities == 4 );
+            CHECK( stats->m_replayed_records == 1 );
+            CHECK( journal.World().EntityCount() == 5 );
+
+            // Older snapshots and the segments they cover are gone.
+            std::size_t files = 0;
+            for ( const auto & entry : std::filesystem::directory_iterator( dir ) )
+            {
+                ++files;
+                CHECK( entry.path().filename().string() >= "journal-00000000000000000005" );
+            }
+            CHECK( files == 2 );
+        }
+
+        SUBCASE( "Snapshot captured across ticks" )
+        {
+            const auto dir = CleanJournalDir( "PartialSnapshot" );
+            WorldSnapshot expected;
+            {
+                flecs::world world;
+                WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0, .m_snapshots_kept = 1 } );
+                REQUIRE( journal.Recover().has_value() );
+                for ( int i = 0; i < 10; ++i )
+                {
+                    const auto id = journal.AllocateEntityId();
+                    journal.Submit( WorldCommand::Spawn( id ) );
+                    journal.Submit( WorldCommand::Set( id, Transform{ static_cast< float >( id ), 0.0f, 0.0f } ) );
+                }
+                journal.CommitTick( 1 );
+
+                journal.BeginSnapshot();
+                CHECK( !journal.ContinueSnapshot( 4 ) );
+                // Changes to entities captured already and to ones captured later.
+                journal.Submit( WorldCommand::Set( 2, Transform{ 20.0f, 0.0f, 0.0f } ) );
+                journal.Submit( WorldCommand::Destroy( 3 ) );
+                journal.Submit( WorldCommand::Set( 8, Transform{ 80.0f, 0.0f, 0.0f } ) );
+                journal.Submit( WorldCommand::Destroy( 9 ) );
+                journal.Submit( WorldCommand::Spawn( journal.AllocateEntityId() ) );
+                journal.CommitTick( 2 );
+                CHECK( !journal.ContinueSnapshot( 4 ) );
+                CHECK( journal.ContinueSnapshot( 4 ) );
+                CHECK( !journal.SnapshotInProgress() );
+                journal.Submit( WorldCommand::Set( 8, Transform{ 81.0f, 0.0f, 0.0f } ) );
+                journal.CommitTick( 3 );
+                journal.Flush();
+                expected = Capture( journal );
+            }
+
+            flecs::world world;
+            WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+            auto stats = journal.Recover();
+            REQUIRE( stats.has_value() );
+            CHECK( stats->m_snapshot_sequence == 1 );
+            CHECK( stats->m_replayed_records == 2 );
+
+            const auto state = Capture( journal );
+            REQUIRE( state.entities.size() == expected.entities.size() );
+            for ( std::size_t i = 0; i < state.entities.size(); ++i )
+            {
+                CHECK( state.entities[ i ].id == expected.entities[ i ].id );
+                REQUIRE( state.entities[ i ].transform.has_value() == expected.entities[ i ].transform.has_value() );
+                if ( state.entities[ i ].transform )
+                    CHECK( state.entities[ i ].transform->x == expected.entities[ i ].transform->x );
+            }
+        }
+
+        SUBCASE( "Torn tail is cut off" )
+        {
+            const auto dir = CleanJournalDir( "TornTail" );
+            {
+                flecs::world world;
+                WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+                REQUIRE( journal.Recover().has_value() );
+                journal.Submit( WorldCommand::Spawn( journal.AllocateEntityId() ) );
+                journal.CommitTick( 1 );
+                journal.Submit( WorldCommand::Spawn( journal.AllocateEntityId() ) );
+                journal.CommitTick( 2 );
+                journal.Flush();
+            }
+
+            const auto segment = dir / "journal-00000000000000000001.log";
+            const auto size    = std::filesystem::file_size( segment );
+            std::filesystem::resize_file( segment, size - 3 );
+
+            {
+                flecs::world world;
+                WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+                auto stats = journal.Recover();
+                REQUIRE( stats.has_value() );
+                CHECK( stats->m_truncated_tail );
+                CHECK( stats->m_replayed_records == 1 );
+                CHECK( journal.World().EntityCount() == 1 );
+            }
+
+            flecs::world world;
+            WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+            auto stats = journal.Recover();
+            REQUIRE( stats.has_value() );
+            CHECK( !stats->m_truncated_tail );
+        }
+
+#ifdef __linux__
+        SUBCASE( "Failed write leaves no torn frame behind" )
+        {
+            const auto dir = CleanJournalDir( "FailedWrite" );
+            {
+                flecs::world world;
+                WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+                REQUIRE( journal.Recover().has_value() );
+                journal.Submit( WorldCommand::Spawn( journal.AllocateEntityId() ) );
+                journal.CommitTick( 1 );
+                journal.Flush();
+
+                // Cap the file size just past the first frame so the next one is only partly written.
+                const auto segment = dir / "journal-00000000000000000001.log";
+                rlimit saved{};
+                REQUIRE( getrlimit( RLIMIT_FSIZE, &saved ) == 0 );
+                const auto previous_handler = std::signal( SIGXFSZ, SIG_IGN );
+                rlimit capped               = saved;
+                capped.rlim_cur             = std::filesystem::file_size( segment ) + 4;
+                REQUIRE( setrlimit( RLIMIT_FSIZE, &capped ) == 0 );
+
+                journal.Submit( WorldCommand::Spawn( journal.AllocateEntityId() ) );
+                journal.CommitTick( 2 );
+                journal.Flush();
+
+                setrlimit( RLIMIT_FSIZE, &saved );
+                std::signal( SIGXFSZ, previous_handler );
+                CHECK( !journal.WriterError().has_value() );
+
+                journal.Submit( WorldCommand::Spawn( journal.AllocateEntityId() ) );
+                journal.CommitTick( 3 );
+                journal.Flush();
+            }
+
+            flecs::world world;
+            WorldJournal journal( world, { .m_directory = dir, .m_snapshot_interval_ticks = 0 } );
+            auto stats = journal.Recover();
+            REQUIRE( stats.has_value() );
+            CHECK( !stats->m_truncated_tail );
+            CHECK( stats->m_replayed_records == 2 );
+            CHECK( journal.World().EntityCount() == 2 );
+        }
+#endif
+    }
+} // namespace shm::journal
@@ -3,7 +3,9 @@
 #include <doctest/doctest.h>
 
 #include "filesystem/Filesystem.hpp"
+#include "logging/FlightRecorder.hpp"
 #include "logging/Logging.hpp"
+#include "logging/RotatingFileSink.hpp"
 
 #include <filesystem>
 #include <fmt/format.h>
@@ -270,4 +272,297 @@ namespace shm::log
             CHECK( ( content.has_value() && !content->empty() ) );
         }
     }
+
+    TEST_CASE( "shm::flight" )
+    {
+        SUBCASE( "Records below the file level reach the dump only" )
+        {
+            const auto dir = SubcaseDir( "FlightRecorder" );
+            RequireCleanDir( dir );
+            shm::flight::Clear();
+            shm::LoggerSettings s;
+            s.m_log_file_path = dir.string();
+            s.m_log_file_name = "FlightRecorder.log";
+            s.m_logger_name   = "flightlogger";
+            s.m_level         = spdlog::level::info;
+            s.m_enable_stderr = false;
+            shm::Logger logger( s );
+
+            // SHM_LOG_TO is never stripped at compile time, unlike SHM_LOG_TRACE in release builds.
+            SHM_LOG_TO( shm::log::CurrentCategory(), spdlog::level::trace, "Trace record {}", 1 );
+            SHM_LOG_TO( shm::log::CurrentCategory(), spdlog::level::info, "Info record {}", 2 );
+            shm::flight::RecordFrame( 7, 2'500'000 );
+            spdlog::default_logger()->flush();
+            CHECK( logger.DumpFlightRecorder().has_value() );
+
+            const auto log_content = shm::fs::ReadFileToString( dir / s.m_log_file_name );
+            REQUIRE( log_content.has_value() );
+            CHECK( log_content->find( "Trace record 1" ) == std::string::npos );
+            CHECK( log_content->find( "Info record 2" ) != std::string::npos );
+
+            const auto dump = shm::fs::ReadFileToString( dir / "flightlogger.flight.log" );
+            REQUIRE( dump.has_value() );
+            const auto trace_pos = dump->find( "[trace@thread:" );
+            const auto info_pos  = dump->find( "Info record 2" );
+            const auto frame_pos = dump->find( "tick 7 took 2500us" );
+            CHECK( trace_pos != std::string::npos );
+            CHECK( dump->find( "Trace record 1" ) != std::string::npos );
+            CHECK( info_pos != std::string::npos );
+            CHECK( frame_pos != std::string::npos );
+            CHECK( trace_pos < info_pos );
+            CHECK( info_pos < frame_pos );
+        }
+
+        SUBCASE( "Threads are merged by time and rings keep the newest records" )
+        {
+            const auto dir = SubcaseDir( "FlightRecorderThreads" );
+            RequireCleanDir( dir );
+            shm::flight::Clear();
+
+            shm::flight::RecordFrame( 1, 1000 );
+            std::jthread( []() { shm::flight::RecordFrame( 2, 1000 ); } ).join();
+            for ( uint64_t tick = 3; tick < 3 + shm::flight::RecordsPerThread; ++tick )
+                shm::flight::RecordFrame( tick, 1000 );
+
+            const auto path = dir / "threads.flight.log";
+            REQUIRE( shm::flight::Dump( path ).has_value() );
+            const auto dump = shm::fs::ReadFileToString( path );
+            REQUIRE( dump.has_value() );
+            CHECK( dump->find( "] tick 1 took" ) == std::string::npos );
+            CHECK( dump->find( "] tick 2 took" ) < dump->find( "] tick 3 took" ) );
+            CHECK( dump->find( fmt::format( "] tick {} took", 2 + shm::flight::RecordsPerThread ) ) != std::string::npos );
+        }
+
+        SUBCASE( "Rings of exited threads are reused" )
+        {
+            const auto dir = SubcaseDir( "FlightRecorderReuse" );
+            RequireCleanDir( dir );
+            shm::flight::Clear();
+
+            // Far more threads than rings, one after the other.
+            for ( uint64_t tick = 1; tick <= 2 * shm::flight::MaxThreads; ++tick )
+                std::jthread( [ tick ]() { shm::flight::RecordFrame( tick, 1000 ); } ).join();
+
+            const auto path = dir / "reuse.flight.log";
+            REQUIRE( shm::flight::Dump( path ).has_value() );
+            const auto dump = shm::fs::ReadFileToString( path );
+            REQUIRE( dump.has_value() );
+            CHECK( dump->find( fmt::format( "] tick {} took", 2 * shm::flight::MaxThreads ) ) != std::string::npos );
+        }
+    }
+
+    TEST_CASE( "shm::LogCategory" )
+    {
+        shm::log::SetDefaultLevel( spdlog::level::info );
+        shm::log::SetCaptureLevel( spdlog::level::off );
+        shm::log::ClearCategoryLevels();
+
+        SUBCASE( "Categories follow the default level until overridden" )
+        {
+            shm::LogCategory net{ "Net" };
+            CHECK( net.Level() == spdlog::level::info );
+            CHECK( net.Route( spdlog::level::debug ) == shm::LogRoute::Drop );
+            CHECK( net.Route( spdlog::level::warn ) == shm::LogRoute::Logger );
+
+            shm::log::SetCategoryLevel( "Net", spdlog::level::debug );
+            CHECK( net.Route( spdlog::level::debug ) == shm::LogRoute::Logger );
+            CHECK( shm::DefaultLogCategory().Route( spdlog::level::debug ) == shm::LogRoute::Drop );
+            CHECK( shm::log::LowestLevel() == spdlog::level::debug );
+
+            // Overrides apply to categories created after them too.
+            shm::LogCategory late_net{ "Net" };
+            CHECK( late_net.Level() == spdlog::level::debug );
+
+            shm::log::ClearCategoryLevels();
+            CHECK( net.Level() == spdlog::level::info );
+            CHECK( shm::log::LowestLevel() == spdlog::level::info );
+        }
+
+        SUBCASE( "Records below the category level go to the flight recorder" )
+        {
+            shm::LogCategory net{ "Net" };
+            shm::log::SetCaptureLevel( spdlog::level::trace );
+            CHECK( net.Route( spdlog::level::trace ) == shm::LogRoute::FlightRecorder );
+            CHECK( net.Route( spdlog::level::info ) == shm::LogRoute::Logger );
+            shm::log::SetCaptureLevel( spdlog::level::off );
+            CHECK( net.Route( spdlog::level::trace ) == shm::LogRoute::Drop );
+        }
+
+        SUBCASE( "Scopes set the current category" )
+        {
+            shm::LogCategory net{ "Net" };
+            CHECK( &shm::log::CurrentCategory() == &shm::DefaultLogCategory() );
+            {
+                shm::LogScope net_scope{ net };
+                CHECK( &shm::log::CurrentCategory() == &net );
+                {
+                    shm::LogScope nested{ "Nested" };
+                    CHECK( &shm::log::CurrentCategory() == &net );
+                }
+            }
+            CHECK( &shm::log::CurrentCategory() == &shm::DefaultLogCategory() );
+        }
+
+        SUBCASE( "Applying a config" )
+        {
+            shm::LogCategory net{ "Net" };
+            shm::LogLevelsConfig config;
+            config.default_level       = "warning";
+            config.categories[ "Net" ] = "trace";
+            CHECK( shm::log::ApplyLevels( config ).has_value() );
+            CHECK( shm::DefaultLogCategory().Level() == spdlog::level::warn );
+            CHECK( net.Level() == spdlog::level::trace );
+
+            config.categories[ "Net" ] = "loud";
+            CHECK( !shm::log::ApplyLevels( config ).has_value() );
+            CHECK( net.Level() == spdlog::level::trace );
+
+            config.default_level.clear();
+            config.categories.clear();
+            CHECK( shm::log::ApplyLevels( config ).has_value() );
+            CHECK( shm::DefaultLogCategory().Level() == spdlog::level::warn );
+            CHECK( net.Level() == spdlog::level::warn );
+        }
+
+        shm::log::SetDefaultLevel( spdlog::level::info );
+        shm::log::ClearCategoryLevels();
+    }
+
+    TEST_CASE( "shm::RotatingFileSink" )
+    {
+        auto archived_files = []( const std::filesystem::path & dir, std::string_view suffix )
+        {
+            std::vector< std::filesystem::path > files;
+            for ( const auto & entry : std::filesystem::directory_iterator( dir ) )
+            {
+                const auto name = entry.path().filename().string();
+                if ( name.starts_with( "Segments.2" ) && name.ends_with( suffix ) )
+                    files.push_back( entry.path() );
+            }
+            return files;
+        };
+
+        auto write_lines = []( shm::RotatingFileSink & sink, int count )
+        {
+            for ( int i = 0; i < count; ++i )
+            {
+                const std::string payload = fmt::format( "line {} XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX", i );
+                sink.log( spdlog::details::log_msg( "rotation", spdlog::level::info, payload ) );
+            }
+            sink.flush();
+        };
+
+        SUBCASE( "Size rotation keeps the newest segments" )
+        {
+            const auto dir = SubcaseDir( "BackgroundRotation" );
+            RequireCleanDir( dir );
+            {
+                shm::RotatingFileSink sink( { .m_file_path = dir / "Segments.log", .m_max_file_size_bytes = 1024, .m_max_files = 3 } );
+                for ( int round = 0; round < 6; ++round )
+                {
+                    write_lines( sink, 40 );
+                    sink.WaitForArchiving();
+                    CHECK( sink.ArchiveBacklog() == 0 );
+                }
+                CHECK( std::filesystem::exists( sink.NextFilePath() ) );
+            }
+
+            CHECK( std::filesystem::exists( dir / "Segments.log" ) );
+            CHECK( !std::filesystem::exists( dir / "Segments.log.next" ) );
+            CHECK( archived_files( dir, ".log" ).size() == 3 );
+        }
+
+        SUBCASE( "Disk budget" )
+        {
+            const auto dir = SubcaseDir( "BackgroundRotationBudget" );
+            RequireCleanDir( dir );
+            {
+                shm::RotatingFileSink sink(
+                    { .m_file_path = dir / "Segments.log", .m_max_file_size_bytes = 1024, .m_max_files = 0, .m_max_total_bytes = 4096 } );
+                for ( int round = 0; round < 10; ++round )
+                {
+                    write_lines( sink, 40 );
+                    sink.WaitForArchiving();
+                }
+            }
+
+            uint64_t total = std::filesystem::file_size( dir / "Segments.log" );
+            for ( const auto & file : archived_files( dir, ".log" ) )
+                total += std::filesystem::file_size( file );
+            CHECK( total <= 4096 + 1024 );
+        }
+
+        SUBCASE( "Compressed segments" )
+        {
+            const auto dir = SubcaseDir( "BackgroundRotationZstd" );
+            RequireCleanDir( dir );
+            {
+                shm::RotatingFileSink sink( { .m_file_path = dir / "Segments.log", .m_max_file_size_bytes = 1024, .m_compress = true } );
+                write_lines( sink, 40 );
+                sink.WaitForArchiving();
+                write_lines( sink, 1 );
+                sink.WaitForArchiving();
+            }
+
+            CHECK( archived_files( dir, ".log" ).empty() );
+            CHECK( !archived_files( dir, ".log.zst" ).empty() );
+        }
+
+        SUBCASE( "Rotate on open archives the previous file" )
+        {
+            const auto dir = SubcaseDir( "BackgroundRotationOpen" );
+            RequireCleanDir( dir );
+            std::filesystem::create_directories( dir );
+            CHECK( shm::fs::WriteStringToFile( dir / "Segments.log", "previous run\n", std::ios::out | std::ios::trunc ).has_value() );
+            {
+                shm::RotatingFileSink sink( { .m_file_path = dir / "Segments.log" } );
+            }
+            CHECK( archived_files( dir, ".log" ).size() == 1 );
+            CHECK( std::filesystem::file_size( dir / "Segments.log" ) == 0 );
+        }
+
+        SUBCASE( "A rotation interrupted by a crash is finished in order" )
+        {
+            const auto dir = SubcaseDir( "BackgroundRotationCrash" );
+            RequireCleanDir( dir );
+            std::filesystem::create_directories( dir );
+            CHECK( shm::fs::WriteStringToFile( dir / "Segments.log", "older\n", std::ios::out | std::ios::trunc ).has_value() );
+            CHECK( shm::fs::WriteStringToFile( dir / "Segments.log.next", "newer\n", std::ios::out | std::ios::trunc ).has_value() );
+            {
+                shm::RotatingFileSink sink( { .m_file_path = dir / "Segments.log" } );
+            }
+
+            auto archived = archived_files( dir, ".log" );
+            std::ranges::sort( archived );
+            REQUIRE( archived.size() == 2 );
+            CHECK( shm::fs::ReadFileToString( archived[ 0 ] ).value_or( "" ) == "older\n" );
+            CHECK( shm::fs::ReadFileToString( archived[ 1 ] ).value_or( "" ) == "newer\n" );
+            CHECK( !std::filesystem::exists( dir / "Segments.log.next" ) );
+        }
+
+        SUBCASE( "Time rotation" )
+        {
+            const auto dir = SubcaseDir( "BackgroundRotationTime" );
+            RequireCleanDir( dir );
+            {
+                const auto opened = spdlog::log_clock::now();
+                shm::RotatingFileSink sink( { .m_file_path = dir / "Segments.log", .m_max_file_size_bytes = 0, .m_rotation_interval = std::chrono::seconds( 60 ) } );
+                const auto log_at = [ & ]( std::chrono::seconds after_open )
+                {
+                    sink.log( spdlog::details::log_msg( opened + after_open, {}, "rotation", spdlog::level::info, "line" ) );
+                    sink.flush();
+                    sink.WaitForArchiving();
+                };
+
+                log_at( std::chrono::seconds( 0 ) );
+                log_at( std::chrono::seconds( 59 ) );
+                CHECK( archived_files( dir, ".log" ).empty() );
+                log_at( std::chrono::seconds( 61 ) );
+                CHECK( archived_files( dir, ".log" ).size() == 1 );
+                // The interval starts over with the new file.
+                log_at( std::chrono::seconds( 62 ) );
+                CHECK( archived_files( dir, ".log" ).size() == 1 );
+            }
+        }
+    }
 } // namespace shm::log
@@ -0,0 +1,192 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "memory/SlabPool.hpp"
+#include "net/Gateway.hpp"
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Tracked
+    {
+        explicit Tracked( int value, int & alive )
+            : m_value( value )
+            , m_alive( alive )
+        {
+            ++m_alive;
+        }
+
+        ~Tracked()
+        {
+            --m_alive;
+        }
+
+        int m_value;
+        int & m_alive;
+    };
+} // namespace
+
+namespace shm::mem
+{
+    TEST_CASE( "shm::mem::SlabPool" )
+    {
+        SUBCASE( "Create, get and destroy" )
+        {
+            int alive = 0;
+            SlabPool< Tracked, 16 > pool;
+            auto handle = pool.Create( 7, alive );
+            REQUIRE( handle.IsValid() );
+            CHECK( alive == 1 );
+            REQUIRE( pool.Get( handle ) != nullptr );
+            CHECK( pool.Get( handle )->m_value == 7 );
+
+            CHECK( pool.Destroy( handle ) );
+            CHECK( alive == 0 );
+            CHECK( pool.LiveCount() == 0 );
+        }
+
+        SUBCASE( "Stale handles are rejected" )
+        {
+            int alive = 0;
+            SlabPool< Tracked, 16 > pool;
+            auto stale = pool.Create( 1, alive );
+            pool.Destroy( stale );
+
+            // the freed slot is handed out again with a new generation
+            auto fresh = pool.Create( 2, alive );
+            CHECK( fresh.m_index == stale.m_index );
+            CHECK( fresh.m_generation != stale.m_generation );
+
+            CHECK( pool.Get( stale ) == nullptr );
+            CHECK( !pool.IsAlive( stale ) );
+            CHECK( !pool.Destroy( stale ) );
+            REQUIRE( pool.Get( fresh ) != nullptr );
+            CHECK( pool.Get( fresh )->m_value == 2 );
+            CHECK( pool.Stats().m_stale_accesses >= 2 );
+        }
+
+        SUBCASE( "Capacity limit and recycling across threads" )
+        {
+            SlabPool< std::string, 16, 2 > pool;
+            std::vector< Handle< std::string > > handles;
+            for ( std::size_t i = 0; i < decltype( pool )::MaxCapacity; ++i )
+                handles.push_back( pool.Create( "value" ) );
+
+            CHECK( !pool.Create( "overflow" ).IsValid() );
+
+            // slots freed on another thread end up in its cache, a full pool has to steal them back
+            std::jthread( [ & ]
+                          {
+                              for ( auto handle : handles )
+                                  pool.Destroy( handle );
+                          } )
+                .join();
+
+            CHECK( pool.Create( "recycled" ).IsValid() );
+        }
+
+        SUBCASE( "Statistics" )
+        {
+            SlabPool< int, 16 > pool;
+            std::vector< Handle< int > > handles;
+            for ( int i = 0; i < 20; ++i )
+                handles.push_back( pool.Create( i ) );
+            for ( int i = 0; i < 15; ++i )
+                pool.Destroy( handles[ i ] );
+
+            const auto stats = pool.Stats();
+            CHECK( stats.m_live == 5 );
+            CHECK( stats.m_high_water == 20 );
+            CHECK( stats.m_slabs == 2 );
+            CHECK( stats.m_capacity == 32 );
+            CHECK( stats.m_total_allocations == 20 );
+            CHECK( stats.m_total_frees == 15 );
+            CHECK( stats.m_fragmentation == doctest::Approx( 27.0 / 32.0 ) );
+        }
+
+        SUBCASE( "Statistics while other threads create and destroy" )
+        {
+            // Small caches refill and flush all the time, which used to deadlock against Stats() taking the locks
+            // the other way round.
+            SlabPool< int, 16 > pool;
+            std::atomic< bool > stop{ false };
+            std::vector< std::jthread > workers;
+            for ( int worker = 0; worker < 2; ++worker )
+            {
+                workers.emplace_back(
+                    [ & ]
+                    {
+                        std::vector< Handle< int > > handles;
+                        while ( !stop.load( std::memory_order_relaxed ) )
+                        {
+                            for ( int i = 0; i < 200; ++i )
+                                handles.push_back( pool.Create( i ) );
+                            for ( auto handle : handles )
+                                pool.Destroy( handle );
+                            handles.clear();
+                        }
+                    } );
+            }
+
+            // Frees are read before the allocations they follow, so they can never be ahead.
+            std::size_t inconsistent = 0;
+            for ( int i = 0; i < 2000; ++i )
+            {
+                const auto frees       = pool.Stats().m_total_frees;
+                const auto allocations = pool.Stats().m_total_allocations;
+                if ( frees > allocations )
+                    ++inconsistent;
+            }
+            stop = true;
+            CHECK( inconsistent == 0 );
+        }
+
+        SUBCASE( "An empty pool is small" )
+        {
+            // The slab directory grows with the slabs rather than being reserved for MaxSlabs up front.
+            CHECK( sizeof( SlabPool< int > ) < 4096 );
+
+            SlabPool< int, 16, 1024 > pool;
+            std::vector< Handle< int > > handles;
+            for ( int i = 0; i < 16 * 300; ++i )
+                handles.push_back( pool.Create( i ) );
+            CHECK( pool.Stats().m_slabs == 300 );
+            REQUIRE( pool.Get( handles.back() ) != nullptr );
+            CHECK( *pool.Get( handles.back() ) == 16 * 300 - 1 );
+        }
+    }
+} // namespace shm::mem
+
+namespace shm::net
+{
+    TEST_CASE( "shm::net::Gateway" )
+    {
+        constexpr std::array< std::byte, 4 > payload{ std::byte{ 1 }, std::byte{ 2 }, std::byte{ 3 }, std::byte{ 4 } };
+
+        Gateway gateway;
+        auto connection = gateway.Open( "127.0.0.1:1234", 1 );
+        REQUIRE( gateway.Get( connection ) != nullptr );
+        CHECK( gateway.Get( connection )->RemoteAddress() == "127.0.0.1:1234" );
+
+        CHECK( gateway.Send( connection, payload ) );
+        CHECK( gateway.Send( connection, payload ) );
+        CHECK( gateway.Stats().m_buffers.m_live == 2 );
+
+        auto buffer = gateway.PopQueued( connection );
+        REQUIRE( gateway.GetBuffer( buffer ) != nullptr );
+        CHECK( gateway.GetBuffer( buffer )->m_size == payload.size() );
+        gateway.ReleaseBuffer( buffer );
+
+        // closing releases whatever is still queued
+        CHECK( gateway.Close( connection ) );
+        CHECK( gateway.Stats().m_buffers.m_live == 0 );
+        CHECK( gateway.ConnectionCount() == 0 );
+        CHECK( !gateway.Send( connection, payload ) );
+        CHECK( !gateway.Close( connection ) );
+    }
+} // namespace shm::net
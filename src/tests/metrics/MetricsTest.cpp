@@ -0,0 +1,119 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "filesystem/Filesystem.hpp"
+#include "metrics/Metrics.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace shm::metrics
+{
+    TEST_CASE( "shm::metrics" )
+    {
+        SUBCASE( "Counters sum all thread shards" )
+        {
+            Registry registry;
+            auto & counter = registry.GetCounter( "test_total" );
+            {
+                std::vector< std::jthread > threads;
+                for ( int t = 0; t < 12; ++t )
+                {
+                    threads.emplace_back( [ &counter ]
+                                          {
+                                              for ( int i = 0; i < 1000; ++i )
+                                                  counter.Increment();
+                                          } );
+                }
+            }
+            CHECK( counter.Value() == 12000 );
+            CHECK( &registry.GetCounter( "test_total" ) == &counter );
+        }
+
+        SUBCASE( "Histogram bucket bounds" )
+        {
+            for ( uint64_t value : { 0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull } )
+            {
+                const auto index = Histogram::BucketIndex( value );
+                REQUIRE( index < Histogram::BucketCount );
+                CHECK( Histogram::BucketLowerBound( index ) <= value );
+                CHECK( Histogram::BucketUpperBound( index ) >= value );
+            }
+        }
+
+        SUBCASE( "Histogram quantiles" )
+        {
+            Histogram histogram;
+            for ( uint64_t i = 1; i <= 10000; ++i )
+                histogram.Record( i );
+
+            const auto snapshot = histogram.Snapshot();
+            CHECK( snapshot.m_count == 10000 );
+            CHECK( snapshot.m_max == 10000 );
+            CHECK( snapshot.m_sum == 10000ull * 10001ull / 2 );
+
+            const auto p50 = static_cast< double >( snapshot.ValueAtQuantile( 0.5 ) );
+            const auto p99 = static_cast< double >( snapshot.ValueAtQuantile( 0.99 ) );
+            CHECK( p50 == doctest::Approx( 5000.0 ).epsilon( 1.0 / Histogram::SubBuckets ) );
+            CHECK( p99 == doctest::Approx( 9900.0 ).epsilon( 1.0 / Histogram::SubBuckets ) );
+            CHECK( snapshot.ValueAtQuantile( 1.0 ) == 10000 );
+        }
+
+        SUBCASE( "Prometheus export" )
+        {
+            Registry registry;
+            registry.GetCounter( "test_requests_total", "Requests" ).Increment( 3 );
+            registry.GetGauge( "test_queue_depth" ).Set( -2 );
+            registry.RegisterGaugeCallback( "test_connections", "Connections",
+                                            []() -> int64_t
+                                            {
+                                                return 42;
+                                            } );
+            registry.GetHistogram( "test_latency_ns" ).Record( 100 );
+
+            const auto dir  = std::filesystem::path( "./Testing/Metrics" );
+            const auto file = dir / "metrics.prom";
+            REQUIRE( WritePrometheusFile( registry.Snapshot(), file ).has_value() );
+
+            auto content = shm::fs::ReadFileToString( file );
+            REQUIRE( content.has_value() );
+            CHECK( content->find( "# HELP test_requests_total Requests\n" ) != std::string::npos );
+            CHECK( content->find( "# TYPE test_requests_total counter\ntest_requests_total 3\n" ) != std::string::npos );
+            CHECK( content->find( "test_queue_depth -2\n" ) != std::string::npos );
+            CHECK( content->find( "test_connections 42\n" ) != std::string::npos );
+            CHECK( content->find( "test_latency_ns_bucket{le=\"127\"} 1\n" ) != std::string::npos );
+            CHECK( content->find( "test_latency_ns_bucket{le=\"+Inf\"} 1\n" ) != std::string::npos );
+            CHECK( content->find( "test_latency_ns_count 1\n" ) != std::string::npos );
+            CHECK( !std::filesystem::exists( dir / "metrics.prom.tmp" ) );
+        }
+
+        SUBCASE( "Failed exports are reported once per interval" )
+        {
+            // A regular file where the export directory should be.
+            const auto blocker = std::filesystem::path( "./Testing/Metrics/blocker" );
+            std::filesystem::create_directories( blocker.parent_path() );
+            REQUIRE( shm::fs::WriteStringToFile( blocker, "", std::ios::out | std::ios::trunc ).has_value() );
+
+            Registry registry;
+            std::atomic< uint64_t > reports{ 0 };
+            std::atomic< uint64_t > failures{ 0 };
+            {
+                Aggregator aggregator( registry, { .m_period                = std::chrono::milliseconds( 5 ),
+                                                   .m_prometheus_file       = blocker / "metrics.prom",
+                                                   .m_on_export_error       = [ & ]( std::error_code, uint64_t count )
+                                                   {
+                                                       ++reports;
+                                                       failures += count;
+                                                   },
+                                                   .m_export_error_interval = std::chrono::hours( 1 ) } );
+                while ( !aggregator.Latest() || reports.load() == 0 )
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+            }
+            CHECK( reports.load() == 1 );
+            CHECK( failures.load() == 1 );
+        }
+    }
+} // namespace shm::metrics
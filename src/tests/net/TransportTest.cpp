@@ -0,0 +1,400 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "net/Gateway.hpp"
+#include "net/Messages.hpp"
+#include "net/ShmTransport.hpp"
+#include "net/SocketTransport.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using TransportPair = std::pair< std::unique_ptr< shm::net::ITransport >, std::unique_ptr< shm::net::ITransport > >;
+
+    enum class Kind
+    {
+        Tcp,
+        Unix,
+        Shm,
+    };
+
+    TransportPair MakePair( Kind kind, std::size_t ring_capacity = shm::net::ShmSettings{}.m_ring_capacity )
+    {
+        if ( kind == Kind::Shm )
+        {
+            auto channel = shm::net::ShmTransport::CreateChannel( ring_capacity );
+            REQUIRE( channel.has_value() );
+            auto broker = shm::net::ShmTransport::Attach( *channel, shm::net::ShmSide::Broker );
+            auto peer   = shm::net::ShmTransport::Attach( *channel, shm::net::ShmSide::Peer );
+            REQUIRE( broker.has_value() );
+            REQUIRE( peer.has_value() );
+            return { std::move( *broker ), std::move( *peer ) };
+        }
+
+        auto pair = shm::net::SocketTransport::CreatePair( kind == Kind::Tcp ? shm::net::SocketKind::TcpLoopback : shm::net::SocketKind::Unix );
+        REQUIRE( pair.has_value() );
+        return { std::move( pair->first ), std::move( pair->second ) };
+    }
+
+    auto MoveFrame( float x )
+    {
+        return shm::wire::EncodeFrame( shm::net::msg::Move{ .x = x } );
+    }
+
+    void CheckRoundTrip( Kind kind )
+    {
+        auto [ broker, peer ] = MakePair( kind );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+
+        for ( int i = 0; i < 100; ++i )
+            REQUIRE( peer->SendFrame( MoveFrame( static_cast< float >( i ) ) ).has_value() );
+        for ( int i = 0; i < 100; ++i )
+        {
+            const auto frame = broker->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+            REQUIRE( frame.has_value() );
+            CHECK( std::ranges::equal( *frame, MoveFrame( static_cast< float >( i ) ) ) );
+        }
+        CHECK( broker->ReceiveFrame( buffer, std::chrono::nanoseconds::zero() ).error() == std::errc::timed_out );
+
+        const auto reply = shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = 42 } );
+        REQUIRE( broker->SendFrame( reply ).has_value() );
+        const auto echoed = peer->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+        REQUIRE( echoed.has_value() );
+        CHECK( std::ranges::equal( *echoed, reply ) );
+    }
+
+    void CheckPeerGone( Kind kind )
+    {
+        auto [ broker, peer ] = MakePair( kind );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+
+        REQUIRE( peer->SendFrame( MoveFrame( 1.0f ) ).has_value() );
+        peer.reset();
+
+        // Frames sent before the peer left are still delivered.
+        CHECK( broker->ReceiveFrame( buffer, std::chrono::seconds( 1 ) ).has_value() );
+        CHECK( broker->ReceiveFrame( buffer, std::chrono::seconds( 1 ) ).error() == std::errc::connection_reset );
+    }
+} // namespace
+
+TEST_CASE( "shm::net::SocketTransport" )
+{
+    SUBCASE( "Frames arrive whole and in order over TCP loopback" )
+    {
+        CheckRoundTrip( Kind::Tcp );
+    }
+    SUBCASE( "Frames arrive whole and in order over a Unix socket" )
+    {
+        CheckRoundTrip( Kind::Unix );
+    }
+    SUBCASE( "A TCP peer going away is reported after its last frame" )
+    {
+        CheckPeerGone( Kind::Tcp );
+    }
+    SUBCASE( "A Unix socket peer going away is reported after its last frame" )
+    {
+        CheckPeerGone( Kind::Unix );
+    }
+
+    SUBCASE( "A peer that does not read pushes back without blocking or tearing frames" )
+    {
+        auto [ broker, peer ] = MakePair( Kind::Unix );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+        std::vector< std::byte > payload( 60'000 );
+        const auto payload_for = [ &payload ]( std::size_t index )
+        {
+            std::ranges::fill( payload, static_cast< std::byte >( index ) );
+            return std::span< const std::byte >( payload );
+        };
+
+        std::size_t sent = 0;
+        while ( true )
+        {
+            const shm::protocol::FrameHeader header{ .m_length = static_cast< uint16_t >( payload.size() ), .m_opcode = 1 };
+            const auto result = broker->SendGathered( header, payload_for( sent ) );
+            if ( !result.has_value() )
+            {
+                CHECK( result.error() == std::errc::resource_unavailable_try_again );
+                break;
+            }
+            ++sent;
+        }
+        REQUIRE( sent > 0 );
+
+        // The last frame may only be out in part, reading lets the rest follow.
+        std::size_t received = 0;
+        for ( int attempt = 0; attempt < 1000 && received < sent; ++attempt )
+        {
+            std::ignore       = broker->FlushPending();
+            const auto frame  = peer->ReceiveFrame( buffer, std::chrono::milliseconds( 10 ) );
+            if ( !frame.has_value() )
+                continue;
+            REQUIRE( frame->size() == sizeof( shm::protocol::FrameHeader ) + payload.size() );
+            CHECK( std::ranges::all_of( frame->subspan( sizeof( shm::protocol::FrameHeader ) ),
+                                        [ received ]( std::byte value ) { return value == static_cast< std::byte >( received ); } ) );
+            ++received;
+        }
+        CHECK( received == sent );
+        CHECK( broker->FlushPending().has_value() );
+    }
+}
+
+TEST_CASE( "shm::net::ShmTransport" )
+{
+    SUBCASE( "Frames arrive whole and in order" )
+    {
+        CheckRoundTrip( Kind::Shm );
+    }
+
+    SUBCASE( "A peer going away is reported after its last frame" )
+    {
+        CheckPeerGone( Kind::Shm );
+    }
+
+    SUBCASE( "Bytes that are not a frame are rejected" )
+    {
+        auto [ broker, peer ] = MakePair( Kind::Shm );
+        const auto frame      = MoveFrame( 1.0f );
+        CHECK( broker->SendFrame( std::span( frame ).first( frame.size() - 1 ) ).error() == std::errc::invalid_argument );
+        CHECK( broker->SendFrame( std::span( frame ).first( 3 ) ).error() == std::errc::invalid_argument );
+    }
+
+    SUBCASE( "A full ring pushes back until the reader catches up" )
+    {
+        auto [ broker, peer ] = MakePair( Kind::Shm, 1 );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+        const auto frame = MoveFrame( 1.0f );
+
+        std::size_t sent = 0;
+        while ( broker->SendFrame( frame ).has_value() )
+            ++sent;
+        // The smallest ring still holds the largest frame.
+        CHECK( sent == std::bit_ceil( shm::net::MaxFrameSize ) / frame.size() );
+        CHECK( broker->SendFrame( frame ).error() == std::errc::resource_unavailable_try_again );
+
+        REQUIRE( peer->ReceiveFrame( buffer, std::chrono::seconds( 1 ) ).has_value() );
+        CHECK( broker->SendFrame( frame ).has_value() );
+
+        // Everything arrives intact, including the frames wrapping around the end of the ring.
+        std::size_t received = 1;
+        while ( true )
+        {
+            const auto next = peer->ReceiveFrame( buffer, std::chrono::nanoseconds::zero() );
+            if ( !next.has_value() )
+                break;
+            CHECK( std::ranges::equal( *next, frame ) );
+            ++received;
+        }
+        CHECK( received == sent + 1 );
+    }
+
+    SUBCASE( "A sleeping reader is woken by the writer" )
+    {
+        auto channel = shm::net::ShmTransport::CreateChannel();
+        REQUIRE( channel.has_value() );
+        auto broker = shm::net::ShmTransport::Attach( *channel, shm::net::ShmSide::Broker, { .m_busy_poll = std::chrono::nanoseconds::zero() } );
+        auto peer   = shm::net::ShmTransport::Attach( *channel, shm::net::ShmSide::Peer );
+        REQUIRE( broker.has_value() );
+        REQUIRE( peer.has_value() );
+
+        std::jthread writer(
+            [ & ]
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+                std::ignore = ( *peer )->SendFrame( MoveFrame( 2.0f ) );
+            } );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+        const auto frame = ( *broker )->ReceiveFrame( buffer, std::chrono::seconds( 5 ) );
+        REQUIRE( frame.has_value() );
+        CHECK( std::ranges::equal( *frame, MoveFrame( 2.0f ) ) );
+    }
+
+    SUBCASE( "A service connecting through the listener gets a channel of its own" )
+    {
+        const auto path = std::filesystem::temp_directory_path() / "shm_transport_test.sock";
+        {
+            auto listener = shm::net::ShmListener::Listen( path );
+            REQUIRE( listener.has_value() );
+            const auto permissions = std::filesystem::status( path ).permissions();
+            CHECK( permissions == ( std::filesystem::perms::owner_read | std::filesystem::perms::owner_write ) );
+            CHECK( listener->Accept().empty() );
+
+            shm::Result< std::unique_ptr< shm::net::ShmTransport > > service;
+            std::jthread connecting( [ & ] { service = shm::net::ShmTransport::Connect( path, std::chrono::seconds( 5 ) ); } );
+            std::vector< shm::net::ShmAccepted > accepted;
+            for ( int attempt = 0; attempt < 500 && accepted.empty(); ++attempt )
+            {
+                accepted = listener->Accept();
+                std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            }
+            connecting.join();
+            REQUIRE( accepted.size() == 1 );
+            REQUIRE( service.has_value() );
+            CHECK( accepted.front().m_pid > 0 );
+
+            std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+            REQUIRE( ( *service )->SendFrame( MoveFrame( 3.0f ) ).has_value() );
+            const auto frame = accepted.front().m_transport->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+            REQUIRE( frame.has_value() );
+            CHECK( std::ranges::equal( *frame, MoveFrame( 3.0f ) ) );
+
+            const auto reply = shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = 7 } );
+            REQUIRE( accepted.front().m_transport->SendFrame( reply ).has_value() );
+            const auto echoed = ( *service )->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+            REQUIRE( echoed.has_value() );
+            CHECK( std::ranges::equal( *echoed, reply ) );
+        }
+        CHECK( !std::filesystem::exists( path ) );
+    }
+
+    SUBCASE( "Connecting without a listener fails" )
+    {
+        const auto path = std::filesystem::temp_directory_path() / "shm_transport_test_missing.sock";
+        CHECK( !shm::net::ShmTransport::Connect( path, std::chrono::milliseconds( 100 ) ).has_value() );
+    }
+}
+
+TEST_CASE( "shm::net::Gateway" )
+{
+    SUBCASE( "Attached transports feed the inbox and drain the send queue" )
+    {
+        shm::net::Gateway gateway;
+        auto [ broker, peer ] = MakePair( Kind::Shm );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+
+        const auto connection = gateway.Attach( "shm", 1, std::move( broker ) );
+        REQUIRE( connection.IsValid() );
+
+        REQUIRE( peer->SendFrame( MoveFrame( 3.0f ) ).has_value() );
+        REQUIRE( gateway.Send( connection, MoveFrame( 4.0f ) ) );
+        gateway.PumpTransports( 2 );
+
+        std::vector< shm::net::InboundType > types;
+        gateway.Inbound().ForEach(
+            [ & ]( const shm::net::InboundEvent & event )
+            {
+                CHECK( event.m_session == connection.Pack() );
+                types.push_back( event.m_type );
+                if ( event.m_type == shm::net::InboundType::Message )
+                    CHECK( std::ranges::equal( event.m_payload, MoveFrame( 3.0f ) ) );
+            } );
+        CHECK( types == std::vector{ shm::net::InboundType::Connected, shm::net::InboundType::Message } );
+        CHECK( gateway.Get( connection )->m_last_activity_tick == 2 );
+        CHECK( gateway.Get( connection )->QueuedBuffers() == 0 );
+        CHECK( gateway.Stats().m_buffers.m_live == 0 );
+
+        const auto sent = peer->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+        REQUIRE( sent.has_value() );
+        CHECK( std::ranges::equal( *sent, MoveFrame( 4.0f ) ) );
+
+        gateway.Inbound().Clear();
+        peer.reset();
+        gateway.PumpTransports( 3 );
+        types.clear();
+        gateway.Inbound().ForEach( [ & ]( const shm::net::InboundEvent & event ) { types.push_back( event.m_type ); } );
+        CHECK( types == std::vector{ shm::net::InboundType::Disconnected } );
+        CHECK( gateway.ConnectionCount() == 0 );
+    }
+
+    SUBCASE( "Flushing only sends" )
+    {
+        shm::net::Gateway gateway;
+        auto [ broker, peer ] = MakePair( Kind::Shm );
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+
+        const auto connection = gateway.Attach( "shm", 1, std::move( broker ) );
+        gateway.Inbound().Clear();
+        REQUIRE( peer->SendFrame( MoveFrame( 3.0f ) ).has_value() );
+        REQUIRE( gateway.Send( connection, MoveFrame( 4.0f ) ) );
+        gateway.FlushTransports();
+
+        CHECK( gateway.Inbound().Size() == 0 );
+        CHECK( gateway.Get( connection )->QueuedBuffers() == 0 );
+        const auto sent = peer->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+        REQUIRE( sent.has_value() );
+        CHECK( std::ranges::equal( *sent, MoveFrame( 4.0f ) ) );
+
+        // A connection closing after its last frame is closed by the flush as well.
+        REQUIRE( gateway.Send( connection, MoveFrame( 5.0f ) ) );
+        REQUIRE( gateway.CloseAfterFlush( connection ) );
+        gateway.FlushTransports();
+        CHECK( gateway.ConnectionCount() == 0 );
+        CHECK( peer->ReceiveFrame( buffer, std::chrono::seconds( 1 ) ).has_value() );
+    }
+
+    SUBCASE( "A broadcast is stored once and gathered per recipient" )
+    {
+        shm::net::Gateway gateway;
+        std::vector< std::unique_ptr< shm::net::ITransport > > peers;
+        std::vector< shm::net::ConnectionHandle > recipients;
+        for ( auto kind : { Kind::Tcp, Kind::Unix, Kind::Shm } )
+        {
+            auto [ broker, peer ] = MakePair( kind );
+            recipients.push_back( gateway.Attach( "peer", 1, std::move( broker ) ) );
+            peers.push_back( std::move( peer ) );
+        }
+        const auto stale = gateway.Open( "stale", 1 );
+        REQUIRE( gateway.Close( stale ) );
+        recipients.push_back( stale );
+
+        const auto payload = shm::wire::Encode( shm::net::msg::SetWorld{ .world_id = 9 } );
+        const auto queued  = gateway.Broadcast( recipients, shm::net::msg::SetWorld::Opcode, payload,
+                                                [ & ]( shm::net::ConnectionHandle recipient, shm::protocol::FrameHeader & header )
+                                                {
+                                                    // The checksum only covers the payload, so headers can differ per recipient.
+                                                    if ( recipient == recipients[ 1 ] )
+                                                        header.m_opcode = shm::net::msg::Move::Opcode;
+                                                } );
+        CHECK( queued == 3 );
+        CHECK( gateway.Stats().m_buffers.m_live == 1 );
+
+        gateway.PumpTransports( 2 );
+        CHECK( gateway.Stats().m_buffers.m_live == 0 );
+
+        std::vector< std::byte > buffer( shm::net::MaxFrameSize );
+        for ( std::size_t i = 0; i < peers.size(); ++i )
+        {
+            const auto frame = peers[ i ]->ReceiveFrame( buffer, std::chrono::seconds( 1 ) );
+            REQUIRE( frame.has_value() );
+            auto expected = shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = 9 } );
+            if ( i == 1 )
+            {
+                const uint16_t opcode = shm::net::msg::Move::Opcode;
+                std::memcpy( expected.data() + offsetof( shm::protocol::FrameHeader, m_opcode ), &opcode, sizeof( opcode ) );
+            }
+            CHECK( std::ranges::equal( *frame, expected ) );
+            CHECK( gateway.Get( recipients[ i ] )->m_bytes_sent == expected.size() );
+        }
+    }
+
+    SUBCASE( "Closing a recipient releases only its reference" )
+    {
+        shm::net::Gateway gateway;
+        const std::array recipients{ gateway.Open( "a", 1 ), gateway.Open( "b", 1 ) };
+        const std::array< std::byte, 3 > payload{ std::byte{ 1 }, std::byte{ 2 }, std::byte{ 3 } };
+
+        CHECK( gateway.Broadcast( recipients, 5, payload ) == 2 );
+        CHECK( gateway.Close( recipients[ 0 ] ) );
+        CHECK( gateway.Stats().m_buffers.m_live == 1 );
+
+        const auto buffer = gateway.PopQueued( recipients[ 1 ] );
+        REQUIRE( gateway.GetBuffer( buffer ) != nullptr );
+        CHECK( std::ranges::equal( gateway.GetBuffer( buffer )->Bytes(), payload ) );
+        gateway.ReleaseBuffer( buffer );
+        CHECK( gateway.Stats().m_buffers.m_live == 0 );
+
+        CHECK( gateway.Broadcast( {}, 5, payload ) == 0 );
+        CHECK( gateway.Stats().m_buffers.m_live == 0 );
+    }
+}
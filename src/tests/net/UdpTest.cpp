@@ -0,0 +1,403 @@
+#include <doctest/doctest.h>
+
+#include "net/Gateway.hpp"
+#include "net/Messages.hpp"
+#include "hash/SipHash.hpp"
+#include "net/ReliableChannel.hpp"
+#include "net/UdpHandshake.hpp"
+#include "net/UdpServer.hpp"
+#include "net/UdpSocket.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector< std::byte > Message( uint32_t value )
+    {
+        std::vector< std::byte > message( sizeof( value ) );
+        std::memcpy( message.data(), &value, sizeof( value ) );
+        return message;
+    }
+
+    uint32_t ValueOf( std::span< const std::byte > message )
+    {
+        uint32_t value = 0;
+        std::memcpy( &value, message.data(), sizeof( value ) );
+        return value;
+    }
+
+    /// @brief Receives on the socket until count datagrams arrived or the timeout passed.
+    std::vector< shm::net::ReceivedDatagram > ReceiveAtLeast( shm::net::UdpSocket & socket, shm::net::MessageBufferPool & pool, std::size_t count,
+                                                              std::chrono::milliseconds timeout = std::chrono::seconds( 1 ) )
+    {
+        std::vector< shm::net::ReceivedDatagram > datagrams( count );
+        std::size_t received = 0;
+        const auto deadline  = std::chrono::steady_clock::now() + timeout;
+        while ( received < count && std::chrono::steady_clock::now() < deadline )
+        {
+            std::ignore = socket.WaitReadable( std::chrono::milliseconds( 10 ) );
+            received += socket.ReceiveBatch( pool, std::span( datagrams ).subspan( received ) ).value_or( 0 );
+        }
+        datagrams.resize( received );
+        return datagrams;
+    }
+
+    /// @brief One round trip of the handshake, the server runs the given tick.
+    void ExchangeHandshake( shm::net::UdpConnector & connector, shm::net::UdpSocket & client, shm::net::UdpServer & server,
+                            shm::net::MessageBufferPool & pool, uint64_t tick )
+    {
+        REQUIRE( client.Queue( shm::net::UdpAddress::Loopback( server.Port() ), connector.Request() ) );
+        REQUIRE( client.Flush( shm::net::UdpSendMode::Batched ).has_value() );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+        server.Receive( tick );
+        server.Flush( tick );
+        for ( const auto & datagram : ReceiveAtLeast( client, pool, 1, std::chrono::milliseconds( 100 ) ) )
+        {
+            connector.Receive( pool.Get( datagram.m_buffer )->Bytes() );
+            pool.Destroy( datagram.m_buffer );
+        }
+    }
+
+    /// @return The connection the server accepted, 0 if it did not within two round trips.
+    uint32_t Connect( uint32_t nonce, shm::net::UdpSocket & client, shm::net::UdpServer & server, shm::net::MessageBufferPool & pool, uint64_t tick )
+    {
+        shm::net::UdpConnector connector( nonce );
+        for ( int round_trip = 0; round_trip < 2 && !connector.Accepted(); ++round_trip )
+            ExchangeHandshake( connector, client, server, pool, tick );
+        return connector.Connection();
+    }
+} // namespace
+
+TEST_CASE( "shm::hash::SipHash24" )
+{
+    // Reference vectors of the SipHash paper, key 00..0f and messages 00..(n-1).
+    const shm::hash::SipKey key{ 0x0706050403020100, 0x0F0E0D0C0B0A0908 };
+    std::array< std::byte, 15 > message;
+    for ( std::size_t i = 0; i < message.size(); ++i )
+        message[ i ] = std::byte( i );
+    CHECK( shm::hash::SipHash24( key, {} ) == 0x726FDB47DD0E0E31 );
+    CHECK( shm::hash::SipHash24( key, message ) == 0xA129CA6149BE45E5 );
+}
+
+TEST_CASE( "shm::net::ReliableChannel" )
+{
+    SUBCASE( "Messages arrive once and in order over a lossy link" )
+    {
+        shm::net::ReliableChannel sender;
+        shm::net::ReliableChannel receiver;
+        std::mt19937 random( 7 );
+
+        // Datagrams in flight, each direction drops 30 %, duplicates 10 % and delivers in random order.
+        std::vector< std::vector< std::byte > > to_receiver;
+        std::vector< std::vector< std::byte > > to_sender;
+        const auto transmit = [ & ]( std::vector< std::vector< std::byte > > & link )
+        {
+            return [ &link, &random ]( std::span< const std::byte > datagram )
+            {
+                if ( random() % 10 < 3 )
+                    return;
+                link.emplace_back( datagram.begin(), datagram.end() );
+                if ( random() % 10 == 0 )
+                    link.emplace_back( datagram.begin(), datagram.end() );
+            };
+        };
+
+        constexpr uint32_t message_count = 5000;
+        uint32_t queued                  = 0;
+        std::vector< uint32_t > delivered;
+        for ( uint64_t tick = 1; tick < 100'000 && delivered.size() < message_count; ++tick )
+        {
+            while ( queued < message_count && sender.Queue( Message( queued ) ) )
+                ++queued;
+
+            sender.Poll( tick, transmit( to_receiver ) );
+            std::shuffle( to_receiver.begin(), to_receiver.end(), random );
+            for ( const auto & datagram : to_receiver )
+                CHECK( receiver.Receive( datagram, [ & ]( std::span< const std::byte > message ) { delivered.push_back( ValueOf( message ) ); } ) );
+            to_receiver.clear();
+
+            receiver.Poll( tick, transmit( to_sender ) );
+            for ( const auto & datagram : to_sender )
+                CHECK( sender.Receive( datagram, []( std::span< const std::byte > ) { FAIL( "The receiver sends no messages" ); } ) );
+            to_sender.clear();
+        }
+
+        REQUIRE( delivered.size() == message_count );
+        for ( uint32_t i = 0; i < message_count; ++i )
+            CHECK( delivered[ i ] == i );
+        CHECK( sender.InFlight() == 0 );
+        CHECK( sender.Resends() > 0 );
+    }
+
+    SUBCASE( "The window limits the messages in flight" )
+    {
+        shm::net::ReliableChannel channel;
+        for ( uint32_t i = 0; i < shm::net::ReliableChannel::Window; ++i )
+            REQUIRE( channel.Queue( Message( i ) ) );
+        CHECK_FALSE( channel.Queue( Message( 0 ) ) );
+        CHECK_FALSE( shm::net::ReliableChannel{}.Queue( std::vector< std::byte >( shm::net::MaxReliablePayload + 1 ) ) );
+    }
+
+    SUBCASE( "A restored channel carries on where the captured one stopped" )
+    {
+        shm::net::ReliableChannel sender;
+        shm::net::ReliableChannel receiver;
+        std::vector< std::vector< std::byte > > in_flight;
+        const auto transmit = [ & ]( std::span< const std::byte > datagram ) { in_flight.emplace_back( datagram.begin(), datagram.end() ); };
+        std::vector< uint32_t > delivered;
+        const auto deliver = [ & ]( std::span< const std::byte > message ) { delivered.push_back( ValueOf( message ) ); };
+
+        for ( uint32_t i = 0; i < 4; ++i )
+            REQUIRE( sender.Queue( Message( i ) ) );
+        sender.Poll( 1, transmit );
+        REQUIRE( in_flight.size() == 4 );
+        // Message 1 is lost, 2 and 3 wait behind it and nothing was acknowledged yet.
+        for ( const std::size_t i : { 0u, 2u, 3u } )
+            CHECK( receiver.Receive( in_flight[ i ], deliver ) );
+        CHECK( delivered == std::vector< uint32_t >{ 0 } );
+
+        shm::net::ReliableChannel restored_sender;
+        shm::net::ReliableChannel restored_receiver;
+        restored_sender.Restore( sender.Capture() );
+        restored_receiver.Restore( receiver.Capture() );
+        CHECK( restored_sender.InFlight() == 4 );
+        REQUIRE( restored_sender.Queue( Message( 4 ) ) );
+
+        // Unacknowledged messages go out again without waiting for the resend timer.
+        in_flight.clear();
+        restored_sender.Poll( 2, transmit );
+        CHECK( in_flight.size() == 5 );
+        for ( const auto & datagram : in_flight )
+            CHECK( restored_receiver.Receive( datagram, deliver ) );
+        CHECK( delivered == std::vector< uint32_t >{ 0, 1, 2, 3, 4 } );
+
+        in_flight.clear();
+        restored_receiver.Poll( 2, transmit );
+        REQUIRE( in_flight.size() == 1 );
+        CHECK( restored_sender.Receive( in_flight.front(), []( std::span< const std::byte > ) { FAIL( "Acks carry no messages" ); } ) );
+        CHECK( restored_sender.InFlight() == 0 );
+    }
+
+    SUBCASE( "Resends wait for the resend timer" )
+    {
+        shm::net::ReliableChannel channel( { .m_resend_after_ticks = 10 } );
+        REQUIRE( channel.Queue( Message( 1 ) ) );
+
+        std::size_t sent = 0;
+        for ( uint64_t tick = 1; tick <= 25; ++tick )
+            channel.Poll( tick, [ & ]( std::span< const std::byte > ) { ++sent; } );
+        CHECK( sent == 3 );
+        CHECK( channel.Resends() == 2 );
+    }
+}
+
+TEST_CASE( "shm::net::UdpSocket" )
+{
+    shm::net::MessageBufferPool pool;
+    auto receiver = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+    auto sender   = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+    REQUIRE( receiver.has_value() );
+    REQUIRE( sender.has_value() );
+    const auto to = receiver->LocalAddress();
+
+    const auto check_mode = [ & ]( shm::net::UdpSendMode mode )
+    {
+        // Equally sized datagrams become one segmented message, the shorter last one ends the run.
+        for ( uint32_t i = 0; i < 150; ++i )
+            REQUIRE( sender->Queue( to, i == 149 ? Message( i ) : std::vector< std::byte >( 100, std::byte( i ) ) ) );
+        CHECK_FALSE( sender->Queue( to, std::vector< std::byte >( shm::net::MaxDatagramSize + 1 ) ) );
+
+        const auto sent = sender->Flush( mode );
+        REQUIRE( sent.has_value() );
+        CHECK( *sent == 150 );
+        CHECK( sender->QueuedDatagrams() == 0 );
+
+        const auto datagrams = ReceiveAtLeast( *receiver, pool, 150 );
+        REQUIRE( datagrams.size() == 150 );
+        for ( uint32_t i = 0; i < 150; ++i )
+        {
+            const auto * buffer = pool.Get( datagrams[ i ].m_buffer );
+            REQUIRE( buffer != nullptr );
+            CHECK( datagrams[ i ].m_from == sender->LocalAddress() );
+            if ( i == 149 )
+                CHECK( ValueOf( buffer->Bytes() ) == i );
+            else
+                CHECK( std::ranges::equal( buffer->Bytes(), std::vector< std::byte >( 100, std::byte( i ) ) ) );
+            pool.Destroy( datagrams[ i ].m_buffer );
+        }
+        CHECK( pool.Stats().m_live == 0 );
+    };
+
+    SUBCASE( "One datagram per system call" )
+    {
+        check_mode( shm::net::UdpSendMode::PerDatagram );
+    }
+    SUBCASE( "Batched" )
+    {
+        check_mode( shm::net::UdpSendMode::Batched );
+    }
+    SUBCASE( "Segmented" )
+    {
+        check_mode( shm::net::UdpSendMode::Segmented );
+    }
+}
+
+TEST_CASE( "shm::net::UdpServer" )
+{
+    shm::net::Gateway gateway;
+    shm::net::MessageBufferPool pool;
+    auto server = shm::net::UdpServer::Create( gateway, { .m_peer_timeout_ticks = 5 } );
+    REQUIRE( server.has_value() );
+    auto client = shm::net::UdpSocket::Bind( shm::net::UdpAddress::Loopback( 0 ), false );
+    REQUIRE( client.has_value() );
+    const auto server_address = shm::net::UdpAddress::Loopback( ( *server )->Port() );
+    const auto send = [ & ]( shm::net::ReliableChannel & channel, std::span< const std::byte > frame, uint64_t tick )
+    {
+        REQUIRE( channel.Queue( frame ) );
+        channel.Poll( tick, [ & ]( std::span< const std::byte > datagram ) { client->Queue( server_address, datagram ); } );
+        REQUIRE( client->Flush( shm::net::UdpSendMode::Batched ).has_value() );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+    };
+
+    SUBCASE( "Addresses that do not echo their cookie get no connection" )
+    {
+        // Whoever forges the client's address never sees the challenge.
+        shm::net::UdpConnector connector( 1 );
+        ExchangeHandshake( connector, *client, **server, pool, 1 );
+        CHECK_FALSE( connector.Accepted() );
+        CHECK( ( *server )->PeerCount() == 0 );
+
+        REQUIRE( client->Queue( server_address, shm::net::EncodeHandshake( { .m_type = shm::net::HandshakeType::Response, .m_nonce = 1, .m_cookie = 1234 } ) ) );
+        shm::net::ReliableChannel guessed( {}, 1 );
+        send( guessed, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 1.0f } ), 1 );
+        ( *server )->Receive( 1 );
+        CHECK( ( *server )->PeerCount() == 0 );
+        CHECK( gateway.ConnectionCount() == 0 );
+    }
+
+    SUBCASE( "Peers become gateway connections exchanging frames" )
+    {
+        const auto connection_id = Connect( 1, *client, **server, pool, 1 );
+        REQUIRE( connection_id != 0 );
+        REQUIRE( ( *server )->PeerCount() == 1 );
+        shm::net::ReliableChannel client_channel( {}, connection_id );
+        send( client_channel, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 1.0f } ), 1 );
+        ( *server )->Receive( 1 );
+        gateway.PumpTransports( 1 );
+
+        std::vector< shm::net::InboundType > types;
+        uint64_t session = 0;
+        gateway.Inbound().ForEach(
+            [ & ]( const shm::net::InboundEvent & event )
+            {
+                types.push_back( event.m_type );
+                session = event.m_session;
+                if ( event.m_type == shm::net::InboundType::Message )
+                    CHECK( std::ranges::equal( event.m_payload, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 1.0f } ) ) );
+            } );
+        CHECK( types == std::vector{ shm::net::InboundType::Connected, shm::net::InboundType::Message } );
+        gateway.Inbound().Clear();
+
+        const auto connection = shm::net::ConnectionHandle::Unpack( session );
+        CHECK( gateway.Get( connection )->RemoteAddress() == client->LocalAddress().ToString() );
+        REQUIRE( gateway.Send( connection, shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = 3 } ) ) );
+        gateway.PumpTransports( 2 );
+        ( *server )->Flush( 2 );
+
+        const auto datagrams = ReceiveAtLeast( *client, pool, 1 );
+        REQUIRE( datagrams.size() == 1 );
+        std::size_t frames = 0;
+        client_channel.Receive( pool.Get( datagrams.front().m_buffer )->Bytes(),
+                                [ & ]( std::span< const std::byte > frame )
+                                {
+                                    CHECK( std::ranges::equal( frame, shm::wire::EncodeFrame( shm::net::msg::SetWorld{ .world_id = 3 } ) ) );
+                                    ++frames;
+                                } );
+        pool.Destroy( datagrams.front().m_buffer );
+        CHECK( frames == 1 );
+        // The client's frame was acknowledged along the way.
+        CHECK( client_channel.InFlight() == 0 );
+
+        SUBCASE( "Silent peers are disconnected" )
+        {
+            // Datagrams of another connection do not keep the peer alive.
+            shm::net::ReliableChannel stale( {}, connection_id + 1 );
+            send( stale, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 2.0f } ), 6 );
+            ( *server )->Receive( 6 );
+            gateway.PumpTransports( 6 );
+            CHECK( gateway.Inbound().Size() == 0 );
+
+            ( *server )->Receive( 7 );
+            gateway.PumpTransports( 7 );
+            types.clear();
+            gateway.Inbound().ForEach( [ & ]( const shm::net::InboundEvent & event ) { types.push_back( event.m_type ); } );
+            CHECK( types == std::vector{ shm::net::InboundType::Disconnected } );
+            CHECK( gateway.ConnectionCount() == 0 );
+
+            ( *server )->Receive( 8 );
+            CHECK( ( *server )->PeerCount() == 0 );
+        }
+
+        SUBCASE( "A client that restarts on the same address gets a new connection" )
+        {
+            // The old connection's ack is still on its way, the restarted client never knew it.
+            const auto restarted_id = Connect( 2, *client, **server, pool, 3 );
+            REQUIRE( restarted_id != 0 );
+            CHECK( restarted_id != connection_id );
+            CHECK( ( *server )->PeerCount() == 1 );
+            gateway.PumpTransports( 3 );
+            types.clear();
+            gateway.Inbound().ForEach( [ & ]( const shm::net::InboundEvent & event ) { types.push_back( event.m_type ); } );
+            std::ranges::sort( types );
+            CHECK( types == std::vector{ shm::net::InboundType::Connected, shm::net::InboundType::Disconnected } );
+            CHECK( gateway.ConnectionCount() == 1 );
+            gateway.Inbound().Clear();
+
+            // Frames of the old connection are dropped, those of the new one arrive.
+            shm::net::ReliableChannel restarted_channel( {}, restarted_id );
+            send( client_channel, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 2.0f } ), 4 );
+            send( restarted_channel, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 3.0f } ), 4 );
+            ( *server )->Receive( 4 );
+            gateway.PumpTransports( 4 );
+            std::vector< std::vector< std::byte > > payloads;
+            gateway.Inbound().ForEach( [ & ]( const shm::net::InboundEvent & event ) { payloads.emplace_back( event.m_payload.begin(), event.m_payload.end() ); } );
+            REQUIRE( payloads.size() == 1 );
+            CHECK( std::ranges::equal( payloads.front(), shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 3.0f } ) ) );
+        }
+
+        SUBCASE( "Closed peers get their last frame and refused peers stay away" )
+        {
+            REQUIRE( gateway.Send( connection, shm::wire::EncodeFrame( shm::net::msg::Rejected{ .retry_after_ms = 100 } ) ) );
+            gateway.CloseAfterFlush( connection );
+            ( *server )->Refuse( session, 6 );
+            gateway.PumpTransports( 3 );
+            CHECK( gateway.ConnectionCount() == 0 );
+            ( *server )->Flush( 3 );
+
+            // The gateway let go, the peer stays until the rejection is acknowledged.
+            const auto rejection = ReceiveAtLeast( *client, pool, 1 );
+            REQUIRE( rejection.size() == 1 );
+            frames = 0;
+            client_channel.Receive( pool.Get( rejection.front().m_buffer )->Bytes(), [ & ]( std::span< const std::byte > ) { ++frames; } );
+            pool.Destroy( rejection.front().m_buffer );
+            CHECK( frames == 1 );
+            ( *server )->Receive( 4 );
+            CHECK( ( *server )->PeerCount() == 1 );
+
+            send( client_channel, shm::wire::EncodeFrame( shm::net::msg::Move{ .x = 2.0f } ), 4 );
+            ( *server )->Receive( 5 );
+            CHECK( ( *server )->PeerCount() == 0 );
+            CHECK( Connect( 2, *client, **server, pool, 5 ) == 0 );
+            CHECK( ( *server )->PeerCount() == 0 );
+            CHECK( gateway.Inbound().Size() == 0 );
+
+            CHECK( Connect( 3, *client, **server, pool, 6 ) != 0 );
+            CHECK( ( *server )->PeerCount() == 1 );
+        }
+    }
+}
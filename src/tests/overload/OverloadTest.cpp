@@ -0,0 +1,304 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "app/InboundHandler.hpp"
+#include "journal/Journal.hpp"
+#include "metrics/Metrics.hpp"
+#include "net/Messages.hpp"
+#include "overload/LoadShedder.hpp"
+#include "overload/OverloadController.hpp"
+#include "protocol/FrameHeader.hpp"
+#include "replay/Capture.hpp"
+#include "wire/Codec.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <flecs.h>
+#include <vector>
+
+namespace
+{
+    using shm::overload::OverloadLevel;
+
+    /// @brief The 120 Hz budget of the broker main loop.
+    constexpr uint64_t G_FRAME_BUDGET_NS = 1'000'000'000 / 120;
+    constexpr std::string_view G_OVERLOAD_DIR = "./Testing/Overload/";
+
+    auto PositionUpdate( float x )
+    {
+        return shm::wire::EncodeFrame( shm::net::msg::Move{ .x = x } );
+    }
+
+    float PositionOf( const shm::net::InboundEvent & event )
+    {
+        const auto move = shm::wire::Decode< shm::net::msg::Move >( event.m_payload.subspan( sizeof( shm::protocol::FrameHeader ) ) );
+        REQUIRE( move.has_value() );
+        return move->x;
+    }
+
+    std::vector< shm::net::InboundEvent > Events( const shm::net::Inbox & inbox )
+    {
+        std::vector< shm::net::InboundEvent > events;
+        inbox.ForEach( [ & ]( const shm::net::InboundEvent & event ) { events.push_back( event ); } );
+        return events;
+    }
+
+    std::size_t CountOf( const shm::net::Inbox & inbox, shm::net::InboundType type )
+    {
+        return static_cast< std::size_t >( std::ranges::count( Events( inbox ), type, &shm::net::InboundEvent::m_type ) );
+    }
+
+    /// @brief Records 1200 ticks of 200 sessions sending a position update every tick. For ticks 300 to 599 another
+    /// 400 sessions do the same, three times the usual traffic.
+    std::filesystem::path RecordSpike()
+    {
+        const auto dir = std::filesystem::path( G_OVERLOAD_DIR ) / "Spike";
+        std::filesystem::remove_all( dir );
+        std::filesystem::create_directories( dir );
+
+        auto writer = shm::replay::CaptureWriter::Create( dir / "spike.capture", {} );
+        REQUIRE( writer.has_value() );
+        for ( uint64_t tick = 1; tick <= 1200; ++tick )
+        {
+            const bool spike = tick >= 300 && tick < 600;
+            if ( tick == 1 || tick == 300 )
+            {
+                for ( uint64_t session = tick == 1 ? 1 : 201; session <= ( tick == 1 ? 200u : 600u ); ++session )
+                    writer->RecordInbound( tick, { .m_type = shm::net::InboundType::Connected, .m_session = session } );
+            }
+
+            const auto payload = PositionUpdate( static_cast< float >( tick ) );
+            for ( uint64_t session = 1; session <= ( spike ? 600u : 200u ); ++session )
+                writer->RecordInbound( tick, { .m_type = shm::net::InboundType::Message, .m_session = session, .m_payload = payload } );
+            if ( tick == 600 )
+            {
+                for ( uint64_t session = 201; session <= 600; ++session )
+                    writer->RecordInbound( tick, { .m_type = shm::net::InboundType::Disconnected, .m_session = session } );
+            }
+            writer->RecordTick( tick, 1.0f / 120.0f );
+        }
+        REQUIRE( writer->Close().has_value() );
+        return dir;
+    }
+
+    struct ReplayOutcome
+    {
+        uint64_t m_p99_modeled_frame_ns = 0;
+        OverloadLevel m_highest_level = OverloadLevel::Normal;
+        std::size_t m_sessions = 0;
+        std::size_t m_rejected = 0;
+    };
+
+    /// @brief Replays the capture through the broker tick, with or without shedding. The frame time is not measured but
+    /// modeled from the events the tick handled, so the outcome does not depend on the speed of the machine: the 200
+    /// sessions of normal traffic take half of the budget. This checks the controller and shedder against that model,
+    /// not the wall time of the real tick.
+    ReplayOutcome ReplayWithModeledLoad( const std::filesystem::path & dir, bool shed )
+    {
+        constexpr uint64_t event_cost_ns = G_FRAME_BUDGET_NS / 2 / 200;
+
+        std::filesystem::remove_all( dir / ( shed ? "shed" : "plain" ) );
+        auto reader = shm::replay::CaptureReader::Open( dir / "spike.capture" );
+        REQUIRE( reader.has_value() );
+        flecs::world world;
+        shm::journal::WorldJournal journal( world, { .m_directory = dir / ( shed ? "shed" : "plain" ), .m_snapshot_interval_ticks = 0 } );
+        journal.Restore( reader->InitialState() );
+        wb::InboundHandler inbound( journal );
+
+        shm::metrics::Registry registry;
+        shm::overload::OverloadController controller( registry, G_FRAME_BUDGET_NS );
+        shm::overload::LoadShedder shedder( registry );
+        shm::net::Inbox inbox;
+
+        ReplayOutcome outcome;
+        std::vector< uint64_t > frames;
+        shm::replay::Replay(
+            *reader, inbox,
+            [ & ]( uint64_t tick, float delta_time )
+            {
+                const auto received = inbox.Size();
+                if ( shed )
+                    outcome.m_rejected += shedder.Apply( inbox, controller.Level(), tick ).size();
+
+                frames.push_back( inbox.Size() * event_cost_ns );
+                inbox.ForEach( [ & ]( const shm::net::InboundEvent & event ) { inbound.Handle( event ); } );
+                inbox.Clear();
+                world.progress( delta_time );
+                journal.CommitTick( tick );
+
+                outcome.m_highest_level = std::max( outcome.m_highest_level, controller.Observe( frames.back(), received ) );
+            },
+            []() { return uint64_t{ 0 }; } );
+        journal.Flush();
+
+        std::ranges::sort( frames );
+        outcome.m_p99_modeled_frame_ns = frames[ frames.size() * 99 / 100 ];
+        outcome.m_sessions             = inbound.SessionCount();
+        return outcome;
+    }
+} // namespace
+
+TEST_CASE( "shm::overload::OverloadController" )
+{
+    shm::metrics::Registry registry;
+    const shm::overload::OverloadConfig config{ .escalate_after_ticks = 3, .recover_after_ticks = 10, .max_inbound_events = 1000 };
+    shm::overload::OverloadController controller( registry, G_FRAME_BUDGET_NS, config );
+
+    SUBCASE( "A single late frame sheds nothing" )
+    {
+        controller.Observe( G_FRAME_BUDGET_NS * 3, 0 );
+        for ( int tick = 0; tick < 20; ++tick )
+            CHECK( controller.Observe( G_FRAME_BUDGET_NS / 4, 0 ) == OverloadLevel::Normal );
+    }
+
+    SUBCASE( "Sustained overload escalates one step at a time and recovers the same way" )
+    {
+        std::vector< OverloadLevel > levels;
+        for ( int tick = 0; tick < 40; ++tick )
+            levels.push_back( controller.Observe( G_FRAME_BUDGET_NS * 2, 0 ) );
+        CHECK( std::ranges::is_sorted( levels ) );
+        CHECK( levels.back() == OverloadLevel::RejectConnections );
+        CHECK( registry.GetGauge( "shm_overload_level" ).Value() == 4 );
+
+        // Between the thresholds nothing changes.
+        for ( int tick = 0; tick < 100; ++tick )
+            CHECK( controller.Observe( G_FRAME_BUDGET_NS * 7 / 10, 0 ) == OverloadLevel::RejectConnections );
+
+        for ( int tick = 0; tick < 200 && controller.Level() != OverloadLevel::Normal; ++tick )
+            controller.Observe( 0, 0 );
+        CHECK( controller.Level() == OverloadLevel::Normal );
+    }
+
+    SUBCASE( "A full inbound queue counts as overload" )
+    {
+        for ( int tick = 0; tick < 3; ++tick )
+            controller.Observe( 0, 1000 );
+        CHECK( controller.Level() == OverloadLevel::ReducedReplication );
+    }
+
+    SUBCASE( "Reconfiguring keeps the level" )
+    {
+        for ( int tick = 0; tick < 3; ++tick )
+            controller.Observe( 0, 1000 );
+        controller.Configure( { .max_inbound_events = 0 } );
+        CHECK( controller.Level() == OverloadLevel::ReducedReplication );
+        CHECK( controller.Observe( 0, 1000 ) == OverloadLevel::ReducedReplication );
+    }
+}
+
+TEST_CASE( "shm::overload::LoadShedder" )
+{
+    using shm::net::InboundType;
+
+    shm::metrics::Registry registry;
+    shm::overload::LoadShedder shedder(
+        registry, { .reduced_replication_interval = 4, .admissions_per_tick = 2, .max_waiting_sessions = 3, .retry_after_ms = 1000 } );
+    shm::net::Inbox inbox;
+
+    SUBCASE( "Nothing is touched while the broker keeps up" )
+    {
+        inbox.Push( InboundType::Connected, 1 );
+        inbox.Push( InboundType::Message, 1, PositionUpdate( 1.0f ) );
+        CHECK( shedder.Apply( inbox, OverloadLevel::Normal, 1 ).empty() );
+        CHECK( inbox.Size() == 2 );
+    }
+
+    SUBCASE( "Reduced replication hands on the newest position update every few ticks" )
+    {
+        std::vector< float > applied;
+        for ( uint64_t tick = 1; tick <= 8; ++tick )
+        {
+            inbox.Push( InboundType::Message, 1, PositionUpdate( static_cast< float >( tick ) ) );
+            inbox.Push( InboundType::Message, 1, PositionUpdate( static_cast< float >( tick ) + 0.5f ) );
+            std::ignore = shedder.Apply( inbox, OverloadLevel::ReducedReplication, tick );
+            for ( const auto & event : Events( inbox ) )
+                applied.push_back( PositionOf( event ) );
+            inbox.Clear();
+        }
+        // Session 1 is due on the ticks 3 and 7.
+        CHECK( applied == std::vector< float >{ 3.5f, 7.5f } );
+        CHECK( registry.GetCounter( "shm_shed_position_updates_total" ).Value() == 13 );
+
+        // Back to normal the held back update is handed on right away, a newer one replaces it.
+        inbox.Push( InboundType::Message, 1, PositionUpdate( 9.0f ) );
+        std::ignore = shedder.Apply( inbox, OverloadLevel::ReducedReplication, 9 );
+        CHECK( inbox.Size() == 0 );
+        std::ignore = shedder.Apply( inbox, OverloadLevel::Normal, 10 );
+        CHECK( inbox.Size() == 1 );
+        CHECK( shedder.Deferred() == 0 );
+    }
+
+    SUBCASE( "The admission gate lets waiting sessions in a few per tick" )
+    {
+        for ( uint64_t session = 1; session <= 3; ++session )
+        {
+            inbox.Push( InboundType::Connected, session );
+            inbox.Push( InboundType::Message, session, PositionUpdate( 1.0f ) );
+        }
+        std::ignore = shedder.Apply( inbox, OverloadLevel::AdmissionGate, 1 );
+        // Two admitted at the end of the tick, their messages of the tick were dropped while they waited.
+        CHECK( CountOf( inbox, InboundType::Connected ) == 2 );
+        CHECK( CountOf( inbox, InboundType::Message ) == 0 );
+        CHECK( shedder.Waiting() == 1 );
+        CHECK( registry.GetCounter( "shm_shed_messages_total" ).Value() == 3 );
+        inbox.Clear();
+
+        // New sessions queue behind the waiting one even once the gate opened.
+        inbox.Push( InboundType::Connected, 4 );
+        std::ignore = shedder.Apply( inbox, OverloadLevel::Normal, 2 );
+        const auto admitted = Events( inbox );
+        REQUIRE( admitted.size() == 2 );
+        CHECK( admitted[ 0 ].m_session == 3 );
+        CHECK( admitted[ 1 ].m_session == 4 );
+        CHECK( shedder.Waiting() == 0 );
+    }
+
+    SUBCASE( "Sessions leaving while they wait are forgotten" )
+    {
+        for ( uint64_t session = 1; session <= 3; ++session )
+            inbox.Push( InboundType::Connected, session );
+        std::ignore = shedder.Apply( inbox, OverloadLevel::AdmissionGate, 1 );
+        CHECK( shedder.Waiting() == 1 );
+        inbox.Clear();
+
+        inbox.Push( InboundType::Disconnected, 3 );
+        std::ignore = shedder.Apply( inbox, OverloadLevel::Normal, 2 );
+        CHECK( inbox.Size() == 0 );
+        CHECK( shedder.Waiting() == 0 );
+    }
+
+    SUBCASE( "New sessions are rejected once the gate is full or the broker rejects" )
+    {
+        for ( uint64_t session = 1; session <= 6; ++session )
+            inbox.Push( InboundType::Connected, session );
+        inbox.Push( InboundType::Message, 6, PositionUpdate( 1.0f ) );
+        auto rejected = shedder.Apply( inbox, OverloadLevel::RejectConnections, 1 );
+        CHECK( rejected.size() == 6 );
+        CHECK( inbox.Size() == 0 );
+
+        for ( uint64_t session = 7; session <= 12; ++session )
+            inbox.Push( InboundType::Connected, session );
+        rejected = shedder.Apply( inbox, OverloadLevel::AdmissionGate, 2 );
+        // Three wait, of which two are admitted right away, the other three do not fit the gate.
+        CHECK( std::vector< uint64_t >( rejected.begin(), rejected.end() ) == std::vector< uint64_t >{ 10, 11, 12 } );
+        CHECK( registry.GetCounter( "shm_rejected_sessions_total" ).Value() == 9 );
+    }
+}
+
+TEST_CASE( "shm::overload replayed traffic spike against modeled frame times" )
+{
+    const auto dir = RecordSpike();
+
+    const auto plain = ReplayWithModeledLoad( dir, false );
+    CHECK( plain.m_p99_modeled_frame_ns > G_FRAME_BUDGET_NS );
+
+    // Three times the traffic for 300 ticks: replication is reduced within a few ticks, nothing further is needed and
+    // the p99 frame time stays within the budget.
+    const auto shed = ReplayWithModeledLoad( dir, true );
+    CHECK( shed.m_p99_modeled_frame_ns <= G_FRAME_BUDGET_NS );
+    CHECK( shed.m_highest_level == OverloadLevel::ReducedReplication );
+    CHECK( shed.m_rejected == 0 );
+    CHECK( shed.m_sessions == 200 );
+    CHECK( plain.m_sessions == 200 );
+}
@@ -0,0 +1,286 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "app/InboundHandler.hpp"
+#include "filesystem/Filesystem.hpp"
+#include "journal/Journal.hpp"
+#include "net/Messages.hpp"
+#include "net/SessionDirectory.hpp"
+#include "replay/Capture.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <array>
+#include <bit>
+#include <filesystem>
+#include <flecs.h>
+
+namespace
+{
+    constexpr std::string_view G_REPLAY_DIR = "./Testing/Replay/";
+
+    std::filesystem::path CleanReplayDir( std::string_view name )
+    {
+        const auto dir = std::filesystem::path( G_REPLAY_DIR ) / name;
+        std::filesystem::remove_all( dir );
+        std::filesystem::create_directories( dir );
+        return dir;
+    }
+
+    auto PositionUpdate( float x, float y, float z )
+    {
+        return shm::wire::EncodeFrame( shm::net::msg::Move{ .x = x, .y = y, .z = z } );
+    }
+
+    /// @brief The tick of the broker without sockets: inbound events into the world, journal commit.
+    struct Broker
+    {
+        explicit Broker( const std::filesystem::path & journal_dir, uint64_t idle_timeout_ticks = 0 )
+            : m_journal( m_world, { .m_directory = journal_dir, .m_snapshot_interval_ticks = 0 } )
+            , m_inbound( m_journal, idle_timeout_ticks )
+        {
+        }
+
+        void Step( uint64_t tick, float delta_time )
+        {
+            m_inbox.ForEach( [ this ]( const shm::net::InboundEvent & event ) { m_inbound.Handle( event ); } );
+            m_inbox.Clear();
+            m_inbound.ExpireIdle( tick );
+            m_world.progress( delta_time );
+            m_journal.CommitTick( tick );
+        }
+
+        uint64_t Hash() const
+        {
+            return shm::replay::HashWorld( m_journal.CaptureState() );
+        }
+
+        flecs::world m_world;
+        shm::journal::WorldJournal m_journal;
+        wb::InboundHandler m_inbound;
+        shm::net::Inbox m_inbox;
+    };
+
+    /// @brief Records a run of 50 ticks in which sessions connect, move around and some of them leave again.
+    uint64_t RecordRun( const std::filesystem::path & dir )
+    {
+        Broker broker( dir / "journal" );
+        REQUIRE( broker.m_journal.Recover().has_value() );
+        auto writer = shm::replay::CaptureWriter::Create( dir / "run.capture", broker.m_journal.CaptureState() );
+        REQUIRE( writer.has_value() );
+
+        for ( uint64_t tick = 1; tick <= 50; ++tick )
+        {
+            if ( tick <= 10 )
+                broker.m_inbox.Push( shm::net::InboundType::Connected, tick );
+            for ( uint64_t session = 1; session <= std::min< uint64_t >( tick, 10 ); ++session )
+            {
+                const auto payload = PositionUpdate( static_cast< float >( tick ) * 0.1f, static_cast< float >( session ) / 3.0f, 1.0f / static_cast< float >( tick ) );
+                broker.m_inbox.Push( shm::net::InboundType::Message, session, payload );
+            }
+            if ( tick == 30 )
+                broker.m_inbox.Push( shm::net::InboundType::Disconnected, 4 );
+
+            broker.m_inbox.ForEach( [ & ]( const shm::net::InboundEvent & event ) { writer->RecordInbound( tick, event ); } );
+            const float delta_time = 1.0f / 120.0f;
+            writer->RecordTick( tick, delta_time );
+            broker.Step( tick, delta_time );
+            if ( tick % 10 == 0 )
+                writer->RecordCheckpoint( tick, broker.Hash() );
+        }
+        broker.m_journal.Flush();
+        REQUIRE( writer->Close().has_value() );
+        return broker.Hash();
+    }
+} // namespace
+
+namespace shm::replay
+{
+    TEST_CASE( "shm::replay::Capture" )
+    {
+        SUBCASE( "Events read back as written" )
+        {
+            const auto dir = CleanReplayDir( "RoundTrip" );
+            journal::WorldSnapshot initial{ .sequence = 3, .next_entity_id = 8 };
+            initial.entities.push_back( { .id = 7, .presence = journal::Presence{ .session_id = 5, .world_id = 1 } } );
+            {
+                auto writer = CaptureWriter::Create( dir / "a.capture", initial );
+                REQUIRE( writer.has_value() );
+                const auto payload = PositionUpdate( 1.0f, 2.0f, 3.0f );
+                writer->RecordInbound( 1, { .m_type = net::InboundType::Message, .m_session = 5, .m_payload = payload } );
+                writer->RecordTick( 1, 0.25f );
+                writer->RecordCheckpoint( 1, 0xDEADBEEFull );
+                REQUIRE( writer->Close().has_value() );
+            }
+
+            auto reader = CaptureReader::Open( dir / "a.capture" );
+            REQUIRE( reader.has_value() );
+            CHECK( reader->InitialState().next_entity_id == 8 );
+            REQUIRE( reader->InitialState().entities.size() == 1 );
+            CHECK( reader->InitialState().entities[ 0 ].presence->session_id == 5 );
+
+            auto message = reader->Next();
+            REQUIRE( message.has_value() );
+            CHECK( message->m_type == CaptureEventType::Message );
+            CHECK( message->m_value == 5 );
+            CHECK( message->m_payload.size() == shm::wire::FrameSize< net::msg::Move > );
+
+            auto tick = reader->Next();
+            REQUIRE( tick.has_value() );
+            CHECK( tick->m_type == CaptureEventType::Tick );
+            CHECK( std::bit_cast< float >( static_cast< uint32_t >( tick->m_value ) ) == 0.25f );
+
+            auto checkpoint = reader->Next();
+            REQUIRE( checkpoint.has_value() );
+            CHECK( checkpoint->m_value == 0xDEADBEEFull );
+            CHECK( !reader->Next().has_value() );
+            CHECK( !reader->Truncated() );
+        }
+
+        SUBCASE( "Torn event ends the capture" )
+        {
+            const auto dir = CleanReplayDir( "Torn" );
+            {
+                auto writer = CaptureWriter::Create( dir / "a.capture", {} );
+                REQUIRE( writer.has_value() );
+                writer->RecordTick( 1, 0.5f );
+                writer->RecordTick( 2, 0.5f );
+                REQUIRE( writer->Close().has_value() );
+            }
+            std::filesystem::resize_file( dir / "a.capture", std::filesystem::file_size( dir / "a.capture" ) - 2 );
+
+            auto reader = CaptureReader::Open( dir / "a.capture" );
+            REQUIRE( reader.has_value() );
+            CHECK( reader->Next().has_value() );
+            CHECK( !reader->Next().has_value() );
+            CHECK( reader->Truncated() );
+        }
+
+        SUBCASE( "Not a capture" )
+        {
+            const auto dir = CleanReplayDir( "Invalid" );
+            REQUIRE( shm::fs::WriteStringToFile( dir / "a.capture", "certainly not a capture", std::ios::out | std::ios::trunc ).has_value() );
+            CHECK( !CaptureReader::Open( dir / "a.capture" ).has_value() );
+        }
+    }
+
+    TEST_CASE( "shm::replay::Replay" )
+    {
+        const auto dir           = CleanReplayDir( "Deterministic" );
+        const auto recorded_hash = RecordRun( dir );
+
+        SUBCASE( "Replays reproduce the recorded world" )
+        {
+            for ( int run = 0; run < 2; ++run )
+            {
+                std::filesystem::remove_all( dir / "replay" );
+                auto reader = CaptureReader::Open( dir / "run.capture" );
+                REQUIRE( reader.has_value() );
+
+                Broker broker( dir / "replay" );
+                broker.m_journal.Restore( reader->InitialState() );
+                broker.m_inbound.Adopt( reader->InitialState() );
+                const auto stats = Replay( *reader, broker.m_inbox, [ & ]( uint64_t tick, float delta_time ) { broker.Step( tick, delta_time ); },
+                                           [ & ]() { return broker.Hash(); } );
+                CHECK( stats.m_ticks == 50 );
+                CHECK( stats.m_checkpoints == 5 );
+                CHECK( !stats.m_first_divergent_tick.has_value() );
+                CHECK( broker.Hash() == recorded_hash );
+                CHECK( broker.m_inbound.SessionCount() == 9 );
+            }
+        }
+
+        SUBCASE( "Divergence is reported at the first mismatching checkpoint" )
+        {
+            std::filesystem::remove_all( dir / "replay" );
+            auto reader = CaptureReader::Open( dir / "run.capture" );
+            REQUIRE( reader.has_value() );
+
+            Broker broker( dir / "replay" );
+            broker.m_journal.Restore( reader->InitialState() );
+            const auto stats = Replay(
+                *reader, broker.m_inbox,
+                [ & ]( uint64_t tick, float delta_time )
+                {
+                    // Loses the events of one tick, session 5 never connects.
+                    if ( tick == 5 )
+                        broker.m_inbox.Clear();
+                    broker.Step( tick, delta_time );
+                },
+                [ & ]() { return broker.Hash(); } );
+            REQUIRE( stats.m_first_divergent_tick.has_value() );
+            CHECK( *stats.m_first_divergent_tick == 10 );
+        }
+    }
+
+    TEST_CASE( "wb::InboundHandler" )
+    {
+        SUBCASE( "Idle sessions time out" )
+        {
+            const auto dir = CleanReplayDir( "IdleTimeout" );
+            Broker broker( dir / "journal", 10 );
+            REQUIRE( broker.m_journal.Recover().has_value() );
+
+            broker.m_inbox.Push( net::InboundType::Connected, 1 );
+            broker.m_inbox.Push( net::InboundType::Connected, 2 );
+            broker.Step( 1, 0.0f );
+            for ( uint64_t tick = 2; tick <= 30; ++tick )
+            {
+                // Session 1 keeps talking, session 2 stays quiet.
+                const auto payload = PositionUpdate( 1.0f, 2.0f, 3.0f );
+                broker.m_inbox.Push( net::InboundType::Message, 1, payload );
+                broker.Step( tick, 0.0f );
+                if ( tick == 10 )
+                    CHECK( broker.m_inbound.SessionCount() == 2 );
+            }
+
+            CHECK( broker.m_inbound.SessionCount() == 1 );
+            CHECK( broker.m_inbound.TimedOutSessions() == 1 );
+            CHECK( broker.m_journal.CaptureState().entities.size() == 1 );
+        }
+
+        SUBCASE( "The session directory follows the session entities" )
+        {
+            const auto dir = CleanReplayDir( "SessionDirectory" );
+            Broker broker( dir / "journal" );
+            REQUIRE( broker.m_journal.Recover().has_value() );
+
+            broker.m_inbox.Push( net::InboundType::Connected, 1 );
+            broker.Step( 1, 0.0f );
+
+            // Sessions from before the directory are published as well.
+            net::SessionDirectory directory;
+            broker.m_inbound.MirrorInto( directory );
+            broker.m_inbox.Push( net::InboundType::Connected, 2 );
+            broker.Step( 2, 0.0f );
+            CHECK( directory.Size() == 2 );
+
+            const auto state = broker.m_journal.CaptureState();
+            for ( const auto & entity : state.entities )
+            {
+                REQUIRE( entity.presence.has_value() );
+                const auto session = directory.FindSession( entity.presence->session_id );
+                REQUIRE( session.has_value() );
+                CHECK( session->m_entity == entity.id );
+                CHECK( directory.FindPlayer( entity.id ) == entity.presence->session_id );
+            }
+
+            const auto change_world = wire::EncodeFrame( net::msg::SetWorld{ .world_id = 3 } );
+            broker.m_inbox.Push( net::InboundType::Message, 1, change_world );
+            broker.m_inbox.Push( net::InboundType::Disconnected, 2 );
+            broker.Step( 3, 0.0f );
+            REQUIRE( directory.FindSession( 1 ).has_value() );
+            CHECK( directory.FindSession( 1 )->m_world_id == 3 );
+            CHECK( !directory.FindSession( 2 ).has_value() );
+            CHECK( directory.Size() == 1 );
+
+            const std::array< net::SessionRename, 1 > renames{ { { .m_from = 1, .m_to = 7 } } };
+            const auto entity = directory.FindSession( 1 )->m_entity;
+            CHECK( broker.m_inbound.Resume( renames ).empty() );
+            CHECK( !directory.FindSession( 1 ).has_value() );
+            REQUIRE( directory.FindSession( 7 ).has_value() );
+            CHECK( directory.FindSession( 7 )->m_entity == entity );
+            CHECK( directory.FindSession( 7 )->m_world_id == 3 );
+            CHECK( directory.FindPlayer( entity ) == 7u );
+        }
+    }
+} // namespace shm::replay
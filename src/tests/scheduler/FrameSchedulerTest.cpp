@@ -0,0 +1,202 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "metrics/Metrics.hpp"
+#include "scheduler/FrameScheduler.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using shm::sched::Clock;
+
+    /// @brief The 120 Hz budget of the broker main loop.
+    constexpr auto G_FRAME_BUDGET = std::chrono::duration_cast< Clock::duration >( 1s ) / 120;
+
+    /// @brief Time that only moves when the test moves it, so frame times do not depend on the machine running the test.
+    struct FakeClock
+    {
+        Clock::time_point m_now{ 1h };
+
+        shm::sched::FrameScheduler::TimeSource Source()
+        {
+            return [ this ]() { return m_now; };
+        }
+    };
+
+    /// @brief Job doing total worth of work in steps of step_duration, each step advances the clock by its duration.
+    std::function< shm::sched::StepResult() > BusyJob( FakeClock & clock, Clock::duration total, Clock::duration step_duration,
+                                                       std::size_t * steps_done = nullptr )
+    {
+        return [ &clock, remaining = total, step_duration, steps_done ]() mutable
+        {
+            clock.m_now += step_duration;
+            remaining -= step_duration;
+            if ( steps_done )
+                ++*steps_done;
+            return remaining > Clock::duration::zero() ? shm::sched::StepResult::Continue : shm::sched::StepResult::Done;
+        };
+    }
+} // namespace
+
+TEST_CASE( "shm::sched::FrameScheduler" )
+{
+    using namespace shm::sched;
+
+    shm::metrics::Registry registry;
+    FakeClock clock;
+    FrameScheduler scheduler( registry, FrameScheduler::DefaultMaxPassedOver, clock.Source() );
+
+    SUBCASE( "A 500 ms job is spread over frames without any frame over budget" )
+    {
+        scheduler.Submit( { .m_name = "snapshot", .m_priority = JobPriority::Low }, BusyJob( clock, 500ms, 1ms ) );
+
+        std::size_t frames      = 0;
+        std::size_t over_budget = 0;
+        Clock::duration longest_frame{};
+        while ( scheduler.Backlog() != 0 && frames < 1000 )
+        {
+            const auto frame_start = clock.m_now;
+            const auto frame_end   = frame_start + G_FRAME_BUDGET;
+            // The tick itself.
+            clock.m_now += 2ms;
+            scheduler.RunUntil( frame_end );
+
+            const auto frame_time = clock.m_now - frame_start;
+            longest_frame         = std::max( longest_frame, frame_time );
+            if ( frame_time > G_FRAME_BUDGET )
+                ++over_budget;
+            clock.m_now = std::max( clock.m_now, frame_end );
+            ++frames;
+        }
+
+        INFO( "longest frame: ", std::chrono::duration< double, std::milli >( longest_frame ).count(), " ms" );
+        CHECK( scheduler.Backlog() == 0 );
+        CHECK( over_budget == 0 );
+        // 500 ms of work in six 1 ms steps per frame.
+        CHECK( frames >= 80 );
+        CHECK( frames <= 90 );
+    }
+
+    SUBCASE( "Jobs run by priority, then by deadline" )
+    {
+        std::vector< std::string > order;
+        const auto record = [ &order ]( std::string name )
+        {
+            return [ &order, name ]()
+            {
+                order.push_back( name );
+                return StepResult::Done;
+            };
+        };
+        scheduler.Submit( { .m_name = "low", .m_priority = JobPriority::Low }, record( "low" ) );
+        scheduler.Submit( { .m_name = "normal-late", .m_deadline = 10s }, record( "normal-late" ) );
+        scheduler.Submit( { .m_name = "normal-soon", .m_deadline = 1s }, record( "normal-soon" ) );
+        scheduler.Submit( { .m_name = "normal-none" }, record( "normal-none" ) );
+        scheduler.Submit( { .m_name = "high", .m_priority = JobPriority::High }, record( "high" ) );
+
+        const auto stats = scheduler.RunUntil( clock.m_now + 1s );
+        CHECK( stats.m_completed == 5 );
+        CHECK( order == std::vector< std::string >{ "high", "normal-soon", "normal-late", "normal-none", "low" } );
+    }
+
+    SUBCASE( "Jobs below the lowest priority wait" )
+    {
+        std::size_t low_steps    = 0;
+        std::size_t normal_steps = 0;
+        scheduler.Submit( { .m_name = "low", .m_priority = JobPriority::Low }, BusyJob( clock, 1ms, 1ms, &low_steps ) );
+        scheduler.Submit( { .m_name = "normal" }, BusyJob( clock, 1ms, 1ms, &normal_steps ) );
+
+        scheduler.RunUntil( clock.m_now + 1s, JobPriority::Normal );
+        CHECK( normal_steps == 1 );
+        CHECK( low_steps == 0 );
+        CHECK( scheduler.Backlog() == 1 );
+        scheduler.RunUntil( clock.m_now + 1s );
+        CHECK( low_steps == 1 );
+    }
+
+    SUBCASE( "Steps that do not fit wait for the next frame" )
+    {
+        std::size_t steps = 0;
+        scheduler.Submit( { .m_name = "slow" }, BusyJob( clock, 20ms, 5ms, &steps ) );
+
+        // The first step has no estimate yet and runs, the second one would overrun the frame.
+        scheduler.RunUntil( clock.m_now + 7ms );
+        CHECK( steps == 1 );
+        scheduler.RunUntil( clock.m_now + 1ms );
+        CHECK( steps == 1 );
+        scheduler.RunUntil( clock.m_now + 12ms );
+        CHECK( steps == 3 );
+    }
+
+    SUBCASE( "Jobs behind one that does not fit still run" )
+    {
+        std::size_t slow_steps = 0;
+        std::size_t fast_steps = 0;
+        scheduler.Submit( { .m_name = "slow", .m_priority = JobPriority::High }, BusyJob( clock, 20ms, 5ms, &slow_steps ) );
+        scheduler.RunUntil( clock.m_now + 1ms );
+        REQUIRE( slow_steps == 1 );
+
+        scheduler.Submit( { .m_name = "fast" }, BusyJob( clock, 2ms, 1ms, &fast_steps ) );
+        scheduler.RunUntil( clock.m_now + 4ms );
+        CHECK( slow_steps == 1 );
+        CHECK( fast_steps == 2 );
+    }
+
+    SUBCASE( "Jobs passed over for too long run without fitting" )
+    {
+        FrameScheduler starving( registry, 3, clock.Source() );
+        std::size_t steps = 0;
+        starving.Submit( { .m_name = "slow" }, BusyJob( clock, 4ms, 2ms, &steps ) );
+        starving.RunUntil( clock.m_now + 1ms );
+        REQUIRE( steps == 1 );
+
+        // Frames that are already late, as after a slow tick.
+        std::size_t forced = 0;
+        for ( int frame = 0; frame < 4; ++frame )
+            forced += starving.RunUntil( clock.m_now ).m_forced;
+        CHECK( steps == 2 );
+        CHECK( forced == 1 );
+        CHECK( starving.Backlog() == 0 );
+        CHECK( registry.GetCounter( "shm_deferred_forced_steps_total" ).Value() == 1 );
+    }
+
+    SUBCASE( "Jobs below the lowest priority are not forced" )
+    {
+        FrameScheduler starving( registry, 1, clock.Source() );
+        std::size_t steps = 0;
+        const auto id     = starving.Submit( { .m_name = "low", .m_priority = JobPriority::Low }, BusyJob( clock, 1ms, 1ms, &steps ) );
+        for ( int frame = 0; frame < 4; ++frame )
+            starving.RunUntil( clock.m_now, JobPriority::Normal );
+        CHECK( steps == 0 );
+        CHECK( starving.IsQueued( id ) );
+        starving.RunUntil( clock.m_now + 1s );
+        CHECK( !starving.IsQueued( id ) );
+    }
+
+    SUBCASE( "Deadline misses are counted once per job" )
+    {
+        scheduler.Submit( { .m_name = "urgent", .m_deadline = 1ms }, BusyJob( clock, 10ms, 2ms ) );
+        clock.m_now += 2ms;
+
+        for ( int frame = 0; frame < 10 && scheduler.Backlog() != 0; ++frame )
+            scheduler.RunUntil( clock.m_now + 3ms );
+        CHECK( scheduler.Backlog() == 0 );
+        CHECK( scheduler.DeadlineMisses() == 1 );
+        CHECK( registry.GetCounter( "shm_deferred_deadline_misses_total" ).Value() == 1 );
+    }
+
+    SUBCASE( "Cancelled jobs do not run" )
+    {
+        std::size_t steps = 0;
+        const auto id     = scheduler.Submit( { .m_name = "cancelled" }, BusyJob( clock, 1ms, 1ms, &steps ) );
+        CHECK( scheduler.Cancel( id ) );
+        CHECK( !scheduler.Cancel( id ) );
+        scheduler.RunUntil( clock.m_now + 10ms );
+        CHECK( steps == 0 );
+        CHECK( scheduler.Backlog() == 0 );
+    }
+}
@@ -0,0 +1,181 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "hash/Crc32c.hpp"
+#include "protocol/FrameHeader.hpp"
+#include "simd/Simd.hpp"
+#include "strings/String.hpp"
+#include "strings/Utf8.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// @brief Every level the machine running the tests supports, each kernel is checked against the scalar one on all.
+    std::vector< shm::simd::Level > SupportedLevels()
+    {
+        std::vector< shm::simd::Level > levels;
+        for ( auto level : { shm::simd::Level::Scalar, shm::simd::Level::Sse42, shm::simd::Level::Avx2 } )
+        {
+            if ( level <= shm::simd::DetectedLevel() )
+                levels.push_back( level );
+        }
+        return levels;
+    }
+
+    struct ScopedMaxLevel
+    {
+        explicit ScopedMaxLevel( shm::simd::Level level )
+        {
+            shm::simd::SetMaxLevel( level );
+        }
+
+        ~ScopedMaxLevel()
+        {
+            shm::simd::SetMaxLevel( shm::simd::Level::Avx2 );
+        }
+    };
+
+    std::vector< std::byte > RandomBytes( std::size_t size, uint32_t seed )
+    {
+        std::mt19937 rng( seed );
+        std::vector< std::byte > bytes( size );
+        for ( auto & value : bytes )
+            value = static_cast< std::byte >( rng() );
+        return bytes;
+    }
+} // namespace
+
+TEST_CASE( "shm::hash::Crc32c" )
+{
+    static_assert( shm::hash::Crc32c( std::span< const std::byte >{} ) == 0 );
+
+    const std::string_view check = "123456789";
+    const auto bytes             = RandomBytes( 100'000, 1 );
+    for ( auto level : SupportedLevels() )
+    {
+        CAPTURE( shm::simd::LevelName( level ) );
+        ScopedMaxLevel scoped( level );
+        CHECK( shm::hash::Crc32c( std::as_bytes( std::span( check ) ) ) == 0xE3069283u );
+
+        // Unaligned starts and sizes around the three stream block sizes.
+        for ( std::size_t offset : { 0, 1, 5 } )
+        {
+            for ( std::size_t size : { 0, 7, 8, 255, 768, 769, 24'575, 24'576, 24'583, 90'000 } )
+            {
+                const auto data = std::span( bytes ).subspan( offset, size );
+                CHECK( shm::hash::Crc32c( data, 0xABCDu ) == shm::hash::Crc32cScalar( data, 0xABCDu ) );
+            }
+        }
+
+        // Checksumming in pieces gives the same result as in one go.
+        const auto whole = std::span( bytes ).first( 50'000 );
+        CHECK( shm::hash::Crc32c( whole.subspan( 30'000 ), shm::hash::Crc32c( whole.first( 30'000 ) ) ) == shm::hash::Crc32c( whole ) );
+    }
+}
+
+TEST_CASE( "shm::str::IsValidUtf8" )
+{
+    const std::vector< std::pair< std::string, bool > > cases{
+        { "", true },
+        { "plain ascii", true },
+        { "gr\xC3\xBC\xC3\x9F\x65 \xE2\x82\xAC \xF0\x9F\x98\x80", true },
+        { "\xF4\x8F\xBF\xBF", true },           // U+10FFFF
+        { "\xED\x9F\xBF", true },               // U+D7FF, just below the surrogates
+        { "\xC0\xAF", false },                  // overlong '/'
+        { "\xE0\x80\xAF", false },              // overlong, three bytes
+        { "\xF0\x80\x80\xAF", false },          // overlong, four bytes
+        { "\xED\xA0\x80", false },              // surrogate U+D800
+        { "\xF4\x90\x80\x80", false },          // above U+10FFFF
+        { "\xF8\x88\x80\x80\x80", false },      // five byte form
+        { "\x80", false },                      // stray continuation
+        { "\xC3", false },                      // cut short at the end
+        { "\xE2\x82", false },
+        { "\xC3\x41", false },                  // continuation missing
+        { "\xE2\x82\xAC\xAC", false },          // one continuation too many
+    };
+
+    for ( auto level : SupportedLevels() )
+    {
+        CAPTURE( shm::simd::LevelName( level ) );
+        ScopedMaxLevel scoped( level );
+        for ( const auto & [ text, valid ] : cases )
+        {
+            CAPTURE( text );
+            CHECK( shm::str::IsValidUtf8( text ) == valid );
+            // Again at every position relative to a vector block and across a block boundary.
+            for ( std::size_t prefix = 1; prefix < 40; ++prefix )
+                CHECK( shm::str::IsValidUtf8( std::string( prefix, 'a' ) + text + "tail" ) == valid );
+        }
+
+        // Random mixes of valid sequences, some of them corrupted, agree with the scalar implementation.
+        std::mt19937 rng( 42 );
+        const std::vector< std::string > pieces{ "a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xEF\xBF\xBF" };
+        for ( int i = 0; i < 5'000; ++i )
+        {
+            std::string text;
+            for ( uint32_t count = rng() % 80; count > 0; --count )
+                text += pieces[ rng() % pieces.size() ];
+            if ( !text.empty() && rng() % 2 == 0 )
+                text[ rng() % text.size() ] = static_cast< char >( rng() );
+            const auto bytes = std::as_bytes( std::span( text ) );
+            CHECK( shm::str::IsValidUtf8( bytes ) == shm::str::IsValidUtf8Scalar( bytes ) );
+        }
+    }
+}
+
+TEST_CASE( "shm::protocol::FindInvalidHeader" )
+{
+    const shm::protocol::FrameLimits limits{ .m_min_length = 4, .m_max_length = 1024, .m_min_opcode = 1, .m_max_opcode = 200 };
+    std::vector< shm::protocol::FrameHeader > headers( 100, { .m_length = 16, .m_opcode = 7, .m_checksum = 0xFFFFFFFFu } );
+
+    for ( auto level : SupportedLevels() )
+    {
+        CAPTURE( shm::simd::LevelName( level ) );
+        ScopedMaxLevel scoped( level );
+        CHECK( shm::protocol::FindInvalidHeader( headers, limits ) == headers.size() );
+        CHECK( shm::protocol::FindInvalidHeader( {}, limits ) == 0 );
+
+        // Out of range in each field, at the edges of the vector blocks and behind a second invalid header.
+        for ( std::size_t bad : { 0, 5, 31, 32, 33, 98 } )
+        {
+            for ( int field = 0; field < 3; ++field )
+            {
+                CAPTURE( bad );
+                CAPTURE( field );
+                auto broken = headers;
+                if ( field == 0 )
+                    broken[ bad ].m_length = 1025;
+                else if ( field == 1 )
+                    broken[ bad ].m_opcode = 0;
+                else
+                    broken[ bad ].m_opcode = 201;
+                broken[ 99 ].m_length = 3;
+                CHECK( shm::protocol::FindInvalidHeader( broken, limits ) == bad );
+            }
+        }
+    }
+
+    const std::string_view payload = "payload!";
+    shm::protocol::FrameHeader header{ .m_length = static_cast< uint16_t >( payload.size() ), .m_opcode = 1 };
+    header.m_checksum = shm::hash::Crc32c( std::as_bytes( std::span( payload ) ) );
+    CHECK( shm::protocol::ChecksumMatches( header, std::as_bytes( std::span( payload ) ) ) );
+    CHECK( !shm::protocol::ChecksumMatches( header, std::as_bytes( std::span( payload ).first( 7 ) ) ) );
+}
+
+TEST_CASE( "ed::str::ConvertWide" )
+{
+    const std::string utf8 = "Shimmer \xC3\xBC\xC3\x9F \xE2\x82\xAC \xF0\x9F\x98\x80, followed by a long stretch of plain ASCII text";
+    const auto wide        = ed::str::ConvertToWide( utf8.c_str() );
+    CHECK( ed::str::ConvertWide( wide.c_str() ) == utf8 );
+    CHECK( wide.substr( 0, 8 ) == L"Shimmer " );
+    CHECK( wide[ 8 ] == L'ü' );
+    // A surrogate pair on Windows, a single code unit elsewhere.
+    CHECK( wide.find( L"\U0001F600" ) != std::wstring::npos );
+
+    CHECK( ed::str::ConvertToWide( "a\xFF" "b\xE2\x82" ) == L"a�b��" );
+    CHECK( ed::str::ConvertToWide( nullptr ).empty() );
+    CHECK( ed::str::ConvertWide( nullptr ).empty() );
+}
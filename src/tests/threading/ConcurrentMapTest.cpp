@@ -0,0 +1,180 @@
+#include <doctest/doctest.h>
+
+#include "threading/ConcurrentMap.hpp"
+#include "threading/EpochDomain.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Counted
+    {
+        explicit Counted( std::atomic< int > & freed )
+            : m_freed( freed )
+        {
+        }
+
+        ~Counted()
+        {
+            m_freed.fetch_add( 1 );
+        }
+
+        std::atomic< int > & m_freed;
+    };
+
+    /// @brief What writers store, readers can tell a torn or foreign value apart.
+    struct Entry
+    {
+        uint64_t m_key     = 0;
+        uint64_t m_version = 0;
+    };
+} // namespace
+
+TEST_CASE( "shm::EpochDomain" )
+{
+    SUBCASE( "Retired objects outlive the readers that pinned before" )
+    {
+        std::atomic< int > freed{ 0 };
+        shm::EpochDomain epochs;
+
+        auto guard = epochs.Pin();
+        epochs.Retire( new Counted( freed ) );
+        for ( int i = 0; i < 4; ++i )
+            epochs.Collect();
+        CHECK( freed == 0 );
+
+        {
+            auto released = std::move( guard );
+        }
+        for ( int i = 0; i < 4; ++i )
+            epochs.Collect();
+        CHECK( freed == 1 );
+    }
+
+    SUBCASE( "Whatever is still retired goes with the domain" )
+    {
+        std::atomic< int > freed{ 0 };
+        {
+            shm::EpochDomain epochs;
+            for ( int i = 0; i < 10; ++i )
+                epochs.Retire( new Counted( freed ) );
+        }
+        CHECK( freed == 10 );
+    }
+}
+
+TEST_CASE( "shm::ConcurrentMap" )
+{
+    SUBCASE( "Insert, assign and erase" )
+    {
+        shm::ConcurrentMap< uint64_t, uint32_t > map;
+        CHECK( !map.Find( 7 ).has_value() );
+        CHECK( map.InsertOrAssign( 7, 70 ) );
+        CHECK( !map.InsertOrAssign( 7, 71 ) );
+        CHECK( map.Find( 7 ) == 71u );
+        CHECK( map.Size() == 1 );
+
+        CHECK( map.Erase( 7 ) );
+        CHECK( !map.Erase( 7 ) );
+        CHECK( !map.Contains( 7 ) );
+        CHECK( map.Size() == 0 );
+
+        CHECK( map.InsertOrAssign( 7, 72 ) );
+        CHECK( map.Find( 7 ) == 72u );
+    }
+
+    SUBCASE( "Growing keeps every entry" )
+    {
+        shm::ConcurrentMap< uint64_t, uint64_t > map;
+        const auto initial_capacity = map.Capacity();
+        for ( uint64_t key = 0; key < 10'000; ++key )
+            map.InsertOrAssign( key, key * 3 );
+        for ( uint64_t key = 0; key < 10'000; key += 2 )
+            map.Erase( key );
+
+        CHECK( map.Capacity() > initial_capacity );
+        CHECK( map.Size() == 5'000 );
+        bool all_found = true;
+        for ( uint64_t key = 0; key < 10'000; ++key )
+            all_found = all_found && map.Find( key ) == ( key % 2 == 0 ? std::optional< uint64_t >{} : key * 3 );
+        CHECK( all_found );
+    }
+
+    SUBCASE( "Erasing and inserting the same keys does not grow the table" )
+    {
+        shm::ConcurrentMap< uint32_t, uint32_t > map( 100 );
+        const auto capacity = map.Capacity();
+        for ( uint32_t round = 0; round < 1'000; ++round )
+        {
+            for ( uint32_t key = 0; key < 100; ++key )
+            {
+                map.InsertOrAssign( key, round );
+                map.Erase( key );
+            }
+        }
+        CHECK( map.Capacity() == capacity );
+        CHECK( map.Size() == 0 );
+    }
+
+    SUBCASE( "Readers see whole values while writers grow the table" )
+    {
+        constexpr uint64_t keys_per_writer = 50'000;
+        constexpr int writers              = 4;
+        constexpr int readers              = 4;
+
+        shm::ConcurrentMap< uint64_t, Entry > map;
+        std::atomic< bool > writing{ true };
+        std::atomic< uint64_t > torn{ 0 };
+
+        {
+            std::vector< std::jthread > threads;
+            for ( int reader = 0; reader < readers; ++reader )
+            {
+                threads.emplace_back(
+                    [ & ]()
+                    {
+                        uint64_t key = 0;
+                        while ( writing.load() )
+                        {
+                            key = ( key + 7919 ) % ( keys_per_writer * writers );
+                            const auto entry = map.Find( key );
+                            if ( entry && ( entry->m_key != key || entry->m_version > 2 ) )
+                                torn.fetch_add( 1, std::memory_order_relaxed );
+                        }
+                    } );
+            }
+
+            std::vector< std::jthread > writer_threads;
+            for ( int writer = 0; writer < writers; ++writer )
+            {
+                writer_threads.emplace_back(
+                    [ &, writer ]()
+                    {
+                        const uint64_t first = keys_per_writer * static_cast< uint64_t >( writer );
+                        for ( uint64_t key = first; key < first + keys_per_writer; ++key )
+                            map.InsertOrAssign( key, { key, 1 } );
+                        for ( uint64_t key = first; key < first + keys_per_writer; key += 2 )
+                            map.InsertOrAssign( key, { key, 2 } );
+                        for ( uint64_t key = first + 1; key < first + keys_per_writer; key += 2 )
+                            map.Erase( key );
+                    } );
+            }
+            writer_threads.clear();
+            writing = false;
+        }
+
+        CHECK( torn == 0 );
+        CHECK( map.Size() == keys_per_writer * writers / 2 );
+
+        bool consistent = true;
+        for ( uint64_t key = 0; key < keys_per_writer * writers; ++key )
+        {
+            const auto entry = map.Find( key );
+            consistent       = consistent && ( key % 2 == 0 ? entry.has_value() && entry->m_version == 2 : !entry.has_value() );
+        }
+        CHECK( consistent );
+    }
+}
@@ -0,0 +1,70 @@
+#include <doctest/doctest.h>
+
+#include "threading/SpscQueue.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+TEST_CASE( "shm::SpscQueue" )
+{
+    SUBCASE( "Capacity is rounded up and bounds the queue" )
+    {
+        shm::SpscQueue< int > queue( 5 );
+        CHECK( queue.Capacity() == 8 );
+        for ( int i = 0; i < 8; ++i )
+            CHECK( queue.TryPush( i ) );
+        CHECK( !queue.TryPush( 8 ) );
+        CHECK( queue.Size() == 8 );
+
+        CHECK( queue.TryPop() == 0 );
+        CHECK( queue.TryPush( 8 ) );
+        for ( int i = 1; i <= 8; ++i )
+            CHECK( queue.TryPop() == i );
+        CHECK( !queue.TryPop().has_value() );
+    }
+
+    SUBCASE( "Move only values" )
+    {
+        shm::SpscQueue< std::unique_ptr< int > > queue( 2 );
+        CHECK( queue.TryPush( std::make_unique< int >( 7 ) ) );
+        auto value = queue.TryPop();
+        REQUIRE( value.has_value() );
+        CHECK( **value == 7 );
+    }
+
+    SUBCASE( "Values cross threads in order" )
+    {
+        constexpr uint64_t count = 1'000'000;
+        shm::SpscQueue< uint64_t > queue( 64 );
+
+        std::jthread producer(
+            [ & ]()
+            {
+                for ( uint64_t i = 0; i < count; )
+                {
+                    if ( queue.TryPush( i ) )
+                        ++i;
+                    else
+                        std::this_thread::yield();
+                }
+            } );
+
+        uint64_t expected = 0;
+        bool in_order     = true;
+        while ( expected < count )
+        {
+            if ( auto value = queue.TryPop() )
+            {
+                in_order = in_order && *value == expected;
+                ++expected;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        CHECK( in_order );
+        CHECK( queue.Size() == 0 );
+    }
+}
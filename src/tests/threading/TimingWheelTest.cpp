@@ -0,0 +1,150 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "threading/TaskResult.hpp"
+#include "threading/TimingWheel.hpp"
+
+#include <map>
+#include <random>
+#include <vector>
+
+TEST_CASE( "shm::TimingWheel" )
+{
+    using Wheel = shm::TimingWheel< uint64_t >;
+
+    SUBCASE( "Timers fire at their deadline" )
+    {
+        Wheel wheel;
+        std::vector< std::pair< uint64_t, uint64_t > > fired;
+        for ( uint64_t deadline : { 1ull, 5ull, 255ull, 256ull, 257ull, 70'000ull, 16'777'300ull } )
+            wheel.Schedule( deadline, deadline );
+        CHECK( wheel.Size() == 7 );
+
+        for ( uint64_t tick = 1; tick <= 16'777'400; ++tick )
+            wheel.Advance( tick, [ & ]( uint64_t payload ) { fired.emplace_back( wheel.Now(), payload ); } );
+
+        REQUIRE( fired.size() == 7 );
+        for ( const auto & [ tick, payload ] : fired )
+            CHECK( tick == payload );
+        CHECK( wheel.Size() == 0 );
+    }
+
+    SUBCASE( "Deadlines beyond the wheel wait in the overflow list" )
+    {
+        Wheel wheel( ( 1ull << 32 ) - 10 );
+        const uint64_t far = ( 1ull << 33 ) + 3;
+        wheel.Schedule( far, 1 );
+
+        std::size_t fired = wheel.Advance( far - 1, []( uint64_t ) {} );
+        CHECK( fired == 0 );
+        fired = wheel.Advance( far, []( uint64_t ) {} );
+        CHECK( fired == 1 );
+    }
+
+    SUBCASE( "Cancelled and rescheduled timers" )
+    {
+        Wheel wheel;
+        auto cancelled   = wheel.Schedule( 10, 1 );
+        auto rescheduled = wheel.Schedule( 10, 2 );
+        CHECK( wheel.Cancel( cancelled ) );
+        CHECK( !wheel.Cancel( cancelled ) );
+        CHECK( wheel.Reschedule( rescheduled, 600 ) );
+        CHECK( *wheel.Get( rescheduled ) == 2 );
+
+        std::vector< uint64_t > fired;
+        wheel.Advance( 599, [ & ]( uint64_t payload ) { fired.push_back( payload ); } );
+        CHECK( fired.empty() );
+        wheel.Advance( 600, [ & ]( uint64_t payload ) { fired.push_back( payload ); } );
+        CHECK( fired == std::vector< uint64_t >{ 2 } );
+        CHECK( !wheel.IsPending( rescheduled ) );
+        CHECK( wheel.Get( rescheduled ) == nullptr );
+
+        // The slot is reused, the stale handle must not reach the new timer.
+        auto reused = wheel.Schedule( 700, 3 );
+        CHECK( reused.m_index == rescheduled.m_index );
+        CHECK( !wheel.Cancel( rescheduled ) );
+        CHECK( wheel.IsPending( reused ) );
+    }
+
+    SUBCASE( "Past deadlines and timers scheduled while firing go to the next tick" )
+    {
+        Wheel wheel( 100 );
+        wheel.Schedule( 50, 1 );
+
+        std::vector< std::pair< uint64_t, uint64_t > > fired;
+        const auto on_expired = [ & ]( uint64_t payload )
+        {
+            fired.emplace_back( wheel.Now(), payload );
+            if ( payload == 1 )
+                wheel.Schedule( wheel.Now(), 2 );
+        };
+        wheel.Advance( 101, on_expired );
+        wheel.Advance( 105, on_expired );
+        REQUIRE( fired.size() == 2 );
+        CHECK( fired[ 0 ] == std::pair< uint64_t, uint64_t >{ 101, 1 } );
+        CHECK( fired[ 1 ] == std::pair< uint64_t, uint64_t >{ 102, 2 } );
+    }
+
+    SUBCASE( "Emitted cancellation signals drop their timers" )
+    {
+        Wheel wheel;
+        auto signal = std::make_shared< ed::thread::CancellationSignal >();
+        Threading::TaskResult< void > task( std::future< void >{}, std::weak_ptr( signal ) );
+        wheel.Schedule( 20, 1, task.CancelSignal() );
+        wheel.Schedule( 20, 2 );
+
+        CHECK( task.StopTask() );
+        std::vector< uint64_t > fired;
+        wheel.Advance( 20, [ & ]( uint64_t payload ) { fired.push_back( payload ); } );
+        CHECK( fired == std::vector< uint64_t >{ 2 } );
+        CHECK( wheel.Size() == 0 );
+    }
+
+    SUBCASE( "Random churn matches a reference" )
+    {
+        Wheel wheel;
+        std::mt19937_64 random( 7 );
+        std::map< uint64_t, std::pair< shm::TimerHandle, uint64_t > > expected;
+        uint64_t next_id = 0;
+        uint64_t errors  = 0;
+
+        for ( uint64_t tick = 1; tick <= 20'000; ++tick )
+        {
+            for ( int i = 0; i < 8; ++i )
+            {
+                const uint64_t deadline = tick + random() % ( random() % 2 ? 300 : 100'000 );
+                const auto id           = next_id++;
+                expected[ id ]          = { wheel.Schedule( deadline, id ), std::max( deadline, tick ) };
+            }
+            if ( !expected.empty() )
+            {
+                auto iter = expected.lower_bound( random() % next_id );
+                if ( iter != expected.end() )
+                {
+                    if ( random() % 2 )
+                    {
+                        CHECK( wheel.Cancel( iter->second.first ) );
+                        expected.erase( iter );
+                    }
+                    else
+                    {
+                        iter->second.second = tick + random() % 5'000;
+                        CHECK( wheel.Reschedule( iter->second.first, iter->second.second ) );
+                    }
+                }
+            }
+
+            wheel.Advance( tick,
+                           [ & ]( uint64_t id )
+                           {
+                               auto iter = expected.find( id );
+                               if ( iter == expected.end() || iter->second.second != tick )
+                                   ++errors;
+                               else
+                                   expected.erase( iter );
+                           } );
+        }
+        CHECK( errors == 0 );
+        CHECK( wheel.Size() == expected.size() );
+    }
+}
@@ -0,0 +1,94 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "filesystem/Filesystem.hpp"
+#include "logging/Logging.hpp"
+#include "tracing/Tracing.hpp"
+
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+    const std::filesystem::path G_TRACE_DIR = "./Testing/Traces";
+}
+
+namespace shm::trace
+{
+    TEST_CASE( "shm::trace" )
+    {
+        SUBCASE( "Nothing is recorded while disabled" )
+        {
+            Clear();
+            SetEnabled( false );
+            {
+                Span span{ "DisabledSpan" };
+                LogScope scope{ "DisabledScope" };
+            }
+
+            const auto file = G_TRACE_DIR / "disabled.json";
+            REQUIRE( DumpChromeTrace( file ).has_value() );
+            auto content = shm::fs::ReadFileToString( file );
+            REQUIRE( content.has_value() );
+            CHECK( content->find( "DisabledSpan" ) == std::string::npos );
+            CHECK( content->find( "DisabledScope" ) == std::string::npos );
+        }
+
+        SUBCASE( "Spans and log scopes of all threads are dumped" )
+        {
+            Clear();
+            SetEnabled( true );
+            {
+                Span span{ "MainSpan" };
+                LogScope scope{ "Quoted \"Scope\"" };
+            }
+            std::jthread( []
+                          {
+                              Span span{ "WorkerSpan" };
+                          } )
+                .join();
+            SetEnabled( false );
+
+            const auto file = G_TRACE_DIR / "enabled.json";
+            REQUIRE( DumpChromeTrace( file ).has_value() );
+            auto content = shm::fs::ReadFileToString( file );
+            REQUIRE( content.has_value() );
+            CHECK( content->starts_with( R"({"displayTimeUnit":"ns","traceEvents":[)" ) );
+            CHECK( content->find( R"({"name":"MainSpan","ph":"X")" ) != std::string::npos );
+            CHECK( content->find( R"({"name":"Quoted \"Scope\"","ph":"X")" ) != std::string::npos );
+            CHECK( content->find( R"({"name":"WorkerSpan","ph":"X")" ) != std::string::npos );
+        }
+
+        SUBCASE( "Buffers of exited threads are taken over by new threads" )
+        {
+            Clear();
+            SetEnabled( true );
+            std::jthread( []
+                          {
+                              Span span{ "FirstWorkerSpan" };
+                          } )
+                .join();
+            std::jthread( []
+                          {
+                              Span span{ "SecondWorkerSpan" };
+                          } )
+                .join();
+            SetEnabled( false );
+
+            const auto file = G_TRACE_DIR / "reused.json";
+            REQUIRE( DumpChromeTrace( file ).has_value() );
+            auto content = shm::fs::ReadFileToString( file );
+            REQUIRE( content.has_value() );
+            CHECK( content->find( "FirstWorkerSpan" ) == std::string::npos );
+            CHECK( content->find( "SecondWorkerSpan" ) != std::string::npos );
+        }
+
+        SUBCASE( "Dump requests are consumed once" )
+        {
+            CHECK( !ConsumeDumpRequest() );
+            RequestDump();
+            CHECK( ConsumeDumpRequest() );
+            CHECK( !ConsumeDumpRequest() );
+        }
+    }
+} // namespace shm::trace
@@ -0,0 +1,198 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "hash/Crc32c.hpp"
+#include "net/Messages.hpp"
+#include "wire/Codec.hpp"
+#include "wire/Dispatcher.hpp"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    enum class Stance : uint8_t
+    {
+        Idle    = 0,
+        Walking = 1,
+        Running = 4,
+    };
+
+    struct Vec3
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+    };
+
+    struct EntityState
+    {
+        static constexpr uint16_t Opcode = 7;
+
+        uint64_t id = 0;
+        Vec3 position;
+        std::array< int16_t, 2 > heading{};
+        Stance stance = Stance::Idle;
+        bool visible  = false;
+        shm::wire::FixedString< 8 > name;
+    };
+
+    /// @brief Records what it got so the tests can look at the decoded messages.
+    struct Recorder
+    {
+        std::vector< shm::net::msg::Move > m_moves;
+        std::vector< EntityState > m_states;
+
+        void On( const shm::net::msg::Move & message )
+        {
+            m_moves.push_back( message );
+        }
+
+        void On( const EntityState & message )
+        {
+            m_states.push_back( message );
+        }
+    };
+
+    using RecorderDispatcher = shm::wire::Dispatcher< Recorder, shm::net::msg::Move, EntityState >;
+
+    EntityState SampleState()
+    {
+        return { .id = 0x0102030405060708ull, .position = { 1.0f, -2.5f, 3.25f }, .heading = { -1, 300 }, .stance = Stance::Running, .visible = true, .name = shm::wire::FixedString< 8 >( "bot-7" ) };
+    }
+} // namespace
+
+TEST_CASE( "shm::wire::Codec" )
+{
+    using namespace shm::wire;
+
+    SUBCASE( "Sizes are known at compile time and carry no padding" )
+    {
+        static_assert( WireSize< shm::net::msg::Move > == 12 );
+        static_assert( WireSize< shm::net::msg::SetWorld > == 4 );
+        static_assert( WireSize< Vec3 > == 12 );
+        static_assert( WireSize< EntityState > == 8 + 12 + 4 + 1 + 1 + 9 );
+        static_assert( FrameSize< shm::net::msg::Move > == 20 );
+    }
+
+    SUBCASE( "Fields are laid out in order and little endian" )
+    {
+        const auto bytes = Encode( SampleState() );
+        CHECK( bytes[ 0 ] == std::byte{ 0x08 } );
+        CHECK( bytes[ 7 ] == std::byte{ 0x01 } );
+
+        float x = 0.0f;
+        std::memcpy( &x, bytes.data() + 8, sizeof( x ) );
+        CHECK( x == 1.0f );
+        CHECK( bytes[ 20 ] == std::byte{ 0xFF } );
+        CHECK( bytes[ 22 ] == std::byte{ 0x2C } );
+        CHECK( bytes[ 23 ] == std::byte{ 0x01 } );
+        CHECK( bytes[ 24 ] == std::byte{ 4 } );
+        CHECK( bytes[ 25 ] == std::byte{ 1 } );
+        CHECK( bytes[ 26 ] == std::byte{ 5 } );
+        CHECK( bytes[ 27 ] == std::byte{ 'b' } );
+    }
+
+    SUBCASE( "Round trip" )
+    {
+        const auto state   = SampleState();
+        const auto decoded = Decode< EntityState >( Encode( state ) );
+        REQUIRE( decoded.has_value() );
+        CHECK( decoded->id == state.id );
+        CHECK( decoded->position.y == state.position.y );
+        CHECK( decoded->heading == state.heading );
+        CHECK( decoded->stance == Stance::Running );
+        CHECK( decoded->visible );
+        CHECK( decoded->name.View() == "bot-7" );
+    }
+
+    SUBCASE( "Wrong sizes are rejected" )
+    {
+        const auto bytes = Encode( SampleState() );
+        CHECK( Decode< EntityState >( std::span( bytes ).first( bytes.size() - 1 ) ).error() == std::errc::message_size );
+        CHECK( Decode< shm::net::msg::SetWorld >( bytes ).error() == std::errc::message_size );
+    }
+
+    SUBCASE( "Values a field cannot hold are rejected" )
+    {
+        auto unknown_stance = Encode( SampleState() );
+        unknown_stance[ 24 ] = std::byte{ 2 };
+        CHECK( Decode< EntityState >( unknown_stance ).error() == std::errc::illegal_byte_sequence );
+
+        auto bad_bool = Encode( SampleState() );
+        bad_bool[ 25 ] = std::byte{ 2 };
+        CHECK( Decode< EntityState >( bad_bool ).error() == std::errc::illegal_byte_sequence );
+
+        auto long_name = Encode( SampleState() );
+        long_name[ 26 ] = std::byte{ 9 };
+        CHECK( Decode< EntityState >( long_name ).error() == std::errc::illegal_byte_sequence );
+
+        auto bad_utf8 = Encode( SampleState() );
+        bad_utf8[ 27 ] = std::byte{ 0xC3 };
+        CHECK( Decode< EntityState >( bad_utf8 ).error() == std::errc::illegal_byte_sequence );
+    }
+
+    SUBCASE( "Fixed strings are cut at a complete UTF-8 sequence" )
+    {
+        const FixedString< 4 > name( "ab\xC3\xA9\xC3\xA9" );
+        CHECK( name.View() == "ab\xC3\xA9" );
+
+        const FixedString< 3 > cut( "ab\xC3\xA9" );
+        CHECK( cut.View() == "ab" );
+    }
+}
+
+TEST_CASE( "shm::wire::Dispatcher" )
+{
+    using namespace shm::wire;
+
+    SUBCASE( "Frames reach the handler of their opcode" )
+    {
+        Recorder recorder;
+        const auto move  = EncodeFrame( shm::net::msg::Move{ .x = 1.0f, .y = 2.0f, .z = 3.0f } );
+        const auto state = EncodeFrame( SampleState() );
+        CHECK( RecorderDispatcher::DispatchFrame( recorder, move ) == DispatchResult::Handled );
+        CHECK( RecorderDispatcher::DispatchFrame( recorder, state ) == DispatchResult::Handled );
+
+        REQUIRE( recorder.m_moves.size() == 1 );
+        CHECK( recorder.m_moves[ 0 ].z == 3.0f );
+        REQUIRE( recorder.m_states.size() == 1 );
+        CHECK( recorder.m_states[ 0 ].name.View() == "bot-7" );
+    }
+
+    SUBCASE( "Frame headers carry length, opcode and checksum" )
+    {
+        const auto frame = EncodeFrame( shm::net::msg::Move{ .x = 1.0f } );
+        shm::protocol::FrameHeader header;
+        std::memcpy( &header, frame.data(), sizeof( header ) );
+        CHECK( header.m_length == 12 );
+        CHECK( header.m_opcode == shm::net::msg::Move::Opcode );
+        CHECK( header.m_checksum == shm::hash::Crc32c( std::span( frame ).subspan( sizeof( header ) ) ) );
+        CHECK( shm::protocol::IsWithin( header, RecorderDispatcher::Limits() ) );
+    }
+
+    SUBCASE( "Unknown opcodes and broken frames are not dispatched" )
+    {
+        Recorder recorder;
+        const auto move = Encode( shm::net::msg::Move{} );
+        CHECK( RecorderDispatcher::Dispatch( recorder, 3, move ) == DispatchResult::UnknownOpcode );
+        CHECK( RecorderDispatcher::Dispatch( recorder, 1000, move ) == DispatchResult::UnknownOpcode );
+        CHECK( RecorderDispatcher::Dispatch( recorder, EntityState::Opcode, move ) == DispatchResult::Malformed );
+
+        auto corrupt = EncodeFrame( shm::net::msg::Move{ .x = 1.0f } );
+        corrupt.back() ^= std::byte{ 1 };
+        CHECK( RecorderDispatcher::DispatchFrame( recorder, corrupt ) == DispatchResult::Malformed );
+        CHECK( RecorderDispatcher::DispatchFrame( recorder, std::span( corrupt ).first( 4 ) ) == DispatchResult::Malformed );
+        CHECK( recorder.m_moves.empty() );
+    }
+
+    SUBCASE( "Limits span all messages" )
+    {
+        constexpr auto limits = RecorderDispatcher::Limits();
+        CHECK( limits.m_min_opcode == 1 );
+        CHECK( limits.m_max_opcode == 7 );
+        CHECK( limits.m_min_length == 12 );
+        CHECK( limits.m_max_length == WireSize< EntityState > );
+    }
+}
@@ -0,0 +1,208 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "journal/WorldCommands.hpp"
+#include "worlds/WorldCluster.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace std::chrono_literals;
+    using shm::journal::Presence;
+    using shm::journal::Transform;
+    using shm::journal::WorldCommand;
+
+    /// @brief Polls the cluster until the condition holds, like the broker tick would.
+    template< typename Condition >
+    bool PollUntil( shm::worlds::WorldCluster & cluster, Condition condition, std::chrono::milliseconds timeout = 5s )
+    {
+        const auto end = std::chrono::steady_clock::now() + timeout;
+        while ( std::chrono::steady_clock::now() < end )
+        {
+            cluster.Poll();
+            if ( condition() )
+                return true;
+            std::this_thread::sleep_for( 1ms );
+        }
+        return false;
+    }
+
+    std::vector< shm::worlds::WorldSettings > TwoWorlds()
+    {
+        return { { .m_id = 0, .m_name = "first", .m_tick_rate = 500 }, { .m_id = 1, .m_name = "second", .m_tick_rate = 500 } };
+    }
+
+    std::vector< WorldCommand > Join( uint64_t entity, uint64_t session, uint32_t world )
+    {
+        return { WorldCommand::Spawn( entity ), WorldCommand::Set( entity, Presence{ .session_id = session, .world_id = world } ) };
+    }
+
+    /// @brief Transform of the player as the world simulates it, the host has to be stopped.
+    std::optional< Transform > TransformIn( shm::worlds::WorldHost & host, uint64_t entity )
+    {
+        std::optional< Transform > found;
+        host.World().each(
+            [ & ]( const shm::worlds::Resident & resident, const Transform & transform )
+            {
+                if ( resident.m_entity == entity )
+                    found = transform;
+            } );
+        return found;
+    }
+} // namespace
+
+TEST_CASE( "shm::worlds::WorldCluster" )
+{
+    SUBCASE( "Players are placed into the world of their presence" )
+    {
+        shm::worlds::WorldCluster cluster( TwoWorlds() );
+        cluster.Start();
+        cluster.Route( Join( 1, 100, 0 ) );
+        cluster.Route( Join( 2, 200, 1 ) );
+        cluster.Route( Join( 3, 300, 1 ) );
+
+        auto & first  = *cluster.Find( 0 );
+        auto & second = *cluster.Find( 1 );
+        CHECK( PollUntil( cluster, [ & ]() { return first.Residents() == 1 && second.Residents() == 2; } ) );
+
+        const std::vector< WorldCommand > leave{ WorldCommand::Destroy( 2 ) };
+        cluster.Route( leave );
+        CHECK( PollUntil( cluster, [ & ]() { return second.Residents() == 1; } ) );
+        CHECK( cluster.Stats().m_transfers == 0 );
+    }
+
+    SUBCASE( "A world change hands the player over with its state" )
+    {
+        shm::worlds::WorldCluster cluster( TwoWorlds() );
+        cluster.Start();
+        cluster.Route( Join( 1, 100, 0 ) );
+        const std::vector< WorldCommand > move{ WorldCommand::Set( 1, Transform{ 1.0f, 2.0f, 3.0f } ) };
+        cluster.Route( move );
+
+        const std::vector< WorldCommand > change{ WorldCommand::Set( 1, Presence{ .session_id = 100, .world_id = 1 } ) };
+        cluster.Route( change );
+        auto & first  = *cluster.Find( 0 );
+        auto & second = *cluster.Find( 1 );
+        CHECK( PollUntil( cluster, [ & ]() { return cluster.Stats().m_transfers == 1 && second.Residents() == 1; } ) );
+        CHECK( first.Residents() == 0 );
+        CHECK( cluster.Stats().m_in_transit == 0 );
+
+        cluster.Stop();
+        const auto transform = TransformIn( second, 1 );
+        REQUIRE( transform.has_value() );
+        CHECK( transform->x == 1.0f );
+        CHECK( transform->z == 3.0f );
+        CHECK( !TransformIn( first, 1 ).has_value() );
+    }
+
+    SUBCASE( "Players of worlds without a host wait in the coordinator" )
+    {
+        shm::worlds::WorldCluster cluster( TwoWorlds() );
+        cluster.Start();
+        cluster.Route( Join( 1, 100, 7 ) );
+        cluster.Poll();
+        CHECK( cluster.Stats().m_unhosted == 1 );
+        CHECK( cluster.Find( 7 ) == nullptr );
+
+        const std::vector< WorldCommand > change{ WorldCommand::Set( 1, Presence{ .session_id = 100, .world_id = 0 } ) };
+        cluster.Route( change );
+        CHECK( PollUntil( cluster, [ & ]() { return cluster.Find( 0 )->Residents() == 1; } ) );
+        CHECK( cluster.Stats().m_unhosted == 0 );
+    }
+
+    SUBCASE( "Adopted players are placed before anything is routed" )
+    {
+        shm::journal::WorldSnapshot state;
+        state.entities.push_back( { .id = 5, .transform = Transform{ 4.0f, 0.0f, 0.0f }, .presence = Presence{ .session_id = 50, .world_id = 1 } } );
+        state.entities.push_back( { .id = 6, .transform = Transform{} } );
+
+        shm::worlds::WorldCluster cluster( TwoWorlds() );
+        cluster.Adopt( state );
+        cluster.Start();
+        CHECK( PollUntil( cluster, [ & ]() { return cluster.Find( 1 )->Residents() == 1; } ) );
+        CHECK( cluster.Find( 0 )->Residents() == 0 );
+    }
+
+    SUBCASE( "A slow world neither stalls the other worlds nor the coordinator" )
+    {
+        // The first world parks inside its tick until the test lets it go, so it is provably not taking commands.
+        std::atomic< bool > parked{ false };
+        std::atomic< bool > released{ false };
+        auto worlds                  = TwoWorlds();
+        worlds[ 0 ].m_queue_capacity = 4;
+        worlds[ 0 ].m_setup          = [ & ]( flecs::world & world )
+        {
+            world.system( "Stall" ).run(
+                [ & ]( flecs::iter & )
+                {
+                    parked.store( true );
+                    while ( !released.load() )
+                        std::this_thread::sleep_for( 1ms );
+                } );
+        };
+        shm::worlds::WorldCluster cluster( std::move( worlds ) );
+        cluster.Start();
+        const auto & slow = *cluster.Find( 0 );
+        const auto & fast = *cluster.Find( 1 );
+
+        cluster.Route( Join( 1, 100, 0 ) );
+        CHECK( PollUntil( cluster, [ & ]() { return parked.load(); } ) );
+        const auto slow_ticks = slow.Ticks();
+
+        // Routing to the parked world has to return, a coordinator blocked on it would never get here.
+        auto routed = std::async( std::launch::async,
+                                  [ & ]()
+                                  {
+                                      for ( int i = 0; i < 100; ++i )
+                                      {
+                                          const std::vector< WorldCommand > move{ WorldCommand::Set( 1, Transform{ static_cast< float >( i ), 0.0f, 0.0f } ) };
+                                          cluster.Route( move );
+                                      }
+                                  } );
+        const bool returned = routed.wait_for( 5s ) == std::future_status::ready;
+        CHECK( returned );
+        if ( !returned )
+        {
+            released.store( true );
+            routed.wait();
+        }
+        // Every Move after the first one that had to wait only replaced its transform.
+        CHECK( cluster.Stats().m_backlog == 1 );
+
+        const auto fast_ticks = fast.Ticks();
+        CHECK( PollUntil( cluster, [ & ]() { return fast.Ticks() >= fast_ticks + 20; } ) );
+        CHECK( slow.Ticks() == slow_ticks );
+
+        released.store( true );
+        CHECK( PollUntil( cluster, [ & ]() { return cluster.Stats().m_backlog == 0; } ) );
+        // The last commands were taken by the queue, the next ticks apply them.
+        const auto drained_ticks = slow.Ticks();
+        CHECK( PollUntil( cluster, [ & ]() { return slow.Ticks() >= drained_ticks + 5; } ) );
+        cluster.Stop();
+        CHECK( TransformIn( *cluster.Find( 0 ), 1 )->x == 99.0f );
+    }
+
+    SUBCASE( "A world that does not take its commands is reported as stalled" )
+    {
+        auto worlds                  = TwoWorlds();
+        worlds[ 0 ].m_queue_capacity = 4;
+        shm::worlds::WorldCluster cluster( std::move( worlds ) );
+
+        // Not started yet, nothing drains the queue.
+        constexpr uint64_t players = shm::worlds::WorldCluster::StalledBacklog + 4;
+        for ( uint64_t entity = 1; entity <= players; ++entity )
+            cluster.Route( Join( entity, entity, 0 ) );
+        cluster.Poll();
+        CHECK( cluster.StalledWorlds() == 1 );
+        CHECK( cluster.Stats().m_stalled == 1 );
+
+        cluster.Start();
+        CHECK( PollUntil( cluster, [ & ]() { return cluster.StalledWorlds() == 0 && cluster.Stats().m_backlog == 0; } ) );
+        CHECK( PollUntil( cluster, [ & ]() { return cluster.Find( 0 )->Residents() == players; } ) );
+    }
+}
@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+# Profile guided optimization pipeline for the Linux clang presets:
+#   1. instrumented build            (linux-clang-pgo-generate)
+#   2. training run                  (train.sh)
+#   3. merge of the raw profiles     (.build_linux/pgo/shimmer.profdata)
+#   4. optimized build               (linux-clang-pgo-use)
+#
+# Usage: pgo.sh [--report]
+#   --report  also builds linux-clang-release as reference, records its benchmark results and
+#             prints the speedup of the PGO build through the pgo_speedup_report target.
+set -euo pipefail
+
+ROOT=$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)
+PGO_DIR="$ROOT/.build_linux/pgo"
+RAW_DIR="$PGO_DIR/raw"
+PROFILE="$PGO_DIR/shimmer.profdata"
+LLVM_PROFDATA=${LLVM_PROFDATA:-llvm-profdata}
+
+REPORT=0
+for arg in "$@"; do
+    case "$arg" in
+        --report) REPORT=1 ;;
+        *) echo "unknown argument: $arg" >&2; exit 1 ;;
+    esac
+done
+
+cd "$ROOT"
+
+echo "== instrumented build"
+cmake --preset linux-clang-pgo-generate
+cmake --build --preset linux-clang-pgo-generate
+
+echo "== training"
+rm -rf "$RAW_DIR"
+"$ROOT/tools/pgo/train.sh" "$ROOT/bin/linux-clang-pgo-generate" "$RAW_DIR"
+
+echo "== merging profiles"
+"$LLVM_PROFDATA" merge -output="$PROFILE" "$RAW_DIR"/*.profraw
+
+echo "== optimized build"
+cmake --preset linux-clang-pgo-use -DSHIMMER_PGO_PROFILE="$PROFILE"
+cmake --build --preset linux-clang-pgo-use
+
+if (( REPORT )); then
+    echo "== reference build"
+    cmake --preset linux-clang-release
+    cmake --build --preset linux-clang-release
+
+    mkdir -p "$PGO_DIR/reference"
+    cd "$PGO_DIR/reference"
+    for benchmark in "$ROOT"/bin/linux-clang-release/shm_*_benchmarks; do
+        [[ -x "$benchmark" ]] || continue
+        echo "* reference: $(basename "$benchmark")"
+        "$benchmark" --benchmark_repetitions=5 --benchmark_report_aggregates_only=true \
+            --benchmark_out="$PGO_DIR/reference/$(basename "$benchmark").json" --benchmark_out_format=json > /dev/null
+    done
+
+    cd "$ROOT"
+    echo "== speedup report"
+    cmake --build --preset linux-clang-pgo-use --target pgo_speedup_report
+fi
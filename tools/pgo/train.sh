@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# PGO training workload, run against an instrumented (SHIMMER_PGO=GENERATE) build.
+# Usage: train.sh <binary dir> <raw profile dir>
+#
+# Runs the broker under a short bot swarm load and every benchmark suite with a short minimum time. The swarm
+# drives the UDP receive path, the handshake, session churn, world transfers and the tick loop with real peers,
+# the benchmarks cover logging, config, metrics and the connection pool hot paths.
+set -euo pipefail
+
+BIN_DIR=$(realpath "$1")
+PROFILE_DIR=$(realpath -m "$2")
+TRAIN_SECONDS=${SHIMMER_PGO_TRAIN_SECONDS:-10}
+TRAIN_BOTS=${SHIMMER_PGO_TRAIN_BOTS:-500}
+
+mkdir -p "$PROFILE_DIR"
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+cd "$WORK_DIR"
+
+export LLVM_PROFILE_FILE="$PROFILE_DIR/%p-%m.profraw"
+
+# The spawned broker inherits LLVM_PROFILE_FILE and writes its profile when the swarm stops it with SIGTERM.
+echo "* training: the_shimmer under $TRAIN_BOTS bots for ${TRAIN_SECONDS}s"
+"$BIN_DIR/shm_botswarm" --spawn-broker "$BIN_DIR/the_shimmer" --work-dir "$WORK_DIR/swarm" \
+    --bots "$TRAIN_BOTS" --duration "$TRAIN_SECONDS" --ramp-up 2 --session-length 4 \
+    --worlds 2 --transfer-every 20 > /dev/null
+
+for benchmark in "$BIN_DIR"/shm_*_benchmarks; do
+    [[ -x "$benchmark" ]] || continue
+    echo "* training: $(basename "$benchmark")"
+    "$benchmark" --benchmark_min_time=0.05s > /dev/null
+done